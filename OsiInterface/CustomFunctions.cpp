@@ -108,6 +108,38 @@ void CustomFunction::GenerateHeader(std::stringstream & ss) const
 }
 
 
+namespace
+{
+	bool IsObjectGuidParam(CustomFunctionParam const & param)
+	{
+		return param.Type == ValueType::CharacterGuid
+			|| param.Type == ValueType::ItemGuid
+			|| param.Type == ValueType::GuidString;
+	}
+
+	STDString MakeHandleVariantName(STDString const & name)
+	{
+		if (name.substr(0, 4) == "NRD_") {
+			return "NRDH_" + name.substr(4);
+		} else {
+			return name + "_Handle";
+		}
+	}
+
+	std::vector<CustomFunctionParam> MakeHandleVariantParams(std::vector<CustomFunctionParam> const & params)
+	{
+		auto variantParams = params;
+		for (auto & param : variantParams) {
+			if (IsObjectGuidParam(param)) {
+				param.Type = ValueType::Integer64;
+			}
+		}
+
+		return variantParams;
+	}
+}
+
+
 bool CustomCall::Call(OsiArgumentDesc const & params)
 {
 	if (!ValidateArgs(params)) {
@@ -119,6 +151,12 @@ bool CustomCall::Call(OsiArgumentDesc const & params)
 }
 
 
+std::unique_ptr<CustomCall> CustomCall::CreateHandleVariant() const
+{
+	return std::make_unique<CustomCall>(MakeHandleVariantName(Name()), MakeHandleVariantParams(Params()), handler_);
+}
+
+
 bool CustomQuery::Query(OsiArgumentDesc & params)
 {
 	if (!ValidateArgs(params)) {
@@ -128,6 +166,11 @@ bool CustomQuery::Query(OsiArgumentDesc & params)
 	return handler_(std::ref(params));
 }
 
+std::unique_ptr<CustomQuery> CustomQuery::CreateHandleVariant() const
+{
+	return std::make_unique<CustomQuery>(MakeHandleVariantName(Name()), MakeHandleVariantParams(Params()), handler_);
+}
+
 
 void CustomFunctionManager::BeginStaticRegistrationPhase()
 {
@@ -197,6 +240,18 @@ FunctionHandle CustomFunctionManager::Register(std::unique_ptr<CustomEvent> even
 	return handle;
 }
 
+FunctionHandle CustomFunctionManager::RegisterWithHandleVariant(std::unique_ptr<CustomCall> call)
+{
+	Register(call->CreateHandleVariant());
+	return Register(std::move(call));
+}
+
+FunctionHandle CustomFunctionManager::RegisterWithHandleVariant(std::unique_ptr<CustomQuery> qry)
+{
+	Register(qry->CreateHandleVariant());
+	return Register(std::move(qry));
+}
+
 std::optional<FunctionHandle> CustomFunctionManager::RegisterDynamic(std::unique_ptr<CustomCallBase> call)
 {
 	assert(staticRegistrationDone_);
@@ -176,6 +176,9 @@ namespace dse
 
 		virtual bool Call(OsiArgumentDesc const & params) override;
 
+		// Creates the handle-based variant of the call (see CustomFunctionManager::RegisterWithHandleVariant())
+		std::unique_ptr<CustomCall> CreateHandleVariant() const;
+
 	private:
 		std::function<void(OsiArgumentDesc const &)> handler_;
 	};
@@ -205,6 +208,9 @@ namespace dse
 
 		virtual bool Query(OsiArgumentDesc & params) override;
 
+		// Creates the handle-based variant of the query (see CustomFunctionManager::RegisterWithHandleVariant())
+		std::unique_ptr<CustomQuery> CreateHandleVariant() const;
+
 	private:
 		std::function<bool(OsiArgumentDesc &)> handler_;
 	};
@@ -241,6 +247,13 @@ namespace dse
 		FunctionHandle Register(std::unique_ptr<CustomQueryBase> qry);
 		FunctionHandle Register(std::unique_ptr<CustomEvent> event);
 
+		// Registers the function and a variant of it where character, item and game object
+		// GUID parameters are replaced by INTEGER64 object handles. The variant is named
+		// NRDH_* instead of NRD_* and shares the handler with the GUID version, so the
+		// handler must resolve these parameters using esv::GetCharacterArg() & co.
+		FunctionHandle RegisterWithHandleVariant(std::unique_ptr<CustomCall> call);
+		FunctionHandle RegisterWithHandleVariant(std::unique_ptr<CustomQuery> qry);
+
 		std::optional<FunctionHandle> RegisterDynamic(std::unique_ptr<CustomCallBase> call);
 		std::optional<FunctionHandle> RegisterDynamic(std::unique_ptr<CustomQueryBase> qry);
 		std::optional<FunctionHandle> RegisterDynamic(std::unique_ptr<CustomEvent> event);
@@ -1183,6 +1183,8 @@ namespace dse
 			}
 		}
 
+		sym.EsvCharacterFactory = (esv::CharacterFactory **)sym.ServerGlobals[(unsigned)EsvGlobalEoCApp::EsvCharacterFactory];
+		sym.EsvItemFactory = (esv::ItemFactory **)sym.ServerGlobals[(unsigned)EsvGlobalEoCApp::EsvItemFactory];
 		sym.EsvInventoryFactory = (esv::InventoryFactory **)sym.ServerGlobals[(unsigned)EsvGlobalEoCApp::EsvInventoryFactory];
 		sym.EsvSurfaceActionFactory = (esv::SurfaceActionFactory**)sym.ServerGlobals[(unsigned)EsvGlobalEoCApp::SurfaceActionFactory];
 
@@ -1090,6 +1090,8 @@ namespace dse
 		});
 
 		auto & serverGlobals = GetStaticSymbols().ServerGlobals;
+		GetStaticSymbols().EsvCharacterFactory = (esv::CharacterFactory **)serverGlobals[(unsigned)EsvGlobalEoCPlugin::EsvCharacterFactory];
+		GetStaticSymbols().EsvItemFactory = (esv::ItemFactory **)serverGlobals[(unsigned)EsvGlobalEoCPlugin::EsvItemFactory];
 		GetStaticSymbols().EsvInventoryFactory = (esv::InventoryFactory **)serverGlobals[(unsigned)EsvGlobalEoCPlugin::EsvInventoryFactory];
 		GetStaticSymbols().EsvSurfaceActionFactory = (esv::SurfaceActionFactory**)serverGlobals[(unsigned)EsvGlobalEoCPlugin::SurfaceActionFactory];
 
@@ -468,6 +468,7 @@ namespace dse
 			}
 		}
 
+		lua->GetBytecodeCache().LogStats();
 		lua->FinishStartup();
 	}
 
@@ -32,7 +32,7 @@ namespace dse::esv
 
 		bool CharacterGetComputedStat(OsiArgumentDesc & args)
 		{
-			auto character = GetEntityWorld()->GetCharacter(args[0].String);
+			auto character = GetCharacterArg(args[0]);
 			auto statName = args[1].String;
 			auto baseStats = args[2].Int32 == 1;
 			auto & statValue = args[3];
@@ -49,8 +49,8 @@ namespace dse::esv
 
 		bool CharacterGetHitChance(OsiArgumentDesc & args)
 		{
-			auto attacker = GetEntityWorld()->GetCharacter(args[0].String);
-			auto target = GetEntityWorld()->GetCharacter(args[1].String);
+			auto attacker = GetCharacterArg(args[0]);
+			auto target = GetCharacterArg(args[1]);
 			auto & hitChance = args[2];
 			if (attacker == nullptr
 				|| target == nullptr
@@ -71,7 +71,7 @@ namespace dse::esv
 		template <OsiPropertyMapType Type>
 		bool CharacterGetStat(OsiArgumentDesc & args)
 		{
-			auto character = GetEntityWorld()->GetCharacter(args[0].String);
+			auto character = GetCharacterArg(args[0]);
 			if (character == nullptr || character->Stats == nullptr) return false;
 
 			return OsirisPropertyMapGet(gCharacterStatsPropertyMap, character->Stats, args, 1, Type);
@@ -79,7 +79,7 @@ namespace dse::esv
 
 		void CharacterSetStatInt(OsiArgumentDesc const & args)
 		{
-			auto character = GetEntityWorld()->GetCharacter(args[0].String);
+			auto character = GetCharacterArg(args[0]);
 			auto stat = ToFixedString(args[1].String);
 			auto value = args[2].Int32;
 
@@ -100,7 +100,7 @@ namespace dse::esv
 		template <OsiPropertyMapType Type>
 		bool CharacterGetPermanentBoost(OsiArgumentDesc & args)
 		{
-			auto character = GetEntityWorld()->GetCharacter(args[0].String);
+			auto character = GetCharacterArg(args[0]);
 			if (character == nullptr) return false;
 
 			auto permanentBoosts = GetCharacterDynamicStat(character, 1);
@@ -112,7 +112,7 @@ namespace dse::esv
 		template <OsiPropertyMapType Type>
 		void CharacterSetPermanentBoost(OsiArgumentDesc const & args)
 		{
-			auto character = GetEntityWorld()->GetCharacter(args[0].String);
+			auto character = GetCharacterArg(args[0]);
 			if (character == nullptr) return;
 
 			auto permanentBoosts = GetCharacterDynamicStat(character, 1);
@@ -123,11 +123,10 @@ namespace dse::esv
 
 		void CharacterSetPermanentBoostTalent(OsiArgumentDesc const & args)
 		{
-			auto characterGuid = args[0].String;
 			auto talent = args[1].String;
 			auto enabled = args[2].Int32;
 
-			auto character = GetEntityWorld()->GetCharacter(characterGuid);
+			auto character = GetCharacterArg(args[0]);
 			if (character == nullptr) return;
 
 			auto permanentBoosts = GetCharacterDynamicStat(character, 1);
@@ -144,11 +143,10 @@ namespace dse::esv
 
 		bool CharacterIsTalentDisabled(OsiArgumentDesc & args)
 		{
-			auto characterGuid = args[0].String;
 			auto talent = args[1].String;
 			auto & disabled = args[2];
 
-			auto character = GetEntityWorld()->GetCharacter(characterGuid);
+			auto character = GetCharacterArg(args[0]);
 			if (character == nullptr) return false;
 
 			auto permanentBoosts = GetCharacterDynamicStat(character, 1);
@@ -166,11 +164,10 @@ namespace dse::esv
 
 		void CharacterDisableTalent(OsiArgumentDesc const & args)
 		{
-			auto characterGuid = args[0].String;
 			auto talent = args[1].String;
 			auto disabled = args[2].Int32;
 
-			auto character = GetEntityWorld()->GetCharacter(characterGuid);
+			auto character = GetCharacterArg(args[0]);
 			if (character == nullptr) return;
 
 			auto permanentBoosts = GetCharacterDynamicStat(character, 1);
@@ -188,10 +185,9 @@ namespace dse::esv
 
 		void CharacterSetGlobal(OsiArgumentDesc const & args)
 		{
-			auto characterGuid = args[0].String;
 			auto global = args[1].Int32 == 1;
 
-			auto character = GetEntityWorld()->GetCharacter(characterGuid);
+			auto character = GetCharacterArg(args[0]);
 			if (character == nullptr) return;
 
 			character->SetGlobal(global);
@@ -200,9 +196,7 @@ namespace dse::esv
 		template <OsiPropertyMapType Type>
 		bool CharacterGet(OsiArgumentDesc & args)
 		{
-			auto characterGuid = args[0].String;
-
-			auto character = GetEntityWorld()->GetCharacter(characterGuid);
+			auto character = GetCharacterArg(args[0]);
 			if (character == nullptr) return false;
 
 			return OsirisPropertyMapGet(gCharacterPropertyMap, character, args, 1, Type);
@@ -210,22 +204,21 @@ namespace dse::esv
 
 		void CharacterIterateSkills(OsiArgumentDesc const & args)
 		{
-			auto characterGuid = args[0].String;
 			auto eventName = args[1].String;
 
-			auto character = GetEntityWorld()->GetCharacter(characterGuid);
+			auto character = GetCharacterArg(args[0]);
 			if (character == nullptr || character->SkillManager == nullptr) return;
 
 			std::vector<std::tuple<char const*, bool, bool>> skillEvents;
 
 			auto & skills = character->SkillManager->Skills;
-			skills.Iterate([&characterGuid, &eventName, &skillEvents](FixedString const & skillId, esv::Skill * skill) {
+			skills.Iterate([&skillEvents](FixedString const & skillId, esv::Skill * skill) {
 				skillEvents.push_back(std::tuple(skill->SkillId.Str, skill->IsLearned, skill->IsActivated));
 			});
 
 			for (auto const& skill : skillEvents) {
 				auto eventArgs = OsiArgumentDesc::Create(OsiArgumentValue{ ValueType::String, eventName });
-				eventArgs->Add(OsiArgumentValue{ ValueType::GuidString, characterGuid });
+				eventArgs->Add(OsiArgumentValue{ ValueType::GuidString, character->MyGuid.Str });
 				eventArgs->Add(OsiArgumentValue{ ValueType::String, std::get<0>(skill) });
 				eventArgs->Add(OsiArgumentValue{ (int32_t)std::get<1>(skill) });
 				eventArgs->Add(OsiArgumentValue{ (int32_t)std::get<2>(skill) });
@@ -238,18 +231,16 @@ namespace dse::esv
 
 		void CharacterEquipItem(OsiArgumentDesc const & args)
 		{
-			auto characterGuid = args[0].String;
-			auto itemGuid = args[1].String;
 			auto slotName = args[2].String;
 			auto consumeAP = args[3].Int32 > 0;
 			auto checkRequirements = args[4].Int32 > 0;
 			auto updateVitality = args[5].Int32 > 0;
 			auto useWeaponAnimType = args[6].Int32 > 0;
 
-			auto character = GetEntityWorld()->GetCharacter(characterGuid);
+			auto character = GetCharacterArg(args[0]);
 			if (character == nullptr || !character->InventoryHandle) return;
 
-			auto item = GetEntityWorld()->GetItem(itemGuid);
+			auto item = GetItemArg(args[1]);
 			if (item == nullptr) return;
 
 			int16_t slotIndex = -1;
@@ -274,9 +265,28 @@ namespace dse::esv
 				updateVitality, useWeaponAnimType);
 		}
 
+		bool ObjectGetHandle(OsiArgumentDesc & args)
+		{
+			auto gameObject = GetEntityWorld()->GetGameObject(args[0].String);
+			if (gameObject == nullptr) return false;
+
+			ObjectHandle handle;
+			gameObject->GetObjectHandle(handle);
+			args[1].Set((int64_t)handle);
+			return true;
+		}
+
+		bool ObjectGetGuid(OsiArgumentDesc & args)
+		{
+			auto gameObject = GetEntityWorld()->GetGameObject(ObjectHandle{ args[0].Int64 });
+			if (gameObject == nullptr) return false;
+
+			args[1].Set(gameObject->MyGuid.Str);
+			return true;
+		}
+
 		bool ObjectGetInternalFlag(OsiArgumentDesc & args)
 		{
-			auto guid = args[0].String;
 			auto flag = args[1].Int32;
 			auto & value = args[2];
 
@@ -285,7 +295,7 @@ namespace dse::esv
 				return false;
 			}
 
-			auto character = GetEntityWorld()->GetCharacter(guid, false);
+			auto character = GetCharacterArg(args[0], false);
 			if (character != nullptr) {
 				if (flag < 64) {
 					value.Set(character->HasFlag(1ull << flag));
@@ -300,7 +310,7 @@ namespace dse::esv
 				return true;
 			}
 
-			auto item = GetEntityWorld()->GetItem(guid);
+			auto item = GetItemArg(args[0]);
 			if (item != nullptr) {
 				if (flag < 64) {
 					value.Set(item->HasFlag(1ull << flag));
@@ -316,7 +326,6 @@ namespace dse::esv
 
 		void ObjectSetInternalFlag(OsiArgumentDesc const & args)
 		{
-			auto guid = args[0].String;
 			auto flag = args[1].Int32;
 			auto value = args[2].Int32 > 0;
 
@@ -325,7 +334,7 @@ namespace dse::esv
 				return;
 			}
 
-			auto character = GetEntityWorld()->GetCharacter(guid, false);
+			auto character = GetCharacterArg(args[0], false);
 			if (character != nullptr) {
 				if (flag < 64) {
 					if (value) {
@@ -356,7 +365,7 @@ namespace dse::esv
 				return;
 			}
 
-			auto item = GetEntityWorld()->GetItem(guid);
+			auto item = GetItemArg(args[0]);
 			if (item != nullptr) {
 				if (flag < 64) {
 					if (value) {
@@ -379,16 +388,15 @@ namespace dse::esv
 		template <OsiPropertyMapType Type>
 		bool RootTemplateGet(OsiArgumentDesc& args)
 		{
-			auto guid = args[0].String;
 			auto property = args[1].Int32;
 			auto& value = args[2];
 
-			auto character = GetEntityWorld()->GetCharacter(guid, false);
+			auto character = GetCharacterArg(args[0], false);
 			if (character != nullptr) {
 				return OsirisPropertyMapGet(gCharacterTemplatePropertyMap, character->CurrentTemplate, args, 1, Type);
 			}
 
-			auto item = GetEntityWorld()->GetItem(guid);
+			auto item = GetItemArg(args[0]);
 			if (item != nullptr) {
 				return OsirisPropertyMapGet(gItemTemplatePropertyMap, item->CurrentTemplate, args, 1, Type);
 			} else {
@@ -411,7 +419,7 @@ namespace dse::esv
 			},
 			&func::CharacterGetComputedStat
 		);
-		functionMgr.Register(std::move(characterGetComputedStat));
+		functionMgr.RegisterWithHandleVariant(std::move(characterGetComputedStat));
 
 		auto characterGetHitChance = std::make_unique<CustomQuery>(
 			"NRD_CharacterGetHitChance",
@@ -422,7 +430,7 @@ namespace dse::esv
 			},
 			&func::CharacterGetHitChance
 		);
-		functionMgr.Register(std::move(characterGetHitChance));
+		functionMgr.RegisterWithHandleVariant(std::move(characterGetHitChance));
 
 		auto characterGetStatInt = std::make_unique<CustomQuery>(
 			"NRD_CharacterGetStatInt",
@@ -433,7 +441,7 @@ namespace dse::esv
 			},
 			&func::CharacterGetStat<OsiPropertyMapType::Integer>
 		);
-		functionMgr.Register(std::move(characterGetStatInt));
+		functionMgr.RegisterWithHandleVariant(std::move(characterGetStatInt));
 
 		auto characterGetStatString = std::make_unique<CustomQuery>(
 			"NRD_CharacterGetStatString",
@@ -444,7 +452,7 @@ namespace dse::esv
 			},
 			&func::CharacterGetStat<OsiPropertyMapType::String>
 		);
-		functionMgr.Register(std::move(characterGetStatString));
+		functionMgr.RegisterWithHandleVariant(std::move(characterGetStatString));
 
 		auto characterSetStatInt = std::make_unique<CustomCall>(
 			"NRD_CharacterSetStatInt",
@@ -455,7 +463,7 @@ namespace dse::esv
 			},
 			&func::CharacterSetStatInt
 		);
-		functionMgr.Register(std::move(characterSetStatInt));
+		functionMgr.RegisterWithHandleVariant(std::move(characterSetStatInt));
 
 
 		auto characterGetPermanentBoostInt = std::make_unique<CustomQuery>(
@@ -467,7 +475,7 @@ namespace dse::esv
 			},
 			&func::CharacterGetPermanentBoost<OsiPropertyMapType::Integer>
 		);
-		functionMgr.Register(std::move(characterGetPermanentBoostInt));
+		functionMgr.RegisterWithHandleVariant(std::move(characterGetPermanentBoostInt));
 
 
 		auto characterSetPermanentBoostInt = std::make_unique<CustomCall>(
@@ -479,7 +487,7 @@ namespace dse::esv
 			},
 			&func::CharacterSetPermanentBoost<OsiPropertyMapType::Integer>
 		);
-		functionMgr.Register(std::move(characterSetPermanentBoostInt));
+		functionMgr.RegisterWithHandleVariant(std::move(characterSetPermanentBoostInt));
 
 
 		auto characterSetTalent = std::make_unique<CustomCall>(
@@ -491,7 +499,7 @@ namespace dse::esv
 			},
 			&func::CharacterSetPermanentBoostTalent
 		);
-		functionMgr.Register(std::move(characterSetTalent));
+		functionMgr.RegisterWithHandleVariant(std::move(characterSetTalent));
 
 
 		auto characterIsTalentDisabled = std::make_unique<CustomQuery>(
@@ -503,7 +511,7 @@ namespace dse::esv
 			},
 			&func::CharacterIsTalentDisabled
 		);
-		functionMgr.Register(std::move(characterIsTalentDisabled));
+		functionMgr.RegisterWithHandleVariant(std::move(characterIsTalentDisabled));
 
 
 		auto characterDisableTalent = std::make_unique<CustomCall>(
@@ -515,7 +523,7 @@ namespace dse::esv
 			},
 			&func::CharacterDisableTalent
 		);
-		functionMgr.Register(std::move(characterDisableTalent));
+		functionMgr.RegisterWithHandleVariant(std::move(characterDisableTalent));
 
 
 		auto characterSetGlobal = std::make_unique<CustomCall>(
@@ -526,7 +534,7 @@ namespace dse::esv
 			},
 			&func::CharacterSetGlobal
 		);
-		functionMgr.Register(std::move(characterSetGlobal));
+		functionMgr.RegisterWithHandleVariant(std::move(characterSetGlobal));
 
 		auto characterGetInt = std::make_unique<CustomQuery>(
 			"NRD_CharacterGetInt",
@@ -537,7 +545,7 @@ namespace dse::esv
 			},
 			&func::CharacterGet<OsiPropertyMapType::Integer>
 		);
-		functionMgr.Register(std::move(characterGetInt));
+		functionMgr.RegisterWithHandleVariant(std::move(characterGetInt));
 
 		auto characterGetReal = std::make_unique<CustomQuery>(
 			"NRD_CharacterGetReal",
@@ -548,7 +556,7 @@ namespace dse::esv
 			},
 			&func::CharacterGet<OsiPropertyMapType::Real>
 		);
-		functionMgr.Register(std::move(characterGetReal));
+		functionMgr.RegisterWithHandleVariant(std::move(characterGetReal));
 		
 		auto characterGetString = std::make_unique<CustomQuery>(
 			"NRD_CharacterGetString",
@@ -559,7 +567,7 @@ namespace dse::esv
 			},
 			&func::CharacterGet<OsiPropertyMapType::String>
 		);
-		functionMgr.Register(std::move(characterGetString));
+		functionMgr.RegisterWithHandleVariant(std::move(characterGetString));
 		
 		auto iterateCharacterSkills = std::make_unique<CustomCall>(
 			"NRD_CharacterIterateSkills",
@@ -569,7 +577,7 @@ namespace dse::esv
 			},
 			&func::CharacterIterateSkills
 		);
-		functionMgr.Register(std::move(iterateCharacterSkills));
+		functionMgr.RegisterWithHandleVariant(std::move(iterateCharacterSkills));
 
 		auto skillIteratorEvent = std::make_unique<CustomEvent>(
 			"NRD_SkillIteratorEvent",
@@ -596,7 +604,27 @@ namespace dse::esv
 			},
 			&func::CharacterEquipItem
 		);
-		functionMgr.Register(std::move(characterEquipItem));
+		functionMgr.RegisterWithHandleVariant(std::move(characterEquipItem));
+
+		auto objectGetHandle = std::make_unique<CustomQuery>(
+			"NRD_ObjectGetHandle",
+			std::vector<CustomFunctionParam>{
+				{ "Object", ValueType::GuidString, FunctionArgumentDirection::In },
+				{ "Handle", ValueType::Integer64, FunctionArgumentDirection::Out },
+			},
+			&func::ObjectGetHandle
+		);
+		functionMgr.Register(std::move(objectGetHandle));
+
+		auto objectGetGuid = std::make_unique<CustomQuery>(
+			"NRD_ObjectGetGuid",
+			std::vector<CustomFunctionParam>{
+				{ "Handle", ValueType::Integer64, FunctionArgumentDirection::In },
+				{ "Object", ValueType::GuidString, FunctionArgumentDirection::Out },
+			},
+			&func::ObjectGetGuid
+		);
+		functionMgr.Register(std::move(objectGetGuid));
 
 		auto objectGetInternalFlag = std::make_unique<CustomQuery>(
 			"NRD_ObjectGetInternalFlag",
@@ -607,7 +635,7 @@ namespace dse::esv
 			},
 			&func::ObjectGetInternalFlag
 		);
-		functionMgr.Register(std::move(objectGetInternalFlag));
+		functionMgr.RegisterWithHandleVariant(std::move(objectGetInternalFlag));
 
 		auto objectSetInternalFlag = std::make_unique<CustomCall>(
 			"NRD_ObjectSetInternalFlag",
@@ -618,7 +646,7 @@ namespace dse::esv
 			},
 			&func::ObjectSetInternalFlag
 		);
-		functionMgr.Register(std::move(objectSetInternalFlag));
+		functionMgr.RegisterWithHandleVariant(std::move(objectSetInternalFlag));
 
 		auto rootTemplateGetInt = std::make_unique<CustomQuery>(
 			"NRD_RootTemplateGetInt",
@@ -629,7 +657,7 @@ namespace dse::esv
 			},
 			&func::RootTemplateGet<OsiPropertyMapType::Integer>
 		);
-		functionMgr.Register(std::move(rootTemplateGetInt));
+		functionMgr.RegisterWithHandleVariant(std::move(rootTemplateGetInt));
 
 		auto rootTemplateGetReal = std::make_unique<CustomQuery>(
 			"NRD_RootTemplateGetReal",
@@ -640,7 +668,7 @@ namespace dse::esv
 			},
 			&func::RootTemplateGet<OsiPropertyMapType::Real>
 		);
-		functionMgr.Register(std::move(rootTemplateGetReal));
+		functionMgr.RegisterWithHandleVariant(std::move(rootTemplateGetReal));
 
 		auto rootTemplateGetString = std::make_unique<CustomQuery>(
 			"NRD_RootTemplateGetString",
@@ -651,7 +679,7 @@ namespace dse::esv
 			},
 			&func::RootTemplateGet<OsiPropertyMapType::String>
 		);
-		functionMgr.Register(std::move(rootTemplateGetString));
+		functionMgr.RegisterWithHandleVariant(std::move(rootTemplateGetString));
 	}
 
 }
@@ -17,6 +17,46 @@ namespace dse
 
 namespace dse::esv
 {
+	// Resolve the character, item or game object passed in an Osiris function argument.
+	// The argument is a GUID string, or a packed ObjectHandle in NRDH_* function variants.
+	Character* GetCharacterArg(OsiArgumentValue const& arg, bool logError = true);
+	Item* GetItemArg(OsiArgumentValue const& arg, bool logError = true);
+	IEoCServerObject* GetGameObjectArg(OsiArgumentValue const& arg, bool logError = true);
+	// Returns a game object in an Osiris output argument as a GUID string or packed ObjectHandle
+	void SetGameObjectArg(OsiArgumentValue& arg, IEoCServerObject* object);
+
+	// Applies the same status to multiple characters/items.
+	// The status ID, prototype and engine functions are only resolved once per batch;
+	// ApplyStatus events are still thrown for each target.
+	class StatusApplyBatch
+	{
+	public:
+		struct Params
+		{
+			// Negative lifetime applies the status permanently
+			float LifeTime{ 6.0f };
+			float StatsMultiplier{ 1.0f };
+			ObjectHandle Source;
+			bool Force{ false };
+		};
+
+		bool Prepare(char const* statusId);
+		void Clear();
+		// Returns false (and skips the target when applying) if it is not a character or item
+		bool AddTarget(OsiArgumentValue const& target);
+		void SkipTarget();
+		// Writes the handle of the applied status for each target (null handle if the target was skipped)
+		void Apply(Params const& params, std::vector<ObjectHandle>& statusHandles);
+
+	private:
+		FixedString statusId_;
+		StatusType statusType_{ StatusType::CONSUME };
+		StatusMachine__CreateStatus createStatus_{ nullptr };
+		StatusMachine__ApplyStatus applyStatus_{ nullptr };
+		// Targets are stored as handles, as applying a status can destroy other targets of the batch
+		std::vector<ObjectHandle> targets_;
+	};
+
 	class CustomFunctionLibrary
 	{
 	public:
@@ -135,28 +135,126 @@ namespace dse
 
 	namespace esv
 	{
-		IEoCServerObject* EntityWorld::GetGameObject(char const* nameGuid, bool logError)
+		GameObjectGuidCache gGameObjectGuidCache;
+		thread_local GameObjectGuidCache::ThreadTable GameObjectGuidCache::threadTable_;
+
+		ObjectHandle GameObjectGuidCache::Find(FixedString const& guid)
 		{
+			auto& table = threadTable_;
+			auto generation = generation_.load(std::memory_order_acquire);
+			if (table.Generation != generation) {
+				table.Entries.fill(Entry{});
+				table.Generation = generation;
+				return ObjectHandle{};
+			}
+
+			auto const& entry = table.Entries[GetSlot(guid.Str)];
+			if (entry.Guid == guid.Str) {
+				return entry.Handle;
+			} else {
+				return ObjectHandle{};
+			}
+		}
+
+		void GameObjectGuidCache::Add(FixedString const& guid, ObjectHandle handle)
+		{
+			threadTable_.Entries[GetSlot(guid.Str)] = Entry{ guid.Str, handle };
+		}
+
+		void GameObjectGuidCache::Clear()
+		{
+			generation_++;
+		}
+
+		IEoCServerObject* EntityWorld::FindGameObjectByGuid(char const* nameGuid, bool characters, bool items, bool logError)
+		{
+			if (this == nullptr) {
+				OsiError("Tried to find component on null EntityWorld!");
+				return nullptr;
+			}
+
 			if (nameGuid == nullptr) {
 				OsiError("Attempted to look up object with null name!");
 				return nullptr;
 			}
 
-			auto character = GetCharacter(nameGuid, false);
-			if (character != nullptr) {
-				return character;
+			auto guid = NameGuidToFixedString(nameGuid);
+			if (!guid) {
+				OsiError("Could not map GUID '" << nameGuid << "' to FixedString");
+				return nullptr;
 			}
 
-			auto item = GetItem(nameGuid, false);
-			if (item != nullptr) {
-				return item;
+			IEoCServerObject* object{ nullptr };
+			auto cachedHandle = gGameObjectGuidCache.Find(guid);
+			if (cachedHandle) {
+				auto type = (ObjectType)cachedHandle.GetType();
+				IEoCServerObject* cached{ nullptr };
+				if (type == ObjectType::ServerCharacter) {
+					cached = GetCharacter(cachedHandle, false);
+				} else if (type == ObjectType::ServerItem) {
+					cached = GetItem(cachedHandle, false);
+				}
+
+				// The salt check in GetComponent() rejects handles of destroyed objects; the GUID check
+				// rejects handles that were reused after the factory was recreated (eg. on level swap)
+				if (cached != nullptr && cached->MyGuid == guid) {
+					// GUIDs are unique, so a character GUID can't belong to an item and vice versa
+					if ((type == ObjectType::ServerCharacter && characters) || (type == ObjectType::ServerItem && items)) {
+						object = cached;
+					}
+				} else {
+					cachedHandle = ObjectHandle{};
+				}
+			}
+
+			if (!cachedHandle) {
+				if (characters) {
+					auto component = GetComponentByGuid(ComponentType::Character, guid);
+					if (component != nullptr) {
+						object = (Character*)((uint8_t*)component - 8);
+					}
+				}
+
+				if (object == nullptr && items) {
+					auto component = GetComponentByGuid(ComponentType::Item, guid);
+					if (component != nullptr) {
+						object = (Item*)((uint8_t*)component - 8);
+					}
+				}
+
+				if (object != nullptr) {
+					ObjectHandle handle;
+					object->GetObjectHandle(handle);
+					gGameObjectGuidCache.Add(guid, handle);
+				}
 			}
 
-			if (logError) {
-				OsiError("No EoC server object found with GUID '" << nameGuid << "'");
+			if (object == nullptr && logError) {
+				if (characters && items) {
+					OsiError("No EoC server object found with GUID '" << nameGuid << "'");
+				} else {
+					auto componentType = characters ? ComponentType::Character : ComponentType::Item;
+					OsiError("No " << ComponentTypeToName(componentType).Str << " component found with GUID '" << nameGuid << "'");
+				}
 			}
 
-			return nullptr;
+			return object;
+		}
+
+		Character* EntityWorld::GetCharacter(char const* nameGuid, bool logError)
+		{
+			return static_cast<Character*>(FindGameObjectByGuid(nameGuid, true, false, logError));
+		}
+
+		Item* EntityWorld::GetItem(char const* nameGuid, bool logError)
+		{
+			return static_cast<Item*>(FindGameObjectByGuid(nameGuid, false, true, logError));
+		}
+
+		IEoCServerObject* EntityWorld::GetGameObject(char const* nameGuid, bool logError)
+		{
+			// Tries both object types with a single GUID mapping and cache probe
+			return FindGameObjectByGuid(nameGuid, true, true, logError);
 		}
 
 		IEoCServerObject* EntityWorld::GetGameObject(ObjectHandle handle, bool logError)
@@ -181,6 +279,44 @@ namespace dse
 			}
 		}
 
+		Character* GetCharacterArg(OsiArgumentValue const& arg, bool logError)
+		{
+			if (arg.TypeId == ValueType::Integer64) {
+				return GetEntityWorld()->GetCharacter(ObjectHandle{ arg.Int64 }, logError);
+			} else {
+				return GetEntityWorld()->GetCharacter(arg.String, logError);
+			}
+		}
+
+		Item* GetItemArg(OsiArgumentValue const& arg, bool logError)
+		{
+			if (arg.TypeId == ValueType::Integer64) {
+				return GetEntityWorld()->GetItem(ObjectHandle{ arg.Int64 }, logError);
+			} else {
+				return GetEntityWorld()->GetItem(arg.String, logError);
+			}
+		}
+
+		IEoCServerObject* GetGameObjectArg(OsiArgumentValue const& arg, bool logError)
+		{
+			if (arg.TypeId == ValueType::Integer64) {
+				return GetEntityWorld()->GetGameObject(ObjectHandle{ arg.Int64 }, logError);
+			} else {
+				return GetEntityWorld()->GetGameObject(arg.String, logError);
+			}
+		}
+
+		void SetGameObjectArg(OsiArgumentValue& arg, IEoCServerObject* object)
+		{
+			if (arg.TypeId == ValueType::Integer64) {
+				ObjectHandle handle;
+				object->GetObjectHandle(handle);
+				arg.Set((int64_t)handle);
+			} else {
+				arg.Set(object->MyGuid.Str);
+			}
+		}
+
 		EntityWorld* GetEntityWorld()
 		{
 			auto server = GetEoCServer();
@@ -358,6 +494,44 @@ namespace dse
 
 	namespace ecl
 	{
+		Character* GetCharacterArg(OsiArgumentValue const& arg, bool logError)
+		{
+			if (arg.TypeId == ValueType::Integer64) {
+				return GetEntityWorld()->GetCharacter(ObjectHandle{ arg.Int64 }, logError);
+			} else {
+				return GetEntityWorld()->GetCharacter(arg.String, logError);
+			}
+		}
+
+		Item* GetItemArg(OsiArgumentValue const& arg, bool logError)
+		{
+			if (arg.TypeId == ValueType::Integer64) {
+				return GetEntityWorld()->GetItem(ObjectHandle{ arg.Int64 }, logError);
+			} else {
+				return GetEntityWorld()->GetItem(arg.String, logError);
+			}
+		}
+
+		IEoCServerObject* GetGameObjectArg(OsiArgumentValue const& arg, bool logError)
+		{
+			if (arg.TypeId == ValueType::Integer64) {
+				return GetEntityWorld()->GetGameObject(ObjectHandle{ arg.Int64 }, logError);
+			} else {
+				return GetEntityWorld()->GetGameObject(arg.String, logError);
+			}
+		}
+
+		void SetGameObjectArg(OsiArgumentValue& arg, IEoCServerObject* object)
+		{
+			if (arg.TypeId == ValueType::Integer64) {
+				ObjectHandle handle;
+				object->GetObjectHandle(handle);
+				arg.Set((int64_t)handle);
+			} else {
+				arg.Set(object->MyGuid.Str);
+			}
+		}
+
 		EntityWorld* GetEntityWorld()
 		{
 			auto client = GetEoCClient();
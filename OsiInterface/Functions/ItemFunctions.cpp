@@ -12,15 +12,14 @@ namespace dse::esv
 	{
 		bool ItemGetStatsId(OsiArgumentDesc & args)
 		{
-			auto itemGuid = args[0].String;
-			auto item = GetEntityWorld()->GetItem(itemGuid);
+			auto item = GetItemArg(args[0]);
 			if (item == nullptr) {
-				OsiError("Item '" << itemGuid << "' does not exist!");
+				OsiError("Item '" << args[0].ToString() << "' does not exist!");
 				return false;
 			}
 
 			if (!item->StatsId.Str) {
-				OsiError("Item '" << itemGuid << "' has no stats ID!");
+				OsiError("Item '" << item->MyGuid.Str << "' has no stats ID!");
 				return false;
 			} else {
 				args[1].Set(item->StatsId.Str);
@@ -30,15 +29,14 @@ namespace dse::esv
 
 		bool ItemGetGenerationParams(OsiArgumentDesc & args)
 		{
-			auto itemGuid = args[0].String;
-			auto item = GetEntityWorld()->GetItem(itemGuid);
+			auto item = GetItemArg(args[0]);
 			if (item == nullptr) {
-				OsiError("Item '" << itemGuid << "' does not exist!");
+				OsiError("Item '" << args[0].ToString() << "' does not exist!");
 				return false;
 			}
 
 			if (!item->Generation) {
-				OsiError("Item '" << itemGuid << "' has no generation data!");
+				OsiError("Item '" << item->MyGuid.Str << "' has no generation data!");
 				return false;
 			} else {
 				OsiWarn("NRD_ItemGetGenerationParams() with 4 arguments is deprecated. Use the 5-argument version instead!");
@@ -52,15 +50,14 @@ namespace dse::esv
 
 		bool ItemGetGenerationParams2(OsiArgumentDesc & args)
 		{
-			auto itemGuid = args[0].String;
-			auto item = GetEntityWorld()->GetItem(itemGuid);
+			auto item = GetItemArg(args[0]);
 			if (item == nullptr) {
-				OsiError("Item '" << itemGuid << "' does not exist!");
+				OsiError("Item '" << args[0].ToString() << "' does not exist!");
 				return false;
 			}
 
 			if (!item->Generation) {
-				OsiError("Item '" << itemGuid << "' has no generation data!");
+				OsiError("Item '" << item->MyGuid.Str << "' has no generation data!");
 				return false;
 			} else {
 				args[1].String = item->Generation->Base ? item->Generation->Base.Str : "";
@@ -73,10 +70,9 @@ namespace dse::esv
 
 		bool ItemHasDeltaModifier(OsiArgumentDesc & args)
 		{
-			auto itemGuid = args[0].String;
-			auto item = GetEntityWorld()->GetItem(itemGuid);
+			auto item = GetItemArg(args[0]);
 			if (item == nullptr) {
-				OsiError("Item '" << itemGuid << "' does not exist!");
+				OsiError("Item '" << args[0].ToString() << "' does not exist!");
 				return false;
 			}
 
@@ -106,16 +102,15 @@ namespace dse::esv
 
 		void ItemIterateDeltaModifiers(OsiArgumentDesc const & args)
 		{
-			auto itemGuid = args[0].String;
 			auto eventName = args[1].String;
 
-			auto item = GetEntityWorld()->GetItem(itemGuid);
+			auto item = GetItemArg(args[0]);
 			if (item == nullptr) return;
 
 			if (item->Generation != nullptr) {
 				for (auto const& boost : item->Generation->Boosts) {
 					auto eventArgs = OsiArgumentDesc::Create(OsiArgumentValue{ ValueType::String, eventName });
-					eventArgs->Add(OsiArgumentValue{ ValueType::ItemGuid, itemGuid });
+					eventArgs->Add(OsiArgumentValue{ ValueType::ItemGuid, item->MyGuid.Str });
 					eventArgs->Add(OsiArgumentValue{ ValueType::String, boost.Str });
 					eventArgs->Add(OsiArgumentValue{ 1 });
 					gOsirisProxy->GetCustomFunctionInjector().ThrowEvent(ItemDeltaModIteratorEventHandle, eventArgs);
@@ -126,7 +121,7 @@ namespace dse::esv
 			if (item->StatsDynamic != nullptr) {
 				for (auto const& boost : item->StatsDynamic->BoostNameSet) {
 					auto eventArgs = OsiArgumentDesc::Create(OsiArgumentValue{ ValueType::String, eventName });
-					eventArgs->Add(OsiArgumentValue{ ValueType::ItemGuid, itemGuid });
+					eventArgs->Add(OsiArgumentValue{ ValueType::ItemGuid, item->MyGuid.Str });
 					eventArgs->Add(OsiArgumentValue{ ValueType::String, boost.Str });
 					eventArgs->Add(OsiArgumentValue{ 0 });
 					gOsirisProxy->GetCustomFunctionInjector().ThrowEvent(ItemDeltaModIteratorEventHandle, eventArgs);
@@ -137,15 +132,14 @@ namespace dse::esv
 
 		void ItemSetIdentified(OsiArgumentDesc const & args)
 		{
-			auto itemGuid = args[0].String;
-			auto item = GetEntityWorld()->GetItem(itemGuid);
+			auto item = GetItemArg(args[0]);
 			if (item == nullptr) {
-				OsiError("Item '" << itemGuid << "' does not exist!");
+				OsiError("Item '" << args[0].ToString() << "' does not exist!");
 				return;
 			}
 
 			if (item->StatsDynamic == nullptr) {
-				OsiError("Item '" << itemGuid << "' has no dynamic stats!");
+				OsiError("Item '" << item->MyGuid.Str << "' has no dynamic stats!");
 				return;
 			}
 
@@ -154,12 +148,11 @@ namespace dse::esv
 
 		bool ItemGetParent(OsiArgumentDesc & args)
 		{
-			auto itemGuid = args[0].String;
-			auto & parentGuid = args[1];
+			auto & parentArg = args[1];
 
-			auto item = GetEntityWorld()->GetItem(itemGuid);
+			auto item = GetItemArg(args[0]);
 			if (item == nullptr) {
-				OsiError("Item '" << itemGuid << "' does not exist!");
+				OsiError("Item '" << args[0].ToString() << "' does not exist!");
 				return false;
 			}
 
@@ -178,7 +171,7 @@ namespace dse::esv
 
 			auto parent = GetEntityWorld()->GetGameObject(inventory->ParentHandle);
 			if (parent != nullptr) {
-				parentGuid.Set(parent->MyGuid.Str);
+				SetGameObjectArg(parentArg, parent);
 				return true;
 			} else {
 				return false;
@@ -204,7 +197,7 @@ namespace dse::esv
 		template <OsiPropertyMapType Type>
 		bool ItemGet(OsiArgumentDesc & args)
 		{
-			auto item = GetEntityWorld()->GetItem(args[0].String);
+			auto item = GetItemArg(args[0]);
 			if (item == nullptr) return false;
 
 			bool fetched = false;
@@ -222,7 +215,7 @@ namespace dse::esv
 		template <OsiPropertyMapType Type>
 		bool ItemGetPermanentBoost(OsiArgumentDesc & args)
 		{
-			auto item = GetEntityWorld()->GetItem(args[0].String);
+			auto item = GetItemArg(args[0]);
 			if (item == nullptr) return false;
 
 			auto permanentBoosts = GetItemDynamicStat(item, 1);
@@ -235,7 +228,7 @@ namespace dse::esv
 		template <OsiPropertyMapType Type>
 		void ItemSetPermanentBoost(OsiArgumentDesc const & args)
 		{
-			auto item = GetEntityWorld()->GetItem(args[0].String);
+			auto item = GetItemArg(args[0]);
 			if (item == nullptr) return;
 
 			auto permanentBoosts = GetItemDynamicStat(item, 1);
@@ -247,11 +240,10 @@ namespace dse::esv
 
 		bool ItemGetPermanentBoostAbility(OsiArgumentDesc & args)
 		{
-			auto itemGuid = args[0].String;
 			auto ability = args[1].String;
 			auto & level = args[2];
 
-			auto item = GetEntityWorld()->GetItem(itemGuid);
+			auto item = GetItemArg(args[0]);
 			if (item == nullptr) return false;
 
 			auto permanentBoosts = GetItemDynamicStat(item, 1);
@@ -269,11 +261,10 @@ namespace dse::esv
 
 		bool ItemGetPermanentBoostTalent(OsiArgumentDesc & args)
 		{
-			auto itemGuid = args[0].String;
 			auto talent = args[1].String;
 			auto & enabled = args[2];
 
-			auto item = GetEntityWorld()->GetItem(itemGuid);
+			auto item = GetItemArg(args[0]);
 			if (item == nullptr) return false;
 
 			auto permanentBoosts = GetItemDynamicStat(item, 1);
@@ -291,11 +282,10 @@ namespace dse::esv
 
 		void ItemSetPermanentBoostAbility(OsiArgumentDesc const & args)
 		{
-			auto itemGuid = args[0].String;
 			auto ability = args[1].String;
 			auto level = args[2].Int32;
 
-			auto item = GetEntityWorld()->GetItem(itemGuid);
+			auto item = GetItemArg(args[0]);
 			if (item == nullptr) return;
 
 			auto permanentBoosts = GetItemDynamicStat(item, 1);
@@ -312,11 +302,10 @@ namespace dse::esv
 
 		void ItemSetPermanentBoostTalent(OsiArgumentDesc const & args)
 		{
-			auto itemGuid = args[0].String;
 			auto talent = args[1].String;
 			auto enabled = args[2].Int32;
 
-			auto item = GetEntityWorld()->GetItem(itemGuid);
+			auto item = GetItemArg(args[0]);
 			if (item == nullptr) return;
 
 			auto permanentBoosts = GetItemDynamicStat(item, 1);
@@ -385,8 +374,7 @@ namespace dse::esv
 			
 			ExtensionState::Get().PendingItemClone.reset();
 
-			auto itemGuid = args[0].String;
-			auto item = GetEntityWorld()->GetItem(itemGuid);
+			auto item = GetItemArg(args[0]);
 			if (item == nullptr) return;
 
 			auto & clone = ExtensionState::Get().PendingItemClone;
@@ -417,7 +405,7 @@ namespace dse::esv
 				return false;
 			}
 
-			args[0].Set(item->GetGuid()->Str);
+			SetGameObjectArg(args[0], item);
 			return true;
 		}
 
@@ -500,7 +488,7 @@ namespace dse::esv
 			},
 			&func::ItemGetStatsId
 		);
-		functionMgr.Register(std::move(itemGetStatsId));
+		functionMgr.RegisterWithHandleVariant(std::move(itemGetStatsId));
 
 		auto itemGetGenerationParams = std::make_unique<CustomQuery>(
 			"NRD_ItemGetGenerationParams",
@@ -512,7 +500,7 @@ namespace dse::esv
 			},
 			&func::ItemGetGenerationParams
 		);
-		functionMgr.Register(std::move(itemGetGenerationParams));
+		functionMgr.RegisterWithHandleVariant(std::move(itemGetGenerationParams));
 
 		auto itemGetGenerationParams2 = std::make_unique<CustomQuery>(
 			"NRD_ItemGetGenerationParams",
@@ -525,7 +513,7 @@ namespace dse::esv
 			},
 			&func::ItemGetGenerationParams2
 		);
-		functionMgr.Register(std::move(itemGetGenerationParams2));
+		functionMgr.RegisterWithHandleVariant(std::move(itemGetGenerationParams2));
 
 		auto itemHasDeltaMod = std::make_unique<CustomQuery>(
 			"NRD_ItemHasDeltaModifier",
@@ -536,7 +524,7 @@ namespace dse::esv
 			},
 			&func::ItemHasDeltaModifier
 		);
-		functionMgr.Register(std::move(itemHasDeltaMod));
+		functionMgr.RegisterWithHandleVariant(std::move(itemHasDeltaMod));
 
 		auto itemIterateDeltaMods = std::make_unique<CustomCall>(
 			"NRD_ItemIterateDeltaModifiers",
@@ -546,7 +534,7 @@ namespace dse::esv
 			},
 			&func::ItemIterateDeltaModifiers
 		);
-		functionMgr.Register(std::move(itemIterateDeltaMods));
+		functionMgr.RegisterWithHandleVariant(std::move(itemIterateDeltaMods));
 
 		auto itemSetIdentified = std::make_unique<CustomCall>(
 			"NRD_ItemSetIdentified",
@@ -556,7 +544,7 @@ namespace dse::esv
 			},
 			&func::ItemSetIdentified
 		);
-		functionMgr.Register(std::move(itemSetIdentified));
+		functionMgr.RegisterWithHandleVariant(std::move(itemSetIdentified));
 
 
 		auto itemGetParent = std::make_unique<CustomQuery>(
@@ -567,7 +555,7 @@ namespace dse::esv
 			},
 			&func::ItemGetParent
 		);
-		functionMgr.Register(std::move(itemGetParent));
+		functionMgr.RegisterWithHandleVariant(std::move(itemGetParent));
 
 
 		auto itemGetInt = std::make_unique<CustomQuery>(
@@ -579,7 +567,7 @@ namespace dse::esv
 			},
 			&func::ItemGet<OsiPropertyMapType::Integer>
 		);
-		functionMgr.Register(std::move(itemGetInt));
+		functionMgr.RegisterWithHandleVariant(std::move(itemGetInt));
 
 		auto itemGetString = std::make_unique<CustomQuery>(
 			"NRD_ItemGetString",
@@ -590,7 +578,7 @@ namespace dse::esv
 			},
 			&func::ItemGet<OsiPropertyMapType::String>
 		);
-		functionMgr.Register(std::move(itemGetString));
+		functionMgr.RegisterWithHandleVariant(std::move(itemGetString));
 
 		auto itemGetGuidString = std::make_unique<CustomQuery>(
 			"NRD_ItemGetGuidString",
@@ -613,7 +601,7 @@ namespace dse::esv
 			},
 			&func::ItemGetPermanentBoost<OsiPropertyMapType::Integer>
 		);
-		functionMgr.Register(std::move(itemGetPermanentBoostInt));
+		functionMgr.RegisterWithHandleVariant(std::move(itemGetPermanentBoostInt));
 
 
 		auto itemGetPermanentBoostReal = std::make_unique<CustomQuery>(
@@ -625,7 +613,7 @@ namespace dse::esv
 			},
 			&func::ItemGetPermanentBoost<OsiPropertyMapType::Real>
 		);
-		functionMgr.Register(std::move(itemGetPermanentBoostReal));
+		functionMgr.RegisterWithHandleVariant(std::move(itemGetPermanentBoostReal));
 
 
 		auto itemGetPermanentBoostString = std::make_unique<CustomQuery>(
@@ -637,7 +625,7 @@ namespace dse::esv
 			},
 			&func::ItemGetPermanentBoost<OsiPropertyMapType::String>
 		);
-		functionMgr.Register(std::move(itemGetPermanentBoostString));
+		functionMgr.RegisterWithHandleVariant(std::move(itemGetPermanentBoostString));
 
 
 		auto itemGetAbility = std::make_unique<CustomQuery>(
@@ -649,7 +637,7 @@ namespace dse::esv
 			},
 			&func::ItemGetPermanentBoostAbility
 		);
-		functionMgr.Register(std::move(itemGetAbility));
+		functionMgr.RegisterWithHandleVariant(std::move(itemGetAbility));
 
 
 		auto itemGetTalent = std::make_unique<CustomQuery>(
@@ -661,7 +649,7 @@ namespace dse::esv
 			},
 			&func::ItemGetPermanentBoostTalent
 		);
-		functionMgr.Register(std::move(itemGetTalent));
+		functionMgr.RegisterWithHandleVariant(std::move(itemGetTalent));
 
 
 		auto itemSetPermanentBoostInt = std::make_unique<CustomCall>(
@@ -673,7 +661,7 @@ namespace dse::esv
 			},
 			&func::ItemSetPermanentBoost<OsiPropertyMapType::Integer>
 		);
-		functionMgr.Register(std::move(itemSetPermanentBoostInt));
+		functionMgr.RegisterWithHandleVariant(std::move(itemSetPermanentBoostInt));
 
 
 		auto itemSetPermanentBoostReal = std::make_unique<CustomCall>(
@@ -685,7 +673,7 @@ namespace dse::esv
 			},
 			&func::ItemSetPermanentBoost<OsiPropertyMapType::Real>
 		);
-		functionMgr.Register(std::move(itemSetPermanentBoostReal));
+		functionMgr.RegisterWithHandleVariant(std::move(itemSetPermanentBoostReal));
 
 
 		auto itemSetPermanentBoostString = std::make_unique<CustomCall>(
@@ -697,7 +685,7 @@ namespace dse::esv
 			},
 			&func::ItemSetPermanentBoost<OsiPropertyMapType::String>
 		);
-		functionMgr.Register(std::move(itemSetPermanentBoostString));
+		functionMgr.RegisterWithHandleVariant(std::move(itemSetPermanentBoostString));
 
 
 		auto itemSetAbility = std::make_unique<CustomCall>(
@@ -709,7 +697,7 @@ namespace dse::esv
 			},
 			&func::ItemSetPermanentBoostAbility
 		);
-		functionMgr.Register(std::move(itemSetAbility));
+		functionMgr.RegisterWithHandleVariant(std::move(itemSetAbility));
 
 
 		auto itemSetTalent = std::make_unique<CustomCall>(
@@ -721,7 +709,7 @@ namespace dse::esv
 			},
 			&func::ItemSetPermanentBoostTalent
 		);
-		functionMgr.Register(std::move(itemSetTalent));
+		functionMgr.RegisterWithHandleVariant(std::move(itemSetTalent));
 		
 
 		auto itemConstructBegin = std::make_unique<CustomCall>(
@@ -740,7 +728,7 @@ namespace dse::esv
 			},
 			&func::ItemCloneBegin
 		);
-		functionMgr.Register(std::move(itemCloneBegin));
+		functionMgr.RegisterWithHandleVariant(std::move(itemCloneBegin));
 
 		auto itemClone = std::make_unique<CustomQuery>(
 			"NRD_ItemClone",
@@ -749,7 +737,7 @@ namespace dse::esv
 			},
 			&func::ItemClone
 		);
-		functionMgr.Register(std::move(itemClone));
+		functionMgr.RegisterWithHandleVariant(std::move(itemClone));
 
 		auto itemCloneSetInt = std::make_unique<CustomCall>(
 			"NRD_ItemCloneSetInt",
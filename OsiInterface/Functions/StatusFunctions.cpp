@@ -12,22 +12,149 @@ namespace dse::esv
 	FunctionHandle HealEventHandle;
 	FunctionHandle ActionStateEnterHandle;
 
-	esv::StatusMachine * GetStatusMachine(char const * gameObjectGuid)
+	esv::StatusMachine * GetStatusMachine(OsiArgumentValue const & gameObject)
 	{
-		auto character = GetEntityWorld()->GetCharacter(gameObjectGuid, false);
+		auto character = GetCharacterArg(gameObject, false);
 		if (character != nullptr) {
 			return character->StatusMachine;
 		}
 
-		auto item = GetEntityWorld()->GetItem(gameObjectGuid, false);
+		auto item = GetItemArg(gameObject, false);
 		if (item != nullptr) {
 			return item->StatusMachine;
 		}
 
-		OsiError("Character or item " << gameObjectGuid << " does not exist!");
+		OsiError("Character or item " << gameObject.ToString() << " does not exist!");
 		return nullptr;
 	}
 
+	esv::StatusMachine * GetStatusMachine(char const * gameObjectGuid)
+	{
+		return GetStatusMachine(OsiArgumentValue{ ValueType::GuidString, gameObjectGuid });
+	}
+
+
+	bool StatusApplyBatch::Prepare(char const* statusId)
+	{
+		Clear();
+
+		createStatus_ = GetStaticSymbols().StatusMachineCreateStatus;
+		applyStatus_ = GetStaticSymbols().StatusMachineApplyStatus;
+		if (createStatus_ == nullptr || applyStatus_ == nullptr) {
+			OsiErrorS("esv::StatusMachine::CreateStatus/ApplyStatus not found!");
+			return false;
+		}
+
+		statusId_ = ToFixedString(statusId);
+		auto protoMgr = GetStaticSymbols().eoc__StatusPrototypeManager;
+		if (!statusId_ || protoMgr == nullptr || *protoMgr == nullptr) {
+			OsiError("Status does not exist: " << statusId);
+			return false;
+		}
+
+		auto proto = (*protoMgr)->Prototypes.Find(statusId_);
+		if (proto == nullptr) {
+			OsiError("Status does not exist: " << statusId);
+			return false;
+		}
+
+		statusType_ = (*proto)->StatusId;
+		if (statusType_ == StatusType::HIT) {
+			OsiError("HIT statuses cannot be applied in a batch: " << statusId);
+			return false;
+		}
+
+		return true;
+	}
+
+	void StatusApplyBatch::Clear()
+	{
+		targets_.clear();
+	}
+
+	bool StatusApplyBatch::AddTarget(OsiArgumentValue const& target)
+	{
+		IEoCServerObject* object = GetCharacterArg(target, false);
+		if (object == nullptr) {
+			object = GetItemArg(target, false);
+		}
+
+		if (object != nullptr) {
+			ObjectHandle handle;
+			object->GetObjectHandle(handle);
+			targets_.push_back(handle);
+			return true;
+		}
+
+		OsiError("Character or item " << target.ToString() << " does not exist!");
+		SkipTarget();
+		return false;
+	}
+
+	void StatusApplyBatch::SkipTarget()
+	{
+		// Keeps status handles aligned with the target list
+		targets_.push_back(ObjectHandle{});
+	}
+
+	void StatusApplyBatch::Apply(Params const& params, std::vector<ObjectHandle>& statusHandles)
+	{
+		statusHandles.resize(targets_.size());
+		for (std::size_t i = 0; i < targets_.size(); i++) {
+			auto targetHandle = targets_[i];
+			statusHandles[i] = ObjectHandle{};
+			if (!targetHandle) {
+				continue;
+			}
+
+			// Status events of previous targets may have destroyed this one
+			IEoCServerObject* target{ nullptr };
+			StatusMachine* machine{ nullptr };
+			if (auto character = GetEntityWorld()->GetCharacter(targetHandle, false)) {
+				target = character;
+				machine = character->StatusMachine;
+			} else if (auto item = GetEntityWorld()->GetItem(targetHandle, false)) {
+				target = item;
+				machine = item->StatusMachine;
+			}
+
+			if (machine == nullptr) {
+				continue;
+			}
+
+			auto status = createStatus_(machine, statusId_, 0);
+			if (status == nullptr) {
+				OsiError("Failed to create status " << statusId_.Str);
+				continue;
+			}
+
+			if (params.LifeTime < 0.0f) {
+				status->Flags0 |= esv::StatusFlags0::KeepAlive;
+				status->CurrentLifeTime = 1.0f;
+			} else {
+				status->Flags0 |= esv::StatusFlags0::IsLifeTimeSet;
+				status->LifeTime = params.LifeTime;
+				status->CurrentLifeTime = params.LifeTime;
+			}
+
+			if (params.Force) {
+				status->Flags2 |= esv::StatusFlags2::ForceStatus;
+			}
+
+			status->TargetHandle = targetHandle;
+			status->StatusSourceHandle = params.Source;
+			status->StatsMultiplier = params.StatsMultiplier;
+
+			if (statusType_ == StatusType::ACTIVE_DEFENSE) {
+				static_cast<esv::StatusActiveDefense*>(status)->TargetPos = *target->GetTranslate();
+			}
+
+			// The apply hook throws the status events and tracks the pending status
+			statusHandles[i] = status->StatusHandle;
+			applyStatus_(machine, status);
+		}
+	}
+
 	PropertyMapBase & StatusToPropertyMap(esv::Status * status)
 	{
 		switch (status->GetStatusId()) {
@@ -86,10 +213,13 @@ namespace dse::esv
 	{
 		void IterateStatuses(OsiArgumentDesc const & args)
 		{
-			auto gameObjectGuid = args[0].String;
 			auto eventName = args[1].String;
 
-			auto statusMachine = GetStatusMachine(gameObjectGuid);
+			auto gameObject = GetGameObjectArg(args[0]);
+			if (gameObject == nullptr) return;
+
+			auto gameObjectGuid = gameObject->MyGuid.Str;
+			auto statusMachine = GetStatusMachine(args[0]);
 			if (statusMachine == nullptr) return;
 
 			for (auto const status : statusMachine->Statuses) {
@@ -106,7 +236,6 @@ namespace dse::esv
 
 		esv::Status * GetStatusHelper(OsiArgumentDesc const & args)
 		{
-			auto gameObjectGuid = args[0].String;
 			ObjectHandle statusHandle{ args[1].Int64 };
 
 			if (statusHandle.GetType() == DamageHelpers::HitHandleTypeId) {
@@ -116,15 +245,15 @@ namespace dse::esv
 			}
 
 			esv::Status * status{ nullptr };
-			auto character = GetEntityWorld()->GetCharacter(gameObjectGuid, false);
+			auto character = GetCharacterArg(args[0], false);
 			if (character != nullptr) {
 				status = character->GetStatus(statusHandle, true);
 			} else {
-				auto item = GetEntityWorld()->GetItem(gameObjectGuid, false);
+				auto item = GetItemArg(args[0], false);
 				if (item != nullptr) {
 					status = item->GetStatus(statusHandle, true);
 				} else {
-					OsiError("Character or item " << gameObjectGuid << " does not exist!");
+					OsiError("Character or item " << args[0].ToString() << " does not exist!");
 					return nullptr;
 				}
 			}
@@ -139,11 +268,10 @@ namespace dse::esv
 
 		bool ObjectHasStatusType(OsiArgumentDesc& args)
 		{
-			auto gameObjectGuid = args[0].String;
 			auto statusType = args[1].String;
 			auto& hasStatus = args[2];
 
-			auto statusMachine = GetStatusMachine(gameObjectGuid);
+			auto statusMachine = GetStatusMachine(args[0]);
 			if (statusMachine == nullptr) return false;
 			
 			auto typeId = EnumInfo<StatusType>::Find(statusType);
@@ -165,10 +293,9 @@ namespace dse::esv
 
 		bool StatusGetHandle(OsiArgumentDesc & args)
 		{
-			auto gameObjectGuid = args[0].String;
 			auto statusId = args[1].String;
 
-			auto statusMachine = GetStatusMachine(gameObjectGuid);
+			auto statusMachine = GetStatusMachine(args[0]);
 			if (statusMachine == nullptr) return false;
 
 			auto statusIdFS = ToFixedString(args[1].String);
@@ -345,12 +472,12 @@ namespace dse::esv
 
 		void StatusPreventApply(OsiArgumentDesc const & args)
 		{
-			auto gameObject = GetEntityWorld()->GetGameObject(args[0].String);
+			auto gameObject = GetGameObjectArg(args[0]);
 			auto statusHandle = ObjectHandle{ args[1].Int64 };
 			auto preventApply = args[2].Int32;
 
 			if (gameObject == nullptr) {
-				OsiError("Game object " << args[0].String << " does not exist!");
+				OsiError("Game object " << args[0].ToString() << " does not exist!");
 				return;
 			}
 
@@ -399,13 +526,12 @@ namespace dse::esv
 
 		bool ApplyActiveDefense(OsiArgumentDesc & args)
 		{
-			auto characterGuid = args[0].String;
 			auto statusId = args[1].String;
 			auto lifeTime = args[2].Float;
 
-			auto character = GetEntityWorld()->GetCharacter(characterGuid);
+			auto character = GetCharacterArg(args[0]);
 			if (character == nullptr) {
-				OsiError("Character " << characterGuid << " does not exist!");
+				OsiError("Character " << args[0].ToString() << " does not exist!");
 				return false;
 			}
 
@@ -449,15 +575,13 @@ namespace dse::esv
 
 		bool ApplyDamageOnMove(OsiArgumentDesc & args)
 		{
-			auto characterGuid = args[0].String;
 			auto statusId = args[1].String;
-			auto sourceCharacterGuid = args[2].String;
 			auto lifeTime = args[3].Float;
 			auto distancePerDamage = args[4].Float;
 
-			auto character = GetEntityWorld()->GetCharacter(characterGuid);
+			auto character = GetCharacterArg(args[0]);
 			if (character == nullptr) {
-				OsiError("Character " << characterGuid << " does not exist!");
+				OsiError("Character " << args[0].ToString() << " does not exist!");
 				return false;
 			}
 
@@ -492,7 +616,7 @@ namespace dse::esv
 				status->CurrentLifeTime = lifeTime;
 			}
 
-			auto sourceCharacter = GetEntityWorld()->GetCharacter(sourceCharacterGuid);
+			auto sourceCharacter = GetCharacterArg(args[2]);
 			if (sourceCharacter == nullptr) {
 				status->StatusSourceHandle = ObjectHandle{};
 			} else {
@@ -515,9 +639,8 @@ namespace dse::esv
 		template <OsiPropertyMapType Type>
 		bool ActionStateGet(OsiArgumentDesc & args)
 		{
-			auto characterGuid = args[0].String;
 
-			auto character = GetEntityWorld()->GetCharacter(characterGuid);
+			auto character = GetCharacterArg(args[0]);
 			if (character == nullptr
 				|| character->ActionMachine == nullptr
 				|| character->ActionMachine->Layers[0].State == nullptr) {
@@ -546,10 +669,9 @@ namespace dse::esv
 
 		bool CharacterGetCurrentAction(OsiArgumentDesc & args)
 		{
-			auto characterGuid = args[0].String;
 			auto & action = args[1];
 
-			auto character = GetEntityWorld()->GetCharacter(characterGuid);
+			auto character = GetCharacterArg(args[0]);
 			if (character == nullptr
 				|| character->ActionMachine == nullptr) {
 				return false;
@@ -819,7 +941,7 @@ namespace dse::esv
 			},
 			&func::IterateStatuses
 		);
-		functionMgr.Register(std::move(iterateCharacterStatuses));
+		functionMgr.RegisterWithHandleVariant(std::move(iterateCharacterStatuses));
 
 		auto hasStatusType = std::make_unique<CustomQuery>(
 			"NRD_ObjectHasStatusType",
@@ -830,7 +952,7 @@ namespace dse::esv
 			},
 			&func::ObjectHasStatusType
 		);
-		functionMgr.Register(std::move(hasStatusType));
+		functionMgr.RegisterWithHandleVariant(std::move(hasStatusType));
 
 		auto getStatusHandle = std::make_unique<CustomQuery>(
 			"NRD_StatusGetHandle",
@@ -841,7 +963,7 @@ namespace dse::esv
 			},
 			&func::StatusGetHandle
 		);
-		functionMgr.Register(std::move(getStatusHandle));
+		functionMgr.RegisterWithHandleVariant(std::move(getStatusHandle));
 
 		auto getStatusAttributeInt = std::make_unique<CustomQuery>(
 			"NRD_StatusGetInt",
@@ -853,7 +975,7 @@ namespace dse::esv
 			},
 			&func::StatusGetAttribute<OsiPropertyMapType::Integer>
 		);
-		functionMgr.Register(std::move(getStatusAttributeInt));
+		functionMgr.RegisterWithHandleVariant(std::move(getStatusAttributeInt));
 
 		auto getStatusAttributeReal = std::make_unique<CustomQuery>(
 			"NRD_StatusGetReal",
@@ -865,7 +987,7 @@ namespace dse::esv
 			},
 			&func::StatusGetAttribute<OsiPropertyMapType::Real>
 		);
-		functionMgr.Register(std::move(getStatusAttributeReal));
+		functionMgr.RegisterWithHandleVariant(std::move(getStatusAttributeReal));
 
 		auto getStatusAttributeString = std::make_unique<CustomQuery>(
 			"NRD_StatusGetString",
@@ -877,7 +999,7 @@ namespace dse::esv
 			},
 			&func::StatusGetAttribute<OsiPropertyMapType::String>
 		);
-		functionMgr.Register(std::move(getStatusAttributeString));
+		functionMgr.RegisterWithHandleVariant(std::move(getStatusAttributeString));
 
 		auto getStatusAttributeGuidString = std::make_unique<CustomQuery>(
 			"NRD_StatusGetGuidString",
@@ -901,7 +1023,7 @@ namespace dse::esv
 			},
 			&func::StatusSetAttribute<OsiPropertyMapType::Integer>
 		);
-		functionMgr.Register(std::move(setStatusAttributeInt));
+		functionMgr.RegisterWithHandleVariant(std::move(setStatusAttributeInt));
 
 		auto setStatusAttributeReal = std::make_unique<CustomCall>(
 			"NRD_StatusSetReal",
@@ -913,7 +1035,7 @@ namespace dse::esv
 			},
 			&func::StatusSetAttribute<OsiPropertyMapType::Real>
 		);
-		functionMgr.Register(std::move(setStatusAttributeReal));
+		functionMgr.RegisterWithHandleVariant(std::move(setStatusAttributeReal));
 
 		auto setStatusAttributeString = std::make_unique<CustomCall>(
 			"NRD_StatusSetString",
@@ -925,7 +1047,7 @@ namespace dse::esv
 			},
 			&func::StatusSetAttribute<OsiPropertyMapType::String>
 		);
-		functionMgr.Register(std::move(setStatusAttributeString));
+		functionMgr.RegisterWithHandleVariant(std::move(setStatusAttributeString));
 
 		auto setStatusAttributeGuidString = std::make_unique<CustomCall>(
 			"NRD_StatusSetGuidString",
@@ -951,7 +1073,7 @@ namespace dse::esv
 			},
 			&func::StatusSetAttribute<OsiPropertyMapType::Vector3>
 		);
-		functionMgr.Register(std::move(setStatusAttributeVector3));
+		functionMgr.RegisterWithHandleVariant(std::move(setStatusAttributeVector3));
 
 		auto statusPreventApply = std::make_unique<CustomCall>(
 			"NRD_StatusPreventApply",
@@ -962,7 +1084,7 @@ namespace dse::esv
 			},
 			&func::StatusPreventApply
 		);
-		functionMgr.Register(std::move(statusPreventApply));
+		functionMgr.RegisterWithHandleVariant(std::move(statusPreventApply));
 
 		auto statusIteratorEvent = std::make_unique<CustomEvent>(
 			"NRD_StatusIteratorEvent",
@@ -996,7 +1118,7 @@ namespace dse::esv
 			},
 			&func::ApplyActiveDefense
 		);
-		functionMgr.Register(std::move(applyActiveDefense));
+		functionMgr.RegisterWithHandleVariant(std::move(applyActiveDefense));
 
 		auto applyDamageOnMove = std::make_unique<CustomQuery>(
 			"NRD_ApplyDamageOnMove",
@@ -1010,7 +1132,7 @@ namespace dse::esv
 			},
 			&func::ApplyDamageOnMove
 		);
-		functionMgr.Register(std::move(applyDamageOnMove));
+		functionMgr.RegisterWithHandleVariant(std::move(applyDamageOnMove));
 
 		auto hitPrepareEvent = std::make_unique<CustomEvent>(
 			"NRD_OnPrepareHit",
@@ -1063,7 +1185,7 @@ namespace dse::esv
 			},
 			&func::CharacterGetCurrentAction
 		);
-		functionMgr.Register(std::move(characterGetCurrentAction));
+		functionMgr.RegisterWithHandleVariant(std::move(characterGetCurrentAction));
 
 		auto actionStateGetString = std::make_unique<CustomQuery>(
 			"NRD_ActionStateGetString",
@@ -1074,7 +1196,7 @@ namespace dse::esv
 			},
 			&func::ActionStateGet<OsiPropertyMapType::String>
 		);
-		functionMgr.Register(std::move(actionStateGetString));
+		functionMgr.RegisterWithHandleVariant(std::move(actionStateGetString));
 	}
 
 }
@@ -193,16 +193,18 @@ namespace dse
 				return nullptr;
 			}
 
-			auto component = Components[(uint32_t)componentType].component->FindComponentByGuid(&fs);
-			if (component != nullptr) {
-				return component;
-			}
-			else {
-				if (logError) {
-					OsiError("No " << ComponentTypeToName(componentType).Str << " component found with GUID '" << nameGuid << "'");
-				}
-				return nullptr;
+			auto component = GetComponentByGuid(componentType, fs);
+			if (component == nullptr && logError) {
+				OsiError("No " << ComponentTypeToName(componentType).Str << " component found with GUID '" << nameGuid << "'");
 			}
+
+			return component;
+		}
+
+		// Looks up a component by its GUID FixedString; doesn't log if the component doesn't exist
+		void* GetComponentByGuid(TComponentType componentType, FixedString const& guid)
+		{
+			return Components[(uint32_t)componentType].component->FindComponentByGuid(&guid);
 		}
 
 		void* GetComponent(TComponentType type, NetId netId, bool logError = true)
@@ -450,16 +452,7 @@ namespace dse
 				return (TurnManager*)((uint8_t*)system.System - 8);
 			}
 
-			inline Character* GetCharacter(char const* nameGuid, bool logError = true)
-			{
-				auto component = GetComponent(ComponentType::Character, nameGuid, logError);
-				if (component != nullptr) {
-					return (Character*)((uint8_t*)component - 8);
-				}
-				else {
-					return nullptr;
-				}
-			}
+			Character* GetCharacter(char const* nameGuid, bool logError = true);
 
 			inline Character* GetCharacter(ObjectHandle handle, bool logError = true)
 			{
@@ -483,16 +476,7 @@ namespace dse
 				}
 			}
 
-			inline Item* GetItem(char const* nameGuid, bool logError = true)
-			{
-				auto component = GetComponent(ComponentType::Item, nameGuid, logError);
-				if (component != nullptr) {
-					return (Item*)((uint8_t*)component - 8);
-				}
-				else {
-					return nullptr;
-				}
-			}
+			Item* GetItem(char const* nameGuid, bool logError = true);
 
 			inline Item* GetItem(ObjectHandle handle, bool logError = true)
 			{
@@ -518,8 +502,55 @@ namespace dse
 
 			IEoCServerObject* GetGameObject(char const* nameGuid, bool logError = true);
 			IEoCServerObject* GetGameObject(ObjectHandle handle, bool logError = true);
+
+		private:
+			// Looks up a character and/or item by GUID using gGameObjectGuidCache
+			IEoCServerObject* FindGameObjectByGuid(char const* nameGuid, bool characters, bool items, bool logError);
+		};
+
+		// Caches the handles of server characters and items looked up by GUID, so repeated
+		// lookups (eg. of party members from Osiris) don't have to go through the component
+		// GUID maps. Cached handles are validated on every hit (factory salt and object GUID),
+		// so stale entries are never returned; the cache is cleared on server game state changes.
+		class GameObjectGuidCache
+		{
+		public:
+			// Direct-mapped table with 2^NumEntriesLog2 entries
+			static constexpr uint32_t NumEntriesLog2 = 10;
+			static constexpr uint32_t NumEntries = 1 << NumEntriesLog2;
+
+			// Returns a null handle if the GUID is not cached
+			ObjectHandle Find(FixedString const& guid);
+			void Add(FixedString const& guid, ObjectHandle handle);
+			void Clear();
+
+		private:
+			struct Entry
+			{
+				char const* Guid{ nullptr };
+				ObjectHandle Handle;
+			};
+
+			struct ThreadTable
+			{
+				uint32_t Generation{ 0xffffffff };
+				std::array<Entry, NumEntries> Entries;
+			};
+
+			// Lookups happen on multiple server threads; each thread has its own table
+			static thread_local ThreadTable threadTable_;
+
+			std::atomic<uint32_t> generation_{ 0 };
+
+			static inline uint32_t GetSlot(char const* guid)
+			{
+				// Fibonacci hashing of the string pointer
+				return (uint32_t)(((uint64_t)guid * 0x9E3779B97F4A7C15ull) >> (64 - NumEntriesLog2));
+			}
 		};
 
+		extern GameObjectGuidCache gGameObjectGuidCache;
+
 		struct CharacterFactory : public NetworkObjectFactory<esv::Character, (uint32_t)ObjectType::ServerCharacter>
 		{
 			void* VMT2;
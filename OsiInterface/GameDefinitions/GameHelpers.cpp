@@ -358,35 +358,43 @@ namespace dse
 
 	void PendingStatuses::Add(esv::Status * status)
 	{
-		PendingStatus pend { status, false };
-		statuses_.insert(std::make_pair(status->StatusHandle, pend));
+		for (auto const& pending : statuses_) {
+			if (pending.Status->StatusHandle == status->StatusHandle) {
+				return;
+			}
+		}
+
+		statuses_.push_back(PendingStatus{ status, false });
 	}
 
 	void PendingStatuses::Remove(esv::Status * status)
 	{
-		auto it = statuses_.find(status->StatusHandle);
-		if (it != statuses_.end()) {
-			statuses_.erase(it);
-		} else {
-			OsiError("Attempted to remove non-pending status " << std::hex << (int64_t)status->StatusHandle);
+		// Statuses are usually removed in reverse order of addition
+		for (auto i = statuses_.size(); i > 0; i--) {
+			if (statuses_[i - 1].Status->StatusHandle == status->StatusHandle) {
+				statuses_.erase(statuses_.begin() + (i - 1));
+				return;
+			}
 		}
+
+		OsiError("Attempted to remove non-pending status " << std::hex << (int64_t)status->StatusHandle);
 	}
 
 	PendingStatus * PendingStatuses::Find(ObjectHandle owner, ObjectHandle handle)
 	{
-		auto it = statuses_.find(handle);
-		if (it != statuses_.end()) {
-			auto & status = it->second;
-			if (owner == status.Status->TargetHandle) {
-				return &status;
-			} else {
-				OsiError("Attempted to retrieve pending status " << std::hex << (int64_t)status.Status->StatusHandle
-					<< " on wrong character!");
-				return nullptr;
+		for (auto & status : statuses_) {
+			if (status.Status->StatusHandle == handle) {
+				if (owner == status.Status->TargetHandle) {
+					return &status;
+				} else {
+					OsiError("Attempted to retrieve pending status " << std::hex << (int64_t)status.Status->StatusHandle
+						<< " on wrong character!");
+					return nullptr;
+				}
 			}
-		} else {
-			return nullptr;
 		}
+
+		return nullptr;
 	}
 
 	esv::Status * esv::StatusMachine::GetStatus(ObjectHandle handle) const
@@ -554,6 +562,12 @@ namespace dse
 	}
 
 	void HitDamageInfo::CopyFrom(HitDamageInfo const& src)
+	{
+		CopyWithoutDamageList(src);
+		DamageList.CopyFrom(src.DamageList);
+	}
+
+	void HitDamageInfo::CopyWithoutDamageList(HitDamageInfo const& src)
 	{
 		Equipment = src.Equipment;
 		TotalDamage = src.TotalDamage;
@@ -565,7 +579,6 @@ namespace dse
 		LifeSteal = src.LifeSteal;
 		EffectFlags = src.EffectFlags;
 		HitWithWeapon = src.HitWithWeapon;
-		DamageList.CopyFrom(src.DamageList);
 	}
 
 
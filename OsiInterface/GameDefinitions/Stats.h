@@ -3,6 +3,10 @@
 #include "BaseTypes.h"
 #include "Enumerations.h"
 #include "Wrappers.h"
+#include <StatLevelMapCache.h>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
 
 namespace dse
 {
@@ -262,6 +266,17 @@ namespace dse
 
 	struct CDivinityStats_Condition;
 
+	// Non-indexed fields of a stats entry that can be synced separately
+	enum class StatSyncField : uint32_t
+	{
+		AIFlags = 1 << 0,
+		Requirements = 1 << 1,
+		MemorizationRequirements = 1 << 2,
+		ComboCategories = 1 << 3,
+		PropertyLists = 1 << 4,
+		All = AIFlags | Requirements | MemorizationRequirements | ComboCategories | PropertyLists
+	};
+
 	struct CRPGStats_Object : public Noncopyable<CRPGStats_Object>
 	{
 		void* VMT{ nullptr };
@@ -291,8 +306,11 @@ namespace dse
 		uint32_t D{ 0 };
 
 		void ToProtobuf(class MsgS2CSyncStat* msg) const;
+		// Writes a partial update containing only the specified indexed properties and fields
+		void ToProtobuf(MsgS2CSyncStat* msg, std::vector<uint32_t> const& indexedProperties, uint32_t fields) const;
 		void FromProtobuf(MsgS2CSyncStat const& msg);
-		void BroadcastSyncMessage() const;
+		void FieldsToProtobuf(MsgS2CSyncStat* msg, uint32_t fields) const;
+		void FieldsFromProtobuf(MsgS2CSyncStat const& msg, uint32_t fields);
 	};
 
 	struct CRPGStats_ObjectInstance : public CRPGStats_Object
@@ -966,6 +984,44 @@ namespace dse
 
 	extern CRPGStatsVMTMappings gCRPGStatsVMTMappings;
 
+	// Attributes that are handled specially by the Lua stat accessors
+	enum class StatAttributeSpecial : uint8_t
+	{
+		None,
+		Level,
+		Name,
+		ModId,
+		Using,
+		Requirements,
+		MemorizationRequirements,
+		AIFlags,
+		ComboCategory,
+		PropertyList
+	};
+
+	enum class StatAttributeType : uint8_t
+	{
+		// Attribute is not stored in IndexedProperties
+		None,
+		FixedString,
+		AttributeFlags,
+		ConstantInt,
+		Conditions,
+		Other
+	};
+
+	struct StatAttributeInfo
+	{
+		FixedString Name;
+		RPGEnumeration* Enumeration{ nullptr };
+		int32_t Index{ -1 };
+		int32_t LevelMapIndex{ -1 };
+		StatAttributeType Type{ StatAttributeType::None };
+		StatAttributeSpecial Special{ StatAttributeSpecial::None };
+	};
+
+	StatAttributeType GetStatAttributeType(RPGEnumeration* enumeration);
+
 	struct CRPGStatsManager : public ProtectedGameObject<CRPGStatsManager>
 	{
 		typedef void (*LoadProc)(CRPGStatsManager* self);
@@ -1021,6 +1077,11 @@ namespace dse
 		std::optional<int> GetAttributeIntScaled(CRPGStats_Object * object, FixedString const& attributeName, int level);
 		bool SetAttributeString(CRPGStats_Object * object, FixedString const& attributeName, const char * value);
 		bool SetAttributeInt(CRPGStats_Object * object, FixedString const& attributeName, int32_t value);
+		std::optional<char const *> GetAttributeString(CRPGStats_Object * object, StatAttributeInfo const& attribute);
+		std::optional<int> GetAttributeInt(CRPGStats_Object * object, StatAttributeInfo const& attribute);
+		std::optional<int> GetAttributeIntScaled(CRPGStats_Object * object, StatAttributeInfo const& attribute, int level);
+		bool SetAttributeString(CRPGStats_Object * object, StatAttributeInfo const& attribute, const char * value);
+		bool SetAttributeInt(CRPGStats_Object * object, StatAttributeInfo const& attribute, int32_t value);
 		bool ObjectExists(FixedString const& statsId, FixedString const& type);
 		std::optional<CRPGStats_Object*> CreateObject(FixedString const& name, FixedString const& type);
 		std::optional<CRPGStats_Object*> CreateObject(FixedString const& name, int32_t modifierListIndex);
@@ -1044,6 +1105,61 @@ namespace dse
 	CRPGStats_Object * StatFindObject(int index);
 #pragma pack(pop)
 
+	// Precomputed attribute lookup tables for each modifier list, so attribute accesses
+	// don't need to go through the modifier list / enumeration lookups each time
+	class StatAttributeCache
+	{
+	public:
+		void Build(CRPGStatsManager* stats);
+		void Clear();
+
+		// Returns nullptr if the modifier list has no attribute with the specified name
+		StatAttributeInfo const* Find(CRPGStatsManager* stats, int32_t modifierListIndex, FixedString const& name);
+
+	private:
+		std::mutex mutex_;
+		std::atomic<bool> built_{ false };
+		std::vector<std::unordered_map<FixedString, StatAttributeInfo>> modifierLists_;
+
+		void BuildModifierLists(CRPGStatsManager* stats);
+	};
+
+	extern StatAttributeCache gStatAttributeCache;
+
+	// Names of stats entries grouped by modifier list (stats type), in creation order
+	class StatEntryIndex
+	{
+	public:
+		void Build(CRPGStatsManager* stats);
+		void Clear();
+		void OnObjectCreated(CRPGStats_Object* object);
+
+		// Calls the visitor for each stats entry of the specified modifier list
+		template <class Visitor>
+		void Iterate(CRPGStatsManager* stats, int32_t modifierListIndex, Visitor visitor)
+		{
+			if (!built_) {
+				Build(stats);
+			}
+
+			std::shared_lock lock(mutex_);
+			if (modifierListIndex >= 0 && modifierListIndex < (int32_t)entries_.size()) {
+				for (auto const& name : entries_[modifierListIndex]) {
+					visitor(name);
+				}
+			}
+		}
+
+	private:
+		std::shared_mutex mutex_;
+		std::atomic<bool> built_{ false };
+		std::vector<std::vector<FixedString>> entries_;
+	};
+
+	extern StatEntryIndex gStatEntryIndex;
+
+	extern StatLevelMapCache gStatLevelMapCache;
+
 	template <class TTag>
 	std::optional<int32_t> CharacterStatGetter(CDivinityStats_Character__GetStat * getter,
 		WrappableFunction<TTag, CDivinityStats_Character__GetStat> & wrapper,
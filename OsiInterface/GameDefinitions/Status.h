@@ -42,6 +42,8 @@ namespace dse
 		void ClearDamage(dse::DamageType damageType);
 		void AddDamage(dse::DamageType damageType, int32_t amount);
 		void CopyFrom(HitDamageInfo const& src);
+		// Copies everything except DamageList
+		void CopyWithoutDamageList(HitDamageInfo const& src);
 	};
 
 	namespace esv
@@ -382,6 +384,9 @@ namespace dse
 		bool PreventApply;
 	};
 
+	// Statuses that are being applied (ApplyStatus hook). Only a few statuses are pending
+	// at the same time (nested applies from event handlers), so a flat list is used;
+	// its storage is kept between applies.
 	class PendingStatuses
 	{
 	public:
@@ -390,6 +395,6 @@ namespace dse
 		PendingStatus * Find(ObjectHandle owner, ObjectHandle statusHandle);
 
 	private:
-		std::unordered_map<ObjectHandle, PendingStatus> statuses_;
+		std::vector<PendingStatus> statuses_;
 	};
 }
\ No newline at end of file
@@ -184,6 +184,8 @@ namespace dse
 		ScriptCheckBlock__Build ScriptCheckBlock__Build{ nullptr };
 
 		esv::LevelManager ** LevelManager{ nullptr };
+		esv::CharacterFactory ** EsvCharacterFactory{ nullptr };
+		esv::ItemFactory ** EsvItemFactory{ nullptr };
 		esv::InventoryFactory ** EsvInventoryFactory{ nullptr };
 		esv::SurfaceActionFactory** EsvSurfaceActionFactory{ nullptr };
 		esv::EoCServer ** EoCServer{ nullptr };
@@ -233,6 +235,24 @@ namespace dse
 		}
 
 
+		inline esv::CharacterFactory * GetCharacterFactory() const
+		{
+			if (EsvCharacterFactory) {
+				return *EsvCharacterFactory;
+			} else {
+				return nullptr;
+			}
+		}
+
+		inline esv::ItemFactory * GetItemFactory() const
+		{
+			if (EsvItemFactory) {
+				return *EsvItemFactory;
+			} else {
+				return nullptr;
+			}
+		}
+
 		inline esv::InventoryFactory * GetInventoryFactory() const
 		{
 			if (EsvInventoryFactory) {
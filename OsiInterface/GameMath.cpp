@@ -0,0 +1,1407 @@
+// Compiled without the precompiled header, so the standalone differential test can build it as well
+#include "GameMath.h"
+#include <cmath>
+
+namespace dse::gamemath
+{
+	void DamageList::Add(DamageType type, int32_t amount)
+	{
+		if (amount == 0) return;
+
+		for (auto it = Damages.begin(); it != Damages.end(); ++it) {
+			if (it->Type == type) {
+				auto newAmount = it->Amount + amount;
+				if (newAmount == 0) {
+					Damages.erase(it);
+				} else {
+					it->Amount = newAmount;
+				}
+				return;
+			}
+		}
+
+		Damages.push_back({ type, amount });
+	}
+
+	int32_t DamageList::GetByType(DamageType type) const
+	{
+		int32_t amount = 0;
+		for (auto const& dmg : Damages) {
+			if (dmg.Type == type) {
+				amount += dmg.Amount;
+			}
+		}
+
+		return amount;
+	}
+
+	void DamageList::Clear()
+	{
+		Damages.clear();
+	}
+
+	void DamageList::Clear(DamageType type)
+	{
+		for (size_t i = 0; i < Damages.size(); i++) {
+			if (Damages[i].Type == type) {
+				Damages.erase(Damages.begin() + i);
+				i--;
+			}
+		}
+	}
+
+	void DamageList::Multiply(double multiplier)
+	{
+		for (auto& dmg : Damages) {
+			dmg.Amount = (int32_t)round(dmg.Amount * multiplier);
+		}
+	}
+
+	void DamageList::Merge(DamageList const& other)
+	{
+		for (auto const& dmg : other.Damages) {
+			Add(dmg.Type, dmg.Amount);
+		}
+	}
+
+	void DamageList::ConvertDamageType(DamageType type)
+	{
+		int32_t totalDamage = 0;
+		for (auto const& dmg : Damages) {
+			totalDamage += dmg.Amount;
+		}
+
+		Damages.clear();
+		Add(type, totalDamage);
+	}
+
+	void DamageList::AggregateSameTypeDamages()
+	{
+		for (size_t i = Damages.size(); i > 0; i--) {
+			auto const& src = Damages[i - 1];
+			for (size_t j = i - 1; j > 0; j--) {
+				auto& dest = Damages[j - 1];
+				if (src.Type == dest.Type) {
+					dest.Amount += src.Amount;
+					Damages.erase(Damages.begin() + (i - 1));
+					break;
+				}
+			}
+		}
+	}
+
+
+	namespace
+	{
+		// Whether a float result of math.floor/math.ceil fits in a Lua integer
+		bool FitsInteger(double v)
+		{
+			return v >= -9223372036854775808.0 && v < 9223372036854775808.0;
+		}
+
+		// Number -> integer conversion of luaL_checkinteger
+		int64_t ToInteger(double v)
+		{
+			if (!FitsInteger(v) || std::floor(v) != v) {
+				throw ScriptError{};
+			}
+
+			return (int64_t)v;
+		}
+
+		// math.ceil: the result is a Lua integer when it fits, so -0.0 becomes 0
+		double LuaCeil(double v)
+		{
+			auto result = std::ceil(v);
+			return FitsInteger(result) ? (double)(int64_t)result : result;
+		}
+
+		// math.floor
+		double LuaFloor(double v)
+		{
+			auto result = std::floor(v);
+			return FitsInteger(result) ? (double)(int64_t)result : result;
+		}
+
+		// Ext.Round
+		double Round(double v)
+		{
+			return round(v);
+		}
+
+		// math.max(a, b): keeps a unless a < b (differs from fmax for NaN)
+		double LuaMax(double a, double b)
+		{
+			return (a < b) ? b : a;
+		}
+
+		// math.deg
+		double Deg(double v)
+		{
+			return v * (180.0 / 3.141592653589793238462643383279502884);
+		}
+
+		// damageList:Add(type, amount) with a Lua number argument
+		void AddDamage(DamageList& damageList, DamageType type, double amount)
+		{
+			damageList.Add(type, (int32_t)ToInteger(amount));
+		}
+
+		bool IsRangedWeapon(Item const& item)
+		{
+			auto type = item.WeaponType;
+			return type == WeaponType::Bow || type == WeaponType::Crossbow || type == WeaponType::Wand || type == WeaponType::Rifle;
+		}
+
+		DeathType DamageTypeToDeathType(DamageType damageType)
+		{
+			switch (damageType) {
+			case DamageType::Physical: return DeathType::Physical;
+			case DamageType::Piercing: return DeathType::Piercing;
+			case DamageType::Fire: return DeathType::Incinerate;
+			case DamageType::Air: return DeathType::Electrocution;
+			case DamageType::Water: return DeathType::FrozenShatter;
+			case DamageType::Earth: return DeathType::PetrifiedShatter;
+			case DamageType::Poison: return DeathType::Acid;
+			default: return DeathType::Sentinel;
+			}
+		}
+
+		std::optional<DeathType> GetDamageListDeathType(DamageList const& damageList)
+		{
+			int64_t biggestDamage = -1;
+			std::optional<DeathType> deathType;
+
+			for (auto const& damage : damageList.Damages) {
+				if (damage.Amount > biggestDamage) {
+					deathType = DamageTypeToDeathType(damage.Type);
+					biggestDamage = damage.Amount;
+				}
+			}
+
+			return deathType;
+		}
+
+		// Damage and damage range of one damage type, in DamageType order
+		struct DamageTypeRanges
+		{
+			bool Present[NumDamageTypes]{};
+			double Min[NumDamageTypes]{};
+			double Max[NumDamageTypes]{};
+		};
+
+		// Functions of Game.Math.lua, evaluated in the same order and precision as the Lua code
+		class Formulas
+		{
+		public:
+			Formulas(Environment* env, ExtraData const& extra)
+				: env_(env), extra_(extra)
+			{}
+
+			double ScaledDamageFromPrimaryAttribute(double primaryAttr)
+			{
+				return (primaryAttr - extra_.AttributeBaseValue) * extra_.DamageBoostFromAttribute;
+			}
+
+			double GetPrimaryAttributeAmount(Skill const& skill, Character const& character)
+			{
+				auto main = character.GetMainWeapon();
+				if (skill.UseWeaponDamage && main != nullptr) {
+					auto offHand = character.GetOffHandWeapon();
+					if (offHand != nullptr && IsRangedWeapon(*main) == IsRangedWeapon(*offHand)) {
+						return (GetItemRequirementAttribute(character, *main) + GetItemRequirementAttribute(character, *offHand)) * 0.5;
+					} else {
+						return GetItemRequirementAttribute(character, *main);
+					}
+				}
+
+				switch (skill.Ability) {
+				case SkillAbility::Warrior:
+				case SkillAbility::Polymorph:
+					return Stat(character, CharacterStat::Strength);
+
+				case SkillAbility::Ranger:
+				case SkillAbility::Rogue:
+					return Stat(character, CharacterStat::Finesse);
+
+				default:
+					return Stat(character, CharacterStat::Intelligence);
+				}
+			}
+
+			double GetSkillAttributeDamageScale(Skill const& skill, Character const* attacker)
+			{
+				// The "skill.Ability == 0" check of the Lua code is never true, as Ability is a string
+				if (attacker == nullptr || skill.UseWeaponDamage) {
+					return 1.0;
+				} else {
+					auto primaryAttr = GetPrimaryAttributeAmount(skill, *attacker);
+					return 1.0 + ScaledDamageFromPrimaryAttribute(primaryAttr);
+				}
+			}
+
+			double GetDamageMultipliers(Skill const& skill, bool stealthed, double const (&attackerPos)[3], double const (&targetPos)[3])
+			{
+				double stealthDamageMultiplier = 1.0;
+				if (stealthed) {
+					stealthDamageMultiplier = skill.StealthDamageMultiplier * 0.01;
+				}
+
+				auto targetDistance = sqrt(pow(attackerPos[0] - targetPos[0], 2.0) + pow(attackerPos[2] - targetPos[2], 2.0));
+				double distanceDamageMultiplier = 1.0;
+				if (targetDistance > 1.0) {
+					distanceDamageMultiplier = Round(targetDistance) * skill.DistanceDamageMultiplier * 0.01 + 1;
+				}
+
+				auto damageMultiplier = skill.DamageMultiplier * 0.01;
+				return stealthDamageMultiplier * distanceDamageMultiplier * damageMultiplier;
+			}
+
+			double GetVitalityBoostByLevel(int64_t level)
+			{
+				auto expGrowth = extra_.VitalityExponentialGrowth;
+				auto growth = pow(expGrowth, (double)(level - 1));
+
+				if (level >= extra_.FirstVitalityLeapLevel) {
+					growth = growth * extra_.FirstVitalityLeapGrowth / expGrowth;
+				}
+
+				if (level >= extra_.SecondVitalityLeapLevel) {
+					growth = growth * extra_.SecondVitalityLeapGrowth / expGrowth;
+				}
+
+				if (level >= extra_.ThirdVitalityLeapLevel) {
+					growth = growth * extra_.ThirdVitalityLeapGrowth / expGrowth;
+				}
+
+				if (level >= extra_.FourthVitalityLeapLevel) {
+					growth = growth * extra_.FourthVitalityLeapGrowth / expGrowth;
+				}
+
+				auto vit = level * extra_.VitalityLinearGrowth + extra_.VitalityStartingAmount * growth;
+				return Round(vit / 5.0) * 5.0;
+			}
+
+			double GetLevelScaledDamage(int64_t level)
+			{
+				auto vitalityBoost = GetVitalityBoostByLevel(level);
+				return vitalityBoost / (((level - 1) * extra_.VitalityToDamageRatioGrowth) + extra_.VitalityToDamageRatio);
+			}
+
+			double GetAverageLevelDamage(int64_t level)
+			{
+				auto scaled = GetLevelScaledDamage(level);
+				return ((level * extra_.ExpectedDamageBoostFromAttributePerLevel) + 1.0) * scaled
+					* ((level * extra_.ExpectedDamageBoostFromSkillAbilityPerLevel) + 1.0);
+			}
+
+			double GetLevelScaledWeaponDamage(int64_t level)
+			{
+				auto scaledDmg = GetLevelScaledDamage(level);
+				return scaledDmg / ((level * extra_.ExpectedDamageBoostFromWeaponAbilityPerLevel) + 1.0);
+			}
+
+			double GetLevelScaledMonsterWeaponDamage(int64_t level)
+			{
+				auto weaponDmg = GetLevelScaledWeaponDamage(level);
+				return ((level * extra_.MonsterDamageBoostPerLevel) + 1.0) * weaponDmg;
+			}
+
+			double GetShieldPhysicalArmor(Character const& attacker)
+			{
+				auto shield = attacker.GetShield();
+				if (shield == nullptr || shield->ItemType != EquipmentStatsType::Shield) {
+					return 0;
+				}
+
+				int64_t armor = 0;
+				double boost = 0;
+				for (auto const& stat : shield->DynamicStats) {
+					if (stat.StatsType == EquipmentStatsType::Shield) {
+						armor = armor + stat.ArmorValue;
+						boost = boost + stat.ArmorBoost * 0.01;
+					}
+				}
+
+				return armor * (1.0 + boost);
+			}
+
+			double GetDamageBoostByType(Character const& character, DamageType damageType)
+			{
+				double boost;
+				switch (damageType) {
+				case DamageType::Physical:
+					boost = Stat(character, CharacterStat::WarriorLore) * extra_.SkillAbilityPhysicalDamageBoostPerPoint;
+					break;
+
+				case DamageType::Fire:
+					boost = Stat(character, CharacterStat::FireSpecialist) * extra_.SkillAbilityFireDamageBoostPerPoint;
+					break;
+
+				case DamageType::Air:
+					boost = Stat(character, CharacterStat::AirSpecialist) * extra_.SkillAbilityAirDamageBoostPerPoint;
+					break;
+
+				case DamageType::Water:
+					boost = Stat(character, CharacterStat::WaterSpecialist) * extra_.SkillAbilityWaterDamageBoostPerPoint;
+					break;
+
+				case DamageType::Earth:
+				case DamageType::Poison:
+					boost = Stat(character, CharacterStat::EarthSpecialist) * extra_.SkillAbilityPoisonAndEarthDamageBoostPerPoint;
+					break;
+
+				default:
+					return 0.0;
+				}
+
+				return boost / 100.0;
+			}
+
+			void ApplyDamageBoosts(Character const& character, DamageList& damageList)
+			{
+				auto damages = damageList.Damages;
+				for (auto const& damage : damages) {
+					auto boost = GetDamageBoostByType(character, damage.Type);
+					if (boost > 0.0) {
+						AddDamage(damageList, damage.Type, Round(damage.Amount * boost));
+					}
+				}
+			}
+
+			// level is nullopt if the Lua code would pass a string (skill.OverrideSkillLevel)
+			double CalculateBaseDamage(DamageSource source, Character const* attacker, std::optional<int64_t> level)
+			{
+				switch (source) {
+				case DamageSource::BaseLevelDamage:
+					return Round(GetLevelScaledDamage(Level(level)));
+
+				case DamageSource::AverageLevelDamge:
+					return Round(GetAverageLevelDamage(Level(level)));
+
+				case DamageSource::MonsterWeaponDamage:
+					return Round(GetLevelScaledMonsterWeaponDamage(Level(level)));
+
+				case DamageSource::SourceMaximumVitality:
+					return Stat(Attacker(attacker), CharacterStat::MaxVitality);
+
+				case DamageSource::SourceMaximumPhysicalArmor:
+					return Stat(Attacker(attacker), CharacterStat::MaxArmor);
+
+				case DamageSource::SourceMaximumMagicArmor:
+					return Stat(Attacker(attacker), CharacterStat::MaxMagicArmor);
+
+				case DamageSource::SourceCurrentVitality:
+					return Stat(Attacker(attacker), CharacterStat::CurrentVitality);
+
+				case DamageSource::SourceCurrentPhysicalArmor:
+					return Stat(Attacker(attacker), CharacterStat::CurrentArmor);
+
+				case DamageSource::SourceCurrentMagicArmor:
+					return Stat(Attacker(attacker), CharacterStat::CurrentMagicArmor);
+
+				case DamageSource::SourceShieldPhysicalArmor:
+					return Round(GetShieldPhysicalArmor(Attacker(attacker)));
+
+				default:
+					// Target* sources index the target argument, which is always 0
+					throw ScriptError{};
+				}
+			}
+
+			// Returns the character property that holds the combat ability, or nullopt for nil
+			std::optional<CharacterStat> GetWeaponAbility(Character const& character, Item const* weapon)
+			{
+				if (weapon == nullptr) {
+					return {};
+				}
+
+				auto offHandWeapon = character.GetOffHandWeapon();
+				if (offHandWeapon != nullptr && IsRangedWeapon(*weapon) && IsRangedWeapon(*offHandWeapon)) {
+					return CharacterStat::DualWielding;
+				}
+
+				auto weaponType = weapon->WeaponType;
+				if (weaponType == WeaponType::Bow || weaponType == WeaponType::Crossbow || weaponType == WeaponType::Rifle) {
+					return CharacterStat::Ranged;
+				}
+
+				if (weapon->IsTwoHanded) {
+					return CharacterStat::TwoHanded;
+				}
+
+				return CharacterStat::SingleHanded;
+			}
+
+			double ComputeWeaponCombatAbilityBoost(Character const& character, Item const& weapon)
+			{
+				auto abilityType = GetWeaponAbility(character, &weapon);
+				if (abilityType) {
+					return Stat(character, *abilityType) * extra_.CombatAbilityDamageBonus;
+				} else {
+					return 0;
+				}
+			}
+
+			std::optional<CharacterStat> GetWeaponScalingRequirement(Item const& weapon)
+			{
+				std::optional<CharacterStat> requirementName;
+				int64_t largestRequirement = -1;
+
+				for (auto const& requirement : weapon.Requirements) {
+					if (requirement.Not) continue;
+
+					// The Param of tag requirements is a string, which can't be compared with a number
+					if (requirement.Type == RequirementType::Tag) {
+						throw ScriptError{};
+					}
+
+					if (requirement.Param > largestRequirement) {
+						std::optional<CharacterStat> attribute;
+						switch (requirement.Type) {
+						case RequirementType::Strength: attribute = CharacterStat::Strength; break;
+						case RequirementType::Finesse: attribute = CharacterStat::Finesse; break;
+						case RequirementType::Constitution: attribute = CharacterStat::Constitution; break;
+						case RequirementType::Memory: attribute = CharacterStat::Memory; break;
+						case RequirementType::Wits: attribute = CharacterStat::Wits; break;
+						default: break;
+						}
+
+						if (attribute) {
+							requirementName = attribute;
+							largestRequirement = requirement.Param;
+						}
+					}
+				}
+
+				return requirementName;
+			}
+
+			double GetItemRequirementAttribute(Character const& character, Item const& weapon)
+			{
+				auto attribute = GetWeaponScalingRequirement(weapon);
+				if (attribute) {
+					return Stat(character, *attribute);
+				} else {
+					return 0;
+				}
+			}
+
+			double ComputeWeaponRequirementScaledDamage(Character const& character, Item const& weapon)
+			{
+				auto scalingReq = GetWeaponScalingRequirement(weapon);
+				if (scalingReq) {
+					return ScaledDamageFromPrimaryAttribute(Stat(character, *scalingReq)) * 100.0;
+				} else {
+					return 0;
+				}
+			}
+
+			void ComputeBaseWeaponDamage(Item const& weapon, DamageTypeRanges& damages, double& damageBoost)
+			{
+				// stats[1] is nil, or a non-weapon stat that has no DamageFromBase
+				if (weapon.DynamicStats.empty() || weapon.DynamicStats[0].StatsType != EquipmentStatsType::Weapon) {
+					throw ScriptError{};
+				}
+
+				auto const& baseStat = weapon.DynamicStats[0];
+				auto baseDmgFromBase = baseStat.DamageFromBase * 0.01;
+				double baseMinDamage = baseStat.MinDamage;
+				double baseMaxDamage = baseStat.MaxDamage;
+				damageBoost = 0;
+
+				for (size_t i = 0; i < weapon.DynamicStats.size(); i++) {
+					auto const& stat = weapon.DynamicStats[i];
+					if (stat.StatsType != EquipmentStatsType::Weapon || stat.DamageType == DamageType::None) continue;
+
+					auto dmgType = (uint32_t)stat.DamageType;
+					auto dmgFromBase = stat.DamageFromBase * 0.01;
+					double minDamage = stat.MinDamage;
+					double maxDamage = stat.MaxDamage;
+
+					if (dmgFromBase != 0) {
+						if (i == 0) {
+							if (baseMinDamage != 0) {
+								minDamage = LuaMax(dmgFromBase * baseMinDamage, 1);
+							}
+							if (baseMaxDamage != 0) {
+								maxDamage = LuaMax(dmgFromBase * baseMaxDamage, 1.0);
+							}
+						} else {
+							minDamage = LuaMax(baseDmgFromBase * dmgFromBase * baseMinDamage, 1.0);
+							maxDamage = LuaMax(baseDmgFromBase * dmgFromBase * baseMaxDamage, 1.0);
+						}
+					}
+
+					if (minDamage > 0) {
+						maxDamage = LuaMax(maxDamage, minDamage + 1.0);
+					}
+
+					damageBoost = damageBoost + stat.DamageBoost;
+
+					if (!damages.Present[dmgType]) {
+						damages.Present[dmgType] = true;
+						damages.Min[dmgType] = minDamage;
+						damages.Max[dmgType] = maxDamage;
+					} else {
+						damages.Min[dmgType] = damages.Min[dmgType] + minDamage;
+						damages.Max[dmgType] = damages.Max[dmgType] + maxDamage;
+					}
+				}
+			}
+
+			// Shared part of CalculateWeaponScaledDamage and CalculateWeaponDamageRange
+			void ComputeScaledWeaponDamageRanges(Character const& character, Item const& weapon, DamageTypeRanges& ranges)
+			{
+				double damageBoost;
+				ComputeBaseWeaponDamage(weapon, ranges, damageBoost);
+
+				auto abilityBoosts = Stat(character, CharacterStat::DamageBoost)
+					+ ComputeWeaponCombatAbilityBoost(character, weapon)
+					+ ComputeWeaponRequirementScaledDamage(character, weapon);
+				abilityBoosts = LuaMax(abilityBoosts + 100.0, 0.0) / 100.0;
+
+				auto boost = 1.0 + damageBoost * 0.01;
+				if (character.HasFlag(CharacterFlag::IsSneaking)) {
+					boost = boost + extra_.SneakDamageMultiplier;
+				}
+
+				for (uint32_t i = 0; i < NumDamageTypes; i++) {
+					if (ranges.Present[i]) {
+						ranges.Min[i] = LuaCeil(ranges.Min[i] * boost * abilityBoosts);
+						ranges.Max[i] = LuaCeil(ranges.Max[i] * boost * abilityBoosts);
+					}
+				}
+			}
+
+			void CalculateWeaponScaledDamage(Character const& character, Item const& weapon, DamageList& damageList, bool noRandomization)
+			{
+				DamageTypeRanges damages;
+				ComputeScaledWeaponDamageRanges(character, weapon, damages);
+
+				for (uint32_t i = 0; i < NumDamageTypes; i++) {
+					if (!damages.Present[i]) continue;
+
+					// Values that don't fit in an integer end up in damageList:Add() or Ext.Random() as floats
+					auto min = ToInteger(damages.Min[i]);
+					auto max = ToInteger(damages.Max[i]);
+
+					int64_t randRange = 1;
+					if (max - min >= 1) {
+						randRange = max - min;
+					}
+
+					int64_t finalAmount;
+					if (noRandomization) {
+						finalAmount = min + (int64_t)LuaFloor(randRange / 2.0);
+					} else {
+						finalAmount = min + env_->ExtRandom(0, randRange);
+					}
+
+					damageList.Add((DamageType)i, (int32_t)finalAmount);
+				}
+			}
+
+			DamageList CalculateWeaponDamage(Character const& attacker, Item const& weapon, bool noRandomization)
+			{
+				DamageList damageList;
+
+				CalculateWeaponScaledDamage(attacker, weapon, damageList, noRandomization);
+
+				auto offHand = attacker.GetOffHandWeapon();
+				ApplyDamageBoosts(attacker, damageList);
+
+				if (offHand != nullptr && weapon.InstanceId == offHand->InstanceId) {
+					damageList.Multiply(extra_.DualWieldingDamagePenalty);
+				}
+
+				return damageList;
+			}
+
+			void CalculateWeaponDamageRange(Character const& character, Item const& weapon, DamageTypeRanges& ranges)
+			{
+				ComputeScaledWeaponDamageRanges(character, weapon, ranges);
+
+				for (uint32_t i = 0; i < NumDamageTypes; i++) {
+					if (ranges.Present[i] && ranges.Min[i] > ranges.Max[i]) {
+						ranges.Max[i] = ranges.Min[i];
+					}
+				}
+			}
+
+			std::optional<SkillDamage> GetSkillDamage(Skill const& skill, Character const* attacker, bool stealthed,
+				double const (&attackerPos)[3], double const (&targetPos)[3], int32_t levelArg, bool noRandomization)
+			{
+				std::optional<int64_t> level = levelArg;
+				if (attacker != nullptr && levelArg < 0) {
+					// A nil level only fails in the formulas that use it
+					auto attackerLevel = attacker->GetStat(CharacterStat::Level);
+					level = attackerLevel ? std::optional<int64_t>(*attackerLevel) : std::nullopt;
+				}
+
+				auto damageMultiplier = skill.DamageMultiplier * 0.01;
+				auto damageMultipliers = GetDamageMultipliers(skill, stealthed, attackerPos, targetPos);
+				std::optional<DamageType> skillDamageType;
+
+				if (level == 0) {
+					// skill.OverrideSkillLevel is a string; it is not a usable level
+					level = {};
+				}
+
+				DamageList damageList;
+
+				if (damageMultiplier <= 0) {
+					return {};
+				}
+
+				if (skill.UseWeaponDamage) {
+					std::optional<DamageType> damageType = skill.DamageType;
+					if (damageType == DamageType::None || damageType == DamageType::Sentinel) {
+						damageType = {};
+					}
+
+					auto& character = Attacker(attacker);
+					auto weapon = character.GetMainWeapon();
+					auto offHand = character.GetOffHandWeapon();
+
+					if (weapon != nullptr) {
+						auto mainDmgs = CalculateWeaponDamage(character, *weapon, noRandomization);
+						mainDmgs.Multiply(damageMultipliers);
+						if (damageType) {
+							mainDmgs.ConvertDamageType(*damageType);
+						}
+						damageList.Merge(mainDmgs);
+					}
+
+					if (offHand != nullptr) {
+						if (weapon == nullptr) {
+							throw ScriptError{};
+						}
+
+						if (IsRangedWeapon(*weapon) == IsRangedWeapon(*offHand)) {
+							auto offHandDmgs = CalculateWeaponDamage(character, *offHand, noRandomization);
+							offHandDmgs.Multiply(damageMultipliers);
+							if (damageType) {
+								offHandDmgs.ConvertDamageType(*damageType);
+								skillDamageType = damageType;
+							}
+							damageList.Merge(offHandDmgs);
+						}
+					}
+
+					damageList.AggregateSameTypeDamages();
+				} else {
+					auto damageType = skill.DamageType;
+
+					auto baseDamage = CalculateBaseDamage(skill.Damage, attacker, level);
+					int64_t damageRange = skill.DamageRange;
+					double randomMultiplier;
+					if (noRandomization) {
+						randomMultiplier = 0.0;
+					} else {
+						// Ext.Random(0, max) rejects a negative max
+						if (damageRange < 0) {
+							throw ScriptError{};
+						}
+						randomMultiplier = 1.0 + (env_->ExtRandom(0, damageRange) - damageRange/2.0) * 0.01;
+					}
+
+					double attrDamageScale;
+					if (skill.Damage == DamageSource::BaseLevelDamage || skill.Damage == DamageSource::AverageLevelDamge) {
+						attrDamageScale = GetSkillAttributeDamageScale(skill, attacker);
+					} else {
+						attrDamageScale = 1.0;
+					}
+
+					double damageBoost;
+					if (attacker != nullptr) {
+						damageBoost = Stat(*attacker, CharacterStat::DamageBoost) / 100.0 + 1.0;
+					} else {
+						damageBoost = 1.0;
+					}
+
+					auto finalDamage = baseDamage * randomMultiplier * attrDamageScale * damageMultipliers;
+					finalDamage = LuaMax(Round(finalDamage), 1);
+					finalDamage = LuaCeil(finalDamage * damageBoost);
+					AddDamage(damageList, damageType, finalDamage);
+
+					if (attacker != nullptr) {
+						ApplyDamageBoosts(*attacker, damageList);
+					}
+				}
+
+				std::optional<DeathType> deathType = skill.DeathType;
+				if (skill.DeathType == DeathType::None) {
+					if (skill.UseWeaponDamage) {
+						deathType = GetDamageListDeathType(damageList);
+					} else {
+						if (!skillDamageType) {
+							skillDamageType = skill.DamageType;
+						}
+
+						deathType = DamageTypeToDeathType(*skillDamageType);
+					}
+				}
+
+				return SkillDamage{ std::move(damageList), deathType };
+			}
+
+			void ApplyDamageSkillAbilityBonuses(DamageList& damageList, Character const* attacker)
+			{
+				if (attacker == nullptr) {
+					return;
+				}
+
+				int64_t magicArmorDamage = 0;
+				int64_t armorDamage = 0;
+
+				for (auto const& damage : damageList.Damages) {
+					auto type = damage.Type;
+					if (type == DamageType::Magic || type == DamageType::Fire || type == DamageType::Air
+						|| type == DamageType::Water || type == DamageType::Earth) {
+						magicArmorDamage = magicArmorDamage + damage.Amount;
+					}
+
+					if (type == DamageType::Physical || type == DamageType::Corrosive || type == DamageType::Sulfuric) {
+						armorDamage = armorDamage + damage.Amount;
+					}
+				}
+
+				if (magicArmorDamage > 0) {
+					auto airSpecialist = Stat(*attacker, CharacterStat::AirSpecialist);
+					if (airSpecialist > 0) {
+						auto magicBonus = airSpecialist * extra_.SkillAbilityDamageToMagicArmorPerPoint;
+						if (magicBonus > 0) {
+							AddDamage(damageList, DamageType::Magic, LuaCeil((magicArmorDamage * magicBonus) / 100.0));
+						}
+					}
+				}
+
+				if (armorDamage > 0) {
+					auto armorBonus = Stat(*attacker, CharacterStat::WarriorLore) * extra_.SkillAbilityDamageToPhysicalArmorPerPoint;
+					if (armorBonus > 0) {
+						AddDamage(damageList, DamageType::Corrosive, LuaCeil((armorDamage * armorBonus) / 100.0));
+					}
+				}
+			}
+
+			int64_t GetResistance(Character const& character, DamageType type)
+			{
+				switch (type) {
+				case DamageType::None:
+				case DamageType::Chaos: return 0;
+				case DamageType::Physical: return Stat(character, CharacterStat::PhysicalResistance);
+				case DamageType::Piercing: return Stat(character, CharacterStat::PiercingResistance);
+				case DamageType::Corrosive: return Stat(character, CharacterStat::CorrosiveResistance);
+				case DamageType::Magic: return Stat(character, CharacterStat::MagicResistance);
+				case DamageType::Fire: return Stat(character, CharacterStat::FireResistance);
+				case DamageType::Air: return Stat(character, CharacterStat::AirResistance);
+				case DamageType::Water: return Stat(character, CharacterStat::WaterResistance);
+				case DamageType::Earth: return Stat(character, CharacterStat::EarthResistance);
+				case DamageType::Poison: return Stat(character, CharacterStat::PoisonResistance);
+				case DamageType::Shadow: return Stat(character, CharacterStat::ShadowResistance);
+				// SulfuricResistance and SentinelResistance are nil
+				default: throw ScriptError{};
+				}
+			}
+
+			void ApplyHitResistances(Character const& character, DamageList& damageList)
+			{
+				auto damages = damageList.Damages;
+				for (auto const& damage : damages) {
+					auto resistance = GetResistance(character, damage.Type);
+					AddDamage(damageList, damage.Type, LuaFloor((damage.Amount * -resistance) / 100.0));
+				}
+			}
+
+			void ApplyDamageCharacterBonuses(Character const& character, Character const* attacker, DamageList& damageList)
+			{
+				damageList.AggregateSameTypeDamages();
+				ApplyHitResistances(character, damageList);
+
+				ApplyDamageSkillAbilityBonuses(damageList, attacker);
+			}
+
+			double GetAbilityCriticalHitMultiplier(Character const& character, std::optional<CharacterStat> ability)
+			{
+				if (ability == CharacterStat::TwoHanded) {
+					return Round(Stat(character, CharacterStat::TwoHanded) * extra_.CombatAbilityCritMultiplierBonus);
+				}
+
+				if (ability == CharacterStat::RogueLore) {
+					return Round(Stat(character, CharacterStat::RogueLore) * extra_.SkillAbilityCritMultiplierPerPoint);
+				}
+
+				return 0;
+			}
+
+			double GetCriticalHitMultiplier(Item const& weapon, Character const* character)
+			{
+				double criticalMultiplier = 0;
+				if (weapon.ItemType == EquipmentStatsType::Weapon) {
+					for (auto const& stat : weapon.DynamicStats) {
+						// Only weapon stats have a CriticalDamage property
+						if (stat.StatsType != EquipmentStatsType::Weapon) {
+							throw ScriptError{};
+						}
+
+						criticalMultiplier = criticalMultiplier + stat.CriticalDamage;
+					}
+
+					if (character != nullptr) {
+						auto ability = GetWeaponAbility(*character, &weapon);
+						criticalMultiplier = criticalMultiplier + GetAbilityCriticalHitMultiplier(*character, ability)
+							+ GetAbilityCriticalHitMultiplier(*character, CharacterStat::RogueLore);
+
+						if (character->HasTalent(Talent::Human_Inventive)) {
+							criticalMultiplier = criticalMultiplier + extra_.TalentHumanCriticalMultiplier;
+						}
+					}
+				}
+
+				return criticalMultiplier * 0.01;
+			}
+
+			void ApplyCriticalHit(Hit& hit, Character const& attacker)
+			{
+				auto mainWeapon = attacker.GetMainWeapon();
+				if (mainWeapon != nullptr) {
+					hit.EffectFlags = hit.EffectFlags | HitFlag::CriticalHit;
+					hit.DamageMultiplier = hit.DamageMultiplier + (GetCriticalHitMultiplier(*mainWeapon, &attacker) - 1.0);
+				}
+			}
+
+			bool ShouldApplyCriticalHit(Hit const& hit, Character const& attacker, HitType hitType, CriticalRoll criticalRoll)
+			{
+				if (criticalRoll != CriticalRoll::Roll) {
+					return criticalRoll == CriticalRoll::Critical;
+				}
+
+				if (attacker.HasTalent(Talent::Haymaker)) {
+					return false;
+				}
+
+				if (hitType == HitType::DoT || hitType == HitType::Surface) {
+					return false;
+				}
+
+				// CriticalChance may be nil on backstabs and magic hits without Violent Magic
+				std::optional<double> critChance = attacker.GetStat(CharacterStat::CriticalChance);
+				if (attacker.HasTalent(Talent::ViolentMagic) && hitType == HitType::Magic) {
+					critChance = Stat(attacker, CharacterStat::CriticalChance) * extra_.TalentViolentMagicCriticalChancePercent * 0.01;
+					critChance = LuaMax(*critChance, 1);
+				} else {
+					if ((hit.EffectFlags & HitFlag::Backstab) != 0) {
+						return true;
+					}
+
+					if (hitType == HitType::Magic) {
+						return false;
+					}
+				}
+
+				// The roll happens before the comparison fails on a nil chance
+				auto roll = env_->MathRandom(0, 99);
+				if (!critChance) {
+					throw ScriptError{};
+				}
+
+				return roll < *critChance;
+			}
+
+			void ConditionalApplyCriticalHitMultiplier(Hit& hit, Character const& attacker, HitType hitType, CriticalRoll criticalRoll)
+			{
+				if (ShouldApplyCriticalHit(hit, attacker, hitType, criticalRoll)) {
+					ApplyCriticalHit(hit, attacker);
+				}
+			}
+
+			void ApplyLifeSteal(Hit& hit, Character const& target, Character const* attacker, HitType hitType)
+			{
+				if (attacker == nullptr || hitType == HitType::DoT || hitType == HitType::Surface) {
+					return;
+				}
+
+				int64_t magicDmg = hit.DamageList.GetByType(DamageType::Magic);
+				int64_t corrosiveDmg = hit.DamageList.GetByType(DamageType::Corrosive);
+				// Sums of 32-bit damage values, exact in a double
+				double lifesteal = (double)(hit.TotalDamageDone - hit.ArmorAbsorption - corrosiveDmg - magicDmg);
+
+				if ((hit.EffectFlags & (HitFlag::FromShacklesOfPain | HitFlag::NoDamageOnOwner | HitFlag::Reflection)) != 0) {
+					auto modifier = extra_.LifestealFromReflectionModifier;
+					lifesteal = LuaFloor(lifesteal * modifier);
+				}
+
+				auto currentVitality = Stat(target, CharacterStat::CurrentVitality);
+				if (lifesteal > currentVitality) {
+					lifesteal = (double)currentVitality;
+				}
+
+				if (lifesteal > 0) {
+					// lifesteal is an integer no larger than CurrentVitality here
+					hit.LifeSteal = ToInteger(LuaMax(LuaCeil(((int64_t)lifesteal * Stat(*attacker, CharacterStat::LifeSteal)) / 100.0), 0));
+				}
+			}
+
+			void ApplyDamagesToHitInfo(DamageList const& damageList, Hit& hit)
+			{
+				int64_t totalDamage = 0;
+				for (auto const& damage : damageList.Damages) {
+					totalDamage = totalDamage + damage.Amount;
+					if (damage.Type == DamageType::Chaos) {
+						hit.DamageList.Add(hit.DamageType, damage.Amount);
+					} else {
+						hit.DamageList.Add(damage.Type, damage.Amount);
+					}
+				}
+
+				hit.TotalDamageDone = hit.TotalDamageDone + totalDamage;
+			}
+
+			int64_t ComputeArmorDamage(DamageList const& damageList, int64_t armor)
+			{
+				int64_t damage = (int64_t)damageList.GetByType(DamageType::Corrosive) + damageList.GetByType(DamageType::Physical)
+					+ damageList.GetByType(DamageType::Sulfuric);
+				return (damage < armor) ? damage : armor;
+			}
+
+			int64_t ComputeMagicArmorDamage(DamageList const& damageList, int64_t magicArmor)
+			{
+				int64_t damage = (int64_t)damageList.GetByType(DamageType::Magic)
+					+ damageList.GetByType(DamageType::Fire)
+					+ damageList.GetByType(DamageType::Water)
+					+ damageList.GetByType(DamageType::Air)
+					+ damageList.GetByType(DamageType::Earth)
+					+ damageList.GetByType(DamageType::Poison);
+				return (damage < magicArmor) ? damage : magicArmor;
+			}
+
+			void DoHit(Hit& hit, DamageList& damageList, std::vector<DamageType> const& statusBonusDmgTypes, HitType hitType,
+				Character const& target, Character const* attacker)
+			{
+				hit.EffectFlags = hit.EffectFlags | HitFlag::Hit;
+				damageList.AggregateSameTypeDamages();
+				damageList.Multiply(hit.DamageMultiplier);
+
+				int64_t totalDamage = 0;
+				for (auto const& damage : damageList.Damages) {
+					totalDamage = totalDamage + damage.Amount;
+				}
+
+				if (totalDamage < 0) {
+					damageList.Clear();
+				}
+
+				ApplyDamageCharacterBonuses(target, attacker, damageList);
+				damageList.AggregateSameTypeDamages();
+				hit.DamageList = DamageList{};
+				hit.DamageListReplaced = true;
+
+				for (auto damageType : statusBonusDmgTypes) {
+					AddDamage(damageList, damageType, LuaCeil(totalDamage * 0.1));
+				}
+
+				ApplyDamagesToHitInfo(damageList, hit);
+				hit.ArmorAbsorption = hit.ArmorAbsorption + ComputeArmorDamage(damageList, Stat(target, CharacterStat::CurrentArmor));
+				hit.ArmorAbsorption = hit.ArmorAbsorption + ComputeMagicArmorDamage(damageList, Stat(target, CharacterStat::CurrentMagicArmor));
+
+				if (hit.TotalDamageDone > 0) {
+					ApplyLifeSteal(hit, target, attacker, hitType);
+				} else {
+					hit.EffectFlags = hit.EffectFlags | HitFlag::DontCreateBloodSurface;
+				}
+
+				if (hitType == HitType::Surface) {
+					hit.EffectFlags = hit.EffectFlags | HitFlag::Surface;
+				}
+
+				if (hitType == HitType::DoT) {
+					hit.EffectFlags = hit.EffectFlags | HitFlag::DoT;
+				}
+			}
+
+			double GetAttackerDamageMultiplier(Character const& attacker, HighGroundBonus highGround)
+			{
+				if (highGround == HighGroundBonus::HighGround) {
+					auto rangerLoreBonus = Stat(attacker, CharacterStat::RangerLore) * extra_.SkillAbilityHighGroundBonusPerPoint * 0.01;
+					return LuaMax(rangerLoreBonus + extra_.HighGroundBaseDamageBonus, 0.0);
+				} else if (highGround == HighGroundBonus::LowGround) {
+					return extra_.LowGroundBaseDamagePenalty;
+				} else {
+					return 0.0;
+				}
+			}
+
+			Number CalculateHitChance(Character const& attacker, Character const& target)
+			{
+				if (attacker.HasTalent(Talent::Haymaker)) {
+					return Number{ 100, true };
+				}
+
+				// IsRangedWeapon() is called with the weapon type string instead of the item,
+				// so "ranged" is always false; the main weapon still has to exist
+				if (attacker.GetMainWeapon() == nullptr) {
+					throw ScriptError{};
+				}
+
+				bool ranged = false;
+				double accuracy = Stat(attacker, CharacterStat::Accuracy);
+				double dodge = 0;
+				// A nil IsIncapacitatedRefCount compares unequal to 0 without raising an error
+				if ((!attacker.HasFlag(CharacterFlag::Invisible) || ranged) && target.GetStat(CharacterStat::IsIncapacitatedRefCount) == 0) {
+					dodge = Stat(target, CharacterStat::Dodge);
+				}
+
+				auto chanceToHit1 = Round(((100.0 - dodge) * accuracy) / 100);
+				// math.max(0, math.min(100, chanceToHit1)) returns the integer bounds when clamping
+				Number clamped{ chanceToHit1, false };
+				if (!(chanceToHit1 < 100)) {
+					clamped = Number{ 100, true };
+				}
+				if (!(0 < clamped.Value)) {
+					clamped = Number{ 0, true };
+				}
+
+				auto chanceToHitBoost = Stat(attacker, CharacterStat::ChanceToHitBoost);
+				if (clamped.Integer) {
+					return Number{ (double)((int64_t)clamped.Value + chanceToHitBoost), true };
+				} else {
+					return Number{ clamped.Value + chanceToHitBoost, false };
+				}
+			}
+
+			bool IsInFlankingPosition(Character const& target, Character const& attacker)
+			{
+				double tPos[3], aPos[3], rotation[9];
+				if (!target.GetPosition(tPos) || !attacker.GetPosition(aPos) || !target.GetRotation(rotation)) {
+					throw ScriptError{};
+				}
+
+				auto dx = tPos[0] - aPos[0], dy = tPos[1] - aPos[1], dz = tPos[2] - aPos[2];
+				auto distanceSq = 1.0 / sqrt(pow(dx, 2.0) + pow(dy, 2.0) + pow(dz, 2.0));
+				auto nx = dx * distanceSq, ny = dy * distanceSq, nz = dz * distanceSq;
+
+				auto ang = -rotation[5] * nx - rotation[6] * ny - rotation[7] * nz;
+				return ang > cos(0.52359879);
+			}
+
+			bool CanBackstab(Character const& target, Character const& attacker)
+			{
+				double targetPos[3], attackerPos[3], targetRot[9];
+				if (!target.GetPosition(targetPos) || !attacker.GetPosition(attackerPos) || !target.GetRotation(targetRot)) {
+					throw ScriptError{};
+				}
+
+				double atkDir[3];
+				for (int i = 0; i < 3; i++) {
+					atkDir[i] = attackerPos[i] - targetPos[i];
+				}
+
+				auto atkAngle = Deg(atan2(atkDir[2], atkDir[0]));
+				if (atkAngle < 0) {
+					atkAngle = 360 + atkAngle;
+				}
+
+				auto angle = Deg(atan2(-targetRot[0], targetRot[2]));
+				if (angle < 0) {
+					angle = 360 + angle;
+				}
+
+				auto relAngle = atkAngle - angle;
+				if (relAngle < 0) {
+					relAngle = 360 + relAngle;
+				}
+
+				return relAngle >= 150 && relAngle <= 210;
+			}
+
+			void ComputeCharacterHit(Character const& target, Character const* attacker, Item const* weapon, DamageList& damageList,
+				HitType hitType, bool noHitRoll, bool forceReduceDurability, Hit& hit, bool alwaysBackstab,
+				HighGroundBonus highGroundFlag, CriticalRoll criticalRoll)
+			{
+				hit.DamageMultiplier = 1.0;
+				std::vector<DamageType> statusBonusDmgTypes;
+
+				if (attacker == nullptr) {
+					DoHit(hit, damageList, statusBonusDmgTypes, hitType, target, attacker);
+					return;
+				}
+
+				// The Lua code calls GetAttackerDamageMultiplier(target, attacker, ...), so the
+				// high ground bonus is computed from the RangerLore of the target
+				hit.DamageMultiplier = 1.0 + GetAttackerDamageMultiplier(target, highGroundFlag);
+				if (hitType == HitType::Magic || hitType == HitType::Surface || hitType == HitType::DoT || hitType == HitType::Reflected) {
+					ConditionalApplyCriticalHitMultiplier(hit, *attacker, hitType, criticalRoll);
+					DoHit(hit, damageList, statusBonusDmgTypes, hitType, target, attacker);
+					return;
+				}
+
+				bool backstabbed = false;
+				if (alwaysBackstab || (weapon != nullptr && weapon->WeaponType == WeaponType::Knife && CanBackstab(target, *attacker))) {
+					hit.EffectFlags = hit.EffectFlags | HitFlag::Backstab;
+					backstabbed = true;
+				}
+
+				if (hitType == HitType::Melee) {
+					if (IsInFlankingPosition(target, *attacker)) {
+						hit.EffectFlags = hit.EffectFlags | HitFlag::Flanking;
+					}
+
+					// Apply Sadist talent
+					if (attacker->HasTalent(Talent::Sadist)) {
+						if ((hit.EffectFlags & HitFlag::Poisoned) != 0) {
+							statusBonusDmgTypes.push_back(DamageType::Poison);
+						}
+						if ((hit.EffectFlags & HitFlag::Burning) != 0) {
+							statusBonusDmgTypes.push_back(DamageType::Fire);
+						}
+						if ((hit.EffectFlags & HitFlag::Bleeding) != 0) {
+							statusBonusDmgTypes.push_back(DamageType::Physical);
+						}
+					}
+				}
+
+				if (attacker->HasTalent(Talent::Damage)) {
+					hit.DamageMultiplier = hit.DamageMultiplier + 0.1;
+				}
+
+				bool hitBlocked = false;
+
+				if (!noHitRoll) {
+					// Called as CalculateHitChance(target, attacker) by the Lua code
+					auto hitChance = CalculateHitChance(target, *attacker);
+					auto hitRoll = env_->MathRandom(0, 99);
+					if (hitRoll >= hitChance.Value) {
+						if (target.HasTalent(Talent::RangerLoreEvasionBonus) && hitRoll < hitChance.Value + 10) {
+							hit.EffectFlags = hit.EffectFlags | HitFlag::Dodged;
+						} else {
+							hit.EffectFlags = hit.EffectFlags | HitFlag::Missed;
+						}
+						hitBlocked = true;
+					} else {
+						// BlockChance may be nil; it is only compared if the hit isn't a backstab
+						if (!backstabbed) {
+							auto blockChance = Stat(target, CharacterStat::BlockChance);
+							if (blockChance > 0 && env_->MathRandom(0, 99) < blockChance) {
+								hit.EffectFlags = hit.EffectFlags | HitFlag::Blocked;
+								hitBlocked = true;
+							}
+						}
+					}
+				}
+
+				if (weapon != nullptr && !weapon->IsDefaultWeapon && hitType != HitType::Magic && forceReduceDurability
+					&& (hit.EffectFlags & (HitFlag::Missed | HitFlag::Dodged)) == 0) {
+					if (!env_->ConditionalDamageItemDurability(*attacker, *weapon)) {
+						throw ScriptError{};
+					}
+				}
+
+				if (!hitBlocked) {
+					ConditionalApplyCriticalHitMultiplier(hit, *attacker, hitType, criticalRoll);
+					DoHit(hit, damageList, statusBonusDmgTypes, hitType, target, attacker);
+				}
+			}
+
+		private:
+			Environment* env_;
+			ExtraData const& extra_;
+
+			static int64_t Stat(Character const& character, CharacterStat stat)
+			{
+				auto value = character.GetStat(stat);
+				if (!value) {
+					throw ScriptError{};
+				}
+
+				return *value;
+			}
+
+			// Indexing a nil attacker
+			static Character const& Attacker(Character const* attacker)
+			{
+				if (attacker == nullptr) {
+					throw ScriptError{};
+				}
+
+				return *attacker;
+			}
+
+			// Arithmetic on a string level
+			static int64_t Level(std::optional<int64_t> level)
+			{
+				if (!level) {
+					throw ScriptError{};
+				}
+
+				return *level;
+			}
+		};
+	}
+
+
+	bool GetSkillDamage(Environment& env, ExtraData const& extra, Skill const& skill, Character const* attacker,
+		bool /*isFromItem*/, bool stealthed, double const (&attackerPos)[3], double const (&targetPos)[3],
+		int32_t level, bool noRandomization, std::optional<SkillDamage>& result)
+	{
+		try {
+			Formulas formulas(&env, extra);
+			result = formulas.GetSkillDamage(skill, attacker, stealthed, attackerPos, targetPos, level, noRandomization);
+			return true;
+		} catch (ScriptError&) {
+			return false;
+		}
+	}
+
+	bool CalculateWeaponDamage(Environment& env, ExtraData const& extra, Character const& attacker, Item const& weapon,
+		bool noRandomization, DamageList& damageList)
+	{
+		try {
+			Formulas formulas(&env, extra);
+			damageList = formulas.CalculateWeaponDamage(attacker, weapon, noRandomization);
+			return true;
+		} catch (ScriptError&) {
+			return false;
+		}
+	}
+
+	bool GetSkillDamageRange(ExtraData const& extra, Character const& character, Skill const& skill,
+		std::vector<DamageRange>& ranges)
+	{
+		try {
+			Formulas formulas(nullptr, extra);
+			ranges.clear();
+			auto damageMultiplier = skill.DamageMultiplier * 0.01;
+
+			if (skill.UseWeaponDamage) {
+				auto mainWeapon = character.GetMainWeapon();
+				if (mainWeapon == nullptr) {
+					throw ScriptError{};
+				}
+
+				DamageTypeRanges mainDamageRange;
+				formulas.CalculateWeaponDamageRange(character, *mainWeapon, mainDamageRange);
+				auto offHandWeapon = character.GetOffHandWeapon();
+
+				if (offHandWeapon != nullptr && IsRangedWeapon(*mainWeapon) == IsRangedWeapon(*offHandWeapon)) {
+					DamageTypeRanges offHandDamageRange;
+					formulas.CalculateWeaponDamageRange(character, *offHandWeapon, offHandDamageRange);
+
+					auto dualWieldPenalty = extra.DualWieldingDamagePenalty;
+					for (uint32_t i = 0; i < NumDamageTypes; i++) {
+						if (!offHandDamageRange.Present[i]) continue;
+
+						auto min = offHandDamageRange.Min[i] * dualWieldPenalty;
+						auto max = offHandDamageRange.Max[i] * dualWieldPenalty;
+						if (mainDamageRange.Present[i]) {
+							mainDamageRange.Min[i] = mainDamageRange.Min[i] + min;
+							mainDamageRange.Max[i] = mainDamageRange.Max[i] + max;
+						} else {
+							mainDamageRange.Present[i] = true;
+							mainDamageRange.Min[i] = min;
+							mainDamageRange.Max[i] = max;
+						}
+					}
+				}
+
+				// The Lua code iterates these with pairs(); the results are integral floats,
+				// so the summation below doesn't depend on the iteration order
+				for (uint32_t i = 0; i < NumDamageTypes; i++) {
+					if (!mainDamageRange.Present[i]) continue;
+
+					auto min = Round(mainDamageRange.Min[i] * damageMultiplier);
+					auto max = Round(mainDamageRange.Max[i] * damageMultiplier);
+					mainDamageRange.Min[i] = min + LuaCeil(min * formulas.GetDamageBoostByType(character, (DamageType)i));
+					mainDamageRange.Max[i] = max + LuaCeil(max * formulas.GetDamageBoostByType(character, (DamageType)i));
+				}
+
+				auto damageType = skill.DamageType;
+				if (damageType != DamageType::None && damageType != DamageType::Sentinel) {
+					double min = 0, max = 0;
+					bool empty = true;
+					for (uint32_t i = 0; i < NumDamageTypes; i++) {
+						if (mainDamageRange.Present[i]) {
+							min = min + mainDamageRange.Min[i];
+							max = max + mainDamageRange.Max[i];
+							empty = false;
+						}
+					}
+
+					// The sums stay integers (0) if there are no ranges to add
+					ranges.push_back({ damageType, Number{ min, empty }, Number{ max, empty } });
+				} else {
+					for (uint32_t i = 0; i < NumDamageTypes; i++) {
+						if (mainDamageRange.Present[i]) {
+							ranges.push_back({ (DamageType)i, Number{ mainDamageRange.Min[i], false }, Number{ mainDamageRange.Max[i], false } });
+						}
+					}
+				}
+			} else {
+				auto damageType = skill.DamageType;
+				if (damageMultiplier <= 0) {
+					return true;
+				}
+
+				auto level = character.GetStat(CharacterStat::Level);
+				if (!level) {
+					throw ScriptError{};
+				}
+
+				int64_t skillLevel = *level;
+				if ((skillLevel < 0 || skill.OverrideSkillLevel) && skill.Level > 0) {
+					skillLevel = skill.Level;
+				}
+
+				double attrDamageScale;
+				if (skill.Damage == DamageSource::BaseLevelDamage || skill.Damage == DamageSource::AverageLevelDamge) {
+					attrDamageScale = formulas.GetSkillAttributeDamageScale(skill, &character);
+				} else {
+					attrDamageScale = 1.0;
+				}
+
+				auto baseDamage = formulas.CalculateBaseDamage(skill.Damage, &character, skillLevel) * attrDamageScale * damageMultiplier;
+				auto damageRange = skill.DamageRange * baseDamage * 0.005;
+
+				auto damageTypeBoost = 1.0 + formulas.GetDamageBoostByType(character, damageType);
+				auto characterDamageBoost = character.GetStat(CharacterStat::DamageBoost);
+				if (!characterDamageBoost) {
+					throw ScriptError{};
+				}
+
+				auto damageBoost = 1.0 + (*characterDamageBoost / 100.0);
+				auto min = LuaCeil(LuaCeil(Round(baseDamage - damageRange) * damageBoost) * damageTypeBoost);
+				auto max = LuaCeil(LuaCeil(Round(baseDamage + damageRange) * damageBoost) * damageTypeBoost);
+				ranges.push_back({ damageType, Number{ min, FitsInteger(min) }, Number{ max, FitsInteger(max) } });
+			}
+
+			return true;
+		} catch (ScriptError&) {
+			return false;
+		}
+	}
+
+	bool CalculateHitChance(ExtraData const& extra, Character const& attacker, Character const& target, Number& hitChance)
+	{
+		try {
+			Formulas formulas(nullptr, extra);
+			hitChance = formulas.CalculateHitChance(attacker, target);
+			return true;
+		} catch (ScriptError&) {
+			return false;
+		}
+	}
+
+	bool ComputeCharacterHit(Environment& env, ExtraData const& extra, Character const& target, Character const* attacker,
+		Item const* weapon, DamageList& damageList, HitType hitType, bool noHitRoll, bool forceReduceDurability,
+		Hit& hit, bool alwaysBackstab, HighGroundBonus highGround, CriticalRoll criticalRoll)
+	{
+		try {
+			Formulas formulas(&env, extra);
+			formulas.ComputeCharacterHit(target, attacker, weapon, damageList, hitType, noHitRoll, forceReduceDurability,
+				hit, alwaysBackstab, highGround, criticalRoll);
+			return true;
+		} catch (ScriptError&) {
+			return false;
+		}
+	}
+}
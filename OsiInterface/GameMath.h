@@ -0,0 +1,374 @@
+#pragma once
+
+// Native implementation of the damage and hit formulas of LuaScripts/Game.Math.lua
+// (GetSkillDamage, CalculateWeaponDamage, GetSkillDamageRange, CalculateHitChance and
+// ComputeCharacterHit, with the helpers they call).
+// This file must not depend on game definitions; it is also compiled by the
+// standalone differential test (Tools/GameMathTest) that checks it against the Lua code.
+//
+// Results are bit-for-bit identical to the Lua implementation: the formulas are evaluated
+// in doubles in the same order as the Lua expressions, random numbers are drawn from the
+// same sources in the same order, and the damage list follows DamagePairList semantics.
+// Where the Lua code would raise an error for the given inputs, the functions return false
+// and the caller is expected to run the Lua implementation instead.
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace dse::gamemath
+{
+	// The enumerations below use the values of the game enumerations of the same name
+
+	enum class DamageType : uint32_t
+	{
+		None = 0, Physical = 1, Piercing = 2, Corrosive = 3, Magic = 4, Chaos = 5, Fire = 6,
+		Air = 7, Water = 8, Earth = 9, Poison = 10, Shadow = 11, Sulfuric = 12, Sentinel = 13
+	};
+
+	constexpr uint32_t NumDamageTypes = 14;
+
+	enum class DeathType : uint8_t
+	{
+		None = 0, Physical = 1, Piercing = 2, Arrow = 3, DoT = 4, Incinerate = 5, Acid = 6,
+		Electrocution = 7, FrozenShatter = 8, PetrifiedShatter = 9, Explode = 10, Surrender = 11,
+		Hang = 12, KnockedDown = 13, Lifetime = 14, Sulfur = 15, Sentinel = 16
+	};
+
+	enum class HitType : uint32_t
+	{
+		Melee = 0, Magic = 1, Ranged = 2, WeaponDamage = 3, Surface = 4, DoT = 5, Reflected = 6
+	};
+
+	enum class CriticalRoll : int
+	{
+		Roll = 0, Critical = 1, NotCritical = 2
+	};
+
+	enum class HighGroundBonus : int
+	{
+		Unknown = 0, HighGround = 1, EvenGround = 2, LowGround = 3
+	};
+
+	enum class WeaponType : uint32_t
+	{
+		None = 0, Sword = 1, Club = 2, Axe = 3, Staff = 4, Bow = 5, Crossbow = 6, Spear = 7,
+		Knife = 8, Wand = 9, Arrow = 10, Rifle = 11, Sentinel = 12
+	};
+
+	enum class EquipmentStatsType : uint32_t
+	{
+		Weapon = 0, Armor = 1, Shield = 2
+	};
+
+	// Only the values the formulas look at; other requirement types pass through unchanged
+	enum class RequirementType : uint32_t
+	{
+		None = 0, Level = 1, Strength = 2, Finesse = 3, Intelligence = 4, Constitution = 5,
+		Memory = 6, Wits = 7, Tag = 172
+	};
+
+	// Talents checked by the formulas
+	enum class Talent : int
+	{
+		Damage = 10, Durability = 28, RangerLoreEvasionBonus = 76, Human_Inventive = 87,
+		ViolentMagic = 97, Sadist = 119, Haymaker = 120
+	};
+
+	// HitFlag values
+	namespace HitFlag
+	{
+		constexpr int64_t Hit = 1;
+		constexpr int64_t Blocked = 2;
+		constexpr int64_t Dodged = 4;
+		constexpr int64_t Missed = 8;
+		constexpr int64_t CriticalHit = 0x10;
+		constexpr int64_t Backstab = 0x20;
+		constexpr int64_t DontCreateBloodSurface = 0x80;
+		constexpr int64_t Reflection = 0x200;
+		constexpr int64_t NoDamageOnOwner = 0x400;
+		constexpr int64_t FromShacklesOfPain = 0x800;
+		constexpr int64_t Flanking = 0x8000;
+		constexpr int64_t Surface = 0x20000;
+		constexpr int64_t DoT = 0x40000;
+		constexpr int64_t Poisoned = 0x200000;
+		constexpr int64_t Burning = 0x400000;
+		constexpr int64_t Bleeding = 0x800000;
+	}
+
+	// "Damage" attribute of skills (DamageSourceType enumeration of the stats)
+	enum class DamageSource
+	{
+		BaseLevelDamage,
+		AverageLevelDamge,
+		MonsterWeaponDamage,
+		SourceMaximumVitality,
+		SourceMaximumPhysicalArmor,
+		SourceMaximumMagicArmor,
+		SourceCurrentVitality,
+		SourceCurrentPhysicalArmor,
+		SourceCurrentMagicArmor,
+		SourceShieldPhysicalArmor,
+		TargetMaximumVitality,
+		TargetMaximumPhysicalArmor,
+		TargetMaximumMagicArmor,
+		TargetCurrentVitality,
+		TargetCurrentPhysicalArmor,
+		TargetCurrentMagicArmor,
+		// Not present in Game.Math.DamageSourceCalcTable
+		Unknown
+	};
+
+	// "Ability" attribute of skills, as far as the formulas distinguish them
+	enum class SkillAbility
+	{
+		Warrior,
+		Polymorph,
+		Ranger,
+		Rogue,
+		Other
+	};
+
+	// Character stats read by the formulas (properties of the StatCharacter Lua object)
+	enum class CharacterStat
+	{
+		Level,
+		Strength,
+		Finesse,
+		Intelligence,
+		Constitution,
+		Memory,
+		Wits,
+		WarriorLore,
+		RangerLore,
+		RogueLore,
+		SingleHanded,
+		TwoHanded,
+		Ranged,
+		DualWielding,
+		FireSpecialist,
+		WaterSpecialist,
+		AirSpecialist,
+		EarthSpecialist,
+		PhysicalResistance,
+		PiercingResistance,
+		CorrosiveResistance,
+		MagicResistance,
+		FireResistance,
+		AirResistance,
+		WaterResistance,
+		EarthResistance,
+		PoisonResistance,
+		ShadowResistance,
+		DamageBoost,
+		CriticalChance,
+		Accuracy,
+		Dodge,
+		ChanceToHitBoost,
+		BlockChance,
+		LifeSteal,
+		MaxVitality,
+		MaxArmor,
+		MaxMagicArmor,
+		CurrentVitality,
+		CurrentArmor,
+		CurrentMagicArmor,
+		IsIncapacitatedRefCount
+	};
+
+	enum class CharacterFlag
+	{
+		IsSneaking,
+		Invisible,
+		InParty
+	};
+
+	struct ExtraData
+	{
+#define DEFN_EXTRA_DATA(name, key) double name;
+#include "GameMathExtraData.inl"
+#undef DEFN_EXTRA_DATA
+	};
+
+	// Lua number with its subtype, for results where the Lua code can observe the difference
+	struct Number
+	{
+		double Value;
+		bool Integer;
+	};
+
+	struct DamagePair
+	{
+		DamageType Type;
+		int32_t Amount;
+	};
+
+	// Same semantics as DamagePairList and the DamageList Lua object
+	class DamageList
+	{
+	public:
+		std::vector<DamagePair> Damages;
+
+		// Appends without merging (DamagePairList::SafeAdd)
+		inline void SafeAdd(DamageType type, int32_t amount)
+		{
+			Damages.push_back({ type, amount });
+		}
+
+		// DamagePairList::AddDamage
+		void Add(DamageType type, int32_t amount);
+		int32_t GetByType(DamageType type) const;
+		void Clear();
+		void Clear(DamageType type);
+		void Multiply(double multiplier);
+		void Merge(DamageList const& other);
+		void ConvertDamageType(DamageType type);
+		void AggregateSameTypeDamages();
+	};
+
+	// One entry of the DynamicStats of an item
+	struct ItemStats
+	{
+		EquipmentStatsType StatsType{ EquipmentStatsType::Weapon };
+		// Weapon stats
+		gamemath::DamageType DamageType{ gamemath::DamageType::None };
+		int32_t MinDamage{ 0 };
+		int32_t MaxDamage{ 0 };
+		int32_t DamageBoost{ 0 };
+		int32_t DamageFromBase{ 0 };
+		int32_t CriticalDamage{ 0 };
+		// Shield and armor stats
+		int32_t ArmorValue{ 0 };
+		int32_t ArmorBoost{ 0 };
+	};
+
+	struct Requirement
+	{
+		RequirementType Type{ RequirementType::None };
+		// Unused for tag requirements (the Lua value is the tag name)
+		int32_t Param{ 0 };
+		bool Not{ false };
+	};
+
+	struct Item
+	{
+		uint32_t InstanceId{ 0 };
+		EquipmentStatsType ItemType{ EquipmentStatsType::Weapon };
+		gamemath::WeaponType WeaponType{ gamemath::WeaponType::None };
+		bool IsTwoHanded{ false };
+		// Name == "DefaultWeapon"
+		bool IsDefaultWeapon{ false };
+		std::vector<ItemStats> DynamicStats;
+		std::vector<Requirement> Requirements;
+		// Caller-defined reference to the game object
+		void* Context{ nullptr };
+	};
+
+	// Character stats, read on demand (some of them are computed by the game when read)
+	class Character
+	{
+	public:
+		virtual ~Character() {}
+
+		// Returns nullopt if reading the stat from Lua would yield nil
+		virtual std::optional<int32_t> GetStat(CharacterStat stat) const = 0;
+		virtual bool HasTalent(Talent talent) const = 0;
+		virtual bool HasFlag(CharacterFlag flag) const = 0;
+		virtual Item const* GetMainWeapon() const = 0;
+		virtual Item const* GetOffHandWeapon() const = 0;
+		// GetItemBySlot("Shield", true)
+		virtual Item const* GetShield() const = 0;
+		// Returns false if the stats object has no character (Position/Rotation would be nil)
+		virtual bool GetPosition(double (&position)[3]) const = 0;
+		// 3x3 matrix in the order of the Lua table (column-major)
+		virtual bool GetRotation(double (&rotation)[9]) const = 0;
+	};
+
+	struct Skill
+	{
+		// "Damage Multiplier"
+		int32_t DamageMultiplier{ 0 };
+		// "Stealth Damage Multiplier"
+		int32_t StealthDamageMultiplier{ 0 };
+		// "Distance Damage Multiplier"
+		int32_t DistanceDamageMultiplier{ 0 };
+		// "Damage Range"
+		int32_t DamageRange{ 0 };
+		int32_t Level{ 0 };
+		bool UseWeaponDamage{ false };
+		bool OverrideSkillLevel{ false };
+		SkillAbility Ability{ SkillAbility::Other };
+		gamemath::DamageType DamageType{ gamemath::DamageType::None };
+		DamageSource Damage{ DamageSource::BaseLevelDamage };
+		gamemath::DeathType DeathType{ gamemath::DeathType::None };
+	};
+
+	// Fields of the hit table used by ComputeCharacterHit
+	struct Hit
+	{
+		int64_t EffectFlags{ 0 };
+		int64_t TotalDamageDone{ 0 };
+		int64_t ArmorAbsorption{ 0 };
+		int64_t LifeSteal{ 0 };
+		gamemath::DamageType DamageType{ gamemath::DamageType::None };
+		// Written by ComputeCharacterHit
+		double DamageMultiplier{ 1.0 };
+		// Replaced with a new list when the hit is applied (DamageListReplaced is set)
+		gamemath::DamageList DamageList;
+		bool DamageListReplaced{ false };
+	};
+
+	struct DamageRange
+	{
+		DamageType Type;
+		Number Min;
+		Number Max;
+	};
+
+	struct SkillDamage
+	{
+		DamageList Damage;
+		// nil if the skill has no death type and the damage list is empty
+		std::optional<DeathType> Death;
+	};
+
+	// Thrown where the Lua implementation would raise an error. Character and Environment
+	// implementations may also throw it for values they can't represent; the formula then returns false.
+	struct ScriptError {};
+
+	// Random sources and script callbacks used by the formulas
+	class Environment
+	{
+	public:
+		virtual ~Environment() {}
+
+		// Ext.Random(min, max)
+		virtual int64_t ExtRandom(int64_t min, int64_t max) = 0;
+		// math.random(min, max)
+		virtual int64_t MathRandom(int64_t min, int64_t max) = 0;
+		// Calls Game.Math.ConditionalDamageItemDurability(character, item), which modifies the item.
+		// Returns false if the call raised an error.
+		virtual bool ConditionalDamageItemDurability(Character const& character, Item const& item) = 0;
+	};
+
+	// Game.Math.GetSkillDamage; result is left empty if the Lua function returns nothing
+	bool GetSkillDamage(Environment& env, ExtraData const& extra, Skill const& skill, Character const* attacker,
+		bool isFromItem, bool stealthed, double const (&attackerPos)[3], double const (&targetPos)[3],
+		int32_t level, bool noRandomization, std::optional<SkillDamage>& result);
+
+	// Game.Math.CalculateWeaponDamage
+	bool CalculateWeaponDamage(Environment& env, ExtraData const& extra, Character const& attacker, Item const& weapon,
+		bool noRandomization, DamageList& damageList);
+
+	// Game.Math.GetSkillDamageRange
+	bool GetSkillDamageRange(ExtraData const& extra, Character const& character, Skill const& skill,
+		std::vector<DamageRange>& ranges);
+
+	// Game.Math.CalculateHitChance
+	bool CalculateHitChance(ExtraData const& extra, Character const& attacker, Character const& target, Number& hitChance);
+
+	// Game.Math.ComputeCharacterHit; updates damageList and hit like the Lua function
+	bool ComputeCharacterHit(Environment& env, ExtraData const& extra, Character const& target, Character const* attacker,
+		Item const* weapon, DamageList& damageList, HitType hitType, bool noHitRoll, bool forceReduceDurability,
+		Hit& hit, bool alwaysBackstab, HighGroundBonus highGround, CriticalRoll criticalRoll);
+}
@@ -0,0 +1,39 @@
+// Ext.ExtraData values read by the Game.Math formulas (GameMath.h)
+// DEFN_EXTRA_DATA(field name, ExtraData key)
+DEFN_EXTRA_DATA(AttributeBaseValue, "AttributeBaseValue")
+DEFN_EXTRA_DATA(DamageBoostFromAttribute, "DamageBoostFromAttribute")
+DEFN_EXTRA_DATA(VitalityStartingAmount, "VitalityStartingAmount")
+DEFN_EXTRA_DATA(VitalityExponentialGrowth, "VitalityExponentialGrowth")
+DEFN_EXTRA_DATA(VitalityLinearGrowth, "VitalityLinearGrowth")
+DEFN_EXTRA_DATA(VitalityToDamageRatio, "VitalityToDamageRatio")
+DEFN_EXTRA_DATA(VitalityToDamageRatioGrowth, "VitalityToDamageRatioGrowth")
+DEFN_EXTRA_DATA(FirstVitalityLeapLevel, "FirstVitalityLeapLevel")
+DEFN_EXTRA_DATA(FirstVitalityLeapGrowth, "FirstVitalityLeapGrowth")
+DEFN_EXTRA_DATA(SecondVitalityLeapLevel, "SecondVitalityLeapLevel")
+DEFN_EXTRA_DATA(SecondVitalityLeapGrowth, "SecondVitalityLeapGrowth")
+DEFN_EXTRA_DATA(ThirdVitalityLeapLevel, "ThirdVitalityLeapLevel")
+DEFN_EXTRA_DATA(ThirdVitalityLeapGrowth, "ThirdVitalityLeapGrowth")
+DEFN_EXTRA_DATA(FourthVitalityLeapLevel, "FourthVitalityLeapLevel")
+DEFN_EXTRA_DATA(FourthVitalityLeapGrowth, "FourthVitalityLeapGrowth")
+DEFN_EXTRA_DATA(ExpectedDamageBoostFromAttributePerLevel, "ExpectedDamageBoostFromAttributePerLevel")
+DEFN_EXTRA_DATA(ExpectedDamageBoostFromSkillAbilityPerLevel, "ExpectedDamageBoostFromSkillAbilityPerLevel")
+DEFN_EXTRA_DATA(ExpectedDamageBoostFromWeaponAbilityPerLevel, "ExpectedDamageBoostFromWeaponAbilityPerLevel")
+DEFN_EXTRA_DATA(MonsterDamageBoostPerLevel, "MonsterDamageBoostPerLevel")
+DEFN_EXTRA_DATA(SkillAbilityPhysicalDamageBoostPerPoint, "SkillAbilityPhysicalDamageBoostPerPoint")
+DEFN_EXTRA_DATA(SkillAbilityFireDamageBoostPerPoint, "SkillAbilityFireDamageBoostPerPoint")
+DEFN_EXTRA_DATA(SkillAbilityAirDamageBoostPerPoint, "SkillAbilityAirDamageBoostPerPoint")
+DEFN_EXTRA_DATA(SkillAbilityWaterDamageBoostPerPoint, "SkillAbilityWaterDamageBoostPerPoint")
+DEFN_EXTRA_DATA(SkillAbilityPoisonAndEarthDamageBoostPerPoint, "SkillAbilityPoisonAndEarthDamageBoostPerPoint")
+DEFN_EXTRA_DATA(SkillAbilityDamageToMagicArmorPerPoint, "SkillAbilityDamageToMagicArmorPerPoint")
+DEFN_EXTRA_DATA(SkillAbilityDamageToPhysicalArmorPerPoint, "SkillAbilityDamageToPhysicalArmorPerPoint")
+DEFN_EXTRA_DATA(SkillAbilityCritMultiplierPerPoint, "SkillAbilityCritMultiplierPerPoint")
+DEFN_EXTRA_DATA(SkillAbilityHighGroundBonusPerPoint, "SkillAbilityHighGroundBonusPerPoint")
+DEFN_EXTRA_DATA(CombatAbilityDamageBonus, "CombatAbilityDamageBonus")
+DEFN_EXTRA_DATA(CombatAbilityCritMultiplierBonus, "CombatAbilityCritMultiplierBonus")
+DEFN_EXTRA_DATA(SneakDamageMultiplier, "Sneak Damage Multiplier")
+DEFN_EXTRA_DATA(DualWieldingDamagePenalty, "DualWieldingDamagePenalty")
+DEFN_EXTRA_DATA(TalentHumanCriticalMultiplier, "TalentHumanCriticalMultiplier")
+DEFN_EXTRA_DATA(TalentViolentMagicCriticalChancePercent, "TalentViolentMagicCriticalChancePercent")
+DEFN_EXTRA_DATA(LifestealFromReflectionModifier, "LifestealFromReflectionModifier")
+DEFN_EXTRA_DATA(HighGroundBaseDamageBonus, "HighGroundBaseDamageBonus")
+DEFN_EXTRA_DATA(LowGroundBaseDamagePenalty, "LowGroundBaseDamagePenalty")
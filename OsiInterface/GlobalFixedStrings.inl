@@ -48,6 +48,7 @@ FS(MainWeapon);
 FS(OffHandWeapon);
 FS(NotSneaking);
 FS(Character);
+FS(Item);
 FS(Rotation);
 FS(Position);
 FS(MyGuid);
@@ -15,24 +15,67 @@ namespace dse::esv
 	extern FunctionHandle HitEventHandle;
 
 
+	PendingHit* PendingHitManager::CreateHit()
+	{
+		uint32_t id;
+		auto hit = hits_.Allocate(id);
+		if (hit == nullptr) {
+			OsiErrorS("Too many pending hits!");
+			return nullptr;
+		}
+
+		hit->Id = id;
+		return hit;
+	}
+
+	template <class TKey>
+	PendingHit* PendingHitManager::FindHit(HitMap<TKey>& map, TKey* key)
+	{
+		auto id = map.Find(key);
+		return id ? hits_.Get(*id) : nullptr;
+	}
+
+	template <class TKey>
+	void PendingHitManager::MapHit(HitMap<TKey>& map, TKey* key, PendingHit* hit)
+	{
+		// Keep existing mappings, unless they point to a hit that was already deleted
+		auto id = map.Find(key);
+		if (id == nullptr) {
+			map.Insert(key, hit->Id);
+		} else if (hits_.Get(*id) == nullptr) {
+			*id = hit->Id;
+		}
+	}
+
+	template <class TKey>
+	void PendingHitManager::UnmapHit(HitMap<TKey>& map, TKey* key, PendingHit* hit)
+	{
+		auto id = map.Find(key);
+		if (id != nullptr && (*id == hit->Id || hits_.Get(*id) == nullptr)) {
+			map.Erase(key);
+		}
+	}
+
 	PendingHit* PendingHitManager::OnCharacterHit(esv::Character* character, CDivinityStats_Character* attacker,
 		CDivinityStats_Item* weapon, DamagePairList* damageList, HitType hitType, bool noHitRoll,
 		HitDamageInfo* damageInfo, int forceReduceDurability, HighGroundBonus highGround,
 		bool procWindWalker, CriticalRoll criticalRoll)
 	{
-		auto it = characterHitMap_.find(damageInfo);
-		if (it != characterHitMap_.end()) {
-			if (it->second->CapturedStatusSetup || it->second->CapturedStatusEnter) {
-				WARN_HIT("PendingHitManager::OnCharacterHit(Hit=%p): Hit pointer reuse on %d", damageInfo, it->second->Id);
-				it->second->CharacterHitPointer = nullptr;
+		auto existing = FindHit(characterHitMap_, damageInfo);
+		if (existing != nullptr) {
+			if (existing->CapturedStatusSetup || existing->CapturedStatusEnter) {
+				WARN_HIT("PendingHitManager::OnCharacterHit(Hit=%p): Hit pointer reuse on %d", damageInfo, existing->Id);
+				existing->CharacterHitPointer = nullptr;
 			} else {
-				WARN_HIT("PendingHitManager::OnCharacterHit(Hit=%p): Found duplicate hit with ID %d, deleting", damageInfo, it->second->Id);
-				DeleteHit(it->second);
+				WARN_HIT("PendingHitManager::OnCharacterHit(Hit=%p): Found duplicate hit with ID %d, deleting", damageInfo, existing->Id);
+				DeleteHit(existing);
 			}
 		}
 
-		auto hit = std::make_unique<PendingHit>();
-		hit->Id = nextHitId_++;
+		auto hit = CreateHit();
+		if (hit == nullptr) {
+			return nullptr;
+		}
 
 		DEBUG_HIT("PendingHitManager::OnCharacterHit(Hit=%p): Constructing new hit %d", damageInfo, hit->Id);
 
@@ -48,8 +91,9 @@ namespace dse::esv
 		hit->CapturedCharacterHit = true;
 		hit->WeaponStats = weapon;
 		hit->CharacterHitPointer = damageInfo;
-		hit->CharacterHitDamageList.CopyFrom(*damageList);
-		hit->CharacterHit.CopyFrom(*damageInfo);
+		hit->CharacterHitDamageList.Assign(damageList->Buf, damageList->Size);
+		hit->CharacterHit.CopyWithoutDamageList(*damageInfo);
+		hit->CharacterHitDamage.Assign(damageInfo->DamageList.Buf, damageInfo->DamageList.Size);
 		hit->HitType = hitType;
 		hit->NoHitRoll = noHitRoll;
 		hit->ForceReduceDurability = forceReduceDurability;
@@ -57,39 +101,31 @@ namespace dse::esv
 		hit->ProcWindWalker = procWindWalker;
 		hit->CriticalRoll = criticalRoll;
 
-		auto pHit = hit.get();
-		hits_.insert(std::make_pair(hit->Id, std::move(hit)));
-		characterHitMap_.insert(std::make_pair(damageInfo, pHit));
-		return pHit;
+		MapHit(characterHitMap_, damageInfo, hit);
+		return hit;
 	}
 
 	PendingHit* PendingHitManager::OnStatusHitSetup(esv::StatusHit* status, HitDamageInfo* damageInfo)
 	{
-		PendingHit* pHit;
-		auto it = characterHitMap_.find(damageInfo);
-		if (it != characterHitMap_.end()) {
-			pHit = it->second;
+		auto pHit = FindHit(characterHitMap_, damageInfo);
+		if (pHit != nullptr) {
 			DEBUG_HIT("PendingHitManager::OnStatusHitSetup(S=%p, Hit=%p): Mapped to existing %d", status, damageInfo, pHit->Id);
 		} else {
-			auto hit = std::make_unique<PendingHit>();
-			hit->Id = nextHitId_++;
+			pHit = CreateHit();
+			if (pHit == nullptr) {
+				return nullptr;
+			}
 
-			pHit = hit.get();
-			hits_.insert(std::make_pair(hit->Id, std::move(hit)));
 			WARN_HIT("PendingHitManager::OnStatusHitSetup(S=%p, Hit=%p): Create new %d", status, damageInfo, pHit->Id);
 		}
 
 		pHit->CapturedStatusSetup = true;
 		pHit->Status = status;
-		hitStatusMap_.insert(std::make_pair(status, pHit));
+		MapHit(hitStatusMap_, status, pHit);
 
 		// We no longer need to keep character hit mappings
 		if (pHit->CapturedCharacterHit && pHit->CharacterHitPointer != nullptr) {
-			auto it = characterHitMap_.find(pHit->CharacterHitPointer);
-			if (it != characterHitMap_.end() && it->second == pHit) {
-				characterHitMap_.erase(it);
-			}
-
+			UnmapHit(characterHitMap_, pHit->CharacterHitPointer, pHit);
 			pHit->CharacterHitPointer = nullptr;
 		}
 
@@ -98,57 +134,53 @@ namespace dse::esv
 
 	PendingHit* PendingHitManager::OnApplyHit(esv::StatusMachine* self, esv::StatusHit* status)
 	{
-		PendingHit* pHit;
-		auto it = hitStatusMap_.find(status);
-		if (it != hitStatusMap_.end()) {
-			pHit = it->second;
+		auto pHit = FindHit(hitStatusMap_, status);
+		if (pHit != nullptr) {
 			DEBUG_HIT("PendingHitManager::OnApplyHit(S=%p): Mapped to existing %d", status, &status->DamageInfo, pHit->Id);
 		} else {
-			auto hit = std::make_unique<PendingHit>();
-			hit->Id = nextHitId_++;
+			pHit = CreateHit();
+			if (pHit == nullptr) {
+				return nullptr;
+			}
 
-			pHit = hit.get();
-			hits_.insert(std::make_pair(hit->Id, std::move(hit)));
 			WARN_HIT("PendingHitManager::OnStatusHitEnter(S=%p): Create new %d", status, &status->DamageInfo, pHit->Id);
 		}
 
 		pHit->CapturedStatusApply = true;
 		pHit->TargetHandle = self->OwnerObjectHandle;
 		pHit->Status = status;
-		hitStatusDamageMap_.insert(std::make_pair(&status->DamageInfo, pHit));
+		MapHit(hitStatusDamageMap_, &status->DamageInfo, pHit);
 
 		return pHit;
 	}
 
 	PendingHit* PendingHitManager::OnStatusHitEnter(esv::StatusHit* status)
 	{
-		PendingHit* pHit;
-		auto it = hitStatusMap_.find(status);
-		if (it != hitStatusMap_.end()) {
-			pHit = it->second;
+		auto pHit = FindHit(hitStatusMap_, status);
+		if (pHit != nullptr) {
 			DEBUG_HIT("PendingHitManager::OnStatusHitEnter(S=%p, Hit=%p): Mapped to existing %d", status, &status->DamageInfo, pHit->Id);
 		} else {
-			auto hit = std::make_unique<PendingHit>();
-			hit->Id = nextHitId_++;
+			pHit = CreateHit();
+			if (pHit == nullptr) {
+				return nullptr;
+			}
 
-			pHit = hit.get();
-			hits_.insert(std::make_pair(hit->Id, std::move(hit)));
 			WARN_HIT("PendingHitManager::OnStatusHitEnter(S=%p, Hit=%p): Create new %d", status, &status->DamageInfo, pHit->Id);
 		}
 
 		pHit->CapturedStatusEnter = true;
 		pHit->Status = status;
-		hitStatusDamageMap_.insert(std::make_pair(&status->DamageInfo, pHit));
+		MapHit(hitStatusDamageMap_, &status->DamageInfo, pHit);
 
 		return pHit;
 	}
 
 	void PendingHitManager::OnStatusHitDestroy(esv::StatusHit* status)
 	{
-		auto it = hitStatusMap_.find(status);
-		if (it != hitStatusMap_.end()) {
-			DEBUG_HIT("PendingHitManager::OnStatusHitEnter(S=%p): Deleting hit %d", status, it->second->Id);
-			DeleteHit(it->second);
+		auto hit = FindHit(hitStatusMap_, status);
+		if (hit != nullptr) {
+			DEBUG_HIT("PendingHitManager::OnStatusHitEnter(S=%p): Deleting hit %d", status, hit->Id);
+			DeleteHit(hit);
 		} else {
 			WARN_HIT("PendingHitManager::OnStatusHitEnter(S=%p): Hit not tracked!", status);
 		}
@@ -157,44 +189,32 @@ namespace dse::esv
 
 	PendingHit* PendingHitManager::OnCharacterApplyDamage(HitDamageInfo* hit)
 	{
-		auto it = hitStatusDamageMap_.find(hit);
-		if (it != hitStatusDamageMap_.end()) {
-			DEBUG_HIT("PendingHitManager::OnCharacterApplyDamage(Hit=%p): Mapped to existing %d", hit, it->second->Id);
-			return it->second;
+		auto pHit = FindHit(hitStatusDamageMap_, hit);
+		if (pHit != nullptr) {
+			DEBUG_HIT("PendingHitManager::OnCharacterApplyDamage(Hit=%p): Mapped to existing %d", hit, pHit->Id);
 		} else {
 			DEBUG_HIT("PendingHitManager::OnCharacterApplyDamage(Hit=%p): No context record found!", hit);
-			return nullptr;
 		}
+
+		return pHit;
 	}
 
 	void PendingHitManager::DeleteHit(PendingHit* hit)
 	{
-		if (hit->CapturedStatusEnter) {
-			auto it = hitStatusDamageMap_.find(&hit->Status->DamageInfo);
-			if (it != hitStatusDamageMap_.end()) {
-				hitStatusDamageMap_.erase(it);
-			}
+		if (hit->CapturedStatusEnter || hit->CapturedStatusApply) {
+			UnmapHit(hitStatusDamageMap_, &hit->Status->DamageInfo, hit);
 		}
 
 		if (hit->CapturedStatusSetup) {
-			auto it = hitStatusMap_.find(hit->Status);
-			if (it != hitStatusMap_.end()) {
-				hitStatusMap_.erase(it);
-			}
+			UnmapHit(hitStatusMap_, hit->Status, hit);
 		}
 
 		if (hit->CapturedCharacterHit && hit->CharacterHitPointer != nullptr) {
-			auto it = characterHitMap_.find(hit->CharacterHitPointer);
-			if (it != characterHitMap_.end() && it->second == hit) {
-				characterHitMap_.erase(it);
-			}
+			UnmapHit(characterHitMap_, hit->CharacterHitPointer, hit);
 		}
 
-		auto it = hits_.find(hit->Id);
-		if (it != hits_.end()) {
-			// Hit deleted here by unique_ptr dtor
-			hits_.erase(it);
-		}
+		// Resets the hit and bumps the generation of its slot, so stale IDs no longer resolve to it
+		hits_.Free(hit->Id);
 	}
 	
 
@@ -243,19 +263,24 @@ namespace dse::esv
 
 	void HitProxy::OnStatusHitSetup(esv::StatusHit* status, HitDamageInfo* hit)
 	{
-		gOsirisProxy->GetServerExtensionState().PendingHits.OnStatusHitSetup(status, hit);
+		HitTracePhaseScope trace(HitTracePhase::StatusHitSetup);
+		trace.SetHit(gOsirisProxy->GetServerExtensionState().PendingHits.OnStatusHitSetup(status, hit));
 	}
 
 
 	void HitProxy::OnStatusHitEnter(esv::StatusHit* status)
 	{
+		HitTracePhaseScope trace(HitTracePhase::StatusHitEnter);
 		auto context = gOsirisProxy->GetServerExtensionState().PendingHits.OnStatusHitEnter(status);
+		trace.SetHit(context);
 
 		LuaServerPin lua(ExtensionState::Get());
 		if (lua) {
+			HitTraceHandlerScope luaTrace(HitTracer::Handler::Lua);
 			lua->OnStatusHitEnter(status, context);
 		}
 
+		HitTraceHandlerScope osirisTrace(HitTracer::Handler::Osiris);
 		gOsirisProxy->GetFunctionLibrary().ThrowStatusHitEnter(status);
 	}
 
@@ -265,6 +290,7 @@ namespace dse::esv
 		HitDamageInfo* damageInfo, int forceReduceDurability, CRPGStats_Object_Property_List* skillProperties, HighGroundBonus highGround,
 		bool procWindWalker, CriticalRoll criticalRoll)
 	{
+		HitTracePhaseScope trace(HitTracePhase::CharacterHit);
 		auto helper = gOsirisProxy->GetServerExtensionState().DamageHelpers.Create();
 		helper->Type = DamageHelpers::HT_PrepareHitEvent;
 		helper->Target = self;
@@ -281,15 +307,19 @@ namespace dse::esv
 		helper->ForceReduceDurability = (bool)forceReduceDurability;
 		helper->SetExternalDamageInfo(damageInfo, damageList);
 
-		gOsirisProxy->GetFunctionLibrary().ThrowCharacterHit(self, attackerStats, itemStats, damageList, hitType, noHitRoll,
-			damageInfo, forceReduceDurability, skillProperties, highGround, procWindWalker, criticalRoll, *helper);
+		{
+			HitTraceHandlerScope osirisTrace(HitTracer::Handler::Osiris);
+			gOsirisProxy->GetFunctionLibrary().ThrowCharacterHit(self, attackerStats, itemStats, damageList, hitType, noHitRoll,
+				damageInfo, forceReduceDurability, skillProperties, highGround, procWindWalker, criticalRoll, *helper);
+		}
 
 		wrappedHit(self, attackerStats, itemStats, damageList, helper->HitType, helper->NoHitRoll,
 			damageInfo, helper->ForceReduceDurability, skillProperties, helper->HighGround,
 			helper->ProcWindWalker, helper->CriticalRoll);
 
-		gOsirisProxy->GetServerExtensionState().PendingHits.OnCharacterHit(self, attackerStats, itemStats,
+		auto pendingHit = gOsirisProxy->GetServerExtensionState().PendingHits.OnCharacterHit(self, attackerStats, itemStats,
 			damageList, hitType, noHitRoll, damageInfo, forceReduceDurability, highGround, procWindWalker, criticalRoll);
+		trace.SetHit(pendingHit);
 
 		gOsirisProxy->GetServerExtensionState().DamageHelpers.Destroy(helper->Handle);
 	}
@@ -299,8 +329,10 @@ namespace dse::esv
 		bool forceReduceDurability, HitDamageInfo* damageInfo, CRPGStats_Object_Property_List* skillProperties,
 		HighGroundBonus highGroundFlag, CriticalRoll criticalRoll)
 	{
+		HitTracePhaseScope trace(HitTracePhase::CharacterHitInternal);
 		LuaServerPin lua(ExtensionState::Get());
 		if (lua) {
+			HitTraceHandlerScope luaTrace(HitTracer::Handler::Lua);
 			if (lua->ComputeCharacterHit(self, attackerStats, item, damageList, hitType, noHitRoll, forceReduceDurability, damageInfo,
 				skillProperties, highGroundFlag, criticalRoll)) {
 				return;
@@ -315,12 +347,15 @@ namespace dse::esv
 	void HitProxy::OnCharacterApplyDamage(esv::Character::ApplyDamageProc next, esv::Character* self, HitDamageInfo& hit,
 		uint64_t attackerHandle, CauseType causeType, glm::vec3& impactDirection)
 	{
+		HitTracePhaseScope trace(HitTracePhase::CharacterApplyDamage);
 		auto context = gOsirisProxy->GetServerExtensionState().PendingHits.OnCharacterApplyDamage(&hit);
+		trace.SetHit(context);
 
 		HitDamageInfo luaHit = hit;
 
 		LuaServerPin lua(ExtensionState::Get());
 		if (lua) {
+			HitTraceHandlerScope luaTrace(HitTracer::Handler::Lua);
 			if (lua->OnCharacterApplyDamage(self, luaHit, ObjectHandle(attackerHandle), causeType, impactDirection, context)) {
 				return;
 			}
@@ -341,9 +376,13 @@ namespace dse::esv
 			return;
 		}
 
+		HitTracePhaseScope trace(HitTracePhase::ApplyStatus);
 		ExtensionState::Get().PendingStatuses.Add(status);
 
-		gOsirisProxy->GetFunctionLibrary().ThrowApplyStatus(self, status);
+		{
+			HitTraceHandlerScope osirisTrace(HitTracer::Handler::Osiris);
+			gOsirisProxy->GetFunctionLibrary().ThrowApplyStatus(self, status);
+		}
 
 		bool previousPreventApplyState = self->PreventStatusApply;
 		ObjectHandle targetHandle;
@@ -2,6 +2,8 @@
 
 #include "CustomFunctions.h"
 #include "ExtensionState.h"
+#include "HitContainers.h"
+#include "HitTracer.h"
 #include <GameDefinitions/EntitySystem.h>
 #include <GameDefinitions/Character.h>
 #include <GameDefinitions/Item.h>
@@ -26,8 +28,12 @@ namespace dse::esv
 		bool CapturedCharacterHit{ false };
 		CDivinityStats_Item* WeaponStats{ nullptr };
 		HitDamageInfo* CharacterHitPointer{ nullptr };
-		DamagePairList CharacterHitDamageList;
+		// Damage list passed to esv::Character::Hit
+		InlineArray<TDamagePair, 4> CharacterHitDamageList;
+		// Hit info without its damage list (which is stored in CharacterHitDamage instead),
+		// so pending hits don't allocate from the game heap
 		HitDamageInfo CharacterHit;
+		InlineArray<TDamagePair, 4> CharacterHitDamage;
 		HitType HitType{ HitType::Melee };
 		bool NoHitRoll{ false };
 		bool ProcWindWalker{ false };
@@ -42,6 +48,9 @@ namespace dse::esv
 
 		// Captured during esv::StatusHit::Enter
 		bool CapturedStatusEnter{ false };
+
+		// Start of the first traced phase of this hit (see HitTracer)
+		uint64_t TraceStartTime{ 0 };
 	};
 
 	class PendingHitManager
@@ -60,11 +69,22 @@ namespace dse::esv
 		void DeleteHit(PendingHit* hit);
 
 	private:
-		uint32_t nextHitId_{ 1 };
-		std::unordered_map<uint32_t, std::unique_ptr<PendingHit>> hits_;
-		std::unordered_map<HitDamageInfo*, PendingHit*> characterHitMap_;
-		std::unordered_map<StatusHit*, PendingHit*> hitStatusMap_;
-		std::unordered_map<HitDamageInfo*, PendingHit*> hitStatusDamageMap_;
+		template <class TKey>
+		using HitMap = PointerHashMap<TKey*, uint32_t>;
+
+		GenerationalPool<PendingHit> hits_;
+		// Maps store hit IDs; entries of hits that were deleted in the meantime are treated as missing
+		HitMap<HitDamageInfo> characterHitMap_;
+		HitMap<StatusHit> hitStatusMap_;
+		HitMap<HitDamageInfo> hitStatusDamageMap_;
+
+		PendingHit* CreateHit();
+		template <class TKey>
+		PendingHit* FindHit(HitMap<TKey>& map, TKey* key);
+		template <class TKey>
+		void MapHit(HitMap<TKey>& map, TKey* key, PendingHit* hit);
+		template <class TKey>
+		void UnmapHit(HitMap<TKey>& map, TKey* key, PendingHit* hit);
 	};
 
 	class HitProxy
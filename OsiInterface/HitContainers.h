@@ -0,0 +1,295 @@
+#pragma once
+
+// Allocation-free containers used by PendingHitManager.
+// This file must not depend on game definitions; it is also compiled by the
+// standalone benchmark (Tools/PendingHitBenchmark).
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace dse
+{
+	// Slab allocator with generation-tagged object IDs.
+	// Freed slots are reused in LIFO order; the generation of a slot is bumped on every free,
+	// so IDs of freed objects are never resolved to a new object that reuses the same slot
+	// (until the generation wraps around).
+	template <class T>
+	class GenerationalPool
+	{
+	public:
+		static constexpr uint32_t IndexBits = 20;
+		static constexpr uint32_t IndexMask = (1u << IndexBits) - 1;
+		static constexpr uint32_t GenerationMask = (1u << (32 - IndexBits)) - 1;
+		static constexpr uint32_t SlabSize = 64;
+		static constexpr uint32_t MaxObjects = IndexMask;
+
+		GenerationalPool() = default;
+		GenerationalPool(GenerationalPool const&) = delete;
+		GenerationalPool& operator =(GenerationalPool const&) = delete;
+
+		// Returns a value-initialized object, or nullptr if the pool is full
+		T* Allocate(uint32_t& id)
+		{
+			if (freeHead_ == InvalidIndex) {
+				if (numSlots_ >= MaxObjects) {
+					return nullptr;
+				}
+
+				slabs_.push_back(std::make_unique<Slot[]>(SlabSize));
+				for (uint32_t i = SlabSize; i > 0; i--) {
+					auto index = numSlots_ + i - 1;
+					GetSlot(index).NextFree = freeHead_;
+					freeHead_ = index;
+				}
+
+				numSlots_ += SlabSize;
+			}
+
+			auto index = freeHead_;
+			auto& slot = GetSlot(index);
+			freeHead_ = slot.NextFree;
+			slot.InUse = true;
+			numAllocated_++;
+
+			id = (slot.Generation << IndexBits) | index;
+			return &slot.Object;
+		}
+
+		// Resets the object and returns its slot to the free list
+		void Free(uint32_t id)
+		{
+			auto slot = FindSlot(id);
+			if (slot == nullptr) {
+				return;
+			}
+
+			slot->Object = T{};
+			slot->InUse = false;
+			// Generation 0 is skipped, so valid IDs are never 0
+			slot->Generation = (slot->Generation + 1) & GenerationMask;
+			if (slot->Generation == 0) {
+				slot->Generation = 1;
+			}
+
+			slot->NextFree = freeHead_;
+			freeHead_ = id & IndexMask;
+			numAllocated_--;
+		}
+
+		// Returns nullptr if the ID refers to an object that was freed
+		T* Get(uint32_t id)
+		{
+			auto slot = FindSlot(id);
+			return slot ? &slot->Object : nullptr;
+		}
+
+		inline uint32_t NumAllocated() const
+		{
+			return numAllocated_;
+		}
+
+		inline uint32_t NumSlots() const
+		{
+			return numSlots_;
+		}
+
+	private:
+		static constexpr uint32_t InvalidIndex = 0xffffffff;
+
+		struct Slot
+		{
+			T Object{};
+			uint32_t Generation{ 1 };
+			uint32_t NextFree{ InvalidIndex };
+			bool InUse{ false };
+		};
+
+		std::vector<std::unique_ptr<Slot[]>> slabs_;
+		uint32_t freeHead_{ InvalidIndex };
+		uint32_t numSlots_{ 0 };
+		uint32_t numAllocated_{ 0 };
+
+		inline Slot& GetSlot(uint32_t index)
+		{
+			return slabs_[index / SlabSize][index % SlabSize];
+		}
+
+		Slot* FindSlot(uint32_t id)
+		{
+			auto index = id & IndexMask;
+			if (index >= numSlots_) {
+				return nullptr;
+			}
+
+			auto& slot = GetSlot(index);
+			if (!slot.InUse || slot.Generation != (id >> IndexBits)) {
+				return nullptr;
+			}
+
+			return &slot;
+		}
+	};
+
+
+	// Open addressing hash map with pointer keys (linear probing, backward shift deletion).
+	// Null keys are not allowed.
+	template <class TKey, class TValue>
+	class PointerHashMap
+	{
+	public:
+		static_assert(std::is_pointer_v<TKey>, "PointerHashMap keys must be pointers");
+
+		TValue* Find(TKey key)
+		{
+			if (size_ == 0) {
+				return nullptr;
+			}
+
+			for (auto index = GetBucket(key); ; index = (index + 1) & mask_) {
+				auto& entry = entries_[index];
+				if (entry.Key == key) {
+					return &entry.Value;
+				} else if (entry.Key == nullptr) {
+					return nullptr;
+				}
+			}
+		}
+
+		// Doesn't overwrite the value if the key already exists (same as std::unordered_map::insert)
+		bool Insert(TKey key, TValue const& value)
+		{
+			if ((size_ + 1) * 2 > entries_.size()) {
+				Grow();
+			}
+
+			for (auto index = GetBucket(key); ; index = (index + 1) & mask_) {
+				auto& entry = entries_[index];
+				if (entry.Key == key) {
+					return false;
+				} else if (entry.Key == nullptr) {
+					entry.Key = key;
+					entry.Value = value;
+					size_++;
+					return true;
+				}
+			}
+		}
+
+		bool Erase(TKey key)
+		{
+			if (size_ == 0) {
+				return false;
+			}
+
+			auto index = GetBucket(key);
+			for (;; index = (index + 1) & mask_) {
+				if (entries_[index].Key == key) {
+					break;
+				} else if (entries_[index].Key == nullptr) {
+					return false;
+				}
+			}
+
+			// Move back entries that would become unreachable after removing this one
+			auto hole = index;
+			for (auto next = (hole + 1) & mask_; entries_[next].Key != nullptr; next = (next + 1) & mask_) {
+				auto bucket = GetBucket(entries_[next].Key);
+				// Entry can be moved if its home bucket is not in the (hole, next] range
+				if (((next - bucket) & mask_) >= ((next - hole) & mask_)) {
+					entries_[hole] = entries_[next];
+					hole = next;
+				}
+			}
+
+			entries_[hole] = Entry{};
+			size_--;
+			return true;
+		}
+
+		inline uint32_t Size() const
+		{
+			return size_;
+		}
+
+	private:
+		struct Entry
+		{
+			TKey Key{ nullptr };
+			TValue Value{};
+		};
+
+		std::vector<Entry> entries_;
+		uint32_t mask_{ 0 };
+		uint32_t shift_{ 64 };
+		uint32_t size_{ 0 };
+
+		inline uint32_t GetBucket(TKey key) const
+		{
+			// Fibonacci hashing of the pointer
+			return (uint32_t)(((uint64_t)(uintptr_t)key * 0x9E3779B97F4A7C15ull) >> shift_);
+		}
+
+		void Grow()
+		{
+			auto oldEntries = std::move(entries_);
+			uint32_t capacity = oldEntries.empty() ? 16 : (uint32_t)oldEntries.size() * 2;
+			entries_.clear();
+			entries_.resize(capacity);
+			mask_ = capacity - 1;
+			shift_ = 64;
+			for (auto size = capacity; size > 1; size >>= 1) {
+				shift_--;
+			}
+
+			size_ = 0;
+			for (auto const& entry : oldEntries) {
+				if (entry.Key != nullptr) {
+					Insert(entry.Key, entry.Value);
+				}
+			}
+		}
+	};
+
+
+	// Array that stores up to N elements inline and only allocates for larger sizes.
+	// The overflow buffer is kept when the array is reassigned.
+	template <class T, uint32_t N>
+	class InlineArray
+	{
+	public:
+		void Assign(T const* values, uint32_t size)
+		{
+			if (size <= N) {
+				std::copy(values, values + size, inline_);
+				overflow_.clear();
+			} else {
+				overflow_.assign(values, values + size);
+			}
+
+			size_ = size;
+		}
+
+		inline uint32_t Size() const
+		{
+			return size_;
+		}
+
+		inline T const* begin() const
+		{
+			return size_ <= N ? inline_ : overflow_.data();
+		}
+
+		inline T const* end() const
+		{
+			return begin() + size_;
+		}
+
+	private:
+		uint32_t size_{ 0 };
+		T inline_[N];
+		std::vector<T> overflow_;
+	};
+}
@@ -0,0 +1,232 @@
+#include <stdafx.h>
+#include <HitTracer.h>
+#include <Hit.h>
+#include <algorithm>
+
+namespace dse::esv
+{
+	HitTracer gHitTracer;
+
+	char const* HitTracePhaseToString(HitTracePhase phase)
+	{
+		switch (phase) {
+		case HitTracePhase::CharacterHit: return "CharacterHit";
+		case HitTracePhase::CharacterHitInternal: return "CharacterHitInternal";
+		case HitTracePhase::StatusHitSetup: return "StatusHitSetup";
+		case HitTracePhase::ApplyStatus: return "ApplyStatus";
+		case HitTracePhase::StatusHitEnter: return "StatusHitEnter";
+		case HitTracePhase::CharacterApplyDamage: return "CharacterApplyDamage";
+		default: return "(Unknown)";
+		}
+	}
+
+
+	void LatencyHistogram::Add(uint64_t ns)
+	{
+		if (Count == 0 || ns < Min) Min = ns;
+		if (ns > Max) Max = ns;
+		Count++;
+		Total += ns;
+
+		unsigned bucket = 0;
+		while (bucket + 1 < NumBuckets && (ns >> (bucket + 1)) != 0) {
+			bucket++;
+		}
+
+		Buckets[bucket]++;
+	}
+
+	uint64_t LatencyHistogram::Percentile(double p) const
+	{
+		if (Count == 0) {
+			return 0;
+		}
+
+		auto target = (uint64_t)(p * Count);
+		if (target < 1) target = 1;
+
+		uint64_t seen = 0;
+		for (unsigned i = 0; i < NumBuckets; i++) {
+			seen += Buckets[i];
+			if (seen >= target) {
+				return std::min(((uint64_t)2 << i) - 1, Max);
+			}
+		}
+
+		return Max;
+	}
+
+
+	void HitTracer::Start()
+	{
+		std::lock_guard lock(mutex_);
+		if (epoch_ == 0) {
+			epoch_ = Now();
+		}
+
+		events_.reserve(MaxEvents);
+		enabled_.store(true, std::memory_order_relaxed);
+		INFO("Hit tracing started");
+	}
+
+	void HitTracer::Stop()
+	{
+		enabled_.store(false, std::memory_order_relaxed);
+		INFO("Hit tracing stopped");
+	}
+
+	void HitTracer::Reset()
+	{
+		std::lock_guard lock(mutex_);
+		epoch_ = IsEnabled() ? Now() : 0;
+		stats_ = HitTraceStats{};
+		events_.clear();
+	}
+
+	bool HitTracer::EnterPhase(HitTracePhase phase)
+	{
+		if (depth_ >= MaxDepth) {
+			return false;
+		}
+
+		frames_[depth_++] = Frame{ phase, Now(), 0, 0 };
+		return true;
+	}
+
+	void HitTracer::LeavePhase(PendingHit* hit)
+	{
+		if (depth_ == 0) {
+			return;
+		}
+
+		auto const& frame = frames_[--depth_];
+		auto end = Now();
+		auto phase = (unsigned)frame.Phase;
+
+		// Handler time is inclusive of nested phases
+		if (depth_ > 0) {
+			frames_[depth_ - 1].LuaTime += frame.LuaTime;
+			frames_[depth_ - 1].OsirisTime += frame.OsirisTime;
+		}
+
+		if (hit != nullptr && hit->TraceStartTime == 0) {
+			hit->TraceStartTime = frame.Start;
+		}
+
+		std::lock_guard lock(mutex_);
+		stats_.PhaseTime[phase].Add(end - frame.Start);
+		if (frame.LuaTime > 0) stats_.LuaTime[phase].Add(frame.LuaTime);
+		if (frame.OsirisTime > 0) stats_.OsirisTime[phase].Add(frame.OsirisTime);
+
+		if (hit != nullptr && frame.Phase == HitTracePhase::CharacterApplyDamage) {
+			stats_.HitLatency.Add(end - hit->TraceStartTime);
+		}
+
+		Event evt;
+		evt.HitId = hit ? hit->Id : 0;
+		evt.Phase = frame.Phase;
+		evt.TargetHandle = hit ? (uint64_t)(int64_t)hit->TargetHandle : 0;
+		evt.Start = frame.Start > epoch_ ? frame.Start - epoch_ : 0;
+		evt.SinceHitStart = hit ? frame.Start - hit->TraceStartTime : 0;
+		evt.Duration = end - frame.Start;
+		evt.LuaTime = frame.LuaTime;
+		evt.OsirisTime = frame.OsirisTime;
+
+		if (events_.size() < MaxEvents) {
+			events_.push_back(evt);
+		} else {
+			events_[stats_.EventsRecorded % MaxEvents] = evt;
+			stats_.EventsDropped++;
+		}
+
+		stats_.EventsRecorded++;
+	}
+
+	void HitTracer::AddHandlerTime(Handler handler, uint64_t ns)
+	{
+		if (depth_ == 0) {
+			return;
+		}
+
+		auto& frame = frames_[depth_ - 1];
+		if (handler == Handler::Lua) {
+			frame.LuaTime += ns;
+		} else {
+			frame.OsirisTime += ns;
+		}
+	}
+
+	HitTraceStats HitTracer::GetStats() const
+	{
+		std::lock_guard lock(mutex_);
+		return stats_;
+	}
+
+	void HitTracer::Dump(std::string& out) const
+	{
+		std::lock_guard lock(mutex_);
+		char line[256];
+
+		auto writeHistogram = [&](char const* name, char const* kind, LatencyHistogram const& hist) {
+			if (hist.Count == 0) return;
+
+			sprintf_s(line, "%s\t%s\tcount=%llu\ttotal_us=%.1f\tmin_us=%.1f\tp50_us=%.1f\tp90_us=%.1f\tp99_us=%.1f\tmax_us=%.1f\n",
+				name, kind, hist.Count, hist.Total / 1000.0, hist.Min / 1000.0, hist.Percentile(0.5) / 1000.0,
+				hist.Percentile(0.9) / 1000.0, hist.Percentile(0.99) / 1000.0, hist.Max / 1000.0);
+			out += line;
+
+			for (unsigned i = 0; i < LatencyHistogram::NumBuckets; i++) {
+				if (hist.Buckets[i] > 0) {
+					sprintf_s(line, "\t<%llu ns\t%llu\n", (unsigned long long)2 << i, hist.Buckets[i]);
+					out += line;
+				}
+			}
+		};
+
+		out += "# Histograms\n";
+		for (unsigned i = 0; i < HitTraceStats::NumPhases; i++) {
+			auto name = HitTracePhaseToString((HitTracePhase)i);
+			writeHistogram(name, "Time", stats_.PhaseTime[i]);
+			writeHistogram(name, "Lua", stats_.LuaTime[i]);
+			writeHistogram(name, "Osiris", stats_.OsirisTime[i]);
+		}
+
+		writeHistogram("Hit", "Latency", stats_.HitLatency);
+
+		sprintf_s(line, "# Events (%llu recorded, %llu dropped)\n", stats_.EventsRecorded, stats_.EventsDropped);
+		out += line;
+		out += "HitId\tPhase\tTarget\tStartUs\tSinceHitStartUs\tDurationUs\tLuaUs\tOsirisUs\n";
+
+		// Oldest event first
+		auto first = events_.size() < MaxEvents ? 0 : stats_.EventsRecorded % MaxEvents;
+		for (std::size_t i = 0; i < events_.size(); i++) {
+			auto const& evt = events_[(first + i) % events_.size()];
+			sprintf_s(line, "%u\t%s\t%016llx\t%.1f\t%.1f\t%.1f\t%.1f\t%.1f\n",
+				evt.HitId, HitTracePhaseToString(evt.Phase), evt.TargetHandle, evt.Start / 1000.0,
+				evt.SinceHitStart / 1000.0, evt.Duration / 1000.0, evt.LuaTime / 1000.0, evt.OsirisTime / 1000.0);
+			out += line;
+		}
+	}
+
+	void HitTracer::LogSummary() const
+	{
+		auto stats = GetStats();
+
+		INFO("Hit trace by phase (us):        count      total        p50        p99        max      Lua   Osiris");
+		for (unsigned i = 0; i < HitTraceStats::NumPhases; i++) {
+			auto const& time = stats.PhaseTime[i];
+			if (time.Count == 0) continue;
+
+			INFO("    %-24s %10lld %10.0f %10.1f %10.1f %10.1f %8.0f %8.0f", HitTracePhaseToString((HitTracePhase)i),
+				(int64_t)time.Count, time.Total / 1000.0, time.Percentile(0.5) / 1000.0, time.Percentile(0.99) / 1000.0,
+				time.Max / 1000.0, stats.LuaTime[i].Total / 1000.0, stats.OsirisTime[i].Total / 1000.0);
+		}
+
+		auto const& latency = stats.HitLatency;
+		if (latency.Count > 0) {
+			INFO("    %-24s %10lld %10.0f %10.1f %10.1f %10.1f", "Hit latency",
+				(int64_t)latency.Count, latency.Total / 1000.0, latency.Percentile(0.5) / 1000.0,
+				latency.Percentile(0.99) / 1000.0, latency.Max / 1000.0);
+		}
+	}
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace dse::esv
+{
+	struct PendingHit;
+
+	// Hooks of the hit pipeline in HitProxy
+	enum class HitTracePhase : uint8_t
+	{
+		CharacterHit,
+		// Nested in CharacterHit; Lua ComputeCharacterHit listeners
+		CharacterHitInternal,
+		StatusHitSetup,
+		ApplyStatus,
+		StatusHitEnter,
+		CharacterApplyDamage,
+		Count
+	};
+
+	char const* HitTracePhaseToString(HitTracePhase phase);
+
+	// Log2 bucketed latency histogram (nanoseconds)
+	struct LatencyHistogram
+	{
+		static constexpr unsigned NumBuckets = 40;
+
+		uint64_t Count{ 0 };
+		uint64_t Total{ 0 };
+		uint64_t Min{ 0 };
+		uint64_t Max{ 0 };
+		// Bucket i counts samples in [2^i, 2^(i+1)) ns
+		uint64_t Buckets[NumBuckets]{ 0 };
+
+		void Add(uint64_t ns);
+		// Upper bound of the bucket containing the requested percentile (0..1)
+		uint64_t Percentile(double p) const;
+	};
+
+	struct HitTraceStats
+	{
+		static constexpr unsigned NumPhases = (unsigned)HitTracePhase::Count;
+
+		// Wall time of each hook (including nested phases and handlers)
+		LatencyHistogram PhaseTime[NumPhases];
+		// Time spent in Lua listeners and Osiris events during each hook (only hooks where they were called)
+		LatencyHistogram LuaTime[NumPhases];
+		LatencyHistogram OsirisTime[NumPhases];
+		// Time from the first traced phase of a hit until the end of its CharacterApplyDamage hook
+		LatencyHistogram HitLatency;
+		uint64_t EventsRecorded{ 0 };
+		uint64_t EventsDropped{ 0 };
+	};
+
+	// Per-hit and per-phase timing of the hit pipeline, to find which listeners make hit-heavy turns slow.
+	// Disabled by default; scopes only perform a relaxed atomic load when tracing is off.
+	// Phases are entered and left on the server thread; stats can be read from any thread.
+	class HitTracer
+	{
+	public:
+		static constexpr std::size_t MaxEvents = 16384;
+		static constexpr unsigned MaxDepth = 16;
+
+		enum class Handler
+		{
+			Lua,
+			Osiris
+		};
+
+		inline bool IsEnabled() const
+		{
+			return enabled_.load(std::memory_order_relaxed);
+		}
+
+		void Start();
+		void Stop();
+		void Reset();
+
+		bool EnterPhase(HitTracePhase phase);
+		void LeavePhase(PendingHit* hit);
+		void AddHandlerTime(Handler handler, uint64_t ns);
+
+		HitTraceStats GetStats() const;
+		// Writes per-phase histograms followed by the recorded phase events (tab separated)
+		void Dump(std::string& out) const;
+		void LogSummary() const;
+
+		static inline uint64_t Now()
+		{
+			return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+	private:
+		struct Frame
+		{
+			HitTracePhase Phase;
+			uint64_t Start;
+			uint64_t LuaTime;
+			uint64_t OsirisTime;
+		};
+
+		struct Event
+		{
+			uint32_t HitId;
+			HitTracePhase Phase;
+			uint64_t TargetHandle;
+			// Relative to the start of tracing
+			uint64_t Start;
+			// Relative to the first traced phase of the hit
+			uint64_t SinceHitStart;
+			uint64_t Duration;
+			uint64_t LuaTime;
+			uint64_t OsirisTime;
+		};
+
+		std::atomic<bool> enabled_{ false };
+		// Only accessed from the server thread
+		Frame frames_[MaxDepth];
+		unsigned depth_{ 0 };
+
+		mutable std::mutex mutex_;
+		uint64_t epoch_{ 0 };
+		HitTraceStats stats_;
+		// Ring buffer of the most recent events
+		std::vector<Event> events_;
+	};
+
+	extern HitTracer gHitTracer;
+
+
+	// Traces a hit pipeline hook
+	class HitTracePhaseScope
+	{
+	public:
+		inline HitTracePhaseScope(HitTracePhase phase)
+		{
+			if (gHitTracer.IsEnabled()) {
+				active_ = gHitTracer.EnterPhase(phase);
+			}
+		}
+
+		inline ~HitTracePhaseScope()
+		{
+			if (active_) {
+				gHitTracer.LeavePhase(hit_);
+			}
+		}
+
+		// Associates the phase with a pending hit (may be null)
+		inline void SetHit(PendingHit* hit)
+		{
+			hit_ = hit;
+		}
+
+		HitTracePhaseScope(HitTracePhaseScope const&) = delete;
+		HitTracePhaseScope& operator =(HitTracePhaseScope const&) = delete;
+
+	private:
+		bool active_{ false };
+		PendingHit* hit_{ nullptr };
+	};
+
+
+	// Charges the time spent in a Lua listener or Osiris event to the current hit phase
+	class HitTraceHandlerScope
+	{
+	public:
+		inline HitTraceHandlerScope(HitTracer::Handler handler)
+			: handler_(handler)
+		{
+			if (gHitTracer.IsEnabled()) {
+				start_ = HitTracer::Now();
+			}
+		}
+
+		inline ~HitTraceHandlerScope()
+		{
+			if (start_ != 0) {
+				gHitTracer.AddHandlerTime(handler_, HitTracer::Now() - start_);
+			}
+		}
+
+		HitTraceHandlerScope(HitTraceHandlerScope const&) = delete;
+		HitTraceHandlerScope& operator =(HitTraceHandlerScope const&) = delete;
+
+	private:
+		HitTracer::Handler handler_;
+		uint64_t start_{ 0 };
+	};
+}
@@ -0,0 +1,138 @@
+#include <stdafx.h>
+#include <LogQueue.h>
+#include <chrono>
+#include <cstring>
+#include <new>
+
+// Slot sequence numbers follow D. Vyukov's bounded MPMC queue: a slot is free for
+// the producer at position N when Sequence == N, and holds a record for the
+// consumer when Sequence == N + 1.
+LogQueue::LogQueue(std::size_t capacity)
+	: slots_(new Slot[capacity]), mask_(capacity - 1)
+{
+	for (std::size_t i = 0; i < capacity; i++) {
+		slots_[i].Sequence.store(i, std::memory_order_relaxed);
+	}
+
+	for (auto& window : rateWindows_) {
+		window.store(0, std::memory_order_relaxed);
+	}
+}
+
+LogQueue::~LogQueue()
+{
+	Record record;
+	while (Pop(record)) {
+		Release(record);
+	}
+}
+
+bool LogQueue::CheckRateLimit(DebugMessageType type)
+{
+	auto limit = rateLimit_;
+	if (limit == 0) return true;
+
+	auto window = (uint32_t)std::chrono::duration_cast<std::chrono::seconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+	auto& state = rateWindows_[(unsigned)type % NumCategories];
+	auto current = state.load(std::memory_order_relaxed);
+	for (;;) {
+		uint64_t next;
+		if ((uint32_t)(current >> 32) != window) {
+			next = ((uint64_t)window << 32) | 1;
+		} else if ((uint32_t)current >= limit) {
+			return false;
+		} else {
+			next = current + 1;
+		}
+
+		if (state.compare_exchange_weak(current, next, std::memory_order_relaxed)) {
+			return true;
+		}
+	}
+}
+
+bool LogQueue::Push(DebugMessageType type, char const* message, std::size_t length)
+{
+	if (!CheckRateLimit(type)) {
+		dropped_.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	Slot* slot;
+	auto pos = enqueuePos_.load(std::memory_order_relaxed);
+	for (;;) {
+		slot = &slots_[pos & mask_];
+		auto seq = slot->Sequence.load(std::memory_order_acquire);
+		auto diff = (intptr_t)seq - (intptr_t)pos;
+		if (diff == 0) {
+			if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+				break;
+			}
+		} else if (diff < 0) {
+			// Queue is full; the consumer hasn't released this slot yet
+			dropped_.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		} else {
+			pos = enqueuePos_.load(std::memory_order_relaxed);
+		}
+	}
+
+	slot->Data.Type = type;
+	slot->Data.Overflow = nullptr;
+	if (length > MaxInlineLength) {
+		slot->Data.Overflow = new (std::nothrow) char[length + 1];
+		if (slot->Data.Overflow != nullptr) {
+			memcpy(slot->Data.Overflow, message, length);
+			slot->Data.Overflow[length] = 0;
+		} else {
+			length = MaxInlineLength;
+		}
+	}
+
+	if (slot->Data.Overflow == nullptr) {
+		memcpy(slot->Data.Message, message, length);
+		slot->Data.Message[length] = 0;
+	}
+
+	slot->Data.Length = (uint32_t)length;
+	slot->Sequence.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+bool LogQueue::Pop(Record& record)
+{
+	auto pos = dequeuePos_.load(std::memory_order_relaxed);
+	auto& slot = slots_[pos & mask_];
+	auto seq = slot.Sequence.load(std::memory_order_acquire);
+	if ((intptr_t)seq - (intptr_t)(pos + 1) < 0) {
+		return false;
+	}
+
+	record.Type = slot.Data.Type;
+	record.Length = slot.Data.Length;
+	record.Overflow = slot.Data.Overflow;
+	if (record.Overflow == nullptr) {
+		memcpy(record.Message, slot.Data.Message, (std::size_t)slot.Data.Length + 1);
+	}
+
+	slot.Sequence.store(pos + mask_ + 1, std::memory_order_release);
+	dequeuePos_.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+void LogQueue::Release(Record& record)
+{
+	delete[] record.Overflow;
+	record.Overflow = nullptr;
+}
+
+bool LogQueue::IsEmpty() const
+{
+	return dequeuePos_.load(std::memory_order_acquire) == enqueuePos_.load(std::memory_order_acquire);
+}
+
+uint64_t LogQueue::TakeDroppedCount()
+{
+	return dropped_.exchange(0, std::memory_order_relaxed);
+}
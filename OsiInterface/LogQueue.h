@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+enum class DebugMessageType;
+
+// Bounded multi-producer single-consumer queue of preformatted log records.
+// Producers never block: if the queue is full or the rate limit of the message
+// category is exceeded, the message is dropped and counted instead.
+class LogQueue
+{
+public:
+	// Messages up to this length are stored inline in the queue; longer ones are copied to the heap
+	static constexpr std::size_t MaxInlineLength = 1023;
+	static constexpr unsigned NumCategories = 8;
+
+	struct Record
+	{
+		DebugMessageType Type;
+		uint32_t Length;
+		// Heap copy of messages longer than MaxInlineLength (owned by the record)
+		char* Overflow{ nullptr };
+		char Message[MaxInlineLength + 1];
+
+		inline char const* Text() const
+		{
+			return Overflow ? Overflow : Message;
+		}
+	};
+
+	// Capacity must be a power of two
+	LogQueue(std::size_t capacity);
+	~LogQueue();
+
+	LogQueue(LogQueue const&) = delete;
+	LogQueue& operator = (LogQueue const&) = delete;
+
+	// Maximum number of messages per second in each category; 0 disables rate limiting
+	inline void SetRateLimit(uint32_t messagesPerSecond)
+	{
+		rateLimit_ = messagesPerSecond;
+	}
+
+	// Can be called from any thread. Returns false if the message was dropped.
+	bool Push(DebugMessageType type, char const* message, std::size_t length);
+
+	// Must only be called from the consumer thread.
+	// The record must be released with Release() after the message was written.
+	bool Pop(Record& record);
+	static void Release(Record& record);
+
+	bool IsEmpty() const;
+
+	// Returns the number of messages dropped since the last call
+	uint64_t TakeDroppedCount();
+
+private:
+	struct Slot
+	{
+		std::atomic<std::size_t> Sequence;
+		Record Data;
+	};
+
+	std::unique_ptr<Slot[]> slots_;
+	std::size_t mask_;
+	uint32_t rateLimit_{ 0 };
+
+	alignas(64) std::atomic<std::size_t> enqueuePos_{ 0 };
+	alignas(64) std::atomic<std::size_t> dequeuePos_{ 0 };
+	alignas(64) std::atomic<uint64_t> dropped_{ 0 };
+	// Current rate limit window (upper 32 bits) and number of messages in the window (lower 32 bits)
+	alignas(64) std::atomic<uint64_t> rateWindows_[NumCategories];
+
+	bool CheckRateLimit(DebugMessageType type);
+};
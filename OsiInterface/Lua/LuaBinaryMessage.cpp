@@ -0,0 +1,414 @@
+#include <stdafx.h>
+#include <Lua/LuaBinaryMessage.h>
+#include <lauxlib.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+namespace dse::lua::binary
+{
+	namespace
+	{
+		// Same nesting limit as Ext.JsonStringify()
+		constexpr int MaxDepth = 64;
+
+		constexpr uint8_t FormatVersion = 1;
+
+		enum class Tag : uint8_t
+		{
+			Nil = 0,
+			False = 1,
+			True = 2,
+			// Zigzag encoded varint
+			Integer = 3,
+			Double = 4,
+			// Double that is exactly representable as a float (eg. positions)
+			Float = 5,
+			// New string; also appended to the string table
+			String = 6,
+			// Reference to a previously written string
+			StringRef = 7,
+			// Followed by the number of key/value pairs and the pairs
+			Table = 8,
+			// Table with keys 1..n; followed by n and the values
+			Array = 9
+		};
+
+		inline int AbsIndex(lua_State* L, int index)
+		{
+			return (index > 0 || index <= LUA_REGISTRYINDEX) ? index : lua_gettop(L) + index + 1;
+		}
+
+
+		class Writer
+		{
+		public:
+			Writer(lua_State* L, STDString& out)
+				: L_(L), out_(out)
+			{}
+
+			void Write(int index)
+			{
+				out_ += (char)FormatVersion;
+				WriteValue(index, 0, false);
+			}
+
+		private:
+			lua_State* L_;
+			STDString& out_;
+			// Lua strings stay alive while they're referenced from the value being serialized,
+			// so keys can point to the string data owned by Lua
+			std::unordered_map<std::string_view, uint32_t> strings_;
+
+			inline void WriteTag(Tag tag)
+			{
+				out_ += (char)tag;
+			}
+
+			void WriteVarint(uint64_t value)
+			{
+				char buf[10];
+				std::size_t len = 0;
+				while (value >= 0x80) {
+					buf[len++] = (char)(value | 0x80);
+					value >>= 7;
+				}
+
+				buf[len++] = (char)value;
+				out_.append(buf, len);
+			}
+
+			void WriteString(int index)
+			{
+				std::size_t len;
+				auto str = lua_tolstring(L_, index, &len);
+				std::string_view key(str, len);
+				auto it = strings_.find(key);
+				if (it != strings_.end()) {
+					WriteTag(Tag::StringRef);
+					WriteVarint(it->second);
+				} else {
+					strings_.insert(std::make_pair(key, (uint32_t)strings_.size()));
+					WriteTag(Tag::String);
+					WriteVarint(len);
+					out_.append(str, len);
+				}
+			}
+
+			void WriteNumber(int index)
+			{
+#if LUA_VERSION_NUM > 501
+				if (lua_isinteger(L_, index)) {
+					auto value = (int64_t)lua_tointeger(L_, index);
+					WriteTag(Tag::Integer);
+					WriteVarint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+					return;
+				}
+#endif
+
+				double value = lua_tonumber(L_, index);
+				auto floatValue = (float)value;
+				if ((double)floatValue == value || std::isnan(value)) {
+					WriteTag(Tag::Float);
+					out_.append(reinterpret_cast<char const*>(&floatValue), sizeof(floatValue));
+				} else {
+					WriteTag(Tag::Double);
+					out_.append(reinterpret_cast<char const*>(&value), sizeof(value));
+				}
+			}
+
+			void WriteValue(int index, int depth, bool isKey)
+			{
+				switch (lua_type(L_, index)) {
+				case LUA_TNIL:
+					WriteTag(Tag::Nil);
+					break;
+
+				case LUA_TBOOLEAN:
+					WriteTag(lua_toboolean(L_, index) ? Tag::True : Tag::False);
+					break;
+
+				case LUA_TNUMBER:
+					WriteNumber(index);
+					break;
+
+				case LUA_TSTRING:
+					WriteString(index);
+					break;
+
+				case LUA_TTABLE:
+					if (isKey) {
+						throw std::runtime_error("Can only serialize string, number or boolean table keys");
+					}
+
+					WriteTable(index, depth);
+					break;
+
+				default:
+					throw std::runtime_error(STDString("Cannot serialize values of type ") + lua_typename(L_, lua_type(L_, index)));
+				}
+			}
+
+			void WriteTable(int index, int depth)
+			{
+				if (depth > MaxDepth) {
+					throw std::runtime_error("Recursion depth exceeded while serializing message (recursive table?)");
+				}
+
+				if (!lua_checkstack(L_, 4)) {
+					throw std::runtime_error("Message nested too deep");
+				}
+
+				index = AbsIndex(L_, index);
+
+				// Tables whose keys are exactly 1..n are written without the keys
+				auto length = (uint64_t)lua_rawlen(L_, index);
+				uint64_t count{ 0 }, sequenceKeys{ 0 };
+				lua_pushnil(L_);
+				while (lua_next(L_, index) != 0) {
+					count++;
+#if LUA_VERSION_NUM > 501
+					if (lua_isinteger(L_, -2)) {
+						auto key = lua_tointeger(L_, -2);
+						if (key >= 1 && (uint64_t)key <= length) {
+							sequenceKeys++;
+						}
+					}
+#endif
+					lua_pop(L_, 1);
+				}
+
+				if (count > 0 && count == length && sequenceKeys == length) {
+					WriteTag(Tag::Array);
+					WriteVarint(length);
+					for (uint64_t i = 1; i <= length; i++) {
+						lua_rawgeti(L_, index, (lua_Integer)i);
+						WriteValue(-1, depth + 1, false);
+						lua_pop(L_, 1);
+					}
+				} else {
+					WriteTag(Tag::Table);
+					WriteVarint(count);
+					lua_pushnil(L_);
+					while (lua_next(L_, index) != 0) {
+						WriteValue(-2, depth + 1, true);
+						WriteValue(-1, depth + 1, false);
+						lua_pop(L_, 1);
+					}
+				}
+			}
+		};
+
+
+		class Reader
+		{
+		public:
+			Reader(lua_State* L, StringView message)
+				: L_(L), pos_(message.data()), end_(message.data() + message.size())
+			{}
+
+			void Read()
+			{
+				Need(1);
+				auto version = (uint8_t)*pos_++;
+				if (version != FormatVersion) {
+					throw std::runtime_error("Unsupported binary message version");
+				}
+
+				ReadValue(ReadTag(), 0); // stack: value
+				if (pos_ != end_) {
+					throw std::runtime_error("Unexpected data after the end of the message");
+				}
+			}
+
+		private:
+			lua_State* L_;
+			char const* pos_;
+			char const* end_;
+			// Strings point into the message, which outlives the reader
+			std::vector<std::string_view> strings_;
+
+			void Need(std::size_t size)
+			{
+				if ((std::size_t)(end_ - pos_) < size) {
+					throw std::runtime_error("Unexpected end of message");
+				}
+			}
+
+			Tag ReadTag()
+			{
+				Need(1);
+				return (Tag)*pos_++;
+			}
+
+			uint64_t ReadVarint()
+			{
+				uint64_t value = 0;
+				for (unsigned shift = 0; shift < 64; shift += 7) {
+					Need(1);
+					auto byte = (uint8_t)*pos_++;
+					value |= (uint64_t)(byte & 0x7f) << shift;
+					if ((byte & 0x80) == 0) {
+						return value;
+					}
+				}
+
+				throw std::runtime_error("Malformed integer in message");
+			}
+
+			template <class T>
+			T ReadRaw()
+			{
+				T value;
+				Need(sizeof(value));
+				memcpy(&value, pos_, sizeof(value));
+				pos_ += sizeof(value);
+				return value;
+			}
+
+			void ReadValue(Tag tag, int depth)
+			{
+				switch (tag) {
+				case Tag::Nil:
+					lua_pushnil(L_);
+					break;
+
+				case Tag::False:
+					lua_pushboolean(L_, 0);
+					break;
+
+				case Tag::True:
+					lua_pushboolean(L_, 1);
+					break;
+
+				case Tag::Integer:
+				{
+					auto value = ReadVarint();
+					lua_pushinteger(L_, (lua_Integer)((value >> 1) ^ (0 - (value & 1))));
+					break;
+				}
+
+				case Tag::Double:
+					lua_pushnumber(L_, ReadRaw<double>());
+					break;
+
+				case Tag::Float:
+					lua_pushnumber(L_, (double)ReadRaw<float>());
+					break;
+
+				case Tag::String:
+				{
+					auto len = ReadVarint();
+					Need(len);
+					lua_pushlstring(L_, pos_, (std::size_t)len);
+					strings_.push_back(std::string_view(pos_, (std::size_t)len));
+					pos_ += len;
+					break;
+				}
+
+				case Tag::StringRef:
+				{
+					auto index = ReadVarint();
+					if (index >= strings_.size()) {
+						throw std::runtime_error("Invalid string reference in message");
+					}
+
+					auto const& str = strings_[(std::size_t)index];
+					lua_pushlstring(L_, str.data(), str.size());
+					break;
+				}
+
+				case Tag::Table:
+					ReadTable(depth);
+					break;
+
+				case Tag::Array:
+					ReadArray(depth);
+					break;
+
+				default:
+					throw std::runtime_error("Unknown value type in message");
+				}
+			}
+
+			// Each element takes at least one byte; don't trust the size of malformed messages
+			int GetPreallocSize(uint64_t size, std::size_t minElementSize)
+			{
+				return (int)std::min<uint64_t>(size, (end_ - pos_) / minElementSize);
+			}
+
+			void CheckDepth(int depth)
+			{
+				if (depth > MaxDepth || !lua_checkstack(L_, 4)) {
+					throw std::runtime_error("Message nested too deep");
+				}
+			}
+
+			void ReadArray(int depth)
+			{
+				CheckDepth(depth);
+				auto size = ReadVarint();
+				lua_createtable(L_, GetPreallocSize(size, 1), 0); // stack: table
+				auto table = lua_gettop(L_);
+				for (uint64_t i = 1; i <= size; i++) {
+					ReadValue(ReadTag(), depth + 1); // stack: table, value
+					lua_rawseti(L_, table, (lua_Integer)i); // stack: table
+				}
+			}
+
+			void ReadTable(int depth)
+			{
+				CheckDepth(depth);
+				auto size = ReadVarint();
+				lua_createtable(L_, 0, GetPreallocSize(size, 2)); // stack: table
+				auto table = lua_gettop(L_);
+				for (uint64_t i = 0; i < size; i++) {
+					auto keyTag = ReadTag();
+					if (keyTag == Tag::Nil || keyTag == Tag::Table || keyTag == Tag::Array) {
+						throw std::runtime_error("Invalid table key in message");
+					}
+
+					ReadValue(keyTag, depth + 1); // stack: table, key
+					if (lua_type(L_, -1) == LUA_TNUMBER && std::isnan(lua_tonumber(L_, -1))) {
+						throw std::runtime_error("Invalid table key in message");
+					}
+
+					ReadValue(ReadTag(), depth + 1); // stack: table, key, value
+					lua_rawset(L_, table); // stack: table
+				}
+			}
+		};
+	}
+
+	void Serialize(lua_State* L, int index, STDString& out)
+	{
+		index = AbsIndex(L, index);
+		auto top = lua_gettop(L);
+		out.clear();
+
+		Writer writer(L, out);
+		try {
+			writer.Write(index);
+		} catch (std::runtime_error&) {
+			lua_settop(L, top);
+			throw;
+		}
+	}
+
+	bool Deserialize(lua_State* L, StringView message, STDString& error)
+	{
+		auto top = lua_gettop(L);
+		Reader reader(L, message);
+		try {
+			reader.Read(); // stack: value
+		} catch (std::runtime_error& e) {
+			error = e.what();
+			lua_settop(L, top);
+			return false;
+		}
+
+		return true;
+	}
+}
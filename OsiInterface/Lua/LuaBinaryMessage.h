@@ -0,0 +1,17 @@
+#pragma once
+
+#include <GameDefinitions/BaseTypes.h>
+#include <lua.h>
+
+namespace dse::lua::binary
+{
+	// Serializes the Lua value at the specified stack index to the compact binary
+	// network message format. Supports nil, booleans, numbers (integers and floats are
+	// kept apart), strings and nested tables with string, number or boolean keys.
+	// Throws std::runtime_error if the value cannot be serialized.
+	void Serialize(lua_State* L, int index, STDString& out);
+
+	// Decodes a binary network message directly onto the Lua stack (pushes one value).
+	// Returns false and pushes nothing if the message is malformed.
+	bool Deserialize(lua_State* L, StringView message, STDString& error);
+}
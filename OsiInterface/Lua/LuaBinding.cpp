@@ -2,6 +2,7 @@
 #include <OsirisProxy.h>
 #include <PropertyMaps.h>
 #include "LuaBinding.h"
+#include <Lua/LuaBinaryMessage.h>
 #include "resource.h"
 #include <fstream>
 
@@ -692,6 +693,7 @@ namespace dse::lua
 	void ExtensionLibrary::Register(lua_State * L)
 	{
 		RegisterLib(L);
+		RegisterGameMathLib(L);
 		ObjectProxy<CDivinityStats_Character>::RegisterMetatable(L);
 		ObjectProxy<CharacterDynamicStat>::RegisterMetatable(L);
 		ObjectProxy<CDivinityStats_Item>::RegisterMetatable(L);
@@ -792,6 +794,7 @@ namespace dse::lua
 		luaJIT_setmode(L, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_ON);
 #endif
 		lua_atpanic(L, &LuaPanic);
+		profiler_.Attach(L);
 		OpenLibs();
 	}
 
@@ -800,6 +803,7 @@ namespace dse::lua
 	State::~State()
 	{
 		RestoreLevelMaps(OverriddenLevelMaps);
+		profiler_.Detach();
 		lua_close(L);
 	}
 
@@ -846,7 +850,7 @@ namespace dse::lua
 		int top = lua_gettop(L);
 
 		/* Load the file containing the script we are going to run */
-		int status = luaL_loadbufferx(L, script.c_str(), script.size(), name.c_str(), "text");
+		int status = bytecodeCache_.Load(L, script, name);
 		if (status != LUA_OK) {
 			OsiError("Failed to parse script: " << lua_tostring(L, -1));
 			lua_pop(L, 1);  /* pop error message from the stack */
@@ -871,9 +875,39 @@ namespace dse::lua
 		return lua_gettop(L) - top;
 	}
 
+	bool State::HasListeners(char const* eventName)
+	{
+		lua_getglobal(L, "Ext"); // stack: Ext
+		lua_getfield(L, -1, "_Listeners"); // stack: Ext, listeners
+		if (lua_type(L, -1) != LUA_TTABLE) {
+			lua_pop(L, 2);
+			// Can't tell; let the Lua side handle the event
+			return true;
+		}
+
+		lua_getfield(L, -1, eventName); // stack: Ext, listeners, eventListeners
+		if (lua_type(L, -1) != LUA_TTABLE) {
+			lua_pop(L, 3);
+			return true;
+		}
+
+		lua_pushnil(L); // stack: Ext, listeners, eventListeners, nil
+		if (lua_next(L, -2) != 0) {
+			lua_pop(L, 5);
+			return true;
+		} else {
+			lua_pop(L, 3);
+			return false;
+		}
+	}
+
 	std::optional<int32_t> State::GetHitChance(CDivinityStats_Character * attacker, CDivinityStats_Character * target)
 	{
 		std::lock_guard lock(mutex_);
+		if (!HasListeners("GetHitChance")) {
+			return {};
+		}
+
 		Restriction restriction(*this, RestrictAll);
 
 		PushExtFunction(L, "_GetHitChance"); // stack: fn
@@ -894,6 +928,10 @@ namespace dse::lua
 		float * targetPosition, DeathType * pDeathType, int level, bool noRandomization)
 	{
 		std::lock_guard lock(mutex_);
+		if (!HasListeners("GetSkillDamage")) {
+			return false;
+		}
+
 		Restriction restriction(*this, RestrictAll);
 
 		PushExtFunction(L, "_GetSkillDamage"); // stack: fn
@@ -946,6 +984,22 @@ namespace dse::lua
 		CallExt("_NetMessageReceived", 0, ReturnType<>{}, channel, payload, userId.Id);
 	}
 
+	void State::OnBinaryNetMessageReceived(STDString const& channel, StringView message, UserId userId)
+	{
+		std::lock_guard lock(mutex_);
+		PushExtFunction(L, "_NetMessageReceived"); // stack: fn
+		push(L, channel);
+		STDString error;
+		if (!binary::Deserialize(L, message, error)) { // stack: fn, channel, payload
+			lua_pop(L, 2);
+			OsiError("Failed to decode binary message on channel '" << channel << "': " << error);
+			return;
+		}
+
+		push(L, userId.Id);
+		CheckedCall<>(L, 3, "_NetMessageReceived");
+	}
+
 	void State::OnGameSessionLoading()
 	{
 		CallExt("_OnGameSessionLoading", RestrictAll | ScopeSessionLoad, ReturnType<>{});
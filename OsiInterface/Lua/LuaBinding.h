@@ -4,6 +4,7 @@
 #include <GameDefinitions/Item.h>
 #include <GameDefinitions/Status.h>
 #include <Lua/LuaHelpers.h>
+#include <Lua/LuaBytecodeCache.h>
 
 #include <mutex>
 #include <unordered_set>
@@ -202,6 +203,16 @@ namespace dse::lua
 			return mutex_;
 		}
 
+		inline Profiler & GetProfiler()
+		{
+			return profiler_;
+		}
+
+		inline BytecodeCache & GetBytecodeCache()
+		{
+			return bytecodeCache_;
+		}
+
 		void FinishStartup();
 		void LoadBootstrap(STDString const& path, STDString const& modTable);
 		virtual void OnGameSessionLoading();
@@ -223,16 +234,26 @@ namespace dse::lua
 
 		std::optional<int> LoadScript(STDString const & script, STDString const & name = "", int globalsIdx = 0);
 
+		// Returns whether a Lua listener is registered for the specified engine event.
+		// Engine hooks use this to skip marshaling their arguments to Lua and call the game's
+		// native implementation directly when no mod overrides the event.
+		// Must be called with the state mutex held.
+		bool HasListeners(char const* eventName);
+
 		std::optional<int32_t> GetHitChance(CDivinityStats_Character * attacker, CDivinityStats_Character * target);
 		bool GetSkillDamage(SkillPrototype * self, DamagePairList * damageList,
 			CRPGStats_ObjectInstance *attackerStats, bool isFromItem, bool stealthed, float * attackerPosition,
 			float * targetPosition, DeathType * pDeathType, int level, bool noRandomization);
 		void OnNetMessageReceived(STDString const & channel, STDString const & payload, UserId userId);
+		// Decodes a binary message payload directly onto the stack and passes the value to the listeners
+		void OnBinaryNetMessageReceived(STDString const& channel, StringView message, UserId userId);
 
 	protected:
 		lua_State * L;
 		std::recursive_mutex mutex_;
 		bool startupDone_{ false };
+		Profiler profiler_;
+		BytecodeCache bytecodeCache_;
 
 		void OpenLibs();
 
@@ -282,6 +303,8 @@ namespace dse::lua
 	int GetTreasureTable(lua_State* L);
 	int GetTreasureCategory(lua_State* L);
 	int StatGetAttribute(lua_State* L);
+	int RunStatJob(lua_State* L);
+	int GetStatJobResult(lua_State* L);
 	int StatSetAttribute(lua_State* L);
 	int StatAddCustomDescription(lua_State* L);
 	int StatSetLevelScaling(lua_State* L);
@@ -302,4 +325,7 @@ namespace dse::lua
 	int GetTranslatedString(lua_State* L);
 	int GetTranslatedStringFromKey(lua_State* L);
 	int GenerateIdeHelpers(lua_State* L);
+
+	// Registers Ext._GameMath, the native Game.Math formulas (LuaGameMath.cpp)
+	void RegisterGameMathLib(lua_State* L);
 }
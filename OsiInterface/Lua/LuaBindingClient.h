@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Lua/LuaBinding.h>
+#include <Lua/LuaDescriptionParamCache.h>
 
 namespace dse
 {
@@ -97,8 +98,19 @@ namespace dse::ecl::lua
 		void OnCustomClientUIObjectCreated(char const * name, ObjectHandle handle);
 		UIObject * GetUIObject(char const * name);
 
+		inline DescriptionParamCache& GetDescriptionParamCache()
+		{
+			return descriptionParamCache_;
+		}
+
 	private:
 		ExtensionLibraryClient library_;
 		std::unordered_map<STDString, ObjectHandle> clientUI_;
+		DescriptionParamCache descriptionParamCache_;
+
+		std::optional<STDWString> CallSkillGetDescriptionParam(CRPGStats_Object* skill,
+			CDivinityStats_Character* character, ObjectSet<STDString> const& paramTexts, bool isFromItem);
+		std::optional<STDWString> CallStatusGetDescriptionParam(CRPGStats_Object* status, CRPGStats_ObjectInstance* owner,
+			CRPGStats_ObjectInstance* statusSource, ObjectSet<STDString> const& paramTexts);
 	};
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Lua/LuaBinding.h>
+#include <Lua/LuaPersistentVars.h>
 #include <GameDefinitions/Stats.h>
 #include <GameDefinitions/Osiris.h>
 #include <GameDefinitions/TurnManager.h>
@@ -371,6 +372,7 @@ namespace dse::esv::lua
 					OsiToLua(L, arg); // stack: func, arg0 ... argn
 				}
 
+				ProfilerEventScope profile(L, func);
 				auto status = CallWithTraceback(L, (int)args.size(), 0);
 				if (status != LUA_OK) {
 					OsiError("Failed to call function '" << func << "': " << lua_tostring(L, -1));
@@ -403,9 +405,16 @@ namespace dse::esv::lua
 		void OnGameStateChanged(GameState fromState, GameState toState);
 
 		std::optional<STDString> GetModPersistentVars(STDString const& modTable);
-		void RestoreModPersistentVars(STDString const& modTable, STDString const& vars);
+		void RestoreModPersistentVars(STDString const& modTable, STDString const& vars, bool legacyJson);
 
 	private:
+		struct PersistentVarsCacheEntry
+		{
+			// Hash of the variables the blob was made from
+			uint64_t Hash{ 0 };
+			STDString Blob;
+		};
+
 		ExtensionLibraryServer library_;
 		OsiArgumentPool<OsiArgumentDesc> argDescPool_;
 		OsiArgumentPool<TypedValue> tvPool_;
@@ -415,6 +424,8 @@ namespace dse::esv::lua
 		// ID of current story instance.
 		// Used to invalidate function/node pointers in Lua userdata objects
 		uint32_t generationId_{ 0 };
+		// Last serialized PersistentVars of each mod; reused on save if the mod made no changes
+		std::unordered_map<STDString, PersistentVarsCacheEntry> persistentVarsCache_;
 
 		bool QueryInternal(char const* mod, char const* name, RegistryEntry * func,
 			std::vector<CustomFunctionParam> const & signature, OsiArgumentDesc & params);
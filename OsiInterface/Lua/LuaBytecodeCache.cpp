@@ -0,0 +1,175 @@
+#include <stdafx.h>
+#include <Lua/LuaBytecodeCache.h>
+#include <OsirisProxy.h>
+#include <Version.h>
+#include <lauxlib.h>
+#include <fstream>
+#include <iomanip>
+
+namespace dse::lua
+{
+	uint64_t BytecodeCache::Hash(void const* data, std::size_t size, uint64_t hash)
+	{
+		// FNV-1a
+		auto bytes = reinterpret_cast<uint8_t const*>(data);
+		for (std::size_t i = 0; i < size; i++) {
+			hash ^= bytes[i];
+			hash *= 0x100000001b3ull;
+		}
+
+		return hash;
+	}
+
+	bool BytecodeCache::IsEnabled() const
+	{
+#if LUA_VERSION_NUM > 501
+		return gOsirisProxy->GetConfig().EnableLuaBytecodeCache;
+#else
+		return false;
+#endif
+	}
+
+	bool BytecodeCache::EnsureDirectory()
+	{
+		if (directoryCreated_) return true;
+
+		auto storageRoot = GetStaticSymbols().ToPath("/Osiris Data", PathRootType::GameStorage);
+		if (storageRoot.empty()) {
+			return false;
+		}
+
+		directory_ = storageRoot + "/LuaCache";
+		for (auto const& dir : { storageRoot, directory_ }) {
+			if (CreateDirectoryW(FromUTF8(dir).c_str(), NULL) == FALSE
+				&& GetLastError() != ERROR_ALREADY_EXISTS) {
+				OsiError("Could not create Lua bytecode cache directory: " << dir);
+				return false;
+			}
+		}
+
+		directoryCreated_ = true;
+		return true;
+	}
+
+	STDString BytecodeCache::GetEntryPath(uint64_t key) const
+	{
+		std::stringstream ss;
+		ss << directory_ << "/" << std::hex << std::setw(16) << std::setfill('0') << key << ".luac";
+		return STDString(ss.str());
+	}
+
+	int BytecodeCache::Load(lua_State* L, STDString const& source, STDString const& name)
+	{
+		if (!IsEnabled() || !EnsureDirectory()) {
+			return luaL_loadbufferx(L, source.c_str(), source.size(), name.c_str(), "text");
+		}
+
+		// The chunk name is part of the key, as it is stored in the bytecode debug info
+		auto sourceHash = Hash(source.data(), source.size());
+		auto key = Hash(name.data(), name.size(), sourceHash);
+		auto path = GetEntryPath(key);
+
+		if (TryLoad(L, path, source, sourceHash, name)) {
+			hits_++;
+			return LUA_OK;
+		}
+
+		misses_++;
+		int status = luaL_loadbufferx(L, source.c_str(), source.size(), name.c_str(), "text");
+		if (status == LUA_OK) {
+			Save(L, path, source, sourceHash);
+		}
+
+		return status;
+	}
+
+	bool BytecodeCache::TryLoad(lua_State* L, STDString const& path, STDString const& source, uint64_t sourceHash, STDString const& name)
+	{
+		std::ifstream f(path.c_str(), std::ios::in | std::ios::binary);
+		if (!f.good()) {
+			return false;
+		}
+
+		Header header;
+		f.read(reinterpret_cast<char*>(&header), sizeof(header));
+		if (!f.good()
+			|| header.Magic != Header::MagicValue
+			|| header.ExtenderVersion != CurrentVersion
+			|| header.LuaVersion != LUA_VERSION_NUM
+			|| header.PointerSize != sizeof(void*)
+			|| header.SourceHash != sourceHash
+			|| header.SourceSize != source.size()) {
+			return false;
+		}
+
+		STDString bytecode;
+		bytecode.resize(header.BytecodeSize);
+		f.read(bytecode.data(), bytecode.size());
+		if (!f.good() || Hash(bytecode.data(), bytecode.size()) != header.BytecodeHash) {
+			OsiWarn("Discarding corrupted Lua bytecode cache entry: " << path);
+			return false;
+		}
+
+		if (luaL_loadbufferx(L, bytecode.c_str(), bytecode.size(), name.c_str(), "b") != LUA_OK) {
+			OsiWarn("Failed to load cached Lua bytecode for '" << name << "': " << lua_tostring(L, -1));
+			lua_pop(L, 1);
+			return false;
+		}
+
+		return true;
+	}
+
+	void BytecodeCache::Save(lua_State* L, STDString const& path, STDString const& source, uint64_t sourceHash)
+	{
+#if LUA_VERSION_NUM > 501
+		STDString bytecode;
+		auto writer = [](lua_State* L, void const* p, size_t sz, void* ud) -> int {
+			reinterpret_cast<STDString*>(ud)->append(reinterpret_cast<char const*>(p), sz);
+			return 0;
+		};
+
+		// Debug info is kept, otherwise tracebacks would lose line numbers
+		if (lua_dump(L, writer, &bytecode, 0) != 0) {
+			return;
+		}
+
+		Header header;
+		header.Magic = Header::MagicValue;
+		header.ExtenderVersion = CurrentVersion;
+		header.LuaVersion = LUA_VERSION_NUM;
+		header.PointerSize = sizeof(void*);
+		header.SourceHash = sourceHash;
+		header.SourceSize = source.size();
+		header.BytecodeHash = Hash(bytecode.data(), bytecode.size());
+		header.BytecodeSize = bytecode.size();
+
+		// The server and client states may compile the same script concurrently;
+		// write to a private file first and move it in place afterwards
+		std::stringstream tempPath;
+		tempPath << path << "." << GetCurrentThreadId() << ".tmp";
+
+		{
+			std::ofstream f(tempPath.str().c_str(), std::ios::out | std::ios::binary);
+			if (!f.good()) {
+				return;
+			}
+
+			f.write(reinterpret_cast<char const*>(&header), sizeof(header));
+			f.write(bytecode.data(), bytecode.size());
+		}
+
+		if (!MoveFileExW(FromUTF8(tempPath.str()).c_str(), FromUTF8(path).c_str(), MOVEFILE_REPLACE_EXISTING)) {
+			DeleteFileW(FromUTF8(tempPath.str()).c_str());
+		}
+#endif
+	}
+
+	void BytecodeCache::LogStats()
+	{
+		if (!IsEnabled()) return;
+
+		auto total = hits_ + misses_;
+		DEBUG("Lua bytecode cache: %d of %d scripts loaded from cache (%.1f%% hit rate)",
+			hits_, total, total ? (hits_ * 100.0f / total) : 0.0f);
+	}
+}
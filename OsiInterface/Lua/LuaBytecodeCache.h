@@ -0,0 +1,57 @@
+#pragma once
+
+#include <GameDefinitions/BaseTypes.h>
+#include <lua.h>
+
+namespace dse::lua
+{
+	// Caches compiled Lua chunks in the game storage directory ("Osiris Data/LuaCache").
+	// Entries are keyed by a hash of the chunk name and source text and are
+	// discarded if the extender or Lua version changes.
+	class BytecodeCache
+	{
+	public:
+		// Loads the chunk from the cache if a valid entry exists, otherwise
+		// compiles it from source and stores the bytecode for later loads.
+		// Behaves like luaL_loadbufferx(..., "text").
+		int Load(lua_State* L, STDString const& source, STDString const& name);
+		void LogStats();
+
+		inline uint32_t GetHits() const
+		{
+			return hits_;
+		}
+
+		inline uint32_t GetMisses() const
+		{
+			return misses_;
+		}
+
+	private:
+		struct Header
+		{
+			static constexpr uint32_t MagicValue = 0x45534443; // 'CDSE'
+
+			uint32_t Magic;
+			uint32_t ExtenderVersion;
+			uint32_t LuaVersion;
+			uint32_t PointerSize;
+			uint64_t SourceHash;
+			uint64_t SourceSize;
+			uint64_t BytecodeHash;
+			uint64_t BytecodeSize;
+		};
+
+		STDString directory_;
+		bool directoryCreated_{ false };
+		uint32_t hits_{ 0 };
+		uint32_t misses_{ 0 };
+
+		static uint64_t Hash(void const* data, std::size_t size, uint64_t hash = 0xcbf29ce484222325ull);
+		bool IsEnabled() const;
+		bool EnsureDirectory();
+		STDString GetEntryPath(uint64_t key) const;
+		bool TryLoad(lua_State* L, STDString const& path, STDString const& source, uint64_t sourceHash, STDString const& name);
+		void Save(lua_State* L, STDString const& path, STDString const& source, uint64_t sourceHash);
+	};
+}
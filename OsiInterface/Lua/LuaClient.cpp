@@ -1,5 +1,6 @@
 #include <stdafx.h>
 #include <Lua/LuaBindingClient.h>
+#include <Lua/LuaBinaryMessage.h>
 #include <OsirisProxy.h>
 #include <ExtensionStateClient.h>
 #include <PropertyMaps.h>
@@ -433,6 +434,37 @@ namespace dse::ecl::lua
 		return 0;
 	}
 
+	int PostBinaryMessageToServer(lua_State* L)
+	{
+		auto channel = luaL_checkstring(L, 1);
+		luaL_checkany(L, 2);
+
+		auto& networkMgr = gOsirisProxy->GetNetworkManager();
+		if (!(networkMgr.ClientGetServerCapabilities() & (uint32_t)net::ExtenderCapabilities::BinaryMessages)) {
+			OsiErrorS("Cannot send binary message: the extender version of the server doesn't support it");
+			return 0;
+		}
+
+		STDString payload;
+		try {
+			binary::Serialize(L, 2, payload);
+		} catch (std::runtime_error& e) {
+			return luaL_error(L, "Unable to serialize message: %s", e.what());
+		}
+
+		auto msg = networkMgr.GetFreeClientMessage();
+		if (msg != nullptr) {
+			auto postMsg = msg->GetMessage().mutable_post_lua();
+			postMsg->set_channel_name(channel);
+			postMsg->set_binary_payload(payload.data(), payload.size());
+			networkMgr.ClientSend(msg);
+		} else {
+			OsiErrorS("Could not get free message!");
+		}
+
+		return 0;
+	}
+
 
 	char const* const StatusHandleProxy::MetatableName = "ecl::HStatus";
 
@@ -1234,6 +1266,25 @@ namespace dse::ecl::lua
 		return 0;
 	}
 
+	int GetDescriptionParamCacheStats(lua_State* L)
+	{
+		LuaClientPin pin(ExtensionState::Get());
+		auto& cache = pin->GetDescriptionParamCache();
+
+		lua_newtable(L);
+		setfield(L, "Hits", cache.GetHits());
+		setfield(L, "Misses", cache.GetMisses());
+		setfield(L, "Entries", (uint32_t)cache.GetSize());
+		return 1;
+	}
+
+	int ClearDescriptionParamCache(lua_State* L)
+	{
+		LuaClientPin pin(ExtensionState::Get());
+		pin->GetDescriptionParamCache().Clear();
+		return 0;
+	}
+
 
 	void ExtensionLibraryClient::RegisterLib(lua_State * L)
 	{
@@ -1265,6 +1316,8 @@ namespace dse::ecl::lua
 			{"GetTreasureTable", GetTreasureTable},
 			{"GetTreasureCategory", GetTreasureCategory},
 			{"StatGetAttribute", StatGetAttribute},
+			{"RunStatJob", RunStatJob},
+			{"GetStatJobResult", GetStatJobResult},
 			{"StatSetAttribute", StatSetAttribute},
 			{"StatAddCustomDescription", StatAddCustomDescription},
 			{"StatSetLevelScaling", StatSetLevelScaling},
@@ -1289,11 +1342,14 @@ namespace dse::ecl::lua
 			{"GetTranslatedStringFromKey", GetTranslatedStringFromKey},
 
 			{"PostMessageToServer", PostMessageToServer},
+			{"PostBinaryMessageToServer", PostBinaryMessageToServer},
 			{"CreateUI", CreateUI},
 			{"GetUI", GetUI},
 			{"GetUIByType", GetUIByType},
 			{"GetBuiltinUI", GetBuiltinUI},
 			{"DestroyUI", DestroyUI},
+			{"GetDescriptionParamCacheStats", GetDescriptionParamCacheStats},
+			{"ClearDescriptionParamCache", ClearDescriptionParamCache},
 			{0,0}
 		};
 
@@ -1380,13 +1436,31 @@ namespace dse::ecl::lua
 		CDivinityStats_Character * character, ObjectSet<STDString> const & paramTexts, bool isFromItem)
 	{
 		std::lock_guard lock(mutex_);
-		Restriction restriction(*this, RestrictAll);
+		if (!HasListeners("SkillGetDescriptionParam")) {
+			return {};
+		}
 
 		auto skill = prototype->GetStats();
 		if (skill == nullptr) {
 			return {};
 		}
 
+		auto key = descriptionParamCache_.MakeKey(prototype, character, nullptr, isFromItem, paramTexts);
+		auto cached = descriptionParamCache_.Find(key);
+		if (cached != nullptr) {
+			return *cached;
+		}
+
+		auto result = CallSkillGetDescriptionParam(skill, character, paramTexts, isFromItem);
+		descriptionParamCache_.Add(std::move(key), result);
+		return result;
+	}
+
+	std::optional<STDWString> ClientState::CallSkillGetDescriptionParam(CRPGStats_Object* skill,
+		CDivinityStats_Character* character, ObjectSet<STDString> const& paramTexts, bool isFromItem)
+	{
+		Restriction restriction(*this, RestrictAll);
+
 		PushExtFunction(L, "_SkillGetDescriptionParam"); // stack: fn
 
 		auto _{ PushArguments(L,
@@ -1416,13 +1490,31 @@ namespace dse::ecl::lua
 		CRPGStats_ObjectInstance* statusSource, ObjectSet<STDString> const & paramTexts)
 	{
 		std::lock_guard lock(mutex_);
-		Restriction restriction(*this, RestrictAll);
+		if (!HasListeners("StatusGetDescriptionParam")) {
+			return {};
+		}
 
 		auto status = prototype->GetStats();
 		if (status == nullptr) {
 			return {};
 		}
 
+		auto key = descriptionParamCache_.MakeKey(prototype, owner, statusSource, false, paramTexts);
+		auto cached = descriptionParamCache_.Find(key);
+		if (cached != nullptr) {
+			return *cached;
+		}
+
+		auto result = CallStatusGetDescriptionParam(status, owner, statusSource, paramTexts);
+		descriptionParamCache_.Add(std::move(key), result);
+		return result;
+	}
+
+	std::optional<STDWString> ClientState::CallStatusGetDescriptionParam(CRPGStats_Object* status, CRPGStats_ObjectInstance* owner,
+		CRPGStats_ObjectInstance* statusSource, ObjectSet<STDString> const& paramTexts)
+	{
+		Restriction restriction(*this, RestrictAll);
+
 		PushExtFunction(L, "_StatusGetDescriptionParam"); // stack: fn
 
 		auto luaStatus = Push<StatsProxy>(status, std::optional<int32_t>())(L);
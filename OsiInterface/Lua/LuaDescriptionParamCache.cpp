@@ -0,0 +1,169 @@
+#include <stdafx.h>
+#include <Lua/LuaDescriptionParamCache.h>
+#include <StatSnapshot.h>
+#include <OsirisProxy.h>
+
+namespace dse::ecl::lua
+{
+	namespace
+	{
+		uint64_t HashBytes(void const* begin, void const* end, uint64_t hash)
+		{
+			auto p = reinterpret_cast<uint8_t const*>(begin);
+			auto e = reinterpret_cast<uint8_t const*>(end);
+			for (; p < e; p++) {
+				hash = (hash ^ *p) * 0x100000001b3ull;
+			}
+
+			return hash;
+		}
+
+		template <class T>
+		uint64_t HashValue(T const& value, uint64_t hash)
+		{
+			return HashBytes(&value, &value + 1, hash);
+		}
+
+		uint64_t GetItemRevision(CDivinityStats_Item* item, uint64_t hash)
+		{
+			hash = HashValue(item->Level, hash);
+			hash = HashValue(item->Durability, hash);
+			hash = HashValue(item->AttributeFlags, hash);
+			hash = HashValue(item->MaxCharges, hash);
+			hash = HashValue(item->Charges, hash);
+			// Runes and item boosts add or replace dynamic attribute entries
+			for (auto attributes : item->DynamicAttributes) {
+				hash = HashValue(attributes, hash);
+			}
+
+			return hash;
+		}
+
+		uint64_t GetCharacterRevision(CDivinityStats_Character* character, uint64_t hash)
+		{
+			hash = HashValue(character->Level, hash);
+			hash = HashBytes(&character->CurrentVitality, &character->TraitOrder, hash);
+			hash = HashValue(character->MaxResistance, hash);
+			hash = HashValue(character->HasTwoHandedWeapon, hash);
+			hash = HashValue(character->IsIncapacitatedRefCount, hash);
+			hash = HashValue(character->ActiveBoostConditions, hash);
+			// Skip the RNG states, they change on every hit roll
+			hash = HashBytes(&character->MaxVitality, &character->DisabledTalents + 1, hash);
+
+			// Permanent boosts and status boosts are applied through the dynamic stats
+			for (auto dynamicStat : character->DynamicStats) {
+				hash = HashBytes(&dynamicStat->SummonLifelinkModifier, &dynamicStat->TranslationKey, hash);
+				hash = HashValue(dynamicStat->TranslationKey, hash);
+				hash = HashValue(dynamicStat->BonusWeapon, hash);
+			}
+
+			for (auto equipped : character->EquippedItems) {
+				hash = HashValue(equipped->ItemStatsHandle, hash);
+				hash = HashValue(equipped->ItemSlot, hash);
+				hash = HashValue(equipped->IsEquipped, hash);
+				if (equipped->IsEquipped) {
+					auto item = character->GetItemBySlot(equipped->ItemSlot, true);
+					if (item != nullptr) {
+						hash = GetItemRevision(item, hash);
+					}
+				}
+			}
+
+			return hash;
+		}
+	}
+
+	std::atomic<uint32_t> DescriptionParamCache::statsEdits_{ 0 };
+
+	bool DescriptionParamCache::Key::operator ==(Key const& o) const
+	{
+		return Prototype == o.Prototype
+			&& Owner == o.Owner
+			&& Source == o.Source
+			&& StatsRevision == o.StatsRevision
+			&& IsFromItem == o.IsFromItem
+			&& Params == o.Params;
+	}
+
+	std::size_t DescriptionParamCache::KeyHash::operator ()(Key const& key) const
+	{
+		auto hash = HashValue(key.Prototype, 0xcbf29ce484222325ull);
+		hash = HashValue(key.Owner, hash);
+		hash = HashValue(key.Source, hash);
+		hash = HashValue(key.StatsRevision, hash);
+		hash = HashValue(key.IsFromItem, hash);
+		return (std::size_t)HashBytes(key.Params.data(), key.Params.data() + key.Params.size(), hash);
+	}
+
+	uint64_t DescriptionParamCache::GetObjectRevision(CRPGStats_ObjectInstance* object, uint64_t hash)
+	{
+		auto stats = GetStaticSymbols().GetStats();
+		if (object == nullptr || stats == nullptr) {
+			return HashValue(object, hash);
+		}
+
+		if (object->ModifierListIndex == stats->modifierList.FindIndex(GFS.strCharacter)) {
+			return GetCharacterRevision(reinterpret_cast<CDivinityStats_Character*>(object), hash);
+		} else if (object->ModifierListIndex == stats->modifierList.FindIndex(GFS.strItem)) {
+			return GetItemRevision(reinterpret_cast<CDivinityStats_Item*>(object), hash);
+		} else {
+			return HashValue(object->Level, hash);
+		}
+	}
+
+	DescriptionParamCache::Key DescriptionParamCache::MakeKey(void const* prototype, CRPGStats_ObjectInstance* owner,
+		CRPGStats_ObjectInstance* source, bool isFromItem, ObjectSet<STDString> const& params) const
+	{
+		Key key;
+		key.Prototype = prototype;
+		key.Owner = owner;
+		key.Source = source;
+		key.IsFromItem = isFromItem;
+
+		// Stats entry changes synced from the server publish a new snapshot version
+		auto snapshot = gStatSnapshots.Acquire();
+		uint64_t revision = snapshot ? snapshot->Version : 0;
+		revision = HashValue(statsEdits_.load(), HashValue(revision, 0xcbf29ce484222325ull));
+		revision = GetObjectRevision(owner, revision);
+		key.StatsRevision = GetObjectRevision(source, revision);
+
+		for (auto const& param : params) {
+			key.Params += param;
+			key.Params += '\x1f';
+		}
+
+		return key;
+	}
+
+	std::optional<STDWString> const* DescriptionParamCache::Find(Key const& key)
+	{
+		auto it = entries_.find(key);
+		if (it != entries_.end()) {
+			hits_++;
+			return &it->second;
+		} else {
+			misses_++;
+			return nullptr;
+		}
+	}
+
+	void DescriptionParamCache::Add(Key&& key, std::optional<STDWString> const& value)
+	{
+		// Stale entries are never looked up again, so drop everything when the cache gets too large
+		if (entries_.size() >= MaxEntries) {
+			entries_.clear();
+		}
+
+		entries_.insert(std::make_pair(std::move(key), value));
+	}
+
+	void DescriptionParamCache::OnStatsEdited()
+	{
+		statsEdits_++;
+	}
+
+	void DescriptionParamCache::Clear()
+	{
+		entries_.clear();
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <GameDefinitions/Stats.h>
+#include <atomic>
+#include <optional>
+#include <unordered_map>
+
+namespace dse::ecl::lua
+{
+	// Caches the results of the SkillGetDescriptionParam and StatusGetDescriptionParam listeners,
+	// so redrawing a tooltip doesn't call into Lua for every description parameter.
+	// Entries are keyed by the stats revision of the characters/items the parameter was
+	// computed for, so they are invalidated when those objects or the stats entries change.
+	class DescriptionParamCache
+	{
+	public:
+		// The cache is flushed when it grows larger than this
+		static constexpr std::size_t MaxEntries = 4096;
+
+		struct Key
+		{
+			void const* Prototype;
+			CRPGStats_ObjectInstance const* Owner;
+			CRPGStats_ObjectInstance const* Source;
+			uint64_t StatsRevision;
+			bool IsFromItem;
+			STDString Params;
+
+			bool operator ==(Key const& o) const;
+		};
+
+		Key MakeKey(void const* prototype, CRPGStats_ObjectInstance* owner, CRPGStats_ObjectInstance* source,
+			bool isFromItem, ObjectSet<STDString> const& params) const;
+
+		// Returns nullptr if there is no cached result for the key
+		std::optional<STDWString> const* Find(Key const& key);
+		void Add(Key&& key, std::optional<STDWString> const& value);
+		void Clear();
+
+		// Called when a stats entry is modified locally (without a stat sync)
+		static void OnStatsEdited();
+
+		inline uint32_t GetHits() const
+		{
+			return hits_;
+		}
+
+		inline uint32_t GetMisses() const
+		{
+			return misses_;
+		}
+
+		inline std::size_t GetSize() const
+		{
+			return entries_.size();
+		}
+
+	private:
+		struct KeyHash
+		{
+			std::size_t operator ()(Key const& key) const;
+		};
+
+		std::unordered_map<Key, std::optional<STDWString>, KeyHash> entries_;
+		uint32_t hits_{ 0 };
+		uint32_t misses_{ 0 };
+		static std::atomic<uint32_t> statsEdits_;
+
+		static uint64_t GetObjectRevision(CRPGStats_ObjectInstance* object, uint64_t hash);
+	};
+}
@@ -3,234 +3,27 @@
 #include <PropertyMaps.h>
 #include <Version.h>
 #include <Lua/LuaBinding.h>
+#include <Lua/LuaJson.h>
+#include <Lua/LuaDescriptionParamCache.h>
 #include <ScriptHelpers.h>
 
 #include <fstream>
-#include <json/json.h>
 
 namespace dse::lua
 {
-	void JsonParse(lua_State * L, Json::Value & val);
-
-	void JsonParseArray(lua_State * L, Json::Value & val)
-	{
-		lua_newtable(L);
-		int idx = 1;
-		for (auto it = val.begin(), end = val.end(); it != end; ++it) {
-			push(L, idx++);
-			JsonParse(L, *it);
-			lua_settable(L, -3);
-		}
-	}
-
-	void JsonParseObject(lua_State * L, Json::Value & val)
-	{
-		lua_newtable(L);
-		for (auto it = val.begin(), end = val.end(); it != end; ++it) {
-			JsonParse(L, it.key());
-			JsonParse(L, *it);
-			lua_settable(L, -3);
-		}
-	}
-
-	void JsonParse(lua_State * L, Json::Value & val)
-	{
-		switch (val.type()) {
-		case Json::nullValue:
-			lua_pushnil(L);
-			break;
-
-		case Json::intValue:
-			push(L, val.asInt64());
-			break;
-
-		case Json::uintValue:
-			push(L, (int64_t)val.asUInt64());
-			break;
-
-		case Json::realValue:
-			push(L, val.asDouble());
-			break;
-
-		case Json::stringValue:
-			push(L, val.asCString());
-			break;
-
-		case Json::booleanValue:
-			push(L, val.asBool());
-			break;
-
-		case Json::arrayValue:
-			JsonParseArray(L, val);
-			break;
-
-		case Json::objectValue:
-			JsonParseObject(L, val);
-			break;
-
-		default:
-			luaL_error(L, "Attempted to parse unknown Json value");
-		}
-	}
-
-
 	int JsonParse(lua_State * L)
 	{
 		size_t length;
 		auto json = luaL_checklstring(L, 1, &length);
 
-		Json::CharReaderBuilder factory;
-		std::unique_ptr<Json::CharReader> reader(factory.newCharReader());
-
-		Json::Value root;
-		std::string errs;
-		if (!reader->parse(json, json + length, &root, &errs)) {
+		STDString errs;
+		if (!json::Parse(L, StringView(json, length), errs)) {
 			return luaL_error(L, "Unable to parse JSON: %s", errs.c_str());
 		}
 
-		JsonParse(L, root);
 		return 1;
 	}
 
-	Json::Value JsonStringify(lua_State * L, int index, int depth, bool stringifyInternalTypes);
-
-	Json::Value JsonStringifyObject(lua_State * L, int index, int depth, bool stringifyInternalTypes)
-	{
-		Json::Value arr(Json::objectValue);
-		lua_pushnil(L);
-
-		if (index < 0) index--;
-
-		while (lua_next(L, index) != 0) {
-			Json::Value val(JsonStringify(L, -1, depth + 1, stringifyInternalTypes));
-
-			if (lua_type(L, -2) == LUA_TSTRING) {
-				auto key = lua_tostring(L, -2);
-				arr[key] = val;
-			} else if (lua_type(L, -2) == LUA_TNUMBER) {
-				lua_pushvalue(L, -2);
-				auto key = lua_tostring(L, -1);
-				arr[key] = val;
-				lua_pop(L, 1);
-			} else {
-				throw std::runtime_error("Can only stringify string or number table keys");
-			}
-
-			lua_pop(L, 1);
-		}
-
-		return arr;
-	}
-
-	Json::Value JsonStringifyArray(lua_State * L, int index, int depth, bool stringifyInternalTypes)
-	{
-		Json::Value arr(Json::arrayValue);
-		lua_pushnil(L);
-
-		if (index < 0) index--;
-
-		while (lua_next(L, index) != 0) {
-			arr.append(JsonStringify(L, -1, depth + 1, stringifyInternalTypes));
-			lua_pop(L, 1);
-		}
-
-		return arr;
-	}
-
-	bool JsonCanStringifyAsArray(lua_State * L, int index)
-	{
-		Json::Value arr(Json::objectValue);
-		lua_pushnil(L);
-
-		if (index < 0) index--;
-
-		int next = 1;
-		bool isArray = true;
-		while (lua_next(L, index) != 0) {
-#if LUA_VERSION_NUM > 501
-			if (lua_isinteger(L, -2)) {
-				auto key = lua_tointeger(L, -2);
-				if (key != next++) {
-					isArray = false;
-				}
-			} else {
-				isArray = false;
-			}
-#else
-			if (lua_isnumber(L, -2)) {
-				auto key = lua_tonumber(L, -2);
-				if (abs(key - next++) < 0.0001) {
-					isArray = false;
-				}
-			} else {
-				isArray = false;
-			}
-#endif
-
-			lua_pop(L, 1);
-		}
-
-		return isArray;
-	}
-
-	Json::Value JsonStringifyTable(lua_State * L, int index, int depth, bool stringifyInternalTypes)
-	{
-		if (JsonCanStringifyAsArray(L, index)) {
-			return JsonStringifyArray(L, index, depth, stringifyInternalTypes);
-		} else {
-			return JsonStringifyObject(L, index, depth, stringifyInternalTypes);
-		}
-	}
-
-
-	Json::Value JsonStringify(lua_State * L, int index, int depth, bool stringifyInternalTypes)
-	{
-		if (depth > 64) {
-			throw std::runtime_error("Recursion depth exceeded while stringifying JSON");
-		}
-
-		switch (lua_type(L, index)) {
-		case LUA_TNIL:
-			return Json::Value(Json::nullValue);
-
-		case LUA_TBOOLEAN:
-			return Json::Value(lua_toboolean(L, index) == 1);
-
-		case LUA_TNUMBER:
-#if LUA_VERSION_NUM > 501
-			if (lua_isinteger(L, index)) {
-				return Json::Value(lua_tointeger(L, index));
-			} else {
-				return Json::Value(lua_tonumber(L, index));
-			}
-#else
-			return Json::Value(lua_tonumber(L, index));
-#endif
-
-		case LUA_TSTRING:
-			return Json::Value(lua_tostring(L, index));
-
-		case LUA_TTABLE:
-			return JsonStringifyTable(L, index, depth, stringifyInternalTypes);
-
-		case LUA_TLIGHTUSERDATA:
-		case LUA_TFUNCTION:
-		case LUA_TUSERDATA:
-		case LUA_TTHREAD:
-			if (stringifyInternalTypes) {
-				auto val = Json::Value(luaL_tolstring(L, index, NULL));
-				lua_pop(L, 1);
-				return val;
-			} else {
-				throw std::runtime_error("Attempted to stringify a lightuserdata, userdata, function or thread value");
-			}
-
-		default:
-			throw std::runtime_error("Attempted to stringify an unknown type");
-		}
-	}
-
-
 	int JsonStringify(lua_State * L)
 	{
 		int nargs = lua_gettop(L);
@@ -242,32 +35,21 @@ namespace dse::lua
 			return luaL_error(L, "JsonStringify expects at most three parameters.");
 		}
 
-		bool beautify{ true };
-		if (nargs >= 2) {
-			beautify = lua_toboolean(L, 2) == 1;
-		}
-
+		// The beautify parameter (2) is accepted for compatibility only; the previous
+		// jsoncpp writer always used tab indentation, and the output format is kept
 		bool stringifyInternalTypes{ false };
 		if (nargs >= 3) {
 			stringifyInternalTypes = lua_toboolean(L, 3) == 1;
 		}
 
-		Json::Value root;
+		STDString json;
 		try {
-			root = JsonStringify(L, 1, 0, stringifyInternalTypes);
+			json::Stringify(L, 1, stringifyInternalTypes, json);
 		} catch (std::runtime_error & e) {
 			return luaL_error(L, "%s", e.what());
 		}
 
-		Json::StreamWriterBuilder builder;
-		if (beautify) {
-			builder["indentation"] = "\t";
-		}
-		std::stringstream ss;
-		std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
-		writer->write(root, &ss);
-
-		push(L, ss.str());
+		push(L, json);
 		return 1;
 	}
 
@@ -486,31 +268,30 @@ namespace dse::lua
 	void FetchStatEntries(lua_State * L, CRPGStatsManager * stats, FixedString const& statType)
 	{
 		int32_t index = 1;
-		for (auto object : stats->objects.Primitives) {
-			if (statType) {
-				auto type = stats->GetTypeInfo(object);
-				if (type == nullptr || type->Name != statType) {
-					continue;
-				}
+		if (statType) {
+			auto modifierListIndex = stats->modifierList.FindIndex(statType);
+			gStatEntryIndex.Iterate(stats, modifierListIndex, [L, &index](FixedString const& name) {
+				settable(L, index++, name);
+			});
+		} else {
+			for (auto object : stats->objects.Primitives) {
+				settable(L, index++, object->Name);
 			}
-
-			settable(L, index++, object->Name);
 		}
 	}
 
 	void FetchStatEntriesBefore(lua_State* L, CRPGStatsManager* stats, FixedString const& modId, FixedString const& statType)
 	{
-		auto entries = gOsirisProxy->GetStatLoadOrderHelper().GetStatsLoadedBefore(modId);
+		int32_t modifierListIndex{ -1 };
+		if (statType) {
+			modifierListIndex = stats->modifierList.FindIndex(statType);
+			if (modifierListIndex == -1) return;
+		}
+
+		auto entries = gOsirisProxy->GetStatLoadOrderHelper().GetStatsLoadedBefore(modId, modifierListIndex);
 
 		int32_t index = 1;
 		for (auto object : entries) {
-			if (statType) {
-				auto type = stats->GetTypeInfo(object);
-				if (type == nullptr || type->Name != statType) {
-					continue;
-				}
-			}
-
 			settable(L, index++, object->Name);
 		}
 	}
@@ -1126,16 +907,26 @@ namespace dse::lua
 			return 0;
 		}
 
-		if (attributeFS == GFS.strLevel) {
+		auto attribute = gStatAttributeCache.Find(stats, object->ModifierListIndex, attributeFS);
+		if (attribute == nullptr) {
+			OsiError("Stat object '" << object->Name << "' has no attribute named '" << attributeFS << "'");
+			return 0;
+		}
+
+		switch (attribute->Special) {
+		case StatAttributeSpecial::Level:
 			push(L, object->Level);
 			return 1;
-		} else if (attributeFS == GFS.strName) {
+
+		case StatAttributeSpecial::Name:
 			push(L, object->Name);
 			return 1;
-		} else if (attributeFS == GFS.strModId) {
+
+		case StatAttributeSpecial::ModId:
 			push(L, gOsirisProxy->GetStatLoadOrderHelper().GetStatsEntryMod(object->Name));
 			return 1;
-		} else if (attributeFS == GFS.strUsing) {
+
+		case StatAttributeSpecial::Using:
 			if (object->Using) {
 				auto parent = stats->objects.Find(object->Using);
 				if (parent != nullptr) {
@@ -1145,23 +936,31 @@ namespace dse::lua
 			}
 
 			return 0;
-		} else if (attributeFS == GFS.strRequirements) {
+
+		case StatAttributeSpecial::Requirements:
 			RequirementsToLua(L, object->Requirements);
 			return 1;
-		} else if (attributeFS == GFS.strMemorizationRequirements) {
+
+		case StatAttributeSpecial::MemorizationRequirements:
 			RequirementsToLua(L, object->MemorizationRequirements);
 			return 1;
-		} else if (attributeFS == GFS.strAIFlags) {
+
+		case StatAttributeSpecial::AIFlags:
 			push(L, object->AIFlags);
 			return 1;
-		} else if (attributeFS == GFS.strComboCategory) {
+
+		case StatAttributeSpecial::ComboCategory:
+		{
 			lua_newtable(L);
 			auto index = 1;
 			for (auto const& category : object->ComboCategories) {
 				settable(L, index++, category);
 			}
 			return 1;
-		} else if (attributeFS == GFS.strSkillProperties || attributeFS == GFS.strExtraProperties) {
+		}
+
+		case StatAttributeSpecial::PropertyList:
+		{
 			auto propertyList = object->PropertyList.Find(attributeFS);
 			if (propertyList) {
 				ObjectPropertyListToLua(L, **propertyList);
@@ -1171,9 +970,11 @@ namespace dse::lua
 			}
 		}
 
-		int index;
-		auto attrInfo = stats->GetAttributeInfo(object, attributeFS, index);
-		if (attrInfo && attrInfo->Name == GFS.strConditions) {
+		default:
+			break;
+		}
+
+		if (attribute->Type == StatAttributeType::Conditions) {
 			auto conditions = object->ConditionList.Find(attributeFS);
 			if (conditions) {
 				OsiError("Conditions property '" << attributeFS << "' is not readable");
@@ -1183,7 +984,7 @@ namespace dse::lua
 			}
 		}
 
-		auto value = stats->GetAttributeString(object, attributeFS);
+		auto value = stats->GetAttributeString(object, *attribute);
 		if (!value) {
 			std::optional<int> intval;
 			if (level) {
@@ -1191,9 +992,9 @@ namespace dse::lua
 					*level = object->Level;
 				}
 
-				intval = stats->GetAttributeIntScaled(object, attributeFS, *level);
+				intval = stats->GetAttributeIntScaled(object, *attribute, *level);
 			} else {
-				intval = stats->GetAttributeInt(object, attributeFS);
+				intval = stats->GetAttributeInt(object, *attribute);
 			}
 
 			if (!intval) {
@@ -1231,6 +1032,14 @@ namespace dse::lua
 		return LuaStatGetAttribute(L, object, attributeName, {});
 	}
 
+	// Records modifications made on the server, so SyncStat() only needs to send the modified fields
+	void MarkStatFieldModified(CRPGStats_Object* object, StatSyncField field)
+	{
+		if (gOsirisProxy->IsInServerThread()) {
+			gOsirisProxy->StatSync().MarkFieldDirty(object->Name, field);
+		}
+	}
+
 	int LuaStatSetAttribute(lua_State * L, CRPGStats_Object * object, char const * attributeName, int valueIdx)
 	{
 		LuaVirtualPin lua(gOsirisProxy->GetCurrentExtensionState());
@@ -1252,16 +1061,32 @@ namespace dse::lua
 			return 0;
 		}
 
-		if (attributeFS == GFS.strRequirements) {
+		auto stats = GetStaticSymbols().GetStats();
+		auto attribute = gStatAttributeCache.Find(stats, object->ModifierListIndex, attributeFS);
+		if (attribute == nullptr) {
+			OsiError("Couldn't fetch type info for " << object->Name << "." << attributeFS);
+			push(L, false);
+			return 1;
+		}
+
+		switch (attribute->Special) {
+		case StatAttributeSpecial::Requirements:
 			LuaToRequirements(L, object->Requirements);
+			MarkStatFieldModified(object, StatSyncField::Requirements);
 			return 0;
-		} else if (attributeFS == GFS.strMemorizationRequirements) {
+
+		case StatAttributeSpecial::MemorizationRequirements:
 			LuaToRequirements(L, object->MemorizationRequirements);
+			MarkStatFieldModified(object, StatSyncField::MemorizationRequirements);
 			return 0;
-		} else if (attributeFS == GFS.strAIFlags) {
+
+		case StatAttributeSpecial::AIFlags:
 			object->AIFlags = MakeFixedString(lua_tostring(L, valueIdx));
+			MarkStatFieldModified(object, StatSyncField::AIFlags);
 			return 0;
-		} else if (attributeFS == GFS.strComboCategory) {
+
+		case StatAttributeSpecial::ComboCategory:
+			MarkStatFieldModified(object, StatSyncField::ComboCategories);
 			object->ComboCategories.Set.Clear();
 			if (lua_type(L, valueIdx) != LUA_TTABLE) {
 				OsiError("Must pass a table when setting ComboCategory");
@@ -1274,7 +1099,9 @@ namespace dse::lua
 			}
 
 			return 0;
-		} else if (attributeFS == GFS.strSkillProperties || attributeFS == GFS.strExtraProperties) {
+
+		case StatAttributeSpecial::PropertyList:
+		{
 			STDString name = object->Name.Str;
 			name += "_";
 			name += attributeName;
@@ -1282,7 +1109,7 @@ namespace dse::lua
 
 			auto newList = LuaToObjectPropertyList(L, statsPropertyKey);
 			if (newList) {
-				auto propertyList = object->PropertyList.Find(ToFixedString(attributeName));
+				auto propertyList = object->PropertyList.Find(attributeFS);
 				if (propertyList) {
 					// FIXME - add Remove() support!
 					object->PropertyList.Clear();
@@ -1290,16 +1117,18 @@ namespace dse::lua
 					// GameFree(*propertyList);
 				}
 
-				object->PropertyList.Insert(MakeFixedString(attributeName), newList);
+				object->PropertyList.Insert(attributeFS, newList);
+				MarkStatFieldModified(object, StatSyncField::PropertyLists);
 			}
 
 			return 0;
 		}
 
-		int index;
-		auto stats = GetStaticSymbols().GetStats();
-		auto attrInfo = stats->GetAttributeInfo(object, attributeFS, index);
-		if (attrInfo && attrInfo->Name == GFS.strConditions) {
+		default:
+			break;
+		}
+
+		if (attribute->Type == StatAttributeType::Conditions) {
 			auto conditions = object->ConditionList.Find(attributeFS);
 			if (conditions) {
 				auto value = luaL_checkstring(L, valueIdx);
@@ -1328,14 +1157,14 @@ namespace dse::lua
 		case LUA_TSTRING:
 		{
 			auto value = luaL_checkstring(L, valueIdx);
-			ok = stats->SetAttributeString(object, attributeFS, value);
+			ok = stats->SetAttributeString(object, *attribute, value);
 			break;
 		}
 
 		case LUA_TNUMBER:
 		{
 			auto value = (int32_t)luaL_checkinteger(L, valueIdx);
-			ok = stats->SetAttributeInt(object, attributeFS, value);
+			ok = stats->SetAttributeInt(object, *attribute, value);
 			break;
 		}
 
@@ -1343,6 +1172,14 @@ namespace dse::lua
 			return luaL_error(L, "Expected a string or integer attribute value.");
 		}
 
+		if (ok) {
+			if (gOsirisProxy->IsInServerThread()) {
+				gOsirisProxy->StatSync().MarkAttributeDirty(object->Name, (uint32_t)attribute->Index);
+			} else {
+				ecl::lua::DescriptionParamCache::OnStatsEdited();
+			}
+		}
+
 		push(L, ok);
 		return 1;
 	}
@@ -1389,6 +1226,7 @@ namespace dse::lua
 		customProp->Conditions = nullptr;
 		customProp->TextLine1 = FromUTF8(description);
 		(*props)->Properties.Primitives.Set.Add(customProp);
+		MarkStatFieldModified(object, StatSyncField::PropertyLists);
 
 		return 0;
 	}
@@ -1461,6 +1299,7 @@ namespace dse::lua
 		for (auto levelMapIndex : levelMapIds) {
 			auto levelMap = static_cast<CRPGStats_CustomLevelMap *>(levelMaps.Buf[levelMapIndex]);
 			levelMaps.Buf[levelMapIndex] = levelMap->OriginalLevelMap;
+			gStatLevelMapCache.Invalidate(levelMapIndex, false);
 		}
 
 		if (!levelMapIds.empty()) {
@@ -1516,6 +1355,7 @@ namespace dse::lua
 
 		stats->LevelMaps.Primitives.Set.Buf[modifier->LevelMapIndex] = levelMap;
 		lua->OverriddenLevelMaps.insert(modifier->LevelMapIndex);
+		gStatLevelMapCache.Invalidate(modifier->LevelMapIndex, true);
 
 		return 0;
 	}
@@ -1612,6 +1452,10 @@ namespace dse::lua
 			}
 		}
 
+		if (gOsirisProxy->IsInServerThread()) {
+			gOsirisProxy->StatSync().MarkFullSync((*object)->Name);
+		}
+
 		StatsProxy::New(L, *object, -1);
 		return 1;
 	}
@@ -1632,7 +1476,7 @@ namespace dse::lua
 		}
 
 		stats->SyncWithPrototypeManager(object);
-		object->BroadcastSyncMessage();
+		gOsirisProxy->StatSync().QueueSync(object->Name);
 
 		if (persist) {
 			gOsirisProxy->GetServerExtensionState().MarkRuntimeModifiedStat(ToFixedString(statName));
@@ -0,0 +1,778 @@
+#include <stdafx.h>
+#include <OsirisProxy.h>
+#include <PropertyMaps.h>
+#include <Lua/LuaBinding.h>
+#include <GameMath.h>
+
+// Ext._GameMath: native implementations of the Game.Math damage and hit formulas (GameMath.cpp)
+// for the wrappers at the end of Game.Math.lua.
+// Every function returns false as its first result if it can't handle its arguments
+// (unknown object types, enumeration labels or value types); the Lua implementation runs instead.
+// Arguments are validated before any random number is drawn, so that a fallback doesn't
+// change the random sequence seen by the Lua code. Equipped items are only read when a formula
+// needs them; an item with stats the formulas can't represent makes the call fall back as well.
+
+namespace dse::lua
+{
+#if LUA_VERSION_NUM > 501
+	static_assert((uint32_t)gamemath::DamageType::Sentinel == (uint32_t)DamageType::Sentinel);
+	static_assert((uint32_t)gamemath::DamageType::Shadow == (uint32_t)DamageType::Shadow);
+	static_assert((uint8_t)gamemath::DeathType::Sentinel == (uint8_t)DeathType::Sentinel);
+	static_assert((uint32_t)gamemath::HitType::Reflected == (uint32_t)HitType::Reflected);
+	static_assert((int)gamemath::CriticalRoll::NotCritical == (int)CriticalRoll::NotCritical);
+	static_assert((int)gamemath::HighGroundBonus::LowGround == (int)HighGroundBonus::LowGround);
+	static_assert((uint32_t)gamemath::WeaponType::Sentinel == (uint32_t)WeaponType::Sentinel);
+	static_assert((uint32_t)gamemath::EquipmentStatsType::Shield == (uint32_t)EquipmentStatsType::Shield);
+	static_assert((uint32_t)gamemath::RequirementType::Wits == (uint32_t)RequirementType::Wits);
+	static_assert((uint32_t)gamemath::RequirementType::Tag == (uint32_t)RequirementType::Tag);
+	static_assert((int)gamemath::Talent::Damage == (int)TalentType::Damage);
+	static_assert((int)gamemath::Talent::Durability == (int)TalentType::Durability);
+	static_assert((int)gamemath::Talent::RangerLoreEvasionBonus == (int)TalentType::RangerLoreEvasionBonus);
+	static_assert((int)gamemath::Talent::Human_Inventive == (int)TalentType::Human_Inventive);
+	static_assert((int)gamemath::Talent::ViolentMagic == (int)TalentType::ViolentMagic);
+	static_assert((int)gamemath::Talent::Sadist == (int)TalentType::Sadist);
+	static_assert((int)gamemath::Talent::Haymaker == (int)TalentType::Haymaker);
+
+	namespace
+	{
+		using gamemath::CharacterStat;
+		using gamemath::CharacterFlag;
+
+		// Property names of the character stats proxy, in CharacterStat order
+		char const* const CharacterStatNames[] = {
+			"Level", "Strength", "Finesse", "Intelligence", "Constitution", "Memory", "Wits",
+			"WarriorLore", "RangerLore", "RogueLore", "SingleHanded", "TwoHanded", "Ranged", "DualWielding",
+			"FireSpecialist", "WaterSpecialist", "AirSpecialist", "EarthSpecialist",
+			"PhysicalResistance", "PiercingResistance", "CorrosiveResistance", "MagicResistance",
+			"FireResistance", "AirResistance", "WaterResistance", "EarthResistance", "PoisonResistance",
+			"ShadowResistance", "DamageBoost", "CriticalChance", "Accuracy", "Dodge", "ChanceToHitBoost",
+			"BlockChance", "LifeSteal", "MaxVitality", "MaxArmor", "MaxMagicArmor", "CurrentVitality",
+			"CurrentArmor", "CurrentMagicArmor", "IsIncapacitatedRefCount"
+		};
+
+		static_assert(std::size(CharacterStatNames) == (size_t)CharacterStat::IsIncapacitatedRefCount + 1);
+
+		char const* const ExtraDataKeys[] = {
+#define DEFN_EXTRA_DATA(name, key) key,
+#include <GameMathExtraData.inl>
+#undef DEFN_EXTRA_DATA
+		};
+
+		double gamemath::ExtraData::* const ExtraDataFields[] = {
+#define DEFN_EXTRA_DATA(name, key) &gamemath::ExtraData::name,
+#include <GameMathExtraData.inl>
+#undef DEFN_EXTRA_DATA
+		};
+
+		// "Damage" attribute labels, in DamageSource order
+		char const* const DamageSourceNames[] = {
+			"BaseLevelDamage", "AverageLevelDamge", "MonsterWeaponDamage", "SourceMaximumVitality",
+			"SourceMaximumPhysicalArmor", "SourceMaximumMagicArmor", "SourceCurrentVitality",
+			"SourceCurrentPhysicalArmor", "SourceCurrentMagicArmor", "SourceShieldPhysicalArmor",
+			"TargetMaximumVitality", "TargetMaximumPhysicalArmor", "TargetMaximumMagicArmor",
+			"TargetCurrentVitality", "TargetCurrentPhysicalArmor", "TargetCurrentMagicArmor"
+		};
+
+		static_assert(std::size(DamageSourceNames) == (size_t)gamemath::DamageSource::Unknown);
+
+		// FixedStrings of a list of names, looked up once.
+		// Names that aren't in the string table yet are looked up again on each use.
+		template <size_t N>
+		class FixedStringList
+		{
+		public:
+			FixedStringList(char const* const (&names)[N])
+				: names_(names)
+			{
+				for (size_t i = 0; i < N; i++) {
+					strings_[i] = ToFixedString(names[i]);
+				}
+			}
+
+			FixedString Get(size_t index) const
+			{
+				if (strings_[index]) {
+					return strings_[index];
+				} else {
+					return ToFixedString(names_[index]);
+				}
+			}
+
+		private:
+			char const* const (&names_)[N];
+			FixedString strings_[N];
+		};
+
+		FixedString GetCharacterStatName(CharacterStat stat)
+		{
+			static FixedStringList<std::size(CharacterStatNames)> names(CharacterStatNames);
+			return names.Get((size_t)stat);
+		}
+
+		bool ReadExtraData(gamemath::ExtraData& extra)
+		{
+			static FixedStringList<std::size(ExtraDataKeys)> keys(ExtraDataKeys);
+
+			auto stats = GetStaticSymbols().GetStats();
+			if (stats == nullptr || stats->ExtraData == nullptr) return false;
+
+			for (size_t i = 0; i < std::size(ExtraDataKeys); i++) {
+				auto value = stats->ExtraData->Properties.Find(keys.Get(i));
+				if (value == nullptr) return false;
+				extra.*ExtraDataFields[i] = *value;
+			}
+
+			return true;
+		}
+
+		// Builds the formula view of an item from the values the item stats proxy returns
+		bool ReadItem(CDivinityStats_Item* stats, gamemath::Item& item)
+		{
+			if ((uint32_t)stats->ItemType > (uint32_t)EquipmentStatsType::Shield
+				|| (uint32_t)stats->WeaponType > (uint32_t)WeaponType::Sentinel) {
+				return false;
+			}
+
+			item.InstanceId = stats->InstanceId;
+			item.ItemType = (gamemath::EquipmentStatsType)stats->ItemType;
+			item.WeaponType = (gamemath::WeaponType)stats->WeaponType;
+			item.IsTwoHanded = stats->IsTwoHanded;
+			item.IsDefaultWeapon = stats->Name.Str != nullptr && strcmp(stats->Name.Str, "DefaultWeapon") == 0;
+			item.Context = stats;
+
+			for (auto attributes : stats->DynamicAttributes) {
+				gamemath::ItemStats itemStats;
+				switch (attributes->StatsType) {
+				case EquipmentStatsType::Weapon:
+				{
+					auto weapon = static_cast<CDivinityStats_Equipment_Attributes_Weapon*>(attributes);
+					if ((uint32_t)weapon->DamageType > (uint32_t)DamageType::Sentinel) return false;
+					itemStats.StatsType = gamemath::EquipmentStatsType::Weapon;
+					itemStats.DamageType = (gamemath::DamageType)weapon->DamageType;
+					itemStats.MinDamage = weapon->MinDamage;
+					itemStats.MaxDamage = weapon->MaxDamage;
+					itemStats.DamageBoost = weapon->DamageBoost;
+					itemStats.DamageFromBase = weapon->DamageFromBase;
+					itemStats.CriticalDamage = weapon->CriticalDamage;
+					break;
+				}
+
+				case EquipmentStatsType::Shield:
+				{
+					auto shield = static_cast<CDivinityStats_Equipment_Attributes_Shield*>(attributes);
+					itemStats.StatsType = gamemath::EquipmentStatsType::Shield;
+					itemStats.ArmorValue = shield->ArmorValue;
+					itemStats.ArmorBoost = shield->ArmorBoost;
+					break;
+				}
+
+				case EquipmentStatsType::Armor:
+				{
+					auto armor = static_cast<CDivinityStats_Equipment_Attributes_Armor*>(attributes);
+					itemStats.StatsType = gamemath::EquipmentStatsType::Armor;
+					itemStats.ArmorValue = armor->ArmorValue;
+					itemStats.ArmorBoost = armor->ArmorBoost;
+					break;
+				}
+
+				default:
+					return false;
+				}
+
+				item.DynamicStats.push_back(itemStats);
+			}
+
+			for (uint32_t i = 0; i < stats->Requirements.Set.Size; i++) {
+				auto const& requirement = stats->Requirements[i];
+				gamemath::Requirement req;
+				req.Type = (gamemath::RequirementType)requirement.RequirementId;
+				req.Param = requirement.IntParam;
+				req.Not = requirement.Negate;
+				item.Requirements.push_back(req);
+			}
+
+			return true;
+		}
+
+
+		// Character stats read on demand, in the same order of lookups as CharacterFetchStat()
+		class StatsCharacter : public gamemath::Character
+		{
+		public:
+			StatsCharacter(CDivinityStats_Character* stats)
+				: stats_(stats)
+			{}
+
+			std::optional<int32_t> GetStat(CharacterStat stat) const override
+			{
+				auto name = GetCharacterStatName(stat);
+				if (!name) return {};
+
+				auto value = stats_->GetStat(name, false);
+				if (value) return value;
+
+				auto ability = EnumInfo<AbilityType>::Find(name);
+				if (ability) return stats_->GetAbility(*ability, false);
+
+				auto prop = gCharacterStatsPropertyMap.getInt(stats_, name, false, false);
+				if (prop) return (int32_t)*prop;
+
+				return {};
+			}
+
+			bool HasTalent(gamemath::Talent talent) const override
+			{
+				return stats_->HasTalent((TalentType)talent, false);
+			}
+
+			bool HasFlag(CharacterFlag flag) const override
+			{
+				switch (flag) {
+				case CharacterFlag::IsSneaking: return (bool)(stats_->Flags & StatCharacterFlags::IsSneaking);
+				case CharacterFlag::Invisible: return (bool)(stats_->Flags & StatCharacterFlags::Invisible);
+				case CharacterFlag::InParty: return (bool)(stats_->Flags & StatCharacterFlags::InParty);
+				default: return false;
+				}
+			}
+
+			gamemath::Item const* GetMainWeapon() const override
+			{
+				return mainWeapon_.Get([this] { return stats_->GetMainWeapon(); });
+			}
+
+			gamemath::Item const* GetOffHandWeapon() const override
+			{
+				return offHandWeapon_.Get([this] { return stats_->GetOffHandWeapon(); });
+			}
+
+			gamemath::Item const* GetShield() const override
+			{
+				return shield_.Get([this] { return stats_->GetItemBySlot(ItemSlot::Shield, true); });
+			}
+
+			bool GetPosition(double (&position)[3]) const override
+			{
+				if (stats_->Character == nullptr) return false;
+				auto translate = stats_->Character->GetTranslate();
+				position[0] = translate->x;
+				position[1] = translate->y;
+				position[2] = translate->z;
+				return true;
+			}
+
+			bool GetRotation(double (&rotation)[9]) const override
+			{
+				if (stats_->Character == nullptr) return false;
+				auto const& rot = *stats_->Character->GetRotation();
+				for (auto i = 0; i < 9; i++) {
+					rotation[i] = rot[i / 3][i % 3];
+				}
+				return true;
+			}
+
+		private:
+			class CachedItem
+			{
+			public:
+				template <class Fetch>
+				gamemath::Item const* Get(Fetch fetch) const
+				{
+					if (!fetched_) {
+						fetched_ = true;
+						auto stats = fetch();
+						// Items the formulas can't represent are only an error if they're used
+						if (stats != nullptr && ReadItem(stats, item_)) {
+							present_ = true;
+						} else if (stats != nullptr) {
+							throw gamemath::ScriptError{};
+						}
+					}
+
+					return present_ ? &item_ : nullptr;
+				}
+
+			private:
+				mutable bool fetched_{ false };
+				mutable bool present_{ false };
+				mutable gamemath::Item item_;
+			};
+
+			CDivinityStats_Character* stats_;
+			CachedItem mainWeapon_, offHandWeapon_, shield_;
+		};
+
+
+		class LuaEnvironment : public gamemath::Environment
+		{
+		public:
+			// Indices of math.random, Game.Math.ConditionalDamageItemDurability and of the
+			// attacker and weapon arguments (0 if not available)
+			LuaEnvironment(lua_State* L, int randomIndex = 0, int durabilityIndex = 0, int attackerIndex = 0, int weaponIndex = 0)
+				: L(L), randomIndex_(randomIndex), durabilityIndex_(durabilityIndex),
+				attackerIndex_(attackerIndex), weaponIndex_(weaponIndex)
+			{}
+
+			int64_t ExtRandom(int64_t min, int64_t max) override
+			{
+				// Same as Ext.Random(min, max)
+				auto state = gOsirisProxy->GetCurrentExtensionState();
+				std::uniform_int_distribution<int64_t> dist(min, max);
+				return dist(state->OsiRng);
+			}
+
+			int64_t MathRandom(int64_t min, int64_t max) override
+			{
+				lua_pushvalue(L, randomIndex_);
+				push(L, min);
+				push(L, max);
+				lua_call(L, 2, 1);
+				auto result = lua_tointeger(L, -1);
+				lua_pop(L, 1);
+				return result;
+			}
+
+			bool ConditionalDamageItemDurability(gamemath::Character const&, gamemath::Item const&) override
+			{
+				// The formulas only pass the attacker and weapon arguments of ComputeCharacterHit.
+				// Errors propagate to the caller like they would from the Lua implementation.
+				lua_pushvalue(L, durabilityIndex_);
+				lua_pushvalue(L, attackerIndex_);
+				lua_pushvalue(L, weaponIndex_);
+				lua_call(L, 2, 0);
+				return true;
+			}
+
+		private:
+			lua_State* L;
+			int randomIndex_, durabilityIndex_, attackerIndex_, weaponIndex_;
+		};
+
+
+		// Returns false if the value is neither nil nor a character stats object
+		bool GetCharacterArg(lua_State* L, int index, CDivinityStats_Character*& stats)
+		{
+			if (lua_isnoneornil(L, index)) {
+				stats = nullptr;
+				return true;
+			}
+
+			auto proxy = ObjectProxy<CDivinityStats_Character>::AsUserData(L, index);
+			if (proxy == nullptr) return false;
+			stats = proxy->Get(L);
+			return true;
+		}
+
+		// Returns false if the value is neither nil nor an item stats object that the formulas can represent
+		bool GetItemArg(lua_State* L, int index, std::optional<gamemath::Item>& item)
+		{
+			if (lua_isnoneornil(L, index)) return true;
+
+			auto proxy = ObjectProxy<CDivinityStats_Item>::AsUserData(L, index);
+			if (proxy == nullptr) return false;
+			item.emplace();
+			return ReadItem(proxy->Get(L), *item);
+		}
+
+		bool GetBoolArg(lua_State* L, int index, bool& value)
+		{
+			if (lua_type(L, index) != LUA_TBOOLEAN) return false;
+			value = lua_toboolean(L, index) == 1;
+			return true;
+		}
+
+		template <class T>
+		bool GetIntegerArg(lua_State* L, int index, T& value)
+		{
+			if (!lua_isinteger(L, index)) return false;
+			auto val = lua_tointeger(L, index);
+			if (val < std::numeric_limits<T>::min() || val > std::numeric_limits<T>::max()) return false;
+			value = (T)val;
+			return true;
+		}
+
+		// Accepts enumeration labels only, as the Lua code compares labels
+		template <class TGame, class T>
+		bool GetEnumArg(lua_State* L, int index, T& value)
+		{
+			if (lua_type(L, index) != LUA_TSTRING) return false;
+			auto val = EnumInfo<TGame>::Find(lua_tostring(L, index));
+			if (!val) return false;
+			value = (T)*val;
+			return true;
+		}
+
+		bool GetPositionArg(lua_State* L, int index, double (&position)[3])
+		{
+			if (!lua_istable(L, index)) return false;
+
+			for (auto i = 0; i < 3; i++) {
+				lua_rawgeti(L, index, i + 1);
+				auto isNumber = lua_type(L, -1) == LUA_TNUMBER;
+				position[i] = lua_tonumber(L, -1);
+				lua_pop(L, 1);
+				if (!isNumber) return false;
+			}
+
+			return true;
+		}
+
+		// Reads a field through the metatable of the object (__index of the stats proxies)
+		template <class T, class Fn>
+		bool GetField(lua_State* L, int index, char const* key, T& value, Fn get)
+		{
+			lua_getfield(L, index, key);
+			auto ok = get(L, -1, value);
+			lua_pop(L, 1);
+			return ok;
+		}
+
+		// UseWeaponDamage and OverrideSkillLevel are compared with "Yes"
+		bool GetYesNo(lua_State* L, int index, bool& value)
+		{
+			value = lua_type(L, index) == LUA_TSTRING && strcmp(lua_tostring(L, index), "Yes") == 0;
+			return true;
+		}
+
+		// GetSkillDamage() uses OverrideSkillLevel as a level if the skill level is 0,
+		// which the formulas only reproduce for strings
+		bool GetOverrideSkillLevel(lua_State* L, int index, bool& value)
+		{
+			return lua_type(L, index) == LUA_TSTRING && GetYesNo(L, index, value);
+		}
+
+		// Numbers would make the "skill.Ability == 0" check of the Lua code succeed
+		bool GetSkillAbility(lua_State* L, int index, gamemath::SkillAbility& value)
+		{
+			value = gamemath::SkillAbility::Other;
+			if (lua_isnil(L, index)) return true;
+			if (lua_type(L, index) != LUA_TSTRING) return false;
+
+			auto label = lua_tostring(L, index);
+			if (strcmp(label, "Warrior") == 0) {
+				value = gamemath::SkillAbility::Warrior;
+			} else if (strcmp(label, "Polymorph") == 0) {
+				value = gamemath::SkillAbility::Polymorph;
+			} else if (strcmp(label, "Ranger") == 0) {
+				value = gamemath::SkillAbility::Ranger;
+			} else if (strcmp(label, "Rogue") == 0) {
+				value = gamemath::SkillAbility::Rogue;
+			}
+			return true;
+		}
+
+		bool GetDamageSource(lua_State* L, int index, gamemath::DamageSource& value)
+		{
+			value = gamemath::DamageSource::Unknown;
+			if (lua_isnil(L, index)) return true;
+			if (lua_type(L, index) != LUA_TSTRING) return false;
+
+			auto label = lua_tostring(L, index);
+			for (size_t i = 0; i < std::size(DamageSourceNames); i++) {
+				if (strcmp(label, DamageSourceNames[i]) == 0) {
+					value = (gamemath::DamageSource)i;
+					break;
+				}
+			}
+			return true;
+		}
+
+		// Reads the skill attributes through the skill object (SkillPrototype or stats entry),
+		// so that level scaling applies the same way as in the Lua code
+		bool ReadSkill(lua_State* L, int index, gamemath::Skill& skill)
+		{
+			if (!lua_istable(L, index)
+				&& SkillPrototypeProxy::AsUserData(L, index) == nullptr
+				&& StatsProxy::AsUserData(L, index) == nullptr) {
+				return false;
+			}
+
+			return GetField(L, index, "Damage Multiplier", skill.DamageMultiplier, GetIntegerArg<int32_t>)
+				&& GetField(L, index, "Stealth Damage Multiplier", skill.StealthDamageMultiplier, GetIntegerArg<int32_t>)
+				&& GetField(L, index, "Distance Damage Multiplier", skill.DistanceDamageMultiplier, GetIntegerArg<int32_t>)
+				&& GetField(L, index, "Damage Range", skill.DamageRange, GetIntegerArg<int32_t>)
+				&& GetField(L, index, "Level", skill.Level, GetIntegerArg<int32_t>)
+				&& GetField(L, index, "UseWeaponDamage", skill.UseWeaponDamage, GetYesNo)
+				&& GetField(L, index, "OverrideSkillLevel", skill.OverrideSkillLevel, GetOverrideSkillLevel)
+				&& GetField(L, index, "Ability", skill.Ability, GetSkillAbility)
+				&& GetField(L, index, "Damage", skill.Damage, GetDamageSource)
+				&& GetField(L, index, "DamageType", skill.DamageType, GetEnumArg<DamageType, gamemath::DamageType>)
+				&& GetField(L, index, "DeathType", skill.DeathType, GetEnumArg<DeathType, gamemath::DeathType>);
+		}
+
+		bool ReadDamageList(lua_State* L, int index, gamemath::DamageList& damages)
+		{
+			auto damageList = DamageList::AsUserData(L, index);
+			if (damageList == nullptr) return false;
+
+			for (auto const& dmg : damageList->Get()) {
+				if ((uint32_t)dmg.DamageType > (uint32_t)DamageType::Sentinel) return false;
+				damages.SafeAdd((gamemath::DamageType)dmg.DamageType, dmg.Amount);
+			}
+
+			return true;
+		}
+
+		void WriteDamageList(DamagePairList& damageList, gamemath::DamageList const& damages)
+		{
+			damageList.Clear();
+			for (auto const& dmg : damages.Damages) {
+				damageList.SafeAdd(TDamagePair{ dmg.Amount, (DamageType)dmg.Type });
+			}
+		}
+
+		void PushDamageList(lua_State* L, gamemath::DamageList const& damages)
+		{
+			auto damageList = DamageList::New(L);
+			WriteDamageList(damageList->Get(), damages);
+		}
+
+		void PushNumber(lua_State* L, gamemath::Number const& number)
+		{
+			if (number.Integer) {
+				push(L, (int64_t)number.Value);
+			} else {
+				push(L, number.Value);
+			}
+		}
+
+		bool ReadHit(lua_State* L, int index, gamemath::Hit& hit)
+		{
+			if (!lua_istable(L, index)) return false;
+
+			return GetField(L, index, "EffectFlags", hit.EffectFlags, GetIntegerArg<int64_t>)
+				&& GetField(L, index, "TotalDamageDone", hit.TotalDamageDone, GetIntegerArg<int64_t>)
+				&& GetField(L, index, "ArmorAbsorption", hit.ArmorAbsorption, GetIntegerArg<int64_t>)
+				&& GetField(L, index, "LifeSteal", hit.LifeSteal, GetIntegerArg<int64_t>)
+				&& GetField(L, index, "DamageType", hit.DamageType, GetEnumArg<DamageType, gamemath::DamageType>)
+				&& GetField(L, index, "DamageList", hit.DamageList, ReadDamageList);
+		}
+
+		void WriteHit(lua_State* L, int index, gamemath::Hit const& hit)
+		{
+			setfield(L, "EffectFlags", hit.EffectFlags, index);
+			setfield(L, "TotalDamageDone", hit.TotalDamageDone, index);
+			setfield(L, "ArmorAbsorption", hit.ArmorAbsorption, index);
+			setfield(L, "LifeSteal", hit.LifeSteal, index);
+			setfield(L, "DamageMultiplier", hit.DamageMultiplier, index);
+
+			if (hit.DamageListReplaced) {
+				PushDamageList(L, hit.DamageList);
+				lua_setfield(L, index, "DamageList");
+			}
+		}
+
+		int Unhandled(lua_State* L)
+		{
+			push(L, false);
+			return 1;
+		}
+
+
+		// GetSkillDamage(skill, attacker, isFromItem, stealthed, attackerPos, targetPos, level, noRandomization)
+		//   -> handled, damageList, deathType
+		int GetSkillDamage(lua_State* L)
+		{
+			gamemath::Skill skill;
+			CDivinityStats_Character* attackerStats;
+			bool isFromItem, stealthed, noRandomization;
+			double attackerPos[3], targetPos[3];
+			int32_t level;
+			gamemath::ExtraData extra;
+
+			if (!ReadSkill(L, 1, skill)
+				|| !GetCharacterArg(L, 2, attackerStats)
+				|| !GetBoolArg(L, 3, isFromItem)
+				|| !GetBoolArg(L, 4, stealthed)
+				|| !GetPositionArg(L, 5, attackerPos)
+				|| !GetPositionArg(L, 6, targetPos)
+				|| !GetIntegerArg(L, 7, level)
+				|| !GetBoolArg(L, 8, noRandomization)
+				|| !ReadExtraData(extra)) {
+				return Unhandled(L);
+			}
+
+			std::optional<StatsCharacter> attacker;
+			if (attackerStats != nullptr) {
+				attacker.emplace(attackerStats);
+			}
+
+			LuaEnvironment env(L);
+			std::optional<gamemath::SkillDamage> result;
+			if (!gamemath::GetSkillDamage(env, extra, skill, attacker ? &*attacker : nullptr, isFromItem, stealthed,
+				attackerPos, targetPos, level, noRandomization, result)) {
+				return Unhandled(L);
+			}
+
+			push(L, true);
+			if (!result) {
+				return 1;
+			}
+
+			PushDamageList(L, result->Damage);
+			if (result->Death) {
+				push(L, (DeathType)*result->Death);
+			} else {
+				push(L, nullptr);
+			}
+			return 3;
+		}
+
+		// CalculateWeaponDamage(attacker, weapon, noRandomization) -> handled, damageList
+		int CalculateWeaponDamage(lua_State* L)
+		{
+			CDivinityStats_Character* attackerStats;
+			std::optional<gamemath::Item> weapon;
+			bool noRandomization;
+			gamemath::ExtraData extra;
+
+			if (!GetCharacterArg(L, 1, attackerStats) || attackerStats == nullptr
+				|| !GetItemArg(L, 2, weapon) || !weapon
+				|| !GetBoolArg(L, 3, noRandomization)
+				|| !ReadExtraData(extra)) {
+				return Unhandled(L);
+			}
+
+			StatsCharacter attacker(attackerStats);
+			LuaEnvironment env(L);
+			gamemath::DamageList damageList;
+			if (!gamemath::CalculateWeaponDamage(env, extra, attacker, *weapon, noRandomization, damageList)) {
+				return Unhandled(L);
+			}
+
+			push(L, true);
+			PushDamageList(L, damageList);
+			return 2;
+		}
+
+		// GetSkillDamageRange(character, skill) -> handled, damageRanges
+		int GetSkillDamageRange(lua_State* L)
+		{
+			CDivinityStats_Character* characterStats;
+			gamemath::Skill skill;
+			gamemath::ExtraData extra;
+
+			if (!GetCharacterArg(L, 1, characterStats) || characterStats == nullptr
+				|| !ReadSkill(L, 2, skill)
+				|| !ReadExtraData(extra)) {
+				return Unhandled(L);
+			}
+
+			StatsCharacter character(characterStats);
+			std::vector<gamemath::DamageRange> ranges;
+			if (!gamemath::GetSkillDamageRange(extra, character, skill, ranges)) {
+				return Unhandled(L);
+			}
+
+			push(L, true);
+			lua_newtable(L);
+			for (auto const& range : ranges) {
+				push(L, (DamageType)range.Type);
+				lua_newtable(L);
+				PushNumber(L, range.Min);
+				lua_rawseti(L, -2, 1);
+				PushNumber(L, range.Max);
+				lua_rawseti(L, -2, 2);
+				lua_settable(L, -3);
+			}
+			return 2;
+		}
+
+		// CalculateHitChance(attacker, target) -> handled, hitChance
+		int CalculateHitChance(lua_State* L)
+		{
+			CDivinityStats_Character* attackerStats;
+			CDivinityStats_Character* targetStats;
+			gamemath::ExtraData extra;
+
+			if (!GetCharacterArg(L, 1, attackerStats) || attackerStats == nullptr
+				|| !GetCharacterArg(L, 2, targetStats) || targetStats == nullptr
+				|| !ReadExtraData(extra)) {
+				return Unhandled(L);
+			}
+
+			StatsCharacter attacker(attackerStats), target(targetStats);
+			gamemath::Number hitChance;
+			if (!gamemath::CalculateHitChance(extra, attacker, target, hitChance)) {
+				return Unhandled(L);
+			}
+
+			push(L, true);
+			PushNumber(L, hitChance);
+			return 2;
+		}
+
+		// ComputeCharacterHit(random, durabilityCallback, target, attacker, weapon, damageList, hitType,
+		//   noHitRoll, forceReduceDurability, hit, alwaysBackstab, highGroundFlag, criticalRoll) -> handled
+		// Updates damageList and hit in place.
+		int ComputeCharacterHit(lua_State* L)
+		{
+			CDivinityStats_Character* targetStats;
+			CDivinityStats_Character* attackerStats;
+			std::optional<gamemath::Item> weapon;
+			gamemath::DamageList damages;
+			gamemath::HitType hitType;
+			bool noHitRoll, forceReduceDurability, alwaysBackstab;
+			gamemath::Hit hit;
+			gamemath::HighGroundBonus highGround;
+			gamemath::CriticalRoll criticalRoll;
+			gamemath::ExtraData extra;
+
+			if (!lua_isfunction(L, 1) || !lua_isfunction(L, 2)
+				|| !GetCharacterArg(L, 3, targetStats) || targetStats == nullptr
+				|| !GetCharacterArg(L, 4, attackerStats)
+				|| !GetItemArg(L, 5, weapon)
+				|| !ReadDamageList(L, 6, damages)
+				|| !GetEnumArg<HitType>(L, 7, hitType)
+				|| !GetBoolArg(L, 8, noHitRoll)
+				|| !GetBoolArg(L, 9, forceReduceDurability)
+				|| !ReadHit(L, 10, hit)
+				|| !GetBoolArg(L, 11, alwaysBackstab)
+				|| !GetEnumArg<HighGroundBonus>(L, 12, highGround)
+				|| !GetEnumArg<CriticalRoll>(L, 13, criticalRoll)
+				|| !ReadExtraData(extra)) {
+				return Unhandled(L);
+			}
+
+			StatsCharacter target(targetStats);
+			std::optional<StatsCharacter> attacker;
+			if (attackerStats != nullptr) {
+				attacker.emplace(attackerStats);
+			}
+
+			LuaEnvironment env(L, 1, 2, 4, 5);
+			if (!gamemath::ComputeCharacterHit(env, extra, target, attacker ? &*attacker : nullptr,
+				weapon ? &*weapon : nullptr, damages, hitType, noHitRoll, forceReduceDurability, hit,
+				alwaysBackstab, highGround, criticalRoll)) {
+				return Unhandled(L);
+			}
+
+			WriteDamageList(DamageList::AsUserData(L, 6)->Get(), damages);
+			WriteHit(L, 10, hit);
+			push(L, true);
+			return 1;
+		}
+	}
+
+	void RegisterGameMathLib(lua_State* L)
+	{
+		static const luaL_Reg gameMathLib[] = {
+			{"GetSkillDamage", GetSkillDamage},
+			{"CalculateWeaponDamage", CalculateWeaponDamage},
+			{"GetSkillDamageRange", GetSkillDamageRange},
+			{"CalculateHitChance", CalculateHitChance},
+			{"ComputeCharacterHit", ComputeCharacterHit},
+			{0,0}
+		};
+
+		lua_getglobal(L, "Ext"); // stack: Ext
+		luaL_newlib(L, gameMathLib); // stack: Ext, lib
+		lua_setfield(L, -2, "_GameMath"); // stack: Ext
+		lua_pop(L, 1); // stack: -
+	}
+#else
+	// The formulas depend on the integer/float number subtypes of Lua 5.3;
+	// Game.Math.lua always runs the Lua implementation without Ext._GameMath.
+	void RegisterGameMathLib(lua_State* L)
+	{}
+#endif
+}
@@ -4,6 +4,7 @@
 #include <lua.h>
 #include <lualib.h>
 #include <lauxlib.h>
+#include <Lua/LuaProfiler.h>
 #include <optional>
 
 namespace dse::lua
@@ -513,6 +514,7 @@ namespace dse::lua
 	template <class... Args>
 	auto CheckedCall(lua_State * L, int numArgs, char const * functionName)
 	{
+		ProfilerEventScope profile(L, functionName);
 		if (CallWithTraceback(L, numArgs, sizeof...(Args)) != 0) { // stack: errmsg
 			ERR("%s Lua call failed: %s", functionName, lua_tostring(L, -1));
 			lua_pop(L, 1);
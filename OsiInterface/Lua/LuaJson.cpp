@@ -0,0 +1,826 @@
+#include <stdafx.h>
+#include <Lua/LuaJson.h>
+#include <lauxlib.h>
+#include <algorithm>
+#include <charconv>
+#include <deque>
+#include <cmath>
+#include <emmintrin.h>
+#include <intrin.h>
+
+namespace dse::lua::json
+{
+	// Returns the length of the prefix of s that can be copied without escaping,
+	// ie. contains no control characters, non-ASCII characters, quotes or backslashes
+	inline std::size_t ScanUnescapedPrefix(char const* s, std::size_t len)
+	{
+		std::size_t i = 0;
+		auto const quote = _mm_set1_epi8('"');
+		auto const backslash = _mm_set1_epi8('\\');
+		// Signed compare; matches both control characters and bytes >= 0x80
+		auto const space = _mm_set1_epi8(0x20);
+		for (; i + 16 <= len; i += 16) {
+			auto v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(s + i));
+			auto special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+				_mm_cmplt_epi8(v, space));
+			auto mask = (unsigned long)_mm_movemask_epi8(special);
+			if (mask != 0) {
+				unsigned long bit;
+				_BitScanForward(&bit, mask);
+				return i + bit;
+			}
+		}
+
+		for (; i < len; i++) {
+			auto c = (uint8_t)s[i];
+			if (c < 0x20 || c >= 0x80 || c == '"' || c == '\\') break;
+		}
+
+		return i;
+	}
+
+	// Returns the length of the prefix of s that contains no quotes or backslashes
+	inline std::size_t ScanStringBody(char const* s, std::size_t len)
+	{
+		std::size_t i = 0;
+		auto const quote = _mm_set1_epi8('"');
+		auto const backslash = _mm_set1_epi8('\\');
+		for (; i + 16 <= len; i += 16) {
+			auto v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(s + i));
+			auto special = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash));
+			auto mask = (unsigned long)_mm_movemask_epi8(special);
+			if (mask != 0) {
+				unsigned long bit;
+				_BitScanForward(&bit, mask);
+				return i + bit;
+			}
+		}
+
+		for (; i < len && s[i] != '"' && s[i] != '\\'; i++) {}
+		return i;
+	}
+
+
+	class Writer
+	{
+	public:
+		Writer(lua_State* L, bool stringifyInternalTypes, STDString& out)
+			: L_(L), stringifyInternalTypes_(stringifyInternalTypes), out_(out)
+		{}
+
+		void WriteRoot(int index)
+		{
+			indented_ = true;
+			WriteValue(index, 0);
+		}
+
+	private:
+		struct Member
+		{
+			// Key as written to the output (truncated at the first NUL, like jsoncpp's const char* lookup)
+			char const* Key;
+			std::size_t KeyLength;
+			// Original Lua key, needed to fetch the value after sorting
+			int KeyType;
+			char const* RawKey;
+			std::size_t RawKeyLength;
+			lua_Integer IntKey;
+			lua_Number NumKey;
+		};
+
+		lua_State* L_;
+		bool stringifyInternalTypes_;
+		STDString& out_;
+		STDString indentString_;
+		bool indented_{ false };
+		// Backing storage for stringified numeric keys; deque keeps pointers stable
+		std::deque<std::string> numericKeys_;
+
+		// The following functions mirror jsoncpp's BuiltStyledStreamWriter
+		// with "\t" indentation and comments enabled
+		void WriteIndent()
+		{
+			out_ += '\n';
+			out_ += indentString_;
+		}
+
+		void WriteWithIndent(char const* s, std::size_t len)
+		{
+			if (!indented_) WriteIndent();
+			out_.append(s, len);
+			indented_ = false;
+		}
+
+		void WriteValue(int index, int depth)
+		{
+			if (depth > 64) {
+				throw std::runtime_error("Recursion depth exceeded while stringifying JSON");
+			}
+
+			switch (lua_type(L_, index)) {
+			case LUA_TNIL:
+				out_ += "null";
+				break;
+
+			case LUA_TBOOLEAN:
+				out_ += lua_toboolean(L_, index) ? "true" : "false";
+				break;
+
+			case LUA_TNUMBER:
+#if LUA_VERSION_NUM > 501
+				if (lua_isinteger(L_, index)) {
+					WriteInteger(lua_tointeger(L_, index));
+				} else {
+					WriteDouble(lua_tonumber(L_, index));
+				}
+#else
+				WriteDouble(lua_tonumber(L_, index));
+#endif
+				break;
+
+			case LUA_TSTRING:
+			{
+				auto str = lua_tostring(L_, index);
+				WriteQuotedString(out_, str, strlen(str));
+				break;
+			}
+
+			case LUA_TTABLE:
+				WriteTable(index, depth);
+				break;
+
+			case LUA_TLIGHTUSERDATA:
+			case LUA_TFUNCTION:
+			case LUA_TUSERDATA:
+			case LUA_TTHREAD:
+				if (stringifyInternalTypes_) {
+					auto str = luaL_tolstring(L_, index, NULL);
+					WriteQuotedString(out_, str, strlen(str));
+					lua_pop(L_, 1);
+				} else {
+					throw std::runtime_error("Attempted to stringify a lightuserdata, userdata, function or thread value");
+				}
+				break;
+
+			default:
+				throw std::runtime_error("Attempted to stringify an unknown type");
+			}
+		}
+
+		void WriteInteger(int64_t value)
+		{
+			char buf[32];
+			auto result = std::to_chars(buf, buf + sizeof(buf), value);
+			out_.append(buf, result.ptr - buf);
+		}
+
+		void WriteDouble(double value)
+		{
+			if (!std::isfinite(value)) {
+				out_ += std::isnan(value) ? "null" : (value < 0 ? "-1e+9999" : "1e+9999");
+				return;
+			}
+
+			// Same as snprintf("%.17g"), which is what jsoncpp uses
+			char buf[64];
+			auto result = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::general, 17);
+			std::string_view str(buf, result.ptr - buf);
+			out_ += str;
+			if (str.find('.') == std::string_view::npos && str.find('e') == std::string_view::npos) {
+				out_ += ".0";
+			}
+		}
+
+		static void WriteHex(STDString& out, unsigned ch)
+		{
+			static char const hex[] = "0123456789abcdef";
+			char buf[6] = { '\\', 'u', hex[(ch >> 12) & 0xf], hex[(ch >> 8) & 0xf], hex[(ch >> 4) & 0xf], hex[ch & 0xf] };
+			out.append(buf, 6);
+		}
+
+		static unsigned DecodeUTF8(char const*& s, char const* e)
+		{
+			const unsigned ReplacementCharacter = 0xFFFD;
+			unsigned firstByte = (uint8_t)*s;
+			if (firstByte < 0x80) return firstByte;
+
+			if (firstByte < 0xE0) {
+				if (e - s < 2) return ReplacementCharacter;
+				unsigned cp = ((firstByte & 0x1F) << 6) | ((uint8_t)s[1] & 0x3F);
+				s += 1;
+				return cp < 0x80 ? ReplacementCharacter : cp;
+			}
+
+			if (firstByte < 0xF0) {
+				if (e - s < 3) return ReplacementCharacter;
+				unsigned cp = ((firstByte & 0x0F) << 12) | (((uint8_t)s[1] & 0x3F) << 6) | ((uint8_t)s[2] & 0x3F);
+				s += 2;
+				if (cp >= 0xD800 && cp <= 0xDFFF) return ReplacementCharacter;
+				return cp < 0x800 ? ReplacementCharacter : cp;
+			}
+
+			if (firstByte < 0xF8) {
+				if (e - s < 4) return ReplacementCharacter;
+				unsigned cp = ((firstByte & 0x07) << 18) | (((uint8_t)s[1] & 0x3F) << 12)
+					| (((uint8_t)s[2] & 0x3F) << 6) | ((uint8_t)s[3] & 0x3F);
+				s += 3;
+				return cp < 0x10000 ? ReplacementCharacter : cp;
+			}
+
+			return ReplacementCharacter;
+		}
+
+		static void WriteQuotedString(STDString& out, char const* s, std::size_t len)
+		{
+			out += '"';
+			auto end = s + len;
+			while (s < end) {
+				auto plain = ScanUnescapedPrefix(s, end - s);
+				out.append(s, plain);
+				s += plain;
+				if (s == end) break;
+
+				switch (*s) {
+				case '"': out += "\\\""; break;
+				case '\\': out += "\\\\"; break;
+				case '\b': out += "\\b"; break;
+				case '\f': out += "\\f"; break;
+				case '\n': out += "\\n"; break;
+				case '\r': out += "\\r"; break;
+				case '\t': out += "\\t"; break;
+				default:
+				{
+					// Remaining control characters and all non-ASCII codepoints are \u escaped
+					auto cp = DecodeUTF8(s, end);
+					if (cp < 0x10000) {
+						WriteHex(out, cp);
+					} else {
+						cp -= 0x10000;
+						WriteHex(out, 0xD800 + ((cp >> 10) & 0x3FF));
+						WriteHex(out, 0xDC00 + (cp & 0x3FF));
+					}
+					break;
+				}
+				}
+
+				s++;
+			}
+
+			out += '"';
+		}
+
+		bool IsArray(int index, int& size)
+		{
+			lua_pushnil(L_);
+			if (index < 0) index--;
+
+			int next = 1;
+			bool isArray = true;
+			while (lua_next(L_, index) != 0) {
+#if LUA_VERSION_NUM > 501
+				if (!lua_isinteger(L_, -2) || lua_tointeger(L_, -2) != next++) {
+					isArray = false;
+				}
+#else
+				if (!lua_isnumber(L_, -2) || lua_tonumber(L_, -2) != next++) {
+					isArray = false;
+				}
+#endif
+
+				lua_pop(L_, 1);
+				if (!isArray) {
+					lua_pop(L_, 1);
+					break;
+				}
+			}
+
+			size = next - 1;
+			return isArray;
+		}
+
+		void WriteTable(int index, int depth)
+		{
+			luaL_checkstack(L_, 4, "JSON nesting too deep");
+			if (index < 0) {
+				index = lua_gettop(L_) + index + 1;
+			}
+
+			int size;
+			if (IsArray(index, size)) {
+				WriteArray(index, size, depth);
+			} else {
+				WriteObject(index, depth);
+			}
+		}
+
+		void WriteArray(int index, int size, int depth)
+		{
+			if (size == 0) {
+				out_ += "[]";
+				return;
+			}
+
+			WriteWithIndent("[", 1);
+			indentString_ += '\t';
+			for (int i = 1; i <= size; i++) {
+				lua_rawgeti(L_, index, i);
+				if (!indented_) WriteIndent();
+				indented_ = true;
+				WriteValue(-1, depth + 1);
+				indented_ = false;
+				lua_pop(L_, 1);
+
+				if (i < size) {
+					out_ += ',';
+				}
+			}
+
+			indentString_.pop_back();
+			WriteWithIndent("]", 1);
+		}
+
+		void WriteObject(int index, int depth)
+		{
+			std::vector<Member> members;
+			lua_pushnil(L_);
+			while (lua_next(L_, index) != 0) {
+				Member member;
+				member.KeyType = lua_type(L_, -2);
+				if (member.KeyType == LUA_TSTRING) {
+					member.RawKey = lua_tolstring(L_, -2, &member.RawKeyLength);
+					member.Key = member.RawKey;
+					member.KeyLength = strlen(member.RawKey);
+				} else if (member.KeyType == LUA_TNUMBER) {
+#if LUA_VERSION_NUM > 501
+					if (lua_isinteger(L_, -2)) {
+						member.IntKey = lua_tointeger(L_, -2);
+						member.KeyType = LUA_NUMTAGS;
+					} else
+#endif
+					{
+						member.NumKey = lua_tonumber(L_, -2);
+					}
+
+					// Same conversion as lua_tostring(), so integral floats keep their ".0" suffix
+					lua_pushvalue(L_, -2);
+					numericKeys_.emplace_back(lua_tostring(L_, -1));
+					lua_pop(L_, 1);
+					member.Key = numericKeys_.back().c_str();
+					member.KeyLength = numericKeys_.back().size();
+				} else {
+					lua_pop(L_, 2);
+					throw std::runtime_error("Can only stringify string or number table keys");
+				}
+
+				members.push_back(member);
+				lua_pop(L_, 1);
+			}
+
+			if (members.empty()) {
+				out_ += "{}";
+				return;
+			}
+
+			// jsoncpp stores members in a map ordered by memcmp(); for duplicate keys
+			// (eg. 1 and "1") the last assignment in traversal order wins
+			std::stable_sort(members.begin(), members.end(), [](Member const& a, Member const& b) {
+				auto cmp = memcmp(a.Key, b.Key, std::min(a.KeyLength, b.KeyLength));
+				return cmp < 0 || (cmp == 0 && a.KeyLength < b.KeyLength);
+			});
+
+			WriteWithIndent("{", 1);
+			indentString_ += '\t';
+			bool first = true;
+			for (std::size_t i = 0; i < members.size(); i++) {
+				auto const& member = members[i];
+				if (i + 1 < members.size()
+					&& members[i + 1].KeyLength == member.KeyLength
+					&& memcmp(members[i + 1].Key, member.Key, member.KeyLength) == 0) {
+					continue;
+				}
+
+				if (!first) {
+					out_ += ',';
+				}
+				first = false;
+
+				STDString key;
+				WriteQuotedString(key, member.Key, member.KeyLength);
+				WriteWithIndent(key.c_str(), key.size());
+				out_ += " : ";
+
+				switch (member.KeyType) {
+				case LUA_TSTRING: lua_pushlstring(L_, member.RawKey, member.RawKeyLength); break;
+#if LUA_VERSION_NUM > 501
+				case LUA_NUMTAGS: lua_pushinteger(L_, member.IntKey); break;
+#endif
+				default: lua_pushnumber(L_, member.NumKey); break;
+				}
+
+				lua_rawget(L_, index);
+				WriteValue(-1, depth + 1);
+				lua_pop(L_, 1);
+			}
+
+			indentString_.pop_back();
+			WriteWithIndent("}", 1);
+		}
+	};
+
+
+	void Stringify(lua_State* L, int index, bool stringifyInternalTypes, STDString& out)
+	{
+		if (index < 0) {
+			index = lua_gettop(L) + index + 1;
+		}
+
+		Writer writer(L, stringifyInternalTypes, out);
+		writer.WriteRoot(index);
+	}
+
+
+	class Reader
+	{
+	public:
+		static constexpr int StackLimit = 1000;
+
+		Reader(lua_State* L, StringView json)
+			: L_(L), begin_(json.data()), cur_(json.data()), end_(json.data() + json.size())
+		{}
+
+		bool ParseRoot(STDString& error)
+		{
+			// Skip UTF-8 BOM
+			if (end_ - cur_ >= 3 && memcmp(cur_, "\xEF\xBB\xBF", 3) == 0) {
+				cur_ += 3;
+			}
+
+			int top = lua_gettop(L_);
+			if (!ParseValue(0)) {
+				lua_settop(L_, top);
+				FormatError(error);
+				return false;
+			}
+
+			return true;
+		}
+
+	private:
+		lua_State* L_;
+		char const* begin_;
+		char const* cur_;
+		char const* end_;
+		char const* errorPos_{ nullptr };
+		char const* errorMsg_{ nullptr };
+		STDString buf_;
+
+		bool Fail(char const* msg, char const* pos)
+		{
+			errorMsg_ = msg;
+			errorPos_ = pos;
+			return false;
+		}
+
+		void FormatError(STDString& error)
+		{
+			int line = 1;
+			auto lineStart = begin_;
+			for (auto p = begin_; p < errorPos_; p++) {
+				if (*p == '\n') {
+					line++;
+					lineStart = p + 1;
+				}
+			}
+
+			char location[64];
+			sprintf_s(location, "* Line %d, Column %d\n  ", line, (int)(errorPos_ - lineStart) + 1);
+			error = location;
+			error += errorMsg_;
+			error += "\n";
+		}
+
+		bool SkipWhitespace()
+		{
+			while (cur_ < end_) {
+				auto c = *cur_;
+				if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+					cur_++;
+				} else if (c == '/' && cur_ + 1 < end_ && cur_[1] == '*') {
+					auto commentEnd = std::search(cur_ + 2, end_, "*/", "*/" + 2);
+					if (commentEnd == end_) {
+						return Fail("Syntax error: value, object or array expected.", cur_);
+					}
+					cur_ = commentEnd + 2;
+				} else if (c == '/' && cur_ + 1 < end_ && cur_[1] == '/') {
+					while (cur_ < end_ && *cur_ != '\n' && *cur_ != '\r') cur_++;
+				} else {
+					break;
+				}
+			}
+
+			return true;
+		}
+
+		bool Match(char const* literal, std::size_t len)
+		{
+			if ((std::size_t)(end_ - cur_) < len || memcmp(cur_, literal, len) != 0) {
+				return false;
+			}
+
+			cur_ += len;
+			return true;
+		}
+
+		bool ParseValue(int depth)
+		{
+			if (depth > StackLimit) {
+				return Fail("Exceeded stackLimit in readValue().", cur_);
+			}
+
+			if (!SkipWhitespace()) return false;
+			if (cur_ == end_) {
+				return Fail("Syntax error: value, object or array expected.", cur_);
+			}
+
+			switch (*cur_) {
+			case '{': return ParseObject(depth);
+			case '[': return ParseArray(depth);
+			case '"': return ParseString();
+			case 't':
+				if (!Match("true", 4)) break;
+				lua_pushboolean(L_, 1);
+				return true;
+			case 'f':
+				if (!Match("false", 5)) break;
+				lua_pushboolean(L_, 0);
+				return true;
+			case 'n':
+				if (!Match("null", 4)) break;
+				lua_pushnil(L_);
+				return true;
+			default:
+				if (*cur_ == '-' || (*cur_ >= '0' && *cur_ <= '9')) {
+					return ParseNumber();
+				}
+				break;
+			}
+
+			return Fail("Syntax error: value, object or array expected.", cur_);
+		}
+
+		bool ParseObject(int depth)
+		{
+			luaL_checkstack(L_, 3, "JSON nesting too deep");
+			lua_newtable(L_);
+			cur_++;
+
+			for (;;) {
+				if (!SkipWhitespace()) return false;
+				if (cur_ < end_ && *cur_ == '}') {
+					cur_++;
+					return true;
+				}
+
+				if (cur_ == end_ || *cur_ != '"') {
+					return Fail("Missing '}' or object member name", cur_);
+				}
+
+				if (!ParseString()) return false;
+				if (!SkipWhitespace()) return false;
+				if (cur_ == end_ || *cur_ != ':') {
+					return Fail("Missing ':' after object member name", cur_);
+				}
+
+				cur_++;
+				if (!ParseValue(depth + 1)) return false;
+				lua_rawset(L_, -3);
+
+				if (!SkipWhitespace()) return false;
+				if (cur_ < end_ && *cur_ == ',') {
+					cur_++;
+				} else if (cur_ < end_ && *cur_ == '}') {
+					cur_++;
+					return true;
+				} else {
+					return Fail("Missing ',' or '}' in object declaration", cur_);
+				}
+			}
+		}
+
+		bool ParseArray(int depth)
+		{
+			luaL_checkstack(L_, 3, "JSON nesting too deep");
+			lua_newtable(L_);
+			cur_++;
+
+			lua_Integer index = 1;
+			for (;;) {
+				if (!SkipWhitespace()) return false;
+				if (cur_ < end_ && *cur_ == ']') {
+					cur_++;
+					return true;
+				}
+
+				if (!ParseValue(depth + 1)) return false;
+				lua_rawseti(L_, -2, index++);
+
+				if (!SkipWhitespace()) return false;
+				if (cur_ < end_ && *cur_ == ',') {
+					cur_++;
+				} else if (cur_ < end_ && *cur_ == ']') {
+					cur_++;
+					return true;
+				} else {
+					return Fail("Missing ',' or ']' in array declaration", cur_);
+				}
+			}
+		}
+
+		bool ParseNumber()
+		{
+			auto start = cur_;
+			auto p = cur_;
+			if (*p == '-') p++;
+			while (p < end_ && *p >= '0' && *p <= '9') p++;
+			bool isDouble = false;
+			if (p < end_ && *p == '.') {
+				isDouble = true;
+				p++;
+				while (p < end_ && *p >= '0' && *p <= '9') p++;
+			}
+
+			if (p < end_ && (*p == 'e' || *p == 'E')) {
+				isDouble = true;
+				p++;
+				if (p < end_ && (*p == '+' || *p == '-')) p++;
+				while (p < end_ && *p >= '0' && *p <= '9') p++;
+			}
+
+			cur_ = p;
+
+			if (!isDouble) {
+				bool negative = (*start == '-');
+				auto digits = negative ? start + 1 : start;
+				uint64_t value = 0;
+				bool overflow = false;
+				for (auto d = digits; d < p; d++) {
+					unsigned digit = *d - '0';
+					if (value > (UINT64_MAX - digit) / 10) {
+						overflow = true;
+						break;
+					}
+					value = value * 10 + digit;
+				}
+
+				// Values that don't fit into int64/uint64 are parsed as doubles, like in jsoncpp
+				if (!overflow && (!negative || value <= (uint64_t)INT64_MAX + 1)) {
+					// uint64 values above INT64_MAX wrap around, same as the old (int64_t)asUInt64() conversion
+					lua_pushinteger(L_, negative ? (lua_Integer)(0 - value) : (lua_Integer)value);
+					return true;
+				}
+			}
+
+			double value = 0.0;
+			auto result = std::from_chars(start, p, value);
+			if (result.ec == std::errc::result_out_of_range) {
+				auto exp = std::find_if(start, p, [](char c) { return c == 'e' || c == 'E'; });
+				bool underflow = exp != p && exp + 1 < p && exp[1] == '-';
+				value = underflow ? 0.0 : (*start == '-' ? -HUGE_VAL : HUGE_VAL);
+			} else if (result.ec != std::errc() || result.ptr != p) {
+				return Fail("Syntax error: value, object or array expected.", start);
+			}
+
+			lua_pushnumber(L_, value);
+			return true;
+		}
+
+		static bool DecodeHex4(char const* p, unsigned& value)
+		{
+			value = 0;
+			for (int i = 0; i < 4; i++) {
+				auto c = p[i];
+				value <<= 4;
+				if (c >= '0' && c <= '9') value += c - '0';
+				else if (c >= 'a' && c <= 'f') value += c - 'a' + 10;
+				else if (c >= 'A' && c <= 'F') value += c - 'A' + 10;
+				else return false;
+			}
+
+			return true;
+		}
+
+		static void AppendUTF8(STDString& out, unsigned cp)
+		{
+			if (cp <= 0x7F) {
+				out += (char)cp;
+			} else if (cp <= 0x7FF) {
+				out += (char)(0xC0 | (0x1F & (cp >> 6)));
+				out += (char)(0x80 | (0x3F & cp));
+			} else if (cp <= 0xFFFF) {
+				out += (char)(0xE0 | (0xF & (cp >> 12)));
+				out += (char)(0x80 | (0x3F & (cp >> 6)));
+				out += (char)(0x80 | (0x3F & cp));
+			} else if (cp <= 0x10FFFF) {
+				out += (char)(0xF0 | (0x7 & (cp >> 18)));
+				out += (char)(0x80 | (0x3F & (cp >> 12)));
+				out += (char)(0x80 | (0x3F & (cp >> 6)));
+				out += (char)(0x80 | (0x3F & cp));
+			}
+		}
+
+		// Strings are pushed up to the first NUL character, matching the old
+		// Json::Value::asCString() based conversion
+		void PushTruncatedString(char const* s, std::size_t len)
+		{
+			auto nul = (char const*)memchr(s, 0, len);
+			lua_pushlstring(L_, s, nul ? (nul - s) : len);
+		}
+
+		bool ParseString()
+		{
+			auto start = ++cur_;
+			auto plain = ScanStringBody(cur_, end_ - cur_);
+			cur_ += plain;
+			if (cur_ < end_ && *cur_ == '"') {
+				// Fast path: no escape sequences, push directly from the input buffer
+				PushTruncatedString(start, plain);
+				cur_++;
+				return true;
+			}
+
+			buf_.assign(start, plain);
+			while (cur_ < end_) {
+				auto c = *cur_;
+				if (c == '"') {
+					cur_++;
+					PushTruncatedString(buf_.data(), buf_.size());
+					return true;
+				}
+
+				if (c != '\\') {
+					auto run = ScanStringBody(cur_, end_ - cur_);
+					buf_.append(cur_, run);
+					cur_ += run;
+					continue;
+				}
+
+				auto escapeStart = cur_;
+				if (++cur_ == end_) {
+					break;
+				}
+
+				switch (*cur_++) {
+				case '"': buf_ += '"'; break;
+				case '/': buf_ += '/'; break;
+				case '\\': buf_ += '\\'; break;
+				case 'b': buf_ += '\b'; break;
+				case 'f': buf_ += '\f'; break;
+				case 'n': buf_ += '\n'; break;
+				case 'r': buf_ += '\r'; break;
+				case 't': buf_ += '\t'; break;
+				case 'u':
+				{
+					unsigned cp;
+					if (end_ - cur_ < 4) {
+						return Fail("Bad unicode escape sequence in string: four digits expected.", escapeStart);
+					}
+					if (!DecodeHex4(cur_, cp)) {
+						return Fail("Bad unicode escape sequence in string: hexadecimal digit expected.", escapeStart);
+					}
+					cur_ += 4;
+
+					if (cp >= 0xD800 && cp <= 0xDBFF) {
+						if (end_ - cur_ < 6) {
+							return Fail("additional six characters expected to parse unicode surrogate pair.", escapeStart);
+						}
+
+						unsigned low;
+						if (cur_[0] != '\\' || cur_[1] != 'u') {
+							return Fail("expecting another \\u token to begin the second half of a unicode surrogate pair", escapeStart);
+						}
+						if (!DecodeHex4(cur_ + 2, low)) {
+							return Fail("Bad unicode escape sequence in string: hexadecimal digit expected.", escapeStart);
+						}
+						cur_ += 6;
+						cp = 0x10000 + ((cp & 0x3FF) << 10) + (low & 0x3FF);
+					}
+
+					AppendUTF8(buf_, cp);
+					break;
+				}
+				default:
+					return Fail("Bad escape sequence in string", escapeStart);
+				}
+			}
+
+			return Fail("Missing '\"' at end of string", start - 1);
+		}
+	};
+
+
+	bool Parse(lua_State* L, StringView json, STDString& error)
+	{
+		Reader reader(L, json);
+		return reader.ParseRoot(error);
+	}
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <GameDefinitions/BaseTypes.h>
+#include <lua.h>
+
+namespace dse::lua::json
+{
+	// Serializes the Lua value at the specified stack index to JSON text.
+	// The output is byte-for-byte identical to what jsoncpp's StreamWriterBuilder
+	// (default settings) produces for the equivalent Json::Value tree.
+	// Throws std::runtime_error if the value cannot be serialized.
+	void Stringify(lua_State* L, int index, bool stringifyInternalTypes, STDString& out);
+
+	// Parses JSON text directly onto the Lua stack (pushes one value).
+	// Accepts the same input as jsoncpp's CharReaderBuilder with default settings.
+	// Returns false and pushes nothing if the document is malformed.
+	bool Parse(lua_State* L, StringView json, STDString& error);
+}
@@ -840,6 +840,7 @@ namespace dse::esv::lua
 			param = param->NextParam;
 		}
 
+		ProfilerEventScope profile(L, Name().c_str());
 		if (CallWithTraceback(lua->GetState(), numParams, 0) != 0) {
 			OsiError("Handler for '" << Name() << "' failed: " << lua_tostring(L, -1));
 			lua_pop(L, 1);
@@ -906,6 +907,7 @@ namespace dse::esv::lua
 			paramIndex++;
 		}
 
+		ProfilerEventScope profile(L, name);
 		if (CallWithTraceback(L, numParams, LUA_MULTRET) != 0) {
 			OsiError("Handler for '" << name << "' failed: " << lua_tostring(L, -1));
 			lua_pop(L, 1);
@@ -0,0 +1,521 @@
+#include <stdafx.h>
+#include <Lua/LuaPersistentVars.h>
+#include <lauxlib.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+namespace dse::lua::persistence
+{
+	namespace
+	{
+		// Same nesting limit as Ext.JsonStringify()
+		constexpr int MaxDepth = 64;
+
+		constexpr uint32_t BlobMagic = 0x56505345; // 'ESPV'
+		constexpr uint32_t BlobVersion = 1;
+
+		enum class Tag : uint8_t
+		{
+			False = 1,
+			True = 2,
+			Integer = 3,
+			Number = 4,
+			// New string; also appended to the string table
+			String = 5,
+			// Reference to a previously written string
+			StringRef = 6,
+			// Followed by the table size and the key/value pairs
+			Table = 7
+		};
+
+		// Table sizes are written as a fixed-width varint, so they can be filled in
+		// after the table was traversed
+		constexpr std::size_t TableSizeBytes = 4;
+		constexpr uint32_t MaxTableSize = (1 << (7 * TableSizeBytes - 1)) - 1;
+
+		inline int AbsIndex(lua_State* L, int index)
+		{
+			return (index > 0 || index <= LUA_REGISTRYINDEX) ? index : lua_gettop(L) + index + 1;
+		}
+
+
+		// Hashes the values that Writer would write. Table entries are combined independently of
+		// their order, so a table hashes the same after it was saved and loaded again.
+		class Hasher
+		{
+		public:
+			Hasher(lua_State* L)
+				: L_(L)
+			{}
+
+			bool Hash(int index, uint64_t& hash)
+			{
+				hash = Seed;
+				return HashValue(index, 0, false, hash);
+			}
+
+		private:
+			static constexpr uint64_t Seed = 0x9E3779B97F4A7C15ull;
+
+			lua_State* L_;
+
+			static inline void Add(uint64_t& hash, uint64_t value)
+			{
+				hash = (hash ^ value) * 0xBF58476D1CE4E5B9ull;
+				hash ^= hash >> 31;
+			}
+
+			static void AddString(uint64_t& hash, char const* str, std::size_t len)
+			{
+				Add(hash, len);
+
+				std::size_t i = 0;
+				uint64_t word;
+				for (; i + sizeof(word) <= len; i += sizeof(word)) {
+					memcpy(&word, str + i, sizeof(word));
+					Add(hash, word);
+				}
+
+				if (i < len) {
+					word = 0;
+					memcpy(&word, str + i, len - i);
+					Add(hash, word);
+				}
+			}
+
+			void AddNumber(uint64_t& hash, int index)
+			{
+#if LUA_VERSION_NUM > 501
+				if (lua_isinteger(L_, index)) {
+					Add(hash, (uint64_t)Tag::Integer);
+					Add(hash, (uint64_t)lua_tointeger(L_, index));
+					return;
+				}
+#endif
+
+				double value = lua_tonumber(L_, index);
+				uint64_t bits;
+				memcpy(&bits, &value, sizeof(bits));
+				Add(hash, (uint64_t)Tag::Number);
+				Add(hash, bits);
+			}
+
+			bool HashValue(int index, int depth, bool isKey, uint64_t& hash)
+			{
+				switch (lua_type(L_, index)) {
+				case LUA_TBOOLEAN:
+					Add(hash, (uint64_t)(lua_toboolean(L_, index) ? Tag::True : Tag::False));
+					return true;
+
+				case LUA_TNUMBER:
+					AddNumber(hash, index);
+					return true;
+
+				case LUA_TSTRING:
+				{
+					std::size_t len;
+					auto str = lua_tolstring(L_, index, &len);
+					Add(hash, (uint64_t)Tag::String);
+					AddString(hash, str, len);
+					return true;
+				}
+
+				case LUA_TTABLE:
+					return !isKey && HashTable(index, depth, hash);
+
+				default:
+					return false;
+				}
+			}
+
+			bool HashTable(int index, int depth, uint64_t& hash)
+			{
+				if (depth > MaxDepth || !lua_checkstack(L_, 3)) {
+					return false;
+				}
+
+				index = AbsIndex(L_, index);
+
+				uint64_t size = 0, entries = 0;
+				lua_pushnil(L_);
+				while (lua_next(L_, index) != 0) {
+					uint64_t entry = Seed;
+					if (!HashValue(-2, depth + 1, true, entry) || !HashValue(-1, depth + 1, false, entry)) {
+						lua_pop(L_, 2);
+						return false;
+					}
+
+					// Finalize each entry before summing, so entries can't cancel each other out
+					entry ^= entry >> 32;
+					entry *= 0x94D049BB133111EBull;
+					entry ^= entry >> 29;
+					entries += entry;
+					lua_pop(L_, 1);
+					size++;
+				}
+
+				Add(hash, (uint64_t)Tag::Table);
+				Add(hash, size);
+				Add(hash, entries);
+				return true;
+			}
+		};
+
+
+		class Writer
+		{
+		public:
+			Writer(lua_State* L, STDString& out)
+				: L_(L), out_(out)
+			{}
+
+			void Write(int index)
+			{
+				WriteUInt32(BlobMagic);
+				WriteUInt32(BlobVersion);
+				WriteValue(index, 0, false);
+			}
+
+		private:
+			lua_State* L_;
+			STDString& out_;
+			// Lua strings stay alive while they're referenced from the tree being serialized,
+			// so keys can point to the string data owned by Lua
+			std::unordered_map<std::string_view, uint32_t> strings_;
+
+			inline void WriteTag(Tag tag)
+			{
+				out_ += (char)tag;
+			}
+
+			void WriteUInt32(uint32_t value)
+			{
+				out_.append(reinterpret_cast<char const*>(&value), sizeof(value));
+			}
+
+			void WriteVarint(uint64_t value)
+			{
+				char buf[10];
+				std::size_t len = 0;
+				while (value >= 0x80) {
+					buf[len++] = (char)(value | 0x80);
+					value >>= 7;
+				}
+
+				buf[len++] = (char)value;
+				out_.append(buf, len);
+			}
+
+			void WriteString(int index)
+			{
+				std::size_t len;
+				auto str = lua_tolstring(L_, index, &len);
+				std::string_view key(str, len);
+				auto it = strings_.find(key);
+				if (it != strings_.end()) {
+					WriteTag(Tag::StringRef);
+					WriteVarint(it->second);
+				} else {
+					strings_.insert(std::make_pair(key, (uint32_t)strings_.size()));
+					WriteTag(Tag::String);
+					WriteVarint(len);
+					out_.append(str, len);
+				}
+			}
+
+			void WriteNumber(int index)
+			{
+#if LUA_VERSION_NUM > 501
+				if (lua_isinteger(L_, index)) {
+					auto value = (int64_t)lua_tointeger(L_, index);
+					WriteTag(Tag::Integer);
+					WriteVarint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+					return;
+				}
+#endif
+
+				double value = lua_tonumber(L_, index);
+				WriteTag(Tag::Number);
+				out_.append(reinterpret_cast<char const*>(&value), sizeof(value));
+			}
+
+			void WriteValue(int index, int depth, bool isKey)
+			{
+				switch (lua_type(L_, index)) {
+				case LUA_TBOOLEAN:
+					WriteTag(lua_toboolean(L_, index) ? Tag::True : Tag::False);
+					break;
+
+				case LUA_TNUMBER:
+					WriteNumber(index);
+					break;
+
+				case LUA_TSTRING:
+					WriteString(index);
+					break;
+
+				case LUA_TTABLE:
+					if (isKey) {
+						throw std::runtime_error("Can only serialize string, number or boolean table keys");
+					}
+
+					WriteTable(index, depth);
+					break;
+
+				default:
+					throw std::runtime_error(STDString("Cannot serialize values of type ") + lua_typename(L_, lua_type(L_, index)));
+				}
+			}
+
+			void WriteTable(int index, int depth)
+			{
+				if (depth > MaxDepth) {
+					throw std::runtime_error("Recursion depth exceeded while serializing persistent variables");
+				}
+
+				if (!lua_checkstack(L_, 4)) {
+					throw std::runtime_error("Persistent variables nested too deep");
+				}
+
+				index = AbsIndex(L_, index);
+				WriteTag(Tag::Table);
+				auto sizePos = out_.size();
+				out_.append(TableSizeBytes, '\0');
+
+				uint32_t size = 0, integerKeys = 0;
+				lua_pushnil(L_);
+				while (lua_next(L_, index) != 0) {
+#if LUA_VERSION_NUM > 501
+					if (lua_isinteger(L_, -2)) integerKeys++;
+#endif
+					WriteValue(-2, depth + 1, true);
+					WriteValue(-1, depth + 1, false);
+					lua_pop(L_, 1);
+					size++;
+				}
+
+				if (size > MaxTableSize) {
+					throw std::runtime_error("Table too large to serialize");
+				}
+
+				// Lowest bit tells the reader whether the table should be preallocated as an array
+				uint32_t sizeInfo = (size << 1) | (size > 0 && integerKeys == size ? 1 : 0);
+				for (std::size_t i = 0; i < TableSizeBytes; i++) {
+					auto byte = (sizeInfo >> (7 * i)) & 0x7f;
+					out_[sizePos + i] = (char)(i + 1 < TableSizeBytes ? (byte | 0x80) : byte);
+				}
+			}
+		};
+
+
+		class Reader
+		{
+		public:
+			Reader(lua_State* L, StringView blob, int stringsIndex)
+				: L_(L), pos_(blob.data()), end_(blob.data() + blob.size()), stringsIndex_(stringsIndex)
+			{}
+
+			void Read()
+			{
+				if (ReadUInt32() != BlobMagic) {
+					throw std::runtime_error("Not a persistent variables blob");
+				}
+
+				auto version = ReadUInt32();
+				if (version > BlobVersion) {
+					throw std::runtime_error("Persistent variables were saved by a newer extender version");
+				}
+
+				ReadValue(ReadTag(), 0); // stack: value
+				if (pos_ != end_) {
+					throw std::runtime_error("Unexpected data after the end of persistent variables");
+				}
+			}
+
+		private:
+			lua_State* L_;
+			char const* pos_;
+			char const* end_;
+			int stringsIndex_;
+			lua_Integer numStrings_{ 0 };
+
+			void Need(std::size_t size)
+			{
+				if ((std::size_t)(end_ - pos_) < size) {
+					throw std::runtime_error("Unexpected end of persistent variables blob");
+				}
+			}
+
+			Tag ReadTag()
+			{
+				Need(1);
+				return (Tag)*pos_++;
+			}
+
+			uint32_t ReadUInt32()
+			{
+				uint32_t value;
+				Need(sizeof(value));
+				memcpy(&value, pos_, sizeof(value));
+				pos_ += sizeof(value);
+				return value;
+			}
+
+			uint64_t ReadVarint()
+			{
+				uint64_t value = 0;
+				for (unsigned shift = 0; shift < 64; shift += 7) {
+					Need(1);
+					auto byte = (uint8_t)*pos_++;
+					value |= (uint64_t)(byte & 0x7f) << shift;
+					if ((byte & 0x80) == 0) {
+						return value;
+					}
+				}
+
+				throw std::runtime_error("Malformed integer in persistent variables blob");
+			}
+
+			void ReadValue(Tag tag, int depth)
+			{
+				switch (tag) {
+				case Tag::False:
+					lua_pushboolean(L_, 0);
+					break;
+
+				case Tag::True:
+					lua_pushboolean(L_, 1);
+					break;
+
+				case Tag::Integer:
+				{
+					auto value = ReadVarint();
+					lua_pushinteger(L_, (lua_Integer)((value >> 1) ^ (0 - (value & 1))));
+					break;
+				}
+
+				case Tag::Number:
+				{
+					double value;
+					Need(sizeof(value));
+					memcpy(&value, pos_, sizeof(value));
+					pos_ += sizeof(value);
+					lua_pushnumber(L_, value);
+					break;
+				}
+
+				case Tag::String:
+				{
+					auto len = ReadVarint();
+					Need(len);
+					lua_pushlstring(L_, pos_, (std::size_t)len);
+					pos_ += len;
+					lua_pushvalue(L_, -1);
+					lua_rawseti(L_, stringsIndex_, ++numStrings_);
+					break;
+				}
+
+				case Tag::StringRef:
+				{
+					auto index = ReadVarint();
+					if (index >= (uint64_t)numStrings_) {
+						throw std::runtime_error("Invalid string reference in persistent variables blob");
+					}
+
+					lua_rawgeti(L_, stringsIndex_, (lua_Integer)index + 1);
+					break;
+				}
+
+				case Tag::Table:
+					ReadTable(depth);
+					break;
+
+				default:
+					throw std::runtime_error("Unknown value type in persistent variables blob");
+				}
+			}
+
+			void ReadTable(int depth)
+			{
+				if (depth > MaxDepth || !lua_checkstack(L_, 6)) {
+					throw std::runtime_error("Persistent variables nested too deep");
+				}
+
+				auto sizeInfo = ReadVarint();
+				auto size = sizeInfo >> 1;
+				// Each key/value pair takes at least two bytes; don't trust the size of malformed blobs
+				auto preallocSize = (int)std::min<uint64_t>(size, (end_ - pos_) / 2);
+				if (sizeInfo & 1) {
+					lua_createtable(L_, preallocSize, 0); // stack: table
+				} else {
+					lua_createtable(L_, 0, preallocSize); // stack: table
+				}
+
+				auto table = lua_gettop(L_);
+				for (uint64_t i = 0; i < size; i++) {
+					auto keyTag = ReadTag();
+					if (keyTag == Tag::Table) {
+						throw std::runtime_error("Invalid table key in persistent variables blob");
+					}
+
+					ReadValue(keyTag, depth + 1); // stack: table, key
+					if (lua_type(L_, -1) == LUA_TNUMBER && std::isnan(lua_tonumber(L_, -1))) {
+						throw std::runtime_error("Invalid table key in persistent variables blob");
+					}
+
+					ReadValue(ReadTag(), depth + 1); // stack: table, key, value
+					lua_rawset(L_, table); // stack: table
+				}
+			}
+		};
+	}
+
+	std::optional<uint64_t> Hash(lua_State* L, int index)
+	{
+		Hasher hasher(L);
+		auto top = lua_gettop(L);
+		uint64_t hash;
+		if (!hasher.Hash(AbsIndex(L, index), hash)) {
+			lua_settop(L, top);
+			return {};
+		}
+
+		return hash;
+	}
+
+	void Serialize(lua_State* L, int index, STDString& out)
+	{
+		index = AbsIndex(L, index);
+		auto top = lua_gettop(L);
+		out.clear();
+
+		Writer writer(L, out);
+		try {
+			writer.Write(index);
+		} catch (std::runtime_error&) {
+			lua_settop(L, top);
+			throw;
+		}
+	}
+
+	bool Deserialize(lua_State* L, StringView blob, STDString& error)
+	{
+		auto top = lua_gettop(L);
+		lua_newtable(L); // stack: strings
+
+		Reader reader(L, blob, top + 1);
+		try {
+			reader.Read(); // stack: strings, value
+		} catch (std::runtime_error& e) {
+			error = e.what();
+			lua_settop(L, top);
+			return false;
+		}
+
+		lua_remove(L, top + 1); // stack: value
+		return true;
+	}
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <GameDefinitions/BaseTypes.h>
+#include <lua.h>
+#include <optional>
+
+namespace dse::lua::persistence
+{
+	// Computes a hash of the Lua value at the specified stack index (and all tables reachable
+	// from it) that changes whenever its serialized form would change.
+	// Returns an empty value if the value cannot be serialized.
+	std::optional<uint64_t> Hash(lua_State* L, int index);
+
+	// Serializes the Lua value at the specified stack index to the binary PersistentVars format.
+	// Throws std::runtime_error if the value cannot be serialized.
+	void Serialize(lua_State* L, int index, STDString& out);
+
+	// Deserializes a binary PersistentVars blob. On success, pushes the value and returns true.
+	// Returns false and pushes nothing if the blob is malformed.
+	bool Deserialize(lua_State* L, StringView blob, STDString& error);
+}
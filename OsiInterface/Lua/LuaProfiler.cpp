@@ -0,0 +1,380 @@
+#include <stdafx.h>
+#include <Lua/LuaProfiler.h>
+#include <algorithm>
+#include <fstream>
+
+namespace dse::lua
+{
+	Profiler::~Profiler()
+	{
+		Detach();
+	}
+
+	Profiler* Profiler::FromState(lua_State* L)
+	{
+#if LUA_VERSION_NUM > 501
+		return *reinterpret_cast<Profiler**>(lua_getextraspace(L));
+#else
+		return nullptr;
+#endif
+	}
+
+	void Profiler::Attach(lua_State* L)
+	{
+#if LUA_VERSION_NUM > 501
+		L_ = L;
+		*reinterpret_cast<Profiler**>(lua_getextraspace(L)) = this;
+#endif
+	}
+
+	void Profiler::Detach()
+	{
+#if LUA_VERSION_NUM > 501
+		if (L_ != nullptr) {
+			Stop();
+			*reinterpret_cast<Profiler**>(lua_getextraspace(L_)) = nullptr;
+			L_ = nullptr;
+		}
+#endif
+	}
+
+	void Profiler::Start(Mode mode, int sampleInterval)
+	{
+		if (L_ == nullptr) {
+			ERR("Profiler::Start(): Profiling is not supported on this Lua VM");
+			return;
+		}
+
+		if (running_) {
+			Stop();
+		}
+
+		if (nodes_.empty()) {
+			Reset();
+		}
+
+		frames_.clear();
+		eventDepths_.clear();
+		startTime_ = lastTimestamp_ = Clock::now();
+
+		origAlloc_ = lua_getallocf(L_, &origAllocUd_);
+		lua_setallocf(L_, &TrackingAlloc, this);
+
+		if (mode == Mode::Instrument) {
+			lua_sethook(L_, &Hook, LUA_MASKCALL | LUA_MASKRET, 0);
+		} else {
+			lua_sethook(L_, &Hook, LUA_MASKCOUNT, std::max(sampleInterval, 1));
+		}
+
+		running_ = true;
+	}
+
+	void Profiler::Stop()
+	{
+		if (!running_) return;
+
+		ChargeElapsed();
+		lua_sethook(L_, nullptr, 0, 0);
+		lua_setallocf(L_, origAlloc_, origAllocUd_);
+		running_ = false;
+		frames_.clear();
+		eventDepths_.clear();
+
+		auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - startTime_).count();
+		INFO("Lua profiler stopped after %lld ms; %d call paths recorded", (int64_t)elapsed, (int)nodes_.size());
+	}
+
+	void Profiler::Reset()
+	{
+		nodes_.clear();
+		nodeIndex_.clear();
+		eventIndex_.clear();
+		frames_.clear();
+		eventDepths_.clear();
+
+		Node unattributed;
+		unattributed.Name = "(unattributed)";
+		unattributed.Parent = UnattributedNode;
+		nodes_.push_back(unattributed);
+	}
+
+	void Profiler::EnterEvent(char const* name)
+	{
+		ChargeElapsed();
+
+		uint32_t node;
+		auto it = eventIndex_.find(name);
+		if (it != eventIndex_.end()) {
+			node = it->second;
+		} else {
+			node = (uint32_t)nodes_.size();
+			Node event;
+			event.Name = name;
+			event.Parent = node;
+			nodes_.push_back(event);
+			eventIndex_.insert(std::make_pair(std::string(name), node));
+		}
+
+		nodes_[node].Calls++;
+		eventDepths_.push_back(frames_.size());
+		frames_.push_back(Frame{ node, nullptr });
+	}
+
+	void Profiler::LeaveEvent()
+	{
+		if (eventDepths_.empty()) return;
+
+		ChargeElapsed();
+		// Frames left behind by Lua errors (no return hook is called for unwound frames)
+		// are discarded together with the event frame
+		frames_.resize(eventDepths_.back());
+		eventDepths_.pop_back();
+	}
+
+	void Profiler::Hook(lua_State* L, lua_Debug* ar)
+	{
+		auto self = FromState(L);
+		// Coroutines share the main thread's hook; their time is charged to the resuming frame
+		if (self == nullptr || !self->running_ || L != self->L_) return;
+
+		switch (ar->event) {
+		case LUA_HOOKCALL: self->OnCall(L, ar, false); break;
+		case LUA_HOOKTAILCALL: self->OnCall(L, ar, true); break;
+		case LUA_HOOKRET: self->OnReturn(L, ar); break;
+		case LUA_HOOKCOUNT: self->OnSample(L); break;
+		}
+	}
+
+	void* Profiler::TrackingAlloc(void* ud, void* ptr, size_t osize, size_t nsize)
+	{
+		auto self = reinterpret_cast<Profiler*>(ud);
+		// When ptr is null, osize holds the type of the object being allocated
+		auto oldSize = (ptr != nullptr) ? osize : 0;
+		if (nsize > oldSize) {
+			auto& node = self->nodes_[self->CurrentNode()];
+			node.AllocBytes += nsize - oldSize;
+			node.AllocCount++;
+		}
+
+		return self->origAlloc_(self->origAllocUd_, ptr, osize, nsize);
+	}
+
+	void Profiler::OnCall(lua_State* L, lua_Debug* ar, bool tailCall)
+	{
+		ChargeElapsed();
+
+		lua_getinfo(L, "f", ar);
+		auto function = lua_topointer(L, -1);
+		lua_pop(L, 1);
+
+		auto eventBase = eventDepths_.empty() ? 0 : eventDepths_.back() + 1;
+		if (tailCall && frames_.size() > eventBase) {
+			frames_.pop_back();
+		}
+
+		auto node = GetOrCreateNode(CurrentNode(), function, L, ar);
+		nodes_[node].Calls++;
+		frames_.push_back(Frame{ node, function });
+	}
+
+	void Profiler::OnReturn(lua_State* L, lua_Debug* ar)
+	{
+		ChargeElapsed();
+
+		lua_getinfo(L, "f", ar);
+		auto function = lua_topointer(L, -1);
+		lua_pop(L, 1);
+
+		auto eventBase = eventDepths_.empty() ? 0 : eventDepths_.back() + 1;
+		// Resynchronize with the real call stack if frames were unwound by an error
+		auto depth = frames_.size();
+		while (depth > eventBase && frames_[depth - 1].Function != function) {
+			depth--;
+		}
+
+		if (depth > eventBase) {
+			frames_.resize(depth - 1);
+		}
+	}
+
+	void Profiler::OnSample(lua_State* L)
+	{
+		lua_Debug stack[32];
+		int levels = 0;
+		while (levels < (int)std::size(stack) && lua_getstack(L, levels, &stack[levels])) {
+			levels++;
+		}
+
+		auto node = CurrentNode();
+		for (int i = levels - 1; i >= 0; i--) {
+			lua_getinfo(L, "f", &stack[i]);
+			auto function = lua_topointer(L, -1);
+			lua_pop(L, 1);
+			node = GetOrCreateNode(node, function, L, &stack[i]);
+		}
+
+		auto now = Clock::now();
+		// Samples taken outside of an event have no known starting point; only count them
+		if (!eventDepths_.empty()) {
+			nodes_[node].SelfTime += std::chrono::duration_cast<std::chrono::microseconds>(now - lastTimestamp_).count();
+		}
+
+		nodes_[node].Calls++;
+		lastTimestamp_ = now;
+	}
+
+	void Profiler::ChargeElapsed()
+	{
+		auto now = Clock::now();
+		// Time between two Lua calls is spent in the game, not in Lua
+		if (!frames_.empty()) {
+			auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - lastTimestamp_).count();
+			nodes_[CurrentNode()].SelfTime += elapsed;
+		}
+
+		lastTimestamp_ = now;
+	}
+
+	uint32_t Profiler::CurrentNode() const
+	{
+		return frames_.empty() ? UnattributedNode : frames_.back().Node;
+	}
+
+	uint32_t Profiler::GetOrCreateNode(uint32_t parent, void const* function, lua_State* L, lua_Debug* ar)
+	{
+		NodeKey key{ parent, function };
+		auto it = nodeIndex_.find(key);
+		if (it != nodeIndex_.end()) {
+			return it->second;
+		}
+
+		// Name resolution is only done once per call path, as it is relatively expensive
+		lua_getinfo(L, "Sn", ar);
+
+		Node node;
+		node.Parent = parent;
+		if (ar->what != nullptr && strcmp(ar->what, "C") == 0) {
+			node.Name = ar->name ? ar->name : "(C function)";
+		} else {
+			node.Name = ar->short_src;
+			node.Name += ":";
+			node.Name += std::to_string(ar->linedefined);
+			if (ar->name != nullptr) {
+				node.Name += " (";
+				node.Name += ar->name;
+				node.Name += ")";
+			}
+
+			// Mod scripts are loaded with a "<ModDirectory>/<Path>" chunk name
+			std::string_view source(ar->source ? ar->source : "");
+			auto modSep = source.find('/');
+			if (modSep != std::string_view::npos && source[0] != '@' && source[0] != '=') {
+				node.Mod = source.substr(0, modSep);
+			}
+		}
+
+		if (node.Mod.empty() && parent != UnattributedNode) {
+			node.Mod = nodes_[parent].Mod;
+		}
+
+		auto index = (uint32_t)nodes_.size();
+		nodes_.push_back(node);
+		nodeIndex_.insert(std::make_pair(key, index));
+		return index;
+	}
+
+	std::string Profiler::BuildStack(uint32_t node) const
+	{
+		std::vector<uint32_t> path;
+		for (;;) {
+			path.push_back(node);
+			auto parent = nodes_[node].Parent;
+			if (parent == node) break;
+			node = parent;
+		}
+
+		std::string stack;
+		for (auto it = path.rbegin(); it != path.rend(); it++) {
+			if (!stack.empty()) {
+				stack += ';';
+			}
+
+			// Collapsed stack format uses ';' as separator and ' ' before the value
+			for (auto c : nodes_[*it].Name) {
+				stack += (c == ';' || c == ' ') ? '_' : c;
+			}
+		}
+
+		return stack;
+	}
+
+	bool Profiler::Dump(std::string const& path)
+	{
+		// Merge call paths that only differ in closure identity
+		std::map<std::string, std::pair<uint64_t, uint64_t>> stacks;
+		for (uint32_t i = 0; i < nodes_.size(); i++) {
+			auto const& node = nodes_[i];
+			if (node.SelfTime > 0 || node.AllocBytes > 0) {
+				auto& values = stacks[BuildStack(i)];
+				values.first += node.SelfTime;
+				values.second += node.AllocBytes;
+			}
+		}
+
+		std::ofstream timeFile(path.c_str(), std::ios::out | std::ios::binary);
+		std::ofstream allocFile((path + ".alloc").c_str(), std::ios::out | std::ios::binary);
+		if (!timeFile.good() || !allocFile.good()) {
+			ERR("Profiler::Dump(): Could not open '%s' for writing", path.c_str());
+			return false;
+		}
+
+		for (auto const& stack : stacks) {
+			if (stack.second.first > 0) {
+				timeFile << stack.first << ' ' << stack.second.first << '\n';
+			}
+
+			if (stack.second.second > 0) {
+				allocFile << stack.first << ' ' << stack.second.second << '\n';
+			}
+		}
+
+		INFO("Lua profile written to '%s' (%d stacks)", path.c_str(), (int)stacks.size());
+		return true;
+	}
+
+	void Profiler::LogSummary()
+	{
+		struct Totals
+		{
+			uint64_t Time{ 0 };
+			uint64_t AllocBytes{ 0 };
+		};
+
+		std::map<std::string, Totals> mods, events;
+		for (uint32_t i = 0; i < nodes_.size(); i++) {
+			auto const& node = nodes_[i];
+			auto& mod = mods[node.Mod.empty() ? "(extender)" : node.Mod];
+			mod.Time += node.SelfTime;
+			mod.AllocBytes += node.AllocBytes;
+
+			auto root = i;
+			while (nodes_[root].Parent != root) {
+				root = nodes_[root].Parent;
+			}
+
+			auto& event = events[nodes_[root].Name];
+			event.Time += node.SelfTime;
+			event.AllocBytes += node.AllocBytes;
+		}
+
+		INFO("Lua profile by mod:");
+		for (auto const& mod : mods) {
+			INFO("    %-40s %10lld us %12lld bytes", mod.first.c_str(), (int64_t)mod.second.Time, (int64_t)mod.second.AllocBytes);
+		}
+
+		INFO("Lua profile by event:");
+		for (auto const& event : events) {
+			INFO("    %-40s %10lld us %12lld bytes", event.first.c_str(), (int64_t)event.second.Time, (int64_t)event.second.AllocBytes);
+		}
+	}
+}
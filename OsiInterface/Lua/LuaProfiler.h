@@ -0,0 +1,146 @@
+#pragma once
+
+#include <lua.h>
+
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+
+namespace dse::lua
+{
+	// Lua-side profiler that attributes wall time and allocations to
+	// (event -> Lua call stack) paths. The root of every path is the extender
+	// callback that entered Lua (eg. "_OnGameStateChanged"); mods are identified
+	// by the mod directory prefix of the chunk name (see LuaLoadModScript).
+	class Profiler
+	{
+	public:
+		enum class Mode
+		{
+			// Call/return hooks; exact self time for every Lua and C function
+			Instrument,
+			// Instruction count hook; approximate time, lower overhead
+			Sample
+		};
+
+		static constexpr int DefaultSampleInterval = 1000;
+
+		~Profiler();
+
+		static Profiler* FromState(lua_State* L);
+
+		void Attach(lua_State* L);
+		void Detach();
+
+		inline bool IsRunning() const
+		{
+			return running_;
+		}
+
+		void Start(Mode mode, int sampleInterval = DefaultSampleInterval);
+		void Stop();
+		void Reset();
+		// Writes collapsed-stack time samples (microseconds) to path and allocation
+		// samples (bytes) to path + ".alloc"; both can be fed to flamegraph.pl as-is.
+		bool Dump(std::string const& path);
+		void LogSummary();
+
+		void EnterEvent(char const* name);
+		void LeaveEvent();
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		struct Node
+		{
+			std::string Name;
+			std::string Mod;
+			uint32_t Parent;
+			uint64_t SelfTime{ 0 };
+			uint64_t Calls{ 0 };
+			uint64_t AllocBytes{ 0 };
+			uint64_t AllocCount{ 0 };
+		};
+
+		struct NodeKey
+		{
+			uint32_t Parent;
+			void const* Function;
+
+			inline bool operator ==(NodeKey const& o) const
+			{
+				return Parent == o.Parent && Function == o.Function;
+			}
+		};
+
+		struct NodeKeyHash
+		{
+			inline std::size_t operator ()(NodeKey const& k) const
+			{
+				return std::hash<void const*>()(k.Function) ^ ((std::size_t)k.Parent * 0x9E3779B97F4A7C15ull);
+			}
+		};
+
+		struct Frame
+		{
+			uint32_t Node;
+			void const* Function;
+		};
+
+		static constexpr uint32_t UnattributedNode = 0;
+
+		lua_State* L_{ nullptr };
+		bool running_{ false };
+		lua_Alloc origAlloc_{ nullptr };
+		void* origAllocUd_{ nullptr };
+		Clock::time_point lastTimestamp_;
+		Clock::time_point startTime_;
+
+		std::vector<Node> nodes_;
+		std::unordered_map<NodeKey, uint32_t, NodeKeyHash> nodeIndex_;
+		std::unordered_map<std::string, uint32_t> eventIndex_;
+		std::vector<Frame> frames_;
+		std::vector<std::size_t> eventDepths_;
+
+		static void Hook(lua_State* L, lua_Debug* ar);
+		static void* TrackingAlloc(void* ud, void* ptr, size_t osize, size_t nsize);
+
+		void OnCall(lua_State* L, lua_Debug* ar, bool tailCall);
+		void OnReturn(lua_State* L, lua_Debug* ar);
+		void OnSample(lua_State* L);
+
+		void ChargeElapsed();
+		uint32_t CurrentNode() const;
+		uint32_t GetOrCreateNode(uint32_t parent, void const* function, lua_State* L, lua_Debug* ar);
+		std::string BuildStack(uint32_t node) const;
+	};
+
+
+	// Marks the extender callback that is entering Lua, so that time spent
+	// in the call is attributed to the event when the profiler is running.
+	class ProfilerEventScope
+	{
+	public:
+		inline ProfilerEventScope(lua_State* L, char const* name)
+		{
+			auto profiler = Profiler::FromState(L);
+			if (profiler != nullptr && profiler->IsRunning()) {
+				profiler_ = profiler;
+				profiler_->EnterEvent(name);
+			}
+		}
+
+		inline ~ProfilerEventScope()
+		{
+			if (profiler_ != nullptr) {
+				profiler_->LeaveEvent();
+			}
+		}
+
+		ProfilerEventScope(ProfilerEventScope const&) = delete;
+		ProfilerEventScope& operator =(ProfilerEventScope const&) = delete;
+
+	private:
+		Profiler* profiler_{ nullptr };
+	};
+}
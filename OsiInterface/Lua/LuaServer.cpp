@@ -3,8 +3,13 @@
 #include <GameDefinitions/Ai.h>
 #include <GameDefinitions/Surface.h>
 #include <Lua/LuaBindingServer.h>
+#include <Lua/LuaJson.h>
+#include <Lua/LuaBinaryMessage.h>
 #include <OsirisProxy.h>
+#include <HitTracer.h>
+#include <ScriptHelpers.h>
 #include <PropertyMaps.h>
+#include <algorithm>
 #include "resource.h"
 
 namespace dse::lua
@@ -943,33 +948,151 @@ namespace dse::esv::lua
 		return 1;
 	}
 
-	int BroadcastMessage(lua_State * L)
+	bool PeerSupportsBinaryMessages(PeerId peerId)
 	{
-		auto channel = luaL_checkstring(L, 1);
-		auto payload = luaL_checkstring(L, 2);
+		auto capabilities = gOsirisProxy->GetNetworkManager().GetPeerCapabilities(peerId);
+		return (capabilities & (uint32_t)net::ExtenderCapabilities::BinaryMessages) != 0;
+	}
+
+	void SetLuaMessagePayload(MsgPostLuaMessage* postMsg, char const* channel, STDString const& payload, bool binary)
+	{
+		postMsg->set_channel_name(channel);
+		if (binary) {
+			postMsg->set_binary_payload(payload.data(), payload.size());
+		} else {
+			postMsg->set_payload(payload.data(), payload.size());
+		}
+	}
+
+	void BroadcastLuaMessage(char const* channel, STDString const& payload, bool binary, UserId excludeUserId)
+	{
+		// Stat changes made before the message was sent must reach the clients before the message does
+		gOsirisProxy->StatSync().Flush();
 
-		esv::Character * excludeCharacter = nullptr;
-		if (lua_gettop(L) > 2 && !lua_isnil(L, 3)) {
-			auto excludeCharacterGuid = luaL_checkstring(L, 3);
-			excludeCharacter = GetEntityWorld()->GetCharacter(excludeCharacterGuid);
-			if (excludeCharacter == nullptr) return 0;
+		auto& batcher = gOsirisProxy->LuaMessageBatch();
+		if (batcher.IsBatched(channel)) {
+			batcher.Broadcast(channel, payload, excludeUserId, binary);
+			return;
 		}
 
 		auto & networkMgr = gOsirisProxy->GetNetworkManager();
+		if (binary) {
+			auto peerIds = networkMgr.ServerGetExtenderPeerIds();
+			if (!std::all_of(peerIds.begin(), peerIds.end(), &PeerSupportsBinaryMessages)) {
+				// Older clients would receive an empty string payload, so send the message separately
+				// to each peer that understands binary payloads
+				auto excludePeerId = excludeUserId ? excludeUserId.GetPeerId() : -1;
+				for (auto peerId : peerIds) {
+					if (peerId == excludePeerId) continue;
+					if (!PeerSupportsBinaryMessages(peerId)) {
+						WARN("Not sending binary message to peer %d as its extender version doesn't support it!", peerId);
+						continue;
+					}
+
+					auto msg = networkMgr.GetFreeServerMessage(UserId::Unassigned);
+					if (msg != nullptr) {
+						SetLuaMessagePayload(msg->GetMessage().mutable_post_lua(), channel, payload, binary);
+						networkMgr.ServerSendToPeer(msg, peerId);
+					} else {
+						OsiErrorS("Could not get free message!");
+					}
+				}
+				return;
+			}
+		}
+
 		auto msg = networkMgr.GetFreeServerMessage(-1);
 		if (msg != nullptr) {
-			auto postMsg = msg->GetMessage().mutable_post_lua();
-			postMsg->set_channel_name(channel);
-			postMsg->set_payload(payload);
-			if (excludeCharacter != nullptr) {
-				networkMgr.ServerBroadcast(msg, excludeCharacter->UserID);
-			} else {
-				networkMgr.ServerBroadcast(msg, -1);
-			}
+			SetLuaMessagePayload(msg->GetMessage().mutable_post_lua(), channel, payload, binary);
+			networkMgr.ServerBroadcast(msg, excludeUserId);
 		} else {
 			OsiErrorS("Could not get free message!");
 		}
+	}
+
+	void PostLuaMessageToUser(char const* channel, STDString const& payload, bool binary, UserId userId)
+	{
+		if (binary && !PeerSupportsBinaryMessages(userId.GetPeerId())) {
+			OsiError("Cannot send binary message to user " << userId.Id << ": the extender version of the client doesn't support it");
+			return;
+		}
+
+		gOsirisProxy->StatSync().Flush();
+
+		auto& batcher = gOsirisProxy->LuaMessageBatch();
+		if (batcher.IsBatched(channel)) {
+			batcher.Send(channel, payload, userId, binary);
+			return;
+		}
+
+		auto & networkMgr = gOsirisProxy->GetNetworkManager();
+		auto msg = networkMgr.GetFreeServerMessage(userId);
+		if (msg != nullptr) {
+			SetLuaMessagePayload(msg->GetMessage().mutable_post_lua(), channel, payload, binary);
+			networkMgr.ServerSend(msg, userId);
+		} else {
+			OsiErrorS("Could not get free message!");
+		}
+	}
+
+	// Fetches the optional character whose user is excluded from a broadcast.
+	// Returns false if the character doesn't exist.
+	bool GetBroadcastExcludedUser(lua_State* L, int index, UserId& excludeUserId)
+	{
+		excludeUserId = UserId::Unassigned;
+		if (lua_gettop(L) >= index && !lua_isnil(L, index)) {
+			auto excludeCharacterGuid = luaL_checkstring(L, index);
+			auto excludeCharacter = GetEntityWorld()->GetCharacter(excludeCharacterGuid);
+			if (excludeCharacter == nullptr) return false;
+			excludeUserId = excludeCharacter->UserID;
+		}
+
+		return true;
+	}
+
+	// Fetches the user of the character that a message is sent to
+	bool GetMessageRecipient(char const* characterGuid, UserId& userId)
+	{
+		auto character = GetEntityWorld()->GetCharacter(characterGuid);
+		if (character == nullptr) return false;
+
+		if (character->UserID.Id == UserId::Unassigned) {
+			OsiError("Attempted to send message to character " << characterGuid << " that has no user assigned!");
+			return false;
+		}
+
+		userId = character->UserID;
+		return true;
+	}
+
+	int BroadcastMessage(lua_State * L)
+	{
+		auto channel = luaL_checkstring(L, 1);
+		auto payload = luaL_checkstring(L, 2);
+
+		UserId excludeUserId;
+		if (!GetBroadcastExcludedUser(L, 3, excludeUserId)) return 0;
+
+		BroadcastLuaMessage(channel, payload, false, excludeUserId);
+		return 0;
+	}
+
+	int BroadcastBinaryMessage(lua_State* L)
+	{
+		auto channel = luaL_checkstring(L, 1);
+		luaL_checkany(L, 2);
+
+		UserId excludeUserId;
+		if (!GetBroadcastExcludedUser(L, 3, excludeUserId)) return 0;
+
+		STDString payload;
+		try {
+			binary::Serialize(L, 2, payload);
+		} catch (std::runtime_error& e) {
+			return luaL_error(L, "Unable to serialize message: %s", e.what());
+		}
 
+		BroadcastLuaMessage(channel, payload, true, excludeUserId);
 		return 0;
 	}
 
@@ -979,28 +1102,364 @@ namespace dse::esv::lua
 		auto channel = luaL_checkstring(L, 2);
 		auto payload = luaL_checkstring(L, 3);
 
-		auto character = GetEntityWorld()->GetCharacter(characterGuid);
-		if (character == nullptr) return 0;
+		UserId userId;
+		if (!GetMessageRecipient(characterGuid, userId)) return 0;
 
-		if (character->UserID.Id == UserId::Unassigned) {
-			OsiError("Attempted to send message to character " << characterGuid << " that has no user assigned!");
-			return 0;
+		PostLuaMessageToUser(channel, payload, false, userId);
+		return 0;
+	}
+
+	int PostBinaryMessageToClient(lua_State* L)
+	{
+		auto characterGuid = luaL_checkstring(L, 1);
+		auto channel = luaL_checkstring(L, 2);
+		luaL_checkany(L, 3);
+
+		UserId userId;
+		if (!GetMessageRecipient(characterGuid, userId)) return 0;
+
+		STDString payload;
+		try {
+			binary::Serialize(L, 3, payload);
+		} catch (std::runtime_error& e) {
+			return luaL_error(L, "Unable to serialize message: %s", e.what());
 		}
 
-		auto & networkMgr = gOsirisProxy->GetNetworkManager();
-		auto msg = networkMgr.GetFreeServerMessage(character->UserID);
-		if (msg != nullptr) {
-			auto postMsg = msg->GetMessage().mutable_post_lua();
-			postMsg->set_channel_name(channel);
-			postMsg->set_payload(payload);
-			networkMgr.ServerSend(msg, character->UserID);
+		PostLuaMessageToUser(channel, payload, true, userId);
+		return 0;
+	}
+
+	int SetMessageBatching(lua_State* L)
+	{
+		auto channel = luaL_checkstring(L, 1);
+		auto enabled = checked_get<bool>(L, 2);
+		gOsirisProxy->LuaMessageBatch().SetChannelBatching(channel, enabled);
+		return 0;
+	}
+
+	int SetMessageBatchLimits(lua_State* L)
+	{
+		auto maxMessages = checked_get<int>(L, 1);
+		auto maxBytes = checked_get<int>(L, 2);
+		if (maxMessages < 1 || maxBytes < 1) {
+			return luaL_error(L, "Batch limits must be positive");
+		}
+
+		gOsirisProxy->LuaMessageBatch().SetLimits((uint32_t)maxMessages, (uint32_t)maxBytes);
+		return 0;
+	}
+
+	int GetMessageBatchStats(lua_State* L)
+	{
+		bool reset = lua_gettop(L) >= 1 && checked_get<bool>(L, 1);
+		auto& batcher = gOsirisProxy->LuaMessageBatch();
+		auto const& stats = batcher.GetStats();
+		lua_newtable(L);
+		setfield(L, "MessagesBatched", (int64_t)stats.MessagesBatched);
+		setfield(L, "BatchesSent", (int64_t)stats.BatchesSent);
+		setfield(L, "BytesSent", (int64_t)stats.BytesSent);
+		setfield(L, "ThresholdFlushes", (int64_t)stats.ThresholdFlushes);
+		setfield(L, "MessagesUnbatched", (int64_t)stats.MessagesUnbatched);
+		// Each batched message would have been a separate packet without batching
+		auto packetsSaved = stats.MessagesBatched > stats.BatchesSent ? stats.MessagesBatched - stats.BatchesSent : 0;
+		setfield(L, "PacketsSaved", (int64_t)packetsSaved);
+
+		if (reset) {
+			batcher.ResetStats();
+		}
+
+		return 1;
+	}
+
+	int EnableHitTracing(lua_State* L)
+	{
+		auto enabled = checked_get<bool>(L, 1);
+		if (enabled) {
+			esv::gHitTracer.Start();
 		} else {
-			OsiErrorS("Could not get free message!");
+			esv::gHitTracer.Stop();
 		}
 
 		return 0;
 	}
 
+	void PushLatencyHistogram(lua_State* L, esv::LatencyHistogram const& hist)
+	{
+		// Times are reported in microseconds
+		lua_newtable(L);
+		setfield(L, "Count", (int64_t)hist.Count);
+		setfield(L, "Total", hist.Total / 1000.0);
+		setfield(L, "Min", hist.Min / 1000.0);
+		setfield(L, "Max", hist.Max / 1000.0);
+		setfield(L, "P50", hist.Percentile(0.5) / 1000.0);
+		setfield(L, "P90", hist.Percentile(0.9) / 1000.0);
+		setfield(L, "P99", hist.Percentile(0.99) / 1000.0);
+	}
+
+	int GetHitTraceStats(lua_State* L)
+	{
+		bool reset = lua_gettop(L) >= 1 && checked_get<bool>(L, 1);
+		auto stats = esv::gHitTracer.GetStats();
+		if (reset) {
+			esv::gHitTracer.Reset();
+		}
+
+		lua_newtable(L);
+		setfield(L, "Enabled", esv::gHitTracer.IsEnabled());
+		setfield(L, "EventsRecorded", (int64_t)stats.EventsRecorded);
+		setfield(L, "EventsDropped", (int64_t)stats.EventsDropped);
+		PushLatencyHistogram(L, stats.HitLatency);
+		lua_setfield(L, -2, "HitLatency");
+
+		lua_newtable(L); // stack: stats, phases
+		for (unsigned i = 0; i < esv::HitTraceStats::NumPhases; i++) {
+			lua_newtable(L); // stack: stats, phases, phase
+			PushLatencyHistogram(L, stats.PhaseTime[i]);
+			lua_setfield(L, -2, "Time");
+			PushLatencyHistogram(L, stats.LuaTime[i]);
+			lua_setfield(L, -2, "Lua");
+			PushLatencyHistogram(L, stats.OsirisTime[i]);
+			lua_setfield(L, -2, "Osiris");
+			lua_setfield(L, -2, esv::HitTracePhaseToString((esv::HitTracePhase)i)); // stack: stats, phases
+		}
+
+		lua_setfield(L, -2, "Phases"); // stack: stats
+		return 1;
+	}
+
+	int DumpHitTrace(lua_State* L)
+	{
+		auto path = checked_get<char const*>(L, 1);
+
+		std::string trace;
+		esv::gHitTracer.Dump(trace);
+		push(L, script::SaveExternalFile(path, trace));
+		return 1;
+	}
+
+	// Resolves a character/item GUID or handle passed to a Lua function
+	OsiArgumentValue GetLuaGameObjectArg(lua_State* L, int index)
+	{
+		if (lua_type(L, index) == LUA_TNUMBER) {
+			return OsiArgumentValue((int64_t)lua_tointeger(L, index));
+		} else {
+			return OsiArgumentValue{ ValueType::GuidString, luaL_checkstring(L, index) };
+		}
+	}
+
+	struct StatusApplyScratch
+	{
+		esv::StatusApplyBatch Batch;
+		std::vector<ObjectHandle> StatusHandles;
+		bool InUse{ false };
+	};
+
+	int ApplyStatusToTargets(lua_State* L)
+	{
+		LuaServerPin lua(ExtensionState::Get());
+		if (lua->RestrictionFlags & State::RestrictOsiris) {
+			return luaL_error(L, "Attempted to apply statuses in restricted context");
+		}
+
+		auto statusId = luaL_checkstring(L, 1);
+		luaL_checktype(L, 2, LUA_TTABLE);
+
+		esv::StatusApplyBatch::Params params;
+		if (lua_gettop(L) >= 3 && !lua_isnil(L, 3)) {
+			luaL_checktype(L, 3, LUA_TTABLE);
+			lua_getfield(L, 3, "LifeTime");
+			if (!lua_isnil(L, -1)) params.LifeTime = checked_get<float>(L, -1);
+			lua_getfield(L, 3, "StatsMultiplier");
+			if (!lua_isnil(L, -1)) params.StatsMultiplier = checked_get<float>(L, -1);
+			lua_getfield(L, 3, "Force");
+			if (!lua_isnil(L, -1)) params.Force = checked_get<bool>(L, -1);
+			lua_getfield(L, 3, "Source");
+			if (!lua_isnil(L, -1)) {
+				auto source = esv::GetGameObjectArg(GetLuaGameObjectArg(L, -1));
+				if (source != nullptr) {
+					source->GetObjectHandle(params.Source);
+				}
+			}
+			lua_pop(L, 4);
+		}
+
+		// Status listeners may apply statuses recursively; only the outermost call reuses the shared buffers
+		static StatusApplyScratch sharedScratch;
+		StatusApplyScratch localScratch;
+		auto& scratch = sharedScratch.InUse ? localScratch : sharedScratch;
+		scratch.InUse = true;
+		auto release = [&scratch]() {
+			scratch.InUse = false;
+			scratch.Batch.Clear();
+		};
+
+		if (!scratch.Batch.Prepare(statusId)) {
+			release();
+			return 0;
+		}
+
+		auto numTargets = (int)lua_rawlen(L, 2);
+		for (int i = 1; i <= numTargets; i++) {
+			lua_rawgeti(L, 2, i);
+			if (lua_type(L, -1) == LUA_TNUMBER || lua_type(L, -1) == LUA_TSTRING) {
+				scratch.Batch.AddTarget(GetLuaGameObjectArg(L, -1));
+			} else {
+				OsiError("Status target " << i << " must be a GUID or handle");
+				scratch.Batch.SkipTarget();
+			}
+			lua_pop(L, 1);
+		}
+
+		scratch.Batch.Apply(params, scratch.StatusHandles);
+
+		lua_createtable(L, numTargets, 0);
+		for (int i = 0; i < numTargets; i++) {
+			auto handle = scratch.StatusHandles[i];
+			if (handle) {
+				push(L, i + 1);
+				push(L, (int64_t)handle);
+				lua_settable(L, -3);
+			}
+		}
+
+		release();
+		return 1;
+	}
+
+	struct ProximityQueryOptions
+	{
+		bool HasTag{ false };
+		FixedString Tag;
+		ObjectHandle Exclude;
+		std::optional<bool> IsPlayer;
+		std::optional<bool> Dead;
+		uint32_t Limit{ 0 };
+		bool ReturnHandles{ false };
+	};
+
+	void GetProximityQueryOptions(lua_State* L, int index, ProximityQueryOptions& options)
+	{
+		if (lua_gettop(L) < index || lua_isnil(L, index)) {
+			return;
+		}
+
+		luaL_checktype(L, index, LUA_TTABLE);
+		lua_getfield(L, index, "Tag");
+		if (!lua_isnil(L, -1)) {
+			// Tags that aren't in the string table can't match any object
+			options.HasTag = true;
+			options.Tag = ToFixedString(checked_get<char const*>(L, -1));
+		}
+
+		lua_getfield(L, index, "Exclude");
+		if (!lua_isnil(L, -1)) {
+			auto excluded = esv::GetGameObjectArg(GetLuaGameObjectArg(L, -1), false);
+			if (excluded != nullptr) {
+				excluded->GetObjectHandle(options.Exclude);
+			}
+		}
+
+		lua_getfield(L, index, "IsPlayer");
+		if (!lua_isnil(L, -1)) options.IsPlayer = checked_get<bool>(L, -1);
+		lua_getfield(L, index, "Dead");
+		if (!lua_isnil(L, -1)) options.Dead = checked_get<bool>(L, -1);
+		lua_getfield(L, index, "Limit");
+		if (!lua_isnil(L, -1)) options.Limit = (uint32_t)std::max(checked_get<int64_t>(L, -1), (int64_t)0);
+		lua_getfield(L, index, "ReturnHandles");
+		if (!lua_isnil(L, -1)) options.ReturnHandles = checked_get<bool>(L, -1);
+		lua_pop(L, 6);
+	}
+
+	bool MatchesProximityQuery(IEoCServerObject* object, ProximityQueryOptions const& options)
+	{
+		if (options.Exclude) {
+			ObjectHandle handle;
+			object->GetObjectHandle(handle);
+			if (handle == options.Exclude) return false;
+		}
+
+		if (options.HasTag) {
+			auto tag = options.Tag;
+			if (!tag || !object->IsTagged(tag)) return false;
+		}
+
+		return true;
+	}
+
+	// Sorts the objects found by a proximity query by distance and pushes them as a list of GUIDs or handles
+	void PushProximityQueryResults(lua_State* L, std::vector<std::pair<float, IEoCServerObject*>>& results,
+		ProximityQueryOptions const& options)
+	{
+		auto byDistance = [](auto const& a, auto const& b) { return a.first < b.first; };
+		if (options.Limit > 0 && options.Limit < results.size()) {
+			std::partial_sort(results.begin(), results.begin() + options.Limit, results.end(), byDistance);
+			results.resize(options.Limit);
+		} else {
+			std::sort(results.begin(), results.end(), byDistance);
+		}
+
+		lua_createtable(L, (int)results.size(), 0);
+		for (uint32_t i = 0; i < results.size(); i++) {
+			push(L, i + 1);
+			if (options.ReturnHandles) {
+				ObjectHandle handle;
+				results[i].second->GetObjectHandle(handle);
+				push(L, (int64_t)handle);
+			} else {
+				push(L, results[i].second->MyGuid);
+			}
+			lua_settable(L, -3);
+		}
+	}
+
+	int GetCharactersAroundPosition(lua_State* L)
+	{
+		LuaServerPin lua(ExtensionState::Get());
+		if (lua->RestrictionFlags & State::RestrictOsiris) {
+			return luaL_error(L, "Attempted to query characters in restricted context");
+		}
+
+		glm::vec3 pos{ checked_get<float>(L, 1), checked_get<float>(L, 2), checked_get<float>(L, 3) };
+		auto radius = checked_get<float>(L, 4);
+		ProximityQueryOptions options;
+		GetProximityQueryOptions(L, 5, options);
+
+		static std::vector<std::pair<float, IEoCServerObject*>> results;
+		results.clear();
+		esv::gObjectSpatialIndex.QueryCharacters(pos, radius, [&options](esv::Character* character, float distSq) {
+			if (options.IsPlayer && *options.IsPlayer != (bool)(character->Flags & esv::CharacterFlags::IsPlayer)) return;
+			if (options.Dead && *options.Dead != (bool)(character->Flags & esv::CharacterFlags::Dead)) return;
+			if (!MatchesProximityQuery(character, options)) return;
+			results.push_back(std::make_pair(distSq, character));
+		});
+
+		PushProximityQueryResults(L, results, options);
+		return 1;
+	}
+
+	int GetItemsAroundPosition(lua_State* L)
+	{
+		LuaServerPin lua(ExtensionState::Get());
+		if (lua->RestrictionFlags & State::RestrictOsiris) {
+			return luaL_error(L, "Attempted to query items in restricted context");
+		}
+
+		glm::vec3 pos{ checked_get<float>(L, 1), checked_get<float>(L, 2), checked_get<float>(L, 3) };
+		auto radius = checked_get<float>(L, 4);
+		ProximityQueryOptions options;
+		GetProximityQueryOptions(L, 5, options);
+
+		static std::vector<std::pair<float, IEoCServerObject*>> results;
+		results.clear();
+		esv::gObjectSpatialIndex.QueryItems(pos, radius, [&options](esv::Item* item, float distSq) {
+			if (!MatchesProximityQuery(item, options)) return;
+			results.push_back(std::make_pair(distSq, item));
+		});
+
+		PushProximityQueryResults(L, results, options);
+		return 1;
+	}
+
 	int PlayerHasExtender(lua_State* L)
 	{
 		auto characterGuid = luaL_checkstring(L, 1);
@@ -1047,6 +1506,8 @@ namespace dse::esv::lua
 			{"GetTreasureTable", GetTreasureTable},
 			{"GetTreasureCategory", GetTreasureCategory},
 			{"StatGetAttribute", StatGetAttribute},
+			{"RunStatJob", RunStatJob},
+			{"GetStatJobResult", GetStatJobResult},
 			{"StatSetAttribute", StatSetAttribute},
 			{"StatAddCustomDescription", StatAddCustomDescription},
 			{"GetStat", GetStat},
@@ -1079,7 +1540,19 @@ namespace dse::esv::lua
 
 			{"BroadcastMessage", BroadcastMessage},
 			{"PostMessageToClient", PostMessageToClient},
+			{"BroadcastBinaryMessage", BroadcastBinaryMessage},
+			{"PostBinaryMessageToClient", PostBinaryMessageToClient},
+			{"SetMessageBatching", SetMessageBatching},
+			{"SetMessageBatchLimits", SetMessageBatchLimits},
+			{"GetMessageBatchStats", GetMessageBatchStats},
 			{"PlayerHasExtender", PlayerHasExtender},
+
+			{"EnableHitTracing", EnableHitTracing},
+			{"GetHitTraceStats", GetHitTraceStats},
+			{"DumpHitTrace", DumpHitTrace},
+			{"ApplyStatusToTargets", ApplyStatusToTargets},
+			{"GetCharactersAroundPosition", GetCharactersAroundPosition},
+			{"GetItemsAroundPosition", GetItemsAroundPosition},
 			{0,0}
 		};
 
@@ -1125,6 +1598,10 @@ namespace dse::esv::lua
 	std::optional<int32_t> ServerState::StatusGetEnterChance(esv::Status * status, bool isEnterCheck)
 	{
 		std::lock_guard lock(mutex_);
+		if (!HasListeners("StatusGetEnterChance")) {
+			return {};
+		}
+
 		Restriction restriction(*this, RestrictOsiris);
 
 		PushExtFunction(L, "_StatusGetEnterChance"); // stack: fn
@@ -1141,7 +1618,8 @@ namespace dse::esv::lua
 	}
 
 
-	void PushHit(lua_State* L, HitDamageInfo const& hit)
+	template <class TDamageList>
+	void PushHit(lua_State* L, HitDamageInfo const& hit, TDamageList const& damageList)
 	{
 		lua_newtable(L);
 		setfield(L, "Equipment", hit.Equipment);
@@ -1156,13 +1634,18 @@ namespace dse::esv::lua
 		setfield(L, "HitWithWeapon", hit.HitWithWeapon);
 
 		auto luaDamageList = DamageList::New(L);
-		for (auto const& dmg : hit.DamageList) {
+		for (auto const& dmg : damageList) {
 			luaDamageList->Get().SafeAdd(dmg);
 		}
 		
 		lua_setfield(L, -2, "DamageList");
 	}
 
+	void PushHit(lua_State* L, HitDamageInfo const& hit)
+	{
+		PushHit(L, hit, hit.DamageList);
+	}
+
 	bool PopHit(lua_State* L, HitDamageInfo& hit, int index)
 	{
 		luaL_checktype(L, index, LUA_TTABLE);
@@ -1201,7 +1684,7 @@ namespace dse::esv::lua
 		if (hit.CapturedCharacterHit) {
 			ObjectProxy<CDivinityStats_Item>::New(L, hit.WeaponStats);
 			lua_setfield(L, -2, "Weapon");
-			PushHit(L, hit.CharacterHit);
+			PushHit(L, hit.CharacterHit, hit.CharacterHitDamage);
 			lua_setfield(L, -2, "Hit");
 			setfield(L, "HitType", hit.HitType);
 			setfield(L, "NoHitRoll", hit.NoHitRoll);
@@ -1220,6 +1703,10 @@ namespace dse::esv::lua
 	void ServerState::OnStatusHitEnter(esv::StatusHit* hit, PendingHit* context)
 	{
 		std::lock_guard lock(mutex_);
+		if (!HasListeners("StatusHitEnter")) {
+			return;
+		}
+
 		Restriction restriction(*this, RestrictOsiris);
 
 		PushExtFunction(L, "_StatusHitEnter"); // stack: fn
@@ -1232,6 +1719,7 @@ namespace dse::esv::lua
 			lua_newtable(L);
 		}
 
+		ProfilerEventScope profile(L, "_StatusHitEnter");
 		if (CallWithTraceback(L, 2, 1) != 0) { // stack: succeeded
 			OsiError("StatusHitEnter handler failed: " << lua_tostring(L, -1));
 			lua_pop(L, 1);
@@ -1244,6 +1732,10 @@ namespace dse::esv::lua
 		CRPGStats_Object_Property_List *skillProperties, HighGroundBonus highGroundFlag, CriticalRoll criticalRoll)
 	{
 		std::lock_guard lock(mutex_);
+		if (!HasListeners("ComputeCharacterHit")) {
+			return false;
+		}
+
 		Restriction restriction(*this, RestrictOsiris);
 
 		PushExtFunction(L, "_ComputeCharacterHit"); // stack: fn
@@ -1278,6 +1770,7 @@ namespace dse::esv::lua
 		push(L, highGroundFlag);
 		push(L, criticalRoll);
 
+		ProfilerEventScope profile(L, "_ComputeCharacterHit");
 		if (CallWithTraceback(L, 11, 1) != 0) { // stack: succeeded
 			OsiError("ComputeCharacterHit handler failed: " << lua_tostring(L, -1));
 			lua_pop(L, 1);
@@ -1333,6 +1826,10 @@ namespace dse::esv::lua
 			CauseType causeType, glm::vec3& impactDirection, PendingHit* context)
 	{
 		std::lock_guard lock(mutex_);
+		if (!HasListeners("BeforeCharacterApplyDamage")) {
+			return false;
+		}
+
 		Restriction restriction(*this, RestrictOsiris);
 
 		PushExtFunction(L, "_BeforeCharacterApplyDamage"); // stack: fn
@@ -1368,6 +1865,7 @@ namespace dse::esv::lua
 			lua_newtable(L);
 		}
 
+		ProfilerEventScope profile(L, "_BeforeCharacterApplyDamage");
 		if (CallWithTraceback(L, 6, 1) != 0) { // stack: succeeded
 			OsiError("BeforeCharacterApplyDamage handler failed: " << lua_tostring(L, -1));
 			lua_pop(L, 1);
@@ -1403,6 +1901,10 @@ namespace dse::esv::lua
 	bool ServerState::OnUpdateTurnOrder(esv::TurnManager * self, uint8_t combatId)
 	{
 		std::lock_guard lock(mutex_);
+		if (!HasListeners("CalculateTurnOrder")) {
+			return false;
+		}
+
 		Restriction restriction(*this, RestrictOsiris);
 
 		auto turnMgr = GetEntityWorld()->GetTurnManager();
@@ -1422,6 +1924,7 @@ namespace dse::esv::lua
 		TurnManagerCombatProxy::New(L, combatId); // stack: fn, combat
 		CombatTeamListToLua(L, combat->NextRoundTeams.Set);
 
+		ProfilerEventScope profile(L, "_CalculateTurnOrder");
 		if (CallWithTraceback(L, 2, 1) != 0) { // stack: retval
 			OsiError("OnUpdateTurnOrder handler failed: " << lua_tostring(L, -1));
 			lua_pop(L, 1);
@@ -1450,28 +1953,87 @@ namespace dse::esv::lua
 		std::lock_guard lock(mutex_);
 		Restriction restriction(*this, RestrictAll);
 
-		PushExtFunction(L, "_GetModPersistentVars");
-		push(L, modTable);
+		auto top = lua_gettop(L);
+		PushExtFunction(L, "_GetModPersistentVars"); // stack: fn
+		push(L, modTable); // stack: fn, modTable
 
-		auto ret = CheckedCall<std::optional<char const*>>(L, 1, "Ext.GetModPersistentVars");
-		if (ret) {
-			return std::get<0>(*ret);
-		} else {
+		ProfilerEventScope profile(L, "Ext.GetModPersistentVars");
+		if (CallWithTraceback(L, 1, 1) != LUA_OK) { // stack: vars
+			OsiError("Ext.GetModPersistentVars failed: " << lua_tostring(L, -1));
+			lua_settop(L, top);
+			return {};
+		}
+
+		if (lua_isnil(L, -1)) {
+			lua_settop(L, top);
+			return {};
+		}
+
+		// stack: vars
+		// Hashing is much cheaper than serializing, so unchanged variables reuse the previous blob
+		auto hash = persistence::Hash(L, top + 1);
+		auto cached = persistentVarsCache_.find(modTable);
+		if (hash && cached != persistentVarsCache_.end() && cached->second.Hash == *hash) {
+			lua_settop(L, top);
+			return cached->second.Blob;
+		}
+
+		STDString blob;
+		try {
+			persistence::Serialize(L, top + 1, blob);
+		} catch (std::runtime_error& e) {
+			OsiError("Failed to serialize persistent variables of mod table '" << modTable << "': " << e.what());
+			lua_settop(L, top);
 			return {};
 		}
+
+		if (hash) {
+			auto& entry = persistentVarsCache_[modTable];
+			entry.Hash = *hash;
+			entry.Blob = blob;
+		} else {
+			persistentVarsCache_.erase(modTable);
+		}
+
+		lua_settop(L, top);
+		return blob;
 	}
 
 
-	void ServerState::RestoreModPersistentVars(STDString const& modTable, STDString const& vars)
+	void ServerState::RestoreModPersistentVars(STDString const& modTable, STDString const& vars, bool legacyJson)
 	{
 		std::lock_guard lock(mutex_);
 		Restriction restriction(*this, RestrictAll);
 
-		PushExtFunction(L, "_RestoreModPersistentVars");
+		auto top = lua_gettop(L);
+		STDString error;
+		if (legacyJson) {
+			if (!json::Parse(L, StringView(vars), error)) {
+				OsiError("Failed to parse persistent variables of mod table '" << modTable << "': " << error);
+				return;
+			}
+		} else if (!persistence::Deserialize(L, StringView(vars), error)) {
+			OsiError("Failed to load persistent variables of mod table '" << modTable << "': " << error);
+			return;
+		}
+
+		// stack: vars
+		// The restored variables are identical to the blob until the mod changes them
+		auto hash = legacyJson ? std::optional<uint64_t>() : persistence::Hash(L, top + 1);
+		PushExtFunction(L, "_RestoreModPersistentVars"); // stack: vars, fn
 		push(L, modTable);
-		push(L, vars);
+		lua_pushvalue(L, top + 1); // stack: vars, fn, modTable, vars
+
+		ProfilerEventScope profile(L, "Ext.RestoreModPersistentVars");
+		if (CallWithTraceback(L, 2, 0) != LUA_OK) {
+			OsiError("Ext.RestoreModPersistentVars failed: " << lua_tostring(L, -1));
+		} else if (hash) {
+			auto& entry = persistentVarsCache_[modTable];
+			entry.Hash = *hash;
+			entry.Blob = vars;
+		}
 
-		CheckedCall<>(L, 2, "Ext.RestoreModPersistentVars");
+		lua_settop(L, top);
 	}
 
 
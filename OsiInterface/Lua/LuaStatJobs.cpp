@@ -0,0 +1,534 @@
+#include <stdafx.h>
+#include <Lua/LuaStatJobs.h>
+#include <Lua/LuaBinding.h>
+#include <Lua/LuaJson.h>
+#include <chrono>
+#include <limits>
+
+namespace dse::lua
+{
+	StatJobManager gStatJobs;
+
+	namespace
+	{
+		// Registry key of the snapshot used by the job running in the Lua state
+		char const* const SnapshotRegistryKey = "StatJobSnapshot";
+		// Registry key of the job deadline
+		char const* const DeadlineRegistryKey = "StatJobDeadline";
+
+#if LUA_VERSION_NUM > 501
+		static const luaL_Reg jobLibs[] = {
+		  {"_G", luaopen_base},
+		  {LUA_TABLIBNAME, luaopen_table},
+		  {LUA_STRLIBNAME, luaopen_string},
+		  {LUA_MATHLIBNAME, luaopen_math},
+		  {NULL, NULL}
+		};
+#else
+		static const luaL_Reg jobLibs[] = {
+		  {"", luaopen_base},
+		  {LUA_TABLIBNAME, luaopen_table},
+		  {LUA_STRLIBNAME, luaopen_string},
+		  {LUA_MATHLIBNAME, luaopen_math},
+		  {LUA_BITLIBNAME, luaopen_bit},
+		  {NULL, NULL}
+		};
+#endif
+
+		void OpenJobLibs(lua_State* L)
+		{
+			for (auto lib = jobLibs; lib->func; lib++) {
+#if LUA_VERSION_NUM > 501
+				luaL_requiref(L, lib->name, lib->func, 1);
+				lua_pop(L, 1);
+#else
+				lua_pushcfunction(L, lib->func);
+				lua_pushstring(L, lib->name);
+				lua_call(L, 1, 0);
+#endif
+			}
+
+			// Jobs must not access the filesystem or load precompiled bytecode, which Lua doesn't verify
+			lua_pushnil(L);
+			lua_setglobal(L, "dofile");
+			lua_pushnil(L);
+			lua_setglobal(L, "loadfile");
+			lua_pushnil(L);
+			lua_setglobal(L, "load");
+			lua_pushnil(L);
+			lua_setglobal(L, "loadstring");
+		}
+
+		struct JobAllocator
+		{
+			std::size_t Used{ 0 };
+			// Only enforced while the job script is running
+			std::size_t Limit{ std::numeric_limits<std::size_t>::max() };
+		};
+
+		void* JobAlloc(void* ud, void* ptr, size_t osize, size_t nsize)
+		{
+			auto allocator = reinterpret_cast<JobAllocator*>(ud);
+			// When ptr is null, osize holds the type of the object being allocated
+			auto oldSize = (ptr != nullptr) ? osize : 0;
+			if (nsize == 0) {
+				free(ptr);
+				allocator->Used -= oldSize;
+				return nullptr;
+			}
+
+			if (nsize > oldSize && allocator->Used + (nsize - oldSize) > allocator->Limit) {
+				return nullptr;
+			}
+
+			auto newPtr = realloc(ptr, nsize);
+			if (newPtr != nullptr) {
+				allocator->Used = allocator->Used - oldSize + nsize;
+			}
+
+			return newPtr;
+		}
+
+		StatSnapshot const& GetSnapshot(lua_State* L)
+		{
+			lua_getfield(L, LUA_REGISTRYINDEX, SnapshotRegistryKey);
+			auto snapshot = (StatSnapshot const*)lua_touserdata(L, -1);
+			lua_pop(L, 1);
+			return *snapshot;
+		}
+
+		void RequirementsToLua(lua_State* L, std::vector<StatRequirement> const& requirements)
+		{
+			lua_newtable(L);
+			int index = 1;
+			for (auto const& requirement : requirements) {
+				push(L, index++);
+				lua_newtable(L);
+				auto requirementType = (RequirementType)requirement.requirement();
+				auto label = EnumInfo<RequirementType>::Find(requirementType);
+				if (label) {
+					setfield(L, "Requirement", label);
+				}
+
+				if (requirementType == RequirementType::Tag) {
+					setfield(L, "Param", StringView(requirement.string_param()));
+				} else {
+					setfield(L, "Param", requirement.int_param());
+				}
+
+				setfield(L, "Not", requirement.negate());
+				lua_settable(L, -3);
+			}
+		}
+
+		// Property lists are returned in the raw form used by the stats sync message
+		void PropertyListToLua(lua_State* L, StatPropertyList const& propertyList)
+		{
+			lua_newtable(L);
+			int index = 1;
+			for (auto const& property : propertyList.properties()) {
+				push(L, index++);
+				lua_newtable(L);
+				setfield(L, "Name", StringView(property.name()));
+				auto label = EnumInfo<CRPGStats_Object_Property_Type>::Find((CRPGStats_Object_Property_Type)property.type());
+				if (label) {
+					setfield(L, "Type", label);
+				}
+
+				setfield(L, "Context", property.property_context());
+				if (!property.conditions().empty()) {
+					setfield(L, "Condition", StringView(property.conditions()));
+				}
+
+				lua_newtable(L);
+				for (int i = 0; i < property.string_params_size(); i++) {
+					settable(L, i + 1, StringView(property.string_params(i)));
+				}
+				lua_setfield(L, -2, "StringParams");
+
+				lua_newtable(L);
+				for (int i = 0; i < property.int_params_size(); i++) {
+					settable(L, i + 1, property.int_params(i));
+				}
+				lua_setfield(L, -2, "IntParams");
+
+				lua_newtable(L);
+				for (int i = 0; i < property.float_params_size(); i++) {
+					settable(L, i + 1, (double)property.float_params(i));
+				}
+				lua_setfield(L, -2, "FloatParams");
+
+				lua_newtable(L);
+				for (int i = 0; i < property.bool_params_size(); i++) {
+					settable(L, i + 1, property.bool_params(i));
+				}
+				lua_setfield(L, -2, "BoolParams");
+
+				lua_settable(L, -3);
+			}
+		}
+
+		int JobStatGetAttribute(lua_State* L)
+		{
+			auto statName = luaL_checkstring(L, 1);
+			auto attributeName = luaL_checkstring(L, 2);
+			auto const& snapshot = GetSnapshot(L);
+
+			auto entry = snapshot.Find(statName);
+			if (entry == nullptr) {
+				return 0;
+			}
+
+			auto attribute = snapshot.FindAttribute(*entry, attributeName);
+			if (attribute == nullptr) {
+				return luaL_error(L, "Stat object '%s' has no attribute named '%s'", statName, attributeName);
+			}
+
+			switch (attribute->Special) {
+			case StatAttributeSpecial::Level:
+				push(L, entry->Level);
+				return 1;
+
+			case StatAttributeSpecial::Name:
+				push(L, entry->Name);
+				return 1;
+
+			case StatAttributeSpecial::ModId:
+				push(L, entry->ModId);
+				return 1;
+
+			case StatAttributeSpecial::Using:
+				if (entry->Using) {
+					push(L, entry->Using);
+					return 1;
+				}
+
+				return 0;
+
+			case StatAttributeSpecial::Requirements:
+				RequirementsToLua(L, entry->Requirements);
+				return 1;
+
+			case StatAttributeSpecial::MemorizationRequirements:
+				RequirementsToLua(L, entry->MemorizationRequirements);
+				return 1;
+
+			case StatAttributeSpecial::AIFlags:
+				push(L, entry->AIFlags);
+				return 1;
+
+			case StatAttributeSpecial::ComboCategory:
+			{
+				lua_newtable(L);
+				auto index = 1;
+				for (auto const& category : entry->ComboCategories) {
+					settable(L, index++, category);
+				}
+				return 1;
+			}
+
+			case StatAttributeSpecial::PropertyList:
+				for (auto const& propertyList : entry->PropertyLists) {
+					if (propertyList.name() == attributeName) {
+						PropertyListToLua(L, propertyList);
+						return 1;
+					}
+				}
+
+				return 0;
+
+			default:
+				break;
+			}
+
+			if (attribute->Type == StatAttributeType::Conditions) {
+				return luaL_error(L, "Conditions property '%s' is not readable", attributeName);
+			}
+
+			auto value = snapshot.GetString(*entry, *attribute);
+			if (value) {
+				push(L, *value);
+				return 1;
+			}
+
+			auto intValue = snapshot.GetInt(*entry, *attribute);
+			if (intValue) {
+				push(L, *intValue);
+				return 1;
+			}
+
+			return 0;
+		}
+
+		int JobGetStatEntries(lua_State* L)
+		{
+			auto const& snapshot = GetSnapshot(L);
+			int32_t modifierListIndex{ -1 };
+			if (!lua_isnoneornil(L, 1)) {
+				auto typeName = luaL_checkstring(L, 1);
+				auto it = snapshot.Tables->ModifierListIndices.find(typeName);
+				if (it == snapshot.Tables->ModifierListIndices.end()) {
+					return luaL_error(L, "Unknown stats entry type: %s", typeName);
+				}
+
+				modifierListIndex = it->second;
+			}
+
+			lua_newtable(L);
+			int32_t index = 1;
+			for (auto const& entry : snapshot.Entries) {
+				if (modifierListIndex == -1 || entry->ModifierListIndex == modifierListIndex) {
+					settable(L, index++, entry->Name);
+				}
+			}
+
+			return 1;
+		}
+
+		int JobStatSnapshotVersion(lua_State* L)
+		{
+			push(L, GetSnapshot(L).Version);
+			return 1;
+		}
+
+		int JobPrint(lua_State* L)
+		{
+			STDString msg("[StatJob] ");
+			int nargs = lua_gettop(L);
+			for (int i = 1; i <= nargs; i++) {
+				size_t length;
+				auto str = lua_tolstring(L, i, &length);
+				if (str == nullptr) {
+					str = luaL_typename(L, i);
+					length = strlen(str);
+				}
+
+				if (i > 1) {
+					msg += ' ';
+				}
+				msg.append(str, length);
+			}
+
+			gConsole.Debug(DebugMessageType::Info, msg.c_str());
+			return 0;
+		}
+
+		void RegisterJobExtLib(lua_State* L, StatSnapshot const& snapshot)
+		{
+			static const luaL_Reg extLib[] = {
+				{"StatGetAttribute", JobStatGetAttribute},
+				{"GetStatEntries", JobGetStatEntries},
+				{"StatSnapshotVersion", JobStatSnapshotVersion},
+				{"Print", JobPrint},
+				{"Round", LuaRound},
+				{0,0}
+			};
+
+			lua_newtable(L);
+#if LUA_VERSION_NUM > 501
+			luaL_setfuncs(L, extLib, 0);
+#else
+			luaL_register(L, NULL, extLib);
+#endif
+
+			lua_newtable(L);
+			for (auto const& extraData : snapshot.Tables->ExtraData) {
+				settable(L, extraData.first, (double)extraData.second);
+			}
+			lua_setfield(L, -2, "ExtraData");
+
+			lua_setglobal(L, "Ext");
+		}
+
+		void JobTimeoutHook(lua_State* L, lua_Debug* ar)
+		{
+			lua_getfield(L, LUA_REGISTRYINDEX, DeadlineRegistryKey);
+			auto deadline = (int64_t)lua_tonumber(L, -1);
+			lua_pop(L, 1);
+
+			auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+			if (now > deadline) {
+				luaL_error(L, "Stat job exceeded the maximum run time of %d ms", (int)StatJobManager::MaxJobTimeMs);
+			}
+		}
+	}
+
+	uint32_t StatJobManager::Submit(STDString const& script, STDString const& inputJson)
+	{
+		auto snapshot = gStatSnapshots.Acquire();
+		if (!snapshot) {
+			return 0;
+		}
+
+		std::lock_guard lock(mutex_);
+		auto jobId = nextJobId_++;
+		jobs_.push_back(Job{ jobId, script, inputJson, std::move(snapshot) });
+		pending_.insert(jobId);
+
+		if (workerThread_ == nullptr) {
+			workerThread_ = new std::thread(&StatJobManager::WorkerThread, this);
+		}
+
+		jobAdded_.notify_one();
+		return jobId;
+	}
+
+	StatJobManager::JobStatus StatJobManager::TakeResult(uint32_t jobId, STDString& result)
+	{
+		std::lock_guard lock(mutex_);
+		auto it = results_.find(jobId);
+		if (it != results_.end()) {
+			auto status = it->second.Succeeded ? JobStatus::Succeeded : JobStatus::Failed;
+			result = std::move(it->second.Value);
+			results_.erase(it);
+			return status;
+		}
+
+		if (pending_.find(jobId) != pending_.end()) {
+			return JobStatus::Pending;
+		} else {
+			return JobStatus::Unknown;
+		}
+	}
+
+	void StatJobManager::WorkerThread()
+	{
+		for (;;) {
+			Job job;
+			{
+				std::unique_lock lock(mutex_);
+				jobAdded_.wait(lock, [this]() { return !jobs_.empty(); });
+				job = std::move(jobs_.front());
+				jobs_.pop_front();
+			}
+
+			STDString result;
+			bool succeeded = RunJob(job, result);
+			// Release the snapshot before publishing the result, so the old version
+			// can be freed even if nobody picks up the result
+			job.Snapshot.reset();
+
+			std::lock_guard lock(mutex_);
+			pending_.erase(job.Id);
+			results_.insert(std::make_pair(job.Id, Result{ succeeded, std::move(result) }));
+		}
+	}
+
+	bool StatJobManager::RunJob(Job const& job, STDString& result)
+	{
+		// A new Lua state is used for each job, so jobs can't leave state behind
+		JobAllocator allocator;
+		auto L = lua_newstate(&JobAlloc, &allocator);
+		if (L == nullptr) {
+			result = "Failed to create Lua state";
+			return false;
+		}
+
+		OpenJobLibs(L);
+		lua_pushlightuserdata(L, const_cast<StatSnapshot*>(job.Snapshot.get()));
+		lua_setfield(L, LUA_REGISTRYINDEX, SnapshotRegistryKey);
+		RegisterJobExtLib(L, *job.Snapshot);
+
+		int nargs = 0;
+		if (!job.Input.empty()) {
+			if (!json::Parse(L, job.Input, result)) {
+				lua_close(L);
+				return false;
+			}
+
+			nargs = 1;
+		}
+
+		auto deadline = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count() + MaxJobTimeMs;
+		lua_pushnumber(L, (lua_Number)deadline);
+		lua_setfield(L, LUA_REGISTRYINDEX, DeadlineRegistryKey);
+		lua_sethook(L, &JobTimeoutHook, LUA_MASKCOUNT, 100000);
+
+		bool succeeded{ false };
+		allocator.Limit = allocator.Used + MaxJobMemory;
+		int status = luaL_loadbufferx(L, job.Script.c_str(), job.Script.size(), "=StatJob", "text");
+		if (status == LUA_OK) {
+			lua_insert(L, -1 - nargs);
+			status = lua_pcall(L, nargs, 1, 0);
+		}
+
+		// The result is converted outside of a protected call, where allocations must not fail
+		allocator.Limit = std::numeric_limits<std::size_t>::max();
+		if (status == LUA_ERRMEM) {
+			char msg[128];
+			sprintf_s(msg, "Stat job exceeded the memory limit of %d MB", (int)(MaxJobMemory / (1024 * 1024)));
+			result = msg;
+		} else if (status != LUA_OK) {
+			result = lua_tostring(L, -1);
+		} else if (lua_isnil(L, -1)) {
+			succeeded = true;
+		} else {
+			try {
+				json::Stringify(L, -1, false, result);
+				succeeded = true;
+			} catch (std::runtime_error& e) {
+				result = e.what();
+			}
+		}
+
+		lua_close(L);
+		return succeeded;
+	}
+
+
+	int RunStatJob(lua_State* L)
+	{
+		size_t length;
+		auto script = luaL_checklstring(L, 1, &length);
+
+		STDString input;
+		if (!lua_isnoneornil(L, 2)) {
+			try {
+				json::Stringify(L, 2, false, input);
+			} catch (std::runtime_error& e) {
+				return luaL_error(L, "Stat job input is not serializable: %s", e.what());
+			}
+		}
+
+		auto jobId = gStatJobs.Submit(STDString(script, length), input);
+		if (jobId == 0) {
+			return luaL_error(L, "Stats snapshot not available; stat jobs can only be run after the stats were loaded");
+		}
+
+		push(L, jobId);
+		return 1;
+	}
+
+	int GetStatJobResult(lua_State* L)
+	{
+		auto jobId = (uint32_t)luaL_checkinteger(L, 1);
+
+		STDString result;
+		switch (gStatJobs.TakeResult(jobId, result)) {
+		case StatJobManager::JobStatus::Pending:
+			return 0;
+
+		case StatJobManager::JobStatus::Succeeded:
+			push(L, true);
+			if (result.empty()) {
+				lua_pushnil(L);
+			} else {
+				STDString error;
+				if (!json::Parse(L, result, error)) {
+					return luaL_error(L, "Unable to parse stat job result: %s", error.c_str());
+				}
+			}
+			return 2;
+
+		case StatJobManager::JobStatus::Failed:
+			push(L, false);
+			push(L, result);
+			return 2;
+
+		default:
+			return luaL_error(L, "Unknown stat job: %d", jobId);
+		}
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <GameDefinitions/BaseTypes.h>
+#include <StatSnapshot.h>
+#include <lua.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace dse::lua
+{
+	// Runs Lua scripts that only read stats data on a worker thread.
+	// Each job gets its own Lua state with a minimal Ext library that reads from
+	// the stats snapshot that was current when the job was submitted.
+	// Jobs are run one at a time, in the order they were submitted.
+	class StatJobManager
+	{
+	public:
+		// Jobs are aborted if they run longer than this
+		static constexpr unsigned MaxJobTimeMs = 10000;
+		// Jobs are aborted if their Lua state grows larger than this
+		static constexpr std::size_t MaxJobMemory = 128 * 1024 * 1024;
+
+		enum class JobStatus
+		{
+			Unknown,
+			Pending,
+			Succeeded,
+			Failed
+		};
+
+		// Returns 0 if no stats snapshot is available
+		uint32_t Submit(STDString const& script, STDString const& inputJson);
+		// Returns the JSON result (or error message) of a finished job and forgets the job
+		JobStatus TakeResult(uint32_t jobId, STDString& result);
+
+	private:
+		struct Job
+		{
+			uint32_t Id;
+			STDString Script;
+			STDString Input;
+			std::shared_ptr<StatSnapshot const> Snapshot;
+		};
+
+		struct Result
+		{
+			bool Succeeded;
+			STDString Value;
+		};
+
+		std::mutex mutex_;
+		std::condition_variable jobAdded_;
+		std::deque<Job> jobs_;
+		std::unordered_map<uint32_t, Result> results_;
+		std::unordered_set<uint32_t> pending_;
+		std::thread* workerThread_{ nullptr };
+		uint32_t nextJobId_{ 1 };
+
+		void WorkerThread();
+		bool RunJob(Job const& job, STDString& result);
+	};
+
+	extern StatJobManager gStatJobs;
+}
@@ -73,17 +73,14 @@ end
 Ext._GetModPersistentVars = function (modTable)
 	local tab = Mods[modTable]
 	if tab ~= nil then
-		local persistent = tab.PersistentVars
-		if persistent ~= nil then
-			return Ext.JsonStringify(persistent)
-		end
+		return tab.PersistentVars
 	end
 end
 
 Ext._RestoreModPersistentVars = function (modTable, vars)
 	local tab = Mods[modTable]
 	if tab ~= nil then
-		tab.PersistentVars = Ext.JsonParse(vars)
+		tab.PersistentVars = vars
 	end
 end
 
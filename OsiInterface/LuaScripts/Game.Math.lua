@@ -7,6 +7,7 @@ local Ext = Ext
 Game = {
     Math = {}
 }
+local GameMath = Game.Math
 
 _ENV = Game.Math
 if setfenv ~= nil then
@@ -421,6 +422,14 @@ function ComputeBaseWeaponDamage(weapon)
     return damages, damageBoost
 end
 
+-- Damage types in DamageType enumeration order.
+-- Weapon damages are rolled in this order, as the iteration order of pairs() over
+-- string keys is different in each Lua state.
+local DamageTypeOrder = {
+    "None", "Physical", "Piercing", "Corrosive", "Magic", "Chaos", "Fire",
+    "Air", "Water", "Earth", "Poison", "Shadow", "Sulfuric", "Sentinel"
+}
+
 -- from CDivinityStats_Character::CalculateWeaponDamageInner and CDivinityStats_Item::ComputeScaledDamage
 --- @param character StatCharacter
 --- @param weapon StatItem
@@ -439,23 +448,27 @@ function CalculateWeaponScaledDamage(character, weapon, damageList, noRandomizat
         boost = boost + Ext.ExtraData['Sneak Damage Multiplier']
     end
 
-    for damageType, damage in pairs(damages) do
-        local min = math.ceil(damage.Min * boost * abilityBoosts)
-        local max = math.ceil(damage.Max * boost * abilityBoosts)
+    for i = 1, #DamageTypeOrder do
+        local damageType = DamageTypeOrder[i]
+        local damage = damages[damageType]
+        if damage ~= nil then
+            local min = math.ceil(damage.Min * boost * abilityBoosts)
+            local max = math.ceil(damage.Max * boost * abilityBoosts)
 
-        local randRange = 1
-        if max - min >= 1 then
-            randRange = max - min
-        end
+            local randRange = 1
+            if max - min >= 1 then
+                randRange = max - min
+            end
 
-        local finalAmount
-        if noRandomization then
-            finalAmount = min + math.floor(randRange / 2)
-        else
-            finalAmount = min + Ext.Random(0, randRange)
-        end
+            local finalAmount
+            if noRandomization then
+                finalAmount = min + math.floor(randRange / 2)
+            else
+                finalAmount = min + Ext.Random(0, randRange)
+            end
 
-        damageList:Add(damageType, finalAmount)
+            damageList:Add(damageType, finalAmount)
+        end
     end
 end
 
@@ -906,7 +919,7 @@ function DoHit(hit, damageList, statusBonusDmgTypes, hitType, target, attacker)
     hit.DamageList = Ext.NewDamageList()
 
     for i,damageType in pairs(statusBonusDmgTypes) do
-        damageList.Add(damageType, math.ceil(totalDamage * 0.1))
+        damageList:Add(damageType, math.ceil(totalDamage * 0.1))
     end
 
     ApplyDamagesToHitInfo(damageList, hit)
@@ -1323,3 +1336,160 @@ function StatusGetEnterChance(status, isEnterCheck)
       
     return status.CanEnterChance
 end
+
+
+
+-- Native implementations of the damage and hit formulas (GameMath.cpp).
+-- They return the same results as the Lua functions above, and are used as long as no mod
+-- has replaced a function or table the formula reads, or math.random. Otherwise, or if the
+-- native code can't handle its arguments, the Lua implementation runs.
+local NativeMath = Ext._GameMath
+if NativeMath ~= nil then
+    local LuaGetSkillDamage = GetSkillDamage
+    local LuaCalculateWeaponDamage = CalculateWeaponDamage
+    local LuaGetSkillDamageRange = GetSkillDamageRange
+    local LuaCalculateHitChance = CalculateHitChance
+    local LuaComputeCharacterHit = ComputeCharacterHit
+
+    -- Snapshot of the values each native formula takes as given, see TakeSnapshot()
+    local Snapshots = {}
+
+    local function IsPristine(snapshot)
+        local tables, keys, values = snapshot.Tables, snapshot.Keys, snapshot.Values
+        for i = 1, snapshot.Count do
+            if tables[i][keys[i]] ~= values[i] then
+                return false
+            end
+        end
+
+        return true
+    end
+
+    function GetSkillDamage(skill, attacker, isFromItem, stealthed, attackerPos, targetPos, level, noRandomization)
+        if IsPristine(Snapshots.GetSkillDamage) then
+            local handled, damageList, deathType = NativeMath.GetSkillDamage(skill, attacker, isFromItem, stealthed,
+                attackerPos, targetPos, level, noRandomization)
+            if handled then
+                if damageList == nil then
+                    return
+                end
+                return damageList, deathType
+            end
+        end
+
+        return LuaGetSkillDamage(skill, attacker, isFromItem, stealthed, attackerPos, targetPos, level, noRandomization)
+    end
+
+    function CalculateWeaponDamage(attacker, weapon, noRandomization)
+        if IsPristine(Snapshots.CalculateWeaponDamage) then
+            local handled, damageList = NativeMath.CalculateWeaponDamage(attacker, weapon, noRandomization)
+            if handled then
+                return damageList
+            end
+        end
+
+        return LuaCalculateWeaponDamage(attacker, weapon, noRandomization)
+    end
+
+    function GetSkillDamageRange(character, skill)
+        if IsPristine(Snapshots.GetSkillDamageRange) then
+            local handled, damageRanges = NativeMath.GetSkillDamageRange(character, skill)
+            if handled then
+                return damageRanges
+            end
+        end
+
+        return LuaGetSkillDamageRange(character, skill)
+    end
+
+    function CalculateHitChance(attacker, target)
+        if IsPristine(Snapshots.CalculateHitChance) then
+            local handled, hitChance = NativeMath.CalculateHitChance(attacker, target)
+            if handled then
+                return hitChance
+            end
+        end
+
+        return LuaCalculateHitChance(attacker, target)
+    end
+
+    function ComputeCharacterHit(target, attacker, weapon, damageList, hitType, noHitRoll, forceReduceDurability, hit, alwaysBackstab, highGroundFlag, criticalRoll)
+        if IsPristine(Snapshots.ComputeCharacterHit) then
+            -- The hit roll and durability check call back into Lua
+            local handled = NativeMath.ComputeCharacterHit(math.random, ConditionalDamageItemDurability,
+                target, attacker, weapon, damageList, hitType, noHitRoll, forceReduceDurability, hit,
+                alwaysBackstab, highGroundFlag, criticalRoll)
+            if handled then
+                return hit
+            end
+        end
+
+        return LuaComputeCharacterHit(target, attacker, weapon, damageList, hitType, noHitRoll, forceReduceDurability, hit, alwaysBackstab, highGroundFlag, criticalRoll)
+    end
+
+    -- Records the identity of the Game.Math functions and tables a formula reads (directly or
+    -- through the functions it calls), of every damage type entry of the damage type maps it
+    -- reads, and of math.random. IsPristine() compares them on each call, so replacing any
+    -- of them, with rawset() too, switches the formula back to the Lua implementation.
+    -- The values of HitFlag are engine constants and aren't tracked.
+    local function TakeSnapshot(names, damageTypeMaps)
+        local snapshot = { Tables = {}, Keys = {}, Values = {}, Count = 0 }
+        local function Track(tbl, key)
+            local n = snapshot.Count + 1
+            snapshot.Tables[n] = tbl
+            snapshot.Keys[n] = key
+            snapshot.Values[n] = tbl[key]
+            snapshot.Count = n
+        end
+
+        for i = 1, #names do
+            Track(GameMath, names[i])
+        end
+
+        for i = 1, #damageTypeMaps do
+            Track(GameMath, damageTypeMaps[i])
+            local map = GameMath[damageTypeMaps[i]]
+            for j = 1, #DamageTypeOrder do
+                Track(map, DamageTypeOrder[j])
+            end
+        end
+
+        Track(math, "random")
+        return snapshot
+    end
+
+    local WeaponDamageFunctions = {
+        "ApplyDamageBoosts", "CalculateWeaponScaledDamage", "ComputeBaseWeaponDamage",
+        "ComputeWeaponCombatAbilityBoost", "ComputeWeaponRequirementScaledDamage",
+        "GetDamageBoostByType", "GetWeaponAbility", "GetWeaponScalingRequirement",
+        "IsRangedWeapon", "ScaledDamageFromPrimaryAttribute"
+    }
+
+    Snapshots.CalculateWeaponDamage = TakeSnapshot(WeaponDamageFunctions, {"DamageBoostTable"})
+
+    Snapshots.GetSkillDamage = TakeSnapshot({
+        "CalculateBaseDamage", "CalculateWeaponDamage", "DamageTypeToDeathType",
+        "GetDamageListDeathType", "GetDamageMultipliers", "GetItemRequirementAttribute",
+        "GetPrimaryAttributeAmount", "GetSkillAttributeDamageScale", table.unpack(WeaponDamageFunctions)
+    }, {"DamageBoostTable", "DamageTypeToDeathTypeMap"})
+
+    Snapshots.GetSkillDamageRange = TakeSnapshot({
+        "CalculateBaseDamage", "CalculateWeaponDamageRange", "ComputeBaseWeaponDamage",
+        "ComputeWeaponCombatAbilityBoost", "ComputeWeaponRequirementScaledDamage",
+        "GetDamageBoostByType", "GetItemRequirementAttribute", "GetPrimaryAttributeAmount",
+        "GetSkillAttributeDamageScale", "GetWeaponAbility", "GetWeaponScalingRequirement",
+        "IsRangedWeapon", "ScaledDamageFromPrimaryAttribute"
+    }, {"DamageBoostTable"})
+
+    Snapshots.CalculateHitChance = TakeSnapshot({"IsRangedWeapon"}, {})
+
+    Snapshots.ComputeCharacterHit = TakeSnapshot({
+        "ApplyCriticalHit", "ApplyDamageCharacterBonuses", "ApplyDamageSkillAbilityBonuses",
+        "ApplyDamagesToHitInfo", "ApplyHitResistances", "ApplyLifeSteal", "CalculateHitChance",
+        "CanBackstab", "ConditionalApplyCriticalHitMultiplier", "ConditionalDamageItemDurability",
+        "DamageItemDurability", "DoHit", "GetAbilityCriticalHitMultiplier",
+        "GetAttackerDamageMultiplier", "GetCriticalHitMultiplier", "GetResistance",
+        "GetWeaponAbility", "HitFlag", "IsInFlankingPosition", "IsRangedWeapon",
+        "ShouldApplyCriticalHit"
+    }, {})
+end
@@ -0,0 +1,238 @@
+// Compiled without the precompiled header, so the standalone harness can build it as well
+#include "NetMessageFragments.h"
+#include <algorithm>
+#include <lz4.h>
+
+namespace dse::net
+{
+	bool CompressLZ4(std::string_view input, std::string& output)
+	{
+		if (input.size() > LZ4_MAX_INPUT_SIZE) {
+			return false;
+		}
+
+		output.resize(LZ4_compressBound((int)input.size()));
+		auto compressedSize = LZ4_compress_default(input.data(), output.data(), (int)input.size(), (int)output.size());
+		if (compressedSize <= 0) {
+			output.clear();
+			return false;
+		}
+
+		output.resize(compressedSize);
+		return true;
+	}
+
+	bool DecompressLZ4(std::string_view input, std::size_t size, std::string& output)
+	{
+		if (input.size() > LZ4_MAX_INPUT_SIZE || size > LZ4_MAX_INPUT_SIZE) {
+			return false;
+		}
+
+		output.resize(size);
+		auto decompressedSize = LZ4_decompress_safe(input.data(), output.data(), (int)input.size(), (int)size);
+		if (decompressedSize < 0 || (std::size_t)decompressedSize != size) {
+			output.clear();
+			return false;
+		}
+
+		return true;
+	}
+
+
+	bool FragmentWriter::ShouldFragment(std::size_t size, uint32_t capabilities)
+	{
+		if (!(capabilities & (uint32_t)ExtenderCapabilities::Fragmentation)) {
+			return false;
+		}
+
+		return size > FragmentSize
+			|| (size > CompressionThreshold && (capabilities & (uint32_t)ExtenderCapabilities::LZ4Compression));
+	}
+
+	void FragmentWriter::Split(uint32_t channel, std::string_view payload, uint32_t capabilities,
+		std::vector<MessageFragment>& fragments)
+	{
+		auto sequence = sequences_[channel]++;
+
+		auto compression = FragmentCompression::None;
+		std::string compressed;
+		std::string_view data = payload;
+		if (payload.size() > CompressionThreshold
+			&& (capabilities & (uint32_t)ExtenderCapabilities::LZ4Compression)
+			&& CompressLZ4(payload, compressed)
+			&& compressed.size() < payload.size()) {
+			compression = FragmentCompression::LZ4;
+			data = compressed;
+		}
+
+		auto count = std::max<std::size_t>(1, (data.size() + FragmentSize - 1) / FragmentSize);
+		fragments.clear();
+		fragments.resize(count);
+		for (std::size_t i = 0; i < count; i++) {
+			auto& fragment = fragments[i];
+			fragment.Channel = channel;
+			fragment.Sequence = sequence;
+			fragment.Index = (uint32_t)i;
+			fragment.Count = (uint32_t)count;
+			fragment.Compression = compression;
+			fragment.Size = (uint32_t)payload.size();
+			fragment.Data = data.substr(i * FragmentSize, FragmentSize);
+		}
+	}
+
+	void FragmentWriter::Reset()
+	{
+		sequences_.clear();
+	}
+
+
+	FragmentReassembler::Result FragmentReassembler::Add(uint32_t sender, MessageFragment const& fragment,
+		std::string& payload, std::string& error)
+	{
+		if (fragment.Count == 0 || fragment.Index >= fragment.Count) {
+			error = "Fragment index out of range";
+			return Result::Error;
+		}
+
+		if (fragment.Size > MaxMessageSize || fragment.Count > MaxMessageSize / FragmentWriter::FragmentSize + 1) {
+			error = "Fragmented message too large";
+			return Result::Error;
+		}
+
+		if (fragment.Compression != FragmentCompression::None && fragment.Compression != FragmentCompression::LZ4) {
+			error = "Unsupported fragment compression";
+			return Result::Error;
+		}
+
+		Key key{ sender, fragment.Channel, fragment.Sequence };
+		if (completed_.find(key) != completed_.end()) {
+			// Late duplicate of a fragment of an already reassembled message
+			return Result::Incomplete;
+		}
+
+		auto it = pending_.find(key);
+		if (it == pending_.end()) {
+			EvictOldest(sender, fragment.Channel);
+
+			PendingMessage message;
+			message.Count = fragment.Count;
+			message.Compression = fragment.Compression;
+			message.Size = fragment.Size;
+			message.CreatedAt = nextCreatedAt_++;
+			message.Fragments.resize(fragment.Count);
+			message.Received.resize(fragment.Count, false);
+			it = pending_.insert(std::make_pair(key, std::move(message))).first;
+		}
+
+		auto& message = it->second;
+		if (message.Count != fragment.Count
+			|| message.Compression != fragment.Compression
+			|| message.Size != fragment.Size) {
+			pending_.erase(it);
+			error = "Fragment header doesn't match the other fragments of the message";
+			return Result::Error;
+		}
+
+		if (message.Received[fragment.Index]) {
+			// Duplicate fragment
+			return Result::Incomplete;
+		}
+
+		message.ReceivedBytes += fragment.Data.size();
+		if (message.ReceivedBytes > MaxMessageSize
+			|| (message.Compression == FragmentCompression::None && message.ReceivedBytes > message.Size)) {
+			pending_.erase(it);
+			error = "Fragmented message larger than its declared size";
+			return Result::Error;
+		}
+
+		message.Fragments[fragment.Index] = fragment.Data;
+		message.Received[fragment.Index] = true;
+		message.NumReceived++;
+
+		if (message.NumReceived < message.Count) {
+			return Result::Incomplete;
+		}
+
+		std::string data;
+		data.reserve(message.ReceivedBytes);
+		for (auto const& part : message.Fragments) {
+			data += part;
+		}
+
+		auto compression = message.Compression;
+		auto size = message.Size;
+		pending_.erase(it);
+		MarkCompleted(key);
+
+		if (compression == FragmentCompression::LZ4) {
+			if (!DecompressLZ4(data, size, payload)) {
+				error = "Failed to decompress fragmented message";
+				return Result::Error;
+			}
+		} else {
+			if (data.size() != size) {
+				error = "Fragmented message size mismatch";
+				return Result::Error;
+			}
+
+			payload = std::move(data);
+		}
+
+		return Result::Complete;
+	}
+
+	void FragmentReassembler::EvictOldest(uint32_t sender, uint32_t channel)
+	{
+		std::size_t numPending{ 0 };
+		auto oldest = pending_.end();
+		auto first = pending_.lower_bound(Key{ sender, channel, 0 });
+		for (auto it = first; it != pending_.end() && std::get<0>(it->first) == sender && std::get<1>(it->first) == channel; ++it) {
+			numPending++;
+			if (oldest == pending_.end() || it->second.CreatedAt < oldest->second.CreatedAt) {
+				oldest = it;
+			}
+		}
+
+		if (numPending >= MaxPendingMessages) {
+			pending_.erase(oldest);
+		}
+	}
+
+	void FragmentReassembler::MarkCompleted(Key const& key)
+	{
+		completed_.insert(key);
+		completedOrder_.push_back(key);
+		if (completedOrder_.size() > MaxCompletedHistory) {
+			completed_.erase(completedOrder_.front());
+			completedOrder_.pop_front();
+		}
+	}
+
+	void FragmentReassembler::RemoveSender(uint32_t sender)
+	{
+		auto first = pending_.lower_bound(Key{ sender, 0, 0 });
+		auto last = first;
+		while (last != pending_.end() && std::get<0>(last->first) == sender) {
+			++last;
+		}
+
+		pending_.erase(first, last);
+
+		for (auto it = completedOrder_.begin(); it != completedOrder_.end(); ) {
+			if (std::get<0>(*it) == sender) {
+				completed_.erase(*it);
+				it = completedOrder_.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+
+	void FragmentReassembler::Reset()
+	{
+		pending_.clear();
+		completed_.clear();
+		completedOrder_.clear();
+	}
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+// Fragmentation, compression and reassembly of extender network message payloads.
+// This file must not depend on game definitions or protobuf; it is also compiled by
+// the standalone loopback harness (Tools/NetFragmentTest).
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace dse::net
+{
+	// Features that a peer supports; exchanged in MsgC2SExtenderHello/MsgS2CExtenderHello
+	enum class ExtenderCapabilities : uint32_t
+	{
+		None = 0,
+		// Peer understands MsgFragment messages
+		Fragmentation = 1 << 0,
+		// Peer can decompress LZ4 compressed fragments (requires Fragmentation)
+		LZ4Compression = 1 << 1,
+		// Peer understands MsgPostLuaMessages (batched Lua messages)
+		MessageBatching = 1 << 2,
+		// Peer understands binary Lua message payloads (MsgPostLuaMessage.binary_payload)
+		BinaryMessages = 1 << 3,
+		// Peer understands MsgS2CSyncStats (batched, partial stat syncs)
+		BatchedStatSync = 1 << 4,
+
+		Supported = Fragmentation | LZ4Compression | MessageBatching | BinaryMessages | BatchedStatSync
+	};
+
+	enum class FragmentCompression : uint32_t
+	{
+		None = 0,
+		LZ4 = 1
+	};
+
+	struct MessageFragment
+	{
+		uint32_t Channel{ 0 };
+		// Sequence number of the original message within the channel
+		uint32_t Sequence{ 0 };
+		uint32_t Index{ 0 };
+		uint32_t Count{ 0 };
+		FragmentCompression Compression{ FragmentCompression::None };
+		// Size of the original (uncompressed) payload
+		uint32_t Size{ 0 };
+		std::string Data;
+	};
+
+	class FragmentWriter
+	{
+	public:
+		// Maximum size of the data in a single fragment
+		static constexpr std::size_t FragmentSize = 0x10000;
+		// Payloads smaller than this are never compressed
+		static constexpr std::size_t CompressionThreshold = 0x1000;
+
+		// Checks whether a payload should be sent as fragments instead of a single message
+		static bool ShouldFragment(std::size_t size, uint32_t capabilities);
+
+		// Compresses (if the peer supports it and it's worth it) and splits the payload.
+		// Sequence numbers are allocated separately for each channel.
+		void Split(uint32_t channel, std::string_view payload, uint32_t capabilities,
+			std::vector<MessageFragment>& fragments);
+		void Reset();
+
+	private:
+		std::unordered_map<uint32_t, uint32_t> sequences_;
+	};
+
+	class FragmentReassembler
+	{
+	public:
+		// Maximum size of a reassembled payload
+		static constexpr std::size_t MaxMessageSize = 0x4000000;
+		// Maximum number of incomplete messages per sender and channel;
+		// the oldest incomplete message is dropped when a new one arrives
+		static constexpr std::size_t MaxPendingMessages = 16;
+		// Number of completed messages remembered to drop late duplicate fragments
+		static constexpr std::size_t MaxCompletedHistory = 256;
+
+		enum class Result
+		{
+			Incomplete,
+			Complete,
+			Error
+		};
+
+		// Adds a fragment received from a sender. Fragments may arrive in any order.
+		// When the last fragment of a message arrives, the original payload is returned in payload.
+		Result Add(uint32_t sender, MessageFragment const& fragment, std::string& payload, std::string& error);
+		void RemoveSender(uint32_t sender);
+		void Reset();
+
+		inline std::size_t GetNumPending() const
+		{
+			return pending_.size();
+		}
+
+	private:
+		// (sender, channel, sequence)
+		using Key = std::tuple<uint32_t, uint32_t, uint32_t>;
+
+		struct PendingMessage
+		{
+			uint32_t Count{ 0 };
+			FragmentCompression Compression{ FragmentCompression::None };
+			uint32_t Size{ 0 };
+			uint32_t NumReceived{ 0 };
+			std::size_t ReceivedBytes{ 0 };
+			uint64_t CreatedAt{ 0 };
+			std::vector<std::string> Fragments;
+			std::vector<bool> Received;
+		};
+
+		std::map<Key, PendingMessage> pending_;
+		uint64_t nextCreatedAt_{ 0 };
+		std::set<Key> completed_;
+		std::deque<Key> completedOrder_;
+
+		void EvictOldest(uint32_t sender, uint32_t channel);
+		void MarkCompleted(Key const& key);
+	};
+
+	bool CompressLZ4(std::string_view input, std::string& output);
+	bool DecompressLZ4(std::string_view input, std::size_t size, std::string& output);
+}
@@ -1,9 +1,14 @@
 #include <stdafx.h>
 #include <NetProtocol.h>
+#include <NetworkStringTable.h>
+#include <StatSnapshot.h>
 #include <GameDefinitions/Symbols.h>
 #include <OsirisProxy.h>
 #include <Version.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
 #include <fstream>
+#include <algorithm>
 
 namespace dse
 {
@@ -25,7 +30,12 @@ namespace dse
 		if (Msg->MsgId == ScriptExtenderMessage::MessageId) {
 			auto msg = static_cast<ScriptExtenderMessage *>(Msg);
 			if (msg->IsValid()) {
-				ProcessExtenderMessage(*Context, msg->GetMessage());
+				auto& wrapper = msg->GetMessage();
+				if (wrapper.msg_case() == MessageWrapper::kFragment) {
+					ProcessFragment(*Context, wrapper.fragment());
+				} else {
+					ProcessExtenderMessage(*Context, wrapper);
+				}
 			}
 			return net::MessageStatus::Handled;
 		}
@@ -33,6 +43,38 @@ namespace dse
 		return net::MessageStatus::Unhandled;
 	}
 
+	void ExtenderProtocol::ProcessFragment(net::MessageContext& context, MsgFragment const& msg)
+	{
+		net::MessageFragment fragment;
+		fragment.Channel = msg.channel();
+		fragment.Sequence = msg.sequence();
+		fragment.Index = msg.index();
+		fragment.Count = msg.count();
+		fragment.Compression = (net::FragmentCompression)msg.compression();
+		fragment.Size = msg.size();
+		fragment.Data = msg.data();
+
+		std::string payload, error;
+		auto result = reassembler_.Add((uint32_t)context.UserID.Id, fragment, payload, error);
+		if (result == net::FragmentReassembler::Result::Error) {
+			OsiError("Failed to reassemble fragmented message from user " << context.UserID.Id << ": " << error);
+		} else if (result == net::FragmentReassembler::Result::Complete) {
+			MessageWrapper wrapper;
+			if (!wrapper.ParseFromString(payload)) {
+				OsiErrorS("Failed to parse reassembled fragmented message");
+			} else if (wrapper.msg_case() == MessageWrapper::kFragment) {
+				OsiErrorS("Fragmented message contains another fragment");
+			} else {
+				ProcessExtenderMessage(context, wrapper);
+			}
+		}
+	}
+
+	void ExtenderProtocol::ResetFragments()
+	{
+		reassembler_.Reset();
+	}
+
 	void ExtenderProtocol::Unknown1() {}
 
 	int ExtenderProtocol::PreUpdate(void * Unknown)
@@ -60,6 +102,16 @@ namespace dse
 		return nullptr;
 	}
 
+	// Passes a Lua message to the listeners registered with Ext.RegisterNetListener()
+	void DispatchPostLuaMessage(lua::State& lua, MsgPostLuaMessage const& msg, UserId userId)
+	{
+		if (!msg.binary_payload().empty()) {
+			lua.OnBinaryNetMessageReceived(STDString(msg.channel_name()), msg.binary_payload(), userId);
+		} else {
+			lua.OnNetMessageReceived(STDString(msg.channel_name()), STDString(msg.payload()), userId);
+		}
+	}
+
 	void ExtenderProtocolClient::SyncNetworkStrings(MsgS2CSyncNetworkFixedStrings const& msg)
 	{
 		auto fixedStrings = GetStaticSymbols().NetworkFixedStrings;
@@ -68,17 +120,23 @@ namespace dse
 			return;
 		}
 
-		std::vector<STDString> strings;
-		auto numStrings = msg.network_string_size();
-		strings.reserve(numStrings);
-		for (auto i = 0; i < numStrings; i++) {
-			auto& str = msg.network_string(i);
-			strings.push_back(STDString(str));
+		if (msg.block_size() != 0) {
+			DEBUG("Got fixedstring delta from server (%d blocks)", msg.block_indices_size());
+			gOsirisProxy->NetworkFixedStringSync().SetServerNetworkFixedStringsDelta(msg);
+		} else {
+			std::vector<STDString> strings;
+			auto numStrings = msg.network_string_size();
+			strings.reserve(numStrings);
+			for (auto i = 0; i < numStrings; i++) {
+				auto& str = msg.network_string(i);
+				strings.push_back(STDString(str));
+			}
+
+			DEBUG("Got fixedstring list from server");
+			gOsirisProxy->NetworkFixedStringSync().SetServerNetworkFixedStrings(strings);
 		}
 
 		auto state = GetStaticSymbols().GetClientState();
-		DEBUG("Got fixedstring list from server");
-		gOsirisProxy->NetworkFixedStringSync().SetServerNetworkFixedStrings(strings);
 
 		if (state == ecl::GameState::Running
 			|| state == ecl::GameState::PrepareRunning
@@ -99,10 +157,20 @@ namespace dse
 		switch (msg.msg_case()) {
 		case MessageWrapper::kPostLua:
 		{
-			auto & postMsg = msg.post_lua();
 			ecl::LuaClientPin pin(ecl::ExtensionState::Get());
 			if (pin) {
-				pin->OnNetMessageReceived(STDString(postMsg.channel_name()), STDString(postMsg.payload()), UserId::Unassigned);
+				DispatchPostLuaMessage(*pin, msg.post_lua(), UserId::Unassigned);
+			}
+			break;
+		}
+
+		case MessageWrapper::kPostLuaBatch:
+		{
+			ecl::LuaClientPin pin(ecl::ExtensionState::Get());
+			if (pin) {
+				for (auto const& postMsg : msg.post_lua_batch().messages()) {
+					DispatchPostLuaMessage(*pin, postMsg, UserId::Unassigned);
+				}
 			}
 			break;
 		}
@@ -131,20 +199,49 @@ namespace dse
 			break;
 		}
 
+		case MessageWrapper::kS2CSyncStats:
+		{
+			auto stats = GetStaticSymbols().GetStats();
+			std::vector<FixedString> statIds;
+			for (auto const& stat : msg.s2c_sync_stats().stats()) {
+				stats->SyncObjectFromServer(stat);
+				statIds.push_back(ToFixedString(stat.name().c_str()));
+			}
+
+			gStatSnapshots.Update(stats, statIds);
+			break;
+		}
+
+		case MessageWrapper::kS2CExtenderHello:
+		{
+			auto capabilities = msg.s2c_extender_hello().capabilities();
+			DEBUG("Got extender capabilities from server: %x", capabilities);
+			gOsirisProxy->GetNetworkManager().ClientSetServerCapabilities(
+				capabilities & (uint32_t)net::ExtenderCapabilities::Supported);
+			break;
+		}
+
 		default:
 			OsiErrorS("Unknown extension message type received!");
 		}
 	}
 
+	int ExtenderProtocolServer::PostUpdate(void * Unknown)
+	{
+		gOsirisProxy->StatSync().Flush();
+		gOsirisProxy->LuaMessageBatch().Flush();
+		esv::gObjectSpatialIndex.Invalidate();
+		return 0;
+	}
+
 	void ExtenderProtocolServer::ProcessExtenderMessage(net::MessageContext& context, MessageWrapper & msg)
 	{
 		switch (msg.msg_case()) {
 		case MessageWrapper::kPostLua:
 		{
-			auto & postMsg = msg.post_lua();
 			esv::LuaServerPin pin(esv::ExtensionState::Get());
 			if (pin) {
-				pin->OnNetMessageReceived(STDString(postMsg.channel_name()), STDString(postMsg.payload()), context.UserID);
+				DispatchPostLuaMessage(*pin, msg.post_lua(), context.UserID);
 			}
 			break;
 		}
@@ -152,15 +249,30 @@ namespace dse
 		case MessageWrapper::kC2SRequestStrings:
 		{
 			if (gOsirisProxy->GetConfig().SyncNetworkStrings) {
-				gOsirisProxy->NetworkFixedStringSync().OnUpdateRequested(context.UserID);
+				gOsirisProxy->NetworkFixedStringSync().OnUpdateRequested(context.UserID, msg.c2s_request_strings());
 			}
 			break;
 		}
 
 		case MessageWrapper::kC2SExtenderHello:
 		{
-			DEBUG("Got extender support notification from user %d", context.UserID.Id);
-			gOsirisProxy->GetNetworkManager().ServerAllowExtenderMessages(context.UserID.GetPeerId());
+			auto capabilities = msg.c2s_extender_hello().capabilities();
+			DEBUG("Got extender support notification from user %d (capabilities %x)", context.UserID.Id, capabilities);
+			auto& networkMgr = gOsirisProxy->GetNetworkManager();
+			networkMgr.ServerAllowExtenderMessages(context.UserID.GetPeerId(),
+				capabilities & (uint32_t)net::ExtenderCapabilities::Supported);
+
+			// Older clients don't know the reply message, so only reply to clients that reported capabilities
+			if (capabilities != 0) {
+				auto reply = networkMgr.GetFreeServerMessage(context.UserID);
+				if (reply != nullptr) {
+					reply->GetMessage().mutable_s2c_extender_hello()->set_capabilities(
+						(uint32_t)net::ExtenderCapabilities::Supported);
+					networkMgr.ServerSend(reply, context.UserID);
+				} else {
+					OsiErrorS("Could not get free message!");
+				}
+			}
 			break;
 		}
 
@@ -170,6 +282,59 @@ namespace dse
 	}
 
 
+	// Writes serialized messages to the bitstream in blocks, so the message
+	// doesn't have to be serialized to a temporary buffer first
+	class BitstreamOutputStream : public google::protobuf::io::CopyingOutputStream
+	{
+	public:
+		inline BitstreamOutputStream(net::BitstreamSerializer& serializer)
+			: serializer_(serializer)
+		{}
+
+		bool Write(void const* buffer, int size) override
+		{
+			serializer_.WriteBytes(buffer, size);
+			return true;
+		}
+
+	private:
+		net::BitstreamSerializer& serializer_;
+	};
+
+	// Reads at most the specified number of bytes from the bitstream
+	class BitstreamInputStream : public google::protobuf::io::CopyingInputStream
+	{
+	public:
+		inline BitstreamInputStream(net::BitstreamSerializer& serializer, uint32_t size)
+			: serializer_(serializer), remaining_(size)
+		{}
+
+		int Read(void* buffer, int size) override
+		{
+			auto bytes = std::min((uint32_t)size, remaining_);
+			if (bytes > 0) {
+				serializer_.ReadBytes(buffer, bytes);
+				remaining_ -= bytes;
+			}
+
+			return (int)bytes;
+		}
+
+		// Consumes the rest of the payload if parsing stopped early
+		void SkipRemaining()
+		{
+			uint8_t buf[0x1000];
+			while (remaining_ > 0) {
+				Read(buf, sizeof(buf));
+			}
+		}
+
+	private:
+		net::BitstreamSerializer& serializer_;
+		uint32_t remaining_;
+	};
+
+
 	ScriptExtenderMessage::ScriptExtenderMessage()
 	{
 		MsgId = MessageId;
@@ -185,10 +350,14 @@ namespace dse
 			uint32_t size = (uint32_t)msg.ByteSizeLong();
 			if (size <= MaxPayloadLength) {
 				serializer.WriteBytes(&size, sizeof(size));
-				void * buf = GameAllocRaw(size);
-				msg.SerializeToArray(buf, size);
-				serializer.WriteBytes(buf, size);
-				GameFree(buf);
+				BitstreamOutputStream stream(serializer);
+				google::protobuf::io::CopyingOutputStreamAdaptor adaptor(&stream);
+				{
+					google::protobuf::io::CodedOutputStream out(&adaptor);
+					// Sizes were cached by ByteSizeLong() above
+					msg.SerializeWithCachedSizes(&out);
+				}
+				adaptor.Flush();
 			} else {
 				// Zero length indicates that a packet failed to serialize
 				uint32_t dummy = 0;
@@ -202,10 +371,12 @@ namespace dse
 			if (size > MaxPayloadLength) {
 				OsiError("Tried to read packet of size " << size << ", max size is " << MaxPayloadLength);
 			} else if (size > 0) {
-				void * buf = GameAllocRaw(size);
-				serializer.ReadBytes(buf, size);
-				valid_ = msg.ParseFromArray(buf, size);
-				GameFree(buf);
+				BitstreamInputStream stream(serializer, size);
+				{
+					google::protobuf::io::CopyingInputStreamAdaptor adaptor(&stream);
+					valid_ = msg.ParseFromZeroCopyStream(&adaptor);
+				}
+				stream.SkipRemaining();
 			}
 		}
 	}
@@ -231,11 +402,21 @@ namespace dse
 	void NetworkManager::ClientReset()
 	{
 		clientExtenderSupport_ = false;
+		serverCapabilities_ = 0;
+		clientFragmentWriter_.Reset();
+		if (clientProtocol_ != nullptr) {
+			clientProtocol_->ResetFragments();
+		}
 	}
 
 	void NetworkManager::ServerReset()
 	{
 		serverExtenderPeerIds_.clear();
+		peerCapabilities_.clear();
+		serverFragmentWriter_.Reset();
+		if (serverProtocol_ != nullptr) {
+			serverProtocol_->ResetFragments();
+		}
 	}
 
 	bool NetworkManager::ClientCanSendExtenderMessages() const
@@ -253,9 +434,30 @@ namespace dse
 		return serverExtenderPeerIds_.find(peerId) != serverExtenderPeerIds_.end();
 	}
 
-	void NetworkManager::ServerAllowExtenderMessages(PeerId peerId)
+	void NetworkManager::ServerAllowExtenderMessages(PeerId peerId, uint32_t capabilities)
 	{
 		serverExtenderPeerIds_.insert(peerId);
+		peerCapabilities_[peerId] = capabilities;
+	}
+
+	void NetworkManager::ClientSetServerCapabilities(uint32_t capabilities)
+	{
+		serverCapabilities_ = capabilities;
+	}
+
+	uint32_t NetworkManager::ClientGetServerCapabilities() const
+	{
+		return serverCapabilities_;
+	}
+
+	uint32_t NetworkManager::GetPeerCapabilities(PeerId peerId) const
+	{
+		auto it = peerCapabilities_.find(peerId);
+		if (it != peerCapabilities_.end()) {
+			return it->second;
+		} else {
+			return 0;
+		}
 	}
 
 
@@ -366,7 +568,8 @@ namespace dse
 				gOsirisProxy->GetNetworkManager().ExtendNetworkingClient();
 				auto helloMsg = GetFreeClientMessage();
 				if (helloMsg != nullptr) {
-					helloMsg->GetMessage().mutable_c2s_extender_hello();
+					helloMsg->GetMessage().mutable_c2s_extender_hello()->set_capabilities(
+					(uint32_t)net::ExtenderCapabilities::Supported);
 					ClientSend(helloMsg);
 				}
 				else {
@@ -413,11 +616,63 @@ namespace dse
 		}
 	}
 
+	std::vector<ScriptExtenderMessage*> NetworkManager::MakeFragments(ScriptExtenderMessage* msg, uint32_t capabilities,
+		uint32_t channel, bool server)
+	{
+		auto& wrapper = msg->GetMessage();
+		if (!net::FragmentWriter::ShouldFragment(wrapper.ByteSizeLong(), capabilities)) {
+			return { msg };
+		}
+
+		std::string payload;
+		wrapper.SerializeToString(&payload);
+
+		std::vector<net::MessageFragment> fragments;
+		auto& writer = server ? serverFragmentWriter_ : clientFragmentWriter_;
+		writer.Split(channel, payload, capabilities, fragments);
+
+		std::vector<ScriptExtenderMessage*> messages;
+		for (auto& fragment : fragments) {
+			ScriptExtenderMessage* fragmentMsg{ nullptr };
+			if (messages.empty()) {
+				fragmentMsg = msg;
+			} else if (server) {
+				auto gameServer = GetServer();
+				fragmentMsg = gameServer ? gameServer->GetFreeMessage<ScriptExtenderMessage>() : nullptr;
+			} else {
+				auto client = GetClient();
+				fragmentMsg = client ? client->GetFreeMessage<ScriptExtenderMessage>() : nullptr;
+			}
+
+			if (fragmentMsg == nullptr) {
+				// The receiver drops the incomplete message
+				OsiErrorS("Could not get free message!");
+				break;
+			}
+
+			auto& fragmentWrapper = fragmentMsg->GetMessage();
+			fragmentWrapper.Clear();
+			auto fragmentData = fragmentWrapper.mutable_fragment();
+			fragmentData->set_channel(fragment.Channel);
+			fragmentData->set_sequence(fragment.Sequence);
+			fragmentData->set_index(fragment.Index);
+			fragmentData->set_count(fragment.Count);
+			fragmentData->set_compression((uint32_t)fragment.Compression);
+			fragmentData->set_size(fragment.Size);
+			fragmentData->set_data(std::move(fragment.Data));
+			messages.push_back(fragmentMsg);
+		}
+
+		return messages;
+	}
+
 	void NetworkManager::ClientSend(ScriptExtenderMessage * msg)
 	{
 		auto client = GetClient();
 		if (client != nullptr) {
-			client->VMT->ClientSend(client, client->ClientPeerId, msg);
+			for (auto fragment : MakeFragments(msg, serverCapabilities_, ClientToServerChannel, false)) {
+				client->VMT->ClientSend(client, client->ClientPeerId, fragment);
+			}
 		}
 	}
 
@@ -425,7 +680,10 @@ namespace dse
 	{
 		auto server = GetServer();
 		if (server != nullptr) {
-			server->VMT->SendToPeer(server, &userId.Id, msg);
+			auto capabilities = GetPeerCapabilities(userId.GetPeerId());
+			for (auto fragment : MakeFragments(msg, capabilities, ServerToUserChannel, true)) {
+				server->VMT->SendToPeer(server, &userId.Id, fragment);
+			}
 		}
 	}
 
@@ -434,15 +692,20 @@ namespace dse
 		auto server = GetServer();
 		if (server != nullptr) {
 			ObjectSet<PeerId> peerIds;
+			// Fragmented messages can only be broadcast if every recipient supports them
+			auto capabilities = (uint32_t)net::ExtenderCapabilities::Supported;
 			for (auto peerId : server->ActivePeerIds) {
 				if (ServerCanSendExtenderMessages(peerId)) {
 					peerIds.Set.Add(peerId);
+					capabilities &= GetPeerCapabilities(peerId);
 				} else {
 					WARN("Not sending extender message to peer %d as it does not understand extender protocol!", peerId);
 				}
 			}
 
-			server->VMT->SendToMultiplePeers(server, &peerIds, msg, excludeUserId.Id);
+			for (auto fragment : MakeFragments(msg, capabilities, ServerBroadcastChannel, true)) {
+				server->VMT->SendToMultiplePeers(server, &peerIds, fragment, excludeUserId.Id);
+			}
 		}
 	}
 
@@ -452,14 +715,82 @@ namespace dse
 		if (server != nullptr) {
 			ObjectSet<PeerId> peerIds;
 			peerIds.Set.Reallocate(server->ConnectedPeerIds.Set.Size);
+			auto capabilities = (uint32_t)net::ExtenderCapabilities::Supported;
 			for (auto peerId : server->ConnectedPeerIds) {
 				peerIds.Set.Add(peerId);
+				capabilities &= GetPeerCapabilities(peerId);
+			}
+
+			for (auto fragment : MakeFragments(msg, capabilities, ServerBroadcastChannel, true)) {
+				server->VMT->SendToMultiplePeers(server, &peerIds, fragment, excludeUserId.Id);
 			}
-			server->VMT->SendToMultiplePeers(server, &peerIds, msg, excludeUserId.Id);
 		}
 	}
 
 
+	void NetworkManager::ServerSendToPeer(ScriptExtenderMessage* msg, PeerId peerId)
+	{
+		auto server = GetServer();
+		if (server != nullptr) {
+			ObjectSet<PeerId> peerIds;
+			peerIds.Set.Add(peerId);
+			auto capabilities = GetPeerCapabilities(peerId);
+			for (auto fragment : MakeFragments(msg, capabilities, ServerToUserChannel, true)) {
+				server->VMT->SendToMultiplePeers(server, &peerIds, fragment, UserId::Unassigned);
+			}
+		}
+	}
+
+	void NetworkManager::ServerSendToPeers(ScriptExtenderMessage* msg, std::vector<PeerId> const& peerIds)
+	{
+		auto server = GetServer();
+		if (server != nullptr) {
+			ObjectSet<PeerId> peers;
+			peers.Set.Reallocate((uint32_t)peerIds.size());
+			auto capabilities = (uint32_t)net::ExtenderCapabilities::Supported;
+			for (auto peerId : peerIds) {
+				peers.Set.Add(peerId);
+				capabilities &= GetPeerCapabilities(peerId);
+			}
+
+			for (auto fragment : MakeFragments(msg, capabilities, ServerBroadcastChannel, true)) {
+				server->VMT->SendToMultiplePeers(server, &peers, fragment, UserId::Unassigned);
+			}
+		}
+	}
+
+	std::vector<PeerId> NetworkManager::ServerGetExtenderPeerIds() const
+	{
+		std::vector<PeerId> peerIds;
+		auto server = GetServer();
+		if (server != nullptr) {
+			for (auto peerId : server->ActivePeerIds) {
+				if (ServerCanSendExtenderMessages(peerId)) {
+					peerIds.push_back(peerId);
+				}
+			}
+		}
+
+		return peerIds;
+	}
+
+
+	// Strings of the table, excluding the null string at index 0
+	std::vector<std::string_view> GetNetworkStrings(eoc::NetworkFixedStrings const& fs)
+	{
+		std::vector<std::string_view> strings;
+		auto numStrings = fs.FixedStrSet.Set.Size;
+		if (numStrings > 1) {
+			strings.reserve(numStrings - 1);
+			for (uint32_t i = 1; i < numStrings; i++) {
+				auto str = fs.FixedStrSet[i].Str;
+				strings.push_back(str ? std::string_view(str) : std::string_view());
+			}
+		}
+
+		return strings;
+	}
+
 	void NetworkFixedStringSynchronizer::Dump()
 	{
 		auto nfs = GetStaticSymbols().NetworkFixedStrings;
@@ -478,7 +809,7 @@ namespace dse
 		}
 	}
 
-	void NetworkFixedStringSynchronizer::RequestFromServer()
+	void NetworkFixedStringSynchronizer::RequestFromServer(bool full)
 	{
 		if (!gOsirisProxy->GetNetworkManager().ClientCanSendExtenderMessages()) {
 			OsiWarnS("Not syncing fixedstrings - host has no extender support");
@@ -489,7 +820,20 @@ namespace dse
 		auto& networkMgr = gOsirisProxy->GetNetworkManager();
 		auto msg = networkMgr.GetFreeClientMessage();
 		if (msg != nullptr) {
-			msg->GetMessage().mutable_c2s_request_strings();
+			auto request = msg->GetMessage().mutable_c2s_request_strings();
+			request->set_block_size(NetworkStringBlockSize);
+
+			// Send the hashes of the table we currently have; usually it's the same as the
+			// table we'll have after the module is loaded, so the server only sends the differences
+			auto fixedStrs = GetStaticSymbols().NetworkFixedStrings;
+			if (!full && fixedStrs != nullptr && *fixedStrs != nullptr && (*fixedStrs)->Initialized) {
+				auto hash = HashNetworkStrings(GetNetworkStrings(**fixedStrs), NetworkStringBlockSize);
+				request->set_num_strings(hash.NumStrings);
+				for (auto blockHash : hash.BlockHashes) {
+					request->add_block_hashes(blockHash);
+				}
+			}
+
 			networkMgr.ClientSend(msg);
 		}
 		else {
@@ -500,14 +844,14 @@ namespace dse
 	void NetworkFixedStringSynchronizer::FlushQueuedRequests()
 	{
 		DEBUG("Flushing NetworkFixedString updates");
-		for (auto userId : pendingSyncRequests_) {
-			SendUpdateToUser(userId);
+		for (auto const& request : pendingSyncRequests_) {
+			SendUpdateToUser(request.first, request.second);
 		}
 
 		pendingSyncRequests_.clear();
 	}
 
-	void NetworkFixedStringSynchronizer::OnUpdateRequested(UserId userId)
+	void NetworkFixedStringSynchronizer::OnUpdateRequested(UserId userId, MsgC2SRequestNetworkFixedStrings const& request)
 	{
 		auto gameState = *GetStaticSymbols().GetServerState();
 		if (gameState == esv::GameState::LoadSession
@@ -516,29 +860,50 @@ namespace dse
 			|| gameState == esv::GameState::Sync
 			|| gameState == esv::GameState::Running) {
 			DEBUG("Fulfill requested NetworkFixedString update for user %d", userId.Id);
-			SendUpdateToUser(userId);
+			SendUpdateToUser(userId, request);
 		} else {
 			DEBUG("Queuing requested NetworkFixedString update for user %d", userId.Id);
-			pendingSyncRequests_.insert(userId);
+			pendingSyncRequests_[userId] = request;
 		}
 	}
 
-	void NetworkFixedStringSynchronizer::SendUpdateToUser(UserId userId)
+	void NetworkFixedStringSynchronizer::SendUpdateToUser(UserId userId, MsgC2SRequestNetworkFixedStrings const& request)
 	{
 		auto fixedStrs = GetStaticSymbols().NetworkFixedStrings;
 		if (fixedStrs == nullptr || *fixedStrs == nullptr) {
 			return;
 		}
 
-		DEBUG("Sending NetworkFixedString table to user %d", userId.Id);
 		auto& nfs = **fixedStrs;
 		auto& networkMgr = gOsirisProxy->GetNetworkManager();
 		auto msg = networkMgr.GetFreeServerMessage(userId);
 		if (msg != nullptr) {
 			auto syncMsg = msg->GetMessage().mutable_s2c_sync_strings();
-			auto numStrings = nfs.FixedStrSet.Set.Size;
-			for (uint32_t i = 1; i < numStrings; i++) {
-				syncMsg->add_network_string(nfs.FixedStrSet[i].Str);
+			auto blockSize = request.block_size();
+			if (blockSize >= MinNetworkStringBlockSize && blockSize <= MaxNetworkStringBlockSize) {
+				auto strings = GetNetworkStrings(nfs);
+				auto hash = HashNetworkStrings(strings, blockSize);
+				std::vector<uint64_t> clientBlockHashes(request.block_hashes().begin(), request.block_hashes().end());
+				auto blocks = FindMismatchingNetworkStringBlocks(hash, clientBlockHashes);
+
+				DEBUG("Sending %d of %d NetworkFixedString blocks to user %d", (uint32_t)blocks.size(),
+					(uint32_t)hash.BlockHashes.size(), userId.Id);
+				syncMsg->set_block_size(blockSize);
+				syncMsg->set_num_strings(hash.NumStrings);
+				syncMsg->set_table_hash(hash.TableHash);
+				for (auto block : blocks) {
+					syncMsg->add_block_indices(block);
+					auto last = std::min((block + 1) * blockSize, hash.NumStrings);
+					for (auto i = block * blockSize; i < last; i++) {
+						syncMsg->add_network_string(strings[i].data(), strings[i].size());
+					}
+				}
+			} else {
+				DEBUG("Sending NetworkFixedString table to user %d", userId.Id);
+				auto numStrings = nfs.FixedStrSet.Set.Size;
+				for (uint32_t i = 1; i < numStrings; i++) {
+					syncMsg->add_network_string(nfs.FixedStrSet[i].Str);
+				}
 			}
 
 			networkMgr.ServerSend(msg, userId);
@@ -548,10 +913,68 @@ namespace dse
 		}
 	}
 
+	void NetworkFixedStringSynchronizer::SetServerNetworkFixedStringsDelta(MsgS2CSyncNetworkFixedStrings const& msg)
+	{
+		DeltaUpdate delta;
+		delta.NumStrings = msg.num_strings();
+		delta.BlockSize = msg.block_size();
+		delta.TableHash = msg.table_hash();
+		delta.Blocks.assign(msg.block_indices().begin(), msg.block_indices().end());
+		delta.Strings.reserve(msg.network_string_size());
+		for (auto const& str : msg.network_string()) {
+			delta.Strings.push_back(STDString(str));
+		}
+
+		updatedStrings_.clear();
+		firstChangedIndex_ = 0;
+		delta_ = std::move(delta);
+	}
+
+	bool NetworkFixedStringSynchronizer::MergeDelta(eoc::NetworkFixedStrings const& fs)
+	{
+		auto delta = std::move(*delta_);
+		delta_.reset();
+
+		auto localStrings = GetNetworkStrings(fs);
+		std::vector<std::string_view> blockStrings;
+		blockStrings.reserve(delta.Strings.size());
+		for (auto const& str : delta.Strings) {
+			blockStrings.push_back(std::string_view(str.data(), str.size()));
+		}
+
+		std::vector<std::string_view> merged;
+		std::string error;
+		if (MergeNetworkStringBlocks(localStrings, delta.NumStrings, delta.BlockSize, delta.Blocks, blockStrings, merged, error)
+			&& HashNetworkStrings(merged, delta.BlockSize).TableHash != delta.TableHash) {
+			error = "merged table hash mismatch";
+		}
+
+		if (!error.empty()) {
+			// Our table changed since the hashes were sent to the server (eg. different mods were loaded)
+			if (!fullUpdateRequested_) {
+				WARN("Cannot apply NetworkFixedStrings delta (%s); requesting full table", error.c_str());
+				fullUpdateRequested_ = true;
+				RequestFromServer(true);
+			} else {
+				ERR("Cannot apply NetworkFixedStrings delta: %s", error.c_str());
+			}
+			return false;
+		}
+
+		updatedStrings_.clear();
+		updatedStrings_.reserve(merged.size());
+		for (auto const& str : merged) {
+			updatedStrings_.push_back(STDString(str));
+		}
+
+		firstChangedIndex_ = delta.Blocks.empty() ? delta.NumStrings : delta.Blocks[0] * delta.BlockSize;
+		return true;
+	}
+
 	void NetworkFixedStringSynchronizer::UpdateFromServer()
 	{
 		auto fixedStrs = GetStaticSymbols().NetworkFixedStrings;
-		if (updatedStrings_.empty()
+		if ((updatedStrings_.empty() && !delta_)
 			|| fixedStrs == nullptr
 			|| *fixedStrs == nullptr
 			|| (*fixedStrs)->FixedStrSet.Set.Size == 0) {
@@ -560,11 +983,16 @@ namespace dse
 
 		DEBUG("Updating NetworkFixedStrings from server");
 		auto& fs = **fixedStrs;
+		if (delta_ && !MergeDelta(fs)) {
+			return;
+		}
+
 		auto numStrings = (uint32_t)updatedStrings_.size();
 
 		auto sizeMin = std::min(fs.FixedStrSet.Set.Size - 1, numStrings);
 		uint32_t brokenNum = 0;
-		for (uint32_t i = 0; i < sizeMin; i++) {
+		// Blocks that weren't sent in the delta are identical to our table
+		for (uint32_t i = firstChangedIndex_; i < sizeMin; i++) {
 			auto const& serverString = updatedStrings_[i];
 			auto clientString = fs.FixedStrSet[i + 1];
 			if (serverString != clientString.Str) {
@@ -609,6 +1037,9 @@ namespace dse
 	void NetworkFixedStringSynchronizer::ClientReset()
 	{
 		updatedStrings_.clear();
+		delta_.reset();
+		firstChangedIndex_ = 0;
+		fullUpdateRequested_ = false;
 		notInSync_ = false;
 		syncWarningShown_ = false;
 	}
@@ -622,4 +1053,315 @@ namespace dse
 			syncWarningShown_ = true;
 		}
 	}
+
+
+	StatSynchronizer::DirtyState& StatSynchronizer::GetDirtyState(FixedString const& statId)
+	{
+		return dirty_[statId];
+	}
+
+	void StatSynchronizer::MarkAttributeDirty(FixedString const& statId, uint32_t attributeIndex)
+	{
+		std::lock_guard lock(mutex_);
+		auto& state = GetDirtyState(statId);
+		if (std::find(state.Attributes.begin(), state.Attributes.end(), attributeIndex) == state.Attributes.end()) {
+			state.Attributes.push_back(attributeIndex);
+		}
+	}
+
+	void StatSynchronizer::MarkFieldDirty(FixedString const& statId, StatSyncField field)
+	{
+		std::lock_guard lock(mutex_);
+		GetDirtyState(statId).Fields |= (uint32_t)field;
+	}
+
+	void StatSynchronizer::MarkFullSync(FixedString const& statId)
+	{
+		std::lock_guard lock(mutex_);
+		GetDirtyState(statId).Full = true;
+	}
+
+	void StatSynchronizer::QueueSync(FixedString const& statId)
+	{
+		std::lock_guard lock(mutex_);
+		DirtyState state;
+		auto dirtyIt = dirty_.find(statId);
+		if (dirtyIt != dirty_.end()) {
+			state = std::move(dirtyIt->second);
+			dirty_.erase(dirtyIt);
+		} else {
+			// We don't know what was changed, send everything
+			state.Full = true;
+		}
+
+		auto queuedIt = queued_.find(statId);
+		if (queuedIt == queued_.end()) {
+			queuedIds_.push_back(statId);
+			queued_.insert(std::make_pair(statId, std::move(state)));
+		} else {
+			auto& queued = queuedIt->second;
+			queued.Full = queued.Full || state.Full;
+			queued.Fields |= state.Fields;
+			for (auto index : state.Attributes) {
+				if (std::find(queued.Attributes.begin(), queued.Attributes.end(), index) == queued.Attributes.end()) {
+					queued.Attributes.push_back(index);
+				}
+			}
+		}
+	}
+
+	void StatSynchronizer::Flush()
+	{
+		std::vector<FixedString> statIds;
+		std::unordered_map<FixedString, DirtyState> queued;
+		{
+			std::lock_guard lock(mutex_);
+			if (queuedIds_.empty()) return;
+			statIds.swap(queuedIds_);
+			queued.swap(queued_);
+		}
+
+		auto stats = GetStaticSymbols().GetStats();
+		if (stats == nullptr) return;
+
+		auto& networkMgr = gOsirisProxy->GetNetworkManager();
+		bool measure = gOsirisProxy->GetConfig().DeveloperMode;
+		std::size_t numPartial{ 0 }, numMessages{ 0 }, bytesSent{ 0 }, bytesAsFullUpdates{ 0 };
+
+		// Clients with older extender versions only understand per-entry MsgS2CSyncStat messages
+		std::vector<PeerId> batchedPeers, legacyPeers;
+		for (auto peerId : networkMgr.ServerGetExtenderPeerIds()) {
+			if (networkMgr.GetPeerCapabilities(peerId) & (uint32_t)net::ExtenderCapabilities::BatchedStatSync) {
+				batchedPeers.push_back(peerId);
+			} else {
+				legacyPeers.push_back(peerId);
+			}
+		}
+
+		ScriptExtenderMessage* msg{ nullptr };
+		std::size_t batchSize{ 0 };
+		for (auto const& statId : statIds) {
+			auto object = stats->objects.Find(statId);
+			if (object == nullptr) {
+				OsiError("Cannot sync nonexistent stat: " << statId);
+				continue;
+			}
+
+			if (!legacyPeers.empty()) {
+				SendLegacySync(object, legacyPeers);
+			}
+
+			if (batchedPeers.empty()) {
+				continue;
+			}
+
+			if (msg == nullptr) {
+				msg = networkMgr.GetFreeServerMessage(UserId::Unassigned);
+				if (!msg) {
+					OsiErrorS("Failed to get free message");
+					return;
+				}
+			}
+
+			auto syncMsg = msg->GetMessage().mutable_s2c_sync_stats();
+			auto statMsg = syncMsg->add_stats();
+			auto const& state = queued[statId];
+			if (state.Full) {
+				object->ToProtobuf(statMsg);
+			} else {
+				object->ToProtobuf(statMsg, state.Attributes, state.Fields);
+				numPartial++;
+			}
+
+			auto size = statMsg->ByteSizeLong();
+			batchSize += size;
+			if (measure) {
+				bytesSent += size;
+				if (state.Full) {
+					bytesAsFullUpdates += size;
+				} else {
+					MsgS2CSyncStat fullMsg;
+					object->ToProtobuf(&fullMsg);
+					bytesAsFullUpdates += fullMsg.ByteSizeLong();
+				}
+			}
+
+			if (batchSize >= MaxBatchSize) {
+				networkMgr.ServerSendToPeers(msg, batchedPeers);
+				numMessages++;
+				msg = nullptr;
+				batchSize = 0;
+			}
+		}
+
+		if (msg != nullptr) {
+			networkMgr.ServerSendToPeers(msg, batchedPeers);
+			numMessages++;
+		}
+
+		gStatSnapshots.Update(stats, statIds);
+
+		if (measure) {
+			DEBUG("StatSynchronizer::Flush(): Synced %zu stats entries (%zu partial) in %zu messages; %zu bytes (%zu bytes with full updates)",
+				statIds.size(), numPartial, numMessages, bytesSent, bytesAsFullUpdates);
+		}
+	}
+
+	void StatSynchronizer::SendLegacySync(CRPGStats_Object* object, std::vector<PeerId> const& peerIds)
+	{
+		auto& networkMgr = gOsirisProxy->GetNetworkManager();
+		auto msg = networkMgr.GetFreeServerMessage(UserId::Unassigned);
+		if (!msg) {
+			OsiErrorS("Failed to get free message");
+			return;
+		}
+
+		object->ToProtobuf(msg->GetMessage().mutable_s2c_sync_stat());
+		networkMgr.ServerSendToPeers(msg, peerIds);
+	}
+
+	void StatSynchronizer::Reset()
+	{
+		std::lock_guard lock(mutex_);
+		dirty_.clear();
+		queuedIds_.clear();
+		queued_.clear();
+	}
+
+
+	void LuaMessageBatcher::SetChannelBatching(STDString const& channel, bool enabled)
+	{
+		if (enabled) {
+			channels_.insert(channel);
+		} else {
+			channels_.erase(channel);
+		}
+	}
+
+	bool LuaMessageBatcher::IsBatched(STDString const& channel) const
+	{
+		return channels_.find(channel) != channels_.end();
+	}
+
+	void LuaMessageBatcher::SetLimits(uint32_t maxMessages, uint32_t maxBytes)
+	{
+		maxMessages_ = std::max(maxMessages, 1u);
+		maxBytes_ = std::max(maxBytes, 1u);
+	}
+
+	void LuaMessageBatcher::Broadcast(STDString const& channel, STDString const& payload, UserId excludeUserId, bool binary)
+	{
+		auto& networkMgr = gOsirisProxy->GetNetworkManager();
+		auto excludePeerId = excludeUserId ? excludeUserId.GetPeerId() : -1;
+		for (auto peerId : networkMgr.ServerGetExtenderPeerIds()) {
+			if (peerId != excludePeerId) {
+				QueueForPeer(peerId, channel, payload, binary);
+			}
+		}
+	}
+
+	void LuaMessageBatcher::Send(STDString const& channel, STDString const& payload, UserId userId, bool binary)
+	{
+		auto& networkMgr = gOsirisProxy->GetNetworkManager();
+		auto peerId = userId.GetPeerId();
+		if (!networkMgr.ServerCanSendExtenderMessages(peerId)) {
+			ERR("Attempted to send extender message to user %d that does not understand extender protocol!", userId.Id);
+			return;
+		}
+
+		QueueForPeer(peerId, channel, payload, binary);
+	}
+
+	void LuaMessageBatcher::QueueForPeer(PeerId peerId, STDString const& channel, STDString const& payload, bool binary)
+	{
+		auto& networkMgr = gOsirisProxy->GetNetworkManager();
+		auto capabilities = networkMgr.GetPeerCapabilities(peerId);
+		if (binary && !(capabilities & (uint32_t)net::ExtenderCapabilities::BinaryMessages)) {
+			WARN("Not sending binary message to peer %d as its extender version doesn't support it!", peerId);
+			return;
+		}
+
+		if (!(capabilities & (uint32_t)net::ExtenderCapabilities::MessageBatching)) {
+			SendUnbatched(peerId, channel, payload, binary);
+			return;
+		}
+
+		auto& queue = queues_[peerId];
+		queue.Messages.push_back(QueuedMessage{ std::string(channel.data(), channel.size()), std::string(payload.data(), payload.size()), binary });
+		queue.Bytes += channel.size() + payload.size();
+		stats_.MessagesBatched++;
+
+		if (queue.Messages.size() >= maxMessages_ || queue.Bytes >= maxBytes_) {
+			stats_.ThresholdFlushes++;
+			FlushPeer(peerId, queue);
+		}
+	}
+
+	void LuaMessageBatcher::SendUnbatched(PeerId peerId, STDString const& channel, STDString const& payload, bool binary)
+	{
+		auto& networkMgr = gOsirisProxy->GetNetworkManager();
+		auto msg = networkMgr.GetFreeServerMessage(UserId::Unassigned);
+		if (msg != nullptr) {
+			auto postMsg = msg->GetMessage().mutable_post_lua();
+			postMsg->set_channel_name(channel.data(), channel.size());
+			if (binary) {
+				postMsg->set_binary_payload(payload.data(), payload.size());
+			} else {
+				postMsg->set_payload(payload.data(), payload.size());
+			}
+			networkMgr.ServerSendToPeer(msg, peerId);
+			stats_.MessagesUnbatched++;
+		} else {
+			OsiErrorS("Could not get free message!");
+		}
+	}
+
+	void LuaMessageBatcher::FlushPeer(PeerId peerId, PeerQueue& queue)
+	{
+		if (queue.Messages.empty()) return;
+
+		auto& networkMgr = gOsirisProxy->GetNetworkManager();
+		// The peer may have disconnected since the messages were queued
+		if (networkMgr.ServerCanSendExtenderMessages(peerId)) {
+			auto msg = networkMgr.GetFreeServerMessage(UserId::Unassigned);
+			if (msg != nullptr) {
+				auto batch = msg->GetMessage().mutable_post_lua_batch();
+				batch->mutable_messages()->Reserve((int)queue.Messages.size());
+				for (auto& queued : queue.Messages) {
+					auto postMsg = batch->add_messages();
+					postMsg->set_channel_name(std::move(queued.Channel));
+					if (queued.Binary) {
+						postMsg->set_binary_payload(std::move(queued.Payload));
+					} else {
+						postMsg->set_payload(std::move(queued.Payload));
+					}
+				}
+
+				networkMgr.ServerSendToPeer(msg, peerId);
+				stats_.BatchesSent++;
+				stats_.BytesSent += queue.Bytes;
+			} else {
+				OsiErrorS("Could not get free message!");
+			}
+		}
+
+		queue.Messages.clear();
+		queue.Bytes = 0;
+	}
+
+	void LuaMessageBatcher::Flush()
+	{
+		for (auto& queue : queues_) {
+			FlushPeer(queue.first, queue.second);
+		}
+	}
+
+	void LuaMessageBatcher::Reset()
+	{
+		channels_.clear();
+		queues_.clear();
+		maxMessages_ = DefaultMaxMessages;
+		maxBytes_ = DefaultMaxBytes;
+		ResetStats();
+	}
 }
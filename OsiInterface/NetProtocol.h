@@ -1,7 +1,11 @@
 #pragma once
 
 #include <GameDefinitions/Net.h>
+#include <GameDefinitions/Misc.h>
+#include <GameDefinitions/Stats.h>
+#include <NetMessageFragments.h>
 #include "ScriptExtensions.pb.h"
+#include <mutex>
 
 namespace dse
 {
@@ -55,8 +59,16 @@ namespace dse
 		void * OnRemovedFromHost() override;
 		void * Unknown2() override;
 
+		// Drops partially received fragmented messages
+		void ResetFragments();
+
 	protected:
 		virtual void ProcessExtenderMessage(net::MessageContext& context, MessageWrapper & msg) = 0;
+
+	private:
+		net::FragmentReassembler reassembler_;
+
+		void ProcessFragment(net::MessageContext& context, MsgFragment const& fragment);
 	};
 
 	class ExtenderProtocolClient : public ExtenderProtocol
@@ -70,6 +82,9 @@ namespace dse
 
 	class ExtenderProtocolServer : public ExtenderProtocol
 	{
+	public:
+		int PostUpdate(void * Unknown) override;
+
 	protected:
 		void ProcessExtenderMessage(net::MessageContext& context, MessageWrapper & msg) override;
 	};
@@ -78,13 +93,21 @@ namespace dse
 	class NetworkManager
 	{
 	public:
+		// Fragment channels; sequence numbers of fragmented messages are allocated per channel
+		static constexpr uint32_t ClientToServerChannel = 0;
+		static constexpr uint32_t ServerToUserChannel = 1;
+		static constexpr uint32_t ServerBroadcastChannel = 2;
+
 		void ClientReset();
 		void ServerReset();
 
 		bool ClientCanSendExtenderMessages() const;
 		bool ServerCanSendExtenderMessages(PeerId peerId) const;
 		void ClientAllowExtenderMessages();
-		void ServerAllowExtenderMessages(PeerId peerId);
+		void ServerAllowExtenderMessages(PeerId peerId, uint32_t capabilities = 0);
+		// Called when the server replied to MsgC2SExtenderHello
+		void ClientSetServerCapabilities(uint32_t capabilities);
+		uint32_t ClientGetServerCapabilities() const;
 
 		void ExtendNetworkingClient();
 		void ExtendNetworkingServer();
@@ -96,6 +119,12 @@ namespace dse
 		void ServerSend(ScriptExtenderMessage * msg, UserId userId);
 		void ServerBroadcast(ScriptExtenderMessage * msg, UserId excludeUserId);
 		void ServerBroadcastToConnectedPeers(ScriptExtenderMessage* msg, UserId excludeUserId);
+		void ServerSendToPeer(ScriptExtenderMessage* msg, PeerId peerId);
+		void ServerSendToPeers(ScriptExtenderMessage* msg, std::vector<PeerId> const& peerIds);
+
+		// Active peers that support the extender protocol
+		std::vector<PeerId> ServerGetExtenderPeerIds() const;
+		uint32_t GetPeerCapabilities(PeerId peerId) const;
 
 	private:
 		ExtenderProtocolClient * clientProtocol_{ nullptr };
@@ -106,6 +135,12 @@ namespace dse
 		bool clientExtenderSupport_{ false };
 		// List of clients that support the extender protocol
 		std::unordered_set<PeerId> serverExtenderPeerIds_;
+		// Mask of net::ExtenderCapabilities supported by the server
+		uint32_t serverCapabilities_{ 0 };
+		// Mask of net::ExtenderCapabilities supported by each client
+		std::unordered_map<PeerId, uint32_t> peerCapabilities_;
+		net::FragmentWriter clientFragmentWriter_;
+		net::FragmentWriter serverFragmentWriter_;
 
 		net::GameServer * GetServer() const;
 		net::Client * GetClient() const;
@@ -113,14 +148,19 @@ namespace dse
 		void OnClientConnectMessage(net::Message* msg, net::BitstreamSerializer* serializer);
 		void OnClientAcceptMessage(net::Message* msg, net::BitstreamSerializer* serializer);
 		void HookMessages(net::MessageFactory* messageFactory);
+		// Splits messages that are too large to be sent in a single packet (or are worth
+		// compressing) into MsgFragment messages. The first fragment reuses msg.
+		std::vector<ScriptExtenderMessage*> MakeFragments(ScriptExtenderMessage* msg, uint32_t capabilities,
+			uint32_t channel, bool server);
 	};
 
 
 	class NetworkFixedStringSynchronizer
 	{
 	public:
-		void OnUpdateRequested(UserId userId);
-		void RequestFromServer();
+		void OnUpdateRequested(UserId userId, MsgC2SRequestNetworkFixedStrings const& request);
+		// If full is set, the server sends every block regardless of the strings we already have
+		void RequestFromServer(bool full = false);
 		void FlushQueuedRequests();
 		void UpdateFromServer();
 		void ClientReset();
@@ -130,15 +170,143 @@ namespace dse
 		inline void SetServerNetworkFixedStrings(std::vector<STDString>& strs)
 		{
 			updatedStrings_ = strs;
+			delta_.reset();
+			firstChangedIndex_ = 0;
 		}
 
+		// Stores a delta update; it is merged with the local table in UpdateFromServer()
+		void SetServerNetworkFixedStringsDelta(MsgS2CSyncNetworkFixedStrings const& msg);
+
 	private:
+		struct DeltaUpdate
+		{
+			uint32_t NumStrings{ 0 };
+			uint32_t BlockSize{ 0 };
+			uint64_t TableHash{ 0 };
+			std::vector<uint32_t> Blocks;
+			std::vector<STDString> Strings;
+		};
+
 		std::vector<STDString> updatedStrings_;
-		std::unordered_set<UserId> pendingSyncRequests_;
+		std::optional<DeltaUpdate> delta_;
+		// Strings before this index are known to match the server table
+		uint32_t firstChangedIndex_{ 0 };
+		bool fullUpdateRequested_{ false };
+		std::unordered_map<UserId, MsgC2SRequestNetworkFixedStrings> pendingSyncRequests_;
 		bool notInSync_{ false };
 		bool syncWarningShown_{ false };
 		STDString conflictingString_;
 
-		void SendUpdateToUser(UserId userId);
+		void SendUpdateToUser(UserId userId, MsgC2SRequestNetworkFixedStrings const& request);
+		bool MergeDelta(eoc::NetworkFixedStrings const& fs);
+	};
+
+	// Collects stats entries synced during a server tick and sends them to clients
+	// in a single message. Entries whose modified attributes are known are sent as
+	// partial updates that only contain the modified attributes.
+	class StatSynchronizer
+	{
+	public:
+		// Maximum size of the stats entries sent in a single message
+		static constexpr std::size_t MaxBatchSize = 0x40000;
+
+		void MarkAttributeDirty(FixedString const& statId, uint32_t attributeIndex);
+		void MarkFieldDirty(FixedString const& statId, StatSyncField field);
+		// The next sync of the stats entry will contain all attributes
+		// (eg. because the entry doesn't exist on the client yet)
+		void MarkFullSync(FixedString const& statId);
+		// Sends the stats entry to clients on the next network update
+		void QueueSync(FixedString const& statId);
+		void Flush();
+		void Reset();
+
+	private:
+		struct DirtyState
+		{
+			std::vector<uint32_t> Attributes;
+			uint32_t Fields{ 0 };
+			bool Full{ false };
+		};
+
+		// Sends a full MsgS2CSyncStat for each entry to peers without the BatchedStatSync capability
+		void SendLegacySync(CRPGStats_Object* object, std::vector<PeerId> const& peerIds);
+
+		std::mutex mutex_;
+		std::unordered_map<FixedString, DirtyState> dirty_;
+		std::vector<FixedString> queuedIds_;
+		std::unordered_map<FixedString, DirtyState> queued_;
+
+		DirtyState& GetDirtyState(FixedString const& statId);
+	};
+
+	// Collects Lua messages of channels that have batching enabled and sends the messages
+	// queued for each peer in a single MsgPostLuaMessages message at the end of the server tick.
+	// Messages of a channel are delivered in the order they were posted; messages of
+	// unbatched channels are sent immediately, so they may arrive before earlier batched ones.
+	class LuaMessageBatcher
+	{
+	public:
+		static constexpr uint32_t DefaultMaxMessages = 256;
+		static constexpr uint32_t DefaultMaxBytes = 0x8000;
+
+		struct Stats
+		{
+			// Messages added to a batch
+			uint64_t MessagesBatched{ 0 };
+			// MsgPostLuaMessages messages sent
+			uint64_t BatchesSent{ 0 };
+			// Channel name and payload bytes sent in batches
+			uint64_t BytesSent{ 0 };
+			// Batches sent before the end of the tick because a limit was reached
+			uint64_t ThresholdFlushes{ 0 };
+			// Messages of batched channels sent separately, because the peer doesn't support batching
+			uint64_t MessagesUnbatched{ 0 };
+		};
+
+		void SetChannelBatching(STDString const& channel, bool enabled);
+		bool IsBatched(STDString const& channel) const;
+		// A peer queue is flushed immediately when it reaches either limit
+		void SetLimits(uint32_t maxMessages, uint32_t maxBytes);
+
+		// Queues the message for every extender peer (except the peer of excludeUserId).
+		// Binary payloads are only sent to peers with the BinaryMessages capability.
+		void Broadcast(STDString const& channel, STDString const& payload, UserId excludeUserId, bool binary = false);
+		void Send(STDString const& channel, STDString const& payload, UserId userId, bool binary = false);
+		void Flush();
+		void Reset();
+
+		inline Stats const& GetStats() const
+		{
+			return stats_;
+		}
+
+		inline void ResetStats()
+		{
+			stats_ = Stats{};
+		}
+
+	private:
+		struct QueuedMessage
+		{
+			std::string Channel;
+			std::string Payload;
+			bool Binary{ false };
+		};
+
+		struct PeerQueue
+		{
+			std::vector<QueuedMessage> Messages;
+			std::size_t Bytes{ 0 };
+		};
+
+		std::unordered_set<STDString> channels_;
+		std::unordered_map<PeerId, PeerQueue> queues_;
+		uint32_t maxMessages_{ DefaultMaxMessages };
+		uint32_t maxBytes_{ DefaultMaxBytes };
+		Stats stats_;
+
+		void QueueForPeer(PeerId peerId, STDString const& channel, STDString const& payload, bool binary);
+		void SendUnbatched(PeerId peerId, STDString const& channel, STDString const& payload, bool binary);
+		void FlushPeer(PeerId peerId, PeerQueue& queue);
 	};
 }
@@ -0,0 +1,109 @@
+// Compiled without the precompiled header, so the standalone test can build it as well
+#include "NetworkStringTable.h"
+#include <algorithm>
+
+namespace dse
+{
+	namespace
+	{
+		constexpr uint64_t FnvOffsetBasis = 0xcbf29ce484222325ull;
+		constexpr uint64_t FnvPrime = 0x100000001b3ull;
+
+		inline uint64_t FnvHash(uint64_t hash, void const* data, std::size_t size)
+		{
+			auto bytes = reinterpret_cast<uint8_t const*>(data);
+			for (std::size_t i = 0; i < size; i++) {
+				hash = (hash ^ bytes[i]) * FnvPrime;
+			}
+
+			return hash;
+		}
+	}
+
+	NetworkStringTableHash HashNetworkStrings(std::vector<std::string_view> const& strings, uint32_t blockSize)
+	{
+		NetworkStringTableHash hash;
+		hash.BlockSize = blockSize;
+		hash.NumStrings = (uint32_t)strings.size();
+
+		auto numBlocks = GetNumNetworkStringBlocks(hash.NumStrings, blockSize);
+		hash.BlockHashes.resize(numBlocks);
+
+		auto tableHash = FnvHash(FnvOffsetBasis, &hash.NumStrings, sizeof(hash.NumStrings));
+		for (uint32_t block = 0; block < numBlocks; block++) {
+			auto blockHash = FnvOffsetBasis;
+			auto first = block * blockSize;
+			auto last = std::min(first + blockSize, hash.NumStrings);
+			for (auto i = first; i < last; i++) {
+				auto const& str = strings[i];
+				// The terminator separates strings, so "ab","c" and "a","bc" hash differently
+				blockHash = FnvHash(blockHash, str.data(), str.size());
+				blockHash = (blockHash ^ 0xff) * FnvPrime;
+			}
+
+			hash.BlockHashes[block] = blockHash;
+			tableHash = FnvHash(tableHash, &blockHash, sizeof(blockHash));
+		}
+
+		hash.TableHash = tableHash;
+		return hash;
+	}
+
+	std::vector<uint32_t> FindMismatchingNetworkStringBlocks(NetworkStringTableHash const& server,
+		std::vector<uint64_t> const& clientBlockHashes)
+	{
+		std::vector<uint32_t> blocks;
+		for (uint32_t i = 0; i < server.BlockHashes.size(); i++) {
+			if (i >= clientBlockHashes.size() || clientBlockHashes[i] != server.BlockHashes[i]) {
+				blocks.push_back(i);
+			}
+		}
+
+		return blocks;
+	}
+
+	bool MergeNetworkStringBlocks(std::vector<std::string_view> const& localStrings, uint32_t numStrings,
+		uint32_t blockSize, std::vector<uint32_t> const& blockIndices, std::vector<std::string_view> const& blockStrings,
+		std::vector<std::string_view>& merged, std::string& error)
+	{
+		if (blockSize == 0) {
+			error = "Invalid block size";
+			return false;
+		}
+
+		merged.clear();
+		merged.reserve(numStrings);
+
+		auto numBlocks = GetNumNetworkStringBlocks(numStrings, blockSize);
+		std::size_t nextSentBlock{ 0 }, nextBlockString{ 0 };
+		for (uint32_t block = 0; block < numBlocks; block++) {
+			auto first = block * blockSize;
+			auto last = std::min(first + blockSize, numStrings);
+
+			if (nextSentBlock < blockIndices.size() && blockIndices[nextSentBlock] == block) {
+				if (nextBlockString + (last - first) > blockStrings.size()) {
+					error = "Server sent fewer strings than the blocks contain";
+					return false;
+				}
+
+				merged.insert(merged.end(), blockStrings.begin() + nextBlockString, blockStrings.begin() + nextBlockString + (last - first));
+				nextBlockString += last - first;
+				nextSentBlock++;
+			} else {
+				if (last > localStrings.size()) {
+					error = "Block was not sent by the server, but it is missing from the local table";
+					return false;
+				}
+
+				merged.insert(merged.end(), localStrings.begin() + first, localStrings.begin() + last);
+			}
+		}
+
+		if (nextSentBlock != blockIndices.size() || nextBlockString != blockStrings.size()) {
+			error = "Server sent blocks that are out of order or out of range";
+			return false;
+		}
+
+		return true;
+	}
+}
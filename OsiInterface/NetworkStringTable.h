@@ -0,0 +1,49 @@
+#pragma once
+
+// Block hashing and delta merging for NetworkFixedString table synchronization.
+// This file must not depend on game definitions; it is also compiled by the
+// standalone sync test (Tools/NetworkStringSyncTest).
+//
+// The table (excluding the null string at index 0) is split into blocks of BlockSize
+// strings. The client sends the hash of each block it has; the server replies with the
+// strings of the blocks that are missing or different on the client and the hash of
+// the whole table, which the client uses to verify the merged table.
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dse
+{
+	struct NetworkStringTableHash
+	{
+		uint32_t BlockSize{ 0 };
+		uint32_t NumStrings{ 0 };
+		// Hash of the block hashes and the number of strings
+		uint64_t TableHash{ 0 };
+		std::vector<uint64_t> BlockHashes;
+	};
+
+	// Number of strings per block requested by the client
+	constexpr uint32_t NetworkStringBlockSize = 256;
+	constexpr uint32_t MinNetworkStringBlockSize = 16;
+	constexpr uint32_t MaxNetworkStringBlockSize = 0x10000;
+
+	inline uint32_t GetNumNetworkStringBlocks(uint32_t numStrings, uint32_t blockSize)
+	{
+		return (numStrings + blockSize - 1) / blockSize;
+	}
+
+	NetworkStringTableHash HashNetworkStrings(std::vector<std::string_view> const& strings, uint32_t blockSize);
+
+	// Returns the (ascending) indices of the server blocks that are missing or different on the client
+	std::vector<uint32_t> FindMismatchingNetworkStringBlocks(NetworkStringTableHash const& server,
+		std::vector<uint64_t> const& clientBlockHashes);
+
+	// Reconstructs the server table from the local table and the strings of the blocks sent by
+	// the server (in blockIndices order). The views in merged point into localStrings and blockStrings.
+	bool MergeNetworkStringBlocks(std::vector<std::string_view> const& localStrings, uint32_t numStrings,
+		uint32_t blockSize, std::vector<uint32_t> const& blockIndices, std::vector<std::string_view> const& blockStrings,
+		std::vector<std::string_view>& merged, std::string& error);
+}
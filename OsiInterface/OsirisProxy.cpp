@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "OsirisProxy.h"
 #include "NodeHooks.h"
+#include "StatSnapshot.h"
 #include "Version.h"
 #include <string>
 #include <fstream>
@@ -9,7 +10,7 @@
 #include <chrono>
 #include <ctime>
 #include <psapi.h>
-#include <regex>
+#include <algorithm>
 
 #undef DEBUG_SERVER_CLIENT
 
@@ -35,6 +36,10 @@ void OsirisProxy::Initialize()
 		InitCrashReporting();
 	}
 
+	if (config_.LogRuntime) {
+		gConsole.OpenLogFile(MakeLogFilePath(L"Extender Runtime", L"log"));
+	}
+
 	if (config_.EnableLogging || config_.LogCompile) {
 		DEBUG(L"Osiris logs will be written to %s", config_.LogDirectory.c_str());
 	}
@@ -423,15 +428,23 @@ void OsirisProxy::RegisterFlashTraceCallbacks()
 void OsirisProxy::OnStatsLoadStarted(CRPGStatsManager* mgr)
 {
 	statLoadOrderHelper_.OnLoadStarted();
+	gStatAttributeCache.Clear();
+	gStatEntryIndex.Clear();
+	gStatLevelMapCache.Clear();
+	gStatSnapshots.Clear();
 }
 
 void OsirisProxy::OnStatsLoadFinished(CRPGStatsManager* mgr)
 {
 	statLoadOrderHelper_.OnLoadFinished();
+	gStatAttributeCache.Build(mgr);
+	gStatEntryIndex.Build(mgr);
 	auto state = GetCurrentExtensionState();
 	if (state) {
 		state->OnStatsLoaded();
 	}
+
+	gStatSnapshots.Publish(mgr);
 }
 
 void OsirisProxy::FlashTraceCallback(void * ctx, void * player, char const * message)
@@ -908,6 +921,10 @@ void OsirisProxy::OnServerGameStateChanged(void * self, esv::GameState fromState
 		AddServerThread(GetCurrentThreadId());
 	}
 
+	// Object handles may be reused by other objects after a level swap or reload
+	esv::gGameObjectGuidCache.Clear();
+	esv::gObjectSpatialIndex.Clear();
+
 	switch (fromState) {
 	case esv::GameState::LoadModule:
 		INFO("OsirisProxy::OnServerGameStateChanged(): Loaded module");
@@ -926,6 +943,8 @@ void OsirisProxy::OnServerGameStateChanged(void * self, esv::GameState fromState
 	// We only need to reset the extender enabled peer list on a disconnect.
 	case esv::GameState::Disconnect:
 		networkManager_.ServerReset();
+		// Drops the messages queued for the disconnected peers
+		luaMessageBatcher_.Flush();
 		break;
 
 	case esv::GameState::UnloadSession:
@@ -1167,6 +1186,10 @@ void OsirisProxy::ResetExtensionStateServer()
 	ServerExtState = std::make_unique<esv::ExtensionState>();
 	ServerExtState->Reset();
 	ServerExtensionLoaded = false;
+	statSync_.Reset();
+	luaMessageBatcher_.Reset();
+	esv::gGameObjectGuidCache.Clear();
+	esv::gObjectSpatialIndex.Clear();
 }
 
 void OsirisProxy::LoadExtensionStateServer()
@@ -1284,14 +1307,23 @@ void SavegameSerializer::SerializePersistentVariables(ObjectVisitor* visitor, ui
 					FixedString modId;
 					visitor->VisitFixedString(GFS.strModId, modId, GFS.strEmpty);
 					STDString modVars;
-					visitor->VisitSTDString(GFS.strLuaVariables, modVars, nullStr);
+					if (version >= 49) {
+						ScratchBuffer blob;
+						visitor->VisitBuffer(GFS.strBlob, blob);
+						if (blob.Buffer != nullptr) {
+							modVars.assign(reinterpret_cast<char const*>(blob.Buffer), blob.Size);
+						}
+					} else {
+						// Savegames before v49 store persistent vars as JSON
+						visitor->VisitSTDString(GFS.strLuaVariables, modVars, nullStr);
+					}
 
 					variables.insert(std::make_pair(modId, modVars));
 					visitor->ExitNode(GFS.strMod);
 				}
 			}
 
-			RestorePersistentVariables(variables);
+			RestorePersistentVariables(variables, version < 49);
 		}
 		else {
 			for (auto const& config : configs) {
@@ -1305,7 +1337,11 @@ void SavegameSerializer::SerializePersistentVariables(ObjectVisitor* visitor, ui
 							if (visitor->EnterNode(GFS.strMod, GFS.strModId)) {
 								FixedString modId = MakeFixedString(config.first.c_str());
 								visitor->VisitFixedString(GFS.strModId, modId, GFS.strEmpty);
-								visitor->VisitSTDString(GFS.strLuaVariables, *vars, nullStr);
+								ScratchBuffer blob;
+								blob.Size = (uint32_t)vars->size();
+								blob.Buffer = GameAllocRaw(blob.Size);
+								memcpy(blob.Buffer, vars->data(), blob.Size);
+								visitor->VisitBuffer(GFS.strBlob, blob);
 								visitor->ExitNode(GFS.strMod);
 							}
 						}
@@ -1321,7 +1357,7 @@ void SavegameSerializer::SerializePersistentVariables(ObjectVisitor* visitor, ui
 	}
 }
 
-void SavegameSerializer::RestorePersistentVariables(std::unordered_map<FixedString, STDString> const& variables)
+void SavegameSerializer::RestorePersistentVariables(std::unordered_map<FixedString, STDString> const& variables, bool legacyJson)
 {
 	auto const& configs = gOsirisProxy->GetServerExtensionState().GetConfigs();
 
@@ -1332,7 +1368,7 @@ void SavegameSerializer::RestorePersistentVariables(std::unordered_map<FixedStri
 				DEBUG("Restoring persistent vars for mod %s (%ld bytes)", var.first.Str, var.second.size());
 				esv::LuaServerPin lua(esv::ExtensionState::Get());
 				if (lua) {
-					lua->RestoreModPersistentVars(configIt->second.ModTable, var.second);
+					lua->RestoreModPersistentVars(configIt->second.ModTable, var.second, legacyJson);
 				}
 			}
 			else {
@@ -1422,7 +1458,8 @@ void SavegameSerializer::RestoreStatObject(FixedString const& statId, FixedStrin
 
 	object->FromProtobuf(msg);
 	stats->SyncWithPrototypeManager(object);
-	object->BroadcastSyncMessage();
+	gOsirisProxy->StatSync().MarkFullSync(statId);
+	gOsirisProxy->StatSync().QueueSync(statId);
 	gOsirisProxy->GetServerExtensionState().MarkRuntimeModifiedStat(statId);
 }
 
@@ -1454,13 +1491,40 @@ void StatLoadOrderHelper::OnLoadStarted()
 	loadingStats_ = true;
 	statLastTxtMod_ = FixedString{};
 	statsEntryToModMap_.clear();
+	preParseBufferRanges_.Clear();
+	modEntries_.clear();
 	UpdateModDirectoryMap();
 }
 
 void StatLoadOrderHelper::OnLoadFinished()
 {
-	OnStatFileOpened();
+	// Entries pre-parsed after the last opened stats file belong to the mod of that file
+	AddPreParseBufferRange();
 	loadingStats_ = false;
+	BuildStatsEntryModMap();
+	BuildModEntryIndex();
+}
+
+void StatLoadOrderHelper::BuildModEntryIndex()
+{
+	modEntries_.clear();
+
+	auto stats = GetStaticSymbols().GetStats();
+	auto numModifierLists = stats->modifierList.Primitives.Set.Size;
+	for (uint32_t i = 0; i < stats->objects.Primitives.Set.Size; i++) {
+		auto object = stats->objects.Primitives[i];
+		auto mod = GetStatsEntryMod(object->Name);
+		if (!mod || object->ModifierListIndex < 0 || object->ModifierListIndex >= (int32_t)numModifierLists) {
+			continue;
+		}
+
+		auto& entries = modEntries_[mod];
+		if (entries.empty()) {
+			entries.resize(numModifierLists);
+		}
+
+		entries[object->ModifierListIndex].push_back((int32_t)i);
+	}
 }
 
 void StatLoadOrderHelper::UpdateModDirectoryMap()
@@ -1477,39 +1541,43 @@ void StatLoadOrderHelper::UpdateModDirectoryMap()
 	}
 }
 
-void StatLoadOrderHelper::OnStatFileOpened()
+void StatLoadOrderHelper::BuildStatsEntryModMap()
 {
+	// Entries are attributed to the mod of the first stats file opened after the entry
+	// was pre-parsed (the final range closed by OnLoadFinished() covers the rest).
+	// Pre-parse buffers are only appended, so the buffer index of an entry tells
+	// which file opening came first after the entry (or its latest override) was parsed.
 	auto stats = GetStaticSymbols().GetStats();
-	auto const& bufs = stats->PreParsedDataBufferMap;
-	bufs.Iterate([this, stats](auto const& key, auto const& preParseBufIdx) {
-		auto preParseBuf = stats->PreParsedDataBuffers[(uint32_t)preParseBufIdx];
-		auto entry = statsEntryToModMap_.find(key);
-		if (entry == statsEntryToModMap_.end()) {
-			StatsEntryModMapping mapping;
-			mapping.Mod = statLastTxtMod_;
-			mapping.PreParseBuf = preParseBuf;
-			statsEntryToModMap_.insert(std::make_pair(key, mapping));
-		} else if (entry->second.PreParseBuf != preParseBuf) {
-			entry->second.Mod = statLastTxtMod_;
-			entry->second.PreParseBuf = preParseBuf;
+	statsEntryToModMap_.clear();
+	statsEntryToModMap_.reserve(stats->PreParsedDataBufferMap.ItemCount);
+
+	stats->PreParsedDataBufferMap.Iterate([this](auto const& key, auto const& preParseBufIdx) {
+		auto mod = preParseBufferRanges_.Find((uint32_t)preParseBufIdx);
+		if (mod != nullptr) {
+			statsEntryToModMap_.insert(std::make_pair(key, *mod));
 		}
 	});
 }
 
-static std::regex sStatPathRegex(".*/Public/(.*)/Stats/Generated/.*.txt$");
+void StatLoadOrderHelper::AddPreParseBufferRange()
+{
+	auto numBuffers = GetStaticSymbols().GetStats()->PreParsedDataBuffers.Set.Size;
+	preParseBufferRanges_.Add(numBuffers, statLastTxtMod_);
+}
 
 void StatLoadOrderHelper::OnStatFileOpened(Path const& path)
 {
 	if (!loadingStats_) return;
 
-	std::cmatch match;
-	if (std::regex_match(path.Name.c_str(), match, sStatPathRegex)) {
+	std::string_view modDirectory;
+	if (MatchStatsFilePath(path.Name, modDirectory)) {
 		std::unique_lock lock(modMapMutex_);
 
-		auto modIt = modDirectoryToModMap_.find(match[1].str().c_str());
+		auto modIt = modDirectoryToModMap_.find(STDString(modDirectory));
 		if (modIt != modDirectoryToModMap_.end()) {
 			statLastTxtMod_ = modIt->second;
-			OnStatFileOpened();
+			// Entries pre-parsed since the last opened file are attributed to this mod
+			AddPreParseBufferRange();
 		} else {
 			WARN("Unable to resolve mod while loading stats .txt: %s", path.Name.c_str());
 		}
@@ -1520,21 +1588,21 @@ FixedString StatLoadOrderHelper::GetStatsEntryMod(FixedString statId) const
 {
 	auto entryIt = statsEntryToModMap_.find(statId);
 	if (entryIt != statsEntryToModMap_.end()) {
-		return entryIt->second.Mod;
+		return entryIt->second;
 	} else {
 		return {};
 	}
 }
 
-std::vector<CRPGStats_Object*> StatLoadOrderHelper::GetStatsLoadedBefore(FixedString modId) const
+std::vector<CRPGStats_Object*> StatLoadOrderHelper::GetStatsLoadedBefore(FixedString modId, int32_t modifierListIndex) const
 {
-	std::unordered_set<FixedString> modsLoadedBefore;
+	std::vector<FixedString> modsLoadedBefore;
 	auto state = gOsirisProxy->GetCurrentExtensionState();
 	if (!state) return {};
 
 	bool modIdFound{ false };
 	for (auto const& mod : state->GetModManager()->BaseModule.LoadOrderedModules) {
-		modsLoadedBefore.insert(mod.Info.ModuleUUID);
+		modsLoadedBefore.push_back(mod.Info.ModuleUUID);
 		if (mod.Info.ModuleUUID == modId) {
 			modIdFound = true;
 			break;
@@ -1546,13 +1614,30 @@ std::vector<CRPGStats_Object*> StatLoadOrderHelper::GetStatsLoadedBefore(FixedSt
 		return {};
 	}
 
+	std::vector<int32_t> handles;
+	for (auto const& mod : modsLoadedBefore) {
+		auto modIt = modEntries_.find(mod);
+		if (modIt == modEntries_.end()) continue;
+
+		auto const& entries = modIt->second;
+		if (modifierListIndex == -1) {
+			for (auto const& typeEntries : entries) {
+				handles.insert(handles.end(), typeEntries.begin(), typeEntries.end());
+			}
+		} else if (modifierListIndex >= 0 && modifierListIndex < (int32_t)entries.size()) {
+			auto const& typeEntries = entries[modifierListIndex];
+			handles.insert(handles.end(), typeEntries.begin(), typeEntries.end());
+		}
+	}
+
+	// Keep the creation order of entries regardless of which mod they came from
+	std::sort(handles.begin(), handles.end());
+
 	std::vector<CRPGStats_Object*> statsLoadedBefore;
+	statsLoadedBefore.reserve(handles.size());
 	auto stats = GetStaticSymbols().GetStats();
-	for (auto const& object : stats->objects.Primitives) {
-		auto statEntryMod = GetStatsEntryMod(object->Name);
-		if (statEntryMod && modsLoadedBefore.find(statEntryMod) != modsLoadedBefore.end()) {
-			statsLoadedBefore.push_back(object);
-		}
+	for (auto handle : handles) {
+		statsLoadedBefore.push_back(stats->objects.Primitives[handle]);
 	}
 
 	return statsLoadedBefore;
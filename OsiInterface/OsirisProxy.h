@@ -16,6 +16,8 @@
 #include <GameDefinitions/Symbols.h>
 #include <GlobalFixedStrings.h>
 #include <Hit.h>
+#include <SpatialIndex.h>
+#include <StatLoadOrder.h>
 
 #include <thread>
 #include <mutex>
@@ -42,6 +44,8 @@ struct ToolConfig
 
 	bool SendCrashReports{ true };
 	bool EnableAchievements{ true };
+	bool EnableLuaBytecodeCache{ true };
+	bool LogRuntime{ false };
 
 #if defined(OSI_EXTENSION_BUILD)
 	bool DisableModValidation{ true };
@@ -75,7 +79,7 @@ public:
 private:
 	void Serialize(ObjectVisitor* visitor, uint32_t version);
 	void SerializePersistentVariables(ObjectVisitor* visitor, uint32_t version);
-	void RestorePersistentVariables(std::unordered_map<FixedString, STDString> const&);
+	void RestorePersistentVariables(std::unordered_map<FixedString, STDString> const&, bool legacyJson);
 	void SerializeStatObjects(ObjectVisitor* visitor, uint32_t version);
 	void RestoreStatObject(FixedString const& statId, FixedString const& statType, ScratchBuffer const& blob);
 	bool SerializeStatObject(FixedString const& statId, FixedString& statType, ScratchBuffer& blob);
@@ -86,23 +90,26 @@ class StatLoadOrderHelper
 public:
 	void OnLoadStarted();
 	void OnLoadFinished();
-	void OnStatFileOpened();
 	void OnStatFileOpened(Path const& path);
 	void UpdateModDirectoryMap();
+	void BuildStatsEntryModMap();
+	void BuildModEntryIndex();
 
 	FixedString GetStatsEntryMod(FixedString statId) const;
-	std::vector<CRPGStats_Object*> GetStatsLoadedBefore(FixedString modId) const;
+	// Returns stats entries loaded by the specified mod or any mod before it, optionally
+	// filtered by modifier list (-1 = all types), in creation order
+	std::vector<CRPGStats_Object*> GetStatsLoadedBefore(FixedString modId, int32_t modifierListIndex = -1) const;
 
 private:
-	struct StatsEntryModMapping
-	{
-		FixedString Mod;
-		void* PreParseBuf;
-	};
+	// Attributes entries pre-parsed since the previous range to statLastTxtMod_
+	void AddPreParseBufferRange();
 
 	std::shared_mutex modMapMutex_;
 	std::unordered_map<STDString, FixedString> modDirectoryToModMap_;
-	std::unordered_map<FixedString, StatsEntryModMapping> statsEntryToModMap_;
+	std::unordered_map<FixedString, FixedString> statsEntryToModMap_;
+	PreParseBufferRanges<FixedString> preParseBufferRanges_;
+	// Handles of stats entries loaded by each mod, grouped by modifier list
+	std::unordered_map<FixedString, std::vector<std::vector<int32_t>>> modEntries_;
 	FixedString statLastTxtMod_;
 	bool loadingStats_{ false };
 };
@@ -213,6 +220,16 @@ public:
 		return networkFixedStrings_;
 	}
 
+	inline StatSynchronizer& StatSync()
+	{
+		return statSync_;
+	}
+
+	inline LuaMessageBatcher& LuaMessageBatch()
+	{
+		return luaMessageBatcher_;
+	}
+
 	inline StatLoadOrderHelper& GetStatLoadOrderHelper()
 	{
 		return statLoadOrderHelper_;
@@ -246,6 +263,8 @@ private:
 	std::shared_mutex pathOverrideMutex_;
 	std::unordered_map<STDString, STDString> pathOverrides_;
 	NetworkFixedStringSynchronizer networkFixedStrings_;
+	StatSynchronizer statSync_;
+	LuaMessageBatcher luaMessageBatcher_;
 	SavegameSerializer savegameSerializer_;
 	StatLoadOrderHelper statLoadOrderHelper_;
 	esv::HitProxy hitProxy_;
@@ -0,0 +1,179 @@
+#pragma once
+
+// Uniform grid used by the server object spatial index (SpatialIndex.h).
+// This file must not depend on game definitions; it is also compiled by the
+// standalone benchmark (Tools/SpatialIndexBenchmark).
+
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace dse
+{
+	// Uniform grid over the XZ plane for radius queries.
+	// Objects are identified by a dense slot index (the object factory index of the game object)
+	// and carry an opaque 64-bit handle. Updating the position of an object only touches the
+	// cell lists when the object crosses a cell boundary.
+	class SpatialGrid
+	{
+	public:
+		static constexpr float DefaultCellSize = 8.0f;
+
+		explicit SpatialGrid(float cellSize = DefaultCellSize)
+			: invCellSize_(1.0f / cellSize)
+		{}
+
+		// Inserts the object or updates its position.
+		// If the slot holds a different handle, the previous object is replaced.
+		void Update(uint32_t slot, uint64_t handle, float x, float y, float z)
+		{
+			if (slot >= entries_.size()) {
+				entries_.resize(slot + 1);
+			}
+
+			auto& entry = entries_[slot];
+			auto cell = GetCellKey(x, z);
+			if (entry.Handle == 0) {
+				size_++;
+				AddToCell(slot, cell);
+			} else if (entry.Cell != cell) {
+				RemoveFromCell(slot);
+				AddToCell(slot, cell);
+			}
+
+			entry.Handle = handle;
+			entry.X = x;
+			entry.Y = y;
+			entry.Z = z;
+		}
+
+		void Remove(uint32_t slot)
+		{
+			if (slot >= entries_.size() || entries_[slot].Handle == 0) {
+				return;
+			}
+
+			RemoveFromCell(slot);
+			entries_[slot].Handle = 0;
+			size_--;
+		}
+
+		void Clear()
+		{
+			entries_.clear();
+			cells_.clear();
+			size_ = 0;
+		}
+
+		inline uint32_t Size() const
+		{
+			return size_;
+		}
+
+		inline uint32_t NumSlots() const
+		{
+			return (uint32_t)entries_.size();
+		}
+
+		// Calls visitor(handle, distanceSq) for each object within radius of the position.
+		// Distances are measured in 3D; the grid itself is 2D, as levels are mostly flat.
+		template <class Visitor>
+		void Query(float x, float y, float z, float radius, Visitor visitor) const
+		{
+			if (size_ == 0 || !(radius >= 0.0f)) {
+				return;
+			}
+
+			auto minX = CellCoord(x - radius), maxX = CellCoord(x + radius);
+			auto minZ = CellCoord(z - radius), maxZ = CellCoord(z + radius);
+			auto radiusSq = radius * radius;
+
+			auto visitCell = [&](std::vector<uint32_t> const& slots) {
+				for (auto slot : slots) {
+					auto const& entry = entries_[slot];
+					auto dx = entry.X - x, dy = entry.Y - y, dz = entry.Z - z;
+					auto distSq = dx * dx + dy * dy + dz * dz;
+					if (distSq <= radiusSq) {
+						visitor(entry.Handle, distSq);
+					}
+				}
+			};
+
+			// Large queries are cheaper to run on the list of occupied cells
+			auto numCells = (uint64_t)(maxX - minX + 1) * (uint64_t)(maxZ - minZ + 1);
+			if (numCells > cells_.size()) {
+				for (auto const& cell : cells_) {
+					auto cx = (int32_t)(uint32_t)(cell.first >> 32), cz = (int32_t)(uint32_t)cell.first;
+					if (cx >= minX && cx <= maxX && cz >= minZ && cz <= maxZ) {
+						visitCell(cell.second);
+					}
+				}
+			} else {
+				for (auto cx = minX; cx <= maxX; cx++) {
+					for (auto cz = minZ; cz <= maxZ; cz++) {
+						auto it = cells_.find(MakeCellKey(cx, cz));
+						if (it != cells_.end()) {
+							visitCell(it->second);
+						}
+					}
+				}
+			}
+		}
+
+	private:
+		struct Entry
+		{
+			// 0 if the slot is empty
+			uint64_t Handle{ 0 };
+			float X{ 0.0f }, Y{ 0.0f }, Z{ 0.0f };
+			uint64_t Cell{ 0 };
+			// Index of the slot in the cell list
+			uint32_t CellIndex{ 0 };
+		};
+
+		float invCellSize_;
+		std::vector<Entry> entries_;
+		// Cell lists are kept when they become empty, so objects moving back and forth
+		// between cells don't reallocate them
+		std::unordered_map<uint64_t, std::vector<uint32_t>> cells_;
+		uint32_t size_{ 0 };
+
+		inline int32_t CellCoord(float v) const
+		{
+			// Clamp to keep far away/invalid positions from overflowing the cell coordinates
+			auto c = std::floor(v * invCellSize_);
+			if (!(c > -1e9f)) return -1000000000;
+			if (c > 1e9f) return 1000000000;
+			return (int32_t)c;
+		}
+
+		static inline uint64_t MakeCellKey(int32_t cx, int32_t cz)
+		{
+			return ((uint64_t)(uint32_t)cx << 32) | (uint32_t)cz;
+		}
+
+		inline uint64_t GetCellKey(float x, float z) const
+		{
+			return MakeCellKey(CellCoord(x), CellCoord(z));
+		}
+
+		void AddToCell(uint32_t slot, uint64_t cell)
+		{
+			auto& slots = cells_[cell];
+			entries_[slot].Cell = cell;
+			entries_[slot].CellIndex = (uint32_t)slots.size();
+			slots.push_back(slot);
+		}
+
+		void RemoveFromCell(uint32_t slot)
+		{
+			auto const& entry = entries_[slot];
+			auto& slots = cells_[entry.Cell];
+			auto last = slots.back();
+			slots[entry.CellIndex] = last;
+			entries_[last].CellIndex = entry.CellIndex;
+			slots.pop_back();
+		}
+	};
+}
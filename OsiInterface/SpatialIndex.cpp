@@ -0,0 +1,77 @@
+#include <stdafx.h>
+#include <SpatialIndex.h>
+#include <algorithm>
+
+namespace dse::esv
+{
+	ObjectSpatialIndex gObjectSpatialIndex;
+
+	void ObjectSpatialIndex::Clear()
+	{
+		characters_.Clear();
+		items_.Clear();
+		level_ = FixedString{};
+		stale_.store(true, std::memory_order_relaxed);
+	}
+
+	FixedString GetCurrentLevelName()
+	{
+		auto levelMgr = GetStaticSymbols().LevelManager;
+		if (levelMgr == nullptr || *levelMgr == nullptr || (*levelMgr)->CurrentLevel == nullptr) {
+			return FixedString{};
+		}
+
+		auto name = (*levelMgr)->Levels.FindByValue((*levelMgr)->CurrentLevel);
+		return name ? *name : FixedString{};
+	}
+
+	template <class T, uint32_t TypeIndex, class Predicate>
+	void SyncGrid(ObjectFactory<T, TypeIndex> const& factory, SpatialGrid& grid, Predicate isIndexed)
+	{
+		auto numObjects = std::min(factory.Objects.Size, factory.Salts.Size);
+		for (uint32_t i = 0; i < numObjects; i++) {
+			auto object = factory.Objects[i];
+			if (object != nullptr && isIndexed(object)) {
+				ObjectHandle handle(TypeIndex, i, factory.Salts[i]);
+				grid.Update(i, handle.Handle, object->WorldPos.x, object->WorldPos.y, object->WorldPos.z);
+			} else {
+				grid.Remove(i);
+			}
+		}
+
+		// Slots that were released from the end of the factory
+		for (auto i = numObjects; i < grid.NumSlots(); i++) {
+			grid.Remove(i);
+		}
+	}
+
+	void ObjectSpatialIndex::Sync()
+	{
+		auto level = GetCurrentLevelName();
+		if (level != level_) {
+			characters_.Clear();
+			items_.Clear();
+			level_ = level;
+		}
+
+		if (!level) {
+			return;
+		}
+
+		auto characters = GetStaticSymbols().GetCharacterFactory();
+		if (characters != nullptr) {
+			SyncGrid(*characters, characters_, [&level](Character* character) {
+				return character->CurrentLevel == level
+					&& !(bool)(character->Flags & CharacterFlags::OffStage);
+			});
+		}
+
+		auto items = GetStaticSymbols().GetItemFactory();
+		if (items != nullptr) {
+			SyncGrid(*items, items_, [&level](Item* item) {
+				return item->CurrentLevel == level
+					&& !item->ParentInventoryHandle;
+			});
+		}
+	}
+}
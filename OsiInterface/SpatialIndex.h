@@ -0,0 +1,86 @@
+#pragma once
+
+#include <SpatialGrid.h>
+#include <GameDefinitions/Symbols.h>
+#include <atomic>
+
+namespace dse::esv
+{
+	// Spatial index of the server characters and items on the current level, for radius queries.
+	// There is no engine event for position changes, so the index is synchronized with the
+	// character and item factories on the first query after each server tick; objects only move
+	// between grid cells when they crossed a cell boundary since the last synchronization.
+	// Off-stage characters and items in inventories are not indexed.
+	// Only used from the server thread.
+	class ObjectSpatialIndex
+	{
+	public:
+		// Marks the indexed positions as outdated (called after each server tick)
+		inline void Invalidate()
+		{
+			stale_.store(true, std::memory_order_relaxed);
+		}
+
+		void Clear();
+
+		// Calls visitor(Character*, distanceSq) for each character within radius of the position
+		template <class Visitor>
+		void QueryCharacters(glm::vec3 const& pos, float radius, Visitor visitor)
+		{
+			SyncIfStale();
+			auto factory = GetStaticSymbols().GetCharacterFactory();
+			if (factory == nullptr) return;
+
+			characters_.Query(pos.x, pos.y, pos.z, radius, [factory, &visitor](uint64_t handle, float distSq) {
+				auto character = factory->Get(ObjectHandle(handle));
+				if (character != nullptr) {
+					visitor(character, distSq);
+				}
+			});
+		}
+
+		// Calls visitor(Item*, distanceSq) for each item within radius of the position
+		template <class Visitor>
+		void QueryItems(glm::vec3 const& pos, float radius, Visitor visitor)
+		{
+			SyncIfStale();
+			auto factory = GetStaticSymbols().GetItemFactory();
+			if (factory == nullptr) return;
+
+			items_.Query(pos.x, pos.y, pos.z, radius, [factory, &visitor](uint64_t handle, float distSq) {
+				auto item = factory->Get(ObjectHandle(handle));
+				if (item != nullptr) {
+					visitor(item, distSq);
+				}
+			});
+		}
+
+		inline uint32_t NumCharacters() const
+		{
+			return characters_.Size();
+		}
+
+		inline uint32_t NumItems() const
+		{
+			return items_.Size();
+		}
+
+	private:
+		SpatialGrid characters_;
+		SpatialGrid items_;
+		FixedString level_;
+		std::atomic<bool> stale_{ true };
+
+		inline void SyncIfStale()
+		{
+			if (stale_.load(std::memory_order_relaxed)) {
+				stale_.store(false, std::memory_order_relaxed);
+				Sync();
+			}
+		}
+
+		void Sync();
+	};
+
+	extern ObjectSpatialIndex gObjectSpatialIndex;
+}
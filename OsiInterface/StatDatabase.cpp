@@ -0,0 +1,185 @@
+// Compiled without the precompiled header, so the standalone reader can build it as well
+#include "StatDatabase.h"
+#include <algorithm>
+#include <cstring>
+
+namespace dse::statdb
+{
+	uint32_t Builder::AddString(std::string_view str)
+	{
+		auto it = stringIndices_.find(str);
+		if (it != stringIndices_.end()) {
+			return it->second;
+		}
+
+		auto index = (uint32_t)strings_.size();
+		strings_.emplace_back(str);
+		stringIndices_.insert(std::make_pair(std::string_view(strings_.back()), index));
+		return index;
+	}
+
+	uint32_t Builder::AddType(std::string_view name, uint32_t firstAttribute, uint32_t numAttributes)
+	{
+		Type type{};
+		type.Name = AddString(name);
+		type.FirstAttribute = firstAttribute;
+		type.NumAttributes = numAttributes;
+		types_.push_back(type);
+		return (uint32_t)types_.size() - 1;
+	}
+
+	uint32_t Builder::AddEntry(Entry const& entry, int32_t const* values)
+	{
+		auto const& type = types_[entry.Type];
+		PendingEntry pending{ entry, values_.size() };
+		values_.insert(values_.end(), values, values + type.NumAttributes);
+		entries_.push_back(pending);
+		return (uint32_t)entries_.size() - 1;
+	}
+
+	namespace
+	{
+		class SectionWriter
+		{
+		public:
+			SectionWriter(std::vector<uint8_t>& buf, uint32_t numSections)
+				: buf_(buf)
+			{
+				buf_.resize(sizeof(Header) + numSections * sizeof(SectionHeader));
+			}
+
+			template <class T>
+			void Write(SectionId id, T const* elements, std::size_t count)
+			{
+				// Align each section to 8 bytes so the reader can access it in-place
+				buf_.resize((buf_.size() + 7) & ~(std::size_t)7);
+
+				SectionHeader section{};
+				section.Id = id;
+				section.ElementSize = sizeof(T);
+				section.Offset = buf_.size();
+				section.Count = count;
+				std::memcpy(buf_.data() + sizeof(Header) + numWritten_ * sizeof(SectionHeader), &section, sizeof(section));
+				numWritten_++;
+
+				auto size = count * sizeof(T);
+				buf_.resize(buf_.size() + size);
+				if (size > 0) {
+					std::memcpy(buf_.data() + section.Offset, elements, size);
+				}
+			}
+
+			template <class T>
+			void Write(SectionId id, std::vector<T> const& elements)
+			{
+				Write(id, elements.data(), elements.size());
+			}
+
+		private:
+			std::vector<uint8_t>& buf_;
+			uint32_t numWritten_{ 0 };
+		};
+	}
+
+	std::vector<uint8_t> Builder::Serialize() const
+	{
+		std::vector<uint32_t> stringOffsets;
+		std::vector<char> stringData;
+		stringOffsets.reserve(strings_.size() + 1);
+		for (auto const& str : strings_) {
+			stringOffsets.push_back((uint32_t)stringData.size());
+			stringData.insert(stringData.end(), str.begin(), str.end());
+			stringData.push_back(0);
+		}
+		stringOffsets.push_back((uint32_t)stringData.size());
+
+		// Group entries by type, keeping the insertion order within each type
+		std::vector<uint32_t> order(entries_.size());
+		for (uint32_t i = 0; i < order.size(); i++) {
+			order[i] = i;
+		}
+
+		std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+			return entries_[a].Data.Type < entries_[b].Data.Type;
+		});
+
+		std::vector<uint32_t> newIndices(entries_.size());
+		for (uint32_t i = 0; i < order.size(); i++) {
+			newIndices[order[i]] = i;
+		}
+
+		std::vector<Entry> entries;
+		entries.reserve(entries_.size());
+		for (auto index : order) {
+			auto entry = entries_[index].Data;
+			if (entry.Using != None) {
+				entry.Using = newIndices[entry.Using];
+			}
+			entries.push_back(entry);
+		}
+
+		std::vector<Type> types(types_);
+		std::vector<int32_t> cells;
+		cells.reserve(values_.size());
+		uint32_t entryIndex = 0;
+		for (uint32_t typeIndex = 0; typeIndex < types.size(); typeIndex++) {
+			auto& type = types[typeIndex];
+			type.FirstEntry = entryIndex;
+			while (entryIndex < entries.size() && entries[entryIndex].Type == typeIndex) {
+				entryIndex++;
+			}
+
+			type.NumEntries = entryIndex - type.FirstEntry;
+			type.FirstCell = cells.size();
+			for (uint32_t attr = 0; attr < type.NumAttributes; attr++) {
+				for (uint32_t i = type.FirstEntry; i < entryIndex; i++) {
+					cells.push_back(values_[entries_[order[i]].FirstValue + attr]);
+				}
+			}
+		}
+
+		std::vector<uint32_t> nameIndex(entries.size());
+		for (uint32_t i = 0; i < nameIndex.size(); i++) {
+			nameIndex[i] = i;
+		}
+
+		std::sort(nameIndex.begin(), nameIndex.end(), [this, &entries](uint32_t a, uint32_t b) {
+			return std::string_view(strings_[entries[a].Name]) < std::string_view(strings_[entries[b].Name]);
+		});
+
+		std::vector<uint8_t> buf;
+		SectionWriter writer(buf, (uint32_t)SectionId::Count);
+		writer.Write(SectionId::StringOffsets, stringOffsets);
+		writer.Write(SectionId::StringData, stringData);
+		writer.Write(SectionId::Types, types);
+		writer.Write(SectionId::Attributes, Attributes);
+		writer.Write(SectionId::Enumerations, Enumerations);
+		writer.Write(SectionId::EnumLabels, EnumLabels);
+		writer.Write(SectionId::Entries, entries);
+		writer.Write(SectionId::Cells, cells);
+		writer.Write(SectionId::NameIndex, nameIndex);
+		writer.Write(SectionId::Flags, Flags);
+		writer.Write(SectionId::FlagNames, FlagNames);
+		writer.Write(SectionId::ComboCategories, ComboCategories);
+		writer.Write(SectionId::Requirements, Requirements);
+		writer.Write(SectionId::PropertyLists, PropertyLists);
+		writer.Write(SectionId::Properties, Properties);
+		writer.Write(SectionId::StringParams, StringParams);
+		writer.Write(SectionId::IntParams, IntParams);
+		writer.Write(SectionId::FloatParams, FloatParams);
+		writer.Write(SectionId::BoolParams, BoolParams);
+		writer.Write(SectionId::LevelMaps, LevelMaps);
+		writer.Write(SectionId::LevelMapSamples, LevelMapSamples);
+		writer.Write(SectionId::LevelMapValues, LevelMapValues);
+		writer.Write(SectionId::ExtraData, ExtraData);
+
+		Header header{};
+		header.Magic = FileMagic;
+		header.Version = FileVersion;
+		header.NumSections = (uint32_t)SectionId::Count;
+		header.MinLevel = MinLevel;
+		header.MaxLevel = MaxLevel;
+		std::memcpy(buf.data(), &header, sizeof(header));
+		return buf;
+	}
+}
@@ -0,0 +1,259 @@
+#pragma once
+
+// Layout of the exported stats database file (see StatDatabaseExport.cpp) and a
+// builder that serializes it.
+// This file must not depend on game definitions; it is also compiled by the
+// standalone reader library (Tools/StatDbReader).
+//
+// The file is a header, a section table and a list of 8-byte aligned sections.
+// All integers are little-endian. Strings are referenced by their index in the
+// string table; record links (entries, labels, parameters, ...) are indices into
+// the section that holds the linked records.
+//
+// Attribute values are stored in columns: the entries of a type are stored
+// consecutively in the Entries section and each attribute of the type has
+// one int32 cell per entry in the Cells section, starting at
+// Type.FirstCell + attributeIndex * Type.NumEntries.
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace dse::statdb
+{
+	constexpr uint32_t FileMagic = 0x42445345; // 'ESDB'
+	constexpr uint32_t FileVersion = 1;
+	// Missing string/record reference
+	constexpr uint32_t None = 0xffffffff;
+
+	enum class SectionId : uint32_t
+	{
+		// uint32_t[NumStrings + 1] offsets into StringData
+		StringOffsets,
+		// Null-terminated UTF-8 strings
+		StringData,
+		Types,
+		Attributes,
+		Enumerations,
+		// uint32_t string index for each enumeration value (None if the value has no label)
+		EnumLabels,
+		Entries,
+		// int32_t attribute values; see Attribute::Kind for their meaning
+		Cells,
+		// uint32_t entry indices sorted by entry name
+		NameIndex,
+		// uint64_t values of AttributeFlags attributes
+		Flags,
+		// uint32_t string index of each AttributeFlags bit
+		FlagNames,
+		// uint32_t string indices
+		ComboCategories,
+		Requirements,
+		PropertyLists,
+		Properties,
+		// uint32_t string indices
+		StringParams,
+		// int32_t values
+		IntParams,
+		// float values
+		FloatParams,
+		// uint8_t values
+		BoolParams,
+		LevelMaps,
+		LevelMapSamples,
+		// int64_t scaled values for each level between Header::MinLevel and Header::MaxLevel
+		LevelMapValues,
+		ExtraData,
+		Count
+	};
+
+	enum class AttributeKind : uint32_t
+	{
+		// Cell holds the unprocessed attribute value
+		Raw,
+		// Cell holds an integer
+		Int,
+		// Cell holds the enumeration value; its label is in Enumeration.FirstLabel + value
+		Enumeration,
+		// Cell holds a string index
+		String,
+		// Cell holds an index into the Flags section
+		Flags
+	};
+
+	struct Header
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t NumSections;
+		int32_t MinLevel;
+		int32_t MaxLevel;
+		uint32_t Reserved[3];
+	};
+
+	struct SectionHeader
+	{
+		SectionId Id;
+		uint32_t ElementSize;
+		uint64_t Offset;
+		uint64_t Count;
+	};
+
+	struct Type
+	{
+		uint32_t Name;
+		uint32_t FirstAttribute;
+		uint32_t NumAttributes;
+		uint32_t FirstEntry;
+		uint32_t NumEntries;
+		uint32_t Reserved;
+		uint64_t FirstCell;
+	};
+
+	struct Attribute
+	{
+		uint32_t Name;
+		AttributeKind Kind;
+		uint32_t Enumeration;
+		uint32_t LevelMap;
+	};
+
+	struct Enumeration
+	{
+		uint32_t Name;
+		uint32_t FirstLabel;
+		uint32_t NumLabels;
+		uint32_t Reserved;
+	};
+
+	struct Entry
+	{
+		uint32_t Name;
+		uint32_t Type;
+		// Index of the parent entry
+		uint32_t Using;
+		uint32_t ModId;
+		int32_t Level;
+		uint32_t AIFlags;
+		uint32_t FirstComboCategory;
+		uint32_t NumComboCategories;
+		uint32_t FirstRequirement;
+		uint32_t NumRequirements;
+		uint32_t FirstMemorizationRequirement;
+		uint32_t NumMemorizationRequirements;
+		uint32_t FirstPropertyList;
+		uint32_t NumPropertyLists;
+	};
+
+	struct Requirement
+	{
+		uint32_t Name;
+		int32_t IntParam;
+		uint32_t StringParam;
+		uint32_t Negate;
+	};
+
+	struct PropertyList
+	{
+		uint32_t Name;
+		uint32_t FirstProperty;
+		uint32_t NumProperties;
+		uint32_t Reserved;
+	};
+
+	struct Property
+	{
+		uint32_t Name;
+		uint32_t TypeName;
+		uint32_t Type;
+		uint32_t Context;
+		uint32_t Conditions;
+		uint32_t FirstStringParam;
+		uint32_t NumStringParams;
+		uint32_t FirstIntParam;
+		uint32_t NumIntParams;
+		uint32_t FirstFloatParam;
+		uint32_t NumFloatParams;
+		uint32_t FirstBoolParam;
+		uint32_t NumBoolParams;
+		uint32_t FirstSurfaceBoost;
+		uint32_t NumSurfaceBoosts;
+		uint32_t Reserved;
+	};
+
+	struct LevelMap
+	{
+		uint32_t Name;
+		uint32_t FirstSample;
+		uint32_t NumSamples;
+		uint32_t Reserved;
+	};
+
+	// Scaled values of a level map for one input (attribute) value.
+	// Samples of a level map are sorted by input value.
+	struct LevelMapSample
+	{
+		int32_t Input;
+		uint32_t Reserved;
+		uint64_t FirstValue;
+	};
+
+	struct ExtraDataValue
+	{
+		uint32_t Name;
+		float Value;
+	};
+
+	// Collects the contents of the database and serializes it to the file layout.
+	// Entries can be added in any order; they are grouped by type when serializing.
+	class Builder
+	{
+	public:
+		int32_t MinLevel{ 1 };
+		int32_t MaxLevel{ 1 };
+
+		std::vector<Attribute> Attributes;
+		std::vector<Enumeration> Enumerations;
+		std::vector<uint32_t> EnumLabels;
+		std::vector<uint64_t> Flags;
+		std::vector<uint32_t> FlagNames;
+		std::vector<uint32_t> ComboCategories;
+		std::vector<Requirement> Requirements;
+		std::vector<PropertyList> PropertyLists;
+		std::vector<Property> Properties;
+		std::vector<uint32_t> StringParams;
+		std::vector<int32_t> IntParams;
+		std::vector<float> FloatParams;
+		std::vector<uint8_t> BoolParams;
+		std::vector<LevelMap> LevelMaps;
+		std::vector<LevelMapSample> LevelMapSamples;
+		std::vector<int64_t> LevelMapValues;
+		std::vector<ExtraDataValue> ExtraData;
+
+		uint32_t AddString(std::string_view str);
+		// The attributes of the type must be added to Attributes beforehand
+		uint32_t AddType(std::string_view name, uint32_t firstAttribute, uint32_t numAttributes);
+		// Entry::Type must be set and Entry::Using must be the index returned by AddEntry for
+		// the parent entry (or None). Values contains one cell for each attribute of the type.
+		uint32_t AddEntry(Entry const& entry, int32_t const* values);
+
+		std::vector<uint8_t> Serialize() const;
+
+	private:
+		struct PendingEntry
+		{
+			Entry Data;
+			uint64_t FirstValue;
+		};
+
+		// Deque elements are never moved, so the index can reference them
+		std::deque<std::string> strings_;
+		std::unordered_map<std::string_view, uint32_t> stringIndices_;
+		std::vector<Type> types_;
+		std::vector<PendingEntry> entries_;
+		std::vector<int32_t> values_;
+	};
+}
@@ -0,0 +1,341 @@
+#include "stdafx.h"
+#include <StatDatabaseExport.h>
+#include <StatDatabase.h>
+#include <OsirisProxy.h>
+#include "ScriptExtensions.pb.h"
+#include <fstream>
+#include <set>
+
+namespace dse
+{
+	namespace
+	{
+		// Level maps are evaluated for every level in this range
+		constexpr int32_t ExportMinLevel = 1;
+		constexpr int32_t ExportMaxLevel = 50;
+
+		class StatDatabaseExporter
+		{
+		public:
+			StatDatabaseExporter(CRPGStatsManager* stats)
+				: stats_(stats)
+			{}
+
+			std::vector<uint8_t> Export()
+			{
+				builder_.MinLevel = ExportMinLevel;
+				builder_.MaxLevel = ExportMaxLevel;
+				levelMapInputs_.resize(stats_->LevelMaps.Primitives.Set.Size);
+
+				AddFlags();
+				AddTypes();
+				AddEntries();
+				AddLevelMaps();
+				AddExtraData();
+				return builder_.Serialize();
+			}
+
+		private:
+			CRPGStatsManager* stats_;
+			statdb::Builder builder_;
+			std::unordered_map<RPGEnumeration*, uint32_t> enumerations_;
+			// Attribute values that entries pass to each level map
+			std::vector<std::set<int32_t>> levelMapInputs_;
+
+			uint32_t AddString(FixedString const& str)
+			{
+				return str ? builder_.AddString(str.Str) : statdb::None;
+			}
+
+			uint32_t AddString(std::string const& str)
+			{
+				return str.empty() ? statdb::None : builder_.AddString(str);
+			}
+
+			void AddFlags()
+			{
+				for (auto const& flags : stats_->AttributeFlags) {
+					builder_.Flags.push_back((uint64_t)flags);
+				}
+
+				for (auto i = 0; i < 64; i++) {
+					auto label = EnumInfo<StatAttributeFlags>::Find((StatAttributeFlags)(1ull << i));
+					builder_.FlagNames.push_back(AddString(label));
+				}
+			}
+
+			uint32_t AddEnumeration(RPGEnumeration* enumeration)
+			{
+				auto it = enumerations_.find(enumeration);
+				if (it != enumerations_.end()) {
+					return it->second;
+				}
+
+				int32_t maxValue{ -1 };
+				enumeration->Values.Iterate([&maxValue](FixedString const& label, int32_t value) {
+					maxValue = std::max(maxValue, value);
+				});
+
+				statdb::Enumeration enumInfo{};
+				enumInfo.Name = AddString(enumeration->Name);
+				enumInfo.FirstLabel = (uint32_t)builder_.EnumLabels.size();
+				// Enumeration values are small consecutive numbers; anything else is not a label table
+				enumInfo.NumLabels = (maxValue >= 0 && maxValue <= 0xffff) ? (uint32_t)(maxValue + 1) : 0;
+				builder_.EnumLabels.resize(builder_.EnumLabels.size() + enumInfo.NumLabels, statdb::None);
+				enumeration->Values.Iterate([this, &enumInfo](FixedString const& label, int32_t value) {
+					if (value >= 0 && (uint32_t)value < enumInfo.NumLabels) {
+						auto& labelIndex = builder_.EnumLabels[enumInfo.FirstLabel + value];
+						if (labelIndex == statdb::None) {
+							labelIndex = AddString(label);
+						}
+					}
+				});
+
+				auto index = (uint32_t)builder_.Enumerations.size();
+				builder_.Enumerations.push_back(enumInfo);
+				enumerations_.insert(std::make_pair(enumeration, index));
+				return index;
+			}
+
+			void AddTypes()
+			{
+				auto numModifierLists = stats_->modifierList.Primitives.Set.Size;
+				for (uint32_t i = 0; i < numModifierLists; i++) {
+					auto modifierList = stats_->modifierList.Primitives[i];
+					auto firstAttribute = (uint32_t)builder_.Attributes.size();
+					auto numAttributes = modifierList->Attributes.Primitives.Set.Size;
+					for (uint32_t j = 0; j < numAttributes; j++) {
+						auto modifier = modifierList->Attributes.Primitives[j];
+						auto enumeration = stats_->modifierValueList.Find(modifier->RPGEnumerationIndex);
+
+						statdb::Attribute attribute{};
+						attribute.Name = AddString(modifier->Name);
+						attribute.Enumeration = statdb::None;
+						attribute.LevelMap = modifier->LevelMapIndex >= 0 ? (uint32_t)modifier->LevelMapIndex : statdb::None;
+
+						switch (GetStatAttributeType(enumeration)) {
+						case StatAttributeType::ConstantInt:
+							attribute.Kind = statdb::AttributeKind::Int;
+							break;
+
+						case StatAttributeType::FixedString:
+							attribute.Kind = statdb::AttributeKind::String;
+							break;
+
+						case StatAttributeType::AttributeFlags:
+							attribute.Kind = statdb::AttributeKind::Flags;
+							break;
+
+						case StatAttributeType::Other:
+							if (enumeration != nullptr && enumeration->Values.ItemCount > 0) {
+								attribute.Kind = statdb::AttributeKind::Enumeration;
+								attribute.Enumeration = AddEnumeration(enumeration);
+							} else {
+								attribute.Kind = statdb::AttributeKind::Raw;
+							}
+							break;
+
+						default:
+							attribute.Kind = statdb::AttributeKind::Raw;
+							break;
+						}
+
+						builder_.Attributes.push_back(attribute);
+					}
+
+					builder_.AddType(modifierList->Name.Str, firstAttribute, numAttributes);
+				}
+			}
+
+			void AddRequirements(ObjectSet<CRPGStats_Requirement, GameMemoryAllocator, true> const& requirements,
+				uint32_t& first, uint32_t& count)
+			{
+				first = (uint32_t)builder_.Requirements.size();
+				count = requirements.Set.Size;
+				for (uint32_t i = 0; i < requirements.Set.Size; i++) {
+					auto const& requirement = requirements[i];
+					statdb::Requirement req{};
+					req.Name = AddString(EnumInfo<RequirementType>::Find(requirement.RequirementId));
+					req.IntParam = requirement.IntParam;
+					req.StringParam = AddString(requirement.StringParam);
+					req.Negate = requirement.Negate ? 1 : 0;
+					builder_.Requirements.push_back(req);
+				}
+			}
+
+			void AddProperty(StatProperty const& msg)
+			{
+				statdb::Property prop{};
+				prop.Name = AddString(msg.name());
+				prop.Type = msg.type();
+				prop.TypeName = AddString(EnumInfo<CRPGStats_Object_Property_Type>::Find((CRPGStats_Object_Property_Type)msg.type()));
+				prop.Context = msg.property_context();
+				prop.Conditions = AddString(msg.conditions());
+
+				prop.FirstStringParam = (uint32_t)builder_.StringParams.size();
+				prop.NumStringParams = (uint32_t)msg.string_params_size();
+				for (auto const& param : msg.string_params()) {
+					builder_.StringParams.push_back(AddString(param));
+				}
+
+				prop.FirstIntParam = (uint32_t)builder_.IntParams.size();
+				prop.NumIntParams = (uint32_t)msg.int_params_size();
+				builder_.IntParams.insert(builder_.IntParams.end(), msg.int_params().begin(), msg.int_params().end());
+
+				prop.FirstFloatParam = (uint32_t)builder_.FloatParams.size();
+				prop.NumFloatParams = (uint32_t)msg.float_params_size();
+				builder_.FloatParams.insert(builder_.FloatParams.end(), msg.float_params().begin(), msg.float_params().end());
+
+				prop.FirstBoolParam = (uint32_t)builder_.BoolParams.size();
+				prop.NumBoolParams = (uint32_t)msg.bool_params_size();
+				for (auto param : msg.bool_params()) {
+					builder_.BoolParams.push_back(param ? 1 : 0);
+				}
+
+				prop.FirstSurfaceBoost = (uint32_t)builder_.IntParams.size();
+				prop.NumSurfaceBoosts = (uint32_t)msg.surface_boosts_size();
+				builder_.IntParams.insert(builder_.IntParams.end(), msg.surface_boosts().begin(), msg.surface_boosts().end());
+
+				builder_.Properties.push_back(prop);
+			}
+
+			void AddPropertyLists(CRPGStats_Object* object, statdb::Entry& entry)
+			{
+				entry.FirstPropertyList = (uint32_t)builder_.PropertyLists.size();
+				object->PropertyList.Iterate([this, &entry](FixedString const& key, CRPGStats_Object_Property_List* propertyList) {
+					StatPropertyList msg;
+					propertyList->ToProtobuf(key, &msg);
+
+					statdb::PropertyList list{};
+					list.Name = AddString(key);
+					list.FirstProperty = (uint32_t)builder_.Properties.size();
+					list.NumProperties = (uint32_t)msg.properties_size();
+					for (auto const& prop : msg.properties()) {
+						AddProperty(prop);
+					}
+
+					builder_.PropertyLists.push_back(list);
+					entry.NumPropertyLists++;
+				});
+			}
+
+			void AddEntries()
+			{
+				auto numObjects = stats_->objects.Primitives.Set.Size;
+				auto numModifierLists = (int32_t)stats_->modifierList.Primitives.Set.Size;
+				auto& loadOrder = gOsirisProxy->GetStatLoadOrderHelper();
+
+				// Builder indices of entries, to resolve "using" references to parents that are defined later
+				std::vector<uint32_t> entryIndices(numObjects, statdb::None);
+				uint32_t numEntries{ 0 };
+				for (uint32_t i = 0; i < numObjects; i++) {
+					auto object = stats_->objects.Primitives[i];
+					if (object->ModifierListIndex >= 0 && object->ModifierListIndex < numModifierLists) {
+						entryIndices[i] = numEntries++;
+					}
+				}
+
+				std::vector<int32_t> values;
+				for (uint32_t i = 0; i < numObjects; i++) {
+					if (entryIndices[i] == statdb::None) continue;
+
+					auto object = stats_->objects.Primitives[i];
+					statdb::Entry entry{};
+					entry.Name = AddString(object->Name);
+					entry.Type = (uint32_t)object->ModifierListIndex;
+					entry.Using = (object->Using >= 0 && (uint32_t)object->Using < numObjects) ? entryIndices[object->Using] : statdb::None;
+					entry.ModId = AddString(loadOrder.GetStatsEntryMod(object->Name));
+					entry.Level = object->Level;
+					entry.AIFlags = AddString(object->AIFlags);
+
+					entry.FirstComboCategory = (uint32_t)builder_.ComboCategories.size();
+					for (auto const& category : object->ComboCategories) {
+						builder_.ComboCategories.push_back(AddString(category));
+						entry.NumComboCategories++;
+					}
+
+					AddRequirements(object->Requirements, entry.FirstRequirement, entry.NumRequirements);
+					AddRequirements(object->MemorizationRequirements, entry.FirstMemorizationRequirement, entry.NumMemorizationRequirements);
+					AddPropertyLists(object, entry);
+
+					auto modifierList = stats_->modifierList.Primitives[entry.Type];
+					auto numAttributes = modifierList->Attributes.Primitives.Set.Size;
+					values.assign(numAttributes, 0);
+					for (uint32_t j = 0; j < numAttributes && j < object->IndexedProperties.size(); j++) {
+						auto value = object->IndexedProperties[j];
+						auto modifier = modifierList->Attributes.Primitives[j];
+						auto enumeration = stats_->modifierValueList.Find(modifier->RPGEnumerationIndex);
+						if (GetStatAttributeType(enumeration) == StatAttributeType::FixedString) {
+							value = (value >= 0 && (uint32_t)value < stats_->ModifierFSSet.Set.Size)
+								? (int32_t)AddString(stats_->ModifierFSSet[value])
+								: (int32_t)statdb::None;
+						}
+
+						if (modifier->LevelMapIndex >= 0 && (uint32_t)modifier->LevelMapIndex < levelMapInputs_.size()) {
+							levelMapInputs_[modifier->LevelMapIndex].insert(value);
+						}
+
+						values[j] = value;
+					}
+
+					builder_.AddEntry(entry, values.data());
+				}
+			}
+
+			void AddLevelMaps()
+			{
+				auto numLevelMaps = stats_->LevelMaps.Primitives.Set.Size;
+				for (uint32_t i = 0; i < numLevelMaps; i++) {
+					auto levelMap = stats_->LevelMaps.Primitives[i];
+
+					statdb::LevelMap map{};
+					map.Name = AddString(levelMap->Name);
+					map.FirstSample = (uint32_t)builder_.LevelMapSamples.size();
+					map.NumSamples = (uint32_t)levelMapInputs_[i].size();
+					// Inputs are sorted, so the reader can binary search them
+					for (auto input : levelMapInputs_[i]) {
+						statdb::LevelMapSample sample{};
+						sample.Input = input;
+						sample.FirstValue = builder_.LevelMapValues.size();
+						for (auto level = ExportMinLevel; level <= ExportMaxLevel; level++) {
+							builder_.LevelMapValues.push_back(levelMap->GetScaledValue(input, level));
+						}
+
+						builder_.LevelMapSamples.push_back(sample);
+					}
+
+					builder_.LevelMaps.push_back(map);
+				}
+			}
+
+			void AddExtraData()
+			{
+				if (stats_->ExtraData == nullptr) return;
+
+				stats_->ExtraData->Properties.Iterate([this](FixedString const& key, float value) {
+					builder_.ExtraData.push_back(statdb::ExtraDataValue{ AddString(key), value });
+				});
+			}
+		};
+	}
+
+	bool ExportStatDatabase(CRPGStatsManager* stats, std::string const& path)
+	{
+		StatDatabaseExporter exporter(stats);
+		auto buf = exporter.Export();
+
+		std::ofstream f(path.c_str(), std::ios::out | std::ios::binary);
+		if (!f.good()) {
+			OsiError("Could not open stats database file for writing: " << path);
+			return false;
+		}
+
+		f.write(reinterpret_cast<char const*>(buf.data()), buf.size());
+		if (!f.good()) {
+			OsiError("Failed to write stats database file: " << path);
+			return false;
+		}
+
+		return true;
+	}
+}
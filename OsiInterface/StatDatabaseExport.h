@@ -0,0 +1,11 @@
+#pragma once
+
+#include <GameDefinitions/Stats.h>
+
+namespace dse
+{
+	// Writes the loaded stats database (resolved attribute values, level maps,
+	// requirements and property lists) to a file that offline tools can memory-map
+	// with the reader library in Tools/StatDbReader. See StatDatabase.h for the layout.
+	bool ExportStatDatabase(CRPGStatsManager* stats, std::string const& path);
+}
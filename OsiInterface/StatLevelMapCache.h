@@ -0,0 +1,118 @@
+#pragma once
+
+// This file must not depend on game definitions; it is also compiled by the
+// standalone benchmark (Tools/StatLevelMapBenchmark).
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace dse
+{
+	// Lazily filled (level map, attribute value) -> level lookup table for level-scaled attributes.
+	// Tables are kept per thread and dropped when the generation changes, so reads don't lock.
+	// Level maps overridden from Lua (StatSetLevelScaling) bypass the table, as the override
+	// function may not be pure and is only callable when the client Lua state is available.
+	class StatLevelMapCache
+	{
+	public:
+		static constexpr int32_t MaxCachedLevel = 64;
+
+		// getLevelMap(levelMapIndex) must return the level map (LevelMaps.Find(levelMapIndex) != nullptr)
+		template <class TGetLevelMap>
+		int64_t GetScaledValue(int32_t levelMapIndex, int32_t value, int32_t level, TGetLevelMap getLevelMap)
+		{
+			auto& tables = GetThreadTables();
+			// Level maps are replaced before the generation is bumped, so the level map
+			// must be fetched after the generation check
+			auto generation = generation_.load(std::memory_order_acquire);
+			auto levelMap = getLevelMap(levelMapIndex);
+
+			if (level < 1 || level > MaxCachedLevel) {
+				return levelMap->GetScaledValue(value, level);
+			}
+
+			if (tables.Generation != generation) {
+				tables.LevelMaps.clear();
+				tables.Generation = generation;
+			}
+
+			if (levelMapIndex >= (int32_t)tables.LevelMaps.size()) {
+				tables.LevelMaps.resize(levelMapIndex + 1);
+			}
+
+			auto& table = tables.LevelMaps[levelMapIndex];
+			if (!table.Initialized) {
+				std::lock_guard lock(mutex_);
+				table.Overridden = levelMapIndex < (int32_t)overridden_.size() && overridden_[levelMapIndex];
+				table.Initialized = true;
+			}
+
+			if (table.Overridden) {
+				return levelMap->GetScaledValue(value, level);
+			}
+
+			auto& values = table.Values[value];
+			auto levelBit = 1ull << (level - 1);
+			if (!(values.Filled & levelBit)) {
+				values.Values[level - 1] = levelMap->GetScaledValue(value, level);
+				values.Filled |= levelBit;
+			}
+
+			return values.Values[level - 1];
+		}
+
+		// Drops the cached values of a level map after it was replaced or restored
+		void Invalidate(int32_t levelMapIndex, bool overridden)
+		{
+			if (levelMapIndex < 0) return;
+
+			std::lock_guard lock(mutex_);
+			if (levelMapIndex >= (int32_t)overridden_.size()) {
+				overridden_.resize(levelMapIndex + 1);
+			}
+
+			overridden_[levelMapIndex] = overridden;
+			generation_++;
+		}
+
+		void Clear()
+		{
+			std::lock_guard lock(mutex_);
+			overridden_.clear();
+			generation_++;
+		}
+
+	private:
+		struct LevelValues
+		{
+			uint64_t Filled{ 0 };
+			int64_t Values[MaxCachedLevel];
+		};
+
+		struct LevelMapTable
+		{
+			bool Initialized{ false };
+			bool Overridden{ false };
+			std::unordered_map<int32_t, LevelValues> Values;
+		};
+
+		struct ThreadTables
+		{
+			uint32_t Generation{ 0xffffffff };
+			std::vector<LevelMapTable> LevelMaps;
+		};
+
+		static ThreadTables& GetThreadTables()
+		{
+			static thread_local ThreadTables tables;
+			return tables;
+		}
+
+		std::mutex mutex_;
+		std::atomic<uint32_t> generation_{ 0 };
+		std::vector<bool> overridden_;
+	};
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+// Helpers of StatLoadOrderHelper (OsirisProxy.h).
+// This file must not depend on game definitions; it is also compiled by the
+// standalone benchmark (Tools/StatLoadOrderBenchmark).
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace dse
+{
+	// Hand-written equivalent of matching the path against ".*/Public/(.*)/Stats/Generated/.*.txt$";
+	// returns the mod directory name (the first capture group)
+	inline bool MatchStatsFilePath(std::string_view path, std::string_view& modDirectory)
+	{
+		constexpr std::string_view publicDir = "/Public/";
+		constexpr std::string_view generatedDir = "/Stats/Generated/";
+
+		// "/Stats/Generated/" must be followed by at least one character and "txt"
+		if (path.size() < generatedDir.size() + 4 || path.substr(path.size() - 3) != "txt") {
+			return false;
+		}
+
+		// Both .* groups are greedy, so the regex matches the last "/Stats/Generated/" that leaves
+		// room for the file name, and the last "/Public/" before it
+		auto generatedPos = path.rfind(generatedDir, path.size() - generatedDir.size() - 4);
+		if (generatedPos == std::string_view::npos || generatedPos < publicDir.size()) {
+			return false;
+		}
+
+		auto publicPos = path.rfind(publicDir, generatedPos - publicDir.size());
+		if (publicPos == std::string_view::npos) {
+			return false;
+		}
+
+		auto modStart = publicPos + publicDir.size();
+		modDirectory = path.substr(modStart, generatedPos - modStart);
+		return true;
+	}
+
+	// Attributes stats entries to mods by their pre-parse buffer index.
+	// Pre-parse buffers are only appended, so the buffer index of an entry tells
+	// which file opening came first after the entry (or its latest override) was parsed.
+	template <class TMod>
+	class PreParseBufferRanges
+	{
+	public:
+		inline void Clear()
+		{
+			ranges_.clear();
+		}
+
+		// Entries with a buffer index below numBuffers that aren't covered by a previous
+		// range are attributed to mod
+		void Add(uint32_t numBuffers, TMod const& mod)
+		{
+			if (ranges_.empty() || ranges_.rbegin()->End < numBuffers) {
+				ranges_.push_back(Range{ numBuffers, mod });
+			}
+		}
+
+		// Returns nullptr if the buffer is not covered by any range
+		TMod const* Find(uint32_t bufferIndex) const
+		{
+			auto range = std::upper_bound(ranges_.begin(), ranges_.end(), bufferIndex,
+				[](uint32_t index, Range const& range) { return index < range.End; });
+			return range != ranges_.end() ? &range->Mod : nullptr;
+		}
+
+	private:
+		struct Range
+		{
+			uint32_t End;
+			TMod Mod;
+		};
+
+		std::vector<Range> ranges_;
+	};
+}
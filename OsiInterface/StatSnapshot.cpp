@@ -0,0 +1,323 @@
+#include "stdafx.h"
+#include <StatSnapshot.h>
+#include <OsirisProxy.h>
+
+namespace dse
+{
+	StatSnapshotManager gStatSnapshots;
+
+	StatSnapshotEntry const* StatSnapshot::Find(std::string_view name) const
+	{
+		auto it = EntryIndices->find(name);
+		if (it != EntryIndices->end()) {
+			return Entries[it->second].get();
+		} else {
+			return nullptr;
+		}
+	}
+
+	StatSnapshotAttribute const* StatSnapshot::FindAttribute(StatSnapshotEntry const& entry, std::string_view name) const
+	{
+		if (entry.ModifierListIndex < 0 || entry.ModifierListIndex >= (int32_t)Tables->ModifierLists.size()) {
+			return nullptr;
+		}
+
+		auto const& attributes = Tables->ModifierLists[entry.ModifierListIndex].Attributes;
+		auto it = attributes.find(name);
+		if (it != attributes.end()) {
+			return &it->second;
+		} else {
+			return nullptr;
+		}
+	}
+
+	std::optional<STDString> StatSnapshot::GetString(StatSnapshotEntry const& entry, StatSnapshotAttribute const& attribute) const
+	{
+		if (attribute.Index < 0 || attribute.Index >= (int32_t)entry.IndexedProperties.size()) {
+			return {};
+		}
+
+		auto index = entry.IndexedProperties[attribute.Index];
+		if (attribute.Type == StatAttributeType::FixedString) {
+			if (index >= 0 && index < (int32_t)Strings->size()) {
+				return STDString((*Strings)[index].Str);
+			} else {
+				return {};
+			}
+		} else if (attribute.Type == StatAttributeType::AttributeFlags) {
+			STDString flagsStr;
+			if (index >= 0 && index < (int32_t)AttributeFlags->size()) {
+				auto attrFlags = (*AttributeFlags)[index];
+				for (auto i = 0; i < 64; i++) {
+					if (attrFlags & (1ull << i)) {
+						auto label = EnumInfo<StatAttributeFlags>::Find((StatAttributeFlags)(1ull << i));
+						if (label) {
+							if (!flagsStr.empty()) {
+								flagsStr += ';';
+							}
+
+							flagsStr += label.Str;
+						}
+					}
+				}
+			}
+
+			return flagsStr;
+		} else if (attribute.Labels) {
+			if (index >= 0 && index < (int32_t)attribute.Labels->size() && (*attribute.Labels)[index]) {
+				return STDString((*attribute.Labels)[index].Str);
+			} else {
+				return {};
+			}
+		} else {
+			return {};
+		}
+	}
+
+	std::optional<int32_t> StatSnapshot::GetInt(StatSnapshotEntry const& entry, StatSnapshotAttribute const& attribute) const
+	{
+		if (attribute.Index < 0 || attribute.Index >= (int32_t)entry.IndexedProperties.size()) {
+			return {};
+		}
+
+		if (attribute.Type == StatAttributeType::ConstantInt || attribute.Labels) {
+			return entry.IndexedProperties[attribute.Index];
+		} else {
+			return {};
+		}
+	}
+
+
+	namespace
+	{
+		std::shared_ptr<std::vector<FixedString> const> CopyEnumerationLabels(RPGEnumeration* enumeration)
+		{
+			int32_t maxValue{ -1 };
+			enumeration->Values.Iterate([&maxValue](FixedString const& label, int32_t value) {
+				maxValue = std::max(maxValue, value);
+			});
+
+			// Enumeration values are small consecutive numbers; anything else is not a label table
+			if (maxValue < 0 || maxValue > 0xffff) {
+				return {};
+			}
+
+			auto labels = std::make_shared<std::vector<FixedString>>(maxValue + 1);
+			enumeration->Values.Iterate([&labels](FixedString const& label, int32_t value) {
+				if (value >= 0 && !(*labels)[value]) {
+					(*labels)[value] = label;
+				}
+			});
+
+			return labels;
+		}
+
+		std::shared_ptr<StatSnapshotTables const> CopyTables(CRPGStatsManager* stats)
+		{
+			std::pair<FixedString, StatAttributeSpecial> specialAttributes[] = {
+				{ GFS.strLevel, StatAttributeSpecial::Level },
+				{ GFS.strName, StatAttributeSpecial::Name },
+				{ GFS.strModId, StatAttributeSpecial::ModId },
+				{ GFS.strUsing, StatAttributeSpecial::Using },
+				{ GFS.strRequirements, StatAttributeSpecial::Requirements },
+				{ GFS.strMemorizationRequirements, StatAttributeSpecial::MemorizationRequirements },
+				{ GFS.strAIFlags, StatAttributeSpecial::AIFlags },
+				{ GFS.strComboCategory, StatAttributeSpecial::ComboCategory },
+				{ GFS.strSkillProperties, StatAttributeSpecial::PropertyList },
+				{ GFS.strExtraProperties, StatAttributeSpecial::PropertyList }
+			};
+
+			auto tables = std::make_shared<StatSnapshotTables>();
+			std::unordered_map<RPGEnumeration*, std::shared_ptr<std::vector<FixedString> const>> labels;
+
+			auto numModifierLists = stats->modifierList.Primitives.Set.Size;
+			tables->ModifierLists.resize(numModifierLists);
+			for (uint32_t i = 0; i < numModifierLists; i++) {
+				auto modifierList = stats->modifierList.Primitives[i];
+				auto& snapshotList = tables->ModifierLists[i];
+				snapshotList.Name = modifierList->Name;
+				tables->ModifierListIndices.insert(std::make_pair(std::string_view(modifierList->Name.Str), (int32_t)i));
+
+				auto numAttributes = modifierList->Attributes.Primitives.Set.Size;
+				for (uint32_t j = 0; j < numAttributes; j++) {
+					auto modifier = modifierList->Attributes.Primitives[j];
+					auto enumeration = stats->modifierValueList.Find(modifier->RPGEnumerationIndex);
+
+					StatSnapshotAttribute attribute;
+					attribute.Name = modifier->Name;
+					attribute.Index = (int32_t)j;
+					attribute.Type = GetStatAttributeType(enumeration);
+					if (enumeration != nullptr && attribute.Type == StatAttributeType::Other
+						&& enumeration->Values.ItemCount > 0) {
+						auto labelIt = labels.find(enumeration);
+						if (labelIt == labels.end()) {
+							labelIt = labels.insert(std::make_pair(enumeration, CopyEnumerationLabels(enumeration))).first;
+						}
+
+						attribute.Labels = labelIt->second;
+					}
+
+					snapshotList.Attributes.insert(std::make_pair(std::string_view(modifier->Name.Str), attribute));
+				}
+
+				for (auto const& special : specialAttributes) {
+					auto& attribute = snapshotList.Attributes[special.first.Str];
+					attribute.Name = special.first;
+					attribute.Special = special.second;
+				}
+			}
+
+			if (stats->ExtraData != nullptr) {
+				stats->ExtraData->Properties.Iterate([&tables](FixedString const& key, float value) {
+					tables->ExtraData.insert(std::make_pair(std::string_view(key.Str), value));
+				});
+			}
+
+			return tables;
+		}
+
+		std::shared_ptr<StatSnapshotEntry const> CopyEntry(CRPGStatsManager* stats, CRPGStats_Object* object)
+		{
+			auto entry = std::make_shared<StatSnapshotEntry>();
+			entry->Name = object->Name;
+			entry->ModId = gOsirisProxy->GetStatLoadOrderHelper().GetStatsEntryMod(object->Name);
+			entry->AIFlags = object->AIFlags;
+			entry->Level = object->Level;
+			entry->ModifierListIndex = object->ModifierListIndex;
+			entry->IndexedProperties.assign(object->IndexedProperties.begin(), object->IndexedProperties.end());
+
+			if (object->Using) {
+				auto parent = stats->objects.Find(object->Using);
+				if (parent != nullptr) {
+					entry->Using = parent->Name;
+				}
+			}
+
+			for (auto const& category : object->ComboCategories) {
+				entry->ComboCategories.push_back(category);
+			}
+
+			entry->Requirements.resize(object->Requirements.Set.Size);
+			for (uint32_t i = 0; i < object->Requirements.Set.Size; i++) {
+				object->Requirements[i].ToProtobuf(&entry->Requirements[i]);
+			}
+
+			entry->MemorizationRequirements.resize(object->MemorizationRequirements.Set.Size);
+			for (uint32_t i = 0; i < object->MemorizationRequirements.Set.Size; i++) {
+				object->MemorizationRequirements[i].ToProtobuf(&entry->MemorizationRequirements[i]);
+			}
+
+			object->PropertyList.Iterate([&entry](FixedString const& key, CRPGStats_Object_Property_List* propertyList) {
+				entry->PropertyLists.emplace_back();
+				propertyList->ToProtobuf(key, &entry->PropertyLists.back());
+			});
+
+			return entry;
+		}
+
+		std::shared_ptr<std::vector<FixedString> const> CopyStrings(CRPGStatsManager* stats)
+		{
+			auto strings = std::make_shared<std::vector<FixedString>>();
+			strings->reserve(stats->ModifierFSSet.Set.Size);
+			for (auto const& str : stats->ModifierFSSet) {
+				strings->push_back(str);
+			}
+
+			return strings;
+		}
+
+		std::shared_ptr<std::vector<uint64_t> const> CopyAttributeFlags(CRPGStatsManager* stats)
+		{
+			auto flags = std::make_shared<std::vector<uint64_t>>();
+			flags->reserve(stats->AttributeFlags.Set.Size);
+			for (auto const& attrFlags : stats->AttributeFlags) {
+				flags->push_back((uint64_t)attrFlags);
+			}
+
+			return flags;
+		}
+	}
+
+	void StatSnapshotManager::Publish(CRPGStatsManager* stats)
+	{
+		std::lock_guard lock(mutex_);
+		auto snapshot = std::make_shared<StatSnapshot>();
+		snapshot->Version = nextVersion_++;
+		snapshot->Tables = CopyTables(stats);
+		snapshot->Strings = CopyStrings(stats);
+		snapshot->AttributeFlags = CopyAttributeFlags(stats);
+
+		auto indices = std::make_shared<std::unordered_map<std::string_view, uint32_t>>();
+		auto numObjects = stats->objects.Primitives.Set.Size;
+		snapshot->Entries.reserve(numObjects);
+		indices->reserve(numObjects);
+		for (uint32_t i = 0; i < numObjects; i++) {
+			auto object = stats->objects.Primitives[i];
+			indices->insert(std::make_pair(std::string_view(object->Name.Str), (uint32_t)snapshot->Entries.size()));
+			snapshot->Entries.push_back(CopyEntry(stats, object));
+		}
+
+		snapshot->EntryIndices = indices;
+		Store(snapshot);
+	}
+
+	void StatSnapshotManager::Update(CRPGStatsManager* stats, std::vector<FixedString> const& modifiedEntries)
+	{
+		std::lock_guard lock(mutex_);
+		auto current = Acquire();
+		if (!current) {
+			// Nothing was published for the current stats yet; readers will get the
+			// modified entries when the first full snapshot is taken
+			return;
+		}
+
+		auto snapshot = std::make_shared<StatSnapshot>(*current);
+		snapshot->Version = nextVersion_++;
+
+		// Setting a new FixedString value appends to the string set; existing values never change
+		if (stats->ModifierFSSet.Set.Size != snapshot->Strings->size()) {
+			snapshot->Strings = CopyStrings(stats);
+		}
+
+		if (stats->AttributeFlags.Set.Size != snapshot->AttributeFlags->size()) {
+			snapshot->AttributeFlags = CopyAttributeFlags(stats);
+		}
+
+		std::shared_ptr<std::unordered_map<std::string_view, uint32_t>> newIndices;
+		for (auto const& name : modifiedEntries) {
+			auto object = stats->objects.Find(name);
+			if (object == nullptr) continue;
+
+			auto it = snapshot->EntryIndices->find(name.Str);
+			if (it != snapshot->EntryIndices->end()) {
+				snapshot->Entries[it->second] = CopyEntry(stats, object);
+			} else {
+				if (!newIndices) {
+					newIndices = std::make_shared<std::unordered_map<std::string_view, uint32_t>>(*snapshot->EntryIndices);
+					snapshot->EntryIndices = newIndices;
+				}
+
+				newIndices->insert(std::make_pair(std::string_view(name.Str), (uint32_t)snapshot->Entries.size()));
+				snapshot->Entries.push_back(CopyEntry(stats, object));
+			}
+		}
+
+		Store(snapshot);
+	}
+
+	void StatSnapshotManager::Clear()
+	{
+		std::lock_guard lock(mutex_);
+		Store(nullptr);
+	}
+
+	std::shared_ptr<StatSnapshot const> StatSnapshotManager::Acquire() const
+	{
+		return std::atomic_load(&current_);
+	}
+
+	void StatSnapshotManager::Store(std::shared_ptr<StatSnapshot const> snapshot)
+	{
+		std::atomic_store(&current_, std::move(snapshot));
+	}
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <GameDefinitions/Stats.h>
+#include "ScriptExtensions.pb.h"
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace dse
+{
+	// Copy of a single stats entry at the time the snapshot was taken.
+	// Contains no pointers to game memory, so it can be read from any thread.
+	struct StatSnapshotEntry
+	{
+		FixedString Name;
+		FixedString Using;
+		FixedString ModId;
+		FixedString AIFlags;
+		int32_t Level{ -1 };
+		int32_t ModifierListIndex{ -1 };
+		std::vector<int32_t> IndexedProperties;
+		std::vector<FixedString> ComboCategories;
+		std::vector<StatRequirement> Requirements;
+		std::vector<StatRequirement> MemorizationRequirements;
+		std::vector<StatPropertyList> PropertyLists;
+	};
+
+	struct StatSnapshotAttribute
+	{
+		FixedString Name;
+		int32_t Index{ -1 };
+		StatAttributeType Type{ StatAttributeType::None };
+		StatAttributeSpecial Special{ StatAttributeSpecial::None };
+		// Enumeration labels indexed by value; empty if the attribute is not an enumeration
+		std::shared_ptr<std::vector<FixedString> const> Labels;
+	};
+
+	struct StatSnapshotModifierList
+	{
+		FixedString Name;
+		std::unordered_map<std::string_view, StatSnapshotAttribute> Attributes;
+	};
+
+	// Stats data that only changes when the stats are reloaded
+	struct StatSnapshotTables
+	{
+		std::vector<StatSnapshotModifierList> ModifierLists;
+		std::unordered_map<std::string_view, int32_t> ModifierListIndices;
+		std::unordered_map<std::string_view, float> ExtraData;
+	};
+
+	// Immutable, versioned copy of the stats database.
+	// Unchanged parts are shared between consecutive versions (copy-on-write).
+	class StatSnapshot
+	{
+	public:
+		uint64_t Version{ 0 };
+		std::shared_ptr<StatSnapshotTables const> Tables;
+		// Copy of CRPGStatsManager::ModifierFSSet (values of FixedString attributes)
+		std::shared_ptr<std::vector<FixedString> const> Strings;
+		// Copy of CRPGStatsManager::AttributeFlags
+		std::shared_ptr<std::vector<uint64_t> const> AttributeFlags;
+		std::vector<std::shared_ptr<StatSnapshotEntry const>> Entries;
+		std::shared_ptr<std::unordered_map<std::string_view, uint32_t> const> EntryIndices;
+
+		StatSnapshotEntry const* Find(std::string_view name) const;
+		StatSnapshotAttribute const* FindAttribute(StatSnapshotEntry const& entry, std::string_view name) const;
+
+		// Returns the string value of an enumeration, FixedString or AttributeFlags attribute
+		std::optional<STDString> GetString(StatSnapshotEntry const& entry, StatSnapshotAttribute const& attribute) const;
+		// Returns the integer value of a ConstantInt or enumeration attribute
+		std::optional<int32_t> GetInt(StatSnapshotEntry const& entry, StatSnapshotAttribute const& attribute) const;
+	};
+
+	// Publishes stats snapshots to readers on other threads.
+	// Readers hold a reference to the snapshot they acquired, so an old version
+	// stays alive until the last reader releases it.
+	class StatSnapshotManager
+	{
+	public:
+		// Takes a full snapshot of the stats database
+		void Publish(CRPGStatsManager* stats);
+		// Publishes a new version where only the specified entries are copied again
+		void Update(CRPGStatsManager* stats, std::vector<FixedString> const& modifiedEntries);
+		void Clear();
+
+		// Returns nullptr if no snapshot was published since the stats were loaded
+		std::shared_ptr<StatSnapshot const> Acquire() const;
+
+	private:
+		// Serializes writers; readers only use the atomic pointer operations
+		std::mutex mutex_;
+		std::shared_ptr<StatSnapshot const> current_;
+		uint64_t nextVersion_{ 1 };
+
+		void Store(std::shared_ptr<StatSnapshot const> snapshot);
+	};
+
+	extern StatSnapshotManager gStatSnapshots;
+}
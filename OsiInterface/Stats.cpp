@@ -393,6 +393,37 @@ namespace dse
 		}
 	}
 
+	void IndexedPropertyToProtobuf(CRPGStatsManager* stats, ModifierList* modifierList, 
+		CRPGStats_Object const* object, uint32_t index, StatIndexedProperty* prop)
+	{
+		auto value = object->IndexedProperties[index];
+		auto modifier = modifierList->Attributes.Find(index);
+		auto enumeration = stats->modifierValueList.Find(modifier->RPGEnumerationIndex);
+		if (enumeration->IsIndexedProperty()) {
+			if (enumeration->IsStringIndexedProperty()) {
+				prop->set_stringval(stats->ModifierFSSet[value].Str);
+			} else {
+				prop->set_intval(value);
+			}
+		}
+	}
+
+	void IndexedPropertyFromProtobuf(CRPGStatsManager* stats, ModifierList* modifierList,
+		CRPGStats_Object* object, uint32_t index, StatIndexedProperty const& prop)
+	{
+		auto modifier = modifierList->Attributes.Find(index);
+		auto enumeration = stats->modifierValueList.Find(modifier->RPGEnumerationIndex);
+		if (enumeration->IsIndexedProperty()) {
+			if (enumeration->IsStringIndexedProperty()) {
+				object->IndexedProperties[index] = stats->GetOrCreateFixedString(prop.stringval().c_str());
+			} else {
+				object->IndexedProperties[index] = prop.intval();
+			}
+		} else {
+			object->IndexedProperties[index] = 0;
+		}
+	}
+
 	void CRPGStats_Object::ToProtobuf(MsgS2CSyncStat* msg) const
 	{
 		msg->set_name(Name.Str);
@@ -402,42 +433,88 @@ namespace dse
 		auto stats = GetStaticSymbols().GetStats();
 		auto modifierList = stats->modifierList.Find(ModifierListIndex);
 
-		for (size_t i = 0; i < IndexedProperties.size(); i++) {
-			auto value = IndexedProperties[i];
-			auto indexedProp = msg->add_indexed_properties();
-			auto modifier = modifierList->Attributes.Find((uint32_t)i);
-			auto enumeration = stats->modifierValueList.Find(modifier->RPGEnumerationIndex);
-			if (enumeration->IsIndexedProperty()) {
-				if (enumeration->IsStringIndexedProperty()) {
-					indexedProp->set_stringval(stats->ModifierFSSet[value].Str);
-				} else {
-					indexedProp->set_intval(value);
-				}
-			}
+		for (uint32_t i = 0; i < IndexedProperties.size(); i++) {
+			IndexedPropertyToProtobuf(stats, modifierList, this, i, msg->add_indexed_properties());
+		}
+
+		FieldsToProtobuf(msg, (uint32_t)StatSyncField::All);
+	}
+
+	void CRPGStats_Object::ToProtobuf(MsgS2CSyncStat* msg, std::vector<uint32_t> const& indexedProperties, uint32_t fields) const
+	{
+		msg->set_name(Name.Str);
+		msg->set_modifier_list(ModifierListIndex);
+		msg->set_partial(true);
+		msg->set_updated_fields(fields);
+
+		auto stats = GetStaticSymbols().GetStats();
+		auto modifierList = stats->modifierList.Find(ModifierListIndex);
+
+		for (auto index : indexedProperties) {
+			msg->add_indexed_property_indices(index);
+			IndexedPropertyToProtobuf(stats, modifierList, this, index, msg->add_indexed_properties());
 		}
 
-		msg->set_ai_flags(AIFlags.Str);
+		FieldsToProtobuf(msg, fields);
+	}
+
+	void CRPGStats_Object::FieldsToProtobuf(MsgS2CSyncStat* msg, uint32_t fields) const
+	{
+		if (fields & (uint32_t)StatSyncField::AIFlags) {
+			msg->set_ai_flags(AIFlags.Str);
+		}
 
-		for (auto const& reqmt : Requirements) {
-			reqmt.ToProtobuf(msg->add_requirements());
+		if (fields & (uint32_t)StatSyncField::Requirements) {
+			for (auto const& reqmt : Requirements) {
+				reqmt.ToProtobuf(msg->add_requirements());
+			}
 		}
 
-		for (auto const& reqmt : MemorizationRequirements) {
-			reqmt.ToProtobuf(msg->add_memorization_requirements());
+		if (fields & (uint32_t)StatSyncField::MemorizationRequirements) {
+			for (auto const& reqmt : MemorizationRequirements) {
+				reqmt.ToProtobuf(msg->add_memorization_requirements());
+			}
 		}
 
-		for (auto const& category : ComboCategories) {
-			msg->add_combo_categories(category.Str);
+		if (fields & (uint32_t)StatSyncField::ComboCategories) {
+			for (auto const& category : ComboCategories) {
+				msg->add_combo_categories(category.Str);
+			}
 		}
 
-		PropertyList.Iterate([msg](auto const& key, auto const& propertyList) {
-			propertyList->ToProtobuf(key, msg->add_property_lists());
-		});
+		if (fields & (uint32_t)StatSyncField::PropertyLists) {
+			PropertyList.Iterate([msg](auto const& key, auto const& propertyList) {
+				propertyList->ToProtobuf(key, msg->add_property_lists());
+			});
+		}
 	}
 
 	void CRPGStats_Object::FromProtobuf(MsgS2CSyncStat const& msg)
 	{
 		auto stats = GetStaticSymbols().GetStats();
+		auto modifierList = stats->modifierList.Find(ModifierListIndex);
+
+		if (msg.partial()) {
+			if (msg.indexed_property_indices_size() != msg.indexed_properties_size()) {
+				OsiError("Malformed partial sync message for '" << Name << "'");
+				return;
+			}
+
+			for (int i = 0; i < msg.indexed_properties_size(); i++) {
+				auto index = msg.indexed_property_indices(i);
+				if (index >= IndexedProperties.size()) {
+					OsiError("IndexedProperties index out of bounds for '" << Name << "'! Got "
+						<< index << ", size is " << IndexedProperties.size());
+					return;
+				}
+
+				IndexedPropertyFromProtobuf(stats, modifierList, this, index, msg.indexed_properties(i));
+			}
+
+			FieldsFromProtobuf(msg, msg.updated_fields());
+			return;
+		}
+
 		Level = msg.level();
 
 		if (msg.indexed_properties_size() != IndexedProperties.size()) {
@@ -446,62 +523,55 @@ namespace dse
 			return;
 		}
 
-		auto modifierList = stats->modifierList.Find(ModifierListIndex);
-		for (size_t i = 0; i < IndexedProperties.size(); i++) {
-			auto modifier = modifierList->Attributes.Find((uint32_t)i);
-			auto enumeration = stats->modifierValueList.Find(modifier->RPGEnumerationIndex);
-			if (enumeration->IsIndexedProperty()) {
-				auto const& prop = msg.indexed_properties().Get((uint32_t)i);
-				if (enumeration->IsStringIndexedProperty()) {
-					IndexedProperties[i] = stats->GetOrCreateFixedString(prop.stringval().c_str());
-				} else {
-					IndexedProperties[i] = prop.intval();
-				}
-			} else {
-				IndexedProperties[i] = 0;
-			}
+		for (uint32_t i = 0; i < IndexedProperties.size(); i++) {
+			IndexedPropertyFromProtobuf(stats, modifierList, this, i, msg.indexed_properties().Get(i));
 		}
 
-		AIFlags = MakeFixedString(msg.ai_flags().c_str());
+		FieldsFromProtobuf(msg, (uint32_t)StatSyncField::All);
+	}
 
-		Requirements.Set.Clear();
-		for (auto const& reqmt : msg.requirements()) {
-			CRPGStats_Requirement requirement;
-			requirement.FromProtobuf(reqmt);
-			Requirements.Set.Add(requirement);
-		}
+	void CRPGStats_Object::FieldsFromProtobuf(MsgS2CSyncStat const& msg, uint32_t fields)
+	{
+		auto stats = GetStaticSymbols().GetStats();
 
-		for (auto const& reqmt : msg.memorization_requirements()) {
-			CRPGStats_Requirement requirement;
-			requirement.FromProtobuf(reqmt);
-			Requirements.Set.Add(requirement);
+		if (fields & (uint32_t)StatSyncField::AIFlags) {
+			AIFlags = MakeFixedString(msg.ai_flags().c_str());
 		}
 
-		ComboCategories.Set.Clear();
-		for (auto const& category : msg.combo_categories()) {
-			ComboCategories.Set.Add(MakeFixedString(category.c_str()));
+		if (fields & (uint32_t)StatSyncField::Requirements) {
+			Requirements.Set.Clear();
+			for (auto const& reqmt : msg.requirements()) {
+				CRPGStats_Requirement requirement;
+				requirement.FromProtobuf(reqmt);
+				Requirements.Set.Add(requirement);
+			}
 		}
 
-		PropertyList.Clear();
-		for (auto const& props : msg.property_lists()) {
-			auto name = MakeFixedString(props.name().c_str());
-			auto propertyList = stats->ConstructPropertyList(name);
-			propertyList->FromProtobuf(props);
-			PropertyList.Insert(name, propertyList);
+		if (fields & (uint32_t)StatSyncField::MemorizationRequirements) {
+			MemorizationRequirements.Set.Clear();
+			for (auto const& reqmt : msg.memorization_requirements()) {
+				CRPGStats_Requirement requirement;
+				requirement.FromProtobuf(reqmt);
+				MemorizationRequirements.Set.Add(requirement);
+			}
 		}
-	}
 
-	void CRPGStats_Object::BroadcastSyncMessage() const
-	{
-		auto msg = gOsirisProxy->GetNetworkManager().GetFreeServerMessage(UserId::Unassigned);
-		if (!msg) {
-			OsiErrorS("Failed to get free message");
-			return;
+		if (fields & (uint32_t)StatSyncField::ComboCategories) {
+			ComboCategories.Set.Clear();
+			for (auto const& category : msg.combo_categories()) {
+				ComboCategories.Set.Add(MakeFixedString(category.c_str()));
+			}
 		}
 
-		auto& wrap = msg->GetMessage();
-		ToProtobuf(wrap.mutable_s2c_sync_stat());
-		gOsirisProxy->GetNetworkManager().ServerBroadcast(msg, UserId::Unassigned);
+		if (fields & (uint32_t)StatSyncField::PropertyLists) {
+			PropertyList.Clear();
+			for (auto const& props : msg.property_lists()) {
+				auto name = MakeFixedString(props.name().c_str());
+				auto propertyList = stats->ConstructPropertyList(name);
+				propertyList->FromProtobuf(props);
+				PropertyList.Insert(name, propertyList);
+			}
+		}
 	}
 
 	bool RPGEnumeration::IsIndexedProperty() const
@@ -531,6 +601,141 @@ namespace dse
 	}
 
 	CRPGStatsVMTMappings gCRPGStatsVMTMappings;
+	StatAttributeCache gStatAttributeCache;
+
+	StatEntryIndex gStatEntryIndex;
+
+	StatLevelMapCache gStatLevelMapCache;
+
+	StatAttributeType GetStatAttributeType(RPGEnumeration* enumeration)
+	{
+		if (enumeration == nullptr) {
+			return StatAttributeType::Other;
+		} else if (enumeration->Name == GFS.strFixedString) {
+			return StatAttributeType::FixedString;
+		} else if (enumeration->Name == GFS.strAttributeFlags) {
+			return StatAttributeType::AttributeFlags;
+		} else if (enumeration->Name == GFS.strConstantInt) {
+			return StatAttributeType::ConstantInt;
+		} else if (enumeration->Name == GFS.strConditions) {
+			return StatAttributeType::Conditions;
+		} else {
+			return StatAttributeType::Other;
+		}
+	}
+
+	void StatAttributeCache::Build(CRPGStatsManager* stats)
+	{
+		std::lock_guard lock(mutex_);
+		BuildModifierLists(stats);
+	}
+
+	void StatAttributeCache::BuildModifierLists(CRPGStatsManager* stats)
+	{
+		std::pair<FixedString, StatAttributeSpecial> specialAttributes[] = {
+			{ GFS.strLevel, StatAttributeSpecial::Level },
+			{ GFS.strName, StatAttributeSpecial::Name },
+			{ GFS.strModId, StatAttributeSpecial::ModId },
+			{ GFS.strUsing, StatAttributeSpecial::Using },
+			{ GFS.strRequirements, StatAttributeSpecial::Requirements },
+			{ GFS.strMemorizationRequirements, StatAttributeSpecial::MemorizationRequirements },
+			{ GFS.strAIFlags, StatAttributeSpecial::AIFlags },
+			{ GFS.strComboCategory, StatAttributeSpecial::ComboCategory },
+			{ GFS.strSkillProperties, StatAttributeSpecial::PropertyList },
+			{ GFS.strExtraProperties, StatAttributeSpecial::PropertyList }
+		};
+
+		auto numModifierLists = stats->modifierList.Primitives.Set.Size;
+		modifierLists_.clear();
+		modifierLists_.resize(numModifierLists);
+
+		for (uint32_t i = 0; i < numModifierLists; i++) {
+			auto modifierList = stats->modifierList.Primitives[i];
+			auto& attributes = modifierLists_[i];
+			auto numAttributes = modifierList->Attributes.Primitives.Set.Size;
+			attributes.reserve(numAttributes + std::size(specialAttributes));
+
+			for (uint32_t j = 0; j < numAttributes; j++) {
+				auto modifier = modifierList->Attributes.Primitives[j];
+				StatAttributeInfo attribute;
+				attribute.Name = modifier->Name;
+				attribute.Index = (int32_t)j;
+				attribute.LevelMapIndex = modifier->LevelMapIndex;
+				attribute.Enumeration = stats->modifierValueList.Find(modifier->RPGEnumerationIndex);
+				attribute.Type = GetStatAttributeType(attribute.Enumeration);
+				attributes.insert(std::make_pair(modifier->Name, attribute));
+			}
+
+			for (auto const& special : specialAttributes) {
+				auto& attribute = attributes[special.first];
+				attribute.Name = special.first;
+				attribute.Special = special.second;
+			}
+		}
+
+		built_ = true;
+	}
+
+	void StatAttributeCache::Clear()
+	{
+		std::lock_guard lock(mutex_);
+		built_ = false;
+		modifierLists_.clear();
+	}
+
+	void StatEntryIndex::Build(CRPGStatsManager* stats)
+	{
+		std::unique_lock lock(mutex_);
+		entries_.clear();
+		entries_.resize(stats->modifierList.Primitives.Set.Size);
+
+		for (auto object : stats->objects.Primitives) {
+			if (object->ModifierListIndex >= 0 && object->ModifierListIndex < (int32_t)entries_.size()) {
+				entries_[object->ModifierListIndex].push_back(object->Name);
+			}
+		}
+
+		built_ = true;
+	}
+
+	void StatEntryIndex::Clear()
+	{
+		std::unique_lock lock(mutex_);
+		built_ = false;
+		entries_.clear();
+	}
+
+	void StatEntryIndex::OnObjectCreated(CRPGStats_Object* object)
+	{
+		if (!built_) return;
+
+		std::unique_lock lock(mutex_);
+		if (object->ModifierListIndex >= 0 && object->ModifierListIndex < (int32_t)entries_.size()) {
+			entries_[object->ModifierListIndex].push_back(object->Name);
+		}
+	}
+
+	StatAttributeInfo const* StatAttributeCache::Find(CRPGStatsManager* stats, int32_t modifierListIndex, FixedString const& name)
+	{
+		if (!built_) {
+			std::lock_guard lock(mutex_);
+			if (!built_) {
+				BuildModifierLists(stats);
+			}
+		}
+
+		if (modifierListIndex < 0 || modifierListIndex >= (int32_t)modifierLists_.size()) {
+			return nullptr;
+		}
+
+		auto const& attributes = modifierLists_[modifierListIndex];
+		auto it = attributes.find(name);
+		if (it != attributes.end()) {
+			return &it->second;
+		} else {
+			return nullptr;
+		}
+	}
 
 	CRPGStatsVMTMappings::CRPGStatsVMTMappings()
 	{
@@ -619,6 +824,7 @@ namespace dse
 
 		object->Handle = objects.Primitives.Set.Size;
 		objects.Add(name, object);
+		gStatEntryIndex.OnObjectCreated(object);
 
 		return object;
 	}
@@ -629,6 +835,8 @@ namespace dse
 		if (object) {
 			object->FromProtobuf(msg);
 			SyncWithPrototypeManager(object);
+		} else if (msg.partial()) {
+			OsiError("Received partial sync for nonexistent stats object: " << msg.name());
 		} else {
 			auto newObject = CreateObject(MakeFixedString(msg.name().c_str()), msg.modifier_list());
 			if (!newObject) {
@@ -785,32 +993,36 @@ namespace dse
 
 	RPGEnumeration * CRPGStatsManager::GetAttributeInfo(CRPGStats_Object * object, FixedString const& attributeName, int & attributeIndex)
 	{
-		auto objModifiers = modifierList.Find(object->ModifierListIndex);
-		if (objModifiers == nullptr) {
+		auto attribute = gStatAttributeCache.Find(this, object->ModifierListIndex, attributeName);
+		if (attribute == nullptr || attribute->Index == -1) {
 			return nullptr;
 		}
 
-		auto modifierInfo = objModifiers->GetAttributeInfo(attributeName, &attributeIndex);
-		if (modifierInfo == nullptr) {
-			return nullptr;
+		attributeIndex = attribute->Index;
+		return attribute->Enumeration;
+	}
+
+	std::optional<char const *> CRPGStatsManager::GetAttributeString(CRPGStats_Object * object, FixedString const& attributeName)
+	{
+		auto attribute = gStatAttributeCache.Find(this, object->ModifierListIndex, attributeName);
+		if (attribute == nullptr) {
+			return {};
 		}
 
-		auto typeInfo = modifierValueList.Find(modifierInfo->RPGEnumerationIndex);
-		return typeInfo;
+		return GetAttributeString(object, *attribute);
 	}
 
-	std::optional<char const *> CRPGStatsManager::GetAttributeString(CRPGStats_Object * object, FixedString const& attributeName)
+	std::optional<char const *> CRPGStatsManager::GetAttributeString(CRPGStats_Object * object, StatAttributeInfo const& attribute)
 	{
-		int attributeIndex;
-		auto typeInfo = GetAttributeInfo(object, attributeName, attributeIndex);
-		if (typeInfo == nullptr) {
+		auto typeInfo = attribute.Enumeration;
+		if (attribute.Index == -1 || typeInfo == nullptr) {
 			return {};
 		}
 
-		auto index = object->IndexedProperties[attributeIndex];
-		if (typeInfo->Name == GFS.strFixedString) {
+		auto index = object->IndexedProperties[attribute.Index];
+		if (attribute.Type == StatAttributeType::FixedString) {
 			return ModifierFSSet[index].Str;
-		} else if (typeInfo->Name == GFS.strAttributeFlags) {
+		} else if (attribute.Type == StatAttributeType::AttributeFlags) {
 			if (index != -1) {
 				auto attrFlags = (uint64_t)AttributeFlags[index];
 				STDString flagsStr;
@@ -847,14 +1059,23 @@ namespace dse
 
 	std::optional<int> CRPGStatsManager::GetAttributeInt(CRPGStats_Object * object, FixedString const& attributeName)
 	{
-		int attributeIndex;
-		auto typeInfo = GetAttributeInfo(object, attributeName, attributeIndex);
-		if (typeInfo == nullptr) {
+		auto attribute = gStatAttributeCache.Find(this, object->ModifierListIndex, attributeName);
+		if (attribute == nullptr) {
+			return {};
+		}
+
+		return GetAttributeInt(object, *attribute);
+	}
+
+	std::optional<int> CRPGStatsManager::GetAttributeInt(CRPGStats_Object * object, StatAttributeInfo const& attribute)
+	{
+		auto typeInfo = attribute.Enumeration;
+		if (attribute.Index == -1 || typeInfo == nullptr) {
 			return {};
 		}
 
-		auto index = object->IndexedProperties[attributeIndex];
-		if (typeInfo->Name == GFS.strConstantInt
+		auto index = object->IndexedProperties[attribute.Index];
+		if (attribute.Type == StatAttributeType::ConstantInt
 			|| typeInfo->Values.ItemCount > 0) {
 			return index;
 		}
@@ -865,21 +1086,25 @@ namespace dse
 
 	std::optional<int> CRPGStatsManager::GetAttributeIntScaled(CRPGStats_Object * object, FixedString const& attributeName, int level)
 	{
-		auto objModifiers = modifierList.Find(object->ModifierListIndex);
-		if (objModifiers == nullptr) {
+		auto attribute = gStatAttributeCache.Find(this, object->ModifierListIndex, attributeName);
+		if (attribute == nullptr) {
 			return {};
 		}
 
-		int attributeIndex;
-		auto modifierInfo = objModifiers->GetAttributeInfo(attributeName, &attributeIndex);
-		if (modifierInfo == nullptr) {
+		return GetAttributeIntScaled(object, *attribute, level);
+	}
+
+	std::optional<int> CRPGStatsManager::GetAttributeIntScaled(CRPGStats_Object * object, StatAttributeInfo const& attribute, int level)
+	{
+		if (attribute.Index == -1) {
 			return {};
 		}
 
-		auto levelMap = LevelMaps.Find(modifierInfo->LevelMapIndex);
-		auto value = object->IndexedProperties[attributeIndex];
+		auto levelMap = LevelMaps.Find(attribute.LevelMapIndex);
+		auto value = object->IndexedProperties[attribute.Index];
 		if (levelMap) {
-			return (int32_t)levelMap->GetScaledValue(value, level);
+			return (int32_t)gStatLevelMapCache.GetScaledValue(attribute.LevelMapIndex, value, level,
+				[this](int32_t index) { return LevelMaps.Find(index); });
 		} else {
 			return value;
 		}
@@ -943,21 +1168,32 @@ namespace dse
 
 	bool CRPGStatsManager::SetAttributeString(CRPGStats_Object * object, FixedString const& attributeName, const char * value)
 	{
-		int attributeIndex;
-		auto typeInfo = GetAttributeInfo(object, attributeName, attributeIndex);
-		if (typeInfo == nullptr) {
+		auto attribute = gStatAttributeCache.Find(this, object->ModifierListIndex, attributeName);
+		if (attribute == nullptr) {
 			OsiError("Couldn't fetch type info for " << object->Name << "." << attributeName);
 			return false;
 		}
 
-		if (typeInfo->Name == GFS.strFixedString) {
+		return SetAttributeString(object, *attribute, value);
+	}
+
+	bool CRPGStatsManager::SetAttributeString(CRPGStats_Object * object, StatAttributeInfo const& attribute, const char * value)
+	{
+		auto typeInfo = attribute.Enumeration;
+		if (attribute.Index == -1 || typeInfo == nullptr) {
+			OsiError("Couldn't fetch type info for " << object->Name << "." << attribute.Name);
+			return false;
+		}
+
+		auto attributeIndex = attribute.Index;
+		if (attribute.Type == StatAttributeType::FixedString) {
 			auto fs = GetOrCreateFixedString(value);
 			if (fs != -1) {
 				object->IndexedProperties[attributeIndex] = fs;
 			} else {
-				OsiError("Couldn't set " << object->Name << "." << attributeName << ": Unable to allocate pooled string");
+				OsiError("Couldn't set " << object->Name << "." << attribute.Name << ": Unable to allocate pooled string");
 			}
-		} else if (typeInfo->Name == GFS.strAttributeFlags) {
+		} else if (attribute.Type == StatAttributeType::AttributeFlags) {
 			auto attrFlagsIndex = object->IndexedProperties[attributeIndex];
 			if (attrFlagsIndex != -1) {
 				auto & attrFlags = AttributeFlags[attrFlagsIndex];
@@ -966,18 +1202,18 @@ namespace dse
 					attrFlags = *flags;
 				}
 			} else {
-				OsiError("Couldn't set " << object->Name << "." << attributeName << ": Stats entry has no AttributeFlags");
+				OsiError("Couldn't set " << object->Name << "." << attribute.Name << ": Stats entry has no AttributeFlags");
 			}
 		} else if (typeInfo->Values.ItemCount > 0) {
 			auto enumIndex = typeInfo->Values.Find(ToFixedString(value));
 			if (enumIndex != nullptr) {
 				object->IndexedProperties[attributeIndex] = *enumIndex;
 			} else {
-				OsiError("Couldn't set " << object->Name << "." << attributeName << ": Value (\"" << value << "\") is not a valid enum label");
+				OsiError("Couldn't set " << object->Name << "." << attribute.Name << ": Value (\"" << value << "\") is not a valid enum label");
 				return false;
 			}
 		} else {
-			OsiError("Couldn't set " << object->Name << "." << attributeName << ": Inappropriate type: " << typeInfo->Name.Str);
+			OsiError("Couldn't set " << object->Name << "." << attribute.Name << ": Inappropriate type: " << typeInfo->Name.Str);
 			return false;
 		}
 
@@ -986,24 +1222,35 @@ namespace dse
 
 	bool CRPGStatsManager::SetAttributeInt(CRPGStats_Object * object, FixedString const& attributeName, int32_t value)
 	{
-		int attributeIndex;
-		auto typeInfo = GetAttributeInfo(object, attributeName, attributeIndex);
-		if (typeInfo == nullptr) {
+		auto attribute = gStatAttributeCache.Find(this, object->ModifierListIndex, attributeName);
+		if (attribute == nullptr) {
 			OsiError("Couldn't fetch type info for " << object->Name << "." << attributeName);
 			return false;
 		}
 
-		if (typeInfo->Name == GFS.strConstantInt) {
+		return SetAttributeInt(object, *attribute, value);
+	}
+
+	bool CRPGStatsManager::SetAttributeInt(CRPGStats_Object * object, StatAttributeInfo const& attribute, int32_t value)
+	{
+		auto typeInfo = attribute.Enumeration;
+		if (attribute.Index == -1 || typeInfo == nullptr) {
+			OsiError("Couldn't fetch type info for " << object->Name << "." << attribute.Name);
+			return false;
+		}
+
+		auto attributeIndex = attribute.Index;
+		if (attribute.Type == StatAttributeType::ConstantInt) {
 			object->IndexedProperties[attributeIndex] = value;
 		} else if (typeInfo->Values.ItemCount > 0) {
 			if (value >= 0 && value < (int)typeInfo->Values.ItemCount) {
 				object->IndexedProperties[attributeIndex] = value;
 			} else {
-				OsiError("Couldn't set " << object->Name << "." << attributeName << ": Enum index (\"" << value << "\") out of range");
+				OsiError("Couldn't set " << object->Name << "." << attribute.Name << ": Enum index (\"" << value << "\") out of range");
 				return false;
 			}
 		} else {
-			OsiError("Couldn't set " << object->Name << "." << attributeName << ": Inappropriate type: " << typeInfo->Name.Str);
+			OsiError("Couldn't set " << object->Name << "." << attribute.Name << ": Inappropriate type: " << typeInfo->Name.Str);
 			return false;
 		}
 
@@ -2,7 +2,12 @@
 #include "Version.h"
 #include <GameDefinitions/BaseTypes.h>
 #include <OsirisProxy.h>
+#include <LogQueue.h>
+#include <StatDatabaseExport.h>
+#include <StatSnapshot.h>
+#include <HitTracer.h>
 #include <thread>
+#include <fstream>
 
 namespace dse
 {
@@ -50,6 +55,7 @@ void Fail(TCHAR const * reason)
 	DebugBreak();
 #endif
 	ERR(L"%s", reason);
+	gConsole.Flush();
 	MessageBoxW(NULL, reason, L"Script Extender Error", MB_OK | MB_ICONERROR);
 	TerminateProcess(GetCurrentProcess(), 1);
 }
@@ -61,6 +67,7 @@ void Fail(char const * reason)
 	DebugBreak();
 #endif
 	ERR("%s", reason);
+	gConsole.Flush();
 	MessageBoxA(NULL, reason, "Script Extender Error", MB_OK | MB_ICONERROR);
 	TerminateProcess(GetCurrentProcess(), 1);
 }
@@ -114,26 +121,228 @@ void DebugConsole::SetColor(DebugMessageType type)
 
 void DebugConsole::Debug(DebugMessageType type, char const* msg)
 {
-	if (!consoleRunning_ || silence_) return;
+	if (logQueue_ == nullptr) return;
 
-	SetColor(type);
-	OutputDebugStringA(msg);
-	OutputDebugStringA("\r\n");
-	std::cout << msg << std::endl;
-	std::cout.flush();
-	SetColor(DebugMessageType::Debug);
+	// Messages are written by the log thread; logging threads never wait for console/file I/O
+	logQueue_->Push(type, msg, strlen(msg));
+	if (logThreadIdle_.load(std::memory_order_relaxed)) {
+		SetEvent(logEvent_);
+	}
 }
 
 void DebugConsole::Debug(DebugMessageType type, wchar_t const* msg)
 {
-	if (!consoleRunning_ || silence_) return;
+	if (logQueue_ == nullptr) return;
+
+	Debug(type, ToUTF8(msg).c_str());
+}
+
+void DebugConsole::StartLogThread()
+{
+	if (logQueue_ != nullptr) return;
 
-	SetColor(type);
-	OutputDebugStringW(msg);
-	OutputDebugStringW(L"\r\n");
-	std::wcout << msg << std::endl;
-	std::wcout.flush();
-	SetColor(DebugMessageType::Debug);
+	auto queue = new LogQueue(LogQueueSize);
+	queue->SetRateLimit(LogRateLimit);
+	logEvent_ = CreateEventW(NULL, FALSE, FALSE, NULL);
+	logQueue_ = queue;
+	logThread_ = new std::thread(&DebugConsole::LogThread, this);
+}
+
+void DebugConsole::LogThread()
+{
+	auto record = std::make_unique<LogQueue::Record>();
+	std::string fileBuf;
+
+	for (;;) {
+		logThreadBusy_ = true;
+		auto logFile = logFile_.load();
+		bool toConsole = consoleRunning_ && !silence_;
+		bool toDebugger = IsDebuggerPresent() == TRUE;
+		auto color = DebugMessageType::Debug;
+		bool written = false;
+
+		auto write = [&](DebugMessageType type, char const* msg, std::size_t length) {
+			if (toConsole) {
+				if (type != color) {
+					std::cout.flush();
+					SetColor(type);
+					color = type;
+				}
+
+				std::cout.write(msg, length);
+				std::cout << '\n';
+			}
+
+			if (toDebugger) {
+				auto wmsg = FromUTF8(std::string_view(msg, length));
+				wmsg += L"\r\n";
+				OutputDebugStringW(wmsg.c_str());
+			}
+
+			if (logFile != INVALID_HANDLE_VALUE) {
+				fileBuf.append(msg, length);
+				fileBuf += "\r\n";
+			}
+
+			written = true;
+		};
+
+		while (logQueue_->Pop(*record)) {
+			write(record->Type, record->Text(), record->Length);
+			LogQueue::Release(*record);
+		}
+
+		auto dropped = logQueue_->TakeDroppedCount();
+		if (dropped > 0) {
+			char msg[128];
+			auto length = sprintf_s(msg, "%llu log messages were dropped (rate limit exceeded or log queue full)", dropped);
+			write(DebugMessageType::Warning, msg, length);
+		}
+
+		if (written) {
+			if (toConsole) {
+				std::cout.flush();
+				SetColor(DebugMessageType::Debug);
+			}
+
+			if (!fileBuf.empty()) {
+				DWORD bytesWritten;
+				WriteFile(logFile, fileBuf.data(), (DWORD)fileBuf.size(), &bytesWritten, NULL);
+				fileBuf.clear();
+			}
+		}
+
+		logThreadBusy_ = false;
+		logThreadIdle_ = true;
+		// Producers only signal the event if we're idle; the timeout covers messages
+		// pushed between the last Pop() and setting the idle flag
+		if (logQueue_->IsEmpty()) {
+			WaitForSingleObject(logEvent_, 50);
+		}
+		logThreadIdle_ = false;
+	}
+}
+
+void DebugConsole::Flush()
+{
+	if (logQueue_ == nullptr) return;
+
+	SetEvent(logEvent_);
+	for (unsigned i = 0; i < 1000 && (!logQueue_->IsEmpty() || logThreadBusy_); i++) {
+		Sleep(1);
+	}
+}
+
+void DebugConsole::OpenLogFile(std::wstring const& path)
+{
+	auto file = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		ERR(L"Could not open extender log file '%s'; error %d", path.c_str(), GetLastError());
+		return;
+	}
+
+	logFile_ = file;
+	StartLogThread();
+}
+
+dse::ExtensionStateBase* GetConsoleExtensionState(bool serverContext)
+{
+	if (serverContext) {
+		if (dse::gOsirisProxy->HasServerExtensionState()) {
+			return &dse::esv::ExtensionState::Get();
+		}
+	} else {
+		if (dse::gOsirisProxy->HasClientExtensionState()) {
+			return &dse::ecl::ExtensionState::Get();
+		}
+	}
+
+	return nullptr;
+}
+
+void ProfilerCommand(dse::lua::Profiler& profiler, std::string const& line)
+{
+	std::istringstream args(line);
+	std::string cmd, action, path;
+	args >> cmd >> action >> path;
+
+	if (action == "start") {
+		profiler.Start(dse::lua::Profiler::Mode::Instrument);
+		DEBUG("Lua profiler started (instrumenting mode)");
+	} else if (action == "sample") {
+		profiler.Start(dse::lua::Profiler::Mode::Sample);
+		DEBUG("Lua profiler started (sampling mode)");
+	} else if (action == "stop") {
+		profiler.Stop();
+	} else if (action == "reset") {
+		profiler.Reset();
+		DEBUG("Lua profile data cleared");
+	} else if (action == "dump") {
+		if (path.empty()) {
+			path = ToUTF8(dse::gOsirisProxy->GetConfig().LogDirectory) + "\\LuaProfile.txt";
+		}
+
+		profiler.Dump(path);
+		profiler.LogSummary();
+	} else {
+		ERR("Usage: profile <start|sample|stop|reset|dump [path]>");
+	}
+}
+
+void HitTraceCommand(std::string const& line)
+{
+	std::istringstream args(line);
+	std::string cmd, action, path;
+	args >> cmd >> action >> path;
+
+	auto& tracer = dse::esv::gHitTracer;
+	if (action == "start") {
+		tracer.Start();
+	} else if (action == "stop") {
+		tracer.Stop();
+	} else if (action == "reset") {
+		tracer.Reset();
+		DEBUG("Hit trace data cleared");
+	} else if (action == "dump") {
+		if (path.empty()) {
+			path = ToUTF8(dse::gOsirisProxy->GetConfig().LogDirectory) + "\\HitTrace.txt";
+		}
+
+		std::string trace;
+		tracer.Dump(trace);
+		std::ofstream f(path.c_str(), std::ios::out | std::ios::binary);
+		if (f.good()) {
+			f.write(trace.data(), trace.size());
+			DEBUG("Hit trace written to %s", path.c_str());
+		} else {
+			ERR("Could not open '%s' for writing", path.c_str());
+		}
+
+		tracer.LogSummary();
+	} else {
+		ERR("Usage: hittrace <start|stop|reset|dump [path]>");
+	}
+}
+
+void StatDatabaseCommand(std::string const& line)
+{
+	std::istringstream args(line);
+	std::string cmd, path;
+	args >> cmd >> path;
+
+	auto stats = dse::GetStaticSymbols().GetStats();
+	if (stats == nullptr || !dse::gStatSnapshots.Acquire()) {
+		ERR("Stats are not loaded yet");
+		return;
+	}
+
+	if (path.empty()) {
+		path = ToUTF8(dse::gOsirisProxy->GetConfig().LogDirectory) + "\\Stats.sdb";
+	}
+
+	if (dse::ExportStatDatabase(stats, path)) {
+		DEBUG("Stats database written to %s", path.c_str());
+	}
 }
 
 void DebugConsole::ConsoleThread()
@@ -155,6 +364,8 @@ void DebugConsole::ConsoleThread()
 		dse::gOsirisProxy->AttachConsoleThread(serverContext_);
 
 		while (consoleRunning_) {
+			// Make sure that the output of the previous command is written before the prompt
+			Flush();
 			inputEnabled_ = true;
 			silence_ = silence;
 			std::cout << ">> ";
@@ -184,20 +395,32 @@ void DebugConsole::ConsoleThread()
 				DEBUG("  server - Switch to server context");
 				DEBUG("  client - Switch to client context");
 				DEBUG("  silence <on|off> - Enable/disable silent mode (log output when in input mode)");
+				DEBUG("  profile <start|sample|stop|reset> - Start/stop the Lua profiler in instrumenting or sampling mode");
+				DEBUG("  profile dump [path] - Write collapsed-stack Lua profile and print per-mod/per-event totals");
+				DEBUG("  hittrace <start|stop|reset> - Start/stop tracing of the hit pipeline");
+				DEBUG("  hittrace dump [path] - Write hit phase histograms and events and print per-phase totals");
+				DEBUG("  statdb [path] - Export the loaded stats database for offline tools (Tools/StatDbReader)");
 				DEBUG("  exit - Leave console mode");
 				DEBUG("  !<cmd> <arg1> ... <argN> - Trigger Lua \"ConsoleCommand\" event with arguments cmd, arg1, ..., argN");
-			} else {
-				dse::ExtensionStateBase* state{ nullptr };
-				if (serverContext_) {
-					if (dse::gOsirisProxy->HasServerExtensionState()) {
-						state = &dse::esv::ExtensionState::Get();
+			} else if (line.rfind("hittrace", 0) == 0) {
+				HitTraceCommand(line);
+			} else if (line == "statdb" || line.rfind("statdb ", 0) == 0) {
+				StatDatabaseCommand(line);
+			} else if (line.rfind("profile", 0) == 0) {
+				auto state = GetConsoleExtensionState(serverContext_);
+				if (state) {
+					dse::LuaVirtualPin pin(*state);
+					if (pin) {
+						std::lock_guard lock(pin->GetMutex());
+						ProfilerCommand(pin->GetProfiler(), line);
+					} else {
+						ERR("Lua state not initialized!");
 					}
 				} else {
-					if (dse::gOsirisProxy->HasClientExtensionState()) {
-						state = &dse::ecl::ExtensionState::Get();
-					}
+					ERR("Extensions not initialized!");
 				}
-
+			} else {
+				auto state = GetConsoleExtensionState(serverContext_);
 				if (state) {
 					dse::LuaVirtualPin pin(*state);
 					if (pin) {
@@ -238,6 +461,7 @@ void DebugConsole::Create()
 	FILE* inputStream;
 	freopen_s(&inputStream, "CONIN$", "r", stdin);
 	consoleRunning_ = true;
+	StartLogThread();
 
 	DEBUG("******************************************************************************");
 	DEBUG("*                                                                            *");
@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <string>
+#include <atomic>
 
 namespace std
 {
@@ -17,22 +18,40 @@ enum class DebugMessageType
 	Error
 };
 
+class LogQueue;
+
 class DebugConsole
 {
 public:
 	void Create();
+	void OpenLogFile(std::wstring const& path);
+	// Waits until all queued messages were written
+	void Flush();
 
 	void Debug(DebugMessageType type, char const* msg);
 	void Debug(DebugMessageType type, wchar_t const* msg);
 
 private:
+	// Maximum number of messages per second in each message category
+	static constexpr uint32_t LogRateLimit = 2000;
+	static constexpr std::size_t LogQueueSize = 2048;
+
 	bool created_{ false };
 	bool inputEnabled_{ false };
 	bool silence_{ false };
 	bool consoleRunning_{ false };
 	std::thread* consoleThread_{ nullptr };
 
+	LogQueue* logQueue_{ nullptr };
+	std::thread* logThread_{ nullptr };
+	std::atomic<HANDLE> logFile_{ INVALID_HANDLE_VALUE };
+	HANDLE logEvent_{ NULL };
+	std::atomic<bool> logThreadIdle_{ false };
+	std::atomic<bool> logThreadBusy_{ false };
+
 	void ConsoleThread();
+	void LogThread();
+	void StartLogThread();
 	void SetColor(DebugMessageType type);
 };
 
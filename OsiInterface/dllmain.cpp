@@ -45,6 +45,8 @@ void LoadConfig(std::wstring const & configPath, dse::ToolConfig & config)
 	ConfigGetBool(root, "DisableModValidation", config.DisableModValidation);
 	ConfigGetBool(root, "DeveloperMode", config.DeveloperMode);
 	ConfigGetBool(root, "EnableAchievements", config.EnableAchievements);
+	ConfigGetBool(root, "EnableLuaBytecodeCache", config.EnableLuaBytecodeCache);
+	ConfigGetBool(root, "LogRuntime", config.LogRuntime);
 
 	auto debuggerPort = root["DebuggerPort"];
 	if (!debuggerPort.isNull()) {
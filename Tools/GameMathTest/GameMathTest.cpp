@@ -0,0 +1,1994 @@
+// Differential test and benchmark of the native damage and hit formulas (OsiInterface/GameMath.cpp)
+// against the Lua implementation in OsiInterface/LuaScripts/Game.Math.lua.
+//
+// Build (Linux, Lua compiled as C++ like LuaLib):
+//   g++ -O2 -std=c++17 -I../../External/lua-5.3.5/src -I../../OsiInterface GameMathTest.cpp
+//       ../../OsiInterface/GameMath.cpp
+//       -x c++ $(ls ../../External/lua-5.3.5/src/*.c | grep -v '/luac\?\.c$') -o GameMathTest
+//
+// Usage:
+//   GameMathTest [cases] [seed] [path of Game.Math.lua]
+//
+// Generates random characters (stats, talents, flags, position), weapons and shields (dynamic
+// stats, requirements), skills, hits and ExtraData values, exposes them to Game.Math.lua as plain
+// tables shaped like the extender's stat proxies, then runs GetSkillDamage, CalculateWeaponDamage,
+// GetSkillDamageRange, CalculateHitChance and ComputeCharacterHit in Lua and natively.
+// Ext.Random and math.random draw from the same generator on both sides, which is reseeded
+// before each run. Every result must match exactly: damage lists (order and amounts), death types,
+// hit fields and flags, integer/float subtypes, the number of random draws, and whether the Lua
+// code raised an error. The Ext._GameMath dispatch wrappers at the end of Game.Math.lua are
+// checked with a stub native table.
+
+#include <GameMath.h>
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+
+using namespace dse::gamemath;
+using Clock = std::chrono::steady_clock;
+
+static char const* const DamageTypeNames[] = {
+	"None", "Physical", "Piercing", "Corrosive", "Magic", "Chaos", "Fire",
+	"Air", "Water", "Earth", "Poison", "Shadow", "Sulfuric", "Sentinel"
+};
+
+static char const* const DeathTypeNames[] = {
+	"None", "Physical", "Piercing", "Arrow", "DoT", "Incinerate", "Acid", "Electrocution",
+	"FrozenShatter", "PetrifiedShatter", "Explode", "Surrender", "Hang", "KnockedDown",
+	"Lifetime", "Sulfur", "Sentinel"
+};
+
+static char const* const HitTypeNames[] = { "Melee", "Magic", "Ranged", "WeaponDamage", "Surface", "DoT", "Reflected" };
+static char const* const CriticalRollNames[] = { "Roll", "Critical", "NotCritical" };
+static char const* const HighGroundNames[] = { "Unknown", "HighGround", "EvenGround", "LowGround" };
+
+static char const* const WeaponTypeNames[] = {
+	"None", "Sword", "Club", "Axe", "Staff", "Bow", "Crossbow", "Spear", "Knife", "Wand", "Arrow", "Rifle", "Sentinel"
+};
+
+static char const* const EquipmentStatsTypeNames[] = { "Weapon", "Armor", "Shield" };
+
+static char const* const DamageSourceNames[] = {
+	"BaseLevelDamage", "AverageLevelDamge", "MonsterWeaponDamage", "SourceMaximumVitality",
+	"SourceMaximumPhysicalArmor", "SourceMaximumMagicArmor", "SourceCurrentVitality",
+	"SourceCurrentPhysicalArmor", "SourceCurrentMagicArmor", "SourceShieldPhysicalArmor",
+	"TargetMaximumVitality", "TargetMaximumPhysicalArmor", "TargetMaximumMagicArmor",
+	"TargetCurrentVitality", "TargetCurrentPhysicalArmor", "TargetCurrentMagicArmor", "Unknown"
+};
+
+static char const* const SkillAbilityNames[] = { "Warrior", "Polymorph", "Ranger", "Rogue", "Source" };
+
+static char const* const CharacterStatNames[] = {
+	"Level", "Strength", "Finesse", "Intelligence", "Constitution", "Memory", "Wits",
+	"WarriorLore", "RangerLore", "RogueLore", "SingleHanded", "TwoHanded", "Ranged", "DualWielding",
+	"FireSpecialist", "WaterSpecialist", "AirSpecialist", "EarthSpecialist",
+	"PhysicalResistance", "PiercingResistance", "CorrosiveResistance", "MagicResistance",
+	"FireResistance", "AirResistance", "WaterResistance", "EarthResistance", "PoisonResistance",
+	"ShadowResistance", "DamageBoost", "CriticalChance", "Accuracy", "Dodge", "ChanceToHitBoost",
+	"BlockChance", "LifeSteal", "MaxVitality", "MaxArmor", "MaxMagicArmor", "CurrentVitality",
+	"CurrentArmor", "CurrentMagicArmor", "IsIncapacitatedRefCount"
+};
+
+constexpr unsigned NumCharacterStats = (unsigned)CharacterStat::IsIncapacitatedRefCount + 1;
+static_assert(std::size(CharacterStatNames) == NumCharacterStats);
+
+static char const* const CharacterFlagNames[] = { "IsSneaking", "Invisible", "InParty" };
+
+struct TalentName
+{
+	Talent Id;
+	char const* Name;
+};
+
+static TalentName const Talents[] = {
+	{ Talent::Damage, "TALENT_Damage" },
+	{ Talent::Durability, "TALENT_Durability" },
+	{ Talent::RangerLoreEvasionBonus, "TALENT_RangerLoreEvasionBonus" },
+	{ Talent::Human_Inventive, "TALENT_Human_Inventive" },
+	{ Talent::ViolentMagic, "TALENT_ViolentMagic" },
+	{ Talent::Sadist, "TALENT_Sadist" },
+	{ Talent::Haymaker, "TALENT_Haymaker" }
+};
+
+char const* RequirementName(RequirementType type)
+{
+	switch (type) {
+	case RequirementType::Level: return "Level";
+	case RequirementType::Strength: return "Strength";
+	case RequirementType::Finesse: return "Finesse";
+	case RequirementType::Intelligence: return "Intelligence";
+	case RequirementType::Constitution: return "Constitution";
+	case RequirementType::Memory: return "Memory";
+	case RequirementType::Wits: return "Wits";
+	case RequirementType::Tag: return "Tag";
+	default: return "None";
+	}
+}
+
+template <size_t N>
+int FindLabel(char const* const (&names)[N], char const* label)
+{
+	for (size_t i = 0; i < N; i++) {
+		if (strcmp(names[i], label) == 0) return (int)i;
+	}
+	return -1;
+}
+
+
+// Shared by Ext.Random, math.random and the native environment
+static std::mt19937_64 gFormulaRng;
+
+int64_t RandomInt(int64_t low, int64_t high)
+{
+	return std::uniform_int_distribution<int64_t>(low, high)(gFormulaRng);
+}
+
+// Ext.Random and math.random; argument handling of LuaRandom (LuaExtFunctions.cpp)
+int LuaRandom(lua_State* L)
+{
+	lua_Integer low, up;
+	switch (lua_gettop(L)) {
+	case 0:
+		lua_pushnumber(L, std::uniform_real_distribution<double>(0.0, 1.0)(gFormulaRng));
+		return 1;
+	case 1:
+		low = 1;
+		up = luaL_checkinteger(L, 1);
+		break;
+	case 2:
+		low = luaL_checkinteger(L, 1);
+		up = luaL_checkinteger(L, 2);
+		break;
+	default:
+		return luaL_error(L, "wrong number of arguments");
+	}
+
+	luaL_argcheck(L, low <= up, 1, "interval is empty");
+	lua_pushinteger(L, RandomInt(low, up));
+	return 1;
+}
+
+int LuaRound(lua_State* L)
+{
+	lua_pushnumber(L, round(luaL_checknumber(L, 1)));
+	return 1;
+}
+
+
+// DamageList userdata with the methods of the extender's DamageList object
+static char const* const DamageListMetatable = "CDamageList";
+
+struct LuaDamageList
+{
+	DamageList List;
+};
+
+LuaDamageList* NewLuaDamageList(lua_State* L)
+{
+	auto list = reinterpret_cast<LuaDamageList*>(lua_newuserdata(L, sizeof(LuaDamageList)));
+	new (list) LuaDamageList();
+	luaL_setmetatable(L, DamageListMetatable);
+	return list;
+}
+
+LuaDamageList* CheckDamageList(lua_State* L, int index)
+{
+	return reinterpret_cast<LuaDamageList*>(luaL_checkudata(L, index, DamageListMetatable));
+}
+
+DamageType CheckDamageType(lua_State* L, int index)
+{
+	if (lua_type(L, index) == LUA_TSTRING) {
+		auto label = FindLabel(DamageTypeNames, lua_tostring(L, index));
+		if (label < 0) luaL_error(L, "Param %d is not a valid 'DamageType' enum label", index);
+		return (DamageType)label;
+	} else if (lua_type(L, index) == LUA_TNUMBER) {
+		auto value = lua_tointeger(L, index);
+		if (value < 0 || value >= (lua_Integer)NumDamageTypes) luaL_error(L, "Param %d is not a valid 'DamageType' enum index", index);
+		return (DamageType)value;
+	} else {
+		luaL_error(L, "Param %d: expected integer or string 'DamageType' enumeration value", index);
+		return DamageType::None;
+	}
+}
+
+int DamageListGC(lua_State* L)
+{
+	CheckDamageList(L, 1)->~LuaDamageList();
+	return 0;
+}
+
+int DamageListGetByType(lua_State* L)
+{
+	auto self = CheckDamageList(L, 1);
+	lua_pushinteger(L, self->List.GetByType(CheckDamageType(L, 2)));
+	return 1;
+}
+
+int DamageListAdd(lua_State* L)
+{
+	auto self = CheckDamageList(L, 1);
+	auto type = CheckDamageType(L, 2);
+	auto amount = (int32_t)luaL_checkinteger(L, 3);
+	self->List.Add(type, amount);
+	return 0;
+}
+
+int DamageListClear(lua_State* L)
+{
+	auto self = CheckDamageList(L, 1);
+	if (lua_gettop(L) >= 2) {
+		self->List.Clear(CheckDamageType(L, 2));
+	} else {
+		self->List.Clear();
+	}
+	return 0;
+}
+
+int DamageListMultiply(lua_State* L)
+{
+	auto self = CheckDamageList(L, 1);
+	self->List.Multiply(luaL_checknumber(L, 2));
+	return 0;
+}
+
+int DamageListMerge(lua_State* L)
+{
+	auto self = CheckDamageList(L, 1);
+	auto other = CheckDamageList(L, 2);
+	self->List.Merge(other->List);
+	return 0;
+}
+
+int DamageListConvertDamageType(lua_State* L)
+{
+	auto self = CheckDamageList(L, 1);
+	self->List.ConvertDamageType(CheckDamageType(L, 2));
+	return 0;
+}
+
+int DamageListAggregateSameTypeDamages(lua_State* L)
+{
+	CheckDamageList(L, 1)->List.AggregateSameTypeDamages();
+	return 0;
+}
+
+int DamageListToTable(lua_State* L)
+{
+	auto self = CheckDamageList(L, 1);
+	lua_newtable(L);
+	for (size_t i = 0; i < self->List.Damages.size(); i++) {
+		auto const& dmg = self->List.Damages[i];
+		lua_newtable(L);
+		lua_pushstring(L, DamageTypeNames[(unsigned)dmg.Type]);
+		lua_setfield(L, -2, "DamageType");
+		lua_pushinteger(L, dmg.Amount);
+		lua_setfield(L, -2, "Amount");
+		lua_rawseti(L, -2, (lua_Integer)i + 1);
+	}
+	return 1;
+}
+
+int LuaNewDamageList(lua_State* L)
+{
+	NewLuaDamageList(L);
+	return 1;
+}
+
+
+// Game objects of one test case; the Lua tables are kept in the registry
+struct TestItem
+{
+	Item Stats;
+	std::vector<std::string> TagParams;
+	bool LoseDurabilityOnCharacterHit{ false };
+	bool Unbreakable{ false };
+	int32_t Durability{ 0 };
+	int LuaRef{ LUA_NOREF };
+};
+
+class TestCharacter : public Character
+{
+public:
+	std::optional<int32_t> Stats[NumCharacterStats];
+	bool TalentFlags[std::size(Talents)]{};
+	bool Flags[std::size(CharacterFlagNames)]{};
+	TestItem* MainWeapon{ nullptr };
+	TestItem* OffHandWeapon{ nullptr };
+	TestItem* Shield{ nullptr };
+	bool HasPosition{ true };
+	double Position[3]{};
+	double Rotation[9]{};
+	int LuaRef{ LUA_NOREF };
+
+	std::optional<int32_t> GetStat(CharacterStat stat) const override
+	{
+		return Stats[(unsigned)stat];
+	}
+
+	bool HasTalent(Talent talent) const override
+	{
+		for (size_t i = 0; i < std::size(Talents); i++) {
+			if (Talents[i].Id == talent) return TalentFlags[i];
+		}
+		return false;
+	}
+
+	bool HasFlag(CharacterFlag flag) const override
+	{
+		return Flags[(unsigned)flag];
+	}
+
+	Item const* GetMainWeapon() const override
+	{
+		return MainWeapon ? &MainWeapon->Stats : nullptr;
+	}
+
+	Item const* GetOffHandWeapon() const override
+	{
+		return OffHandWeapon ? &OffHandWeapon->Stats : nullptr;
+	}
+
+	Item const* GetShield() const override
+	{
+		return Shield ? &Shield->Stats : nullptr;
+	}
+
+	bool GetPosition(double (&position)[3]) const override
+	{
+		if (!HasPosition) return false;
+		std::copy(Position, Position + 3, position);
+		return true;
+	}
+
+	bool GetRotation(double (&rotation)[9]) const override
+	{
+		if (!HasPosition) return false;
+		std::copy(Rotation, Rotation + 9, rotation);
+		return true;
+	}
+};
+
+class TestEnvironment : public Environment
+{
+public:
+	TestEnvironment(lua_State* L)
+		: L(L)
+	{}
+
+	int64_t ExtRandom(int64_t min, int64_t max) override
+	{
+		return RandomInt(min, max);
+	}
+
+	int64_t MathRandom(int64_t min, int64_t max) override
+	{
+		return RandomInt(min, max);
+	}
+
+	bool ConditionalDamageItemDurability(Character const& character, Item const& item) override
+	{
+		auto top = lua_gettop(L);
+		lua_getglobal(L, "Game");
+		lua_getfield(L, -1, "Math");
+		lua_getfield(L, -1, "ConditionalDamageItemDurability");
+		lua_rawgeti(L, LUA_REGISTRYINDEX, static_cast<TestCharacter const&>(character).LuaRef);
+		lua_rawgeti(L, LUA_REGISTRYINDEX, reinterpret_cast<TestItem*>(item.Context)->LuaRef);
+		auto ok = lua_pcall(L, 2, 0, 0) == LUA_OK;
+		lua_settop(L, top);
+		return ok;
+	}
+
+private:
+	lua_State* L;
+};
+
+
+static char const* const MockScript = R"(
+function MockGetItemBySlot(self, slot, mustBeEquipped)
+	if slot == "Shield" then
+		return self._Shield
+	end
+end
+
+-- Benchmark drivers; the hit table and damage list are recreated for each call like in the game
+function BenchCall8(fn, args, reps)
+	for r = 1, reps do
+		for i = 1, #args do
+			local a = args[i]
+			fn(a[1], a[2], a[3], a[4], a[5], a[6], a[7], a[8])
+		end
+	end
+end
+
+function BenchComputeCharacterHit(fn, args, reps)
+	for r = 1, reps do
+		for i = 1, #args do
+			local a = args[i]
+			local damageList = Ext.NewDamageList()
+			for j, dmg in ipairs(a.Damages) do
+				damageList:Add(dmg[1], dmg[2])
+			end
+			local hit = {
+				EffectFlags = a.EffectFlags, TotalDamageDone = 0, ArmorAbsorption = 0, LifeSteal = 0,
+				DamageType = a.DamageType, DamageList = Ext.NewDamageList()
+			}
+			fn(a.Target, a.Attacker, a.Weapon, damageList, a.HitType, a.NoHitRoll, false, hit,
+				a.AlwaysBackstab, a.HighGround, a.CriticalRoll)
+		end
+	end
+end
+)";
+
+void RegisterMockExt(lua_State* L)
+{
+	luaL_newmetatable(L, DamageListMetatable);
+	lua_pushcfunction(L, &DamageListGC);
+	lua_setfield(L, -2, "__gc");
+	lua_newtable(L);
+	struct { char const* Name; lua_CFunction Fn; } methods[] = {
+		{ "GetByType", &DamageListGetByType }, { "Add", &DamageListAdd }, { "Clear", &DamageListClear },
+		{ "Multiply", &DamageListMultiply }, { "Merge", &DamageListMerge },
+		{ "ConvertDamageType", &DamageListConvertDamageType },
+		{ "AggregateSameTypeDamages", &DamageListAggregateSameTypeDamages }, { "ToTable", &DamageListToTable }
+	};
+	for (auto const& method : methods) {
+		lua_pushcfunction(L, method.Fn);
+		lua_setfield(L, -2, method.Name);
+	}
+	lua_setfield(L, -2, "__index");
+	lua_pop(L, 1);
+
+	lua_newtable(L);
+	lua_pushcfunction(L, &LuaRandom);
+	lua_setfield(L, -2, "Random");
+	lua_pushcfunction(L, &LuaRound);
+	lua_setfield(L, -2, "Round");
+	lua_pushcfunction(L, &LuaNewDamageList);
+	lua_setfield(L, -2, "NewDamageList");
+	lua_newtable(L);
+	lua_setfield(L, -2, "ExtraData");
+	lua_setglobal(L, "Ext");
+
+	lua_getglobal(L, "math");
+	lua_pushcfunction(L, &LuaRandom);
+	lua_setfield(L, -2, "random");
+	lua_pop(L, 1);
+}
+
+
+struct ExtraDataDefault
+{
+	char const* Key;
+	double Value;
+	double ExtraData::* Field;
+};
+
+// Values of Data.txt of the base game
+static ExtraDataDefault const ExtraDataDefaults[] = {
+	{ "AttributeBaseValue", 10.0, &ExtraData::AttributeBaseValue },
+	{ "DamageBoostFromAttribute", 0.05, &ExtraData::DamageBoostFromAttribute },
+	{ "VitalityStartingAmount", 21.0, &ExtraData::VitalityStartingAmount },
+	{ "VitalityExponentialGrowth", 1.25, &ExtraData::VitalityExponentialGrowth },
+	{ "VitalityLinearGrowth", 9.091, &ExtraData::VitalityLinearGrowth },
+	{ "VitalityToDamageRatio", 5.0, &ExtraData::VitalityToDamageRatio },
+	{ "VitalityToDamageRatioGrowth", 0.2, &ExtraData::VitalityToDamageRatioGrowth },
+	{ "FirstVitalityLeapLevel", 9.0, &ExtraData::FirstVitalityLeapLevel },
+	{ "FirstVitalityLeapGrowth", 1.25, &ExtraData::FirstVitalityLeapGrowth },
+	{ "SecondVitalityLeapLevel", 13.0, &ExtraData::SecondVitalityLeapLevel },
+	{ "SecondVitalityLeapGrowth", 1.25, &ExtraData::SecondVitalityLeapGrowth },
+	{ "ThirdVitalityLeapLevel", 16.0, &ExtraData::ThirdVitalityLeapLevel },
+	{ "ThirdVitalityLeapGrowth", 1.25, &ExtraData::ThirdVitalityLeapGrowth },
+	{ "FourthVitalityLeapLevel", 18.0, &ExtraData::FourthVitalityLeapLevel },
+	{ "FourthVitalityLeapGrowth", 1.35, &ExtraData::FourthVitalityLeapGrowth },
+	{ "ExpectedDamageBoostFromAttributePerLevel", 0.065, &ExtraData::ExpectedDamageBoostFromAttributePerLevel },
+	{ "ExpectedDamageBoostFromSkillAbilityPerLevel", 0.015, &ExtraData::ExpectedDamageBoostFromSkillAbilityPerLevel },
+	{ "ExpectedDamageBoostFromWeaponAbilityPerLevel", 0.025, &ExtraData::ExpectedDamageBoostFromWeaponAbilityPerLevel },
+	{ "MonsterDamageBoostPerLevel", 0.02, &ExtraData::MonsterDamageBoostPerLevel },
+	{ "SkillAbilityPhysicalDamageBoostPerPoint", 5.0, &ExtraData::SkillAbilityPhysicalDamageBoostPerPoint },
+	{ "SkillAbilityFireDamageBoostPerPoint", 5.0, &ExtraData::SkillAbilityFireDamageBoostPerPoint },
+	{ "SkillAbilityAirDamageBoostPerPoint", 5.0, &ExtraData::SkillAbilityAirDamageBoostPerPoint },
+	{ "SkillAbilityWaterDamageBoostPerPoint", 5.0, &ExtraData::SkillAbilityWaterDamageBoostPerPoint },
+	{ "SkillAbilityPoisonAndEarthDamageBoostPerPoint", 5.0, &ExtraData::SkillAbilityPoisonAndEarthDamageBoostPerPoint },
+	{ "SkillAbilityDamageToMagicArmorPerPoint", 5.0, &ExtraData::SkillAbilityDamageToMagicArmorPerPoint },
+	{ "SkillAbilityDamageToPhysicalArmorPerPoint", 5.0, &ExtraData::SkillAbilityDamageToPhysicalArmorPerPoint },
+	{ "SkillAbilityCritMultiplierPerPoint", 5.0, &ExtraData::SkillAbilityCritMultiplierPerPoint },
+	{ "SkillAbilityHighGroundBonusPerPoint", 5.0, &ExtraData::SkillAbilityHighGroundBonusPerPoint },
+	{ "CombatAbilityDamageBonus", 5.0, &ExtraData::CombatAbilityDamageBonus },
+	{ "CombatAbilityCritMultiplierBonus", 5.0, &ExtraData::CombatAbilityCritMultiplierBonus },
+	{ "Sneak Damage Multiplier", 1.0, &ExtraData::SneakDamageMultiplier },
+	{ "DualWieldingDamagePenalty", 0.5, &ExtraData::DualWieldingDamagePenalty },
+	{ "TalentHumanCriticalMultiplier", 10.0, &ExtraData::TalentHumanCriticalMultiplier },
+	{ "TalentViolentMagicCriticalChancePercent", 100.0, &ExtraData::TalentViolentMagicCriticalChancePercent },
+	{ "LifestealFromReflectionModifier", 0.0, &ExtraData::LifestealFromReflectionModifier },
+	{ "HighGroundBaseDamageBonus", 0.2, &ExtraData::HighGroundBaseDamageBonus },
+	{ "LowGroundBaseDamagePenalty", -0.1, &ExtraData::LowGroundBaseDamagePenalty }
+};
+
+static_assert(std::size(ExtraDataDefaults) * sizeof(double) == sizeof(ExtraData));
+
+
+// Inputs of all five functions for one test case
+struct TestCase
+{
+	ExtraData Extra;
+	std::vector<std::unique_ptr<TestItem>> Items;
+	std::unique_ptr<TestCharacter> Attacker;
+	std::unique_ptr<TestCharacter> Target;
+	Skill SkillData;
+	int SkillRef{ LUA_NOREF };
+
+	// GetSkillDamage
+	bool HasAttacker{ true };
+	bool IsFromItem{ false };
+	bool Stealthed{ false };
+	bool NoRandomization{ false };
+	double AttackerPos[3]{};
+	double TargetPos[3]{};
+	int32_t Level{ -1 };
+
+	// CalculateWeaponDamage
+	TestItem* Weapon{ nullptr };
+
+	// ComputeCharacterHit
+	TestItem* HitWeapon{ nullptr };
+	DamageList Damages;
+	Hit HitData;
+	HitType Type{ HitType::Melee };
+	bool NoHitRoll{ false };
+	bool ForceReduceDurability{ false };
+	bool AlwaysBackstab{ false };
+	HighGroundBonus HighGround{ HighGroundBonus::Unknown };
+	CriticalRoll CritRoll{ CriticalRoll::Roll };
+};
+
+class CaseGenerator
+{
+public:
+	CaseGenerator(uint64_t seed)
+		: rng_(seed)
+	{}
+
+	std::unique_ptr<TestCase> Generate()
+	{
+		auto tc = std::make_unique<TestCase>();
+		bool perturb = Chance(0.5);
+		for (auto const& value : ExtraDataDefaults) {
+			auto v = value.Value;
+			if (perturb) {
+				v = v * Real(0.5, 1.5);
+				if (strstr(value.Key, "LeapLevel") != nullptr) v = round(v);
+			}
+			tc->Extra.*value.Field = v;
+		}
+
+		tc->Attacker = GenerateCharacter(*tc);
+		tc->Target = GenerateCharacter(*tc);
+		if (Chance(0.02)) {
+			std::copy(tc->Target->Position, tc->Target->Position + 3, tc->Attacker->Position);
+		}
+
+		auto& skill = tc->SkillData;
+		skill.DamageMultiplier = Chance(0.1) ? Int(-50, 0) : Int(10, 250);
+		skill.StealthDamageMultiplier = Int(100, 250);
+		skill.DistanceDamageMultiplier = Chance(0.7) ? 0 : Int(0, 10);
+		skill.DamageRange = Chance(0.03) ? Int(-10, -1) : Int(0, 40);
+		skill.Level = Chance(0.2) ? 0 : Int(1, 20);
+		skill.UseWeaponDamage = Chance(0.4);
+		skill.OverrideSkillLevel = Chance(0.3);
+		skill.Ability = (SkillAbility)Int(0, (int)SkillAbility::Other);
+		skill.DamageType = RandomDamageType();
+		// Target* sources always fail in Lua (the target passed to them is 0)
+		if (Chance(0.01)) {
+			skill.Damage = DamageSource::Unknown;
+		} else if (Chance(0.1)) {
+			skill.Damage = (DamageSource)Int((int)DamageSource::TargetMaximumVitality, (int)DamageSource::TargetCurrentMagicArmor);
+		} else {
+			skill.Damage = (DamageSource)Int(0, (int)DamageSource::SourceShieldPhysicalArmor);
+		}
+		skill.DeathType = Chance(0.7) ? DeathType::None : (DeathType)Int(0, (int)DeathType::Sentinel);
+
+		tc->HasAttacker = Chance(0.9);
+		tc->IsFromItem = Chance(0.2);
+		tc->Stealthed = Chance(0.3);
+		tc->NoRandomization = Chance(0.3);
+		RandomPosition(tc->AttackerPos);
+		if (Chance(0.05)) {
+			std::copy(tc->AttackerPos, tc->AttackerPos + 3, tc->TargetPos);
+		} else {
+			RandomPosition(tc->TargetPos);
+		}
+		tc->Level = Chance(0.3) ? -1 : (Chance(0.15) ? 0 : Int(1, 25));
+
+		auto& attacker = *tc->Attacker;
+		if (attacker.OffHandWeapon && Chance(0.3)) {
+			tc->Weapon = attacker.OffHandWeapon;
+		} else if (attacker.MainWeapon && Chance(0.8)) {
+			tc->Weapon = attacker.MainWeapon;
+		} else {
+			tc->Weapon = GenerateWeapon(*tc);
+		}
+
+		auto weaponRoll = Real(0.0, 1.0);
+		if (weaponRoll < 0.8) {
+			tc->HitWeapon = attacker.MainWeapon;
+		} else if (weaponRoll < 0.9) {
+			tc->HitWeapon = GenerateWeapon(*tc);
+		}
+
+		GenerateDamages(tc->Damages, Int(1, 4));
+		auto& hit = tc->HitData;
+		int64_t const inputFlags[] = {
+			HitFlag::Poisoned, HitFlag::Burning, HitFlag::Bleeding, HitFlag::Reflection,
+			HitFlag::NoDamageOnOwner, HitFlag::FromShacklesOfPain, HitFlag::CriticalHit
+		};
+		for (auto flag : inputFlags) {
+			if (Chance(0.15)) hit.EffectFlags |= flag;
+		}
+		hit.TotalDamageDone = Chance(0.7) ? 0 : Int(0, 20);
+		hit.ArmorAbsorption = Chance(0.7) ? 0 : Int(0, 20);
+		hit.LifeSteal = Chance(0.9) ? 0 : Int(0, 5);
+		hit.DamageType = RandomDamageType();
+		GenerateDamages(hit.DamageList, Int(0, 2));
+
+		tc->Type = (HitType)Int(0, (int)HitType::Reflected);
+		tc->NoHitRoll = Chance(0.3);
+		tc->ForceReduceDurability = Chance(0.5);
+		tc->AlwaysBackstab = Chance(0.1);
+		tc->HighGround = (HighGroundBonus)Int(0, (int)HighGroundBonus::LowGround);
+		tc->CritRoll = (CriticalRoll)Int(0, (int)CriticalRoll::NotCritical);
+		return tc;
+	}
+
+private:
+	std::mt19937_64 rng_;
+	uint32_t nextInstanceId_{ 1 };
+
+	bool Chance(double probability)
+	{
+		return std::uniform_real_distribution<double>(0.0, 1.0)(rng_) < probability;
+	}
+
+	int32_t Int(int32_t min, int32_t max)
+	{
+		return std::uniform_int_distribution<int32_t>(min, max)(rng_);
+	}
+
+	double Real(double min, double max)
+	{
+		return std::uniform_real_distribution<double>(min, max)(rng_);
+	}
+
+	// Sulfuric and Sentinel have no resistance stat and make the Lua code raise an error
+	DamageType RandomDamageType()
+	{
+		if (Chance(0.01)) return Chance(0.5) ? DamageType::Sulfuric : DamageType::Sentinel;
+		if (Chance(0.5)) return DamageType::Physical;
+		return (DamageType)Int(0, (int)DamageType::Shadow);
+	}
+
+	void RandomPosition(double (&pos)[3])
+	{
+		pos[0] = Real(-20.0, 20.0);
+		pos[1] = Real(-3.0, 3.0);
+		pos[2] = Real(-20.0, 20.0);
+	}
+
+	void GenerateDamages(DamageList& damages, int count)
+	{
+		for (int i = 0; i < count; i++) {
+			damages.SafeAdd(RandomDamageType(), Chance(0.03) ? Int(-50, -1) : Int(0, 200));
+		}
+	}
+
+	TestItem* GenerateWeapon(TestCase& tc)
+	{
+		auto item = std::make_unique<TestItem>();
+		auto& stats = item->Stats;
+		stats.InstanceId = nextInstanceId_++;
+		stats.ItemType = Chance(0.97) ? EquipmentStatsType::Weapon : EquipmentStatsType::Shield;
+		stats.WeaponType = Chance(0.05) ? (WeaponType)Int(0, (int)WeaponType::Sentinel) : (WeaponType)Int(1, (int)WeaponType::Wand);
+		stats.IsTwoHanded = Chance(0.3);
+		stats.IsDefaultWeapon = Chance(0.1);
+
+		auto numStats = Int(1, 3);
+		for (int i = 0; i < numStats; i++) {
+			ItemStats stat;
+			if (Chance(i == 0 ? 0.98 : 0.9)) {
+				stat.StatsType = EquipmentStatsType::Weapon;
+				stat.DamageType = RandomDamageType();
+				stat.MinDamage = Int(0, 100);
+				stat.MaxDamage = stat.MinDamage + (Chance(0.05) ? Int(-10, 0) : Int(0, 60));
+				stat.DamageBoost = Int(-10, 50);
+				stat.DamageFromBase = (i == 0 && Chance(0.7)) ? 100 : Int(0, 150);
+				stat.CriticalDamage = Int(100, 200);
+			} else {
+				stat.StatsType = Chance(0.5) ? EquipmentStatsType::Armor : EquipmentStatsType::Shield;
+				stat.ArmorValue = Int(0, 300);
+				stat.ArmorBoost = Int(0, 50);
+			}
+			stats.DynamicStats.push_back(stat);
+		}
+
+		GenerateRequirements(*item);
+		item->LoseDurabilityOnCharacterHit = Chance(0.5);
+		item->Unbreakable = Chance(0.2);
+		item->Durability = Int(-5, 100);
+		stats.Context = item.get();
+		tc.Items.push_back(std::move(item));
+		return tc.Items.back().get();
+	}
+
+	TestItem* GenerateShield(TestCase& tc)
+	{
+		auto item = std::make_unique<TestItem>();
+		auto& stats = item->Stats;
+		stats.InstanceId = nextInstanceId_++;
+		stats.ItemType = Chance(0.9) ? EquipmentStatsType::Shield : EquipmentStatsType::Armor;
+
+		auto numStats = Int(1, 2);
+		for (int i = 0; i < numStats; i++) {
+			ItemStats stat;
+			stat.StatsType = Chance(0.8) ? EquipmentStatsType::Shield : EquipmentStatsType::Armor;
+			stat.ArmorValue = Int(0, 300);
+			stat.ArmorBoost = Int(0, 50);
+			stats.DynamicStats.push_back(stat);
+		}
+
+		GenerateRequirements(*item);
+		item->Durability = Int(0, 100);
+		stats.Context = item.get();
+		tc.Items.push_back(std::move(item));
+		return tc.Items.back().get();
+	}
+
+	void GenerateRequirements(TestItem& item)
+	{
+		RequirementType const types[] = {
+			RequirementType::Level, RequirementType::Strength, RequirementType::Finesse,
+			RequirementType::Intelligence, RequirementType::Constitution, RequirementType::Memory,
+			RequirementType::Wits
+		};
+
+		auto numRequirements = Int(0, 3);
+		for (int i = 0; i < numRequirements; i++) {
+			Requirement req;
+			req.Not = Chance(0.2);
+			if (Chance(0.015)) {
+				req.Type = RequirementType::Tag;
+				item.TagParams.push_back("REQ_TAG_" + std::to_string(i));
+			} else {
+				req.Type = types[Int(0, (int)std::size(types) - 1)];
+				req.Param = Int(0, 20);
+				item.TagParams.push_back("");
+			}
+			item.Stats.Requirements.push_back(req);
+		}
+	}
+
+	std::unique_ptr<TestCharacter> GenerateCharacter(TestCase& tc)
+	{
+		auto ch = std::make_unique<TestCharacter>();
+		auto set = [&ch](CharacterStat stat, int32_t value) {
+			ch->Stats[(unsigned)stat] = value;
+		};
+
+		set(CharacterStat::Level, Chance(0.05) ? Int(-2, 0) : Int(1, 25));
+		for (auto stat = (int)CharacterStat::Strength; stat <= (int)CharacterStat::Wits; stat++) {
+			set((CharacterStat)stat, Int(5, 40));
+		}
+		for (auto stat = (int)CharacterStat::WarriorLore; stat <= (int)CharacterStat::EarthSpecialist; stat++) {
+			set((CharacterStat)stat, Chance(0.5) ? 0 : Int(0, 10));
+		}
+		for (auto stat = (int)CharacterStat::PhysicalResistance; stat <= (int)CharacterStat::ShadowResistance; stat++) {
+			set((CharacterStat)stat, Chance(0.5) ? 0 : Int(-50, 150));
+		}
+		set(CharacterStat::DamageBoost, Int(-20, 100));
+		set(CharacterStat::CriticalChance, Int(0, 100));
+		set(CharacterStat::Accuracy, Int(50, 150));
+		set(CharacterStat::Dodge, Int(0, 60));
+		set(CharacterStat::ChanceToHitBoost, Int(-10, 30));
+		set(CharacterStat::BlockChance, Chance(0.7) ? 0 : Int(0, 50));
+		set(CharacterStat::LifeSteal, Chance(0.6) ? 0 : Int(0, 50));
+		for (auto stat = (int)CharacterStat::MaxVitality; stat <= (int)CharacterStat::MaxMagicArmor; stat++) {
+			auto max = Int(0, 5000);
+			set((CharacterStat)stat, max);
+			set((CharacterStat)(stat + 3), Int(0, max));
+		}
+		set(CharacterStat::IsIncapacitatedRefCount, Chance(0.85) ? 0 : 1);
+
+		if (Chance(0.03)) {
+			ch->Stats[Int(0, NumCharacterStats - 1)].reset();
+		}
+
+		for (auto& talent : ch->TalentFlags) {
+			talent = Chance(0.2);
+		}
+		for (auto& flag : ch->Flags) {
+			flag = Chance(0.3);
+		}
+
+		if (Chance(0.95)) ch->MainWeapon = GenerateWeapon(tc);
+		if (Chance(0.3)) ch->OffHandWeapon = GenerateWeapon(tc);
+		if (Chance(0.25)) ch->Shield = GenerateShield(tc);
+
+		ch->HasPosition = Chance(0.98);
+		RandomPosition(ch->Position);
+		auto yaw = Real(-M_PI, M_PI);
+		double const rotation[9] = { cos(yaw), 0.0, -sin(yaw), 0.0, 1.0, 0.0, sin(yaw), 0.0, cos(yaw) };
+		std::copy(rotation, rotation + 9, ch->Rotation);
+		return ch;
+	}
+};
+
+
+// Lua representation of the test inputs, shaped like the extender's stat proxies
+int PushRef(lua_State* L)
+{
+	lua_pushvalue(L, -1);
+	return luaL_ref(L, LUA_REGISTRYINDEX);
+}
+
+void SetField(lua_State* L, char const* key, lua_Integer value)
+{
+	lua_pushinteger(L, value);
+	lua_setfield(L, -2, key);
+}
+
+void SetField(lua_State* L, char const* key, char const* value)
+{
+	lua_pushstring(L, value);
+	lua_setfield(L, -2, key);
+}
+
+void SetBoolField(lua_State* L, char const* key, bool value)
+{
+	lua_pushboolean(L, value ? 1 : 0);
+	lua_setfield(L, -2, key);
+}
+
+void PushVector(lua_State* L, double const* values, int count)
+{
+	lua_newtable(L);
+	for (int i = 0; i < count; i++) {
+		lua_pushnumber(L, values[i]);
+		lua_rawseti(L, -2, i + 1);
+	}
+}
+
+void PushItem(lua_State* L, TestItem& item)
+{
+	if (item.LuaRef != LUA_NOREF) {
+		lua_rawgeti(L, LUA_REGISTRYINDEX, item.LuaRef);
+		return;
+	}
+
+	auto const& stats = item.Stats;
+	lua_newtable(L);
+	SetField(L, "InstanceId", stats.InstanceId);
+	SetField(L, "ItemType", EquipmentStatsTypeNames[(unsigned)stats.ItemType]);
+	SetField(L, "WeaponType", WeaponTypeNames[(unsigned)stats.WeaponType]);
+	SetBoolField(L, "IsTwoHanded", stats.IsTwoHanded);
+	SetField(L, "Name", stats.IsDefaultWeapon ? "DefaultWeapon" : "WPN_Test");
+	SetBoolField(L, "LoseDurabilityOnCharacterHit", item.LoseDurabilityOnCharacterHit);
+	SetBoolField(L, "Unbreakable", item.Unbreakable);
+	SetField(L, "Durability", item.Durability);
+
+	lua_newtable(L);
+	for (size_t i = 0; i < stats.DynamicStats.size(); i++) {
+		auto const& stat = stats.DynamicStats[i];
+		lua_newtable(L);
+		SetField(L, "StatsType", EquipmentStatsTypeNames[(unsigned)stat.StatsType]);
+		SetField(L, "DurabilityDegradeSpeed", (lua_Integer)(i % 2));
+		if (stat.StatsType == EquipmentStatsType::Weapon) {
+			SetField(L, "DamageType", DamageTypeNames[(unsigned)stat.DamageType]);
+			SetField(L, "MinDamage", stat.MinDamage);
+			SetField(L, "MaxDamage", stat.MaxDamage);
+			SetField(L, "DamageBoost", stat.DamageBoost);
+			SetField(L, "DamageFromBase", stat.DamageFromBase);
+			SetField(L, "CriticalDamage", stat.CriticalDamage);
+		} else {
+			SetField(L, "ArmorValue", stat.ArmorValue);
+			SetField(L, "ArmorBoost", stat.ArmorBoost);
+		}
+		lua_rawseti(L, -2, (lua_Integer)i + 1);
+	}
+	lua_setfield(L, -2, "DynamicStats");
+
+	lua_newtable(L);
+	for (size_t i = 0; i < stats.Requirements.size(); i++) {
+		auto const& req = stats.Requirements[i];
+		lua_newtable(L);
+		SetField(L, "Requirement", RequirementName(req.Type));
+		if (req.Type == RequirementType::Tag) {
+			SetField(L, "Param", item.TagParams[i].c_str());
+		} else {
+			SetField(L, "Param", req.Param);
+		}
+		SetBoolField(L, "Not", req.Not);
+		lua_rawseti(L, -2, (lua_Integer)i + 1);
+	}
+	lua_setfield(L, -2, "Requirements");
+
+	item.LuaRef = PushRef(L);
+}
+
+void PushCharacter(lua_State* L, TestCharacter& ch)
+{
+	if (ch.LuaRef != LUA_NOREF) {
+		lua_rawgeti(L, LUA_REGISTRYINDEX, ch.LuaRef);
+		return;
+	}
+
+	lua_newtable(L);
+	for (unsigned i = 0; i < NumCharacterStats; i++) {
+		if (ch.Stats[i]) {
+			SetField(L, CharacterStatNames[i], *ch.Stats[i]);
+		}
+	}
+
+	for (size_t i = 0; i < std::size(Talents); i++) {
+		SetBoolField(L, Talents[i].Name, ch.TalentFlags[i]);
+	}
+
+	for (size_t i = 0; i < std::size(CharacterFlagNames); i++) {
+		SetBoolField(L, CharacterFlagNames[i], ch.Flags[i]);
+	}
+
+	if (ch.MainWeapon) {
+		PushItem(L, *ch.MainWeapon);
+		lua_setfield(L, -2, "MainWeapon");
+	}
+
+	if (ch.OffHandWeapon) {
+		PushItem(L, *ch.OffHandWeapon);
+		lua_setfield(L, -2, "OffHandWeapon");
+	}
+
+	if (ch.Shield) {
+		PushItem(L, *ch.Shield);
+		lua_setfield(L, -2, "_Shield");
+	}
+
+	lua_getglobal(L, "MockGetItemBySlot");
+	lua_setfield(L, -2, "GetItemBySlot");
+
+	if (ch.HasPosition) {
+		PushVector(L, ch.Position, 3);
+		lua_setfield(L, -2, "Position");
+		PushVector(L, ch.Rotation, 9);
+		lua_setfield(L, -2, "Rotation");
+	}
+
+	ch.LuaRef = PushRef(L);
+}
+
+void PushSkill(lua_State* L, TestCase& tc)
+{
+	if (tc.SkillRef != LUA_NOREF) {
+		lua_rawgeti(L, LUA_REGISTRYINDEX, tc.SkillRef);
+		return;
+	}
+
+	auto const& skill = tc.SkillData;
+	lua_newtable(L);
+	SetField(L, "Damage Multiplier", skill.DamageMultiplier);
+	SetField(L, "Stealth Damage Multiplier", skill.StealthDamageMultiplier);
+	SetField(L, "Distance Damage Multiplier", skill.DistanceDamageMultiplier);
+	SetField(L, "Damage Range", skill.DamageRange);
+	SetField(L, "Level", skill.Level);
+	SetField(L, "UseWeaponDamage", skill.UseWeaponDamage ? "Yes" : "No");
+	SetField(L, "OverrideSkillLevel", skill.OverrideSkillLevel ? "Yes" : "No");
+	SetField(L, "Ability", SkillAbilityNames[(unsigned)skill.Ability]);
+	SetField(L, "DamageType", DamageTypeNames[(unsigned)skill.DamageType]);
+	SetField(L, "Damage", DamageSourceNames[(unsigned)skill.Damage]);
+	SetField(L, "DeathType", DeathTypeNames[(unsigned)skill.DeathType]);
+	tc.SkillRef = PushRef(L);
+}
+
+void PushDamageList(lua_State* L, DamageList const& damages)
+{
+	NewLuaDamageList(L)->List = damages;
+}
+
+void PushHit(lua_State* L, Hit const& hit)
+{
+	lua_newtable(L);
+	SetField(L, "EffectFlags", hit.EffectFlags);
+	SetField(L, "TotalDamageDone", hit.TotalDamageDone);
+	SetField(L, "ArmorAbsorption", hit.ArmorAbsorption);
+	SetField(L, "LifeSteal", hit.LifeSteal);
+	SetField(L, "DamageType", DamageTypeNames[(unsigned)hit.DamageType]);
+	PushDamageList(L, hit.DamageList);
+	lua_setfield(L, -2, "DamageList");
+}
+
+void SetExtraData(lua_State* L, ExtraData const& extra)
+{
+	lua_getglobal(L, "Ext");
+	lua_getfield(L, -1, "ExtraData");
+	for (auto const& value : ExtraDataDefaults) {
+		lua_pushnumber(L, extra.*value.Field);
+		lua_setfield(L, -2, value.Key);
+	}
+	lua_pop(L, 2);
+}
+
+void ReleaseRefs(lua_State* L, TestCase& tc)
+{
+	for (auto& item : tc.Items) {
+		luaL_unref(L, LUA_REGISTRYINDEX, item->LuaRef);
+		item->LuaRef = LUA_NOREF;
+	}
+	for (auto ch : { tc.Attacker.get(), tc.Target.get() }) {
+		luaL_unref(L, LUA_REGISTRYINDEX, ch->LuaRef);
+		ch->LuaRef = LUA_NOREF;
+	}
+	luaL_unref(L, LUA_REGISTRYINDEX, tc.SkillRef);
+	tc.SkillRef = LUA_NOREF;
+}
+
+void PushGameMathFunction(lua_State* L, char const* name)
+{
+	lua_getglobal(L, "Game");
+	lua_getfield(L, -1, "Math");
+	lua_getfield(L, -1, name);
+	lua_remove(L, -2);
+	lua_remove(L, -2);
+}
+
+
+// Comparison of the Lua and native results
+struct FunctionStats
+{
+	char const* Name;
+	unsigned Runs{ 0 };
+	unsigned Errors{ 0 };
+	unsigned Mismatches{ 0 };
+};
+
+enum TestedFunction
+{
+	FnGetSkillDamage,
+	FnCalculateWeaponDamage,
+	FnGetSkillDamageRange,
+	FnCalculateHitChance,
+	FnComputeCharacterHit,
+	NumTestedFunctions
+};
+
+static FunctionStats gStats[NumTestedFunctions] = {
+	{ "GetSkillDamage" }, { "CalculateWeaponDamage" }, { "GetSkillDamageRange" },
+	{ "CalculateHitChance" }, { "ComputeCharacterHit" }
+};
+
+static unsigned gReportedMismatches = 0;
+
+void Mismatch(TestedFunction fn, unsigned caseIndex, std::string const& what)
+{
+	gStats[fn].Mismatches++;
+	if (gReportedMismatches++ < 20) {
+		printf("MISMATCH case %u, %s: %s\n", caseIndex, gStats[fn].Name, what.c_str());
+	}
+}
+
+std::string Describe(DamageList const& damages)
+{
+	std::string desc = "[";
+	for (auto const& dmg : damages.Damages) {
+		if (desc.size() > 1) desc += ", ";
+		desc += DamageTypeNames[(unsigned)dmg.Type];
+		desc += "=" + std::to_string(dmg.Amount);
+	}
+	return desc + "]";
+}
+
+bool SameDamages(DamageList const& a, DamageList const& b)
+{
+	if (a.Damages.size() != b.Damages.size()) return false;
+	for (size_t i = 0; i < a.Damages.size(); i++) {
+		if (a.Damages[i].Type != b.Damages[i].Type || a.Damages[i].Amount != b.Damages[i].Amount) return false;
+	}
+	return true;
+}
+
+bool SameBits(double a, double b)
+{
+	return memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+// Compares a Lua number with a native result, including its integer/float subtype
+bool SameNumber(lua_State* L, int index, Number const& number)
+{
+	if (lua_type(L, index) != LUA_TNUMBER) return false;
+	if ((lua_isinteger(L, index) != 0) != number.Integer) return false;
+	if (number.Integer) {
+		return lua_tointeger(L, index) == (lua_Integer)number.Value;
+	} else {
+		return SameBits(lua_tonumber(L, index), number.Value);
+	}
+}
+
+std::string DescribeLua(lua_State* L, int index)
+{
+	if (lua_isinteger(L, index)) return std::to_string(lua_tointeger(L, index));
+	if (lua_type(L, index) == LUA_TNUMBER) {
+		char buf[64];
+		snprintf(buf, sizeof(buf), "%.17g (float)", lua_tonumber(L, index));
+		return buf;
+	}
+	auto str = luaL_tolstring(L, index, nullptr);
+	std::string desc = str ? str : "?";
+	lua_pop(L, 1);
+	return desc;
+}
+
+std::string DescribeNumber(Number const& number)
+{
+	char buf[64];
+	if (number.Integer) {
+		snprintf(buf, sizeof(buf), "%lld", (long long)number.Value);
+	} else {
+		snprintf(buf, sizeof(buf), "%.17g (float)", number.Value);
+	}
+	return buf;
+}
+
+// Integer hit field written by the Lua code; the game reads these back as integers
+bool SameHitField(lua_State* L, int hitIndex, char const* field, int64_t value, std::string& desc)
+{
+	lua_getfield(L, hitIndex, field);
+	auto same = lua_type(L, -1) == LUA_TNUMBER && lua_tonumber(L, -1) == (double)value;
+	if (!same) {
+		desc = std::string(field) + ": Lua " + DescribeLua(L, -1) + ", native " + std::to_string(value);
+	}
+	lua_pop(L, 1);
+	return same;
+}
+
+// Runs the Lua function on the arguments on the stack, leaving its results on the stack.
+// Returns false if it raised an error.
+bool RunLua(lua_State* L, int nargs, int& nresults, std::string& error)
+{
+	auto ok = lua_pcall(L, nargs, LUA_MULTRET, 0) == LUA_OK;
+	nresults = lua_gettop(L);
+	if (!ok) {
+		error = lua_tostring(L, -1) ? lua_tostring(L, -1) : "(error)";
+	}
+	return ok;
+}
+
+void RunCase(lua_State* L, TestCase& tc, unsigned caseIndex, uint64_t seed)
+{
+	SetExtraData(L, tc.Extra);
+	TestEnvironment env(L);
+	auto& attacker = *tc.Attacker;
+	auto& target = *tc.Target;
+	std::mt19937_64 luaRng;
+	int nresults;
+	std::string error;
+
+	auto checkError = [&](TestedFunction fn, bool luaOk, bool nativeOk) {
+		gStats[fn].Runs++;
+		if (!luaOk) gStats[fn].Errors++;
+		if (luaOk != nativeOk) {
+			Mismatch(fn, caseIndex, luaOk ? "native failed, Lua succeeded" : "Lua raised '" + error + "', native succeeded");
+			return false;
+		}
+		if (luaOk && !(gFormulaRng == luaRng)) {
+			Mismatch(fn, caseIndex, "different random draws");
+			return false;
+		}
+		return luaOk;
+	};
+
+	// GetSkillDamage
+	{
+		lua_settop(L, 0);
+		gFormulaRng.seed(seed);
+		PushGameMathFunction(L, "GetSkillDamage");
+		PushSkill(L, tc);
+		if (tc.HasAttacker) {
+			PushCharacter(L, attacker);
+		} else {
+			lua_pushnil(L);
+		}
+		lua_pushboolean(L, tc.IsFromItem);
+		lua_pushboolean(L, tc.Stealthed);
+		PushVector(L, tc.AttackerPos, 3);
+		PushVector(L, tc.TargetPos, 3);
+		lua_pushinteger(L, tc.Level);
+		lua_pushboolean(L, tc.NoRandomization);
+		auto luaOk = RunLua(L, 8, nresults, error);
+		luaRng = gFormulaRng;
+
+		gFormulaRng.seed(seed);
+		std::optional<SkillDamage> result;
+		auto nativeOk = GetSkillDamage(env, tc.Extra, tc.SkillData, tc.HasAttacker ? &attacker : nullptr,
+			tc.IsFromItem, tc.Stealthed, tc.AttackerPos, tc.TargetPos, tc.Level, tc.NoRandomization, result);
+
+		if (checkError(FnGetSkillDamage, luaOk, nativeOk)) {
+			if (nresults == 0 || !result) {
+				if ((nresults == 0) != !result) {
+					Mismatch(FnGetSkillDamage, caseIndex, "returned nothing on one side only");
+				}
+			} else {
+				auto list = reinterpret_cast<LuaDamageList*>(luaL_testudata(L, 1, DamageListMetatable));
+				if (list == nullptr || !SameDamages(list->List, result->Damage)) {
+					Mismatch(FnGetSkillDamage, caseIndex, "damage Lua " + (list ? Describe(list->List) : std::string("?"))
+						+ ", native " + Describe(result->Damage));
+				}
+
+				auto luaDeath = lua_isnil(L, 2) ? std::string("nil") : DescribeLua(L, 2);
+				auto nativeDeath = result->Death ? std::string(DeathTypeNames[(unsigned)*result->Death]) : std::string("nil");
+				if (luaDeath != nativeDeath) {
+					Mismatch(FnGetSkillDamage, caseIndex, "death type Lua " + luaDeath + ", native " + nativeDeath);
+				}
+			}
+		}
+	}
+
+	// CalculateWeaponDamage
+	{
+		lua_settop(L, 0);
+		gFormulaRng.seed(seed + 1);
+		PushGameMathFunction(L, "CalculateWeaponDamage");
+		PushCharacter(L, attacker);
+		PushItem(L, *tc.Weapon);
+		lua_pushboolean(L, tc.NoRandomization);
+		auto luaOk = RunLua(L, 3, nresults, error);
+		luaRng = gFormulaRng;
+
+		gFormulaRng.seed(seed + 1);
+		DamageList damages;
+		auto nativeOk = CalculateWeaponDamage(env, tc.Extra, attacker, tc.Weapon->Stats, tc.NoRandomization, damages);
+
+		if (checkError(FnCalculateWeaponDamage, luaOk, nativeOk)) {
+			auto list = reinterpret_cast<LuaDamageList*>(luaL_testudata(L, 1, DamageListMetatable));
+			if (list == nullptr || !SameDamages(list->List, damages)) {
+				Mismatch(FnCalculateWeaponDamage, caseIndex, "damage Lua " + (list ? Describe(list->List) : std::string("?"))
+					+ ", native " + Describe(damages));
+			}
+		}
+	}
+
+	// GetSkillDamageRange
+	{
+		lua_settop(L, 0);
+		gFormulaRng.seed(seed + 2);
+		PushGameMathFunction(L, "GetSkillDamageRange");
+		PushCharacter(L, attacker);
+		PushSkill(L, tc);
+		auto luaOk = RunLua(L, 2, nresults, error);
+		luaRng = gFormulaRng;
+
+		gFormulaRng.seed(seed + 2);
+		std::vector<DamageRange> ranges;
+		auto nativeOk = GetSkillDamageRange(tc.Extra, attacker, tc.SkillData, ranges);
+
+		if (checkError(FnGetSkillDamageRange, luaOk, nativeOk)) {
+			unsigned luaCount = 0;
+			if (lua_istable(L, 1)) {
+				lua_pushnil(L);
+				while (lua_next(L, 1)) {
+					luaCount++;
+					lua_pop(L, 1);
+				}
+			}
+
+			if (luaCount != ranges.size()) {
+				Mismatch(FnGetSkillDamageRange, caseIndex, "Lua returned " + std::to_string(luaCount)
+					+ " ranges, native " + std::to_string(ranges.size()));
+			}
+
+			for (auto const& range : ranges) {
+				auto label = DamageTypeNames[(unsigned)range.Type];
+				lua_getfield(L, 1, label);
+				if (!lua_istable(L, -1)) {
+					Mismatch(FnGetSkillDamageRange, caseIndex, std::string("no Lua range for ") + label);
+				} else {
+					lua_rawgeti(L, -1, 1);
+					lua_rawgeti(L, -2, 2);
+					if (!SameNumber(L, -2, range.Min) || !SameNumber(L, -1, range.Max)) {
+						Mismatch(FnGetSkillDamageRange, caseIndex, std::string(label) + " Lua "
+							+ DescribeLua(L, -2) + " - " + DescribeLua(L, -1) + ", native "
+							+ DescribeNumber(range.Min) + " - " + DescribeNumber(range.Max));
+					}
+					lua_pop(L, 2);
+				}
+				lua_pop(L, 1);
+			}
+		}
+	}
+
+	// CalculateHitChance
+	{
+		lua_settop(L, 0);
+		gFormulaRng.seed(seed + 3);
+		PushGameMathFunction(L, "CalculateHitChance");
+		PushCharacter(L, attacker);
+		PushCharacter(L, target);
+		auto luaOk = RunLua(L, 2, nresults, error);
+		luaRng = gFormulaRng;
+
+		gFormulaRng.seed(seed + 3);
+		Number hitChance{ 0.0, false };
+		auto nativeOk = CalculateHitChance(tc.Extra, attacker, target, hitChance);
+
+		if (checkError(FnCalculateHitChance, luaOk, nativeOk) && !SameNumber(L, 1, hitChance)) {
+			Mismatch(FnCalculateHitChance, caseIndex, "Lua " + DescribeLua(L, 1) + ", native " + DescribeNumber(hitChance));
+		}
+	}
+
+	// ComputeCharacterHit
+	{
+		lua_settop(L, 0);
+		gFormulaRng.seed(seed + 4);
+		PushGameMathFunction(L, "ComputeCharacterHit");
+		PushCharacter(L, target);
+		if (tc.HasAttacker) {
+			PushCharacter(L, attacker);
+		} else {
+			lua_pushnil(L);
+		}
+		if (tc.HitWeapon) {
+			PushItem(L, *tc.HitWeapon);
+		} else {
+			lua_pushnil(L);
+		}
+		PushDamageList(L, tc.Damages);
+		auto luaDamages = reinterpret_cast<LuaDamageList*>(lua_touserdata(L, -1));
+		lua_pushvalue(L, -1);
+		lua_insert(L, 1);
+		lua_pushstring(L, HitTypeNames[(unsigned)tc.Type]);
+		lua_pushboolean(L, tc.NoHitRoll);
+		lua_pushboolean(L, tc.ForceReduceDurability);
+		PushHit(L, tc.HitData);
+		lua_pushvalue(L, -1);
+		lua_insert(L, 2);
+		lua_pushboolean(L, tc.AlwaysBackstab);
+		lua_pushstring(L, HighGroundNames[(unsigned)tc.HighGround]);
+		lua_pushstring(L, CriticalRollNames[(unsigned)tc.CritRoll]);
+		auto luaOk = lua_pcall(L, 11, 0, 0) == LUA_OK;
+		if (!luaOk) {
+			error = lua_tostring(L, -1) ? lua_tostring(L, -1) : "(error)";
+		}
+		luaRng = gFormulaRng;
+
+		gFormulaRng.seed(seed + 4);
+		auto damages = tc.Damages;
+		auto hit = tc.HitData;
+		auto nativeOk = ComputeCharacterHit(env, tc.Extra, target, tc.HasAttacker ? &attacker : nullptr,
+			tc.HitWeapon ? &tc.HitWeapon->Stats : nullptr, damages, tc.Type, tc.NoHitRoll,
+			tc.ForceReduceDurability, hit, tc.AlwaysBackstab, tc.HighGround, tc.CritRoll);
+
+		if (checkError(FnComputeCharacterHit, luaOk, nativeOk)) {
+			std::string desc;
+			if (!SameHitField(L, 2, "EffectFlags", hit.EffectFlags, desc)
+				|| !SameHitField(L, 2, "TotalDamageDone", hit.TotalDamageDone, desc)
+				|| !SameHitField(L, 2, "ArmorAbsorption", hit.ArmorAbsorption, desc)
+				|| !SameHitField(L, 2, "LifeSteal", hit.LifeSteal, desc)) {
+				Mismatch(FnComputeCharacterHit, caseIndex, desc);
+			}
+
+			lua_getfield(L, 2, "DamageMultiplier");
+			if (!SameBits(lua_tonumber(L, -1), hit.DamageMultiplier)) {
+				Mismatch(FnComputeCharacterHit, caseIndex, "DamageMultiplier: Lua " + DescribeLua(L, -1)
+					+ ", native " + DescribeNumber({ hit.DamageMultiplier, false }));
+			}
+			lua_pop(L, 1);
+
+			lua_getfield(L, 2, "DamageList");
+			auto hitList = reinterpret_cast<LuaDamageList*>(luaL_testudata(L, -1, DamageListMetatable));
+			if (hitList == nullptr || !SameDamages(hitList->List, hit.DamageList)) {
+				Mismatch(FnComputeCharacterHit, caseIndex, "hit damage Lua " + (hitList ? Describe(hitList->List) : std::string("?"))
+					+ ", native " + Describe(hit.DamageList));
+			}
+			lua_pop(L, 1);
+
+			if (!SameDamages(luaDamages->List, damages)) {
+				Mismatch(FnComputeCharacterHit, caseIndex, "damage list Lua " + Describe(luaDamages->List)
+					+ ", native " + Describe(damages));
+			}
+		}
+	}
+
+	lua_settop(L, 0);
+	ReleaseRefs(L, tc);
+}
+
+
+bool LoadGameMath(lua_State* L, std::string const& source)
+{
+	if (luaL_loadbufferx(L, source.c_str(), source.size(), "=Game.Math.lua", "t") != LUA_OK
+		|| lua_pcall(L, 0, 0, 0) != LUA_OK) {
+		printf("Failed to load Game.Math.lua: %s\n", lua_tostring(L, -1));
+		return false;
+	}
+
+	return true;
+}
+
+lua_State* NewTestState(std::string const& gameMathSource, char const* prelude)
+{
+	auto L = luaL_newstate();
+	luaL_openlibs(L);
+	RegisterMockExt(L);
+	if (luaL_dostring(L, MockScript) != LUA_OK
+		|| (prelude != nullptr && luaL_dostring(L, prelude) != LUA_OK)) {
+		printf("Failed to run test script: %s\n", lua_tostring(L, -1));
+		lua_close(L);
+		return nullptr;
+	}
+
+	if (!LoadGameMath(L, gameMathSource)) {
+		lua_close(L);
+		return nullptr;
+	}
+
+	return L;
+}
+
+
+// Checks the Ext._GameMath dispatch of Game.Math.lua with a stub native table
+static char const* const DispatchStub = R"(
+StubMode = "handle"
+StubCalls = {}
+
+local function Stub(name)
+	StubCalls[name] = 0
+	return function (...)
+		StubCalls[name] = StubCalls[name] + 1
+		if StubMode == "decline" then
+			return false
+		elseif StubMode == "nothing" then
+			return true
+		else
+			return true, "native", select('#', ...)
+		end
+	end
+end
+
+StubCalls.ComputeCharacterHit = 0
+Ext._GameMath = {
+	GetSkillDamage = Stub("GetSkillDamage"),
+	CalculateWeaponDamage = Stub("CalculateWeaponDamage"),
+	GetSkillDamageRange = Stub("GetSkillDamageRange"),
+	CalculateHitChance = Stub("CalculateHitChance"),
+	ComputeCharacterHit = function (random, durabilityCallback, ...)
+		StubCalls.ComputeCharacterHit = StubCalls.ComputeCharacterHit + 1
+		if StubMode == "decline" then
+			return false
+		end
+		assert(random == math.random and durabilityCallback == Game.Math.ConditionalDamageItemDurability)
+		local hit = select(8, ...)
+		hit.Native = true
+		return true
+	end
+}
+)";
+
+static char const* const DispatchTest = R"lua(
+local M = Game.Math
+local haymaker = { TALENT_Haymaker = true }
+
+-- Calls the formula and checks whether the native stub handled it; Lua errors
+-- from the placeholder arguments are ignored
+local function Expect(native, name, ...)
+	local calls = StubCalls[name]
+	local ok, result = pcall(M[name], ...)
+	assert((StubCalls[name] == calls + 1) == native, "unexpected dispatch of " .. name)
+	assert(ok or not native, result)
+	return result
+end
+
+-- Native while pristine, with the arguments passed through
+assert(Expect(true, "CalculateHitChance", haymaker, {}) == "native")
+assert(select(2, M.GetSkillDamage(1, 2, 3, 4, 5, 6, 7, 8)) == 8)
+assert(select('#', M.GetSkillDamage(1, 2, 3, 4, 5, 6, 7, 8)) == 2)
+local hit = {}
+assert(Expect(true, "ComputeCharacterHit", {}, {}, nil, nil, "Melee", false, false, hit, false, "Unknown", "Roll") == hit)
+assert(hit.Native)
+
+-- GetSkillDamage returns nothing when the native code returns no damage list
+StubMode = "nothing"
+assert(select('#', M.GetSkillDamage({}, nil, false, false, {0, 0, 0}, {0, 0, 0}, 1, true)) == 0)
+
+-- Lua runs when the native code declines
+StubMode = "decline"
+assert(Expect(true, "CalculateHitChance", haymaker, {}) == 100)
+StubMode = "handle"
+
+-- Lua runs when a function, table entry or math.random is overridden, native again when restored
+local original = M.IsRangedWeapon
+M.IsRangedWeapon = function () return false end
+assert(Expect(false, "CalculateHitChance", haymaker, {}) == 100)
+M.IsRangedWeapon = original
+assert(Expect(true, "CalculateHitChance", haymaker, {}) == "native")
+
+-- Functions a formula doesn't call don't affect it
+original = M.GetResistance
+M.GetResistance = function () return 0 end
+assert(Expect(true, "CalculateHitChance", haymaker, {}) == "native")
+Expect(false, "ComputeCharacterHit", {}, {}, nil, nil, "Melee", false, false, {}, false, "Unknown", "Roll")
+M.GetResistance = original
+
+local fireBoost = M.DamageBoostTable.Fire
+M.DamageBoostTable.Fire = function () return 1 end
+Expect(false, "CalculateWeaponDamage", {}, {}, true)
+M.DamageBoostTable.Fire = nil
+Expect(false, "CalculateWeaponDamage", {}, {}, true)
+M.DamageBoostTable.Fire = fireBoost
+Expect(true, "CalculateWeaponDamage", {}, {}, true)
+
+-- Damage types missing from the maps count too
+M.DamageBoostTable.Chaos = function () return 1 end
+Expect(false, "GetSkillDamageRange", {}, {})
+M.DamageBoostTable.Chaos = nil
+M.DamageTypeToDeathTypeMap.Magic = "Incinerate"
+Expect(false, "GetSkillDamage", {}, {}, false, false, {0, 0, 0}, {0, 0, 0}, 1, true)
+M.DamageTypeToDeathTypeMap.Magic = nil
+Expect(true, "GetSkillDamage", {}, {}, false, false, {0, 0, 0}, {0, 0, 0}, 1, true)
+
+-- Overrides made with rawset() are detected as well
+local getResistance = rawget(M, "GetResistance")
+assert(type(getResistance) == "function")
+rawset(M, "GetResistance", function () return 0 end)
+Expect(false, "ComputeCharacterHit", {}, {}, nil, nil, "Melee", false, false, {}, false, "Unknown", "Roll")
+rawset(M, "GetResistance", getResistance)
+Expect(true, "ComputeCharacterHit", {}, {}, nil, nil, "Melee", false, false, {}, false, "Unknown", "Roll")
+
+-- The tables keep their entries
+assert(rawget(M.HitFlag, "Hit") == 1 and next(M.DamageBoostTable) ~= nil)
+assert(getmetatable(M) == nil and getmetatable(M.HitFlag) == nil)
+
+local random = math.random
+math.random = function (a, b) return a end
+assert(Expect(false, "CalculateHitChance", haymaker, {}) == 100)
+math.random = random
+
+-- CanBackstab stores its angles in Game.Math; that doesn't count as an override
+M.CanBackstab({ Position = {0, 0, 0}, Rotation = {1, 0, 0, 0, 1, 0, 0, 0, 1} }, { Position = {1, 0, 1} })
+assert(M.angle ~= nil)
+assert(Expect(true, "CalculateHitChance", haymaker, {}) == "native")
+
+-- Replacing any function or table a formula reads, directly or through the functions it
+-- calls (found by scanning the Lua source), must switch that formula to Lua
+local bodies = {}
+for name, body in GameMathSource:gmatch("\nfunction ([%w_]+)(%(.-\nend)") do
+	bodies[name] = body
+end
+
+local function Reads(body, name)
+	return (" " .. body):find("[^%w_.:]" .. name .. "[^%w_]") ~= nil
+end
+
+local formulas = {
+	GetSkillDamage = { {}, {}, false, false, {0, 0, 0}, {0, 0, 0}, 1, true },
+	CalculateWeaponDamage = { {}, {}, true },
+	GetSkillDamageRange = { {}, {} },
+	CalculateHitChance = { haymaker, {} },
+	ComputeCharacterHit = { {}, {}, nil, nil, "Melee", false, false, {}, false, "Unknown", "Roll" }
+}
+
+for formula, args in pairs(formulas) do
+	local reached, pending = {}, { formula }
+	while #pending > 0 do
+		local body = bodies[table.remove(pending)]
+		for name, value in pairs(M) do
+			if not reached[name] and (type(value) == "function" or type(value) == "table") and Reads(body or "", name) then
+				reached[name] = true
+				table.insert(pending, name)
+			end
+		end
+	end
+
+	for name in pairs(reached) do
+		if name ~= formula then
+			local value = rawget(M, name)
+			rawset(M, name, type(value) == "table" and {} or function () error("replaced") end)
+			Expect(false, formula, table.unpack(args))
+			rawset(M, name, value)
+			Expect(true, formula, table.unpack(args))
+		end
+	end
+end
+)lua";
+
+bool RunDispatchTest(std::string const& source)
+{
+	auto L = NewTestState(source, DispatchStub);
+	if (L == nullptr) return false;
+
+	lua_pushlstring(L, source.data(), source.size());
+	lua_setglobal(L, "GameMathSource");
+	bool ok = luaL_dostring(L, DispatchTest) == LUA_OK;
+	if (!ok) {
+		printf("Dispatch test failed: %s\n", lua_tostring(L, -1));
+	}
+
+	lua_close(L);
+	return ok;
+}
+
+
+// Benchmark of the Lua functions and their native counterparts on the same inputs
+double ElapsedNs(Clock::time_point start, size_t calls)
+{
+	return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / calls;
+}
+
+double TimeLua(lua_State* L, char const* driver, char const* fn, int argsRef, int reps, size_t calls)
+{
+	lua_settop(L, 0);
+	lua_getglobal(L, driver);
+	PushGameMathFunction(L, fn);
+	lua_rawgeti(L, LUA_REGISTRYINDEX, argsRef);
+	lua_pushinteger(L, reps);
+	auto start = Clock::now();
+	if (lua_pcall(L, 3, 0, 0) != LUA_OK) {
+		printf("Benchmark of %s failed: %s\n", fn, lua_tostring(L, -1));
+		lua_settop(L, 0);
+		return 0.0;
+	}
+	return ElapsedNs(start, calls * reps);
+}
+
+void PrintBenchmark(char const* fn, size_t calls, double luaNs, double nativeNs)
+{
+	printf("%-24s %8zu %14.0f %14.0f %9.1fx\n", fn, calls, luaNs, nativeNs, nativeNs > 0.0 ? luaNs / nativeNs : 0.0);
+}
+
+void RunBenchmark(lua_State* L, uint64_t seed, unsigned numCases)
+{
+	constexpr int Reps = 20;
+	CaseGenerator generator(seed ^ 0x5bd1e995);
+	std::vector<std::unique_ptr<TestCase>> cases;
+	ExtraData extra;
+	for (auto const& value : ExtraDataDefaults) {
+		extra.*value.Field = value.Value;
+	}
+	SetExtraData(L, extra);
+	TestEnvironment env(L);
+
+	for (unsigned i = 0; i < numCases; i++) {
+		auto tc = generator.Generate();
+		tc->Extra = extra;
+		tc->HasAttacker = true;
+		tc->ForceReduceDurability = false;
+		cases.push_back(std::move(tc));
+	}
+
+	printf("\n%-24s %8s %14s %14s %10s\n", "Function", "Inputs", "Lua ns/call", "Native ns/call", "Speedup");
+
+	// Only inputs that both implementations accept
+	auto makeArgs = [&](auto&& accepts, auto&& pushArgs, std::vector<TestCase*>& accepted) {
+		lua_newtable(L);
+		for (auto& tc : cases) {
+			if (accepts(*tc)) {
+				pushArgs(*tc);
+				lua_rawseti(L, -2, (lua_Integer)accepted.size() + 1);
+				accepted.push_back(tc.get());
+			}
+		}
+		return luaL_ref(L, LUA_REGISTRYINDEX);
+	};
+
+	auto luaAccepts = [&](char const* fn, auto&& pushArgs, int nargs) {
+		auto top = lua_gettop(L);
+		PushGameMathFunction(L, fn);
+		pushArgs();
+		auto ok = lua_pcall(L, nargs, 0, 0) == LUA_OK;
+		lua_settop(L, top);
+		return ok;
+	};
+
+	{
+		std::vector<TestCase*> accepted;
+		auto push = [&](TestCase& tc) {
+			lua_newtable(L);
+			PushSkill(L, tc); lua_rawseti(L, -2, 1);
+			PushCharacter(L, *tc.Attacker); lua_rawseti(L, -2, 2);
+			lua_pushboolean(L, tc.IsFromItem); lua_rawseti(L, -2, 3);
+			lua_pushboolean(L, tc.Stealthed); lua_rawseti(L, -2, 4);
+			PushVector(L, tc.AttackerPos, 3); lua_rawseti(L, -2, 5);
+			PushVector(L, tc.TargetPos, 3); lua_rawseti(L, -2, 6);
+			lua_pushinteger(L, tc.Level); lua_rawseti(L, -2, 7);
+			lua_pushboolean(L, tc.NoRandomization); lua_rawseti(L, -2, 8);
+		};
+		auto args = makeArgs([&](TestCase& tc) {
+			std::optional<SkillDamage> result;
+			return GetSkillDamage(env, extra, tc.SkillData, tc.Attacker.get(), tc.IsFromItem, tc.Stealthed,
+				tc.AttackerPos, tc.TargetPos, tc.Level, tc.NoRandomization, result);
+		}, push, accepted);
+
+		auto luaNs = TimeLua(L, "BenchCall8", "GetSkillDamage", args, Reps, accepted.size());
+		auto start = Clock::now();
+		for (int r = 0; r < Reps; r++) {
+			for (auto tc : accepted) {
+				std::optional<SkillDamage> result;
+				GetSkillDamage(env, extra, tc->SkillData, tc->Attacker.get(), tc->IsFromItem, tc->Stealthed,
+					tc->AttackerPos, tc->TargetPos, tc->Level, tc->NoRandomization, result);
+			}
+		}
+		PrintBenchmark("GetSkillDamage", accepted.size(), luaNs, ElapsedNs(start, accepted.size() * Reps));
+		luaL_unref(L, LUA_REGISTRYINDEX, args);
+	}
+
+	{
+		std::vector<TestCase*> accepted;
+		auto push = [&](TestCase& tc) {
+			lua_newtable(L);
+			PushCharacter(L, *tc.Attacker); lua_rawseti(L, -2, 1);
+			PushItem(L, *tc.Weapon); lua_rawseti(L, -2, 2);
+			lua_pushboolean(L, tc.NoRandomization); lua_rawseti(L, -2, 3);
+		};
+		auto args = makeArgs([&](TestCase& tc) {
+			DamageList damages;
+			return CalculateWeaponDamage(env, extra, *tc.Attacker, tc.Weapon->Stats, tc.NoRandomization, damages);
+		}, push, accepted);
+
+		auto luaNs = TimeLua(L, "BenchCall8", "CalculateWeaponDamage", args, Reps, accepted.size());
+		auto start = Clock::now();
+		for (int r = 0; r < Reps; r++) {
+			for (auto tc : accepted) {
+				DamageList damages;
+				CalculateWeaponDamage(env, extra, *tc->Attacker, tc->Weapon->Stats, tc->NoRandomization, damages);
+			}
+		}
+		PrintBenchmark("CalculateWeaponDamage", accepted.size(), luaNs, ElapsedNs(start, accepted.size() * Reps));
+		luaL_unref(L, LUA_REGISTRYINDEX, args);
+	}
+
+	{
+		std::vector<TestCase*> accepted;
+		auto push = [&](TestCase& tc) {
+			lua_newtable(L);
+			PushCharacter(L, *tc.Attacker); lua_rawseti(L, -2, 1);
+			PushSkill(L, tc); lua_rawseti(L, -2, 2);
+		};
+		auto args = makeArgs([&](TestCase& tc) {
+			std::vector<DamageRange> ranges;
+			return GetSkillDamageRange(extra, *tc.Attacker, tc.SkillData, ranges);
+		}, push, accepted);
+
+		auto luaNs = TimeLua(L, "BenchCall8", "GetSkillDamageRange", args, Reps, accepted.size());
+		auto start = Clock::now();
+		for (int r = 0; r < Reps; r++) {
+			for (auto tc : accepted) {
+				std::vector<DamageRange> ranges;
+				GetSkillDamageRange(extra, *tc->Attacker, tc->SkillData, ranges);
+			}
+		}
+		PrintBenchmark("GetSkillDamageRange", accepted.size(), luaNs, ElapsedNs(start, accepted.size() * Reps));
+		luaL_unref(L, LUA_REGISTRYINDEX, args);
+	}
+
+	{
+		std::vector<TestCase*> accepted;
+		auto push = [&](TestCase& tc) {
+			lua_newtable(L);
+			PushCharacter(L, *tc.Attacker); lua_rawseti(L, -2, 1);
+			PushCharacter(L, *tc.Target); lua_rawseti(L, -2, 2);
+		};
+		auto args = makeArgs([&](TestCase& tc) {
+			Number hitChance;
+			return CalculateHitChance(extra, *tc.Attacker, *tc.Target, hitChance);
+		}, push, accepted);
+
+		auto luaNs = TimeLua(L, "BenchCall8", "CalculateHitChance", args, Reps, accepted.size());
+		auto start = Clock::now();
+		for (int r = 0; r < Reps; r++) {
+			for (auto tc : accepted) {
+				Number hitChance;
+				CalculateHitChance(extra, *tc->Attacker, *tc->Target, hitChance);
+			}
+		}
+		PrintBenchmark("CalculateHitChance", accepted.size(), luaNs, ElapsedNs(start, accepted.size() * Reps));
+		luaL_unref(L, LUA_REGISTRYINDEX, args);
+	}
+
+	{
+		auto pushArgs = [&](TestCase& tc) {
+			PushCharacter(L, *tc.Target);
+			PushCharacter(L, *tc.Attacker);
+			if (tc.HitWeapon) {
+				PushItem(L, *tc.HitWeapon);
+			} else {
+				lua_pushnil(L);
+			}
+			PushDamageList(L, tc.Damages);
+			lua_pushstring(L, HitTypeNames[(unsigned)tc.Type]);
+			lua_pushboolean(L, tc.NoHitRoll);
+			lua_pushboolean(L, false);
+			Hit hit;
+			hit.EffectFlags = tc.HitData.EffectFlags;
+			hit.DamageType = tc.HitData.DamageType;
+			PushHit(L, hit);
+			lua_pushboolean(L, tc.AlwaysBackstab);
+			lua_pushstring(L, HighGroundNames[(unsigned)tc.HighGround]);
+			lua_pushstring(L, CriticalRollNames[(unsigned)tc.CritRoll]);
+		};
+
+		auto computeNative = [&](TestCase& tc) {
+			auto damages = tc.Damages;
+			Hit hit;
+			hit.EffectFlags = tc.HitData.EffectFlags;
+			hit.DamageType = tc.HitData.DamageType;
+			return ComputeCharacterHit(env, extra, *tc.Target, tc.Attacker.get(),
+				tc.HitWeapon ? &tc.HitWeapon->Stats : nullptr, damages, tc.Type, tc.NoHitRoll,
+				false, hit, tc.AlwaysBackstab, tc.HighGround, tc.CritRoll);
+		};
+
+		std::vector<TestCase*> accepted;
+		auto push = [&](TestCase& tc) {
+			lua_newtable(L);
+			PushCharacter(L, *tc.Target); lua_setfield(L, -2, "Target");
+			PushCharacter(L, *tc.Attacker); lua_setfield(L, -2, "Attacker");
+			if (tc.HitWeapon) {
+				PushItem(L, *tc.HitWeapon);
+				lua_setfield(L, -2, "Weapon");
+			}
+			lua_newtable(L);
+			for (size_t i = 0; i < tc.Damages.Damages.size(); i++) {
+				lua_newtable(L);
+				lua_pushstring(L, DamageTypeNames[(unsigned)tc.Damages.Damages[i].Type]);
+				lua_rawseti(L, -2, 1);
+				lua_pushinteger(L, tc.Damages.Damages[i].Amount);
+				lua_rawseti(L, -2, 2);
+				lua_rawseti(L, -2, (lua_Integer)i + 1);
+			}
+			lua_setfield(L, -2, "Damages");
+			SetField(L, "EffectFlags", tc.HitData.EffectFlags);
+			SetField(L, "DamageType", DamageTypeNames[(unsigned)tc.HitData.DamageType]);
+			SetField(L, "HitType", HitTypeNames[(unsigned)tc.Type]);
+			SetBoolField(L, "NoHitRoll", tc.NoHitRoll);
+			SetBoolField(L, "AlwaysBackstab", tc.AlwaysBackstab);
+			SetField(L, "HighGround", HighGroundNames[(unsigned)tc.HighGround]);
+			SetField(L, "CriticalRoll", CriticalRollNames[(unsigned)tc.CritRoll]);
+		};
+		auto args = makeArgs([&](TestCase& tc) {
+			// Whether the critical hit and damage code runs depends on the hit roll; skip inputs
+			// that would fail there (non-weapon stats on the weapon, damage types without
+			// resistances, missing stats)
+			if (tc.Attacker->MainWeapon) {
+				for (auto const& stat : tc.Attacker->MainWeapon->Stats.DynamicStats) {
+					if (stat.StatsType != EquipmentStatsType::Weapon) return false;
+				}
+			}
+
+			for (auto const& dmg : tc.Damages.Damages) {
+				if (dmg.Type == DamageType::Sulfuric || dmg.Type == DamageType::Sentinel) return false;
+			}
+
+			for (auto ch : { tc.Attacker.get(), tc.Target.get() }) {
+				for (auto const& stat : ch->Stats) {
+					if (!stat) return false;
+				}
+			}
+
+			return computeNative(tc) && luaAccepts("ComputeCharacterHit", [&]() { pushArgs(tc); }, 11);
+		}, push, accepted);
+
+		auto luaNs = TimeLua(L, "BenchComputeCharacterHit", "ComputeCharacterHit", args, Reps, accepted.size());
+		auto start = Clock::now();
+		for (int r = 0; r < Reps; r++) {
+			for (auto tc : accepted) {
+				computeNative(*tc);
+			}
+		}
+		PrintBenchmark("ComputeCharacterHit", accepted.size(), luaNs, ElapsedNs(start, accepted.size() * Reps));
+		luaL_unref(L, LUA_REGISTRYINDEX, args);
+	}
+
+	for (auto& tc : cases) {
+		ReleaseRefs(L, *tc);
+	}
+}
+
+// Cost of the override check done by the dispatch wrappers on each call
+void RunDispatchBenchmark(std::string const& source)
+{
+	auto L = NewTestState(source, R"(
+		local function Stub() return true, 0 end
+		Ext._GameMath = {
+			GetSkillDamage = Stub,
+			CalculateWeaponDamage = Stub,
+			GetSkillDamageRange = Stub,
+			CalculateHitChance = Stub,
+			ComputeCharacterHit = Stub
+		}
+	)");
+	if (L == nullptr) return;
+
+	constexpr int Calls = 1000000;
+	luaL_dostring(L, R"(
+		function BenchDispatch(fn, calls)
+			local a, t = {}, {}
+			for i = 1, calls do
+				fn(a, t)
+			end
+		end
+	)");
+
+	auto time = [&](char const* name, bool wrapped) {
+		lua_settop(L, 0);
+		lua_getglobal(L, "BenchDispatch");
+		if (wrapped) {
+			PushGameMathFunction(L, name);
+		} else {
+			lua_getglobal(L, "Ext");
+			lua_getfield(L, -1, "_GameMath");
+			lua_getfield(L, -1, name);
+			lua_remove(L, -2);
+			lua_remove(L, -2);
+		}
+		lua_pushinteger(L, Calls);
+		auto start = Clock::now();
+		lua_pcall(L, 2, 0, 0);
+		return ElapsedNs(start, Calls);
+	};
+
+	printf("\n%-24s %14s %14s %10s\n", "Dispatch wrapper", "Stub ns/call", "Wrapped ns/call", "Overhead");
+	for (auto name : { "GetSkillDamage", "CalculateWeaponDamage", "GetSkillDamageRange", "CalculateHitChance", "ComputeCharacterHit" }) {
+		auto direct = time(name, false);
+		auto wrapped = time(name, true);
+		printf("%-24s %14.0f %14.0f %10.0f\n", name, direct, wrapped, wrapped - direct);
+	}
+
+	lua_close(L);
+}
+
+
+int main(int argc, char** argv)
+{
+	unsigned numCases = argc > 1 ? (unsigned)atoi(argv[1]) : 20000;
+	uint64_t seed = argc > 2 ? (uint64_t)atoll(argv[2]) : 1;
+	std::string path = argc > 3 ? argv[3] : "../../OsiInterface/LuaScripts/Game.Math.lua";
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		printf("Can't open %s\n", path.c_str());
+		return 1;
+	}
+	std::stringstream contents;
+	contents << file.rdbuf();
+	auto source = contents.str();
+
+	auto L = NewTestState(source, nullptr);
+	if (L == nullptr) return 1;
+
+	CaseGenerator generator(seed);
+	for (unsigned i = 0; i < numCases; i++) {
+		auto tc = generator.Generate();
+		RunCase(L, *tc, i, seed * 1000003 + i * 8);
+	}
+
+	printf("%-24s %8s %10s %11s\n", "Function", "Cases", "Lua errors", "Mismatches");
+	unsigned mismatches = 0;
+	for (auto const& stats : gStats) {
+		printf("%-24s %8u %10u %11u\n", stats.Name, stats.Runs, stats.Errors, stats.Mismatches);
+		mismatches += stats.Mismatches;
+	}
+
+	auto dispatchOk = RunDispatchTest(source);
+	RunBenchmark(L, seed, 2000);
+	RunDispatchBenchmark(source);
+	lua_close(L);
+
+	if (mismatches > 0 || !dispatchOk) {
+		return 1;
+	}
+
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,275 @@
+// Multi-producer benchmark and consistency test for the extender log queue (OsiInterface/LogQueue.cpp).
+//
+// Build (Linux):
+//   g++ -O2 -std=c++17 -pthread -I../LuaBinaryMessageTest/shim -I../../OsiInterface LogQueueBenchmark.cpp
+//       ../../OsiInterface/LogQueue.cpp -o LogQueueBenchmark
+//
+// Usage:
+//   LogQueueBenchmark [messages per producer] [log file]
+//
+// Throughput: 1, 4 and 8 producer threads push formatted messages (every 500th one longer than
+// the inline record) into a queue of the same size as DebugConsole's, while a consumer thread
+// drains it and writes batches to the log file, like DebugConsole::LogThread. Reports the time
+// producers (ie. game threads) spend per message, compared with the previous synchronous path
+// (a mutex, one write and one flush per message), in two scenarios:
+//   - burst: each producer pushes up to 1/8 of the queue, then waits until the log thread drained it
+//   - flood: producers push all messages back to back; the log thread can't keep up, so most are dropped
+// Every delivered message is checked for corruption and per-producer ordering, and the drop
+// counter must equal the number of rejected pushes.
+//
+// Rate limit: producers flood one category past the limit; the number of accepted messages must
+// not exceed the limit per one-second window, and other categories must still get through.
+
+#include <stdafx.h>
+#include <LogQueue.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Same as OsiInterface/Utils.h
+enum class DebugMessageType
+{
+	Debug,
+	Info,
+	Osiris,
+	Warning,
+	Error
+};
+
+// Same as DebugConsole::LogQueueSize/LogRateLimit
+static constexpr std::size_t LogQueueSize = 2048;
+static constexpr uint32_t LogRateLimit = 2000;
+
+using Clock = std::chrono::steady_clock;
+
+[[noreturn]] static void Fail(char const* message)
+{
+	fprintf(stderr, "%s\n", message);
+	exit(1);
+}
+
+static std::size_t FormatMessage(std::string& buf, unsigned producer, uint64_t seq)
+{
+	char head[96];
+	auto length = snprintf(head, sizeof(head), "[Osiris] Producer %u message %llu: ", producer, (unsigned long long)seq);
+	buf.assign(head, length);
+	if (seq % 500 == 499) {
+		// Ext.Dump output and Lua tracebacks are longer than the inline record
+		buf.append(LogQueue::MaxInlineLength + 200, 'x');
+	} else {
+		buf += "Character 2d0c1a32-6c4d-4ff6-a2ef-09b7a2e2c3bd entered combat";
+	}
+
+	return buf.size();
+}
+
+// Checks that a delivered message is intact and that each producer's messages arrive in order
+static void CheckMessage(char const* msg, std::size_t length, std::vector<int64_t>& lastSeq, std::string& expected)
+{
+	unsigned producer;
+	unsigned long long seq;
+	if (sscanf(msg, "[Osiris] Producer %u message %llu", &producer, &seq) != 2 || producer >= lastSeq.size()) {
+		Fail("Corrupted log message");
+	}
+
+	if ((int64_t)seq <= lastSeq[producer]) {
+		Fail("Log messages of a producer were reordered");
+	}
+
+	lastSeq[producer] = (int64_t)seq;
+	FormatMessage(expected, producer, seq);
+	if (expected.size() != length || memcmp(expected.data(), msg, length) != 0) {
+		Fail("Corrupted log message");
+	}
+}
+
+struct QueueResult
+{
+	double NsPerMessage;
+	uint64_t Delivered;
+	uint64_t Dropped;
+};
+
+static QueueResult RunQueued(unsigned producers, uint64_t perProducer, uint64_t burst, FILE* file)
+{
+	LogQueue queue(LogQueueSize);
+	std::atomic<unsigned> running{ producers };
+	std::atomic<uint64_t> rejected{ 0 };
+	std::atomic<int64_t> pushNs{ 0 };
+	uint64_t delivered{ 0 }, dropped{ 0 };
+
+	std::thread consumer([&]() {
+		auto record = std::make_unique<LogQueue::Record>();
+		std::vector<int64_t> lastSeq(producers, -1);
+		std::string fileBuf, expected;
+		for (;;) {
+			bool done = running.load() == 0;
+			while (queue.Pop(*record)) {
+				CheckMessage(record->Text(), record->Length, lastSeq, expected);
+				fileBuf.append(record->Text(), record->Length);
+				fileBuf += "\r\n";
+				LogQueue::Release(*record);
+				delivered++;
+			}
+
+			dropped += queue.TakeDroppedCount();
+			if (!fileBuf.empty()) {
+				fwrite(fileBuf.data(), 1, fileBuf.size(), file);
+				fflush(file);
+				fileBuf.clear();
+			}
+
+			if (done) break;
+			std::this_thread::yield();
+		}
+	});
+
+	std::vector<std::thread> threads;
+	for (unsigned p = 0; p < producers; p++) {
+		threads.emplace_back([&, p]() {
+			std::string msg;
+			uint64_t failed{ 0 };
+			Clock::duration busy{ 0 };
+			for (uint64_t i = 0; i < perProducer; ) {
+				auto start = Clock::now();
+				for (auto end = std::min(i + burst, perProducer); i < end; i++) {
+					auto length = FormatMessage(msg, p, i);
+					if (!queue.Push(DebugMessageType::Osiris, msg.data(), length)) {
+						failed++;
+					}
+				}
+
+				busy += Clock::now() - start;
+				while (i < perProducer && !queue.IsEmpty()) {
+					std::this_thread::yield();
+				}
+			}
+
+			rejected += failed;
+			pushNs += std::chrono::duration_cast<std::chrono::nanoseconds>(busy).count();
+			running--;
+		});
+	}
+
+	for (auto& thread : threads) thread.join();
+	consumer.join();
+
+	auto total = producers * perProducer;
+	if (delivered + rejected != total) Fail("Messages were lost");
+	if (dropped != rejected) Fail("Drop counter doesn't match the number of rejected messages");
+
+	return { (double)pushNs / total, delivered, dropped };
+}
+
+static double RunSynchronous(unsigned producers, uint64_t perProducer, FILE* file)
+{
+	std::mutex lock;
+	std::atomic<int64_t> writeNs{ 0 };
+	std::vector<std::thread> threads;
+	for (unsigned p = 0; p < producers; p++) {
+		threads.emplace_back([&, p]() {
+			std::string msg;
+			auto start = Clock::now();
+			for (uint64_t i = 0; i < perProducer; i++) {
+				FormatMessage(msg, p, i);
+				msg += "\r\n";
+				std::lock_guard guard(lock);
+				fwrite(msg.data(), 1, msg.size(), file);
+				fflush(file);
+			}
+
+			writeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+		});
+	}
+
+	for (auto& thread : threads) thread.join();
+	return (double)writeNs / (producers * perProducer);
+}
+
+static void TestRateLimit()
+{
+	constexpr unsigned producers = 4;
+	constexpr uint64_t perProducer = 20000;
+
+	LogQueue queue(1 << 16);
+	queue.SetRateLimit(LogRateLimit);
+
+	std::atomic<uint64_t> accepted{ 0 };
+	auto firstWindow = std::chrono::duration_cast<std::chrono::seconds>(Clock::now().time_since_epoch()).count();
+	std::vector<std::thread> threads;
+	for (unsigned p = 0; p < producers; p++) {
+		threads.emplace_back([&, p]() {
+			std::string msg;
+			uint64_t count{ 0 };
+			for (uint64_t i = 0; i < perProducer; i++) {
+				auto length = FormatMessage(msg, p, i);
+				if (queue.Push(DebugMessageType::Debug, msg.data(), length)) count++;
+			}
+
+			accepted += count;
+		});
+	}
+
+	for (auto& thread : threads) thread.join();
+	auto lastWindow = std::chrono::duration_cast<std::chrono::seconds>(Clock::now().time_since_epoch()).count();
+	auto windows = (uint64_t)(lastWindow - firstWindow + 1);
+
+	// Other categories have their own limit
+	if (!queue.Push(DebugMessageType::Error, "Error", 5)) Fail("Rate limit of one category blocked another");
+
+	auto dropped = queue.TakeDroppedCount();
+	auto total = producers * perProducer;
+	if (accepted + dropped != total) Fail("Drop counter doesn't match the number of rate limited messages");
+	if (accepted > LogRateLimit * windows) Fail("Rate limit exceeded");
+	if (accepted == 0) Fail("Rate limit rejected every message");
+
+	uint64_t popped{ 0 };
+	auto record = std::make_unique<LogQueue::Record>();
+	while (queue.Pop(*record)) {
+		LogQueue::Release(*record);
+		popped++;
+	}
+
+	if (popped != accepted + 1) Fail("Queue doesn't contain the accepted messages");
+
+	printf("Rate limit (%u/s): %llu of %llu Debug messages accepted over %llu window(s), %llu dropped; Error still accepted\n\n",
+		LogRateLimit, (unsigned long long)accepted.load(), (unsigned long long)total,
+		(unsigned long long)windows, (unsigned long long)dropped);
+}
+
+int main(int argc, char** argv)
+{
+	auto perProducer = argc > 1 ? (uint64_t)atoll(argv[1]) : 100000;
+	auto path = argc > 2 ? argv[2] : "LogQueueBenchmark.log";
+
+	auto file = fopen(path, "wb");
+	if (file == nullptr) Fail("Could not open log file");
+
+	printf("%u hardware threads, %llu messages per producer, queue size %zu\n\n",
+		std::thread::hardware_concurrency(), (unsigned long long)perProducer, LogQueueSize);
+
+	TestRateLimit();
+
+	printf("%-8s %-10s %16s %16s %12s %12s\n", "", "producers", "sync ns/msg", "queued ns/msg", "delivered", "dropped");
+	for (unsigned producers : { 1u, 4u, 8u }) {
+		auto sync = RunSynchronous(producers, perProducer, file);
+		auto burst = RunQueued(producers, perProducer, LogQueueSize / 8, file);
+		auto flood = RunQueued(producers, perProducer, perProducer, file);
+		if (burst.Dropped != 0) Fail("Messages were dropped although the queue had room for them");
+
+		printf("%-8s %-10u %16.0f %16.0f %12llu %12llu\n", "burst", producers, sync, burst.NsPerMessage,
+			(unsigned long long)burst.Delivered, (unsigned long long)burst.Dropped);
+		printf("%-8s %-10u %16s %16.0f %12llu %12llu\n", "flood", producers, "", flood.NsPerMessage,
+			(unsigned long long)flood.Delivered, (unsigned long long)flood.Dropped);
+	}
+
+	fclose(file);
+	remove(path);
+	return 0;
+}
@@ -0,0 +1,269 @@
+// Round-trip fuzz test and JSON comparison for binary Lua network messages
+// (OsiInterface/Lua/LuaBinaryMessage.cpp).
+//
+// Build (Linux, Lua compiled as C++ like LuaLib):
+//   g++ -O2 -std=c++17 -Ishim -I../../External/lua-5.3.5/src -I../../OsiInterface LuaBinaryMessageTest.cpp
+//       ../../OsiInterface/Lua/LuaBinaryMessage.cpp ../../OsiInterface/Lua/LuaJson.cpp
+//       -x c++ $(ls ../../External/lua-5.3.5/src/*.c | grep -v '/luac\?\.c$') -o LuaBinaryMessageTest
+//
+// Usage:
+//   LuaBinaryMessageTest [fuzz iterations] [seed]
+//
+// The fuzzer generates random values (nested tables with mixed keys, integers, floats,
+// NaN/inf, binary strings, repeated strings), checks that they decode to an identical value
+// (including integer/float subtypes), then decodes corrupted and truncated copies of each
+// message to check that malformed messages are rejected without leaving values on the stack.
+// The benchmark compares message size and encode/decode time with Ext.JsonStringify/JsonParse
+// on typical mod payloads.
+
+#include <stdafx.h>
+#include <Lua/LuaBinaryMessage.h>
+#include <Lua/LuaJson.h>
+#include <lauxlib.h>
+#include <lualib.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+using namespace dse;
+using namespace dse::lua;
+
+static char const* const FuzzScript = R"(
+local strings = { "", "Name", "Handle", "Position", "a", "Visible", "\0\1\255", string.rep("x", 300) }
+
+local function RandomString()
+	if math.random(3) == 1 then
+		return strings[math.random(#strings)]
+	end
+	local chars = {}
+	for i = 1, math.random(0, 20) do
+		chars[i] = string.char(math.random(0, 255))
+	end
+	return table.concat(chars)
+end
+
+local function RandomNumber()
+	local kind = math.random(8)
+	if kind == 1 then return math.random(-100, 100)
+	elseif kind == 2 then return (math.random(0, 0xffffffff) << 32) | math.random(0, 0xffffffff)
+	elseif kind == 3 then return ({ math.mininteger, math.maxinteger, 0, -1 })[math.random(4)]
+	elseif kind == 4 then return math.random() * 1000.0
+	elseif kind == 5 then return (math.random(-1000, 1000)) / 4.0
+	elseif kind == 6 then return ({ 1/0, -1/0, 0.0, -0.0, 1e300, 2^-1074 })[math.random(6)]
+	elseif kind == 7 then return 0/0
+	else return math.random(1, 1000) + 0.0
+	end
+end
+
+local RandomValue
+
+local function RandomKey()
+	local kind = math.random(4)
+	if kind == 1 then return RandomString()
+	elseif kind == 2 then return math.random(-5, 40)
+	elseif kind == 3 then return math.random(1, 20) + 0.5
+	else return math.random(2) == 1
+	end
+end
+
+local function RandomTable(depth)
+	local t = {}
+	if math.random(2) == 1 then
+		for i = 1, math.random(0, 12) do
+			t[i] = RandomValue(depth + 1)
+		end
+	end
+	for i = 1, math.random(0, 6) do
+		local key = RandomKey()
+		if key == key then
+			t[key] = RandomValue(depth + 1)
+		end
+	end
+	return t
+end
+
+RandomValue = function (depth)
+	local kind = math.random(depth < 5 and 6 or 4)
+	if kind == 1 then return math.random(2) == 1
+	elseif kind == 2 then return RandomNumber()
+	elseif kind == 3 then return RandomString()
+	elseif kind == 4 then return RandomNumber()
+	else return RandomTable(depth)
+	end
+end
+
+local function Same(a, b)
+	if type(a) ~= type(b) then return false end
+	if type(a) == "number" then
+		if math.type(a) ~= math.type(b) then return false end
+		if a ~= a then return b ~= b end
+		return a == b and (a ~= 0 or 1/a == 1/b)
+	end
+	if type(a) ~= "table" then return a == b end
+	for k, v in pairs(a) do
+		if not Same(v, b[k]) then return false end
+	end
+	for k, v in pairs(b) do
+		if a[k] == nil then return false end
+	end
+	return true
+end
+
+function Fuzz(iterations, seed)
+	math.randomseed(seed)
+	for i = 1, iterations do
+		local value = RandomValue(0)
+		if math.random(20) == 1 then value = nil end
+		local decoded = RoundTrip(value)
+		if not Same(value, decoded) then
+			error("Round trip mismatch in iteration " .. i)
+		end
+	end
+end
+
+function MakeUIPayload(count)
+	local entries = {}
+	for i = 1, count do
+		entries[i] = {
+			Handle = 0x100000000 + i * 7919,
+			Name = "Character_" .. (i % 16),
+			Position = { 100.25 + i, 12.5, -340.75 + i * 0.5 },
+			Vitality = math.random(0, 500),
+			MaxVitality = 500,
+			Visible = i % 3 ~= 0,
+			Statuses = { "HASTED", "BLESSED", "WET" }
+		}
+	end
+	return { Type = "UIUpdate", Turn = 12, Entries = entries }
+end
+
+function MakeSmallPayload()
+	return { Action = "SetValue", Slot = 4, Value = 0.75 }
+end
+)";
+
+static std::mt19937 rng;
+static uint64_t fuzzMessages{ 0 }, corruptRejected{ 0 }, corruptAccepted{ 0 };
+
+static void CheckCorrupted(lua_State* L, STDString const& message)
+{
+	for (int i = 0; i < 8; i++) {
+		auto corrupted = message;
+		if (i == 0) {
+			corrupted.resize(rng() % corrupted.size());
+		} else {
+			auto flips = 1 + rng() % 3;
+			for (unsigned j = 0; j < flips; j++) {
+				corrupted[rng() % corrupted.size()] = (char)rng();
+			}
+		}
+
+		auto top = lua_gettop(L);
+		STDString error;
+		if (binary::Deserialize(L, corrupted, error)) {
+			if (lua_gettop(L) != top + 1) {
+				fprintf(stderr, "Stack imbalance after decoding a corrupted message\n");
+				exit(1);
+			}
+			lua_settop(L, top);
+			corruptAccepted++;
+		} else {
+			if (lua_gettop(L) != top) {
+				fprintf(stderr, "Stack imbalance after rejecting a corrupted message\n");
+				exit(1);
+			}
+			corruptRejected++;
+		}
+	}
+}
+
+static int RoundTrip(lua_State* L)
+{
+	lua_settop(L, 1);
+	STDString message, error;
+	try {
+		binary::Serialize(L, 1, message);
+	} catch (std::runtime_error& e) {
+		return luaL_error(L, "Serialize failed: %s", e.what());
+	}
+
+	if (!binary::Deserialize(L, message, error)) {
+		return luaL_error(L, "Deserialize failed: %s", error.c_str());
+	}
+
+	fuzzMessages++;
+	CheckCorrupted(L, message);
+	return 1;
+}
+
+static void Benchmark(lua_State* L, char const* name, char const* expr, int iterations)
+{
+	using Clock = std::chrono::steady_clock;
+	if (luaL_dostring(L, expr)) {
+		fprintf(stderr, "%s\n", lua_tostring(L, -1));
+		exit(1);
+	}
+
+	auto value = lua_gettop(L);
+	STDString message, json, error;
+	double binEncode{ 1e9 }, binDecode{ 1e9 }, jsonEncode{ 1e9 }, jsonDecode{ 1e9 };
+	for (int round = 0; round < 5; round++) {
+		auto t0 = Clock::now();
+		for (int i = 0; i < iterations; i++) binary::Serialize(L, value, message);
+		auto t1 = Clock::now();
+		for (int i = 0; i < iterations; i++) { binary::Deserialize(L, message, error); lua_pop(L, 1); }
+		auto t2 = Clock::now();
+		for (int i = 0; i < iterations; i++) { json.clear(); json::Stringify(L, value, false, json); }
+		auto t3 = Clock::now();
+		for (int i = 0; i < iterations; i++) { json::Parse(L, json, error); lua_pop(L, 1); }
+		auto t4 = Clock::now();
+
+		auto us = [iterations](auto a, auto b) { return std::chrono::duration<double, std::micro>(b - a).count() / iterations; };
+		binEncode = std::min(binEncode, us(t0, t1));
+		binDecode = std::min(binDecode, us(t1, t2));
+		jsonEncode = std::min(jsonEncode, us(t2, t3));
+		jsonDecode = std::min(jsonDecode, us(t3, t4));
+		lua_gc(L, LUA_GCCOLLECT, 0);
+	}
+
+	printf("%-14s binary %7zu B  enc %8.2f us  dec %8.2f us | json %7zu B  enc %8.2f us  dec %8.2f us\n",
+		name, message.size(), binEncode, binDecode, json.size(), jsonEncode, jsonDecode);
+	lua_settop(L, value - 1);
+}
+
+int main(int argc, char** argv)
+{
+	auto iterations = argc > 1 ? atoi(argv[1]) : 20000;
+	auto seed = argc > 2 ? atoi(argv[2]) : 1;
+	rng.seed(seed);
+
+	auto L = luaL_newstate();
+	luaL_openlibs(L);
+	lua_pushcfunction(L, &RoundTrip);
+	lua_setglobal(L, "RoundTrip");
+	if (luaL_dostring(L, FuzzScript)) {
+		fprintf(stderr, "%s\n", lua_tostring(L, -1));
+		return 1;
+	}
+
+	lua_getglobal(L, "Fuzz");
+	lua_pushinteger(L, iterations);
+	lua_pushinteger(L, seed);
+	if (lua_pcall(L, 2, 0, 0) != LUA_OK) {
+		fprintf(stderr, "FAILED: %s\n", lua_tostring(L, -1));
+		return 1;
+	}
+
+	printf("Fuzz: %llu round trips OK; corrupted messages: %llu rejected, %llu decoded to other values\n\n",
+		(unsigned long long)fuzzMessages, (unsigned long long)corruptRejected, (unsigned long long)corruptAccepted);
+
+	Benchmark(L, "small", "return MakeSmallPayload()", 200000);
+	Benchmark(L, "UI, 10", "return MakeUIPayload(10)", 20000);
+	Benchmark(L, "UI, 200", "return MakeUIPayload(200)", 1000);
+	Benchmark(L, "int array", "local t = {} for i = 1, 1000 do t[i] = i * 37 end return t", 2000);
+
+	printf("\nOK\n");
+	lua_close(L);
+	return 0;
+}
@@ -0,0 +1,9 @@
+#pragma once
+// Game-independent subset of GameDefinitions/BaseTypes.h used by the Lua codecs
+#include "../stdafx.h"
+
+namespace dse
+{
+	using STDString = std::string;
+	using StringView = std::string_view;
+}
@@ -0,0 +1,8 @@
+#pragma once
+// MSVC intrinsics used by LuaJson.cpp
+
+inline unsigned char _BitScanForward(unsigned long* index, unsigned long mask)
+{
+	*index = __builtin_ctzl(mask);
+	return mask != 0;
+}
@@ -0,0 +1,19 @@
+#pragma once
+// Minimal replacement of the OsiInterface precompiled header for the standalone harness
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+template <std::size_t N, class... Args>
+int sprintf_s(char (&buf)[N], char const* fmt, Args... args)
+{
+	return snprintf(buf, N, fmt, args...);
+}
@@ -0,0 +1,275 @@
+// Save/load benchmark of the streaming JSON codec (OsiInterface/Lua/LuaJson.cpp) against the
+// jsoncpp DOM path that Ext.JsonStringify/JsonParse and persistent vars used before it.
+//
+// Build (Linux, Lua compiled as C++ like LuaLib):
+//   g++ -O2 -std=c++17 -I../LuaBinaryMessageTest/shim -I../../External/lua-5.3.5/src -I../../OsiInterface
+//       -I/usr/include/jsoncpp LuaJsonBenchmark.cpp
+//       ../../OsiInterface/Lua/LuaJson.cpp
+//       -x c++ $(ls ../../External/lua-5.3.5/src/*.c | grep -v '/luac\?\.c$') -ljsoncpp -o LuaJsonBenchmark
+//
+// Usage:
+//   LuaJsonBenchmark [state size in MB] [rounds]
+//
+// Builds a synthetic PersistentVars table of the requested JSON size (per-character records
+// keyed by GUID, quest state, a combat log) and times one save (Lua table -> beautified JSON
+// text) and one load (JSON text -> Lua table) with both codecs. The streaming output must be
+// byte-for-byte identical to the jsoncpp output, and both parsers must produce tables that
+// stringify to the same text; the benchmark exits with an error otherwise.
+
+#include <stdafx.h>
+#include <Lua/LuaJson.h>
+#include <json/json.h>
+#include <lauxlib.h>
+#include <lualib.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+using namespace dse;
+using namespace dse::lua;
+
+static char const* const StateScript = R"(
+local function Guid(i)
+	return string.format("%08x-%04x-%04x-%04x-%012x", i * 2654435761 % 0x100000000,
+		i % 0x10000, (i * 7) % 0x10000, (i * 13) % 0x10000, i * 40503)
+end
+
+local statuses = { "BURNING", "WET", "HASTED", "BLESSED", "KNOCKED_DOWN", "INVISIBLE" }
+
+function MakeState(characters)
+	local state = { Version = 3, Initialized = true, Characters = {}, Quests = {}, CombatLog = {} }
+	for i = 1, characters do
+		state.Characters[Guid(i)] = {
+			Name = "Character_" .. i,
+			Level = i % 20 + 1,
+			Experience = i * 1337,
+			Position = { 100.25 + i, 12.5, -340.75 + i * 0.5 },
+			Statuses = { statuses[i % #statuses + 1], statuses[(i * 3) % #statuses + 1] },
+			Flags = { Visible = i % 3 ~= 0, Dead = i % 17 == 0, Tagged = i % 5 == 0 },
+			Cooldowns = { i % 4, i % 3, 0, 2 },
+			Notes = "Met at the \"Driftwood\" tavern\nwants 200 gold"
+		}
+	end
+
+	for i = 1, characters // 10 do
+		state.Quests["QUEST_" .. i] = { Stage = i % 7, Completed = i % 4 == 0, Giver = Guid(i) }
+	end
+
+	for i = 1, characters // 2 do
+		state.CombatLog[i] = { Turn = i, Attacker = Guid(i), Damage = i * 0.75, Type = "Physical" }
+	end
+
+	return state
+end
+)";
+
+namespace jsoncpp
+{
+	// The Json::Value based codec that Ext.JsonStringify/JsonParse used before LuaJson.cpp
+
+	void Parse(lua_State* L, Json::Value const& val);
+
+	void ParseArray(lua_State* L, Json::Value const& val)
+	{
+		lua_newtable(L);
+		int idx = 1;
+		for (auto it = val.begin(), end = val.end(); it != end; ++it) {
+			lua_pushinteger(L, idx++);
+			Parse(L, *it);
+			lua_settable(L, -3);
+		}
+	}
+
+	void ParseObject(lua_State* L, Json::Value const& val)
+	{
+		lua_newtable(L);
+		for (auto it = val.begin(), end = val.end(); it != end; ++it) {
+			Parse(L, it.key());
+			Parse(L, *it);
+			lua_settable(L, -3);
+		}
+	}
+
+	void Parse(lua_State* L, Json::Value const& val)
+	{
+		switch (val.type()) {
+		case Json::nullValue: lua_pushnil(L); break;
+		case Json::intValue: lua_pushinteger(L, val.asInt64()); break;
+		case Json::uintValue: lua_pushinteger(L, (int64_t)val.asUInt64()); break;
+		case Json::realValue: lua_pushnumber(L, val.asDouble()); break;
+		case Json::stringValue: lua_pushstring(L, val.asCString()); break;
+		case Json::booleanValue: lua_pushboolean(L, val.asBool()); break;
+		case Json::arrayValue: ParseArray(L, val); break;
+		case Json::objectValue: ParseObject(L, val); break;
+		default: luaL_error(L, "Attempted to parse unknown Json value");
+		}
+	}
+
+	bool Parse(lua_State* L, std::string const& json, std::string& errs)
+	{
+		Json::CharReaderBuilder factory;
+		std::unique_ptr<Json::CharReader> reader(factory.newCharReader());
+		Json::Value root;
+		if (!reader->parse(json.data(), json.data() + json.size(), &root, &errs)) {
+			return false;
+		}
+
+		Parse(L, root);
+		return true;
+	}
+
+	Json::Value Stringify(lua_State* L, int index, int depth);
+
+	bool CanStringifyAsArray(lua_State* L, int index)
+	{
+		lua_pushnil(L);
+		if (index < 0) index--;
+
+		int next = 1;
+		bool isArray = true;
+		while (lua_next(L, index) != 0) {
+			if (!lua_isinteger(L, -2) || lua_tointeger(L, -2) != next++) {
+				isArray = false;
+			}
+			lua_pop(L, 1);
+		}
+
+		return isArray;
+	}
+
+	Json::Value StringifyTable(lua_State* L, int index, int depth)
+	{
+		bool isArray = CanStringifyAsArray(L, index);
+		Json::Value result(isArray ? Json::arrayValue : Json::objectValue);
+		lua_pushnil(L);
+		if (index < 0) index--;
+
+		while (lua_next(L, index) != 0) {
+			Json::Value val(Stringify(L, -1, depth + 1));
+			if (isArray) {
+				result.append(val);
+			} else if (lua_type(L, -2) == LUA_TSTRING) {
+				result[lua_tostring(L, -2)] = val;
+			} else if (lua_type(L, -2) == LUA_TNUMBER) {
+				lua_pushvalue(L, -2);
+				result[lua_tostring(L, -1)] = val;
+				lua_pop(L, 1);
+			} else {
+				throw std::runtime_error("Can only stringify string or number table keys");
+			}
+
+			lua_pop(L, 1);
+		}
+
+		return result;
+	}
+
+	Json::Value Stringify(lua_State* L, int index, int depth)
+	{
+		if (depth > 64) {
+			throw std::runtime_error("Recursion depth exceeded while stringifying JSON");
+		}
+
+		switch (lua_type(L, index)) {
+		case LUA_TNIL: return Json::Value(Json::nullValue);
+		case LUA_TBOOLEAN: return Json::Value(lua_toboolean(L, index) == 1);
+		case LUA_TNUMBER:
+			if (lua_isinteger(L, index)) {
+				return Json::Value((Json::Int64)lua_tointeger(L, index));
+			} else {
+				return Json::Value(lua_tonumber(L, index));
+			}
+		case LUA_TSTRING: return Json::Value(lua_tostring(L, index));
+		case LUA_TTABLE: return StringifyTable(L, index, depth);
+		default: throw std::runtime_error("Attempted to stringify an unsupported type");
+		}
+	}
+
+	std::string Stringify(lua_State* L, int index)
+	{
+		auto root = Stringify(L, index, 0);
+		Json::StreamWriterBuilder builder;
+		builder["indentation"] = "\t";
+		std::stringstream ss;
+		std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+		writer->write(root, &ss);
+		return ss.str();
+	}
+}
+
+using Clock = std::chrono::steady_clock;
+
+static double ElapsedMs(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+[[noreturn]] static void Fail(char const* message)
+{
+	fprintf(stderr, "%s\n", message);
+	exit(1);
+}
+
+int main(int argc, char** argv)
+{
+	auto sizeMb = argc > 1 ? atof(argv[1]) : 8.0;
+	auto rounds = argc > 2 ? atoi(argv[2]) : 5;
+
+	auto L = luaL_newstate();
+	luaL_openlibs(L);
+	if (luaL_dostring(L, StateScript)) Fail(lua_tostring(L, -1));
+
+	// A character record is about 520 bytes of beautified JSON, including its share of
+	// the quest table and the combat log
+	auto characters = std::max(1, (int)(sizeMb * 1024 * 1024 / 520));
+	lua_getglobal(L, "MakeState");
+	lua_pushinteger(L, characters);
+	if (lua_pcall(L, 1, 1, 0) != LUA_OK) Fail(lua_tostring(L, -1));
+	auto state = lua_gettop(L);
+
+	STDString streamed, error;
+	std::string dom, domErrors;
+	double streamSave{ 1e9 }, streamLoad{ 1e9 }, domSave{ 1e9 }, domLoad{ 1e9 };
+	for (int round = 0; round < rounds; round++) {
+		auto start = Clock::now();
+		streamed.clear();
+		json::Stringify(L, state, false, streamed);
+		streamSave = std::min(streamSave, ElapsedMs(start));
+
+		start = Clock::now();
+		dom = jsoncpp::Stringify(L, state);
+		domSave = std::min(domSave, ElapsedMs(start));
+
+		start = Clock::now();
+		if (!json::Parse(L, streamed, error)) Fail(error.c_str());
+		streamLoad = std::min(streamLoad, ElapsedMs(start));
+
+		start = Clock::now();
+		if (!jsoncpp::Parse(L, dom, domErrors)) Fail(domErrors.c_str());
+		domLoad = std::min(domLoad, ElapsedMs(start));
+
+		if (round == 0) {
+			if (streamed != STDString(dom.data(), dom.size())) Fail("Streaming output differs from jsoncpp output");
+
+			STDString fromStreamed, fromDom;
+			json::Stringify(L, -2, false, fromStreamed);
+			json::Stringify(L, -1, false, fromDom);
+			if (fromStreamed != streamed || fromDom != streamed) Fail("Parsed tables differ from the saved table");
+		}
+
+		lua_settop(L, state);
+		lua_gc(L, LUA_GCCOLLECT, 0);
+	}
+
+	auto mb = streamed.size() / (1024.0 * 1024.0);
+	printf("State: %d characters, %.2f MB of JSON (best of %d rounds)\n\n", characters, mb, rounds);
+	printf("%-10s %12s %12s %12s %12s\n", "", "save ms", "load ms", "save MB/s", "load MB/s");
+	printf("%-10s %12.1f %12.1f %12.0f %12.0f\n", "jsoncpp", domSave, domLoad, mb * 1000.0 / domSave, mb * 1000.0 / domLoad);
+	printf("%-10s %12.1f %12.1f %12.0f %12.0f\n", "streaming", streamSave, streamLoad, mb * 1000.0 / streamSave, mb * 1000.0 / streamLoad);
+	printf("\nSpeedup: save %.1fx, load %.1fx\n", domSave / streamSave, domLoad / streamLoad);
+
+	lua_close(L);
+	return 0;
+}
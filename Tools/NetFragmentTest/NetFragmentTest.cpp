@@ -0,0 +1,169 @@
+// Loopback harness for extender message fragmentation (OsiInterface/NetMessageFragments.cpp).
+//
+// Build (Linux):
+//   g++ -O2 -std=c++17 -I../../OsiInterface NetFragmentTest.cpp ../../OsiInterface/NetMessageFragments.cpp -llz4 -o NetFragmentTest
+//
+// Usage:
+//   NetFragmentTest [messages] [seed]
+//
+// Splits a mix of JSON-like (compressible) and random payloads sent by several senders on
+// several channels, shuffles and duplicates the fragments of concurrently sent messages,
+// feeds them to a reassembler and checks that every payload arrives intact exactly once.
+
+#include "NetMessageFragments.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+using namespace dse::net;
+
+static constexpr uint32_t NumSenders = 4;
+static constexpr uint32_t NumChannels = 3;
+// Number of messages whose fragments are in flight (and reordered) at the same time
+static constexpr std::size_t WindowSize = 8;
+
+struct SentMessage
+{
+	uint32_t Sender;
+	uint32_t Channel;
+	uint32_t Sequence;
+	std::string Payload;
+	bool Received{ false };
+};
+
+struct InFlightFragment
+{
+	uint32_t Sender;
+	MessageFragment Fragment;
+};
+
+static std::string MakePayload(std::mt19937& rng)
+{
+	static std::size_t const sizes[] = { 100, 3000, 5000, 40000, 70000, 300000, 2000000 };
+	auto size = sizes[rng() % std::size(sizes)] + rng() % 1000;
+
+	std::string payload;
+	payload.reserve(size + 64);
+	if (rng() % 3 == 0) {
+		while (payload.size() < size) {
+			payload += (char)(rng() & 0xff);
+		}
+	} else {
+		uint32_t i = 0;
+		payload += "{";
+		while (payload.size() < size) {
+			payload += "\"Entry" + std::to_string(i++) + "\":{\"Level\":" + std::to_string(rng() % 30)
+				+ ",\"Handle\":" + std::to_string(rng() % 100000) + ",\"Tags\":[\"ALLY\",\"SUMMON\"]},";
+		}
+		payload += "}";
+	}
+
+	return payload;
+}
+
+int main(int argc, char** argv)
+{
+	auto numMessages = argc > 1 ? (std::size_t)atoi(argv[1]) : 2000;
+	auto seed = argc > 2 ? (uint32_t)atoi(argv[2]) : 1;
+	std::mt19937 rng(seed);
+
+	std::vector<FragmentWriter> writers(NumSenders);
+	FragmentReassembler reassembler;
+	std::vector<SentMessage> messages;
+	messages.reserve(numMessages);
+
+	auto capabilities = (uint32_t)ExtenderCapabilities::Supported;
+	std::size_t payloadBytes{ 0 }, wireBytes{ 0 }, numFragments{ 0 }, numDuplicates{ 0 }, errors{ 0 };
+	double splitTime{ 0 }, reassemblyTime{ 0 };
+
+	std::size_t nextMessage{ 0 };
+	while (nextMessage < numMessages) {
+		std::vector<InFlightFragment> inFlight;
+		for (std::size_t i = 0; i < WindowSize && nextMessage < numMessages; i++, nextMessage++) {
+			SentMessage message;
+			message.Sender = rng() % NumSenders;
+			message.Channel = rng() % NumChannels;
+			message.Payload = MakePayload(rng);
+			payloadBytes += message.Payload.size();
+
+			std::vector<MessageFragment> fragments;
+			auto start = std::chrono::steady_clock::now();
+			writers[message.Sender].Split(message.Channel, message.Payload, capabilities, fragments);
+			splitTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			message.Sequence = fragments[0].Sequence;
+			for (auto& fragment : fragments) {
+				wireBytes += fragment.Data.size();
+				numFragments++;
+				if (rng() % 20 == 0) {
+					inFlight.push_back({ message.Sender, fragment });
+					numDuplicates++;
+				}
+				inFlight.push_back({ message.Sender, std::move(fragment) });
+			}
+
+			messages.push_back(std::move(message));
+		}
+
+		std::shuffle(inFlight.begin(), inFlight.end(), rng);
+
+		for (auto const& fragment : inFlight) {
+			std::string payload, error;
+			auto start = std::chrono::steady_clock::now();
+			auto result = reassembler.Add(fragment.Sender, fragment.Fragment, payload, error);
+			reassemblyTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			if (result == FragmentReassembler::Result::Error) {
+				fprintf(stderr, "Reassembly error: %s\n", error.c_str());
+				errors++;
+			} else if (result == FragmentReassembler::Result::Complete) {
+				auto it = std::find_if(messages.begin(), messages.end(), [&](SentMessage const& msg) {
+					return msg.Sender == fragment.Sender
+						&& msg.Channel == fragment.Fragment.Channel
+						&& msg.Sequence == fragment.Fragment.Sequence;
+				});
+
+				if (it == messages.end()) {
+					fprintf(stderr, "Received unknown message %u/%u/%u\n", fragment.Sender, fragment.Fragment.Channel, fragment.Fragment.Sequence);
+					errors++;
+				} else if (it->Received) {
+					fprintf(stderr, "Message %u/%u/%u received twice\n", it->Sender, it->Channel, it->Sequence);
+					errors++;
+				} else if (it->Payload != payload) {
+					fprintf(stderr, "Message %u/%u/%u payload mismatch\n", it->Sender, it->Channel, it->Sequence);
+					errors++;
+				} else {
+					it->Received = true;
+				}
+			}
+		}
+	}
+
+	auto numReceived = std::count_if(messages.begin(), messages.end(), [](SentMessage const& msg) { return msg.Received; });
+	if ((std::size_t)numReceived != messages.size()) {
+		fprintf(stderr, "%zu messages were not received\n", messages.size() - numReceived);
+		errors++;
+	}
+
+	if (reassembler.GetNumPending() > 0) {
+		// Duplicates of completed messages start new (never completed) messages
+		printf("%zu incomplete messages left from duplicate fragments\n", reassembler.GetNumPending());
+	}
+
+	printf("%zu messages, %zu fragments (%zu duplicated), %.1f MB payload, %.1f MB on the wire (%.1f%%)\n",
+		messages.size(), numFragments, numDuplicates, payloadBytes / 1048576.0, wireBytes / 1048576.0,
+		payloadBytes ? wireBytes * 100.0 / payloadBytes : 0.0);
+	printf("Split: %.1f MB/s, reassembly: %.1f MB/s\n",
+		payloadBytes / 1048576.0 / splitTime, payloadBytes / 1048576.0 / reassemblyTime);
+
+	if (errors > 0) {
+		printf("FAILED (%zu errors)\n", errors);
+		return 1;
+	}
+
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,158 @@
+// Join-time cost test for delta NetworkFixedString synchronization (OsiInterface/NetworkStringTable.cpp).
+//
+// Build (Linux):
+//   g++ -O2 -std=c++17 -I../../OsiInterface NetworkStringSyncTest.cpp ../../OsiInterface/NetworkStringTable.cpp -o NetworkStringSyncTest
+//
+// Usage:
+//   NetworkStringSyncTest [strings] [iterations]
+//
+// Builds a synthetic server table and several client tables (identical, a few changed strings,
+// strings appended, a mod inserted in the middle, empty), runs the request/response/merge steps
+// and reports the bytes each side would send and the CPU time of each step, compared to sending
+// the full table.
+
+#include "NetworkStringTable.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+using namespace dse;
+
+// Size of a protobuf length-delimited field with a 1 byte tag
+static std::size_t FieldSize(std::size_t length)
+{
+	std::size_t varint = 1;
+	for (auto value = length; value >= 0x80; value >>= 7) {
+		varint++;
+	}
+
+	return 1 + varint + length;
+}
+
+static std::vector<std::string> MakeTable(std::mt19937& rng, std::size_t numStrings, std::string const& prefix)
+{
+	static char const* const words[] = { "Skill", "Projectile", "Status", "Target", "Shout", "Item", "Armor", "Weapon",
+		"Fire", "Water", "Poison", "Air", "Earth", "Summon", "Boost", "Potion", "Scroll", "Grenade", "Arrow" };
+	std::vector<std::string> table;
+	table.reserve(numStrings);
+	for (std::size_t i = 0; i < numStrings; i++) {
+		std::string str = prefix;
+		auto numWords = 2 + rng() % 3;
+		for (std::size_t w = 0; w < numWords; w++) {
+			str += words[rng() % std::size(words)];
+			str += '_';
+		}
+		str += std::to_string(i);
+		table.push_back(std::move(str));
+	}
+
+	return table;
+}
+
+static std::vector<std::string_view> Views(std::vector<std::string> const& table)
+{
+	return std::vector<std::string_view>(table.begin(), table.end());
+}
+
+struct Scenario
+{
+	char const* Name;
+	std::vector<std::string> Client;
+};
+
+int main(int argc, char** argv)
+{
+	auto numStrings = argc > 1 ? (std::size_t)atoi(argv[1]) : 40000;
+	auto iterations = argc > 2 ? atoi(argv[2]) : 20;
+	std::mt19937 rng(1);
+
+	auto server = MakeTable(rng, numStrings, "");
+	auto serverViews = Views(server);
+
+	std::vector<Scenario> scenarios;
+	scenarios.push_back({ "identical", server });
+
+	auto changed = server;
+	for (int i = 0; i < 5; i++) {
+		changed[rng() % changed.size()] += "_v2";
+	}
+	scenarios.push_back({ "5 strings changed", changed });
+
+	scenarios.push_back({ "500 strings missing at end", std::vector<std::string>(server.begin(), server.end() - 500) });
+
+	auto inserted = server;
+	auto extraMod = MakeTable(rng, 300, "ExtraMod_");
+	inserted.insert(inserted.begin() + inserted.size() / 2, extraMod.begin(), extraMod.end());
+	scenarios.push_back({ "mod inserted in the middle", inserted });
+
+	scenarios.push_back({ "empty", {} });
+
+	std::size_t fullBytes{ 0 };
+	for (auto const& str : server) {
+		fullBytes += FieldSize(str.size());
+	}
+
+	printf("Server table: %zu strings; full update: %zu bytes\n\n", server.size(), fullBytes);
+	printf("%-28s %10s %10s %8s %10s %10s %10s\n", "Scenario", "Request", "Response", "Blocks", "Client us", "Server us", "Merge us");
+
+	bool ok = true;
+	for (auto const& scenario : scenarios) {
+		auto clientViews = Views(scenario.Client);
+		double clientTime{ 0 }, serverTime{ 0 }, mergeTime{ 0 };
+		std::size_t requestBytes{ 0 }, responseBytes{ 0 }, numBlocks{ 0 };
+
+		for (int iter = 0; iter < iterations; iter++) {
+			// Client: hash the local table
+			auto start = std::chrono::steady_clock::now();
+			auto clientHash = HashNetworkStrings(clientViews, NetworkStringBlockSize);
+			auto afterClient = std::chrono::steady_clock::now();
+
+			// Server: hash its table and collect the mismatching blocks
+			auto serverHash = HashNetworkStrings(serverViews, NetworkStringBlockSize);
+			auto blocks = FindMismatchingNetworkStringBlocks(serverHash, clientHash.BlockHashes);
+			std::vector<std::string_view> blockStrings;
+			for (auto block : blocks) {
+				auto last = std::min((block + 1) * NetworkStringBlockSize, serverHash.NumStrings);
+				for (auto i = block * NetworkStringBlockSize; i < last; i++) {
+					blockStrings.push_back(serverViews[i]);
+				}
+			}
+			auto afterServer = std::chrono::steady_clock::now();
+
+			// Client: merge and verify
+			std::vector<std::string_view> merged;
+			std::string error;
+			bool mergedOk = MergeNetworkStringBlocks(clientViews, serverHash.NumStrings, NetworkStringBlockSize,
+				blocks, blockStrings, merged, error)
+				&& HashNetworkStrings(merged, NetworkStringBlockSize).TableHash == serverHash.TableHash;
+			auto afterMerge = std::chrono::steady_clock::now();
+
+			if (!mergedOk || merged != serverViews) {
+				printf("%s: merge failed: %s\n", scenario.Name, error.c_str());
+				ok = false;
+				break;
+			}
+
+			clientTime += std::chrono::duration<double, std::micro>(afterClient - start).count();
+			serverTime += std::chrono::duration<double, std::micro>(afterServer - afterClient).count();
+			mergeTime += std::chrono::duration<double, std::micro>(afterMerge - afterServer).count();
+
+			// block_size + num_strings + packed fixed64 block hashes
+			requestBytes = 3 + 4 + FieldSize(clientHash.BlockHashes.size() * 8);
+			// block_size + num_strings + table_hash + packed block indices (approx. 2 bytes each) + strings
+			responseBytes = 3 + 4 + 9 + (blocks.empty() ? 0 : FieldSize(blocks.size() * 2));
+			for (auto const& str : blockStrings) {
+				responseBytes += FieldSize(str.size());
+			}
+			numBlocks = blocks.size();
+		}
+
+		printf("%-28s %10zu %10zu %8zu %10.0f %10.0f %10.0f\n", scenario.Name, requestBytes, responseBytes, numBlocks,
+			clientTime / iterations, serverTime / iterations, mergeTime / iterations);
+	}
+
+	printf(ok ? "\nOK\n" : "\nFAILED\n");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,522 @@
+// Allocation and latency benchmark for PendingHitManager containers (OsiInterface/HitContainers.h).
+//
+// Build (Linux):
+//   g++ -O2 -std=c++17 -I../../OsiInterface PendingHitBenchmark.cpp -o PendingHitBenchmark
+//
+// Usage:
+//   PendingHitBenchmark [hits] [in-flight hits]
+//
+// Replays synthetic hit sequences (character hit -> StatusHit setup -> enter -> ApplyDamage lookup ->
+// StatusHit destroy) with 1-6 damage types per hit against a copy of the previous PendingHitManager
+// (make_unique + std::unordered_map + game heap damage list copies) and the pooled implementation.
+// Game objects (HitDamageInfo, StatusHit) are reused from a ring buffer, like the game does, so the
+// pointer-keyed maps see address reuse. Reports heap allocations and nanoseconds per hit.
+
+#include "HitContainers.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <unordered_map>
+
+using namespace dse;
+
+static uint64_t gNewCalls{ 0 };
+static uint64_t gGameAllocCalls{ 0 };
+
+void* operator new(std::size_t size)
+{
+	gNewCalls++;
+	if (auto p = malloc(size ? size : 1)) {
+		return p;
+	}
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	free(p);
+}
+
+// Minimal stand-ins for the game types used by PendingHitManager
+
+struct TDamagePair
+{
+	int32_t Amount;
+	uint32_t DamageType;
+};
+
+// Same copy semantics as dse::Array (game heap, no destructor)
+struct GameArray
+{
+	TDamagePair* Buf{ nullptr };
+	uint32_t Capacity{ 0 };
+	uint32_t Size{ 0 };
+
+	GameArray() {}
+	GameArray(GameArray const& a) { CopyFrom(a); }
+	GameArray& operator =(GameArray const& a) { CopyFrom(a); return *this; }
+
+	void CopyFrom(GameArray const& a)
+	{
+		Size = 0;
+		if (a.Size > 0) {
+			gGameAllocCalls++;
+			auto buf = (TDamagePair*)malloc(sizeof(TDamagePair) * a.Size);
+			free(Buf);
+			Buf = buf;
+			Capacity = a.Size;
+			Size = a.Size;
+			for (uint32_t i = 0; i < Size; i++) {
+				Buf[i] = a.Buf[i];
+			}
+		}
+	}
+};
+
+struct HitDamageInfo
+{
+	int32_t TotalDamage{ 0 };
+	uint32_t EffectFlags{ 0 };
+	GameArray DamageList;
+
+	void CopyWithoutDamageList(HitDamageInfo const& src)
+	{
+		TotalDamage = src.TotalDamage;
+		EffectFlags = src.EffectFlags;
+	}
+
+	void CopyFrom(HitDamageInfo const& src)
+	{
+		CopyWithoutDamageList(src);
+		DamageList.CopyFrom(src.DamageList);
+	}
+};
+
+struct StatusHit
+{
+	HitDamageInfo DamageInfo;
+};
+
+
+namespace old_impl
+{
+	struct PendingHit
+	{
+		uint32_t Id;
+		bool CapturedCharacterHit{ false };
+		HitDamageInfo* CharacterHitPointer{ nullptr };
+		GameArray CharacterHitDamageList;
+		HitDamageInfo CharacterHit;
+		bool CapturedStatusSetup{ false };
+		bool CapturedStatusEnter{ false };
+		StatusHit* Status{ nullptr };
+	};
+
+	class PendingHitManager
+	{
+	public:
+		PendingHit* OnCharacterHit(GameArray* damageList, HitDamageInfo* damageInfo)
+		{
+			auto it = characterHitMap_.find(damageInfo);
+			if (it != characterHitMap_.end()) {
+				if (it->second->CapturedStatusSetup || it->second->CapturedStatusEnter) {
+					it->second->CharacterHitPointer = nullptr;
+				} else {
+					DeleteHit(it->second);
+				}
+			}
+
+			auto hit = std::make_unique<PendingHit>();
+			hit->Id = nextHitId_++;
+			hit->CapturedCharacterHit = true;
+			hit->CharacterHitPointer = damageInfo;
+			hit->CharacterHitDamageList.CopyFrom(*damageList);
+			hit->CharacterHit.CopyFrom(*damageInfo);
+
+			auto pHit = hit.get();
+			hits_.insert(std::make_pair(hit->Id, std::move(hit)));
+			characterHitMap_.insert(std::make_pair(damageInfo, pHit));
+			return pHit;
+		}
+
+		PendingHit* OnStatusHitSetup(StatusHit* status, HitDamageInfo* damageInfo)
+		{
+			PendingHit* pHit;
+			auto it = characterHitMap_.find(damageInfo);
+			if (it != characterHitMap_.end()) {
+				pHit = it->second;
+			} else {
+				auto hit = std::make_unique<PendingHit>();
+				hit->Id = nextHitId_++;
+				pHit = hit.get();
+				hits_.insert(std::make_pair(hit->Id, std::move(hit)));
+			}
+
+			pHit->CapturedStatusSetup = true;
+			pHit->Status = status;
+			hitStatusMap_.insert(std::make_pair(status, pHit));
+
+			if (pHit->CapturedCharacterHit && pHit->CharacterHitPointer != nullptr) {
+				auto it = characterHitMap_.find(pHit->CharacterHitPointer);
+				if (it != characterHitMap_.end() && it->second == pHit) {
+					characterHitMap_.erase(it);
+				}
+
+				pHit->CharacterHitPointer = nullptr;
+			}
+
+			return pHit;
+		}
+
+		PendingHit* OnStatusHitEnter(StatusHit* status)
+		{
+			PendingHit* pHit;
+			auto it = hitStatusMap_.find(status);
+			if (it != hitStatusMap_.end()) {
+				pHit = it->second;
+			} else {
+				auto hit = std::make_unique<PendingHit>();
+				hit->Id = nextHitId_++;
+				pHit = hit.get();
+				hits_.insert(std::make_pair(hit->Id, std::move(hit)));
+			}
+
+			pHit->CapturedStatusEnter = true;
+			pHit->Status = status;
+			hitStatusDamageMap_.insert(std::make_pair(&status->DamageInfo, pHit));
+			return pHit;
+		}
+
+		void OnStatusHitDestroy(StatusHit* status)
+		{
+			auto it = hitStatusMap_.find(status);
+			if (it != hitStatusMap_.end()) {
+				DeleteHit(it->second);
+			}
+		}
+
+		PendingHit* OnCharacterApplyDamage(HitDamageInfo* hit)
+		{
+			auto it = hitStatusDamageMap_.find(hit);
+			return it != hitStatusDamageMap_.end() ? it->second : nullptr;
+		}
+
+		void DeleteHit(PendingHit* hit)
+		{
+			if (hit->CapturedStatusEnter) {
+				auto it = hitStatusDamageMap_.find(&hit->Status->DamageInfo);
+				if (it != hitStatusDamageMap_.end()) {
+					hitStatusDamageMap_.erase(it);
+				}
+			}
+
+			if (hit->CapturedStatusSetup) {
+				auto it = hitStatusMap_.find(hit->Status);
+				if (it != hitStatusMap_.end()) {
+					hitStatusMap_.erase(it);
+				}
+			}
+
+			if (hit->CapturedCharacterHit && hit->CharacterHitPointer != nullptr) {
+				auto it = characterHitMap_.find(hit->CharacterHitPointer);
+				if (it != characterHitMap_.end() && it->second == hit) {
+					characterHitMap_.erase(it);
+				}
+			}
+
+			hits_.erase(hit->Id);
+		}
+
+		std::size_t NumHits() const
+		{
+			return hits_.size();
+		}
+
+	private:
+		uint32_t nextHitId_{ 1 };
+		std::unordered_map<uint32_t, std::unique_ptr<PendingHit>> hits_;
+		std::unordered_map<HitDamageInfo*, PendingHit*> characterHitMap_;
+		std::unordered_map<StatusHit*, PendingHit*> hitStatusMap_;
+		std::unordered_map<HitDamageInfo*, PendingHit*> hitStatusDamageMap_;
+	};
+}
+
+
+namespace new_impl
+{
+	struct PendingHit
+	{
+		uint32_t Id;
+		bool CapturedCharacterHit{ false };
+		HitDamageInfo* CharacterHitPointer{ nullptr };
+		InlineArray<TDamagePair, 4> CharacterHitDamageList;
+		HitDamageInfo CharacterHit;
+		InlineArray<TDamagePair, 4> CharacterHitDamage;
+		bool CapturedStatusSetup{ false };
+		bool CapturedStatusEnter{ false };
+		StatusHit* Status{ nullptr };
+	};
+
+	// Mirrors PendingHitManager in OsiInterface/Hit.cpp
+	class PendingHitManager
+	{
+	public:
+		PendingHit* OnCharacterHit(GameArray* damageList, HitDamageInfo* damageInfo)
+		{
+			auto existing = FindHit(characterHitMap_, damageInfo);
+			if (existing != nullptr) {
+				if (existing->CapturedStatusSetup || existing->CapturedStatusEnter) {
+					existing->CharacterHitPointer = nullptr;
+				} else {
+					DeleteHit(existing);
+				}
+			}
+
+			auto hit = CreateHit();
+			hit->CapturedCharacterHit = true;
+			hit->CharacterHitPointer = damageInfo;
+			hit->CharacterHitDamageList.Assign(damageList->Buf, damageList->Size);
+			hit->CharacterHit.CopyWithoutDamageList(*damageInfo);
+			hit->CharacterHitDamage.Assign(damageInfo->DamageList.Buf, damageInfo->DamageList.Size);
+			MapHit(characterHitMap_, damageInfo, hit);
+			return hit;
+		}
+
+		PendingHit* OnStatusHitSetup(StatusHit* status, HitDamageInfo* damageInfo)
+		{
+			auto pHit = FindHit(characterHitMap_, damageInfo);
+			if (pHit == nullptr) {
+				pHit = CreateHit();
+			}
+
+			pHit->CapturedStatusSetup = true;
+			pHit->Status = status;
+			MapHit(hitStatusMap_, status, pHit);
+
+			if (pHit->CapturedCharacterHit && pHit->CharacterHitPointer != nullptr) {
+				UnmapHit(characterHitMap_, pHit->CharacterHitPointer, pHit);
+				pHit->CharacterHitPointer = nullptr;
+			}
+
+			return pHit;
+		}
+
+		PendingHit* OnStatusHitEnter(StatusHit* status)
+		{
+			auto pHit = FindHit(hitStatusMap_, status);
+			if (pHit == nullptr) {
+				pHit = CreateHit();
+			}
+
+			pHit->CapturedStatusEnter = true;
+			pHit->Status = status;
+			MapHit(hitStatusDamageMap_, &status->DamageInfo, pHit);
+			return pHit;
+		}
+
+		void OnStatusHitDestroy(StatusHit* status)
+		{
+			auto hit = FindHit(hitStatusMap_, status);
+			if (hit != nullptr) {
+				DeleteHit(hit);
+			}
+		}
+
+		PendingHit* OnCharacterApplyDamage(HitDamageInfo* hit)
+		{
+			return FindHit(hitStatusDamageMap_, hit);
+		}
+
+		void DeleteHit(PendingHit* hit)
+		{
+			if (hit->CapturedStatusEnter) {
+				UnmapHit(hitStatusDamageMap_, &hit->Status->DamageInfo, hit);
+			}
+
+			if (hit->CapturedStatusSetup) {
+				UnmapHit(hitStatusMap_, hit->Status, hit);
+			}
+
+			if (hit->CapturedCharacterHit && hit->CharacterHitPointer != nullptr) {
+				UnmapHit(characterHitMap_, hit->CharacterHitPointer, hit);
+			}
+
+			hits_.Free(hit->Id);
+		}
+
+		std::size_t NumHits() const
+		{
+			return hits_.NumAllocated();
+		}
+
+	private:
+		template <class TKey>
+		using HitMap = PointerHashMap<TKey*, uint32_t>;
+
+		GenerationalPool<PendingHit> hits_;
+		HitMap<HitDamageInfo> characterHitMap_;
+		HitMap<StatusHit> hitStatusMap_;
+		HitMap<HitDamageInfo> hitStatusDamageMap_;
+
+		PendingHit* CreateHit()
+		{
+			uint32_t id;
+			auto hit = hits_.Allocate(id);
+			hit->Id = id;
+			return hit;
+		}
+
+		template <class TKey>
+		PendingHit* FindHit(HitMap<TKey>& map, TKey* key)
+		{
+			auto id = map.Find(key);
+			return id ? hits_.Get(*id) : nullptr;
+		}
+
+		template <class TKey>
+		void MapHit(HitMap<TKey>& map, TKey* key, PendingHit* hit)
+		{
+			auto id = map.Find(key);
+			if (id == nullptr) {
+				map.Insert(key, hit->Id);
+			} else if (hits_.Get(*id) == nullptr) {
+				*id = hit->Id;
+			}
+		}
+
+		template <class TKey>
+		void UnmapHit(HitMap<TKey>& map, TKey* key, PendingHit* hit)
+		{
+			auto id = map.Find(key);
+			if (id != nullptr && (*id == hit->Id || hits_.Get(*id) == nullptr)) {
+				map.Erase(key);
+			}
+		}
+	};
+}
+
+
+struct HitInput
+{
+	HitDamageInfo* DamageInfo;
+	GameArray* DamageList;
+	StatusHit* Status;
+};
+
+struct Result
+{
+	double NsPerHit;
+	double NewPerHit;
+	double GameAllocPerHit;
+	uint64_t Checksum;
+	std::size_t LeftoverHits;
+};
+
+// Each hit goes through the whole capture sequence; the StatusHit is destroyed `inFlight` hits later
+// (multiple hits are in progress at the same time, eg. AoE skills)
+template <class TManager>
+static Result Replay(std::vector<HitInput> const& inputs, std::size_t numHits, std::size_t inFlight)
+{
+	TManager manager;
+	uint64_t checksum{ 0 };
+
+	auto runHit = [&](std::size_t i) {
+		auto const& in = inputs[i % inputs.size()];
+		manager.OnCharacterHit(in.DamageList, in.DamageInfo);
+		manager.OnStatusHitSetup(in.Status, in.DamageInfo);
+		auto entered = manager.OnStatusHitEnter(in.Status);
+		auto applied = manager.OnCharacterApplyDamage(&in.Status->DamageInfo);
+		checksum += (applied == entered) + applied->CharacterHit.TotalDamage;
+
+		if (i >= inFlight) {
+			manager.OnStatusHitDestroy(inputs[(i - inFlight) % inputs.size()].Status);
+		}
+	};
+
+	// Warm up (grows maps and pools to their steady state size)
+	for (std::size_t i = 0; i < inputs.size() * 2; i++) {
+		runHit(i);
+	}
+
+	checksum = 0;
+	auto newCalls = gNewCalls;
+	auto gameAllocs = gGameAllocCalls;
+	auto start = std::chrono::steady_clock::now();
+	for (std::size_t i = inputs.size() * 2; i < inputs.size() * 2 + numHits; i++) {
+		runHit(i);
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	Result result;
+	result.NsPerHit = std::chrono::duration<double, std::nano>(end - start).count() / numHits;
+	result.NewPerHit = (double)(gNewCalls - newCalls) / numHits;
+	result.GameAllocPerHit = (double)(gGameAllocCalls - gameAllocs) / numHits;
+	result.Checksum = checksum;
+	result.LeftoverHits = manager.NumHits();
+	return result;
+}
+
+int main(int argc, char** argv)
+{
+	auto numHits = argc > 1 ? (std::size_t)atoll(argv[1]) : 2000000;
+	auto inFlight = argc > 2 ? (std::size_t)atoll(argv[2]) : 16;
+	std::mt19937 rng(1);
+
+	// Game objects are reused, so the ring is only slightly larger than the number of hits in flight
+	auto ringSize = inFlight + 8;
+	std::vector<std::unique_ptr<HitDamageInfo>> damageInfos;
+	std::vector<std::unique_ptr<GameArray>> damageLists;
+	std::vector<std::unique_ptr<StatusHit>> statuses;
+	std::vector<HitInput> inputs;
+	for (std::size_t slot = 0; slot < ringSize; slot++) {
+		damageInfos.push_back(std::make_unique<HitDamageInfo>());
+		damageLists.push_back(std::make_unique<GameArray>());
+		statuses.push_back(std::make_unique<StatusHit>());
+		inputs.push_back({ damageInfos[slot].get(), damageLists[slot].get(), statuses[slot].get() });
+	}
+
+	// Damage lists are fixed per ring slot: mostly 1-2 damage types, every 4th hit has 4-6
+	for (std::size_t slot = 0; slot < ringSize; slot++) {
+		uint32_t numTypes = slot % 4 == 3 ? 4 + (slot / 4) % 3 : 1 + slot % 2;
+		GameArray list;
+		list.Buf = (TDamagePair*)malloc(sizeof(TDamagePair) * numTypes);
+		list.Capacity = list.Size = numTypes;
+		for (uint32_t t = 0; t < numTypes; t++) {
+			list.Buf[t] = { (int32_t)(rng() % 100), t + 1 };
+		}
+
+		damageLists[slot]->CopyFrom(list);
+		damageInfos[slot]->DamageList.CopyFrom(list);
+		damageInfos[slot]->TotalDamage = (int32_t)slot;
+		free(list.Buf);
+	}
+
+	printf("%zu hits, %zu in flight, %zu reused game objects\n", numHits, inFlight, ringSize);
+	printf("Damage types per hit (ring slots):");
+	for (std::size_t slot = 0; slot < ringSize; slot++) {
+		printf(" %u", damageLists[slot]->Size);
+	}
+	printf("\n\n");
+
+	auto oldResult = Replay<old_impl::PendingHitManager>(inputs, numHits, inFlight);
+	auto newResult = Replay<new_impl::PendingHitManager>(inputs, numHits, inFlight);
+
+	printf("%-26s %10s %14s %14s %10s\n", "", "ns/hit", "new/hit", "game alloc/hit", "live hits");
+	printf("%-26s %10.1f %14.2f %14.2f %10zu\n", "make_unique+unordered_map", oldResult.NsPerHit,
+		oldResult.NewPerHit, oldResult.GameAllocPerHit, oldResult.LeftoverHits);
+	printf("%-26s %10.1f %14.2f %14.2f %10zu\n", "pool+flat maps", newResult.NsPerHit,
+		newResult.NewPerHit, newResult.GameAllocPerHit, newResult.LeftoverHits);
+
+	bool ok = oldResult.Checksum == newResult.Checksum && oldResult.LeftoverHits == newResult.LeftoverHits;
+	printf(ok ? "\nOK\n" : "\nFAILED: results differ\n");
+	return ok ? 0 : 1;
+}
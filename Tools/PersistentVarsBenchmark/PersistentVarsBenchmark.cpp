@@ -0,0 +1,238 @@
+// Save/load benchmark and change detection test for binary PersistentVars
+// (OsiInterface/Lua/LuaPersistentVars.cpp).
+//
+// Build (Linux, Lua compiled as C++ like LuaLib):
+//   g++ -O2 -std=c++17 -I../LuaBinaryMessageTest/shim -I../../External/lua-5.3.5/src -I../../OsiInterface
+//       PersistentVarsBenchmark.cpp ../../OsiInterface/Lua/LuaPersistentVars.cpp ../../OsiInterface/Lua/LuaJson.cpp
+//       -x c++ $(ls ../../External/lua-5.3.5/src/*.c | grep -v '/luac\?\.c$') -o PersistentVarsBenchmark
+//
+// Usage:
+//   PersistentVarsBenchmark [state size in MB] [rounds]
+//
+// Builds a synthetic PersistentVars table of the requested JSON size and times the save and
+// load paths of ServerState::GetModPersistentVars/RestoreModPersistentVars:
+//   - JSON: JSON text, as saved by extender versions before the binary format
+//   - binary, dirty: hash + serialize, for a mod that changed its variables since the last save
+//   - binary, clean: hash only, for a mod whose variables are unchanged (the previous blob is reused)
+// Before timing, checks that the binary format round-trips the state and that the hash changes
+// after each kind of modification a mod can make (including rawset and deep writes), and stays
+// the same for reloaded or metatable-wrapped copies.
+
+#include <stdafx.h>
+#include <Lua/LuaJson.h>
+#include <Lua/LuaPersistentVars.h>
+#include <lauxlib.h>
+#include <lualib.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace dse;
+using namespace dse::lua;
+
+static char const* const StateScript = R"(
+local function Guid(i)
+	return string.format("%08x-%04x-%04x-%04x-%012x", i * 2654435761 % 0x100000000,
+		i % 0x10000, (i * 7) % 0x10000, (i * 13) % 0x10000, i * 40503)
+end
+
+local statuses = { "BURNING", "WET", "HASTED", "BLESSED", "KNOCKED_DOWN", "INVISIBLE" }
+
+function MakeState(characters)
+	local state = { Version = 3, Initialized = true, Characters = {}, Quests = {}, CombatLog = {} }
+	for i = 1, characters do
+		state.Characters[Guid(i)] = {
+			Name = "Character_" .. i,
+			Level = i % 20 + 1,
+			Experience = i * 1337,
+			Position = { 100.25 + i, 12.5, -340.75 + i * 0.5 },
+			Statuses = { statuses[i % #statuses + 1], statuses[(i * 3) % #statuses + 1] },
+			Flags = { Visible = i % 3 ~= 0, Dead = i % 17 == 0, Tagged = i % 5 == 0 },
+			Cooldowns = { i % 4, i % 3, 0, 2 },
+			Notes = "Met at the \"Driftwood\" tavern\nwants 200 gold"
+		}
+	end
+
+	for i = 1, characters // 10 do
+		state.Quests["QUEST_" .. i] = { Stage = i % 7, Completed = i % 4 == 0, Giver = Guid(i) }
+	end
+
+	for i = 1, characters // 2 do
+		state.CombatLog[i] = { Turn = i, Attacker = Guid(i), Damage = i * 0.75, Type = "Physical" }
+	end
+
+	return state
+end
+
+FirstGuid = Guid(1)
+
+-- Each entry modifies the state in a way that must change its hash; the second function undoes it
+Modifications = {
+	{ "top-level write", function (s) s.Version = 4 end, function (s) s.Version = 3 end },
+	{ "new key", function (s) s.Extra = true end, function (s) s.Extra = nil end },
+	{ "deep write", function (s) s.Characters[FirstGuid].Position[2] = 13.5 end,
+		function (s) s.Characters[FirstGuid].Position[2] = 12.5 end },
+	{ "rawset", function (s) rawset(s.Characters[FirstGuid].Flags, "Dead", true) end,
+		function (s) rawset(s.Characters[FirstGuid].Flags, "Dead", false) end },
+	{ "integer to float", function (s) s.Characters[FirstGuid].Level = 2.0 end,
+		function (s) s.Characters[FirstGuid].Level = 2 end },
+	{ "string edit", function (s) s.Characters[FirstGuid].Name = "Character_2" end,
+		function (s) s.Characters[FirstGuid].Name = "Character_1" end },
+	{ "table.insert", function (s) table.insert(s.CombatLog, { Turn = 0 }) end,
+		function (s) table.remove(s.CombatLog) end },
+	{ "table.remove", function (s) Removed = table.remove(s.Characters[FirstGuid].Cooldowns, 1) end,
+		function (s) table.insert(s.Characters[FirstGuid].Cooldowns, 1, Removed) end },
+	{ "value moved to another key", function (s) s.Quests.QUEST_1, s.Quests.QUEST_X = nil, s.Quests.QUEST_1 end,
+		function (s) s.Quests.QUEST_X, s.Quests.QUEST_1 = nil, s.Quests.QUEST_X end },
+	{ "table replaced by its contents", function (s) Saved = s.Characters[FirstGuid].Flags; s.Characters[FirstGuid].Flags = Saved.Visible end,
+		function (s) s.Characters[FirstGuid].Flags = Saved end },
+}
+)";
+
+using Clock = std::chrono::steady_clock;
+
+static double ElapsedMs(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+[[noreturn]] static void Fail(char const* message)
+{
+	fprintf(stderr, "%s\n", message);
+	exit(1);
+}
+
+static uint64_t HashOrFail(lua_State* L, int index)
+{
+	auto hash = persistence::Hash(L, index);
+	if (!hash) Fail("Hash failed");
+	return *hash;
+}
+
+static void CallModification(lua_State* L, int state, int modification, int step)
+{
+	lua_rawgeti(L, modification, step);
+	lua_pushvalue(L, state);
+	if (lua_pcall(L, 1, 0, 0) != LUA_OK) Fail(lua_tostring(L, -1));
+}
+
+static void TestChangeDetection(lua_State* L, int state)
+{
+	auto hash = HashOrFail(L, state);
+	STDString blob, error;
+	persistence::Serialize(L, state, blob);
+
+	// A reloaded copy hashes the same (even though its tables iterate in a different order),
+	// so the restored blob is reused until the mod changes it
+	if (!persistence::Deserialize(L, StringView(blob), error)) Fail(error.c_str());
+	if (HashOrFail(L, -1) != hash) Fail("Reloaded state hashes differently");
+	lua_pop(L, 1);
+
+	// Metatables are not saved and don't affect the hash
+	lua_newtable(L);
+	lua_pushliteral(L, "__index");
+	lua_newtable(L);
+	lua_rawset(L, -3);
+	lua_setmetatable(L, state);
+	if (HashOrFail(L, state) != hash) Fail("Metatable changed the hash");
+	lua_pushnil(L);
+	lua_setmetatable(L, state);
+
+	lua_getglobal(L, "Modifications");
+	auto modifications = lua_gettop(L);
+	auto count = (int)lua_rawlen(L, modifications);
+	for (int i = 1; i <= count; i++) {
+		lua_rawgeti(L, modifications, i);
+		auto modification = lua_gettop(L);
+		lua_rawgeti(L, modification, 1);
+		auto name = lua_tostring(L, -1);
+
+		CallModification(L, state, modification, 2);
+		if (HashOrFail(L, state) == hash) {
+			fprintf(stderr, "Modification not detected: %s\n", name);
+			exit(1);
+		}
+
+		CallModification(L, state, modification, 3);
+		if (HashOrFail(L, state) != hash) {
+			fprintf(stderr, "Hash differs after undoing modification: %s\n", name);
+			exit(1);
+		}
+
+		lua_settop(L, modifications);
+	}
+
+	lua_pop(L, 1);
+
+	// Values that can't be saved can't be hashed either
+	lua_pushcfunction(L, [](lua_State*) { return 0; });
+	lua_setfield(L, state, "Callback");
+	if (persistence::Hash(L, state)) Fail("Function value was hashed");
+	lua_pushnil(L);
+	lua_setfield(L, state, "Callback");
+
+	printf("Change detection: %d modifications detected, reloaded and metatable copies unchanged\n\n", count);
+}
+
+int main(int argc, char** argv)
+{
+	auto sizeMb = argc > 1 ? atof(argv[1]) : 5.0;
+	auto rounds = argc > 2 ? atoi(argv[2]) : 5;
+
+	auto L = luaL_newstate();
+	luaL_openlibs(L);
+	if (luaL_dostring(L, StateScript)) Fail(lua_tostring(L, -1));
+
+	// A character record is about 520 bytes of beautified JSON, including its share of
+	// the quest table and the combat log
+	auto characters = std::max(1, (int)(sizeMb * 1024 * 1024 / 520));
+	lua_getglobal(L, "MakeState");
+	lua_pushinteger(L, characters);
+	if (lua_pcall(L, 1, 1, 0) != LUA_OK) Fail(lua_tostring(L, -1));
+	auto state = lua_gettop(L);
+
+	TestChangeDetection(L, state);
+
+	STDString json, blob, error;
+	double jsonSave{ 1e9 }, jsonLoad{ 1e9 }, dirtySave{ 1e9 }, cleanSave{ 1e9 }, binaryLoad{ 1e9 };
+	for (int round = 0; round < rounds; round++) {
+		auto start = Clock::now();
+		json.clear();
+		json::Stringify(L, state, false, json);
+		jsonSave = std::min(jsonSave, ElapsedMs(start));
+
+		start = Clock::now();
+		HashOrFail(L, state);
+		persistence::Serialize(L, state, blob);
+		dirtySave = std::min(dirtySave, ElapsedMs(start));
+
+		start = Clock::now();
+		HashOrFail(L, state);
+		cleanSave = std::min(cleanSave, ElapsedMs(start));
+
+		start = Clock::now();
+		if (!json::Parse(L, StringView(json), error)) Fail(error.c_str());
+		jsonLoad = std::min(jsonLoad, ElapsedMs(start));
+
+		// Includes hashing the restored variables, as RestoreModPersistentVars does
+		start = Clock::now();
+		if (!persistence::Deserialize(L, StringView(blob), error)) Fail(error.c_str());
+		HashOrFail(L, -1);
+		binaryLoad = std::min(binaryLoad, ElapsedMs(start));
+
+		lua_settop(L, state);
+		lua_gc(L, LUA_GCCOLLECT, 0);
+	}
+
+	printf("State: %d characters, %.2f MB of JSON, %.2f MB binary (best of %d rounds)\n\n",
+		characters, json.size() / (1024.0 * 1024.0), blob.size() / (1024.0 * 1024.0), rounds);
+	printf("%-16s %12s %12s\n", "", "save ms", "load ms");
+	printf("%-16s %12.2f %12.2f\n", "JSON", jsonSave, jsonLoad);
+	printf("%-16s %12.2f %12.2f\n", "binary, dirty", dirtySave, binaryLoad);
+	printf("%-16s %12.2f %12s\n", "binary, clean", cleanSave, "-");
+	printf("\nSave speedup vs JSON: dirty %.1fx, clean %.1fx\n", jsonSave / dirtySave, jsonSave / cleanSave);
+
+	lua_close(L);
+	return 0;
+}
@@ -0,0 +1,458 @@
+// Equivalence test and benchmark for the stat attribute descriptor cache (StatAttributeCache, OsiInterface/Stats.cpp).
+//
+// Build (Linux):
+//   g++ -O2 -std=c++17 StatAttributeCacheBenchmark.cpp -o StatAttributeCacheBenchmark
+//
+// Usage:
+//   StatAttributeCacheBenchmark [entries] [rounds]
+//
+// StatAttributeCache depends on the game's stats manager, so this is a model rather than a build of
+// Stats.cpp: it reproduces the data structures of both lookup paths and the dispatch of
+// LuaStatGetAttribute before and after the cache:
+//   - previous: FixedString compares against the 10 special attributes, then GetAttributeInfo (for
+//     the Conditions check), GetAttributeString and GetAttributeInt, each of them doing
+//     modifierList.Find, a NameHashMap lookup (game Map: 31 buckets, chained nodes, FixedString
+//     pointer hash), Attributes.Find and modifierValueList.Find, followed by the GFS.str* type compares
+//   - cached: one probe of the per-modifier list table, then a switch on the precomputed
+//     Special and Type fields
+// Each entry reads every attribute of its modifier list and the special attributes. Both paths must
+// resolve every access to the same result. Formatting the value (enum label search, AttributeFlags
+// string) is the same in both paths and is not included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// Interned string, compared and hashed by pointer like dse::FixedString
+struct FixedString
+{
+	char const* Str{ nullptr };
+
+	inline bool operator ==(FixedString const& o) const
+	{
+		return Str == o.Str;
+	}
+};
+
+template <>
+struct std::hash<FixedString>
+{
+	inline std::size_t operator ()(FixedString const& fs) const noexcept
+	{
+		return std::hash<uintptr_t>()((uintptr_t)fs.Str);
+	}
+};
+
+class StringPool
+{
+public:
+	FixedString Make(std::string const& str)
+	{
+		strings_.push_back(std::make_unique<std::string>(str));
+		return FixedString{ strings_.back()->c_str() };
+	}
+
+private:
+	std::vector<std::unique_ptr<std::string>> strings_;
+};
+
+// Same layout and lookup as dse::Map (GameDefinitions/BaseTypes.h)
+template <class TKey, class TValue>
+class GameMap
+{
+public:
+	GameMap(uint32_t hashSize)
+		: hashTable_(hashSize, nullptr)
+	{}
+
+	~GameMap()
+	{
+		for (auto node : hashTable_) {
+			while (node != nullptr) {
+				auto next = node->Next;
+				delete node;
+				node = next;
+			}
+		}
+	}
+
+	void Insert(TKey const& key, TValue const& value)
+	{
+		auto& bucket = hashTable_[(uint64_t)key.Str % hashTable_.size()];
+		auto node = new Node{ nullptr, key, value };
+		if (bucket == nullptr) {
+			bucket = node;
+		} else {
+			auto last = bucket;
+			while (last->Next != nullptr) last = last->Next;
+			last->Next = node;
+		}
+	}
+
+	TValue const* Find(TKey const& key) const
+	{
+		for (auto item = hashTable_[(uint64_t)key.Str % hashTable_.size()]; item != nullptr; item = item->Next) {
+			if (key == item->Key) {
+				return &item->Value;
+			}
+		}
+
+		return nullptr;
+	}
+
+private:
+	struct Node
+	{
+		Node* Next;
+		TKey Key;
+		TValue Value;
+	};
+
+	std::vector<Node*> hashTable_;
+};
+
+struct RPGEnumeration
+{
+	FixedString Name;
+	uint32_t ItemCount;
+};
+
+struct Modifier
+{
+	int32_t RPGEnumerationIndex;
+	FixedString Name;
+};
+
+struct ModifierList
+{
+	std::vector<Modifier*> Attributes;
+	GameMap<FixedString, uint32_t> NameHashMap{ 31 };
+};
+
+struct StatsObject
+{
+	int32_t ModifierListIndex;
+	std::vector<int32_t> IndexedProperties;
+};
+
+struct Names
+{
+	FixedString Specials[10];
+	FixedString FixedStringType, AttributeFlagsType, ConstantIntType, ConditionsType;
+};
+
+struct Stats
+{
+	std::vector<std::unique_ptr<RPGEnumeration>> modifierValueList;
+	std::vector<std::unique_ptr<ModifierList>> modifierList;
+	std::vector<std::vector<std::unique_ptr<Modifier>>> modifiers;
+	std::vector<StatsObject> objects;
+	// Attribute names of each modifier list followed by the special attributes, in access order
+	std::vector<std::vector<FixedString>> accessedNames;
+};
+
+// What LuaStatGetAttribute pushes (or the error it reports) for an attribute
+enum class Result : uint8_t
+{
+	Special,
+	Conditions,
+	String,
+	Flags,
+	Int,
+	Missing
+};
+
+struct Access
+{
+	Result Kind;
+	int32_t Value;
+};
+
+
+static RPGEnumeration* GetAttributeInfo(Stats const& stats, StatsObject const& object, FixedString const& name, int& attributeIndex)
+{
+	auto const& list = *stats.modifierList[object.ModifierListIndex];
+	auto index = list.NameHashMap.Find(name);
+	if (index == nullptr) {
+		return nullptr;
+	}
+
+	attributeIndex = (int)*index;
+	auto modifier = list.Attributes[*index];
+	return stats.modifierValueList[modifier->RPGEnumerationIndex].get();
+}
+
+static Access GetUncached(Stats const& stats, Names const& names, StatsObject const& object, FixedString const& name)
+{
+	for (auto const& special : names.Specials) {
+		if (name == special) {
+			return { Result::Special, 0 };
+		}
+	}
+
+	int index;
+	auto typeInfo = GetAttributeInfo(stats, object, name, index);
+	if (typeInfo && typeInfo->Name == names.ConditionsType) {
+		return { Result::Conditions, 0 };
+	}
+
+	// GetAttributeString
+	typeInfo = GetAttributeInfo(stats, object, name, index);
+	if (typeInfo != nullptr) {
+		auto value = object.IndexedProperties[index];
+		if (typeInfo->Name == names.FixedStringType) {
+			return { Result::String, value };
+		} else if (typeInfo->Name == names.AttributeFlagsType) {
+			return { Result::Flags, value };
+		} else if (typeInfo->ItemCount > 0) {
+			return { Result::String, value };
+		}
+	}
+
+	// GetAttributeInt
+	typeInfo = GetAttributeInfo(stats, object, name, index);
+	if (typeInfo != nullptr && (typeInfo->Name == names.ConstantIntType || typeInfo->ItemCount > 0)) {
+		return { Result::Int, object.IndexedProperties[index] };
+	}
+
+	return { Result::Missing, 0 };
+}
+
+
+enum class StatAttributeType : uint8_t
+{
+	None,
+	FixedString,
+	AttributeFlags,
+	ConstantInt,
+	Conditions,
+	Other
+};
+
+struct StatAttributeInfo
+{
+	FixedString Name;
+	RPGEnumeration* Enumeration{ nullptr };
+	int32_t Index{ -1 };
+	StatAttributeType Type{ StatAttributeType::None };
+	bool Special{ false };
+};
+
+using AttributeCache = std::vector<std::unordered_map<FixedString, StatAttributeInfo>>;
+
+static StatAttributeType GetStatAttributeType(Names const& names, RPGEnumeration* enumeration)
+{
+	if (enumeration == nullptr) {
+		return StatAttributeType::Other;
+	} else if (enumeration->Name == names.FixedStringType) {
+		return StatAttributeType::FixedString;
+	} else if (enumeration->Name == names.AttributeFlagsType) {
+		return StatAttributeType::AttributeFlags;
+	} else if (enumeration->Name == names.ConstantIntType) {
+		return StatAttributeType::ConstantInt;
+	} else if (enumeration->Name == names.ConditionsType) {
+		return StatAttributeType::Conditions;
+	} else {
+		return StatAttributeType::Other;
+	}
+}
+
+// Same as StatAttributeCache::BuildModifierLists
+static AttributeCache BuildCache(Stats const& stats, Names const& names)
+{
+	AttributeCache cache(stats.modifierList.size());
+	for (std::size_t i = 0; i < stats.modifierList.size(); i++) {
+		auto const& list = *stats.modifierList[i];
+		auto& attributes = cache[i];
+		attributes.reserve(list.Attributes.size() + std::size(names.Specials));
+
+		for (std::size_t j = 0; j < list.Attributes.size(); j++) {
+			auto modifier = list.Attributes[j];
+			StatAttributeInfo attribute;
+			attribute.Name = modifier->Name;
+			attribute.Index = (int32_t)j;
+			attribute.Enumeration = stats.modifierValueList[modifier->RPGEnumerationIndex].get();
+			attribute.Type = GetStatAttributeType(names, attribute.Enumeration);
+			attributes.insert(std::make_pair(modifier->Name, attribute));
+		}
+
+		for (auto const& special : names.Specials) {
+			auto& attribute = attributes[special];
+			attribute.Name = special;
+			attribute.Special = true;
+		}
+	}
+
+	return cache;
+}
+
+static Access GetCached(AttributeCache const& cache, StatsObject const& object, FixedString const& name)
+{
+	auto const& attributes = cache[object.ModifierListIndex];
+	auto it = attributes.find(name);
+	if (it == attributes.end()) {
+		return { Result::Missing, 0 };
+	}
+
+	auto const& attribute = it->second;
+	if (attribute.Special) {
+		return { Result::Special, 0 };
+	}
+
+	if (attribute.Index == -1 || attribute.Enumeration == nullptr) {
+		return { Result::Missing, 0 };
+	}
+
+	auto value = object.IndexedProperties[attribute.Index];
+	switch (attribute.Type) {
+	case StatAttributeType::Conditions: return { Result::Conditions, 0 };
+	case StatAttributeType::FixedString: return { Result::String, value };
+	case StatAttributeType::AttributeFlags: return { Result::Flags, value };
+	case StatAttributeType::ConstantInt: return { Result::Int, value };
+	default:
+		if (attribute.Enumeration->ItemCount > 0) {
+			return { Result::String, value };
+		} else {
+			return { Result::Missing, 0 };
+		}
+	}
+}
+
+
+// 5 modifier lists of 110 attributes (roughly the size of Character/Weapon/Armor/Skill lists).
+// Attribute types: 40% ConstantInt, 30% enumerations, 15% FixedString, 5% AttributeFlags,
+// 5% Conditions, 5% enumerations without labels
+static void MakeStats(Stats& stats, Names& names, StringPool& pool, unsigned numObjects, std::mt19937& rng)
+{
+	static char const* const specials[] = {
+		"Level", "Name", "ModId", "Using", "Requirements", "MemorizationRequirements",
+		"AIFlags", "ComboCategory", "SkillProperties", "ExtraProperties"
+	};
+
+	for (std::size_t i = 0; i < std::size(specials); i++) {
+		names.Specials[i] = pool.Make(specials[i]);
+	}
+
+	names.FixedStringType = pool.Make("FixedString");
+	names.AttributeFlagsType = pool.Make("AttributeFlags");
+	names.ConstantIntType = pool.Make("ConstantInt");
+	names.ConditionsType = pool.Make("Conditions");
+
+	stats.modifierValueList.push_back(std::make_unique<RPGEnumeration>(RPGEnumeration{ names.ConstantIntType, 0 }));
+	stats.modifierValueList.push_back(std::make_unique<RPGEnumeration>(RPGEnumeration{ names.FixedStringType, 0 }));
+	stats.modifierValueList.push_back(std::make_unique<RPGEnumeration>(RPGEnumeration{ names.AttributeFlagsType, 0 }));
+	stats.modifierValueList.push_back(std::make_unique<RPGEnumeration>(RPGEnumeration{ names.ConditionsType, 0 }));
+	stats.modifierValueList.push_back(std::make_unique<RPGEnumeration>(RPGEnumeration{ pool.Make("Guid"), 0 }));
+	for (unsigned i = 0; i < 60; i++) {
+		stats.modifierValueList.push_back(std::make_unique<RPGEnumeration>(RPGEnumeration{ pool.Make("Enum_" + std::to_string(i)), 2 + i % 10 }));
+	}
+
+	constexpr unsigned numLists = 5, numAttributes = 110;
+	stats.modifiers.resize(numLists);
+	stats.accessedNames.resize(numLists);
+	for (unsigned l = 0; l < numLists; l++) {
+		auto list = std::make_unique<ModifierList>();
+		for (unsigned a = 0; a < numAttributes; a++) {
+			auto roll = rng() % 100;
+			int32_t enumIndex = roll < 40 ? 0 : roll < 70 ? 5 + (int32_t)(rng() % 60) : roll < 85 ? 1 : roll < 90 ? 2 : roll < 95 ? 3 : 4;
+			auto name = pool.Make("List" + std::to_string(l) + "_Attribute" + std::to_string(a));
+			stats.modifiers[l].push_back(std::make_unique<Modifier>(Modifier{ enumIndex, name }));
+			list->NameHashMap.Insert(name, (uint32_t)list->Attributes.size());
+			list->Attributes.push_back(stats.modifiers[l].back().get());
+			stats.accessedNames[l].push_back(name);
+		}
+
+		for (auto const& special : names.Specials) {
+			stats.accessedNames[l].push_back(special);
+		}
+
+		// Unknown attributes, such as typos or attributes of another list
+		stats.accessedNames[l].push_back(pool.Make("Missing"));
+		stats.modifierList.push_back(std::move(list));
+	}
+
+	for (unsigned o = 0; o < numObjects; o++) {
+		StatsObject object{ (int32_t)(o % numLists), {} };
+		for (unsigned a = 0; a < numAttributes; a++) {
+			object.IndexedProperties.push_back((int32_t)(rng() % 1000));
+		}
+		stats.objects.push_back(std::move(object));
+	}
+}
+
+template <class Fun>
+static double TimeAccesses(Stats const& stats, Fun fun, uint64_t& checksum)
+{
+	auto start = Clock::now();
+	uint64_t accesses{ 0 }, sum{ 0 };
+	for (auto const& object : stats.objects) {
+		for (auto const& name : stats.accessedNames[object.ModifierListIndex]) {
+			auto access = fun(object, name);
+			sum = sum * 31 + (uint64_t)access.Kind * 1000 + (uint64_t)access.Value;
+			accesses++;
+		}
+	}
+
+	checksum = sum;
+	return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / accesses;
+}
+
+int main(int argc, char** argv)
+{
+	auto numObjects = argc > 1 ? (unsigned)atoi(argv[1]) : 4000;
+	auto rounds = argc > 2 ? atoi(argv[2]) : 5;
+
+	std::mt19937 rng(1);
+	StringPool pool;
+	Stats stats;
+	Names names;
+	MakeStats(stats, names, pool, numObjects, rng);
+	auto cache = BuildCache(stats, names);
+
+	uint64_t mismatches{ 0 }, accesses{ 0 };
+	for (auto const& object : stats.objects) {
+		for (auto const& name : stats.accessedNames[object.ModifierListIndex]) {
+			auto uncached = GetUncached(stats, names, object, name);
+			auto cached = GetCached(cache, object, name);
+			if (uncached.Kind != cached.Kind || uncached.Value != cached.Value) {
+				mismatches++;
+			}
+			accesses++;
+		}
+	}
+
+	printf("Equivalence: %llu accesses, %llu mismatches\n\n", (unsigned long long)accesses, (unsigned long long)mismatches);
+	if (mismatches != 0) return 1;
+
+	double uncachedNs{ 1e9 }, cachedNs{ 1e9 };
+	uint64_t uncachedSum{ 0 }, cachedSum{ 0 };
+	for (int round = 0; round < rounds; round++) {
+		uncachedNs = std::min(uncachedNs, TimeAccesses(stats, [&](StatsObject const& object, FixedString const& name) {
+			return GetUncached(stats, names, object, name);
+		}, uncachedSum));
+
+		cachedNs = std::min(cachedNs, TimeAccesses(stats, [&](StatsObject const& object, FixedString const& name) {
+			return GetCached(cache, object, name);
+		}, cachedSum));
+	}
+
+	if (uncachedSum != cachedSum) {
+		printf("Checksums differ!\n");
+		return 1;
+	}
+
+	printf("%u entries, %zu accesses per entry (best of %d rounds)\n", numObjects, stats.accessedNames[0].size(), rounds);
+	printf("%-10s %12s\n", "", "ns/access");
+	printf("%-10s %12.1f\n", "previous", uncachedNs);
+	printf("%-10s %12.1f\n", "cached", cachedNs);
+	return 0;
+}
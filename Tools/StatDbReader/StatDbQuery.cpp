@@ -0,0 +1,132 @@
+// Command line query tool for stats database files (see StatDbReader.h).
+//
+// Build (Linux):
+//   g++ -O2 -std=c++17 -I../../OsiInterface StatDbQuery.cpp StatDbReader.cpp -o StatDbQuery
+//
+// Usage:
+//   StatDbQuery <file> <entry> [attribute] [level]
+//   StatDbQuery <file> --scan
+//
+// Without an attribute all attributes of the entry are printed.
+// --scan reads every attribute value of every entry and prints the time it took.
+
+#include "StatDbReader.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace dse::statdb;
+
+static void PrintEntry(Reader const& db, uint32_t entryIndex, char const* attributeName, char const* level)
+{
+	auto const& entry = db.GetEntries()[entryIndex];
+	auto attributes = db.GetAttributes(entry.Type);
+
+	if (attributeName != nullptr) {
+		auto attribute = db.FindAttribute(entry.Type, attributeName);
+		if (!attribute) {
+			fprintf(stderr, "Type '%s' has no attribute named '%s'\n",
+				std::string(db.GetString(db.GetTypes()[entry.Type].Name)).c_str(), attributeName);
+			return;
+		}
+
+		if (level != nullptr) {
+			auto value = db.GetScaledValue(entryIndex, *attribute, atoi(level));
+			if (value) {
+				printf("%lld\n", (long long)*value);
+			} else {
+				fprintf(stderr, "Attribute is not level-scaled or level is out of range\n");
+			}
+		} else {
+			printf("%s\n", db.GetValueString(entryIndex, *attribute).c_str());
+		}
+		return;
+	}
+
+	printf("Name: %s\n", std::string(db.GetString(entry.Name)).c_str());
+	printf("Type: %s\n", std::string(db.GetString(db.GetTypes()[entry.Type].Name)).c_str());
+	if (entry.Using != None) {
+		printf("Using: %s\n", std::string(db.GetString(db.GetEntries()[entry.Using].Name)).c_str());
+	}
+	printf("ModId: %s\n", std::string(db.GetString(entry.ModId)).c_str());
+	printf("Level: %d\n", entry.Level);
+
+	for (uint32_t i = 0; i < attributes.Size; i++) {
+		auto value = db.GetValueString(entryIndex, i);
+		if (!value.empty()) {
+			printf("%s: %s\n", std::string(db.GetString(attributes[i].Name)).c_str(), value.c_str());
+		}
+	}
+
+	for (auto const& requirement : db.GetRequirements(entry)) {
+		printf("Requirement: %s%s %d %s\n", requirement.Negate ? "!" : "",
+			std::string(db.GetString(requirement.Name)).c_str(), requirement.IntParam,
+			std::string(db.GetString(requirement.StringParam)).c_str());
+	}
+
+	for (auto const& propertyList : db.GetPropertyLists(entry)) {
+		printf("%s:\n", std::string(db.GetString(propertyList.Name)).c_str());
+		for (auto const& prop : db.GetProperties(propertyList)) {
+			printf("  %s (%s)", std::string(db.GetString(prop.Name)).c_str(), std::string(db.GetString(prop.TypeName)).c_str());
+			for (auto param : db.GetStringParams(prop)) {
+				printf(" %s", std::string(db.GetString(param)).c_str());
+			}
+			for (auto param : db.GetIntParams(prop)) {
+				printf(" %d", param);
+			}
+			for (auto param : db.GetFloatParams(prop)) {
+				printf(" %g", param);
+			}
+			printf("\n");
+		}
+	}
+}
+
+static int Scan(Reader const& db)
+{
+	auto start = std::chrono::steady_clock::now();
+	uint64_t numValues = 0;
+	int64_t sum = 0;
+	for (uint32_t type = 0; type < db.GetTypes().Size; type++) {
+		for (uint32_t attribute = 0; attribute < db.GetAttributes(type).Size; attribute++) {
+			for (auto value : db.GetColumn(type, attribute)) {
+				sum += value;
+				numValues++;
+			}
+		}
+	}
+
+	auto end = std::chrono::steady_clock::now();
+	auto ms = std::chrono::duration<double>(end - start).count() * 1000.0;
+	printf("%zu entries, %llu values in %.2f ms (checksum %lld)\n", db.GetEntries().Size,
+		(unsigned long long)numValues, ms, (long long)sum);
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3) {
+		fprintf(stderr, "Usage: %s <file> <entry> [attribute] [level] | --scan\n", argv[0]);
+		return 1;
+	}
+
+	Reader db;
+	std::string error;
+	if (!db.Open(argv[1], error)) {
+		fprintf(stderr, "Failed to open %s: %s\n", argv[1], error.c_str());
+		return 1;
+	}
+
+	if (std::string(argv[2]) == "--scan") {
+		return Scan(db);
+	}
+
+	auto entry = db.FindEntry(argv[2]);
+	if (!entry) {
+		fprintf(stderr, "No stats entry named '%s'\n", argv[2]);
+		return 1;
+	}
+
+	PrintEntry(db, *entry, argc > 3 ? argv[3] : nullptr, argc > 4 ? argv[4] : nullptr);
+	return 0;
+}
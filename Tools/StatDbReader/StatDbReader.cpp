@@ -0,0 +1,450 @@
+#include "StatDbReader.h"
+#include <algorithm>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dse::statdb
+{
+	Reader::~Reader()
+	{
+		Close();
+	}
+
+	bool Reader::Map(std::string const& path, std::string& error)
+	{
+#if defined(_WIN32)
+		file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file_ == INVALID_HANDLE_VALUE) {
+			file_ = nullptr;
+			error = "Could not open file";
+			return false;
+		}
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file_, &size)) {
+			error = "Could not query file size";
+			return false;
+		}
+
+		size_ = (std::size_t)size.QuadPart;
+		if (size_ == 0) {
+			error = "File is empty";
+			return false;
+		}
+
+		fileMapping_ = CreateFileMappingA(file_, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (fileMapping_ == NULL) {
+			error = "Could not create file mapping";
+			return false;
+		}
+
+		mapping_ = MapViewOfFile(fileMapping_, FILE_MAP_READ, 0, 0, 0);
+		if (mapping_ == nullptr) {
+			error = "Could not map file";
+			return false;
+		}
+#else
+		fd_ = open(path.c_str(), O_RDONLY);
+		if (fd_ < 0) {
+			error = "Could not open file";
+			return false;
+		}
+
+		struct stat st;
+		if (fstat(fd_, &st) != 0) {
+			error = "Could not query file size";
+			return false;
+		}
+
+		size_ = (std::size_t)st.st_size;
+		if (size_ == 0) {
+			error = "File is empty";
+			return false;
+		}
+
+		auto mapping = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+		if (mapping == MAP_FAILED) {
+			error = "Could not map file";
+			return false;
+		}
+
+		mapping_ = mapping;
+#endif
+
+		return true;
+	}
+
+	void Reader::Unmap()
+	{
+#if defined(_WIN32)
+		if (mapping_ != nullptr) UnmapViewOfFile(mapping_);
+		if (fileMapping_ != nullptr) CloseHandle(fileMapping_);
+		if (file_ != nullptr) CloseHandle(file_);
+		fileMapping_ = nullptr;
+		file_ = nullptr;
+#else
+		if (mapping_ != nullptr) munmap(mapping_, size_);
+		if (fd_ >= 0) close(fd_);
+		fd_ = -1;
+#endif
+
+		mapping_ = nullptr;
+		size_ = 0;
+	}
+
+	bool Reader::Open(std::string const& path, std::string& error)
+	{
+		Close();
+		if (!Map(path, error) || !Validate(error)) {
+			Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void Reader::Close()
+	{
+		Unmap();
+		header_ = nullptr;
+		stringOffsets_ = {};
+		stringData_ = {};
+		types_ = {};
+		attributes_ = {};
+		enumerations_ = {};
+		enumLabels_ = {};
+		entries_ = {};
+		cells_ = {};
+		nameIndex_ = {};
+		flags_ = {};
+		flagNames_ = {};
+		comboCategories_ = {};
+		requirements_ = {};
+		propertyLists_ = {};
+		properties_ = {};
+		stringParams_ = {};
+		intParams_ = {};
+		floatParams_ = {};
+		boolParams_ = {};
+		levelMaps_ = {};
+		levelMapSamples_ = {};
+		levelMapValues_ = {};
+		extraData_ = {};
+	}
+
+	template <class T>
+	bool Reader::GetSection(SectionId id, Span<T>& span, std::string& error)
+	{
+		auto sections = reinterpret_cast<SectionHeader const*>(header_ + 1);
+		for (uint32_t i = 0; i < header_->NumSections; i++) {
+			auto const& section = sections[i];
+			if (section.Id != id) continue;
+
+			if (section.ElementSize != sizeof(T)
+				|| section.Offset % alignof(T) != 0
+				|| section.Offset > size_
+				|| section.Count > (size_ - section.Offset) / sizeof(T)) {
+				error = "Section " + std::to_string((uint32_t)id) + " is corrupted";
+				return false;
+			}
+
+			span.Data = reinterpret_cast<T const*>(reinterpret_cast<uint8_t const*>(mapping_) + section.Offset);
+			span.Size = (std::size_t)section.Count;
+			return true;
+		}
+
+		error = "Section " + std::to_string((uint32_t)id) + " is missing";
+		return false;
+	}
+
+	bool Reader::Validate(std::string& error)
+	{
+		if (size_ < sizeof(Header)) {
+			error = "File is too small";
+			return false;
+		}
+
+		header_ = reinterpret_cast<Header const*>(mapping_);
+		if (header_->Magic != FileMagic) {
+			error = "Not a stats database file";
+			return false;
+		}
+
+		if (header_->Version != FileVersion) {
+			error = "Unsupported file version " + std::to_string(header_->Version);
+			return false;
+		}
+
+		if (header_->NumSections > (size_ - sizeof(Header)) / sizeof(SectionHeader)) {
+			error = "Section table is corrupted";
+			return false;
+		}
+
+		if (!GetSection(SectionId::StringOffsets, stringOffsets_, error)
+			|| !GetSection(SectionId::StringData, stringData_, error)
+			|| !GetSection(SectionId::Types, types_, error)
+			|| !GetSection(SectionId::Attributes, attributes_, error)
+			|| !GetSection(SectionId::Enumerations, enumerations_, error)
+			|| !GetSection(SectionId::EnumLabels, enumLabels_, error)
+			|| !GetSection(SectionId::Entries, entries_, error)
+			|| !GetSection(SectionId::Cells, cells_, error)
+			|| !GetSection(SectionId::NameIndex, nameIndex_, error)
+			|| !GetSection(SectionId::Flags, flags_, error)
+			|| !GetSection(SectionId::FlagNames, flagNames_, error)
+			|| !GetSection(SectionId::ComboCategories, comboCategories_, error)
+			|| !GetSection(SectionId::Requirements, requirements_, error)
+			|| !GetSection(SectionId::PropertyLists, propertyLists_, error)
+			|| !GetSection(SectionId::Properties, properties_, error)
+			|| !GetSection(SectionId::StringParams, stringParams_, error)
+			|| !GetSection(SectionId::IntParams, intParams_, error)
+			|| !GetSection(SectionId::FloatParams, floatParams_, error)
+			|| !GetSection(SectionId::BoolParams, boolParams_, error)
+			|| !GetSection(SectionId::LevelMaps, levelMaps_, error)
+			|| !GetSection(SectionId::LevelMapSamples, levelMapSamples_, error)
+			|| !GetSection(SectionId::LevelMapValues, levelMapValues_, error)
+			|| !GetSection(SectionId::ExtraData, extraData_, error)) {
+			return false;
+		}
+
+		if (stringOffsets_.Size == 0
+			|| stringOffsets_[stringOffsets_.Size - 1] > stringData_.Size
+			|| nameIndex_.Size != entries_.Size) {
+			error = "Index is corrupted";
+			return false;
+		}
+
+		for (auto const& type : types_) {
+			if (type.FirstEntry > entries_.Size
+				|| type.NumEntries > entries_.Size - type.FirstEntry
+				|| type.FirstAttribute > attributes_.Size
+				|| type.NumAttributes > attributes_.Size - type.FirstAttribute
+				|| type.FirstCell > cells_.Size
+				|| (uint64_t)type.NumAttributes * type.NumEntries > cells_.Size - type.FirstCell) {
+				error = "Type table is corrupted";
+				return false;
+			}
+		}
+
+		for (auto const& entry : entries_) {
+			if (entry.Type >= types_.Size) {
+				error = "Entry table is corrupted";
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	template <class T>
+	Span<T> Reader::Slice(Span<T> const& span, uint32_t first, uint32_t count)
+	{
+		if (first > span.Size || count > span.Size - first) {
+			return {};
+		}
+
+		return Span<T>{ span.Data + first, count };
+	}
+
+	std::string_view Reader::GetString(uint32_t index) const
+	{
+		if ((uint64_t)index + 1 >= stringOffsets_.Size) {
+			return {};
+		}
+
+		auto start = stringOffsets_[index];
+		auto end = stringOffsets_[index + 1];
+		if (start >= end || end > stringData_.Size) {
+			return {};
+		}
+
+		// Offsets include the null terminator
+		return std::string_view(stringData_.Data + start, end - start - 1);
+	}
+
+	std::optional<uint32_t> Reader::FindType(std::string_view name) const
+	{
+		for (uint32_t i = 0; i < types_.Size; i++) {
+			if (GetString(types_[i].Name) == name) {
+				return i;
+			}
+		}
+
+		return {};
+	}
+
+	std::optional<uint32_t> Reader::FindEntry(std::string_view name) const
+	{
+		auto it = std::lower_bound(nameIndex_.begin(), nameIndex_.end(), name, [this](uint32_t entry, std::string_view name) {
+			return entry < entries_.Size && GetString(entries_[entry].Name) < name;
+		});
+
+		if (it != nameIndex_.end() && *it < entries_.Size && GetString(entries_[*it].Name) == name) {
+			return *it;
+		} else {
+			return {};
+		}
+	}
+
+	std::optional<uint32_t> Reader::FindAttribute(uint32_t type, std::string_view name) const
+	{
+		auto attributes = GetAttributes(type);
+		for (uint32_t i = 0; i < attributes.Size; i++) {
+			if (GetString(attributes[i].Name) == name) {
+				return i;
+			}
+		}
+
+		return {};
+	}
+
+	Span<Attribute> Reader::GetAttributes(uint32_t type) const
+	{
+		if (type >= types_.Size) return {};
+		return Slice(attributes_, types_[type].FirstAttribute, types_[type].NumAttributes);
+	}
+
+	Span<Entry> Reader::GetEntries(uint32_t type) const
+	{
+		if (type >= types_.Size) return {};
+		return Slice(entries_, types_[type].FirstEntry, types_[type].NumEntries);
+	}
+
+	Span<int32_t> Reader::GetColumn(uint32_t type, uint32_t attribute) const
+	{
+		if (type >= types_.Size) return {};
+
+		auto const& ty = types_[type];
+		if (attribute >= ty.NumAttributes) return {};
+
+		return Span<int32_t>{ cells_.Data + ty.FirstCell + (uint64_t)attribute * ty.NumEntries, ty.NumEntries };
+	}
+
+	int32_t Reader::GetValue(uint32_t entry, uint32_t attribute) const
+	{
+		auto const& type = types_[entries_[entry].Type];
+		return cells_[type.FirstCell + (uint64_t)attribute * type.NumEntries + (entry - type.FirstEntry)];
+	}
+
+	std::string Reader::GetValueString(uint32_t entry, uint32_t attribute) const
+	{
+		if (entry >= entries_.Size) return {};
+
+		auto attributes = GetAttributes(entries_[entry].Type);
+		if (attribute >= attributes.Size) return {};
+
+		auto const& attr = attributes[attribute];
+		auto value = GetValue(entry, attribute);
+		switch (attr.Kind) {
+		case AttributeKind::String:
+			return std::string(GetString((uint32_t)value));
+
+		case AttributeKind::Enumeration:
+			if (attr.Enumeration < enumerations_.Size) {
+				auto const& enumeration = enumerations_[attr.Enumeration];
+				auto labels = Slice(enumLabels_, enumeration.FirstLabel, enumeration.NumLabels);
+				if (value >= 0 && (uint32_t)value < labels.Size) {
+					return std::string(GetString(labels[value]));
+				}
+			}
+			return {};
+
+		case AttributeKind::Flags:
+		{
+			std::string flags;
+			if (value >= 0 && (uint32_t)value < flags_.Size) {
+				auto mask = flags_[value];
+				for (uint32_t i = 0; i < 64 && i < flagNames_.Size; i++) {
+					if (mask & (1ull << i)) {
+						if (!flags.empty()) flags += ';';
+						flags += GetString(flagNames_[i]);
+					}
+				}
+			}
+			return flags;
+		}
+
+		default:
+			return std::to_string(value);
+		}
+	}
+
+	std::optional<int64_t> Reader::GetScaledValue(uint32_t entry, uint32_t attribute, int32_t level) const
+	{
+		if (entry >= entries_.Size || level < header_->MinLevel || level > header_->MaxLevel) return {};
+
+		auto attributes = GetAttributes(entries_[entry].Type);
+		if (attribute >= attributes.Size || attributes[attribute].LevelMap >= levelMaps_.Size) return {};
+
+		auto const& levelMap = levelMaps_[attributes[attribute].LevelMap];
+		auto samples = Slice(levelMapSamples_, levelMap.FirstSample, levelMap.NumSamples);
+		auto input = GetValue(entry, attribute);
+		auto it = std::lower_bound(samples.begin(), samples.end(), input, [](LevelMapSample const& sample, int32_t input) {
+			return sample.Input < input;
+		});
+
+		if (it == samples.end() || it->Input != input) return {};
+
+		auto index = it->FirstValue + (uint64_t)(level - header_->MinLevel);
+		if (index >= levelMapValues_.Size) return {};
+
+		return levelMapValues_[index];
+	}
+
+	Span<uint32_t> Reader::GetComboCategories(Entry const& entry) const
+	{
+		return Slice(comboCategories_, entry.FirstComboCategory, entry.NumComboCategories);
+	}
+
+	Span<Requirement> Reader::GetRequirements(Entry const& entry) const
+	{
+		return Slice(requirements_, entry.FirstRequirement, entry.NumRequirements);
+	}
+
+	Span<Requirement> Reader::GetMemorizationRequirements(Entry const& entry) const
+	{
+		return Slice(requirements_, entry.FirstMemorizationRequirement, entry.NumMemorizationRequirements);
+	}
+
+	Span<PropertyList> Reader::GetPropertyLists(Entry const& entry) const
+	{
+		return Slice(propertyLists_, entry.FirstPropertyList, entry.NumPropertyLists);
+	}
+
+	Span<Property> Reader::GetProperties(PropertyList const& list) const
+	{
+		return Slice(properties_, list.FirstProperty, list.NumProperties);
+	}
+
+	Span<uint32_t> Reader::GetStringParams(Property const& prop) const
+	{
+		return Slice(stringParams_, prop.FirstStringParam, prop.NumStringParams);
+	}
+
+	Span<int32_t> Reader::GetIntParams(Property const& prop) const
+	{
+		return Slice(intParams_, prop.FirstIntParam, prop.NumIntParams);
+	}
+
+	Span<float> Reader::GetFloatParams(Property const& prop) const
+	{
+		return Slice(floatParams_, prop.FirstFloatParam, prop.NumFloatParams);
+	}
+
+	Span<uint8_t> Reader::GetBoolParams(Property const& prop) const
+	{
+		return Slice(boolParams_, prop.FirstBoolParam, prop.NumBoolParams);
+	}
+
+	Span<int32_t> Reader::GetSurfaceBoosts(Property const& prop) const
+	{
+		return Slice(intParams_, prop.FirstSurfaceBoost, prop.NumSurfaceBoosts);
+	}
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+// Reader for stats database files written by the extender "statdb" console command.
+// The file is memory-mapped and queried in-place; nothing is parsed when it is opened.
+//
+// Build (Linux):
+//   g++ -O2 -std=c++17 -I../../OsiInterface -c StatDbReader.cpp
+
+#include "StatDatabase.h"
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace dse::statdb
+{
+	template <class T>
+	struct Span
+	{
+		T const* Data{ nullptr };
+		std::size_t Size{ 0 };
+
+		inline T const* begin() const
+		{
+			return Data;
+		}
+
+		inline T const* end() const
+		{
+			return Data + Size;
+		}
+
+		inline T const& operator [](std::size_t index) const
+		{
+			return Data[index];
+		}
+	};
+
+	class Reader
+	{
+	public:
+		Reader() = default;
+		Reader(Reader const&) = delete;
+		Reader& operator = (Reader const&) = delete;
+		~Reader();
+
+		bool Open(std::string const& path, std::string& error);
+		void Close();
+
+		inline int32_t GetMinLevel() const
+		{
+			return header_->MinLevel;
+		}
+
+		inline int32_t GetMaxLevel() const
+		{
+			return header_->MaxLevel;
+		}
+
+		// Returns an empty string for None
+		std::string_view GetString(uint32_t index) const;
+
+		inline Span<Type> GetTypes() const
+		{
+			return types_;
+		}
+
+		inline Span<Entry> GetEntries() const
+		{
+			return entries_;
+		}
+
+		std::optional<uint32_t> FindType(std::string_view name) const;
+		// Binary search on the name index
+		std::optional<uint32_t> FindEntry(std::string_view name) const;
+		// Returns the index of the attribute within the type
+		std::optional<uint32_t> FindAttribute(uint32_t type, std::string_view name) const;
+
+		Span<Attribute> GetAttributes(uint32_t type) const;
+		// Entries of the type, in load order
+		Span<Entry> GetEntries(uint32_t type) const;
+		// Values of an attribute for all entries of the type (one cell per GetEntries(type) element)
+		Span<int32_t> GetColumn(uint32_t type, uint32_t attribute) const;
+
+		// Doesn't check the entry and attribute indices, for use in tight loops
+		int32_t GetValue(uint32_t entry, uint32_t attribute) const;
+		// Value of an enumeration, string or flags attribute as a string
+		// (flags are separated by ';'), or the integer value for other attributes
+		std::string GetValueString(uint32_t entry, uint32_t attribute) const;
+		// Value of a level-scaled attribute at the specified level
+		std::optional<int64_t> GetScaledValue(uint32_t entry, uint32_t attribute, int32_t level) const;
+
+		Span<uint32_t> GetComboCategories(Entry const& entry) const;
+		Span<Requirement> GetRequirements(Entry const& entry) const;
+		Span<Requirement> GetMemorizationRequirements(Entry const& entry) const;
+		Span<PropertyList> GetPropertyLists(Entry const& entry) const;
+		Span<Property> GetProperties(PropertyList const& list) const;
+		Span<uint32_t> GetStringParams(Property const& prop) const;
+		Span<int32_t> GetIntParams(Property const& prop) const;
+		Span<float> GetFloatParams(Property const& prop) const;
+		Span<uint8_t> GetBoolParams(Property const& prop) const;
+		Span<int32_t> GetSurfaceBoosts(Property const& prop) const;
+
+		inline Span<ExtraDataValue> GetExtraData() const
+		{
+			return extraData_;
+		}
+
+	private:
+		void* mapping_{ nullptr };
+		std::size_t size_{ 0 };
+#if defined(_WIN32)
+		void* file_{ nullptr };
+		void* fileMapping_{ nullptr };
+#else
+		int fd_{ -1 };
+#endif
+
+		Header const* header_{ nullptr };
+		Span<uint32_t> stringOffsets_;
+		Span<char> stringData_;
+		Span<Type> types_;
+		Span<Attribute> attributes_;
+		Span<Enumeration> enumerations_;
+		Span<uint32_t> enumLabels_;
+		Span<Entry> entries_;
+		Span<int32_t> cells_;
+		Span<uint32_t> nameIndex_;
+		Span<uint64_t> flags_;
+		Span<uint32_t> flagNames_;
+		Span<uint32_t> comboCategories_;
+		Span<Requirement> requirements_;
+		Span<PropertyList> propertyLists_;
+		Span<Property> properties_;
+		Span<uint32_t> stringParams_;
+		Span<int32_t> intParams_;
+		Span<float> floatParams_;
+		Span<uint8_t> boolParams_;
+		Span<LevelMap> levelMaps_;
+		Span<LevelMapSample> levelMapSamples_;
+		Span<int64_t> levelMapValues_;
+		Span<ExtraDataValue> extraData_;
+
+		bool Map(std::string const& path, std::string& error);
+		void Unmap();
+		bool Validate(std::string& error);
+
+		template <class T>
+		bool GetSection(SectionId id, Span<T>& span, std::string& error);
+
+		template <class T>
+		static Span<T> Slice(Span<T> const& span, uint32_t first, uint32_t count);
+	};
+}
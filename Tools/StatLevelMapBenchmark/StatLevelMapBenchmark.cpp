@@ -0,0 +1,253 @@
+// Consistency test and benchmark for the level-scaled attribute cache (OsiInterface/StatLevelMapCache.h).
+//
+// Build (Linux):
+//   g++ -O2 -std=c++17 -pthread -I../../OsiInterface StatLevelMapBenchmark.cpp -o StatLevelMapBenchmark
+//
+// Usage:
+//   StatLevelMapBenchmark [reads] [rounds]
+//
+// Level maps are a stand-in for the game's formula level maps (a virtual GetScaledValue doing
+// floating point math); the game's own implementation is at least as expensive.
+//
+// Consistency: every cached read must equal the direct level map call, including levels outside
+// the cached range; after a level map is overridden (StatSetLevelScaling) the cache must return
+// the override's values, and after it is restored the original values again, on the thread
+// that filled the table before the change. Reader threads must see the same values as the
+// direct calls while filling their own tables.
+//
+// Benchmark: 8 level maps x 8 attribute values x levels 1-35, read in random order and as one
+// repeated (level map, value, level) triple, like tooltips and AI scoring do. Compared with calling
+// the level map directly and with a single table shared by all threads behind a shared_mutex,
+// the alternative to per-thread tables.
+
+#include <StatLevelMapCache.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+
+using namespace dse;
+using Clock = std::chrono::steady_clock;
+
+struct LevelMap
+{
+	virtual ~LevelMap() {}
+	virtual int64_t GetScaledValue(int value, int level) = 0;
+};
+
+struct FormulaLevelMap : public LevelMap
+{
+	float Extra[4];
+
+	FormulaLevelMap(float base, float growth, float perLevel, float log)
+		: Extra{ base, growth, perLevel, log }
+	{}
+
+	int64_t GetScaledValue(int value, int level) override
+	{
+		auto base = Extra[0] * std::pow(Extra[1], (float)level) + Extra[2] * level;
+		return (int64_t)std::round(base * value / 100.0f * (1.0f + Extra[3] * std::log((float)level + 1)));
+	}
+};
+
+// Stand-in for a Lua override installed by StatSetLevelScaling
+struct OverrideLevelMap : public LevelMap
+{
+	int64_t GetScaledValue(int value, int level) override
+	{
+		return (int64_t)value * 1000 + level;
+	}
+};
+
+// Alternative design: one table shared by all threads
+class SharedLevelMapCache
+{
+public:
+	int64_t GetScaledValue(LevelMap* levelMap, int32_t levelMapIndex, int32_t value, int32_t level)
+	{
+		if (level < 1 || level > StatLevelMapCache::MaxCachedLevel) {
+			return levelMap->GetScaledValue(value, level);
+		}
+
+		auto key = ((uint64_t)(uint32_t)levelMapIndex << 32) | (uint32_t)value;
+		auto levelBit = 1ull << (level - 1);
+		{
+			std::shared_lock lock(mutex_);
+			auto it = values_.find(key);
+			if (it != values_.end() && (it->second.Filled & levelBit)) {
+				return it->second.Values[level - 1];
+			}
+		}
+
+		auto scaled = levelMap->GetScaledValue(value, level);
+		std::unique_lock lock(mutex_);
+		auto& values = values_[key];
+		values.Values[level - 1] = scaled;
+		values.Filled |= levelBit;
+		return scaled;
+	}
+
+private:
+	struct LevelValues
+	{
+		uint64_t Filled{ 0 };
+		int64_t Values[StatLevelMapCache::MaxCachedLevel];
+	};
+
+	std::shared_mutex mutex_;
+	std::unordered_map<uint64_t, LevelValues> values_;
+};
+
+struct Read
+{
+	int32_t LevelMap, Value, Level;
+};
+
+static std::vector<std::unique_ptr<LevelMap>> gLevelMaps;
+
+static LevelMap* FindLevelMap(int32_t index)
+{
+	return gLevelMaps[index].get();
+}
+
+[[noreturn]] static void Fail(char const* message)
+{
+	fprintf(stderr, "%s\n", message);
+	exit(1);
+}
+
+static int64_t ReadCached(StatLevelMapCache& cache, Read const& read)
+{
+	return cache.GetScaledValue(read.LevelMap, read.Value, read.Level, FindLevelMap);
+}
+
+static void CheckReads(StatLevelMapCache& cache, std::vector<Read> const& reads, char const* message)
+{
+	for (auto const& read : reads) {
+		if (ReadCached(cache, read) != FindLevelMap(read.LevelMap)->GetScaledValue(read.Value, read.Level)) {
+			Fail(message);
+		}
+	}
+}
+
+static void TestConsistency(std::vector<Read> const& reads)
+{
+	StatLevelMapCache cache;
+	// Fill the tables, then read back from them
+	CheckReads(cache, reads, "Cached value differs from the level map");
+	CheckReads(cache, reads, "Cached value differs from the level map");
+
+	std::vector<Read> outOfRange;
+	for (int32_t level : { -1, 0, StatLevelMapCache::MaxCachedLevel + 1, 200 }) {
+		outOfRange.push_back(Read{ 2, 100, level });
+	}
+	CheckReads(cache, outOfRange, "Value outside the cached level range differs from the level map");
+
+	// StatSetLevelScaling replaces the level map before invalidating it
+	auto original = std::move(gLevelMaps[3]);
+	gLevelMaps[3] = std::make_unique<OverrideLevelMap>();
+	cache.Invalidate(3, true);
+	CheckReads(cache, reads, "Stale value returned after overriding a level map");
+
+	std::thread([&]() {
+		CheckReads(cache, reads, "Stale value returned on another thread after overriding a level map");
+	}).join();
+
+	// RestoreLevelMaps
+	gLevelMaps[3] = std::move(original);
+	cache.Invalidate(3, false);
+	CheckReads(cache, reads, "Stale value returned after restoring a level map");
+	CheckReads(cache, reads, "Stale value returned after restoring a level map");
+
+	// Stats reload
+	cache.Clear();
+	CheckReads(cache, reads, "Cached value differs from the level map after Clear()");
+
+	std::vector<std::thread> threads;
+	for (unsigned i = 0; i < 4; i++) {
+		threads.emplace_back([&]() {
+			CheckReads(cache, reads, "Cached value differs from the level map on a reader thread");
+			CheckReads(cache, reads, "Cached value differs from the level map on a reader thread");
+		});
+	}
+
+	for (auto& thread : threads) thread.join();
+
+	printf("Consistency: %zu reads match the level maps (in range, out of range, override, restore, "
+		"clear, 4 reader threads)\n\n", reads.size());
+}
+
+template <class Fun>
+static double TimeReads(std::vector<Read> const& reads, int rounds, Fun fun, int64_t& checksum)
+{
+	double best{ 1e9 };
+	for (int round = 0; round < rounds; round++) {
+		int64_t sum{ 0 };
+		auto start = Clock::now();
+		for (auto const& read : reads) {
+			sum += fun(read);
+		}
+
+		best = std::min(best, std::chrono::duration<double, std::nano>(Clock::now() - start).count() / reads.size());
+		checksum = sum;
+	}
+
+	return best;
+}
+
+static void Benchmark(char const* name, std::vector<Read> const& reads, int rounds)
+{
+	StatLevelMapCache cache;
+	SharedLevelMapCache sharedCache;
+	int64_t directSum{ 0 }, cachedSum{ 0 }, sharedSum{ 0 };
+
+	auto directNs = TimeReads(reads, rounds, [](Read const& read) {
+		return FindLevelMap(read.LevelMap)->GetScaledValue(read.Value, read.Level);
+	}, directSum);
+
+	auto cachedNs = TimeReads(reads, rounds, [&](Read const& read) {
+		return ReadCached(cache, read);
+	}, cachedSum);
+
+	auto sharedNs = TimeReads(reads, rounds, [&](Read const& read) {
+		return sharedCache.GetScaledValue(FindLevelMap(read.LevelMap), read.LevelMap, read.Value, read.Level);
+	}, sharedSum);
+
+	if (directSum != cachedSum || directSum != sharedSum) {
+		Fail("Checksums differ");
+	}
+
+	printf("%-14s %12.1f %12.1f %12.1f\n", name, directNs, cachedNs, sharedNs);
+}
+
+int main(int argc, char** argv)
+{
+	auto numReads = argc > 1 ? (std::size_t)atoll(argv[1]) : (1 << 20);
+	auto rounds = argc > 2 ? atoi(argv[2]) : 10;
+
+	for (int i = 0; i < 8; i++) {
+		gLevelMaps.push_back(std::make_unique<FormulaLevelMap>(1.0f + i * 0.1f, 1.1f, 1.25f, 0.5f));
+	}
+
+	std::mt19937 rng(1);
+	int32_t const values[] = { 25, 50, 75, 100, 110, 125, 150, 200 };
+	std::vector<Read> randomReads(numReads);
+	for (auto& read : randomReads) {
+		read = Read{ (int32_t)(rng() % 8), values[rng() % 8], (int32_t)(rng() % 35) + 1 };
+	}
+
+	TestConsistency(randomReads);
+
+	std::vector<Read> sameReads(numReads, Read{ 3, 100, 20 });
+
+	printf("%zu reads (best of %d rounds)\n", numReads, rounds);
+	printf("%-14s %12s %12s %12s\n", "ns/read", "direct", "per thread", "shared");
+	Benchmark("random", randomReads, rounds);
+	Benchmark("same triple", sameReads, rounds);
+	return 0;
+}
@@ -0,0 +1,248 @@
+// Equivalence test and benchmark for stats load order tracking (OsiInterface/StatLoadOrder.h).
+//
+// Build (Linux):
+//   g++ -O2 -std=c++17 -I../../OsiInterface StatLoadOrderBenchmark.cpp -o StatLoadOrderBenchmark
+//
+// Usage:
+//   StatLoadOrderBenchmark [random paths] [seed]
+//
+// Path matcher: compares MatchStatsFilePath with the std::regex it replaced on fixed cases and
+// on random paths assembled from the fragments that matter to the pattern ("/Public/",
+// "/Stats/Generated/", "txt", ...), including the capture group.
+//
+// Load order: replays synthetic stats loads (20 entries per file, 15% of them overriding an entry
+// of an earlier file, some files that don't match the pattern or belong to an unknown mod) with
+// the previous algorithm (std::regex + a scan of the whole pre-parse map on each opened file) and
+// with PreParseBufferRanges, and checks that every entry is attributed to the same mod.
+
+#include "StatLoadOrder.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace dse;
+using Clock = std::chrono::steady_clock;
+
+static std::regex sStatPathRegex(".*/Public/(.*)/Stats/Generated/.*.txt$");
+
+static bool CheckPath(std::string const& path)
+{
+	std::cmatch match;
+	bool regexMatched = std::regex_match(path.c_str(), match, sStatPathRegex);
+	std::string_view modDirectory;
+	bool matched = MatchStatsFilePath(path, modDirectory);
+	if (regexMatched != matched || (matched && match[1].str() != modDirectory)) {
+		printf("Mismatch: '%s': regex %d '%s', matcher %d '%.*s'\n", path.c_str(), regexMatched,
+			regexMatched ? match[1].str().c_str() : "", matched, (int)modDirectory.size(), modDirectory.data());
+		return false;
+	}
+
+	return true;
+}
+
+static bool TestPathMatcher(std::size_t numRandom, std::mt19937& rng)
+{
+	static char const* const cases[] = {
+		"C:/Games/DOS2/Data/Public/Shared/Stats/Generated/Data/Skill_Target.txt",
+		"C:/Games/DOS2/Data/Public/Shared/Stats/Generated/Structure/Modifiers.txt",
+		"C:/Games/DOS2/Data/Public/Shared/Stats/Generated/Data/Skill_Target.stats",
+		"C:/Games/DOS2/Data/Mods/Shared/Stats/Generated/Data/Skill_Target.txt",
+		"a/Public/x/Public/y/Stats/Generated/z/Stats/Generated/q.txt",
+		"/Public/a/Stats/Generated/bbbb/Stats/Generated/txt",
+		"/Public/a/Stats/Generated/b/Public/c/Stats/Generated/.txt",
+		"/Public//Stats/Generated/.txt",
+		"/Public/a/Stats/Generated/txt",
+		"/Public/a/Stats/Generated/xtxt",
+		"/Public/a/Stats/Generated/abc.txt.txt",
+		"/Public/Stats/Generated/a.txt",
+		"Public/a/Stats/Generated/x.txt",
+		"x/Public/a/Stats/Generated/b/Public/c.txt",
+		"/Public/a/Stats/Generated/",
+		"",
+	};
+
+	std::size_t mismatches = 0;
+	for (auto path : cases) {
+		if (!CheckPath(path)) mismatches++;
+	}
+
+	static char const* const fragments[] = {
+		"/Public/", "/Stats/Generated/", "/Stats/", "/Generated/", "Public", "/", "txt", ".txt", "x", "Mod_1", "Data"
+	};
+	constexpr auto numFragments = sizeof(fragments) / sizeof(*fragments);
+
+	std::string path;
+	for (std::size_t i = 0; i < numRandom; i++) {
+		path.clear();
+		auto length = 1 + rng() % 8;
+		for (std::size_t j = 0; j < length; j++) {
+			path += fragments[rng() % numFragments];
+		}
+
+		if (!CheckPath(path)) mismatches++;
+	}
+
+	printf("Path matcher: %zu fixed and %zu random paths, %zu mismatches\n\n",
+		sizeof(cases) / sizeof(*cases), numRandom, mismatches);
+	return mismatches == 0;
+}
+
+
+struct LoadOrder
+{
+	// Path of each opened stats file
+	std::vector<std::string> Paths;
+	// Keys of the entries pre-parsed after each file was opened
+	std::vector<std::vector<uint32_t>> Entries;
+	std::unordered_map<std::string, int> ModDirectories;
+	uint32_t NumKeys{ 0 };
+};
+
+static LoadOrder MakeLoadOrder(unsigned numFiles, unsigned entriesPerFile, std::mt19937& rng)
+{
+	LoadOrder order;
+	for (unsigned mod = 0; mod <= numFiles / 50; mod++) {
+		order.ModDirectories.insert(std::make_pair("Mod_" + std::to_string(mod) + "_abcdef", (int)mod + 1));
+	}
+
+	for (unsigned file = 0; file < numFiles; file++) {
+		auto modDir = (file % 60 == 59) ? std::string("Unknown_Mod") : "Mod_" + std::to_string(file / 50) + "_abcdef";
+		auto extension = (file % 40 == 39) ? ".stats" : ".txt";
+		order.Paths.push_back("C:/Games/DOS2/Data/Public/" + modDir + "/Stats/Generated/Data/File" + std::to_string(file) + extension);
+
+		std::vector<uint32_t> entries;
+		for (unsigned i = 0; i < entriesPerFile; i++) {
+			if (order.NumKeys > 0 && rng() % 100 < 15) {
+				entries.push_back(rng() % order.NumKeys);
+			} else {
+				entries.push_back(order.NumKeys++);
+			}
+		}
+
+		order.Entries.push_back(std::move(entries));
+	}
+
+	return order;
+}
+
+// Previous implementation: each opened file rescans the whole pre-parse map
+static std::unordered_map<uint32_t, int> AttributeByScan(LoadOrder const& order)
+{
+	std::unordered_map<uint32_t, uint32_t> preParseMap;
+	uint32_t numBuffers{ 0 };
+	struct Mapping
+	{
+		int Mod;
+		uint32_t Buffer;
+	};
+	std::unordered_map<uint32_t, Mapping> entryMods;
+	int lastMod{ 0 };
+
+	auto scan = [&]() {
+		for (auto const& entry : preParseMap) {
+			auto it = entryMods.find(entry.first);
+			if (it == entryMods.end()) {
+				entryMods.insert(std::make_pair(entry.first, Mapping{ lastMod, entry.second }));
+			} else if (it->second.Buffer != entry.second) {
+				it->second = Mapping{ lastMod, entry.second };
+			}
+		}
+	};
+
+	for (std::size_t file = 0; file < order.Paths.size(); file++) {
+		std::cmatch match;
+		if (std::regex_match(order.Paths[file].c_str(), match, sStatPathRegex)) {
+			auto mod = order.ModDirectories.find(match[1].str());
+			if (mod != order.ModDirectories.end()) {
+				lastMod = mod->second;
+				scan();
+			}
+		}
+
+		for (auto key : order.Entries[file]) {
+			preParseMap[key] = numBuffers++;
+		}
+	}
+
+	scan();
+
+	std::unordered_map<uint32_t, int> result;
+	for (auto const& entry : entryMods) {
+		result.insert(std::make_pair(entry.first, entry.second.Mod));
+	}
+
+	return result;
+}
+
+// StatLoadOrderHelper: each opened file adds a range, entries are attributed once at the end
+static std::unordered_map<uint32_t, int> AttributeByRanges(LoadOrder const& order)
+{
+	std::unordered_map<uint32_t, uint32_t> preParseMap;
+	uint32_t numBuffers{ 0 };
+	PreParseBufferRanges<int> ranges;
+	int lastMod{ 0 };
+
+	for (std::size_t file = 0; file < order.Paths.size(); file++) {
+		std::string_view modDirectory;
+		if (MatchStatsFilePath(order.Paths[file], modDirectory)) {
+			auto mod = order.ModDirectories.find(std::string(modDirectory));
+			if (mod != order.ModDirectories.end()) {
+				lastMod = mod->second;
+				ranges.Add(numBuffers, lastMod);
+			}
+		}
+
+		for (auto key : order.Entries[file]) {
+			preParseMap[key] = numBuffers++;
+		}
+	}
+
+	ranges.Add(numBuffers, lastMod);
+
+	std::unordered_map<uint32_t, int> result;
+	result.reserve(preParseMap.size());
+	for (auto const& entry : preParseMap) {
+		auto mod = ranges.Find(entry.second);
+		if (mod != nullptr) {
+			result.insert(std::make_pair(entry.first, *mod));
+		}
+	}
+
+	return result;
+}
+
+int main(int argc, char** argv)
+{
+	auto numRandom = argc > 1 ? (std::size_t)atoll(argv[1]) : 200000;
+	auto seed = argc > 2 ? (unsigned)atoi(argv[2]) : 1;
+	std::mt19937 rng(seed);
+
+	bool ok = TestPathMatcher(numRandom, rng);
+
+	constexpr unsigned entriesPerFile = 20;
+	printf("%-8s %10s %14s %14s\n", "files", "entries", "scan ms", "ranges ms");
+	for (unsigned numFiles : { 200u, 1000u, 3000u }) {
+		auto order = MakeLoadOrder(numFiles, entriesPerFile, rng);
+
+		auto start = Clock::now();
+		auto scanned = AttributeByScan(order);
+		auto scanMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		start = Clock::now();
+		auto ranged = AttributeByRanges(order);
+		auto rangesMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		printf("%-8u %10u %14.1f %14.1f\n", numFiles, order.NumKeys, scanMs, rangesMs);
+		if (scanned != ranged) {
+			printf("Entries attributed to different mods!\n");
+			ok = false;
+		}
+	}
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+// Standalone throughput harness for the stat text tokenizer (StatParser.cpp).
+// This measures the tokenizer only; the game still loads and parses stat files
+// serially, and nothing here is used by the extender.
+//
+// Build (Linux):
+//   g++ -O2 -std=c++17 -pthread StatParseBench.cpp StatParser.cpp -o StatParseBench
+//
+// Usage:
+//   StatParseBench <corpus directory> [threads] [iterations]
+//   StatParseBench --synthetic <files> [threads] [iterations]
+//
+// The corpus directory is scanned recursively for *.txt files (eg. an extracted
+// Public/ directory of the load order); files are processed in sorted path order.
+
+#include "StatParser.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+using namespace dse;
+namespace fs = std::filesystem;
+
+struct Corpus
+{
+	std::vector<std::string> Paths;
+	// Only used for synthetic corpora
+	std::vector<std::string> Contents;
+};
+
+static bool LoadCorpusFile(Corpus const& corpus, std::size_t index, StatTextFile& file)
+{
+	file.Path = corpus.Paths[index];
+	if (!corpus.Contents.empty()) {
+		auto const& contents = corpus.Contents[index];
+		file.Contents.assign(contents.begin(), contents.end());
+		return true;
+	}
+
+	std::ifstream f(file.Path, std::ios::binary | std::ios::ate);
+	if (!f.good()) return false;
+
+	auto size = (std::size_t)f.tellg();
+	f.seekg(0);
+	file.Contents.resize(size);
+	f.read(file.Contents.data(), size);
+	return f.good();
+}
+
+static std::string MakeSyntheticFile(std::size_t index)
+{
+	std::string s;
+	for (int i = 0; i < 200; i++) {
+		auto name = "Synthetic_" + std::to_string(index) + "_" + std::to_string(i);
+		s += "new entry \"" + name + "\"\r\n";
+		s += "type \"Weapon\"\r\n";
+		if (i > 0) {
+			s += "using \"Synthetic_" + std::to_string(index) + "_" + std::to_string(i - 1) + "\"\r\n";
+		}
+		s += "data \"Damage\" \"" + std::to_string(i % 50) + "\"\r\n";
+		s += "data \"Damage Range\" \"20\"\r\n";
+		s += "data \"Requirements\" \"Strength " + std::to_string(i % 20) + "\"\r\n";
+		s += "data \"ExtraProperties\" \"SELF:OnHit:BURNING,100,1;TARGET:IF(Tagged:UNDEAD):KNOCKED_DOWN,50,1\"\r\n";
+		s += "data \"Boosts\" \"_Boost_Weapon_Damage_Fire;_Boost_Weapon_Crit\"\r\n\r\n";
+	}
+
+	return s;
+}
+
+static bool SameResults(StatTextFile const& a, StatTextFile const& b)
+{
+	return a.Tokens == b.Tokens
+		&& a.Lines.size() == b.Lines.size()
+		&& a.Blocks.size() == b.Blocks.size()
+		&& a.Errors.size() == b.Errors.size();
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <corpus directory> | --synthetic <files> [threads] [iterations]\n", argv[0]);
+		return 1;
+	}
+
+	Corpus corpus;
+	int argIdx = 1;
+	if (std::string(argv[1]) == "--synthetic") {
+		if (argc < 3) {
+			fprintf(stderr, "Missing synthetic file count\n");
+			return 1;
+		}
+
+		auto numFiles = (std::size_t)atoll(argv[2]);
+		for (std::size_t i = 0; i < numFiles; i++) {
+			corpus.Paths.push_back("Synthetic/Stats/Generated/Data/File" + std::to_string(i) + ".txt");
+			corpus.Contents.push_back(MakeSyntheticFile(i));
+		}
+
+		argIdx = 3;
+	} else {
+		std::error_code ec;
+		for (auto const& entry : fs::recursive_directory_iterator(argv[1], ec)) {
+			if (entry.is_regular_file() && entry.path().extension() == ".txt") {
+				corpus.Paths.push_back(entry.path().string());
+			}
+		}
+
+		if (ec) {
+			fprintf(stderr, "Failed to scan corpus directory: %s\n", ec.message().c_str());
+			return 1;
+		}
+
+		std::sort(corpus.Paths.begin(), corpus.Paths.end());
+		argIdx = 2;
+	}
+
+	unsigned threads = argc > argIdx ? (unsigned)atoi(argv[argIdx]) : 0;
+	int iterations = argc > argIdx + 1 ? atoi(argv[argIdx + 1]) : 5;
+	if (threads == 0) {
+		threads = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	auto loader = [&corpus](std::size_t index, StatTextFile& file) {
+		return LoadCorpusFile(corpus, index, file);
+	};
+
+	auto run = [&](unsigned numThreads, std::vector<StatTextFile>& result) {
+		double best = 1e30;
+		for (int i = 0; i < iterations; i++) {
+			auto start = std::chrono::steady_clock::now();
+			result = ParseStatFilesParallel(corpus.Paths.size(), loader, numThreads);
+			StatTextMergedIndex index;
+			index.Build(result);
+			auto end = std::chrono::steady_clock::now();
+			best = std::min(best, std::chrono::duration<double>(end - start).count());
+		}
+		return best;
+	};
+
+	std::vector<StatTextFile> serial, parallel;
+	auto serialTime = run(1, serial);
+	auto parallelTime = run(threads, parallel);
+
+	std::size_t bytes = 0, lines = 0, blocks = 0, errors = 0;
+	for (auto const& file : serial) {
+		bytes += file.Contents.size();
+		lines += file.Lines.size();
+		blocks += file.Blocks.size();
+		errors += file.Errors.size();
+	}
+
+	for (std::size_t i = 0; i < serial.size(); i++) {
+		if (!SameResults(serial[i], parallel[i])) {
+			fprintf(stderr, "Parallel result differs from serial result for %s\n", serial[i].Path.c_str());
+			return 2;
+		}
+	}
+
+	auto mb = bytes / (1024.0 * 1024.0);
+	printf("%zu files, %.1f MB, %zu lines, %zu blocks, %zu errors\n", serial.size(), mb, lines, blocks, errors);
+	printf("1 thread:   %8.2f ms  %8.1f MB/s\n", serialTime * 1000.0, mb / serialTime);
+	printf("%u threads: %8.2f ms  %8.1f MB/s  (%.2fx)\n", threads, parallelTime * 1000.0, mb / parallelTime, serialTime / parallelTime);
+	return 0;
+}
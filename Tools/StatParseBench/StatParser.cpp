@@ -0,0 +1,168 @@
+#include "StatParser.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+namespace dse
+{
+	bool TokenizeStatText(StatTextFile& file)
+	{
+		file.Tokens.clear();
+		file.Lines.clear();
+		file.Blocks.clear();
+		file.Errors.clear();
+
+		char const* pos = file.Contents.data();
+		char const* end = pos + file.Contents.size();
+		uint32_t lineNumber = 0;
+
+		// Most stat lines have 3-4 tokens and are ~30 bytes long
+		file.Lines.reserve(file.Contents.size() / 24);
+		file.Tokens.reserve(file.Contents.size() / 8);
+
+		while (pos < end) {
+			lineNumber++;
+			StatTextLine line{ (uint32_t)file.Tokens.size(), 0, lineNumber };
+
+			while (pos < end && *pos != '\n') {
+				auto ch = *pos;
+				if (ch == ' ' || ch == '\t' || ch == '\r' || ch == ',') {
+					pos++;
+				} else if (ch == '"') {
+					auto strEnd = (char const*)memchr(pos + 1, '"', end - pos - 1);
+					auto lineEnd = (char const*)memchr(pos + 1, '\n', end - pos - 1);
+					if (strEnd == nullptr || (lineEnd != nullptr && lineEnd < strEnd)) {
+						file.Errors.push_back({ lineNumber, "Unterminated string" });
+						pos = lineEnd ? lineEnd : end;
+						break;
+					}
+
+					file.Tokens.push_back(std::string_view(pos + 1, strEnd - pos - 1));
+					pos = strEnd + 1;
+				} else if (ch == '/' && pos + 1 < end && pos[1] == '/') {
+					auto lineEnd = (char const*)memchr(pos, '\n', end - pos);
+					pos = lineEnd ? lineEnd : end;
+				} else {
+					auto tokenStart = pos;
+					while (pos < end && *pos != ' ' && *pos != '\t' && *pos != '\r'
+						&& *pos != '\n' && *pos != ',' && *pos != '"') {
+						pos++;
+					}
+
+					file.Tokens.push_back(std::string_view(tokenStart, pos - tokenStart));
+				}
+			}
+
+			pos++;
+			line.NumTokens = (uint32_t)file.Tokens.size() - line.FirstToken;
+			if (line.NumTokens == 0) continue;
+
+			if (file.GetToken(line, 0) == "new") {
+				if (line.NumTokens < 3) {
+					file.Errors.push_back({ lineNumber, "Declaration must have a type and a name" });
+				} else {
+					file.Blocks.push_back({ file.GetToken(line, 1), file.GetToken(line, 2), (uint32_t)file.Lines.size(), 0 });
+				}
+			}
+
+			file.Lines.push_back(line);
+			if (!file.Blocks.empty()) {
+				file.Blocks.back().NumLines++;
+			}
+		}
+
+		return file.Errors.empty();
+	}
+
+	std::vector<StatTextFile> ParseStatFilesParallel(std::size_t numFiles, StatTextLoader const& loader, unsigned numThreads)
+	{
+		std::vector<StatTextFile> files(numFiles);
+		if (numThreads == 0) {
+			numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+
+		numThreads = (unsigned)std::min<std::size_t>(numThreads, numFiles);
+
+		// Files are handed out one at a time instead of in fixed ranges, since file sizes
+		// vary by several orders of magnitude (Data/Potion.txt vs. Data/Weapon.txt)
+		std::atomic<std::size_t> nextFile{ 0 };
+		auto worker = [&]() {
+			for (;;) {
+				auto index = nextFile.fetch_add(1, std::memory_order_relaxed);
+				if (index >= numFiles) break;
+
+				auto& file = files[index];
+				if (loader(index, file)) {
+					TokenizeStatText(file);
+				} else {
+					file.Contents.clear();
+				}
+			}
+		};
+
+		if (numThreads <= 1) {
+			worker();
+			return files;
+		}
+
+		std::vector<std::thread> threads;
+		threads.reserve(numThreads - 1);
+		for (unsigned i = 1; i < numThreads; i++) {
+			threads.emplace_back(worker);
+		}
+
+		worker();
+
+		for (auto& thread : threads) {
+			thread.join();
+		}
+
+		return files;
+	}
+
+	std::string StatTextMergedIndex::MakeKey(std::string_view kind, std::string_view name)
+	{
+		std::string key;
+		key.reserve(kind.size() + name.size() + 1);
+		key.append(kind);
+		key.push_back('\0');
+		key.append(name);
+		return key;
+	}
+
+	void StatTextMergedIndex::Build(std::vector<StatTextFile> const& files)
+	{
+		blocks_.clear();
+
+		std::size_t numBlocks = 0;
+		for (auto const& file : files) {
+			numBlocks += file.Blocks.size();
+		}
+
+		blocks_.reserve(numBlocks);
+		for (uint32_t fileIndex = 0; fileIndex < files.size(); fileIndex++) {
+			auto const& blocks = files[fileIndex].Blocks;
+			for (uint32_t blockIndex = 0; blockIndex < blocks.size(); blockIndex++) {
+				auto const& block = blocks[blockIndex];
+				blocks_[MakeKey(block.Kind, block.Name)].push_back({ fileIndex, blockIndex });
+			}
+		}
+	}
+
+	StatTextBlockRef const* StatTextMergedIndex::Find(std::string_view kind, std::string_view name) const
+	{
+		auto refs = FindAll(kind, name);
+		return refs ? &refs->back() : nullptr;
+	}
+
+	std::vector<StatTextBlockRef> const* StatTextMergedIndex::FindAll(std::string_view kind, std::string_view name) const
+	{
+		auto it = blocks_.find(MakeKey(kind, name));
+		if (it != blocks_.end()) {
+			return &it->second;
+		} else {
+			return nullptr;
+		}
+	}
+}
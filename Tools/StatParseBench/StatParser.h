@@ -0,0 +1,105 @@
+#pragma once
+
+// Game-independent tokenizer for stat .txt files (Stats/Generated/Data/*.txt).
+// Not part of the extender: the game parses stat files itself (RPGStats::Load) and
+// offers no hook that accepts pre-tokenized input, so stats loading is not parallelized
+// and this code does not affect load times. It only exists for the standalone
+// tokenizer throughput harness; it must not depend on game definitions.
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace dse
+{
+	struct StatTextLine
+	{
+		uint32_t FirstToken;
+		uint32_t NumTokens;
+		uint32_t LineNumber;
+	};
+
+	// A "new <kind> <name>" declaration and all lines up to the next declaration
+	struct StatTextBlock
+	{
+		std::string_view Kind;
+		std::string_view Name;
+		uint32_t FirstLine;
+		uint32_t NumLines;
+	};
+
+	struct StatTextError
+	{
+		uint32_t LineNumber;
+		char const* Message;
+	};
+
+	// Tokenized contents of a single stat file.
+	// Tokens point into Contents, so the file can be moved but not copied.
+	struct StatTextFile
+	{
+		std::string Path;
+		std::vector<char> Contents;
+		std::vector<std::string_view> Tokens;
+		std::vector<StatTextLine> Lines;
+		std::vector<StatTextBlock> Blocks;
+		std::vector<StatTextError> Errors;
+
+		StatTextFile() = default;
+		StatTextFile(StatTextFile const&) = delete;
+		StatTextFile(StatTextFile&&) = default;
+		StatTextFile& operator = (StatTextFile const&) = delete;
+		StatTextFile& operator = (StatTextFile&&) = default;
+
+		inline std::string_view GetToken(StatTextLine const& line, uint32_t index) const
+		{
+			return index < line.NumTokens ? Tokens[line.FirstToken + index] : std::string_view{};
+		}
+	};
+
+	// Splits Contents into lines and tokens. Tokens are separated by whitespace or commas;
+	// quoted tokens are returned without the quotes. "//" starts a comment outside of quotes.
+	// Returns false if the file had syntax errors; the erroneous lines are listed in Errors.
+	bool TokenizeStatText(StatTextFile& file);
+
+	// Fills Path and Contents of the file with the specified index in the load order.
+	// Called concurrently from multiple worker threads.
+	using StatTextLoader = std::function<bool (std::size_t index, StatTextFile& file)>;
+
+	// Loads and tokenizes stat files on worker threads.
+	// The result is in load order; files that couldn't be loaded are left empty.
+	// If numThreads is 0, the number of hardware threads is used.
+	std::vector<StatTextFile> ParseStatFilesParallel(std::size_t numFiles, StatTextLoader const& loader, unsigned numThreads = 0);
+
+	struct StatTextBlockRef
+	{
+		uint32_t File;
+		uint32_t Block;
+	};
+
+	// Maps each (kind, name) pair to its declarations, in load order.
+	// Built serially after the parallel pass; the last declaration is the one
+	// that overrides the others, like later mods override earlier entries.
+	class StatTextMergedIndex
+	{
+	public:
+		void Build(std::vector<StatTextFile> const& files);
+
+		// Returns the last (overriding) declaration of the block, or nullptr
+		StatTextBlockRef const* Find(std::string_view kind, std::string_view name) const;
+		std::vector<StatTextBlockRef> const* FindAll(std::string_view kind, std::string_view name) const;
+
+		inline std::size_t Size() const
+		{
+			return blocks_.size();
+		}
+
+	private:
+		std::unordered_map<std::string, std::vector<StatTextBlockRef>> blocks_;
+
+		static std::string MakeKey(std::string_view kind, std::string_view name);
+	};
+}